@@ -0,0 +1,54 @@
+#include "../utils.hh"
+#include "covdel/cv/color.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cstdint>
+
+using namespace covdel;
+using cv::color;
+using cv::packing;
+
+// 1080p camera frames converted into the inputs of models, and between common formats
+int main()
+{
+  BenchmarkRunner runner { "color.hh", "colour conversion" };
+
+  ma::uint8 nv12 { ma::D(1620, 1920), ma::uninitialized };
+  uint32_t state { 12345 };
+  auto *data { nv12.data() };
+  for (size_t i { 0 }; i < nv12.size(); ++i)
+    data[i] = uint8_t(i % 1920 / 8 + ((state = state * 1103515245U + 12345U) >> 27));
+  const auto rgb { cv::convert_color<ma::uint8>(nv12, color::nv12, color::rgb) };
+  const auto yuyv { cv::convert_color<ma::uint8>(rgb, color::rgb, color::yuyv) };
+  ma::float32 chw { ma::D(3, 1080, 1920), ma::uninitialized };
+  ma::uint8 out { rgb.dim(), ma::uninitialized };
+  ma::uint8 gray { ma::D(1080, 1920, 1), ma::uninitialized };
+  ma::uint8 frame { nv12.dim(), ma::uninitialized };
+  const double bytes { double(nv12.size()) }, rgb_bytes { double(rgb.size()) };
+  const cv::normalization norm { { 0.485F, 0.456F, 0.406F }, { 0.229F, 0.224F, 0.225F } };
+  const cv::pixel_format planar { color::rgb, packing::planar };
+
+  const double fused { runner.run("nv12 to normalized planar float32 rgb", bytes,
+    [&] { cv::convert_color(nv12, color::nv12, chw, planar, norm); }) };
+  std::printf("  %-40s %12.1f\n", "  frames/s", 1 / fused);
+  runner.run("nv12 to uint8 rgb", bytes,
+    [&] { cv::convert_color(nv12, color::nv12, out, color::rgb); });
+  runner.run("yuyv to uint8 bgr", double(yuyv.size()),
+    [&] { cv::convert_color(yuyv, color::yuyv, out, color::bgr); });
+  runner.run("uint8 rgb to bgr", rgb_bytes,
+    [&] { cv::convert_color(rgb, color::rgb, out, color::bgr); });
+  runner.run("uint8 rgb to gray", rgb_bytes,
+    [&] { cv::convert_color(rgb, color::rgb, gray, color::gray); });
+  runner.run("uint8 rgb to hsv", rgb_bytes,
+    [&] { cv::convert_color(rgb, color::rgb, out, color::hsv); });
+  runner.run("uint8 rgb to nv12", rgb_bytes,
+    [&] { cv::convert_color(rgb, color::rgb, frame, color::nv12); });
+
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  runner.run("nv12 to normalized float32 rgb, scalar", bytes,
+    [&] { cv::convert_color(nv12, color::nv12, chw, planar, norm); });
+  ma::set_isa(level);
+
+  return EXIT_SUCCESS;
+}
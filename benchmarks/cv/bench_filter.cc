@@ -0,0 +1,51 @@
+#include "../utils.hh"
+#include "covdel/cv/filter.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cstdint>
+
+using namespace covdel;
+
+// 1080p frames, in color and gray, through the filters of a video pipeline
+int main()
+{
+  BenchmarkRunner runner { "filter.hh", "image filtering" };
+
+  ma::uint8 color { ma::D(1080, 1920, 3), ma::uninitialized };
+  uint32_t state { 12345 };
+  auto *data { color.data() };
+  for (size_t i { 0 }; i < color.size(); ++i)
+    data[i] = uint8_t(i / 3 % 1920 / 8 + ((state = state * 1103515245U + 12345U) >> 27));
+  ma::uint8 gray { color.slice(2, 0, 1).copy() };
+  gray.reshape(ma::D(1080, 1920));
+  const auto grayf { gray.astype<ma::float32>() };
+  ma::uint8 out { color.dim(), ma::uninitialized };
+  ma::uint8 gray_out { gray.dim(), ma::uninitialized };
+  ma::float32 outf { gray.dim(), ma::uninitialized };
+  const double bytes { double(color.size()) }, gray_bytes { double(gray.size()) };
+
+  ma::float32 kernel { ma::D(5, 5) };
+  for (size_t i { 0 }; i < 25; ++i) kernel.data()[i] = float(i % 7) - 3;
+
+  const double blur { runner.run("gaussian_blur 5x5 uint8 rgb", bytes,
+    [&] { cv::gaussian_blur(color, out, 5); }) };
+  std::printf("  %-40s %12.1f\n", "  frames/s", 1 / blur);
+  runner.run("gaussian_blur 5x5 uint8 gray", gray_bytes,
+    [&] { cv::gaussian_blur(gray, gray_out, 5); });
+  runner.run("gaussian_blur 5x5 float32 gray", 4 * gray_bytes,
+    [&] { cv::gaussian_blur(grayf, outf, 5); });
+  runner.run("box_filter 5x5 uint8 rgb", bytes, [&] { cv::box_filter(color, out, 5, 5); });
+  runner.run("box_filter 31x31 uint8 rgb", bytes,
+    [&] { cv::box_filter(color, out, 31, 31); });
+  runner.run("sobel dx 3x3 uint8 gray", gray_bytes, [&] { cv::sobel(gray, outf, 1, 0); });
+  runner.run("filter2d 5x5 non-separable uint8 rgb", bytes,
+    [&] { cv::filter2d(color, out, kernel); });
+
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  runner.run("gaussian_blur 5x5 uint8 rgb, scalar", bytes,
+    [&] { cv::gaussian_blur(color, out, 5); });
+  ma::set_isa(level);
+
+  return EXIT_SUCCESS;
+}
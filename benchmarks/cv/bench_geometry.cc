@@ -0,0 +1,59 @@
+#include "../utils.hh"
+#include "covdel/cv/geometry.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cstdint>
+
+using namespace covdel;
+using cv::interpolation;
+
+// 1080p frames resized and warped into preallocated arrays, as ahead of inference
+int main()
+{
+  BenchmarkRunner runner { "geometry.hh", "geometric transforms" };
+
+  ma::uint8 frame { ma::D(1080, 1920, 3), ma::uninitialized };
+  uint32_t state { 12345 };
+  auto *data { frame.data() };
+  for (size_t i { 0 }; i < frame.size(); ++i)
+    data[i] = uint8_t(i / 3 % 1920 / 8 + ((state = state * 1103515245U + 12345U) >> 27));
+  const auto framef { frame.astype<ma::float32>() };
+  const auto small { cv::resize(frame, 720, 1280) };
+  ma::uint8 out { ma::D(360, 640, 3), ma::uninitialized };
+  ma::uint8 square { ma::D(224, 224, 3), ma::uninitialized };
+  ma::uint8 large { frame.dim(), ma::uninitialized };
+  ma::float32 outf { ma::D(360, 640, 3), ma::uninitialized };
+  const double bytes { double(frame.size()) };
+
+  const double linear { runner.run("resize bilinear uint8 1080p to 360p", bytes,
+    [&] { cv::resize(frame, out); }) };
+  std::printf("  %-40s %12.1f\n", "  frames/s", 1 / linear);
+  runner.run("resize bilinear uint8 1080p to 224x224", bytes,
+    [&] { cv::resize(frame, square); });
+  runner.run("resize bilinear float32 1080p to 360p", 4 * bytes,
+    [&] { cv::resize(framef, outf); });
+  runner.run("resize bicubic uint8 1080p to 360p", bytes,
+    [&] { cv::resize(frame, out, interpolation::bicubic); });
+  runner.run("resize area uint8 1080p to 360p", bytes,
+    [&] { cv::resize(frame, out, interpolation::area); });
+  runner.run("resize antialiased bilinear 1080p to 360p", bytes,
+    [&] { cv::resize(frame, out, interpolation::bilinear, true); });
+  runner.run("resize nearest uint8 1080p to 360p", bytes,
+    [&] { cv::resize(frame, out, interpolation::nearest); });
+  runner.run("resize bilinear uint8 720p to 1080p", double(small.size()),
+    [&] { cv::resize(small, large); });
+
+  const auto turn { cv::rotation_matrix(960, 540, 15) };
+  runner.run("warp_affine bilinear uint8 1080p", bytes,
+    [&] { cv::warp_affine(frame, large, turn); });
+  runner.run("warp_affine bicubic uint8 1080p", bytes,
+    [&] { cv::warp_affine(frame, large, turn, interpolation::bicubic); });
+
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  runner.run("resize bilinear uint8 1080p to 360p, scalar", bytes,
+    [&] { cv::resize(frame, out); });
+  ma::set_isa(level);
+
+  return EXIT_SUCCESS;
+}
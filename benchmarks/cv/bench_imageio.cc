@@ -0,0 +1,53 @@
+#include "../utils.hh"
+#include "covdel/cv/imageio.hh"
+#include "covdel/ma/factory.hh"
+
+#include <cstdint>
+#include <filesystem>
+
+using namespace covdel;
+
+// a photo-like (720, 1280, 3) frame through each format, then a directory of 32 of them
+int main()
+{
+  BenchmarkRunner runner { "imageio.hh", "image decoding and encoding" };
+
+  const auto directory { std::filesystem::temp_directory_path() / "covdel_bench_images" };
+  std::filesystem::create_directories(directory);
+  ma::uint8 image { ma::D(720, 1280, 3), ma::uninitialized };
+  uint32_t state { 12345 };
+  auto *data { image.data() };
+  for (size_t i { 0 }; i < image.size(); ++i)
+    data[i] = uint8_t(i / 3 % 1280 / 6 + i / 3840 / 4
+                      + ((state = state * 1103515245U + 12345U) >> 29));
+  const double bytes { double(image.size()) };
+  ma::uint8 out { image.dim(), ma::uninitialized };
+
+  auto report = [](const char *name, const double seconds, const double images) {
+    std::printf("  %-40s %12.1f\n", name, images / seconds);
+  };
+
+  for (const char *ext : { ".ppm", ".bmp", ".png" }) {
+    const std::string path { (directory / (std::string { "frame" } + ext)).string() };
+    const double encode { runner.run(std::string { "write_image " } + ext, bytes,
+      [&] { cv::write_image(path, image); }) };
+    const double decode { runner.run(std::string { "read_image " } + ext + " into an array",
+      bytes, [&] { cv::read_image(path, out); }) };
+    report("  encoded images/s", encode, 1);
+    report("  decoded images/s", decode, 1);
+    report("  decoded MB/s of file", decode, double(std::filesystem::file_size(path)) / 1e6);
+  }
+
+  std::vector<std::string> paths;
+  for (int i { 0 }; i < 32; ++i) {
+    paths.push_back((directory / ("batch_" + std::to_string(100 + i) + ".png")).string());
+    cv::write_image(paths.back(), image, 1);
+  }
+  ma::uint8 batch { ma::D(32, 720, 1280, 3), ma::uninitialized };
+  const double batched { runner.run("read_images 32 png into a batch", 32 * bytes,
+    [&] { cv::read_images(paths, batch); }) };
+  report("  decoded images/s", batched, 32);
+  std::filesystem::remove_all(directory);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+
+#include <iostream>
+
+using namespace covdel::ma;
+
+// allocating and releasing a 1080p float frame, as a pipeline stage does per image
+void bench_frames(BenchmarkRunner &runner)
+{
+  const D shape { 1080, 1920, 3 };
+  const double bytes { double(shape.size() * sizeof(float)) };
+  auto &heap { aligned_allocator::instance() };
+  auto &pool { pool_allocator::instance() };
+
+  runner.run("zeros heap 1080p float32", bytes, [&] { zeros<float32>(shape, heap); });
+  runner.run("empty heap 1080p float32", bytes, [&] { empty<float32>(shape, heap); });
+  runner.run("zeros pool 1080p float32", bytes, [&] { zeros<float32>(shape, pool); });
+  runner.run("empty pool 1080p float32", bytes, [&] { empty<float32>(shape, pool); });
+}
+
+// small temporaries of an eager chain, dominated by allocation
+void bench_temporaries(BenchmarkRunner &runner)
+{
+  const float32 a { D(256), 1.f };
+  const double bytes { double(a.size() * sizeof(float) * 3) };
+
+  set_default_allocator(aligned_allocator::instance());
+  runner.run("heap add(multiply(a, 2), a) n=256", bytes, [&] { add(multiply(a, 2.f), a); });
+  set_default_allocator(pool_allocator::instance());
+  runner.run("pool add(multiply(a, 2), a) n=256", bytes, [&] { add(multiply(a, 2.f), a); });
+}
+
+int main()
+{
+  BenchmarkRunner runner { "allocator.hh", "aligned and pooled array buffers" };
+
+  bench_frames(runner);
+  bench_temporaries(runner);
+
+  const auto stats { pool_allocator::instance().stats() };
+  std::cout << "pool hits " << stats.hits << ", misses " << stats.misses << '\n';
+  return EXIT_SUCCESS;
+}
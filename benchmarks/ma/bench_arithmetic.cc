@@ -0,0 +1,75 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/simd.hh"
+
+using namespace covdel::ma;
+
+// cache resident and memory bound sizes
+static const size_t sizes[] { 1UL << 12, 1UL << 16, 1UL << 24 };
+
+template<typename _MultiArray>
+void bench_add(BenchmarkRunner &runner, const std::string &type_name)
+{
+  using native_type = typename _MultiArray::native_type;
+
+  for (const auto size : sizes) {
+    const _MultiArray a { D(size), native_type(3) }, b { D(size), native_type(4) };
+    _MultiArray out { D(size) };
+    const double bytes { 3.0 * size * sizeof(native_type) };
+
+    double scalar_time { 0 };
+    for (int level { int(isa::scalar) }; level <= int(max_isa()); ++level) {
+      set_isa(isa(level));
+      const auto name { type_name + " add n=" + std::to_string(size) + " "
+        + str(isa(level)) };
+      const double seconds { runner.run(name, bytes, [&] { add(a, b, out); }) };
+      if (level == int(isa::scalar))
+        scalar_time = seconds;
+      else
+        std::printf("  %-40s %11.2fx\n", "  speedup vs scalar", scalar_time / seconds);
+    }
+    set_isa(max_isa());
+  }
+}
+
+// per-channel scaling of a 1080p interleaved frame, against a fully materialized operand
+void bench_broadcast(BenchmarkRunner &runner)
+{
+  const float32 img { D(1080, 1920, 3), 0.5f }, scale { D(3), 2.f };
+  const auto expanded { scale.broadcast_to(img.dim()).copy() };
+  float32 out { img.dim() };
+  const double bytes { 2.0 * img.size() * sizeof(float) };
+
+  runner.run("float32 (H, W, 3) * (3) broadcast", bytes, [&] { multiply(img, scale, out); });
+  runner.run("float32 (H, W, 3) * (H, W, 3)", bytes * 1.5,
+    [&] { multiply(img, expanded, out); });
+}
+
+// normalization of a 1080p uint8 frame, fused into one pass against one call per operation
+void bench_fusion(BenchmarkRunner &runner)
+{
+  const uint8 img { D(1080, 1920, 3), 128 };
+  const float32 mean { D(3), 120.f }, stddev { D(3), 60.f };
+  float32 out { img.dim() };
+  const double bytes { double(img.size()) * (sizeof(std::uint8_t) + sizeof(float)) };
+
+  runner.run("(cast(u8) - mean) / std * s fused", bytes,
+    [&] { ((cast<dtype::float32>(img) - mean) / stddev * 0.5f).eval(out); });
+  runner.run("(cast(u8) - mean) / std * s eager", bytes, [&] {
+    const auto converted { img.astype<float32>() };
+    multiply(divide(subtract(converted, mean), stddev), 0.5f, out);
+  });
+}
+
+int main()
+{
+  BenchmarkRunner runner { "arithmetic.hh", "element-wise operations" };
+
+  bench_add<float32>(runner, "float32");
+  bench_add<uint8>(runner, "uint8");
+  bench_broadcast(runner);
+  bench_fusion(runner);
+
+  return EXIT_SUCCESS;
+}
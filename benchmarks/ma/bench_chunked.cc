@@ -0,0 +1,42 @@
+#include "../utils.hh"
+#include "covdel/ma/chunked.hh"
+#include "covdel/ma/factory.hh"
+
+#include <cstdint>
+#include <filesystem>
+
+using namespace covdel::ma;
+
+// a stack of noisy 16-bit microscopy frames, written whole and read back by regions
+int main()
+{
+  BenchmarkRunner runner { "chunked.hh", "chunked array files" };
+
+  const auto path { (std::filesystem::temp_directory_path() / "covdel_bench_stack.cvt")
+                      .string() };
+  uint16 stack { D(16, 2048, 2048), uninitialized };
+  uint32_t state { 12345 };
+  auto *data { stack.data() };
+  for (size_t i { 0 }; i < stack.size(); ++i)
+    data[i] = uint16_t(800 + i % 2048 / 16 + ((state = state * 1103515245U + 12345U) >> 25));
+  const double bytes { double(stack.size() * sizeof(uint16_t)) };
+
+  runner.run("save_chunked (1, 256, 256) tiles", bytes,
+    [&] { save_chunked(path, stack, D(1, 256, 256)); });
+  std::printf("  %-40s %12.1f\n", "compression ratio",
+    bytes / double(std::filesystem::file_size(path)));
+
+  const chunked_array cold { path, 0 };
+  runner.run("read whole, uncached", bytes, [&] { cold.read<uint16>(); });
+  runner.run("read (1, 256, 256) tile, uncached", bytes / 64 / 16,
+    [&] { cold.read<uint16>(I(7, 512, 768), D(1, 256, 256)); });
+  runner.run("read (16, 100, 100) region, uncached", 16 * 100 * 100 * 2,
+    [&] { cold.read<uint16>(I(0, 1000, 1000), D(16, 100, 100)); });
+
+  const chunked_array warm { path };
+  runner.run("read (16, 100, 100) region, cached", 16 * 100 * 100 * 2,
+    [&] { warm.read<uint16>(I(0, 1000, 1000), D(16, 100, 100)); });
+  std::filesystem::remove(path);
+
+  return EXIT_SUCCESS;
+}
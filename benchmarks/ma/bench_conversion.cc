@@ -0,0 +1,34 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/simd.hh"
+
+using namespace covdel::ma;
+
+// the conversions around every stage of an image pipeline, at each instruction set level
+void bench_frames(BenchmarkRunner &runner, const isa level)
+{
+  set_isa(level);
+  const uint8 image { D(1080, 1920, 3), 117 };
+  const float32 frame { D(1080, 1920, 3), 0.43f };
+  const double pixels { double(image.size()) };
+  const std::string suffix { " 1080p " + str(level) };
+
+  const conversion normalize { rounding::truncate, false, 1 / 255. };
+  const conversion quantize { rounding::nearest_even, true, 255 };
+  runner.run("uint8 -> float32" + suffix, pixels * 5, [&] { image.astype<float32>(); });
+  runner.run("uint8 -> float32 scaled" + suffix, pixels * 5,
+    [&] { image.astype<float32>(normalize); });
+  runner.run("float32 -> uint8" + suffix, pixels * 5, [&] { frame.astype<uint8>(); });
+  runner.run("float32 -> uint8 quantized" + suffix, pixels * 5,
+    [&] { frame.astype<uint8>(quantize); });
+}
+
+int main()
+{
+  BenchmarkRunner runner { "multiarray.hh", "datatype conversions" };
+
+  bench_frames(runner, isa::scalar);
+  bench_frames(runner, max_isa());
+
+  return EXIT_SUCCESS;
+}
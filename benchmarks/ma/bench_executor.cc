@@ -0,0 +1,33 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/factory.hh"
+
+#include <string>
+
+using namespace covdel::ma;
+
+// memory bound operations of a large array, inline and spread over a pool
+void bench_operations(BenchmarkRunner &runner, executor &exec, const std::string &label)
+{
+  set_default_executor(exec);
+  float32 a { D(4096, 4096), 1.f };
+  const float32 b { D(4096, 4096), 2.f };
+  const double bytes { double(a.size() * sizeof(float)) };
+
+  runner.run(label + " fill (4096, 4096)", bytes, [&] { a.fill(3.f); });
+  runner.run(label + " copy (4096, 4096)", 2 * bytes, [&] { a.copy(); });
+  runner.run(label + " equal (4096, 4096)", 2 * bytes, [&] { (void)(a == b); });
+  runner.run(label + " add (4096, 4096)", 3 * bytes, [&] { add(a, b); });
+}
+
+int main()
+{
+  BenchmarkRunner runner { "executor.hh", "parallel loops of array operations" };
+
+  auto &pool { thread_pool::instance() };
+  bench_operations(runner, serial_executor::instance(), "serial");
+  bench_operations(runner, pool, "pool x" + std::to_string(pool.concurrency()));
+
+  return EXIT_SUCCESS;
+}
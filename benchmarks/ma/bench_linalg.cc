@@ -0,0 +1,85 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/simd.hh"
+
+#include <string>
+
+using namespace covdel::ma;
+
+template<typename _MultiArray>
+_MultiArray generate(const D &dim)
+{
+  _MultiArray out { dim, uninitialized };
+  auto *data { out.data() };
+  for (size_t i { 0 }; i < out.size(); ++i) data[i] = double(i * 7919 % 201) / 100 - 1;
+  return out;
+}
+
+// the textbook triple loop over contiguous rows, as a baseline
+template<typename _MultiArray>
+void naive(const _MultiArray &a, const _MultiArray &b, _MultiArray &c)
+{
+  const size_t m { a.dim()[0] }, k { a.dim()[1] }, n { b.dim()[1] };
+  const auto *x { a.data() }, *y { b.data() };
+  auto *z { c.data() };
+  for (size_t i { 0 }; i < m; ++i)
+    for (size_t j { 0 }; j < n; ++j) {
+      typename _MultiArray::native_type sum { 0 };
+      for (size_t p { 0 }; p < k; ++p) sum += x[i * k + p] * y[p * n + j];
+      z[i * n + j] = sum;
+    }
+}
+
+// square products against the triple loop, which is only run on the smaller sizes
+template<typename _MultiArray>
+void bench_square(BenchmarkRunner &runner, const std::string &type)
+{
+  for (const size_t size : { 64UL, 256UL, 512UL, 1024UL, 2048UL }) {
+    const auto a { generate<_MultiArray>(D(size, size)) };
+    const auto b { generate<_MultiArray>(D(size, size)) };
+    _MultiArray c { D(size, size), uninitialized };
+    const double flops { 2. * double(size) * double(size) * double(size) };
+    const std::string shape { " (" + std::to_string(size) + ")^2" };
+
+    runner.run(type + " matmul" + shape, flops, [&] { matmul(a, b, c); });
+    if (size <= 512)
+      runner.run(type + " naive" + shape, flops, [&] { naive(a, b, c); });
+  }
+}
+
+// transposed operands, batches of small products and matrix-vector products
+void bench_shapes(BenchmarkRunner &runner)
+{
+  const auto a { generate<float32>(D(1024, 1024)) }, b { generate<float32>(D(1024, 1024)) };
+  float32 c { D(1024, 1024), uninitialized };
+  const double flops { 2. * 1024 * 1024 * 1024 };
+  runner.run("float32 gemm a^T b^T (1024)^2", flops,
+    [&] { gemm(a, b, c, 1.f, 0.f, true, true); });
+
+  const auto x { generate<float32>(D(256, 64, 64)) }, y { generate<float32>(D(256, 64, 64)) };
+  float32 z { D(256, 64, 64), uninitialized };
+  const double batch_flops { 2. * 256 * 64 * 64 * 64 };
+  runner.run("float32 matmul 256 x (64)^2", batch_flops, [&] { matmul(x, y, z); });
+
+  const auto v { generate<float32>(D(1024)) };
+  float32 w { D(1024), uninitialized };
+  const double gemv_flops { 2. * 1024 * 1024 };
+  runner.run("float32 matmul (1024)^2 x (1024)", gemv_flops, [&] { matmul(a, v, w); });
+
+  const auto level { active_isa() };
+  set_isa(isa::scalar);
+  runner.run("float32 matmul (1024)^2, scalar", flops, [&] { matmul(a, b, c); });
+  set_isa(level);
+}
+
+int main()
+{
+  BenchmarkRunner runner { "linalg.hh", "matrix products, GFLOP/s in place of GB/s" };
+
+  bench_square<float32>(runner, "float32");
+  bench_square<float64>(runner, "float64");
+  bench_shapes(runner);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/nditer.hh"
+
+#include <cstdlib>
+#include <string>
+
+using namespace covdel::ma;
+
+// element counts of float32 arrays from cache resident to main memory, multi-GB ones only
+// with COVDEL_BENCH_LARGE set, timed less often
+struct scale {
+  std::string label;
+  size_t elements;
+  unsigned reps;
+};
+
+const scale scales[] {
+  { "32KiB", size_t(1) << 13, 51 },
+  { "1MiB", size_t(1) << 18, 31 },
+  { "32MiB", size_t(1) << 23, 11 },
+  { "2GiB", size_t(1) << 29, 3 },
+};
+
+volatile bool sink;
+
+// shape of `elements` as rows of 64 by 16, strided views of which are not contiguous
+D shape(const size_t elements) { return D(elements / 1024, 64, 16); }
+
+void bench_basics(BenchmarkRunner &runner, const scale &s)
+{
+  const D dim { shape(s.elements) };
+  const double n { double(s.elements) }, bytes { 4 * n };
+  const std::string suffix { " float32 " + s.label };
+
+  runner.run("construct zeros" + suffix, bytes, n, [&] { float32 a { dim }; }, s.reps);
+  runner.run("construct uninitialized" + suffix, 0, n,
+    [&] { float32 a { dim, uninitialized }; }, s.reps);
+
+  float32 a { dim, 0.5F };
+  runner.run("fill" + suffix, bytes, n, [&] { a.fill(0.25F); }, s.reps);
+  runner.run("copy" + suffix, 2 * bytes, n, [&] { a.copy(); }, s.reps);
+  float32 t { a };
+  t.transpose();
+  runner.run("copy transposed" + suffix, 2 * bytes, n, [&] { t.copy(); }, s.reps);
+
+  const float32 b { a.copy() };
+  float32 u { b };
+  u.transpose();
+  runner.run("operator== equal" + suffix, 2 * bytes, n, [&] { sink = a == b; }, s.reps);
+  runner.run(
+    "operator== transposed" + suffix, 2 * bytes, n, [&] { sink = t == u; }, s.reps);
+
+  // contiguous arrays reshape as views, others are copied first
+  const D flat { s.elements };
+  runner.run("reshape contiguous" + suffix, 0, n,
+    [&] { float32 v { a }; v.reshape(flat); }, s.reps);
+  runner.run("reshape transposed" + suffix, 2 * bytes, n,
+    [&] { float32 v { t }; v.reshape(flat); }, s.reps);
+}
+
+template<typename _From, typename _To>
+void bench_astype(BenchmarkRunner &runner, const scale &s, const std::string &name)
+{
+  using from_type = typename _From::native_type;
+  using to_type   = typename _To::native_type;
+  const _From a { shape(s.elements), from_type(3) };
+  const double n { double(s.elements) };
+  const double bytes { n * (sizeof(from_type) + sizeof(to_type)) };
+  runner.run("astype " + name + " " + s.label, bytes, n,
+    [&] { a.template astype<_To>(); }, s.reps);
+}
+
+// per-element access, building an index each time against the unchecked operator() and
+// the flat iterators, which are too slow to wait for at the largest scale
+void bench_indexing(BenchmarkRunner &runner, const scale &s)
+{
+  float32 a { shape(s.elements), 1.F };
+  const D dim { a.dim() };
+  const double n { double(s.elements) }, bytes { 4 * n };
+  const std::string suffix { " float32 " + s.label };
+
+  runner.run("operator[] sum" + suffix, bytes, n, [&] {
+    float sum { 0 };
+    for (size_t i { 0 }; i < dim[0]; ++i)
+      for (size_t j { 0 }; j < dim[1]; ++j)
+        for (size_t k { 0 }; k < dim[2]; ++k) sum += a[{ i, j, k }];
+    sink = sum > 0;
+  }, s.reps);
+  runner.run("operator() sum" + suffix, bytes, n, [&] {
+    float sum { 0 };
+    for (size_t i { 0 }; i < dim[0]; ++i)
+      for (size_t j { 0 }; j < dim[1]; ++j)
+        for (size_t k { 0 }; k < dim[2]; ++k) sum += a(i, j, k);
+    sink = sum > 0;
+  }, s.reps);
+
+  float32 t { a };
+  t.transpose();
+  runner.run("iterator sum transposed" + suffix, bytes, n, [&] {
+    float sum { 0 };
+    for (const float v : t) sum += v;
+    sink = sum > 0;
+  }, s.reps);
+}
+
+int main()
+{
+  BenchmarkRunner runner { "multiarray.hh", "construction, copies and element access" };
+  const bool large { std::getenv("COVDEL_BENCH_LARGE") != nullptr };
+
+  for (const scale &s : scales) {
+    if (s.elements > (size_t(1) << 23) && !large) continue;
+    bench_basics(runner, s);
+    bench_astype<uint8, float32>(runner, s, "uint8 -> float32");
+    bench_astype<float32, uint8>(runner, s, "float32 -> uint8");
+    bench_astype<int16, int32>(runner, s, "int16 -> int32");
+    bench_astype<int32, float32>(runner, s, "int32 -> float32");
+    bench_astype<float32, float64>(runner, s, "float32 -> float64");
+    bench_astype<float64, float32>(runner, s, "float64 -> float32");
+    if (s.elements <= (size_t(1) << 23)) bench_indexing(runner, s);
+  }
+
+  return EXIT_SUCCESS;
+}
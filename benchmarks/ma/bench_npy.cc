@@ -0,0 +1,46 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/npy.hh"
+
+#include <filesystem>
+
+using namespace covdel::ma;
+
+std::string scratch(const std::string &name)
+{
+  return (std::filesystem::temp_directory_path() / ("covdel_bench_" + name)).string();
+}
+
+// saving streams at disk speed, loading only maps, whatever the size of the file
+void bench_files(BenchmarkRunner &runner, const size_t rows)
+{
+  auto weights { full<float32>(D(rows, 4096), 0.5f) };
+  const double bytes { double(weights.size() * sizeof(float)) };
+  const std::string suffix { " " + std::to_string(rows * 16 / 1024) + "MiB" };
+  const auto path { scratch("weights.npy") }, archive { scratch("weights.npz") };
+
+  runner.run("save_npy" + suffix, bytes, [&] { save_npy(path, weights); });
+  runner.run("save_npy gathered" + suffix, bytes,
+    [&] { save_npy(path, weights.slice(1, 4095, -1, -1)); });
+  runner.run("npz_writer" + suffix, bytes, [&] {
+    npz_writer out { archive };
+    out.add("weights", weights);
+  });
+
+  save_npy(path, weights);
+  runner.run("load_npy" + suffix, bytes, [&] { load_npy<float32>(path); });
+  runner.run("npz_archive get" + suffix, bytes,
+    [&] { npz_archive { archive }.get<float32>("weights"); });
+  std::filesystem::remove(path);
+  std::filesystem::remove(archive);
+}
+
+int main()
+{
+  BenchmarkRunner runner { "npy.hh", ".npy and .npz files" };
+
+  bench_files(runner, 1024);
+  bench_files(runner, 16384);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/quantize.hh"
+#include "covdel/ma/simd.hh"
+
+#include <string>
+
+using namespace covdel::ma;
+
+template<typename _DType>
+quantized<_DType> generate(const D &dim, const std::int32_t zero_point)
+{
+  quantized<_DType> out { multiarray<_DType> { dim, uninitialized }, { { 0.05f }, { zero_point }, -1 } };
+  auto *data { out.values.data() };
+  for (size_t i { 0 }; i < out.values.size(); ++i)
+    data[i] = typename multiarray<_DType>::native_type(i * 7919 % 251);
+  return out;
+}
+
+// square products of uint8 activations and int8 weights against float32 ones, with
+// GOP/s in place of GB/s
+void bench_square(BenchmarkRunner &runner)
+{
+  for (const size_t size : { 64UL, 256UL, 512UL, 1024UL, 2048UL }) {
+    const auto a { generate<dtype::uint8>(D(size, size), 128) };
+    const auto b { generate<dtype::int8>(D(size, size), 0) };
+    const auto x { dequantize(a) }, y { dequantize(b) };
+    int32 sums { D(size, size), uninitialized };
+    quantized<dtype::uint8> c { uint8 { D(size, size), uninitialized }, { { 4.f }, { 0 }, -1 } };
+    float32 z { D(size, size), uninitialized };
+    const double ops { 2. * double(size) * double(size) * double(size) };
+    const std::string shape { " (" + std::to_string(size) + ")^2" };
+
+    runner.run("float32 matmul" + shape, ops, [&] { matmul(x, y, z); });
+    runner.run("uint8 x int8 -> int32" + shape, ops, [&] { qgemm(a, b, sums); });
+    runner.run("uint8 x int8 -> uint8, relu" + shape, ops,
+      [&] { qgemm(a, b, c, { {}, true }); });
+  }
+}
+
+// a convolution as a product of im2col columns and per-channel weights, on every level
+void bench_levels(BenchmarkRunner &runner)
+{
+  const auto columns { generate<dtype::uint8>(D(56 * 56, 64 * 9), 128) };
+  auto weights { generate<dtype::int8>(D(64, 64 * 9), 0) };
+  weights.params = { std::vector<float>(64, 0.01f), std::vector<std::int32_t>(64, 0), 0 };
+  quantized<dtype::uint8> out { uint8 { D(56 * 56, 64), uninitialized }, { { 1.f }, { 0 }, -1 } };
+  const double ops { 2. * 56 * 56 * 64 * 64 * 9 };
+
+  const auto level { active_isa() };
+  for (int l { int(max_isa()) }; l >= 0; --l) {
+    set_isa(isa(l));
+    runner.run("(3136, 576) x (576, 64)^T, " + str(isa(l)), ops,
+      [&] { qgemm(columns, weights, out, {}, false, true); });
+  }
+  set_isa(level);
+}
+
+int main()
+{
+  BenchmarkRunner runner { "quantize.hh", "quantized products, GOP/s in place of GB/s" };
+
+  bench_square(runner);
+  bench_levels(runner);
+
+  return EXIT_SUCCESS;
+}
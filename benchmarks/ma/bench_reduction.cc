@@ -0,0 +1,40 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/reduction.hh"
+
+using namespace covdel::ma;
+
+// whole array reductions of a memory bound size
+void bench_totals(BenchmarkRunner &runner)
+{
+  const float32 f { D(1UL << 24), 0.5f };
+  const uint8 u { D(1UL << 24), 7 };
+  const double bytes { double(f.size()) };
+
+  runner.run("float32 sum n=16M", bytes * sizeof(float), [&] { sum(f); });
+  runner.run("float32 max n=16M", bytes * sizeof(float), [&] { max(f); });
+  runner.run("float32 argmax n=16M", bytes * sizeof(float), [&] { argmax(f); });
+  runner.run("float32 var n=16M", 2 * bytes * sizeof(float), [&] { var(f); });
+  runner.run("uint8 sum n=16M", bytes, [&] { sum(u); });
+}
+
+// reducing either axis of a square matrix, row by row or block by block
+void bench_axes(BenchmarkRunner &runner)
+{
+  const float32 m { D(4096, 4096), 0.25f };
+  const double bytes { double(m.size() * sizeof(float)) };
+
+  runner.run("float32 (4096, 4096) sum axis 0", bytes, [&] { sum(m, 0); });
+  runner.run("float32 (4096, 4096) sum axis 1", bytes, [&] { sum(m, 1); });
+  runner.run("float32 (4096, 4096) max axis 0", bytes, [&] { max(m, 0); });
+}
+
+int main()
+{
+  BenchmarkRunner runner { "reduction.hh", "reductions along axes" };
+
+  bench_totals(runner);
+  bench_axes(runner);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "../utils.hh"
+#include "covdel/nn/conv.hh"
+
+#include <string>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using nn::conv2d_params;
+using nn::conv_algorithm;
+using nn::layout;
+
+ma::float32 generate(const D &dim)
+{
+  ma::float32 out { dim, ma::uninitialized };
+  for (size_t i { 0 }; i < out.size(); ++i) out.data()[i] = float(i * 7919 % 251) / 251.F - 0.5F;
+  return out;
+}
+
+std::string str(const conv_algorithm algorithm)
+{
+  switch (algorithm) {
+    case conv_algorithm::im2col: return "im2col";
+    case conv_algorithm::direct: return "direct";
+    case conv_algorithm::winograd: return "winograd";
+    default: return "automatic";
+  }
+}
+
+struct layer {
+  std::string name;
+  size_t n, c, h, w, m, k;
+  conv2d_params params;
+  std::vector<conv_algorithm> algorithms;
+};
+
+// layers of common networks, on every algorithm which fits them and the automatic choice
+void bench_layers(BenchmarkRunner &runner)
+{
+  using A = conv_algorithm;
+  const std::vector<layer> layers {
+    { "stem 7x7/2, 3->64, 224^2", 1, 3, 224, 224, 64, 7, { { 2, 2 }, { 3, 3 } }, { A::im2col } },
+    { "3x3, 3->16, 32^2 x8", 8, 3, 32, 32, 16, 3, { { 1, 1 }, { 1, 1 } },
+      { A::im2col, A::winograd } },
+    { "3x3, 16->16, 32^2 x8", 8, 16, 32, 32, 16, 3, { { 1, 1 }, { 1, 1 } },
+      { A::im2col, A::winograd } },
+    { "3x3, 64->64, 56^2", 1, 64, 56, 56, 64, 3, { { 1, 1 }, { 1, 1 } },
+      { A::im2col, A::winograd } },
+    { "3x3, 256->256, 14^2", 1, 256, 14, 14, 256, 3, { { 1, 1 }, { 1, 1 } },
+      { A::im2col, A::winograd } },
+    { "3x3/2, 64->128, 56^2", 1, 64, 56, 56, 128, 3, { { 2, 2 }, { 1, 1 } }, { A::im2col } },
+    { "1x1, 64->256, 56^2", 1, 64, 56, 56, 256, 1, {}, { A::im2col, A::direct } },
+    { "depthwise 3x3, 96, 112^2", 1, 96, 112, 112, 96, 3, { { 1, 1 }, { 1, 1 }, { 1, 1 }, 96 },
+      { A::im2col, A::direct } },
+  };
+
+  for (const auto &l : layers)
+    for (const auto format : { layout::nchw, layout::nhwc }) {
+      auto params { l.params };
+      params.format = format;
+      const auto x { generate(format == layout::nchw ? D(l.n, l.c, l.h, l.w) : D(l.n, l.h, l.w, l.c)) };
+      const auto w { generate(D(l.m, l.c / params.groups, l.k, l.k)) };
+      const auto b { generate(D(l.m)) };
+      ma::float32 y { nn::conv2d_shape(x.dim(), w.dim(), params), ma::uninitialized };
+      const double flops { 2. * double(y.size()) * double(l.c / params.groups * l.k * l.k) };
+      const std::string shape { l.name + (format == layout::nchw ? ", nchw" : ", nhwc") };
+
+      for (auto algorithm : l.algorithms) {
+        params.algorithm = algorithm;
+        runner.run(shape + ", " + str(algorithm), flops, [&] { nn::conv2d(x, w, b, y, params); });
+      }
+      params.algorithm = A::automatic;
+      runner.run(shape + ", automatic -> " + str(nn::conv2d_algorithm(x.dim(), w.dim(), params)),
+        flops, [&] { nn::conv2d(x, w, b, y, params); });
+    }
+}
+
+// a uint8 layer quantized per filter against float32
+void bench_quantized(BenchmarkRunner &runner)
+{
+  for (const auto format : { layout::nchw, layout::nhwc }) {
+    conv2d_params params { { 1, 1 }, { 1, 1 } };
+    params.format = format;
+    const D dim { format == layout::nchw ? D(1, 64, 56, 56) : D(1, 56, 56, 64) };
+    const ma::quantized<ma::dtype::uint8> x { ma::uint8 { dim, 3 }, { { 0.05F }, { 128 }, -1 } };
+    ma::quantized<ma::dtype::int8> w { ma::int8 { D(64, 64, 3, 3), 1 },
+      { std::vector<float>(64, 0.01F), std::vector<std::int32_t>(64, 0), 0 } };
+    ma::quantized<ma::dtype::uint8> y { ma::uint8 { nn::conv2d_shape(dim, w.values.dim(), params) },
+      { { 1.F }, { 0 }, -1 } };
+    const double ops { 2. * 56 * 56 * 64 * 64 * 9 };
+    const std::string shape { std::string("3x3, 64->64, 56^2, uint8, ") +
+                              (format == layout::nchw ? "nchw" : "nhwc") };
+    runner.run(shape, ops, [&] { nn::conv2d(x, w, { {}, true }, y, params); });
+  }
+}
+
+int main()
+{
+  BenchmarkRunner runner { "conv.hh", "2-D convolutions, GFLOP/s in place of GB/s" };
+
+  bench_layers(runner);
+  bench_quantized(runner);
+
+  return EXIT_SUCCESS;
+}
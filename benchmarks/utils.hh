@@ -0,0 +1,129 @@
+#ifndef __COVDEL_BENCHMARKS_UTILS_HH_1700481244__
+#define __COVDEL_BENCHMARKS_UTILS_HH_1700481244__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// times benchmark cases and prints a table of them, which is also appended as one line of
+// JSON to the file named by the COVDEL_BENCH_JSON environment variable when it is set, so
+// that runs can be diffed across commits
+class BenchmarkRunner {
+public:
+  // wall times in seconds of the timed calls of a case
+  struct timing {
+    double median, p99;
+    unsigned reps;
+  };
+
+  BenchmarkRunner(const std::string &bench_file, const std::string &bench_name)
+    : m_file { bench_file }, m_name { bench_name }
+  {
+    std::printf("Benchmarking: %s [%s]\n", bench_name.c_str(), bench_file.c_str());
+    std::printf("  %-40s %12s %12s %10s %12s\n", "case", "median (us)", "p99 (us)",
+      "GB/s", "Melem/s");
+  }
+
+  ~BenchmarkRunner()
+  {
+    write_json();
+    std::printf("Done.\n");
+  }
+
+  // timings of `reps` calls, after `warmup` untimed calls
+  template<typename _Func>
+  static timing measure(_Func &&func, unsigned reps = 15, unsigned warmup = 2)
+  {
+    while (warmup--) func();
+
+    reps = std::max(reps, 1U);
+    std::vector<double> samples(reps);
+    for (auto &sample : samples) {
+      const auto start { std::chrono::steady_clock::now() };
+      func();
+      const std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+      sample = elapsed.count();
+    }
+    std::sort(samples.begin(), samples.end());
+    // nearest rank, the slowest call under a hundred reps
+    const size_t rank { std::max<size_t>((99 * reps + 99) / 100, 1) - 1 };
+    return { samples[reps / 2], samples[rank], reps };
+  }
+
+  // median wall time in seconds of `reps` calls, after `warmup` untimed calls
+  template<typename _Func>
+  static double time(_Func &&func, unsigned reps = 15, unsigned warmup = 2)
+  {
+    return measure(func, reps, warmup).median;
+  }
+
+  // times `func` and prints its throughput over `bytes` of memory traffic per call
+  template<typename _Func>
+  double run(const std::string &case_name, double bytes, _Func &&func)
+  {
+    return run(case_name, bytes, 0, func);
+  }
+
+  // same, also counting `elements` processed per call, fewer reps suiting large cases
+  template<typename _Func>
+  double run(const std::string &case_name, double bytes, double elements, _Func &&func,
+    unsigned reps = 15, unsigned warmup = 2)
+  {
+    const timing t { measure(func, reps, warmup) };
+    m_cases.push_back({ case_name, t, bytes, elements });
+    std::printf("  %-40s %12.1f %12.1f %10.2f", case_name.c_str(), t.median * 1e6,
+      t.p99 * 1e6, bytes / t.median / 1e9);
+    if (elements > 0)
+      std::printf(" %12.1f\n", elements / t.median / 1e6);
+    else
+      std::printf(" %12s\n", "-");
+    return t.median;
+  }
+
+private:
+  struct result {
+    std::string name;
+    timing time;
+    double bytes, elements;
+  };
+
+  std::string m_file, m_name;
+  std::vector<result> m_cases;
+
+  static std::string quoted(const std::string &text)
+  {
+    std::string out { "\"" };
+    for (const char c : text) {
+      if (c == '"' || c == '\\') out += '\\';
+      out += c;
+    }
+    return out + '"';
+  }
+
+  void write_json() const
+  {
+    const char *path { std::getenv("COVDEL_BENCH_JSON") };
+    if (!path || !*path) return;
+    std::FILE *out { std::fopen(path, "a") };
+    if (!out) return void(std::fprintf(stderr, "cannot open %s\n", path));
+
+    std::fprintf(out, "{\"benchmark\": %s, \"file\": %s, \"cases\": [",
+      quoted(m_name).c_str(), quoted(m_file).c_str());
+    for (size_t i { 0 }; i < m_cases.size(); ++i) {
+      const result &c { m_cases[i] };
+      std::fprintf(out,
+        "%s{\"name\": %s, \"reps\": %u, \"median_s\": %.9g, \"p99_s\": %.9g, "
+        "\"bytes\": %.17g, \"elements\": %.17g, \"gb_per_s\": %.6g, "
+        "\"elements_per_s\": %.6g}",
+        i ? ", " : "", quoted(c.name).c_str(), c.time.reps, c.time.median, c.time.p99,
+        c.bytes, c.elements, c.bytes / c.time.median / 1e9, c.elements / c.time.median);
+    }
+    std::fprintf(out, "]}\n");
+    std::fclose(out);
+  }
+};
+
+#endif
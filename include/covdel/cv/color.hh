@@ -0,0 +1,94 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_CV_COLOR_HH_1701643170__
+#define __COVDEL_INCLUDE_COVDEL_CV_COLOR_HH_1701643170__
+
+#include "covdel/ma/factory.hh"
+
+#include <array>
+
+namespace covdel::cv
+{
+  // Colour spaces of uint8 and float32 images. Float samples of gray, rgb and bgr range
+  // over [0, 1], as uint8 ones over [0, 255]. Hue of hsv is in degrees over [0, 360) as
+  // float and halved over [0, 180) as uint8, saturation and value range as samples do.
+  // yuv is the full range YCbCr of BT.601, chroma centred on 128 or 0.5.
+  // yuv420p, nv12 and yuyv are the uint8 frames of cameras and video codecs, in the
+  // limited range of BT.601: yuv420p and nv12 of shape (height * 3 / 2, width), the
+  // luma plane followed by chroma planes subsampled by 2 both ways, yuv420p of
+  // contiguous u and v planes and nv12 of interleaved uv rows, and yuyv of shape
+  // (height, width, 2), chroma subsampled by 2 across rows. Their heights and widths
+  // are even.
+  enum class color { gray, rgb, bgr, hsv, yuv, yuv420p, nv12, yuyv };
+
+  // channels of gray, rgb, bgr, hsv and yuv images, interleaved of shape (height, width,
+  // channels), or planar of shape (channels, height, width) as models take them; gray
+  // images may also have the shape (height, width)
+  enum class packing { interleaved, planar };
+
+  struct pixel_format {
+    color space;
+    packing layout { packing::interleaved };
+
+    pixel_format(const color space, const packing layout = packing::interleaved) noexcept
+      : space { space }, layout { layout }
+    {}
+  };
+
+  // float32 results of each channel become (value - mean) / std, as models normalize
+  // their inputs
+  struct normalization {
+    std::array<float, 3> mean { 0, 0, 0 };
+    std::array<float, 3> std { 1, 1, 1 };
+  };
+
+  // converts `src` in the `from` format into `dst` in the `to` format, of the same height
+  // and width and any strides, rounding and saturating uint8 results. Each range of rows
+  // runs across the threads of the default executor in a single pass, through rows of
+  // float samples held per thread, so that fused conversions such as nv12 to normalized
+  // planar float32 rgb never materialize intermediate images. Throws
+  // std::invalid_argument for shapes which do not fit the formats, and for normalizing
+  // uint8 results.
+  template<typename _InDType, typename _OutDType>
+  void convert_color(const ma::multiarray<_InDType> &src, pixel_format from,
+    ma::multiarray<_OutDType> &dst, pixel_format to, const normalization &norm = {});
+
+  namespace detail
+  {
+    // shape of an image of the given height and width in a format
+    ma::dimension color_shape(size_t height, size_t width, pixel_format format);
+
+    // height and width of an image in a format, checking its shape
+    std::array<size_t, 2> color_size(const ma::dimension &dim, pixel_format format);
+  }  // namespace detail
+
+  // results in new arrays, of the datatype of `_AsArray`
+  template<typename _AsArray, typename _InDType>
+  _AsArray convert_color(const ma::multiarray<_InDType> &src, const pixel_format from,
+    const pixel_format to, const normalization &norm = {})
+  {
+    const auto [height, width] { detail::color_size(src.dim(), from) };
+    _AsArray dst { detail::color_shape(height, width, to), ma::uninitialized };
+    convert_color(src, from, dst, to, norm);
+    return dst;
+  }
+
+}  // namespace covdel::cv
+
+#endif
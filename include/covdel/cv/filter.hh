@@ -0,0 +1,113 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_CV_FILTER_HH_1701471580__
+#define __COVDEL_INCLUDE_COVDEL_CV_FILTER_HH_1701471580__
+
+#include "covdel/ma/factory.hh"
+
+namespace covdel::cv
+{
+  // samples beyond the edges of an image, `constant` takes a given value, `replicate`
+  // repeats the edge (aaa|abcd|ddd) and `reflect` mirrors around it (dcb|abcd|cba)
+  enum class border { constant, replicate, reflect };
+
+  // Filters correlate uint8 or float32 images of shape (height, width) or (height, width,
+  // channels) with a kernel anchored at its centre, (size - 1) / 2 for even sizes, each
+  // channel on its own. Samples are filtered as floats, uint8 results are rounded to
+  // nearest and saturated. `dst` must have the shape of `src` but any layout, and may
+  // overlap it. Row bands run across the threads of the default executor.
+
+  // 2-D kernel of shape (rows, columns), which runs as two 1-D passes when it is separable
+  template<typename _DType>
+  void filter2d(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const ma::float32 &kernel, border mode = border::reflect, float value = 0);
+
+  // 1-D `kx` along the rows followed by 1-D `ky` along the columns
+  template<typename _DType>
+  void sep_filter2d(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const ma::float32 &kx, const ma::float32 &ky, border mode = border::reflect,
+    float value = 0);
+
+  // normalized 1-D gaussian of an odd size, with `sigma` derived from the size when not
+  // positive, as 0.3 * ((size - 1) / 2 - 1) + 0.8
+  ma::float32 gaussian_kernel(int size, double sigma = 0);
+
+  template<typename _DType>
+  void gaussian_blur(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    int size, double sigma = 0, border mode = border::reflect);
+
+  // mean, or sum unless `normalize`, over a window of (rows, columns), in constant time
+  // per pixel from running sums
+  template<typename _DType>
+  void box_filter(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    int rows, int columns, bool normalize = true, border mode = border::reflect,
+    float value = 0);
+
+  // 1-D smoothing and derivative kernels of a sobel operator of size 1, 3, 5 or 7 and
+  // derivatives of order up to 2, or fewer than the size, size 1 only differentiating
+  ma::float32 sobel_kernel(int size, int order);
+
+  // image derivatives of orders `dx` along the rows and `dy` along the columns, with sobel
+  // operators or the more rotation invariant 3 x 3 scharr operator
+  template<typename _DType>
+  void sobel(const ma::multiarray<_DType> &src, ma::float32 &dst, int dx, int dy,
+    int size = 3, border mode = border::reflect);
+
+  template<typename _DType>
+  void scharr(const ma::multiarray<_DType> &src, ma::float32 &dst, int dx, int dy,
+    border mode = border::reflect);
+
+// results in new arrays
+#define FILTER_FUNCTION(name, result, params, args)                                     \
+ template<typename _DType>                                                             \
+ ma::multiarray<result> name(const ma::multiarray<_DType> &src, params)                \
+ {                                                                                     \
+  ma::multiarray<result> dst { src.dim(), ma::uninitialized };                         \
+  name(src, dst, args);                                                                \
+  return dst;                                                                          \
+ }
+
+#define FILTER_ARGS(...) __VA_ARGS__
+
+  FILTER_FUNCTION(filter2d, _DType,
+    FILTER_ARGS(const ma::float32 &kernel, border mode = border::reflect, float value = 0),
+    FILTER_ARGS(kernel, mode, value))
+  FILTER_FUNCTION(sep_filter2d, _DType,
+    FILTER_ARGS(const ma::float32 &kx, const ma::float32 &ky,
+      border mode = border::reflect, float value = 0),
+    FILTER_ARGS(kx, ky, mode, value))
+  FILTER_FUNCTION(gaussian_blur, _DType,
+    FILTER_ARGS(int size, double sigma = 0, border mode = border::reflect),
+    FILTER_ARGS(size, sigma, mode))
+  FILTER_FUNCTION(box_filter, _DType,
+    FILTER_ARGS(int rows, int columns, bool normalize = true,
+      border mode = border::reflect, float value = 0),
+    FILTER_ARGS(rows, columns, normalize, mode, value))
+  FILTER_FUNCTION(sobel, ma::dtype::float32,
+    FILTER_ARGS(int dx, int dy, int size = 3, border mode = border::reflect),
+    FILTER_ARGS(dx, dy, size, mode))
+  FILTER_FUNCTION(scharr, ma::dtype::float32,
+    FILTER_ARGS(int dx, int dy, border mode = border::reflect), FILTER_ARGS(dx, dy, mode))
+
+#undef FILTER_ARGS
+#undef FILTER_FUNCTION
+
+}  // namespace covdel::cv
+
+#endif
@@ -0,0 +1,93 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_CV_GEOMETRY_HH_1701557612__
+#define __COVDEL_INCLUDE_COVDEL_CV_GEOMETRY_HH_1701557612__
+
+#include "covdel/cv/filter.hh"
+#include "covdel/ma/factory.hh"
+
+namespace covdel::cv
+{
+  // `area` averages the source pixels a destination pixel covers when downscaling, and
+  // interpolates bilinearly when upscaling
+  enum class interpolation { nearest, bilinear, bicubic, area };
+
+  // Geometric transforms of uint8 or float32 images of shape (height, width) or (height,
+  // width, channels) into a `dst` of the same channels and any layout, whose height and
+  // width give the size of the result. Pixel centres sit at integer coordinates, rows of
+  // `dst` run across the threads of the default executor, and uint8 results are rounded
+  // to nearest and saturated.
+
+  // scales `src` to the size of `dst`, mapping pixel centres onto each other and
+  // replicating the edges. Resampling weights are cached per source and destination size,
+  // so that resizing a stream of frames allocates nothing once warmed up. Bilinear uint8
+  // resizes run in fixed-point. `antialias` widens bilinear and bicubic kernels by the
+  // downscaling factor, so that they low-pass the source as `area` does.
+  template<typename _DType>
+  void resize(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    interpolation method = interpolation::bilinear, bool antialias = false);
+
+  // `matrix` of shape (2, 3) maps source coordinates (x, y, 1) to destination ones, and is
+  // inverted to sample the source, or already maps destination coordinates to the source
+  // when `inverse`. Samples beyond the source follow the border mode.
+  template<typename _DType>
+  void warp_affine(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const ma::float64 &matrix, interpolation method = interpolation::bilinear,
+    border mode = border::constant, float value = 0, bool inverse = false);
+
+  // rotation by `angle` degrees counterclockwise around (x, y), then scaling by `scale`
+  ma::float64 rotation_matrix(double x, double y, double angle, double scale = 1);
+
+  namespace detail
+  {
+    // shape of an image of the given height and width, with the channels of `dim`
+    inline ma::dimension resized(const ma::dimension &dim, const size_t height,
+      const size_t width)
+    {
+      return dim.ndims() == 3 ? ma::dimension(height, width, dim[2])
+                              : ma::dimension(height, width);
+    }
+  }  // namespace detail
+
+  // results in new arrays of the given height and width
+  template<typename _DType>
+  ma::multiarray<_DType> resize(const ma::multiarray<_DType> &src, size_t height,
+    size_t width, interpolation method = interpolation::bilinear, bool antialias = false)
+  {
+    ma::multiarray<_DType> dst { detail::resized(src.dim(), height, width),
+      ma::uninitialized };
+    resize(src, dst, method, antialias);
+    return dst;
+  }
+
+  template<typename _DType>
+  ma::multiarray<_DType> warp_affine(const ma::multiarray<_DType> &src,
+    const ma::float64 &matrix, size_t height, size_t width,
+    interpolation method = interpolation::bilinear, border mode = border::constant,
+    float value = 0, bool inverse = false)
+  {
+    ma::multiarray<_DType> dst { detail::resized(src.dim(), height, width),
+      ma::uninitialized };
+    warp_affine(src, dst, matrix, method, mode, value, inverse);
+    return dst;
+  }
+
+}  // namespace covdel::cv
+
+#endif
@@ -0,0 +1,63 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_CV_IMAGEIO_HH_1701389950__
+#define __COVDEL_INCLUDE_COVDEL_CV_IMAGEIO_HH_1701389950__
+
+#include "covdel/ma/factory.hh"
+
+#include <string>
+#include <vector>
+
+namespace covdel::cv
+{
+  // file formats, recognized by their signature when read and by the file extension when
+  // written, .pbm .pgm .ppm or .pnm for netpbm
+  enum class image_format { pnm, bmp, png };
+
+  // image stored in a file, always decoded as 8-bit samples of shape (height, width,
+  // channels), with 1 channel for gray, 2 for gray and alpha, 3 for rgb and 4 for rgba
+  struct image_header {
+    image_format format;
+    ma::dimension dim;
+  };
+
+  image_header inspect_image(const std::string &path);
+
+  // decodes the image straight into `out`, which must have the shape of the image and
+  // contiguous pixels within its rows, rows themselves may lie anywhere, such as in a
+  // slice of a larger array, throws std::invalid_argument for malformed or unsupported
+  // files and std::system_error when they cannot be read
+  void read_image(const std::string &path, ma::uint8 &out);
+  ma::uint8 read_image(const std::string &path);
+
+  // decodes images of the same shape into the (count, height, width, channels) `batch`,
+  // and images of any shape into new arrays, across the threads of the default executor
+  void read_images(const std::vector<std::string> &paths, ma::uint8 &batch);
+  std::vector<ma::uint8> read_images(const std::vector<std::string> &paths);
+
+  // paths of the images in a directory, by their extensions, in lexicographic order
+  std::vector<std::string> list_images(const std::string &directory);
+
+  // encodes an image of shape (height, width, channels) of any layout, pnm files take
+  // 1 or 3 channels and bmp files 1, 3 or 4, `level` is the deflate level of png files,
+  // from 0 for none to 9 for the smallest
+  void write_image(const std::string &path, const ma::uint8 &image, int level = 6);
+
+}  // namespace covdel::cv
+
+#endif
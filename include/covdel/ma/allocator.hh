@@ -0,0 +1,122 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_ALLOCATOR_HH_1700695214__
+#define __COVDEL_INCLUDE_COVDEL_MA_ALLOCATOR_HH_1700695214__
+
+#include <atomic>
+#include <cstddef>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    struct thread_cache;
+  }
+
+  // alignment of every array buffer, a cache line and a full avx-512 register
+  inline constexpr std::size_t ALIGNMENT { 64 };
+
+  // source of raw array buffers, which are handed back along with their requested size,
+  // implementations must be thread safe and outlive every array they allocated
+  class allocator {
+  public:
+    virtual ~allocator() = default;
+
+    virtual void *allocate(std::size_t bytes) = 0;
+    virtual void deallocate(void *ptr, std::size_t bytes) noexcept = 0;
+  };
+
+  // every buffer straight from the heap, aligned to ALIGNMENT
+  class aligned_allocator final : public allocator {
+  public:
+    void *allocate(std::size_t bytes) override;
+    void deallocate(void *ptr, std::size_t bytes) noexcept override;
+
+    static aligned_allocator &instance() noexcept;
+
+  private:
+    aligned_allocator() = default;
+  };
+
+  // aligned buffers rounded up to size classes, four per power of two, released buffers
+  // are cached by the releasing thread and handed out again to its later allocations of
+  // the same class, so repeatedly allocated frames of a pipeline stop reaching the heap
+  class pool_allocator final : public allocator {
+  public:
+    struct statistics {
+      std::size_t hits;          // allocations served from a thread cache
+      std::size_t misses;        // allocations which reached the heap
+      std::size_t cached_bytes;  // held by the caches of all threads
+    };
+
+    void *allocate(std::size_t bytes) override;
+    void deallocate(void *ptr, std::size_t bytes) noexcept override;
+
+    statistics stats() const noexcept;
+    void reset_stats() noexcept;
+
+    // bytes each thread may keep cached, 256MiB by default
+    std::size_t limit() const noexcept;
+    void set_limit(const std::size_t bytes) noexcept;
+
+    // returns the buffers cached by the calling thread to the heap
+    void trim() noexcept;
+
+    static pool_allocator &instance() noexcept;
+
+  private:
+    pool_allocator() = default;
+
+    std::atomic<std::size_t> m_hits {}, m_misses {}, m_cached {};
+    std::atomic<std::size_t> m_limit { std::size_t(1) << 28 };
+
+    friend struct detail::thread_cache;
+  };
+
+  // allocator of new arrays on the calling thread, the pool unless set otherwise
+  allocator &default_allocator() noexcept;
+  void set_default_allocator(allocator &alloc) noexcept;
+
+  // forwards to another allocator while counting the bytes it holds, live and at their
+  // peak, as the footprint of a training step or a pipeline, whose arrays are allocated
+  // from it once it is made the default allocator of their threads
+  class tracking_allocator final : public allocator {
+  public:
+    struct statistics {
+      std::size_t live;         // bytes currently allocated
+      std::size_t peak;         // most bytes allocated at once since the last reset
+      std::size_t allocations;  // number of allocations since the last reset
+    };
+
+    explicit tracking_allocator(allocator &upstream = default_allocator()) noexcept;
+
+    void *allocate(std::size_t bytes) override;
+    void deallocate(void *ptr, std::size_t bytes) noexcept override;
+
+    statistics stats() const noexcept;
+    // restarts the peak from the live bytes, and the count of allocations
+    void reset_peak() noexcept;
+
+  private:
+    allocator *p_upstream;
+    std::atomic<std::size_t> m_live {}, m_peak {}, m_allocations {};
+  };
+
+}  // namespace covdel::ma
+
+#endif
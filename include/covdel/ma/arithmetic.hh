@@ -0,0 +1,254 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_ARITHMETIC_HH_1700475903__
+#define __COVDEL_INCLUDE_COVDEL_MA_ARITHMETIC_HH_1700475903__
+
+#include "multiarray.hh"
+
+#include <utility>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    // element-wise operation labels, also used as kernel table slots
+    enum class binary_op {
+      add,
+      subtract,
+      multiply,
+      divide,
+      minimum,
+      maximum,
+      // comparisons, yielding bool8
+      equal,
+      not_equal,
+      less,
+      less_equal,
+      greater,
+      greater_equal
+    };
+
+    enum class unary_op { abs, negative, sqrt, exp, log };
+
+    // an array, or a scalar repeated over the shape of the other operand
+    template<typename _DType>
+    struct elementwise_arg {
+      using native_type = typename multiarray<_DType>::native_type;
+
+      elementwise_arg(const multiarray<_DType> &array) noexcept : array { &array }, value {}
+      { }
+
+      elementwise_arg(const native_type value) noexcept : array { nullptr }, value { value }
+      { }
+
+      const multiarray<_DType> *array;
+      native_type value;
+    };
+
+    // kernels process `count` elements of strided runs, a zero stride repeats one element
+    template<typename _Type, typename _RType>
+    using binary_kernel = void (*)(const _Type *a, ptrdiff_t sa, const _Type *b,
+      ptrdiff_t sb, _RType *out, ptrdiff_t so, size_t count);
+
+    template<typename _Type>
+    using unary_kernel = void (*)(
+      const _Type *a, ptrdiff_t sa, _Type *out, ptrdiff_t so, size_t count);
+
+    template<typename _Type>
+    using clamp_kernel = void (*)(const _Type *a, ptrdiff_t sa, _Type lo, _Type hi,
+      _Type *out, ptrdiff_t so, size_t count);
+
+    // `out` holds elements of the datatype the kernel was found for
+    template<typename _Type>
+    using convert_kernel = void (*)(const _Type *a, ptrdiff_t sa, void *out, ptrdiff_t so,
+      size_t count, const conversion &conv);
+
+    // kernels of the active instruction set level
+    template<typename _DType, typename _RType>
+    binary_kernel<typename _DType::type, typename _RType::type> find_kernel(
+      const binary_op op);
+
+    template<typename _DType>
+    unary_kernel<typename _DType::type> find_kernel(const unary_op op);
+
+    template<typename _DType>
+    clamp_kernel<typename _DType::type> find_clamp_kernel();
+
+    template<typename _DType>
+    convert_kernel<typename _DType::type> find_convert_kernel(const datatype type);
+
+    // [first, last] byte range touched by a view
+    template<typename _DType>
+    std::pair<const char *, const char *> footprint(const multiarray<_DType> &a) noexcept
+    {
+      using native_type = typename multiarray<_DType>::native_type;
+      const native_type *first { a.data() }, *last { a.data() };
+      for (int i { -1 }; ++i < a.dim().ndims();) {
+        const ptrdiff_t span { ptrdiff_t(a.dim()[i] - 1) * a.strides()[i] };
+        (span < 0 ? first : last) += span;
+      }
+      return { reinterpret_cast<const char *>(first),
+        reinterpret_cast<const char *>(last + 1) - 1 };
+    }
+
+    // an input which overlaps the output with a different layout is copied first, so that
+    // in-place updates never read elements they have already overwritten
+    template<typename _DType, typename _RType>
+    multiarray<_DType> unaliased(const multiarray<_DType> &a, const multiarray<_RType> &out)
+    {
+      if (a.size() == 0 || out.size() == 0) return a;
+      const auto [a_first, a_last] { footprint(a) };
+      const auto [o_first, o_last] { footprint(out) };
+      if (a_last < o_first || o_last < a_first) return a;
+      if constexpr (std::is_same_v<_DType, _RType>)
+        if (a.data() == out.data() && a.strides() == out.strides()) return a;
+      return a.copy();
+    }
+
+    // view of a broadcast operand whose short repeating pattern is tiled into a small
+    // buffer, so that runs over it stay long and contiguous
+    template<typename _DType>
+    multiarray<_DType> tiled(const multiarray<_DType> &view);
+
+    template<typename _DType, typename _RType>
+    void binary(const binary_op op, const elementwise_arg<_DType> &a,
+      const elementwise_arg<_DType> &b, multiarray<_RType> &out);
+
+    template<typename _DType>
+    void unary(const unary_op op, const multiarray<_DType> &a, multiarray<_DType> &out);
+
+    template<typename _DType>
+    void clamp(const multiarray<_DType> &a, const typename multiarray<_DType>::native_type lo,
+      const typename multiarray<_DType>::native_type hi, multiarray<_DType> &out);
+
+  }  // namespace detail
+
+// element-wise binary function, returning a new array or writing into `out`, operands are
+// broadcast against each other (or against `out`) without being expanded in memory
+#define BINARY_FUNCTION(name, label, result)                                           \
+ template<typename _DType>                                                             \
+ multiarray<result> &name(                                                             \
+   const multiarray<_DType> &a, const multiarray<_DType> &b, multiarray<result> &out)  \
+ {                                                                                     \
+  detail::binary<_DType, result>(detail::binary_op::label, a, b, out);                 \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> &name(const multiarray<_DType> &a,                                 \
+   const typename multiarray<_DType>::native_type b, multiarray<result> &out)          \
+ {                                                                                     \
+  detail::binary<_DType, result>(detail::binary_op::label, a, b, out);                 \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> name(const multiarray<_DType> &a, const multiarray<_DType> &b)     \
+ {                                                                                     \
+  multiarray<result> out { broadcast(a.dim(), b.dim()), uninitialized };               \
+  detail::binary<_DType, result>(detail::binary_op::label, a, b, out);                 \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> name(                                                              \
+   const multiarray<_DType> &a, const typename multiarray<_DType>::native_type b)      \
+ {                                                                                     \
+  multiarray<result> out { a.dim(), uninitialized };                                   \
+  detail::binary<_DType, result>(detail::binary_op::label, a, b, out);                 \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> name(                                                              \
+   const typename multiarray<_DType>::native_type a, const multiarray<_DType> &b)      \
+ {                                                                                     \
+  multiarray<result> out { b.dim(), uninitialized };                                   \
+  detail::binary<_DType, result>(detail::binary_op::label, a, b, out);                 \
+  return out;                                                                          \
+ }
+
+// element-wise unary function, returning a new array or writing into `out`
+#define UNARY_FUNCTION(name)                                                            \
+ template<typename _DType>                                                             \
+ multiarray<_DType> &name(const multiarray<_DType> &a, multiarray<_DType> &out)        \
+ {                                                                                     \
+  detail::unary(detail::unary_op::name, a, out);                                       \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<_DType> name(const multiarray<_DType> &a)                                  \
+ {                                                                                     \
+  multiarray<_DType> out { a.dim(), uninitialized };                                   \
+  detail::unary(detail::unary_op::name, a, out);                                       \
+  return out;                                                                          \
+ }
+
+  // arithmetic, results keep the datatype of the operands
+  BINARY_FUNCTION(add, add, _DType)
+  BINARY_FUNCTION(subtract, subtract, _DType)
+  BINARY_FUNCTION(multiply, multiply, _DType)
+  BINARY_FUNCTION(divide, divide, _DType)
+  BINARY_FUNCTION(minimum, minimum, _DType)
+  BINARY_FUNCTION(maximum, maximum, _DType)
+
+  // comparisons
+  BINARY_FUNCTION(equal, equal, dtype::bool8)
+  BINARY_FUNCTION(not_equal, not_equal, dtype::bool8)
+  BINARY_FUNCTION(less, less, dtype::bool8)
+  BINARY_FUNCTION(less_equal, less_equal, dtype::bool8)
+  BINARY_FUNCTION(greater, greater, dtype::bool8)
+  BINARY_FUNCTION(greater_equal, greater_equal, dtype::bool8)
+
+  // math functions, integer types are evaluated in double precision and truncated back,
+  // saturating out of range results and turning NaN into zero
+  UNARY_FUNCTION(abs)
+  UNARY_FUNCTION(negative)
+  UNARY_FUNCTION(sqrt)
+  UNARY_FUNCTION(exp)
+  UNARY_FUNCTION(log)
+
+#undef BINARY_FUNCTION
+#undef UNARY_FUNCTION
+
+  template<typename _DType>
+  multiarray<_DType> &clamp(const multiarray<_DType> &a,
+    const typename multiarray<_DType>::native_type lo,
+    const typename multiarray<_DType>::native_type hi, multiarray<_DType> &out)
+  {
+    detail::clamp(a, lo, hi, out);
+    return out;
+  }
+
+  template<typename _DType>
+  multiarray<_DType> clamp(const multiarray<_DType> &a,
+    const typename multiarray<_DType>::native_type lo,
+    const typename multiarray<_DType>::native_type hi)
+  {
+    multiarray<_DType> out { a.dim(), uninitialized };
+    detail::clamp(a, lo, hi, out);
+    return out;
+  }
+
+}  // namespace covdel::ma
+
+// lazily evaluated operators, which build on the declarations above
+#include "expression.hh"
+
+#endif
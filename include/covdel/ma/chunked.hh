@@ -0,0 +1,105 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_CHUNKED_HH_1701302245__
+#define __COVDEL_INCLUDE_COVDEL_MA_CHUNKED_HH_1701302245__
+
+#include "multiarray.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace covdel::ma
+{
+  // chunked files store an array as tiles of a fixed shape, clipped at the upper edges,
+  // each compressed on its own with an in-tree LZ4-style codec after an optional byte
+  // shuffle, and kept raw when that does not pay off, an index of the tiles closes the file
+
+  // streams tiles into a new chunked file, in blocks of whole tiles written in any order,
+  // so arrays larger than memory are written piece by piece, tiles of a block are
+  // compressed in parallel, tiles never written read back as zeros, and the file is
+  // complete once closed, explicitly or by the destructor
+  class chunked_writer {
+  public:
+    chunked_writer(const std::string &path, const datatype type, const dimension &dim,
+      const dimension &tile, const bool shuffle = true);
+    chunked_writer(const chunked_writer &) = delete;
+    chunked_writer &operator=(const chunked_writer &) = delete;
+    ~chunked_writer() noexcept;
+
+    // `origin` and the far corner of the block lie on tile boundaries or the array edges
+    template<typename _DType>
+    void write(const index &origin, const multiarray<_DType> &block);
+    void close();
+
+  private:
+    std::ofstream m_out;
+    datatype m_type;
+    dimension m_dim, m_tile;
+    bool m_shuffle;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> m_index;  // offset and size
+  };
+
+  template<typename _DType>
+  void save_chunked(const std::string &path, const multiarray<_DType> &array,
+    const dimension &tile, const bool shuffle = true);
+
+  // chunked file mapped for reading regions, only the tiles overlapping a region are read,
+  // decompressed in parallel on the default executor and kept in a least recently used
+  // cache, shared by concurrent reads
+  class chunked_array {
+  public:
+    struct statistics {
+      std::size_t hits;          // tiles found in the cache
+      std::size_t misses;        // tiles decompressed
+      std::size_t cached_bytes;  // held by the cache
+    };
+
+    // `cache_bytes` of decompressed tiles are kept, 256MiB by default
+    explicit chunked_array(const std::string &path, std::size_t cache_bytes = 1 << 28);
+    chunked_array(chunked_array &&move) noexcept;
+    chunked_array &operator=(chunked_array &&move) noexcept;
+    ~chunked_array() noexcept;
+
+    datatype type() const noexcept;
+    const dimension &dim() const noexcept;
+    const dimension &tile() const noexcept;
+
+    // region of `shape` from `start`, or the whole array, throws std::invalid_argument if
+    // the file holds another datatype
+    template<typename _MultiArray>
+    _MultiArray read(const index &start, const dimension &shape) const;
+    template<typename _MultiArray>
+    _MultiArray read() const;
+
+    statistics stats() const noexcept;
+    std::size_t cache_limit() const noexcept;
+    void set_cache_limit(const std::size_t bytes);
+
+  private:
+    struct state;
+    std::unique_ptr<state> p_state;
+  };
+
+}  // namespace covdel::ma
+
+#endif
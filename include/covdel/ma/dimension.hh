@@ -1,79 +1,142 @@
 #ifndef __COVDEL_INCLUDE_COVDEL_MA_DIMENSION_HH_1668933640__
 #define __COVDEL_INCLUDE_COVDEL_MA_DIMENSION_HH_1668933640__
 
+#include <array>
+#include <cstddef>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 namespace covdel::ma
 {
+  using std::ptrdiff_t;
   using std::size_t;
 
-  class _dsi {  // 16B
-  public:
-    // copy-move semantics
-    _dsi(const _dsi &copy);
-    _dsi(_dsi &&move) noexcept;
-    ~_dsi() noexcept;
-    _dsi &operator=(_dsi rhs) noexcept;
+  class dimension;
+  class index;
+
+  template<typename _DType>
+  class multiarray;
 
+  // inline fixed-capacity storage, trivially copyable and never allocating
+  template<typename _Type>
+  class _dsi {  // 56B
+  public:
     // operators
-    size_t operator[](const int idx) const;
+    constexpr _Type operator[](const int idx) const;
     bool operator==(const _dsi &rhs) const noexcept;
     bool operator!=(const _dsi &rhs) const noexcept;
-    friend std::ostream &operator<<(std::ostream &out, const _dsi &obj);
+
+    template<typename _OtherType>
+    friend std::ostream &operator<<(std::ostream &out, const _dsi<_OtherType> &obj);
 
     //  general
-    int ndims() const noexcept;
+    constexpr int ndims() const noexcept;
     std::string str() const;
     void swap(_dsi &other) noexcept;
 
   protected:
     template<typename... _Args,
       typename = std::enable_if_t<(std::is_integral_v<_Args> && ...)>>
-    _dsi(_Args... args);
+    constexpr _dsi(_Args... args);
 
     static constexpr int MAX_SIZE { 6 };
-    size_t *p_data;
+    std::array<_Type, MAX_SIZE> m_data;
     int m_len;
+
+    // positions are resolved against extents and strides in a single pass
+    friend class index;
+
+    // broadcast shapes are resolved axis by axis
+    friend dimension broadcast(const dimension &a, const dimension &b);
+
+    // reductions drop or keep axes one by one
+    friend dimension reduced(const dimension &dim, unsigned axes, bool keepdims);
+
+    // views rearrange extents and strides in tandem
+    template<typename _DType>
+    friend class multiarray;
   };
 
-  class dimension : public _dsi {  // 16B
+  class dimension : public _dsi<size_t> {  // 56B
   public:
     template<typename... _Args>
-    dimension(_Args... args);
+    constexpr dimension(_Args... args);
 
     //  general
     size_t size() const noexcept;
     void squeeze();
   };
 
-  class index : public _dsi {  // 16B
+  // element strides of an array view, signed to allow reversed slices
+  class stride : public _dsi<ptrdiff_t> {  // 56B
+  public:
+    template<typename... _Args>
+    constexpr stride(_Args... args);
+
+    // row-major strides of a contiguous array with the given shape
+    explicit stride(const dimension &dim) noexcept;
+  };
+
+  class index : public _dsi<size_t> {  // 56B
   public:
     template<typename... _Args>
-    index(_Args... args);
+    constexpr index(_Args... args);
 
     // general
     size_t flat(const dimension &dim) const;
+    ptrdiff_t offset(const dimension &dim, const stride &strides) const;
     bool operator<(const dimension &dim) const;
     bool operator>=(const dimension &dim) const;
   };
 
+  // shape both dimensions broadcast to, aligning trailing axes where extents of 1 stretch
+  dimension broadcast(const dimension &a, const dimension &b);
+
+  // shape left after reducing the axes set in the `axes` bitmask, which stay with an extent
+  // of 1 under `keepdims`, reducing every axis without it leaves the shape (1)
+  dimension reduced(const dimension &dim, const unsigned axes, const bool keepdims);
+
   // in-header definitions
 
+  template<typename _Type>
   template<typename... _Args, typename>
-  _dsi::_dsi(_Args... args) : p_data { new size_t[MAX_SIZE] {} }, m_len { 0 }
+  constexpr _dsi<_Type>::_dsi(_Args... args) : m_data {}, m_len { 0 }
   {
     if (sizeof...(args) == 0 || sizeof...(args) > MAX_SIZE)
       throw std::invalid_argument { "no. of arguments must be non-zero and less than 6" };
-    ((p_data[m_len++] = args), ...);
+    ((m_data[m_len++] = static_cast<_Type>(args)), ...);
   }
 
+  template<typename _Type>
+  constexpr _Type _dsi<_Type>::operator[](const int idx) const
+  {
+    return idx < m_len ? m_data[idx] : throw std::out_of_range { "index out of bounds" };
+  }
+
+  template<typename _Type>
+  constexpr int _dsi<_Type>::ndims() const noexcept
+  {
+    return m_len;
+  }
+
+  template<typename... _Args>
+  constexpr dimension::dimension(_Args... args) : _dsi { args... }
+  { }
+
   template<typename... _Args>
-  dimension::dimension(_Args... args) : _dsi { args... }
+  constexpr stride::stride(_Args... args) : _dsi { args... }
   { }
 
   template<typename... _Args>
-  index::index(_Args... args) : _dsi { args... }
+  constexpr index::index(_Args... args) : _dsi { args... }
   { }
+
+  static_assert(std::is_trivially_copyable_v<dimension>, "'dimension' must stay trivial\n");
+  static_assert(std::is_trivially_copyable_v<stride>, "'stride' must stay trivial\n");
+  static_assert(std::is_trivially_copyable_v<index>, "'index' must stay trivial\n");
+
 }  // namespace covdel::ma
 
 #endif
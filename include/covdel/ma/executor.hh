@@ -0,0 +1,90 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_EXECUTOR_HH_1700781406__
+#define __COVDEL_INCLUDE_COVDEL_MA_EXECUTOR_HH_1700781406__
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace covdel::ma
+{
+  // runs the parallel loops of array operations, implementations call `func(begin, end)`
+  // over consecutive ranges covering [0, count) exactly once, each at least `grain` long
+  // unless the whole loop is shorter, and return once all are done, rethrowing the first
+  // exception thrown by `func`
+  class executor {
+  public:
+    virtual ~executor() = default;
+
+    // threads which may run ranges concurrently, the calling one included
+    virtual std::size_t concurrency() const noexcept = 0;
+
+    virtual void parallel_for(std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t)> &func) = 0;
+  };
+
+  // runs every loop as a single range on the calling thread
+  class serial_executor final : public executor {
+  public:
+    std::size_t concurrency() const noexcept override;
+    void parallel_for(std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t)> &func) override;
+
+    static serial_executor &instance() noexcept;
+
+  private:
+    serial_executor() = default;
+  };
+
+  // work-stealing pool, ranges are split in halves down to the grain by the worker running
+  // them, which keeps the first half and leaves the others to idle workers, the calling
+  // thread takes part and loops may be nested from within ranges
+  class thread_pool final : public executor {
+  public:
+    // `threads` workers besides the calling thread, none runs every loop inline
+    explicit thread_pool(const std::size_t threads);
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+    ~thread_pool() noexcept override;
+
+    std::size_t concurrency() const noexcept override;
+    void parallel_for(std::size_t count, std::size_t grain,
+      const std::function<void(std::size_t, std::size_t)> &func) override;
+
+    // shared pool with a worker less than the hardware threads, alive until the process exits
+    static thread_pool &instance();
+
+  private:
+    struct state;
+    std::unique_ptr<state> p_state;
+  };
+
+  // executor of array operations started by the calling thread, the shared pool unless set
+  // otherwise, set it to fit array operations into another scheduler
+  executor &default_executor();
+  void set_default_executor(executor &exec) noexcept;
+
+  // bytes an element-wise operation reads and writes per range, operations on fewer than
+  // twice as many bytes run inline on the calling thread, 256KiB by default
+  std::size_t grain_size() noexcept;
+  void set_grain_size(const std::size_t bytes) noexcept;
+
+}  // namespace covdel::ma
+
+#endif
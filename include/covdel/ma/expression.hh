@@ -0,0 +1,629 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_EXPRESSION_HH_1700529262__
+#define __COVDEL_INCLUDE_COVDEL_MA_EXPRESSION_HH_1700529262__
+
+#include "arithmetic.hh"
+#include "executor.hh"
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+namespace covdel::ma
+{
+  // base of lazily evaluated element-wise expressions, which only compute when assigned to
+  // a multiarray or evaluated, in a single pass without intermediate arrays
+  template<typename _Derived>
+  struct expression {
+    const _Derived &self() const noexcept { return static_cast<const _Derived &>(*this); }
+
+    // evaluates into a new contiguous array
+    auto eval() const;
+
+    // evaluates into an existing array, which the expression is broadcast to
+    template<typename _DType>
+    multiarray<_DType> &eval(multiarray<_DType> &out) const;
+  };
+
+  namespace detail
+  {
+    // elements evaluated per block, small enough for every node's buffer to stay in L1
+    static constexpr size_t BLOCK { 512 };
+
+    // position of an array operand during evaluation
+    struct slot {
+      char *data;
+      std::array<ptrdiff_t, 6> steps;  // in bytes
+      size_t size;                     // element size in bytes
+      char *cursor;                    // first element of the current run
+      ptrdiff_t inner;                 // element stride along the run
+    };
+
+    // values of one block, `stride` elements apart
+    template<typename _Type>
+    struct block {
+      const _Type *data;
+      ptrdiff_t stride;
+    };
+
+    // evaluation target, handing out a slot to every array leaf
+    template<typename _RType>
+    struct context {
+      // view of a leaf read during evaluation, copied when it overlaps the output
+      template<typename _DType>
+      multiarray<_DType> prepare(const multiarray<_DType> &array) const
+      {
+        return tiled(unaliased(array, out).broadcast_to(out.dim()));
+      }
+
+      template<typename _DType>
+      const slot *bind(const multiarray<_DType> &view) noexcept
+      {
+        slot &next { *p_next++ };
+        next.data = reinterpret_cast<char *>(const_cast<typename _DType::type *>(view.data()));
+        next.size = sizeof(typename _DType::type);
+        for (int i { -1 }; ++i < view.dim().ndims();)
+          next.steps[i] = view.strides()[i] * ptrdiff_t(next.size);
+        return &next;
+      }
+
+      multiarray<_RType> &out;
+      slot *p_next;
+    };
+
+    // hands out the slots of a context which already bound the same expression, in the
+    // same order, for the states of ranges evaluated concurrently
+    struct rebind_context {
+      template<typename _DType>
+      const multiarray<_DType> &prepare(const multiarray<_DType> &array) const noexcept
+      {
+        return array;
+      }
+
+      template<typename _DType>
+      const slot *bind(const multiarray<_DType> &) noexcept
+      {
+        return p_next++;
+      }
+
+      slot *p_next;
+    };
+
+    ////////////////////////////////////// LEAVES ////////////////////////////////////////
+
+    template<typename _DType>
+    struct leaf {
+      using dtype       = _DType;
+      using native_type = typename multiarray<_DType>::native_type;
+
+      static constexpr bool is_scalar { false };
+      static constexpr size_t LEAVES { 1 };
+
+      explicit leaf(const multiarray<_DType> &array) : m_array { array } { }
+
+      dimension dim() const { return m_array.dim(); }
+
+      struct state {
+        template<typename _Context>
+        state(const leaf &node, _Context &ctx)
+          : view { ctx.prepare(node.m_array) }, p_slot { ctx.bind(view) }
+        { }
+
+        multiarray<_DType> view;
+        const slot *p_slot;
+      };
+
+      static block<native_type> compute(state &s, const size_t start, size_t) noexcept
+      {
+        const auto *first { reinterpret_cast<const native_type *>(s.p_slot->cursor) };
+        return { first + ptrdiff_t(start) * s.p_slot->inner, s.p_slot->inner };
+      }
+
+      multiarray<_DType> m_array;
+    };
+
+    template<typename _DType>
+    struct scalar_leaf {
+      using dtype       = _DType;
+      using native_type = typename multiarray<_DType>::native_type;
+
+      static constexpr bool is_scalar { true };
+      static constexpr size_t LEAVES { 0 };
+
+      explicit scalar_leaf(const native_type value) noexcept : m_value { value } { }
+
+      struct state {
+        template<typename _Context>
+        state(const scalar_leaf &node, _Context &) noexcept : value { node.m_value }
+        { }
+
+        native_type value;
+      };
+
+      static block<native_type> compute(state &s, size_t, size_t) noexcept
+      {
+        return { &s.value, 0 };
+      }
+
+      native_type m_value;
+    };
+
+    /////////////////////////////////////// NODES ////////////////////////////////////////
+
+    // interior nodes compute blocks into their own buffer, or straight into the output
+    // when they are the root of the expression
+    template<typename _Node>
+    struct node : expression<_Node> {
+      template<typename _State>
+      static auto compute(_State &s, const size_t start, const size_t count) noexcept
+      {
+        _Node::eval_into(s, start, count, s.buffer, 1);
+        return block<typename _Node::native_type> { s.buffer, 1 };
+      }
+    };
+
+    template<binary_op _Op, typename _Lhs, typename _Rhs>
+    struct binary_node : node<binary_node<_Op, _Lhs, _Rhs>> {
+      static_assert(std::is_same_v<typename _Lhs::dtype, typename _Rhs::dtype>,
+        "operands of an expression must share a datatype\n");
+      static_assert(int(_Op) < int(binary_op::equal), "comparisons are evaluated eagerly\n");
+
+      using dtype       = typename _Lhs::dtype;
+      using native_type = typename multiarray<dtype>::native_type;
+
+      static constexpr bool is_scalar { _Lhs::is_scalar && _Rhs::is_scalar };
+      static constexpr size_t LEAVES { _Lhs::LEAVES + _Rhs::LEAVES };
+
+      binary_node(const _Lhs &lhs, const _Rhs &rhs) : m_lhs { lhs }, m_rhs { rhs } { }
+
+      dimension dim() const
+      {
+        if constexpr (_Lhs::is_scalar)
+          return m_rhs.dim();
+        else if constexpr (_Rhs::is_scalar)
+          return m_lhs.dim();
+        else
+          return broadcast(m_lhs.dim(), m_rhs.dim());
+      }
+
+      struct state {
+        template<typename _Context>
+        state(const binary_node &node, _Context &ctx)
+          : lhs { node.m_lhs, ctx }, rhs { node.m_rhs, ctx },
+            kernel { find_kernel<dtype, dtype>(_Op) }
+        { }
+
+        typename _Lhs::state lhs;
+        typename _Rhs::state rhs;
+        binary_kernel<native_type, native_type> kernel;
+        alignas(64) native_type buffer[BLOCK];
+      };
+
+      static void eval_into(state &s, const size_t start, const size_t count,
+        native_type *out, const ptrdiff_t so) noexcept
+      {
+        const auto a { _Lhs::compute(s.lhs, start, count) };
+        const auto b { _Rhs::compute(s.rhs, start, count) };
+        s.kernel(a.data, a.stride, b.data, b.stride, out, so, count);
+      }
+
+      _Lhs m_lhs;
+      _Rhs m_rhs;
+    };
+
+    template<unary_op _Op, typename _Arg>
+    struct unary_node : node<unary_node<_Op, _Arg>> {
+      using dtype       = typename _Arg::dtype;
+      using native_type = typename multiarray<dtype>::native_type;
+
+      static constexpr bool is_scalar { _Arg::is_scalar };
+      static constexpr size_t LEAVES { _Arg::LEAVES };
+
+      explicit unary_node(const _Arg &arg) : m_arg { arg } { }
+
+      dimension dim() const { return m_arg.dim(); }
+
+      struct state {
+        template<typename _Context>
+        state(const unary_node &node, _Context &ctx)
+          : arg { node.m_arg, ctx }, kernel { find_kernel<dtype>(_Op) }
+        { }
+
+        typename _Arg::state arg;
+        unary_kernel<native_type> kernel;
+        alignas(64) native_type buffer[BLOCK];
+      };
+
+      static void eval_into(state &s, const size_t start, const size_t count,
+        native_type *out, const ptrdiff_t so) noexcept
+      {
+        const auto a { _Arg::compute(s.arg, start, count) };
+        s.kernel(a.data, a.stride, out, so, count);
+      }
+
+      _Arg m_arg;
+    };
+
+    template<typename _Arg>
+    struct clamp_node : node<clamp_node<_Arg>> {
+      using dtype       = typename _Arg::dtype;
+      using native_type = typename multiarray<dtype>::native_type;
+
+      static constexpr bool is_scalar { _Arg::is_scalar };
+      static constexpr size_t LEAVES { _Arg::LEAVES };
+
+      clamp_node(const _Arg &arg, const native_type lo, const native_type hi)
+        : m_arg { arg }, m_lo { lo }, m_hi { hi }
+      { }
+
+      dimension dim() const { return m_arg.dim(); }
+
+      struct state {
+        template<typename _Context>
+        state(const clamp_node &node, _Context &ctx)
+          : arg { node.m_arg, ctx }, lo { node.m_lo }, hi { node.m_hi },
+            kernel { find_clamp_kernel<dtype>() }
+        { }
+
+        typename _Arg::state arg;
+        native_type lo, hi;
+        clamp_kernel<native_type> kernel;
+        alignas(64) native_type buffer[BLOCK];
+      };
+
+      static void eval_into(state &s, const size_t start, const size_t count,
+        native_type *out, const ptrdiff_t so) noexcept
+      {
+        const auto a { _Arg::compute(s.arg, start, count) };
+        s.kernel(a.data, a.stride, s.lo, s.hi, out, so, count);
+      }
+
+      _Arg m_arg;
+      native_type m_lo, m_hi;
+    };
+
+    // conversion of every element to another datatype, through the astype kernels
+    template<typename _DType, typename _Arg>
+    struct cast_node : node<cast_node<_DType, _Arg>> {
+      using dtype       = _DType;
+      using native_type = typename multiarray<dtype>::native_type;
+      using from_type   = typename _Arg::native_type;
+
+      static constexpr bool is_scalar { _Arg::is_scalar };
+      static constexpr size_t LEAVES { _Arg::LEAVES };
+
+      cast_node(const _Arg &arg, const conversion &conv) : m_arg { arg }, m_conv { conv } { }
+
+      dimension dim() const { return m_arg.dim(); }
+
+      struct state {
+        template<typename _Context>
+        state(const cast_node &node, _Context &ctx)
+          : arg { node.m_arg, ctx },
+            kernel { find_convert_kernel<typename _Arg::dtype>(_DType::s_type) },
+            conv { node.m_conv }
+        { }
+
+        typename _Arg::state arg;
+        convert_kernel<from_type> kernel;
+        conversion conv;
+        alignas(64) native_type buffer[BLOCK];
+      };
+
+      static void eval_into(state &s, const size_t start, const size_t count,
+        native_type *out, const ptrdiff_t so) noexcept
+      {
+        const auto a { _Arg::compute(s.arg, start, count) };
+        s.kernel(a.data, a.stride, out, so, count, s.conv);
+      }
+
+      _Arg m_arg;
+      conversion m_conv;
+    };
+
+    ///////////////////////////////////// EVALUATION /////////////////////////////////////
+
+    // merged shape of the runs, in which adjacent axes are merged wherever every slot is
+    // contiguous across them, the innermost axis being that of the runs
+    struct runs {
+      std::array<size_t, 6> extent;
+      int ndims;
+
+      size_t length() const noexcept { return extent[ndims - 1]; }
+    };
+
+    template<size_t N>
+    runs merge_runs(const dimension &dim, std::array<slot, N> &slots) noexcept
+    {
+      int ndims { dim.ndims() };
+      std::array<size_t, 6> extent {};
+      for (int i { -1 }; ++i < ndims;) extent[i] = dim[i];
+      if (ndims == 0) extent[0] = 1, ndims = 1;
+
+      for (int i { ndims - 1 }; i-- > 0;) {
+        bool mergeable { true };
+        for (const auto &s : slots)
+          mergeable &= s.steps[i] == s.steps[i + 1] * ptrdiff_t(extent[i + 1]);
+        if (!mergeable) continue;
+        extent[i] *= extent[i + 1];
+        for (auto &s : slots) s.steps[i] = s.steps[i + 1];
+        for (int j { i + 1 }; j + 1 < ndims; ++j) {
+          extent[j] = extent[j + 1];
+          for (auto &s : slots) s.steps[j] = s.steps[j + 1];
+        }
+        --ndims;
+      }
+
+      for (auto &s : slots) s.inner = s.steps[ndims - 1] / ptrdiff_t(s.size);
+      return { extent, ndims };
+    }
+
+    // walks the elements [begin, end) of the merged shape in row-major order, calling
+    // `func(offset, count)` for every part of a run after pointing all slot cursors at
+    // the start of that run
+    template<size_t N, typename _Func>
+    void walk_runs(const runs &shape, std::array<slot, N> &slots, size_t begin,
+      const size_t end, _Func &&func)
+    {
+      const int inner { shape.ndims - 1 };
+      const size_t length { shape.length() };
+
+      std::array<size_t, 6> counter {};
+      size_t run { begin / length };
+      for (auto &s : slots) s.cursor = s.data;
+      for (int axis { inner }; axis-- > 0;) {
+        counter[axis] = run % shape.extent[axis];
+        run /= shape.extent[axis];
+        for (auto &s : slots) s.cursor += s.steps[axis] * ptrdiff_t(counter[axis]);
+      }
+
+      for (size_t offset { begin % length }; begin < end; offset = 0) {
+        const size_t count { std::min(length - offset, end - begin) };
+        func(offset, count);
+        if ((begin += count) == end) return;
+
+        int axis { inner };
+        while (--axis >= 0) {
+          if (++counter[axis] < shape.extent[axis]) {
+            for (auto &s : slots) s.cursor += s.steps[axis];
+            break;
+          }
+          for (auto &s : slots)
+            s.cursor -= s.steps[axis] * ptrdiff_t(shape.extent[axis] - 1);
+          counter[axis] = 0;
+        }
+      }
+    }
+
+    // ranges of about grain_size() bytes of all operands are evaluated on the default
+    // executor, each with its own slots and node buffers, small outputs run inline
+    template<typename _Node, typename _RType>
+    void evaluate(const _Node &root, multiarray<_RType> &out)
+    {
+      static_assert(std::is_same_v<typename _Node::dtype, _RType>,
+        "expression and output datatypes differ, cast the expression first\n");
+      using native_type = typename multiarray<_RType>::native_type;
+      using slots_type  = std::array<slot, _Node::LEAVES + 1>;
+
+      if (out.size() == 0) return;
+
+      slots_type slots {};
+      context<_RType> ctx { out, slots.data() };
+      ctx.bind(out);
+      typename _Node::state state { root, ctx };
+      const runs shape { merge_runs(out.dim(), slots) };
+
+      const auto range = [&shape](typename _Node::state &s, slots_type &local,
+                           const size_t begin, const size_t end) {
+        const slot &target { local[0] };
+        walk_runs(shape, local, begin, end, [&s, &target](size_t offset, size_t count) {
+          auto *dst { reinterpret_cast<native_type *>(target.cursor) };
+          for (const size_t stop { offset + count }; offset < stop; offset += BLOCK)
+            _Node::eval_into(s, offset, std::min(BLOCK, stop - offset),
+              dst + ptrdiff_t(offset) * target.inner, target.inner);
+        });
+      };
+
+      size_t bytes { 0 };
+      for (const auto &s : slots) bytes += s.size;
+      const size_t grain { std::max<size_t>(grain_size() / bytes, BLOCK) };
+      const size_t count { out.size() };
+      if (count <= grain) return range(state, slots, 0, count);
+
+      default_executor().parallel_for(count, grain, [&](size_t begin, size_t end) {
+        slots_type local { slots };
+        rebind_context rebound { local.data() + 1 };
+        typename _Node::state s { root, rebound };
+        range(s, local, begin, end);
+      });
+    }
+
+    ////////////////////////////////////// BUILDING //////////////////////////////////////
+
+    template<typename _Type>
+    struct is_array : std::false_type { };
+
+    template<typename _DType>
+    struct is_array<multiarray<_DType>> : std::true_type { };
+
+    template<typename _Type>
+    static constexpr bool is_expression_v { std::is_base_of_v<expression<_Type>, _Type> };
+
+    template<typename _Type>
+    static constexpr bool is_operand_v { is_array<_Type>::value || is_expression_v<_Type> };
+
+    // pairs of operands for which an expression node is built
+    template<typename _Lhs, typename _Rhs>
+    static constexpr bool is_operand_pair_v {
+      (is_operand_v<_Lhs> && (is_operand_v<_Rhs> || std::is_arithmetic_v<_Rhs>))
+      || (std::is_arithmetic_v<_Lhs> && is_operand_v<_Rhs>)
+    };
+
+    // pairs which are only evaluated lazily when one side is already an expression
+    template<typename _Lhs, typename _Rhs>
+    static constexpr bool is_lazy_pair_v {
+      is_operand_pair_v<_Lhs, _Rhs> && (is_expression_v<_Lhs> || is_expression_v<_Rhs>)
+    };
+
+    template<typename _DType>
+    leaf<_DType> as_node(const multiarray<_DType> &array)
+    {
+      return leaf<_DType> { array };
+    }
+
+    template<typename _Node>
+    const _Node &as_node(const expression<_Node> &expr) noexcept
+    {
+      return expr.self();
+    }
+
+    template<typename _Type>
+    using node_t = std::decay_t<decltype(as_node(std::declval<const _Type &>()))>;
+
+    // scalars take the datatype of the other operand
+    template<binary_op _Op, typename _Lhs, typename _Rhs>
+    auto make_binary(const _Lhs &a, const _Rhs &b)
+    {
+      if constexpr (std::is_arithmetic_v<_Lhs>) {
+        using dtype = typename node_t<_Rhs>::dtype;
+        using value = typename multiarray<dtype>::native_type;
+        return binary_node<_Op, scalar_leaf<dtype>, node_t<_Rhs>> {
+          scalar_leaf<dtype> { static_cast<value>(a) }, as_node(b)
+        };
+      } else if constexpr (std::is_arithmetic_v<_Rhs>) {
+        using dtype = typename node_t<_Lhs>::dtype;
+        using value = typename multiarray<dtype>::native_type;
+        return binary_node<_Op, node_t<_Lhs>, scalar_leaf<dtype>> {
+          as_node(a), scalar_leaf<dtype> { static_cast<value>(b) }
+        };
+      } else
+        return binary_node<_Op, node_t<_Lhs>, node_t<_Rhs>> { as_node(a), as_node(b) };
+    }
+
+  }  // namespace detail
+
+  ///////////////////////////////////////// EVALUATION ///////////////////////////////////////
+
+  template<typename _Derived>
+  auto expression<_Derived>::eval() const
+  {
+    multiarray<typename _Derived::dtype> out { self().dim(), uninitialized };
+    detail::evaluate(self(), out);
+    return out;
+  }
+
+  template<typename _Derived>
+  template<typename _DType>
+  multiarray<_DType> &expression<_Derived>::eval(multiarray<_DType> &out) const
+  {
+    detail::evaluate(self(), out);
+    return out;
+  }
+
+  template<typename _DType>
+  template<typename _Derived>
+  multiarray<_DType>::multiarray(const expression<_Derived> &expr)
+    : multiarray { expr.self().dim(), uninitialized }
+  {
+    detail::evaluate(expr.self(), *this);
+  }
+
+  ////////////////////////////////////////// OPERATORS ////////////////////////////////////////
+
+// lazy arithmetic operator, compound assignments evaluate into the left operand's buffer
+#define EXPRESSION_OPERATOR(symbol, label)                                               \
+ template<typename _Lhs, typename _Rhs,                                                \
+   typename = std::enable_if_t<detail::is_operand_pair_v<_Lhs, _Rhs>>>                  \
+ auto operator symbol(const _Lhs &a, const _Rhs &b)                                      \
+ {                                                                                     \
+  return detail::make_binary<detail::binary_op::label>(a, b);                           \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType, typename _Rhs,                                              \
+   typename = std::enable_if_t<detail::is_operand_pair_v<multiarray<_DType>, _Rhs>>>     \
+ multiarray<_DType> &operator symbol##=(multiarray<_DType> &a, const _Rhs &b)           \
+ {                                                                                     \
+  return (a symbol b).eval(a);                                                         \
+ }
+
+  EXPRESSION_OPERATOR(+, add)
+  EXPRESSION_OPERATOR(-, subtract)
+  EXPRESSION_OPERATOR(*, multiply)
+  EXPRESSION_OPERATOR(/, divide)
+
+#undef EXPRESSION_OPERATOR
+
+  template<typename _Arg, typename = std::enable_if_t<detail::is_operand_v<_Arg>>>
+  auto operator-(const _Arg &a)
+  {
+    using node_type = detail::node_t<_Arg>;
+    return detail::unary_node<detail::unary_op::negative, node_type> { detail::as_node(a) };
+  }
+
+  /////////////////////////////////////// LAZY FUNCTIONS //////////////////////////////////////
+
+  // the named functions of arithmetic.hh, building nodes when an argument is an expression
+
+  template<typename _Lhs, typename _Rhs,
+    typename = std::enable_if_t<detail::is_lazy_pair_v<_Lhs, _Rhs>>>
+  auto minimum(const _Lhs &a, const _Rhs &b)
+  {
+    return detail::make_binary<detail::binary_op::minimum>(a, b);
+  }
+
+  template<typename _Lhs, typename _Rhs,
+    typename = std::enable_if_t<detail::is_lazy_pair_v<_Lhs, _Rhs>>>
+  auto maximum(const _Lhs &a, const _Rhs &b)
+  {
+    return detail::make_binary<detail::binary_op::maximum>(a, b);
+  }
+
+#define LAZY_UNARY_FUNCTION(name)                                                       \
+ template<typename _Node>                                                              \
+ auto name(const expression<_Node> &a)                                                 \
+ {                                                                                     \
+  return detail::unary_node<detail::unary_op::name, _Node> { a.self() };               \
+ }
+
+  LAZY_UNARY_FUNCTION(abs)
+  LAZY_UNARY_FUNCTION(negative)
+  LAZY_UNARY_FUNCTION(sqrt)
+  LAZY_UNARY_FUNCTION(exp)
+  LAZY_UNARY_FUNCTION(log)
+
+#undef LAZY_UNARY_FUNCTION
+
+  template<typename _Node>
+  auto clamp(const expression<_Node> &a, const typename _Node::native_type lo,
+    const typename _Node::native_type hi)
+  {
+    return detail::clamp_node<_Node> { a.self(), lo, hi };
+  }
+
+  // lazy conversion of an array or expression to another datatype, see astype
+  template<typename _DType, typename _Arg,
+    typename = std::enable_if_t<detail::is_operand_v<_Arg>>>
+  auto cast(const _Arg &a, const conversion &conv = {})
+  {
+    return detail::cast_node<_DType, detail::node_t<_Arg>> { detail::as_node(a), conv };
+  }
+
+}  // namespace covdel::ma
+
+#endif
@@ -47,6 +47,26 @@ namespace covdel::ma
     return _MultiArray(std::forward<_Args>(args)...);
   }
 
+  // array with unset elements, for outputs which are fully overwritten
+  template<typename _MultiArray>
+  _MultiArray empty(const dimension &dim, allocator &alloc = default_allocator())
+  {
+    return _MultiArray(dim, uninitialized, alloc);
+  }
+
+  template<typename _MultiArray>
+  _MultiArray zeros(const dimension &dim, allocator &alloc = default_allocator())
+  {
+    return _MultiArray(dim, alloc);
+  }
+
+  template<typename _MultiArray>
+  _MultiArray full(const dimension &dim, const typename _MultiArray::native_type value,
+    allocator &alloc = default_allocator())
+  {
+    return _MultiArray(dim, value, alloc);
+  }
+
 }  // namespace covdel::ma
 
 #endif
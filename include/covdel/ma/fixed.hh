@@ -0,0 +1,440 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_FIXED_HH_1703178411__
+#define __COVDEL_INCLUDE_COVDEL_MA_FIXED_HH_1703178411__
+
+#include "multiarray.hh"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace covdel::ma
+{
+  // shape of a rank known at compile time, so that loops over its axes unroll, converting
+  // to and from the dynamic dimension, the latter throwing on a rank mismatch
+  template<int _Rank>
+  class fixed_dimension {  // 8B per axis
+    static_assert(_Rank > 0 && _Rank <= 6, "rank must be between 1 and 6\n");
+
+  public:
+    constexpr fixed_dimension() noexcept : m_data {} { }
+    template<typename... _Args,
+      typename = std::enable_if_t<sizeof...(_Args) == _Rank
+                                  && (std::is_integral_v<_Args> && ...)>>
+    constexpr fixed_dimension(const _Args... args) noexcept
+      : m_data { static_cast<size_t>(args)... }
+    { }
+    explicit fixed_dimension(const dimension &dim);
+
+    // operators
+    constexpr size_t operator[](const int idx) const noexcept { return m_data[idx]; }
+    constexpr bool operator==(const fixed_dimension &rhs) const noexcept;
+    constexpr bool operator!=(const fixed_dimension &rhs) const noexcept;
+    operator dimension() const noexcept;
+
+    // general
+    static constexpr int ndims() noexcept { return _Rank; }
+    constexpr size_t size() const noexcept;
+    // row-major strides of a contiguous array of this shape
+    constexpr std::array<ptrdiff_t, _Rank> strides() const noexcept;
+
+  private:
+    std::array<size_t, _Rank> m_data;
+
+    template<size_t... I>
+    dimension expand(std::index_sequence<I...>) const noexcept;
+  };
+
+  // shape whose extents are template arguments, such as static_dimension<480, 640, 3>,
+  // of contiguous row-major arrays whose element offsets fold into constants
+  template<size_t... _Extents>
+  struct static_dimension {
+    static_assert(sizeof...(_Extents) > 0 && sizeof...(_Extents) <= 6,
+      "rank must be between 1 and 6\n");
+
+    static constexpr int ndims { int(sizeof...(_Extents)) };
+    static constexpr size_t size { (_Extents * ...) };
+    static constexpr fixed_dimension<ndims> extents { _Extents... };
+    static constexpr std::array<ptrdiff_t, ndims> strides { extents.strides() };
+
+    // unchecked offset of an element, bounds are only asserted in debug builds
+    template<typename... _Args>
+    static constexpr ptrdiff_t offset(const _Args... args) noexcept;
+
+    static dimension dim() noexcept { return dimension(_Extents...); }
+  };
+
+  // multiarray of a rank known at compile time, a view sharing the buffer of the dynamic
+  // array it is made from or converts back to, neither of which copies elements. Offsets
+  // are computed without loops over the axes, and for_each runs a loop nest unrolled over
+  // them, with the innermost loop over a pointer step.
+  template<typename _DType, int _Rank>
+  class fixed_multiarray {
+  public:
+    using native_type = typename multiarray<_DType>::native_type;
+    using dimension_type = fixed_dimension<_Rank>;
+    using stride_type    = std::array<ptrdiff_t, _Rank>;
+
+    // constructors
+    explicit fixed_multiarray(const dimension_type &dim,
+      allocator &alloc = default_allocator());
+    fixed_multiarray(const dimension_type &dim, const native_type fill,
+      allocator &alloc = default_allocator());
+    fixed_multiarray(const dimension_type &dim, uninitialized_t,
+      allocator &alloc = default_allocator());
+    // view of a dynamic array, throws std::invalid_argument on a rank mismatch
+    explicit fixed_multiarray(const multiarray<_DType> &array);
+
+    // operators
+    template<typename... _Args>
+    native_type &operator()(const _Args... args) noexcept;
+    template<typename... _Args>
+    const native_type &operator()(const _Args... args) const noexcept;
+    operator const multiarray<_DType> &() const noexcept { return m_array; }
+
+    // getters
+    const dimension_type &dim() const noexcept { return m_dim; }
+    const stride_type &strides() const noexcept { return m_stride; }
+    native_type *data() noexcept { return p_data; }
+    const native_type *data() const noexcept { return p_data; }
+    static constexpr int ndims() noexcept { return _Rank; }
+    size_t size() const noexcept { return m_dim.size(); }
+    bool is_contiguous() const noexcept { return m_stride == m_dim.strides(); }
+
+    // dynamic view of the same elements, copied so that reshaping or transposing it
+    // leaves the cached geometry of this view intact
+    const multiarray<_DType> &dynamic() const noexcept { return m_array; }
+    multiarray<_DType> view() const { return m_array; }
+
+    // calls `func(element)` on every element in row-major order, or `func(element,
+    // i0, i1, ...)` with its position for for_each_indexed
+    template<typename _Func>
+    void for_each(_Func &&func);
+    template<typename _Func>
+    void for_each(_Func &&func) const;
+    template<typename _Func>
+    void for_each_indexed(_Func &&func);
+    template<typename _Func>
+    void for_each_indexed(_Func &&func) const;
+
+    void fill(const native_type value);
+
+  private:
+    multiarray<_DType> m_array;  // keeps the buffer alive
+    native_type *p_data;
+    dimension_type m_dim;
+    stride_type m_stride;
+
+    template<typename... _Args>
+    ptrdiff_t offset(const _Args... args) const noexcept;
+
+    template<int _Axis, typename _Type, typename _Func, typename... _Idx>
+    static void nest(_Type *data, const dimension_type &dim, const stride_type &strides,
+      _Func &func, const _Idx... idx);
+  };
+
+  // contiguous multiarray of extents known at compile time, a view of a dynamic array of
+  // the same shape, or of a new one, whose element offsets are constants
+  template<typename _DType, size_t... _Extents>
+  class static_multiarray {
+  public:
+    using native_type = typename multiarray<_DType>::native_type;
+    using dimension_type = static_dimension<_Extents...>;
+
+    // constructors
+    explicit static_multiarray(allocator &alloc = default_allocator());
+    static_multiarray(const native_type fill, allocator &alloc = default_allocator());
+    // view of a dynamic array, throws std::invalid_argument unless it has this shape
+    // and is contiguous
+    explicit static_multiarray(const multiarray<_DType> &array);
+
+    // operators
+    template<typename... _Args>
+    native_type &operator()(const _Args... args) noexcept;
+    template<typename... _Args>
+    const native_type &operator()(const _Args... args) const noexcept;
+    operator const multiarray<_DType> &() const noexcept { return m_array; }
+    operator fixed_multiarray<_DType, dimension_type::ndims>() const;
+
+    // getters
+    static constexpr fixed_dimension<dimension_type::ndims> dim() noexcept
+    {
+      return dimension_type::extents;
+    }
+    native_type *data() noexcept { return p_data; }
+    const native_type *data() const noexcept { return p_data; }
+    static constexpr int ndims() noexcept { return dimension_type::ndims; }
+    static constexpr size_t size() noexcept { return dimension_type::size; }
+
+    const multiarray<_DType> &dynamic() const noexcept { return m_array; }
+    multiarray<_DType> view() const { return m_array; }
+
+  private:
+    multiarray<_DType> m_array;  // keeps the buffer alive
+    native_type *p_data;
+  };
+
+  // in-header definitions
+
+  template<int _Rank>
+  fixed_dimension<_Rank>::fixed_dimension(const dimension &dim) : m_data {}
+  {
+    if (dim.ndims() != _Rank)
+      throw std::invalid_argument { "dimension does not have the fixed rank" };
+    for (int i { 0 }; i < _Rank; ++i) m_data[i] = dim[i];
+  }
+
+  template<int _Rank>
+  constexpr bool fixed_dimension<_Rank>::operator==(
+    const fixed_dimension &rhs) const noexcept
+  {
+    for (int i { 0 }; i < _Rank; ++i)
+      if (m_data[i] != rhs.m_data[i]) return false;
+    return true;
+  }
+
+  template<int _Rank>
+  constexpr bool fixed_dimension<_Rank>::operator!=(
+    const fixed_dimension &rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+  template<int _Rank>
+  fixed_dimension<_Rank>::operator dimension() const noexcept
+  {
+    return expand(std::make_index_sequence<_Rank> {});
+  }
+
+  template<int _Rank>
+  template<size_t... I>
+  dimension fixed_dimension<_Rank>::expand(std::index_sequence<I...>) const noexcept
+  {
+    return dimension(m_data[I]...);
+  }
+
+  template<int _Rank>
+  constexpr size_t fixed_dimension<_Rank>::size() const noexcept
+  {
+    size_t size { 1 };
+    for (int i { 0 }; i < _Rank; ++i) size *= m_data[i];
+    return size;
+  }
+
+  template<int _Rank>
+  constexpr std::array<ptrdiff_t, _Rank> fixed_dimension<_Rank>::strides() const noexcept
+  {
+    std::array<ptrdiff_t, _Rank> out {};
+    ptrdiff_t step { 1 };
+    for (int i { _Rank }; i-- > 0;) {
+      out[i] = step;
+      step *= ptrdiff_t(m_data[i]);
+    }
+    return out;
+  }
+
+  template<size_t... _Extents>
+  template<typename... _Args>
+  constexpr ptrdiff_t static_dimension<_Extents...>::offset(const _Args... args) noexcept
+  {
+    static_assert(sizeof...(args) == ndims, "index rank mismatch\n");
+    static_assert((std::is_integral_v<_Args> && ...), "indices must be integral\n");
+    ptrdiff_t offset { 0 };
+    int axis { 0 };
+    ((assert(size_t(args) < extents[axis] && "index out of bounds"),
+       offset += ptrdiff_t(args) * strides[axis++]),
+      ...);
+    return offset;
+  }
+
+  ////////////////////////////////// FIXED MULTIARRAY ///////////////////////////////////
+
+  template<typename _DType, int _Rank>
+  fixed_multiarray<_DType, _Rank>::fixed_multiarray(
+    const dimension_type &dim, allocator &alloc)
+    : fixed_multiarray { multiarray<_DType> { dimension(dim), alloc } }
+  { }
+
+  template<typename _DType, int _Rank>
+  fixed_multiarray<_DType, _Rank>::fixed_multiarray(
+    const dimension_type &dim, const native_type fill, allocator &alloc)
+    : fixed_multiarray { multiarray<_DType> { dimension(dim), fill, alloc } }
+  { }
+
+  template<typename _DType, int _Rank>
+  fixed_multiarray<_DType, _Rank>::fixed_multiarray(
+    const dimension_type &dim, uninitialized_t, allocator &alloc)
+    : fixed_multiarray { multiarray<_DType> { dimension(dim), uninitialized, alloc } }
+  { }
+
+  template<typename _DType, int _Rank>
+  fixed_multiarray<_DType, _Rank>::fixed_multiarray(const multiarray<_DType> &array)
+    : m_array { array }, p_data { m_array.data() }, m_dim { array.dim() }, m_stride {}
+  {
+    for (int i { 0 }; i < _Rank; ++i) m_stride[i] = array.strides()[i];
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename... _Args>
+  inline ptrdiff_t fixed_multiarray<_DType, _Rank>::offset(
+    const _Args... args) const noexcept
+  {
+    static_assert(sizeof...(args) == _Rank, "index rank mismatch\n");
+    static_assert((std::is_integral_v<_Args> && ...), "indices must be integral\n");
+    ptrdiff_t offset { 0 };
+    int axis { 0 };
+    ((assert(size_t(args) < m_dim[axis] && "index out of bounds"),
+       offset += ptrdiff_t(args) * m_stride[axis++]),
+      ...);
+    return offset;
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename... _Args>
+  inline typename fixed_multiarray<_DType, _Rank>::native_type &
+  fixed_multiarray<_DType, _Rank>::operator()(const _Args... args) noexcept
+  {
+    return p_data[offset(args...)];
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename... _Args>
+  inline const typename fixed_multiarray<_DType, _Rank>::native_type &
+  fixed_multiarray<_DType, _Rank>::operator()(const _Args... args) const noexcept
+  {
+    return p_data[offset(args...)];
+  }
+
+  // one loop per axis, instantiated axis by axis so that the nest is fully known to the
+  // compiler, the positions of outer axes passed down as arguments
+  template<typename _DType, int _Rank>
+  template<int _Axis, typename _Type, typename _Func, typename... _Idx>
+  inline void fixed_multiarray<_DType, _Rank>::nest(_Type *data,
+    const dimension_type &dim, const stride_type &strides, _Func &func, const _Idx... idx)
+  {
+    const size_t extent { dim[_Axis] };
+    const ptrdiff_t step { strides[_Axis] };
+    if constexpr (_Axis + 1 == _Rank)
+      for (size_t i { 0 }; i < extent; ++i) func(data[ptrdiff_t(i) * step], idx..., i);
+    else
+      for (size_t i { 0 }; i < extent; ++i)
+        nest<_Axis + 1>(data + ptrdiff_t(i) * step, dim, strides, func, idx..., i);
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename _Func>
+  void fixed_multiarray<_DType, _Rank>::for_each(_Func &&func)
+  {
+    auto element = [&func](native_type &value, auto...) { func(value); };
+    if (is_contiguous()) {
+      const size_t count { size() };
+      for (size_t i { 0 }; i < count; ++i) func(p_data[i]);
+    } else
+      nest<0>(p_data, m_dim, m_stride, element);
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename _Func>
+  void fixed_multiarray<_DType, _Rank>::for_each(_Func &&func) const
+  {
+    auto element = [&func](const native_type &value, auto...) { func(value); };
+    if (is_contiguous()) {
+      const size_t count { size() };
+      const native_type *data { p_data };
+      for (size_t i { 0 }; i < count; ++i) func(data[i]);
+    } else
+      nest<0>(static_cast<const native_type *>(p_data), m_dim, m_stride, element);
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename _Func>
+  void fixed_multiarray<_DType, _Rank>::for_each_indexed(_Func &&func)
+  {
+    nest<0>(p_data, m_dim, m_stride, func);
+  }
+
+  template<typename _DType, int _Rank>
+  template<typename _Func>
+  void fixed_multiarray<_DType, _Rank>::for_each_indexed(_Func &&func) const
+  {
+    nest<0>(static_cast<const native_type *>(p_data), m_dim, m_stride, func);
+  }
+
+  template<typename _DType, int _Rank>
+  void fixed_multiarray<_DType, _Rank>::fill(const native_type value)
+  {
+    for_each([value](native_type &element) { element = value; });
+  }
+
+  ////////////////////////////////// STATIC MULTIARRAY //////////////////////////////////
+
+  template<typename _DType, size_t... _Extents>
+  static_multiarray<_DType, _Extents...>::static_multiarray(allocator &alloc)
+    : m_array { dimension_type::dim(), alloc }, p_data { m_array.data() }
+  { }
+
+  template<typename _DType, size_t... _Extents>
+  static_multiarray<_DType, _Extents...>::static_multiarray(
+    const native_type fill, allocator &alloc)
+    : m_array { dimension_type::dim(), fill, alloc }, p_data { m_array.data() }
+  { }
+
+  template<typename _DType, size_t... _Extents>
+  static_multiarray<_DType, _Extents...>::static_multiarray(
+    const multiarray<_DType> &array)
+    : m_array { array }, p_data { m_array.data() }
+  {
+    if (array.dim() != dimension_type::dim())
+      throw std::invalid_argument { "array does not have the static shape" };
+    if (!array.is_contiguous())
+      throw std::invalid_argument { "static arrays must be contiguous" };
+  }
+
+  template<typename _DType, size_t... _Extents>
+  template<typename... _Args>
+  inline typename static_multiarray<_DType, _Extents...>::native_type &
+  static_multiarray<_DType, _Extents...>::operator()(const _Args... args) noexcept
+  {
+    return p_data[dimension_type::offset(args...)];
+  }
+
+  template<typename _DType, size_t... _Extents>
+  template<typename... _Args>
+  inline const typename static_multiarray<_DType, _Extents...>::native_type &
+  static_multiarray<_DType, _Extents...>::operator()(const _Args... args) const noexcept
+  {
+    return p_data[dimension_type::offset(args...)];
+  }
+
+  template<typename _DType, size_t... _Extents>
+  static_multiarray<_DType, _Extents...>::operator fixed_multiarray<_DType,
+    dimension_type::ndims>() const
+  {
+    return fixed_multiarray<_DType, dimension_type::ndims> { m_array };
+  }
+
+  static_assert(std::is_trivially_copyable_v<fixed_dimension<3>>,
+    "'fixed_dimension' must stay trivial\n");
+
+}  // namespace covdel::ma
+
+#endif
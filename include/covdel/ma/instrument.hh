@@ -0,0 +1,146 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_INSTRUMENT_HH_1703348215__
+#define __COVDEL_INCLUDE_COVDEL_MA_INSTRUMENT_HH_1703348215__
+
+#include "datatype.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace covdel::ma
+{
+  // operations of arrays counted and timed by the instrumentation
+  enum class operation {
+    allocate,
+    copy,
+    convert,
+    fill,
+    compare,
+    elementwise,
+    reduce,
+    matmul
+  };
+
+  constexpr std::size_t OPERATIONS { 8 };
+  constexpr std::size_t DATATYPES { 11 };
+  // latency buckets, bucket i counting calls of [2^i, 2^(i+1)) nanoseconds, the first
+  // including instant calls and the last any longer one
+  constexpr std::size_t LATENCY_BUCKETS { 32 };
+
+  std::string str(const operation op);
+
+  // calls of an operation and their latencies
+  struct operation_stats {
+    std::uint64_t calls;
+    std::uint64_t nanoseconds;  // total over all calls
+    std::array<std::uint64_t, LATENCY_BUCKETS> histogram;
+
+    // upper bound in nanoseconds of the latency of a `fraction` of the calls, as 0.99
+    double percentile(const double fraction) const noexcept;
+  };
+
+  // bytes of the arrays of a datatype
+  struct datatype_bytes {
+    std::uint64_t allocated;  // new buffers
+    std::uint64_t copied;     // written by copies
+    std::uint64_t converted;  // written by conversions into this datatype
+  };
+
+  // totals of all threads since the last reset_instrumentation
+  struct instrument_snapshot {
+    std::array<operation_stats, OPERATIONS> operations;
+    std::array<datatype_bytes, DATATYPES> datatypes;
+    std::size_t live_bytes;  // of buffers allocated and not yet released
+    std::size_t peak_bytes;  // most live bytes at once since the last reset
+
+    const operation_stats &operator[](const operation op) const noexcept;
+    const datatype_bytes &operator[](const datatype type) const noexcept;
+  };
+
+  // whether the library records anything, which takes building it with COVDEL_INSTRUMENT,
+  // without which the probes compile to nothing and snapshots stay empty
+  constexpr bool instrumented() noexcept;
+
+  // counters are kept per thread, so that probes never contend, and are merged here
+  instrument_snapshot snapshot();
+
+  // restarts the counters from zero and the peak from the live bytes
+  void reset_instrumentation();
+
+  // records a timeline of every probed call on every thread, until stop_trace, each trace
+  // restarting from an empty one
+  void start_trace();
+  void stop_trace() noexcept;
+  bool tracing() noexcept;
+
+  // the recorded timeline in the trace event format of chrome://tracing and Perfetto, a
+  // complete event per call with the datatype and bytes, and a counter of the live bytes
+  void write_chrome_trace(std::ostream &out);
+
+  namespace detail
+  {
+    // times the scope of an operation on arrays of `type`, accounting `bytes` as
+    // allocated, copied or converted by it, calls left by an exception are not recorded
+    class probe {
+    public:
+      probe(const operation op, const datatype type, const std::size_t bytes) noexcept;
+      probe(const probe &) = delete;
+      probe &operator=(const probe &) = delete;
+      ~probe() noexcept;
+
+    private:
+      operation m_op;
+      datatype m_type;
+      std::size_t m_bytes;
+      std::int64_t m_start;
+      int m_exceptions;
+    };
+
+    // buffers released by the last of their views
+    void record_release(const std::size_t bytes) noexcept;
+
+  }  // namespace detail
+
+  // in-header definitions
+
+  constexpr bool instrumented() noexcept
+  {
+#ifdef COVDEL_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+  }
+
+}  // namespace covdel::ma
+
+// probes of the library sources, removed from builds without COVDEL_INSTRUMENT
+#ifdef COVDEL_INSTRUMENT
+#define COVDEL_PROBE(op, type, bytes) \
+ const ::covdel::ma::detail::probe covdel_probe_ { op, type, bytes }
+#define COVDEL_PROBE_RELEASE(bytes) ::covdel::ma::detail::record_release(bytes)
+#else
+#define COVDEL_PROBE(op, type, bytes) static_cast<void>(0)
+#define COVDEL_PROBE_RELEASE(bytes) static_cast<void>(0)
+#endif
+
+#endif
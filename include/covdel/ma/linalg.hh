@@ -0,0 +1,99 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_LINALG_HH_1701870188__
+#define __COVDEL_INCLUDE_COVDEL_MA_LINALG_HH_1701870188__
+
+#include "multiarray.hh"
+
+#include <stdexcept>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    // shape of the product of `a` and `b`, see matmul
+    dimension matmul_shape(const dimension &a, const dimension &b);
+
+    // c = alpha * op(a) op(b) + beta * c, where op swaps the last two axes of operands
+    // marked transposed, vectors are rows of a and columns of b, and leading axes
+    // broadcast against those of c
+    template<typename _DType>
+    void gemm(const multiarray<_DType> &a, const bool transpose_a,
+      const multiarray<_DType> &b, const bool transpose_b,
+      const typename multiarray<_DType>::native_type alpha,
+      const typename multiarray<_DType>::native_type beta, multiarray<_DType> &c);
+
+    template<typename _DType>
+    typename multiarray<_DType>::native_type dot(
+      const multiarray<_DType> &a, const multiarray<_DType> &b);
+
+  }  // namespace detail
+
+  // matrix products of float32 and float64 arrays, over packed panels of the operands with
+  // register blocked kernels of each instruction set level of simd.hh, blocked for the
+  // caches and split across the threads of the default executor. Operands are read through
+  // their strides, so transposed and sliced views need no copies, and results are identical
+  // for any number of threads. Outputs which overlap an operand are computed from a copy
+  // of it.
+
+  // c = alpha * op(a) op(b) + beta * c for matrices, or stacks of them along leading axes
+  // which broadcast against those of c, op(x) swapping the last two axes of x when it is
+  // marked transposed. With a zero beta, c is only written.
+  template<typename _DType>
+  multiarray<_DType> &gemm(const multiarray<_DType> &a, const multiarray<_DType> &b,
+    multiarray<_DType> &c, const typename multiarray<_DType>::native_type alpha = 1,
+    const typename multiarray<_DType>::native_type beta = 0, const bool transpose_a = false,
+    const bool transpose_b = false)
+  {
+    detail::gemm(a, transpose_a, b, transpose_b, alpha, beta, c);
+    return c;
+  }
+
+  // product over the last axis of `a` and the second to last of `b`, as numpy's matmul,
+  // a vector `a` is a single row and a vector `b` a single column, which are dropped from
+  // the result, and stacks of matrices broadcast along their leading axes
+  template<typename _DType>
+  multiarray<_DType> &matmul(
+    const multiarray<_DType> &a, const multiarray<_DType> &b, multiarray<_DType> &out)
+  {
+    if (out.dim() != detail::matmul_shape(a.dim(), b.dim()))
+      throw std::invalid_argument { "output shape does not match the product" };
+    detail::gemm(a, false, b, false, 1, 0, out);
+    return out;
+  }
+
+  template<typename _DType>
+  multiarray<_DType> matmul(const multiarray<_DType> &a, const multiarray<_DType> &b)
+  {
+    multiarray<_DType> out { detail::matmul_shape(a.dim(), b.dim()), uninitialized };
+    detail::gemm(a, false, b, false, 1, 0, out);
+    return out;
+  }
+
+  // inner product of two vectors of the same length
+  template<typename _DType>
+  typename multiarray<_DType>::native_type dot(
+    const multiarray<_DType> &a, const multiarray<_DType> &b)
+  {
+    return detail::dot(a, b);
+  }
+
+}  // namespace covdel::ma
+
+#endif
@@ -18,11 +18,39 @@
 #ifndef __COVDEL_INCLUDE_COVDEL_MA_MULTIARRAY_HH_1667987582__
 #define __COVDEL_INCLUDE_COVDEL_MA_MULTIARRAY_HH_1667987582__
 
+#include "allocator.hh"
 #include "datatype.hh"
 #include "dimension.hh"
 
+#include <cassert>
+#include <memory>
+
 namespace covdel::ma
 {
+  template<typename _Derived>
+  struct expression;
+
+  // selects construction of arrays whose elements are left unset, for buffers which are
+  // about to be overwritten anyway
+  struct uninitialized_t {
+    explicit uninitialized_t() = default;
+  };
+  inline constexpr uninitialized_t uninitialized {};
+
+  // rounding of floating point values converted to integers
+  enum class rounding { truncate, nearest_even };
+
+  // element conversion of astype, the default is a static_cast, otherwise `in * scale +
+  // offset` is computed in float32, or float64 when either datatype needs more precision,
+  // then rounded for integer outputs, which are clamped to their range under `saturate`,
+  // with NaN becoming 0, out of range values are undefined without it
+  struct conversion {
+    rounding round { rounding::truncate };
+    bool saturate { false };
+    double scale { 1 };
+    double offset { 0 };
+  };
+
   template<typename _DType>
   class scalar {  // 1-8B
   public:
@@ -36,16 +64,27 @@ namespace covdel::ma
     native_type m_value;
   };
 
+  // strided view over a reference counted buffer, shared between all of its views, new
+  // buffers come from the given allocator and are returned to it by the last view
   template<typename _DType>
-  class multiarray {  // 32B
+  class multiarray {  // 144B
   public:
     using native_type = std::enable_if_t<dtype::is_valid<_DType>, typename _DType::type>;
 
     // constructors
-    multiarray(const dimension &dim);
-    multiarray(const dimension &dim, const native_type fill);
+    multiarray(const dimension &dim, allocator &alloc = default_allocator());
+    multiarray(const dimension &dim, const native_type fill,
+      allocator &alloc = default_allocator());
+    multiarray(const dimension &dim, uninitialized_t,
+      allocator &alloc = default_allocator());
+    // view of the given layout over an external buffer, such as a memory mapped file,
+    // which `owner` keeps alive for as long as any view of it
+    multiarray(native_type *data, const dimension &dim, const stride &strides,
+      const std::shared_ptr<void> &owner);
     multiarray(const multiarray &copy);
     multiarray(multiarray &&move) noexcept;
+    template<typename _Derived>
+    multiarray(const expression<_Derived> &expr);
     ~multiarray() noexcept;
 
     // operators
@@ -55,39 +94,116 @@ namespace covdel::ma
     operator bool() const noexcept;
     native_type &operator[](const index &idx);
     const native_type &operator[](const index &idx) const;
+    template<typename... _Args>
+    native_type &operator()(const _Args... args) noexcept;
+    template<typename... _Args>
+    const native_type &operator()(const _Args... args) const noexcept;
     friend std::ostream &operator<<(std::ostream &out, const multiarray &obj);
 
     // getters
     datatype type() const noexcept;
     const dimension &dim() const noexcept;
+    const stride &strides() const noexcept;
+    native_type *data() noexcept;
+    const native_type *data() const noexcept;
     size_t ndims() const noexcept;
     size_t size() const noexcept;
     bool is_base() const noexcept;
+    bool is_contiguous() const noexcept;
     std::string str() const noexcept;
 
+    // checked element access
+    native_type &at(const index &idx);
+    const native_type &at(const index &idx) const;
+
     // general
     template<typename _AsArray, typename _AsType = typename _AsArray::native_type>
-    _AsArray astype() const;
+    _AsArray astype(const conversion &conv = {}) const;
     multiarray copy() const;
+    multiarray ascontiguous() const;
     void swap(multiarray &other) noexcept;
 
     // shape manipulation
     multiarray &reshape(const dimension &new_dim);
     multiarray &flatten();
     multiarray &squeeze();
+    multiarray &transpose();
+    multiarray &permute(const index &axes);
+
+    // views
+    multiarray slice(int axis, ptrdiff_t start, ptrdiff_t stop, ptrdiff_t step = 1) const;
+    multiarray broadcast_to(const dimension &new_dim) const;
 
     // item manipulation
     void fill(const native_type value);
 
   private:
+    std::shared_ptr<native_type[]> p_base;
     native_type *p_data;
     dimension m_dim;
+    stride m_stride;
     bool m_is_base;
 
+    template<typename... _Args>
+    ptrdiff_t offset(const _Args... args) const noexcept;
+
     template<typename _OtherType>
     friend class multiarray;
   };
 
+  // in-header definitions
+
+  // unchecked element offset, bounds are only asserted in debug builds
+  template<typename _DType>
+  template<typename... _Args>
+  inline ptrdiff_t multiarray<_DType>::offset(const _Args... args) const noexcept
+  {
+    static_assert((std::is_integral_v<_Args> && ...), "indices must be integral\n");
+    assert(int(sizeof...(args)) == m_dim.m_len && "index rank mismatch");
+
+    ptrdiff_t offset { 0 };
+    int axis { 0 };
+    ((assert(size_t(args) < m_dim.m_data[axis] && "index out of bounds"),
+       offset += ptrdiff_t(args) * m_stride.m_data[axis++]),
+      ...);
+    return offset;
+  }
+
+  template<typename _DType>
+  template<typename... _Args>
+  inline typename multiarray<_DType>::native_type &multiarray<_DType>::operator()(
+    const _Args... args) noexcept
+  {
+    return p_data[offset(args...)];
+  }
+
+  template<typename _DType>
+  template<typename... _Args>
+  inline const typename multiarray<_DType>::native_type &multiarray<_DType>::operator()(
+    const _Args... args) const noexcept
+  {
+    return p_data[offset(args...)];
+  }
+
+  template<typename _DType>
+  inline const stride &multiarray<_DType>::strides() const noexcept
+  {
+    return m_stride;
+  }
+
+  template<typename _DType>
+  inline typename multiarray<_DType>::native_type *multiarray<_DType>::data() noexcept
+  {
+    return p_data;
+  }
+
+  template<typename _DType>
+  inline const typename multiarray<_DType>::native_type *
+  multiarray<_DType>::data() const noexcept
+  {
+    return p_data;
+  }
+
 }  // namespace covdel::ma
 
 #endif
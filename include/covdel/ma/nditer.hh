@@ -0,0 +1,547 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_NDITER_HH_1703265190__
+#define __COVDEL_INCLUDE_COVDEL_MA_NDITER_HH_1703265190__
+
+#include "executor.hh"
+#include "multiarray.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    using extents_t = std::array<size_t, 6>;
+    using steps_t   = std::array<ptrdiff_t, 6>;
+
+    template<typename _Func, typename _Ptrs, typename _Steps, size_t... K>
+    inline void invoke_run(_Func &func, const _Ptrs &ptrs, const _Steps &steps, int inner,
+      size_t count, std::index_sequence<K...>)
+    {
+      func(std::get<K>(ptrs)..., steps[K][inner]..., count);
+    }
+
+    template<typename _Ptrs, typename _Steps, size_t... K>
+    inline void advance(
+      _Ptrs &ptrs, const _Steps &steps, int axis, ptrdiff_t times, std::index_sequence<K...>)
+    {
+      ((std::get<K>(ptrs) += steps[K][axis] * times), ...);
+    }
+
+    // merges adjacent axes which are contiguous in every operand, innermost first,
+    // returning the number of axes left
+    template<size_t N>
+    int merge_axes(int ndims, extents_t &extent, std::array<steps_t, N> &steps) noexcept
+    {
+      for (int i { ndims - 1 }; i-- > 0;) {
+        bool mergeable { true };
+        for (size_t k { 0 }; k < N; ++k)
+          mergeable &= steps[k][i] == steps[k][i + 1] * ptrdiff_t(extent[i + 1]);
+        if (!mergeable) continue;
+        extent[i] *= extent[i + 1];
+        for (size_t k { 0 }; k < N; ++k) steps[k][i] = steps[k][i + 1];
+        for (int j { i + 1 }; j + 1 < ndims; ++j) {
+          extent[j] = extent[j + 1];
+          for (size_t k { 0 }; k < N; ++k) steps[k][j] = steps[k][j + 1];
+        }
+        --ndims;
+      }
+      return ndims;
+    }
+
+    // walks the elements [begin, end) of `extent` over `ndims` axes of non-zero extents
+    // in order, calling `func(ptrs..., inner_steps..., count)` once per run along the
+    // innermost axis
+    template<typename _Func, size_t N, typename... _Types>
+    void walk_runs(const int ndims, const extents_t &extent,
+      const std::array<steps_t, N> &steps, size_t begin, const size_t end, _Func &func,
+      std::tuple<_Types *...> ptrs)
+    {
+      if (begin >= end) return;
+      const int inner { ndims - 1 };
+      extents_t counter {};
+      constexpr std::make_index_sequence<N> seq {};
+
+      size_t remaining { end - begin };
+      for (int axis { ndims }; axis-- > 0;) {
+        counter[axis] = begin % extent[axis];
+        begin /= extent[axis];
+        advance(ptrs, steps, axis, ptrdiff_t(counter[axis]), seq);
+      }
+
+      while (true) {
+        const size_t count { std::min(extent[inner] - counter[inner], remaining) };
+        invoke_run(func, ptrs, steps, inner, count, seq);
+        if ((remaining -= count) == 0) return;
+
+        // runs after the first start at the beginning of their row
+        advance(ptrs, steps, inner, -ptrdiff_t(counter[inner]), seq);
+        counter[inner] = 0;
+        int axis { inner };
+        while (--axis >= 0) {
+          if (++counter[axis] < extent[axis]) {
+            advance(ptrs, steps, axis, 1, seq);
+            break;
+          }
+          advance(ptrs, steps, axis, -ptrdiff_t(extent[axis] - 1), seq);
+          counter[axis] = 0;
+        }
+      }
+    }
+
+    template<typename _Array>
+    using element_t = std::remove_pointer_t<decltype(std::declval<_Array &>().data())>;
+
+  }  // namespace detail
+
+  ////////////////////////////////////// ITERATORS //////////////////////////////////////
+
+  // random-access iterator over the elements of a view in row-major order, whose axes
+  // are merged where contiguous so that contiguous arrays advance as a pointer would,
+  // other views carrying a counter per axis
+  template<typename _Type>
+  class flat_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = std::remove_const_t<_Type>;
+    using difference_type   = ptrdiff_t;
+    using pointer           = _Type *;
+    using reference         = _Type &;
+
+    // constructors
+    flat_iterator() noexcept = default;
+    flat_iterator(_Type *data, const dimension &dim, const stride &strides,
+      size_t position) noexcept;
+    // mutable iterators convert to constant ones
+    template<typename _Other,
+      typename = std::enable_if_t<std::is_same_v<const _Other, _Type>
+                                  && !std::is_same_v<_Other, _Type>>>
+    flat_iterator(const flat_iterator<_Other> &other) noexcept;
+
+    // operators
+    reference operator*() const noexcept { return *p_current; }
+    pointer operator->() const noexcept { return p_current; }
+    reference operator[](const difference_type n) const noexcept { return *(*this + n); }
+
+    flat_iterator &operator++() noexcept;
+    flat_iterator &operator--() noexcept;
+    flat_iterator operator++(int) noexcept;
+    flat_iterator operator--(int) noexcept;
+    flat_iterator &operator+=(const difference_type n) noexcept;
+    flat_iterator &operator-=(const difference_type n) noexcept { return *this += -n; }
+    flat_iterator operator+(const difference_type n) const noexcept;
+    flat_iterator operator-(const difference_type n) const noexcept;
+    friend flat_iterator operator+(const difference_type n, const flat_iterator &it) noexcept
+    {
+      return it + n;
+    }
+    difference_type operator-(const flat_iterator &rhs) const noexcept
+    {
+      return difference_type(m_position) - difference_type(rhs.m_position);
+    }
+
+    bool operator==(const flat_iterator &rhs) const noexcept;
+    bool operator!=(const flat_iterator &rhs) const noexcept { return !(*this == rhs); }
+    bool operator<(const flat_iterator &rhs) const noexcept;
+    bool operator>(const flat_iterator &rhs) const noexcept { return rhs < *this; }
+    bool operator<=(const flat_iterator &rhs) const noexcept { return !(rhs < *this); }
+    bool operator>=(const flat_iterator &rhs) const noexcept { return !(*this < rhs); }
+
+    // position in row-major order
+    size_t position() const noexcept { return m_position; }
+
+  private:
+    _Type *p_base { nullptr }, *p_current { nullptr };
+    size_t m_position { 0 }, m_size { 0 };
+    int m_ndims { 1 };
+    detail::extents_t m_extent {}, m_counter {};
+    detail::steps_t m_step {};
+
+    // counters and pointer of a position, the pointer of the end being the base
+    void seek(size_t position) noexcept;
+
+    template<typename _Other>
+    friend class flat_iterator;
+  };
+
+  // iterators over multiarrays, so that they work with range-based for loops and with
+  // the algorithms of the standard library, including the parallel ones
+  template<typename _DType>
+  flat_iterator<typename multiarray<_DType>::native_type> begin(multiarray<_DType> &a) noexcept
+  {
+    return { a.data(), a.dim(), a.strides(), 0 };
+  }
+
+  template<typename _DType>
+  flat_iterator<typename multiarray<_DType>::native_type> end(multiarray<_DType> &a) noexcept
+  {
+    return { a.data(), a.dim(), a.strides(), a.size() };
+  }
+
+  template<typename _DType>
+  flat_iterator<const typename multiarray<_DType>::native_type> begin(
+    const multiarray<_DType> &a) noexcept
+  {
+    return { a.data(), a.dim(), a.strides(), 0 };
+  }
+
+  template<typename _DType>
+  flat_iterator<const typename multiarray<_DType>::native_type> end(
+    const multiarray<_DType> &a) noexcept
+  {
+    return { a.data(), a.dim(), a.strides(), a.size() };
+  }
+
+  template<typename _DType>
+  flat_iterator<const typename multiarray<_DType>::native_type> cbegin(
+    const multiarray<_DType> &a) noexcept
+  {
+    return begin(a);
+  }
+
+  template<typename _DType>
+  flat_iterator<const typename multiarray<_DType>::native_type> cend(
+    const multiarray<_DType> &a) noexcept
+  {
+    return end(a);
+  }
+
+  /////////////////////////////////////// NDITER ////////////////////////////////////////
+
+  // order in which an nditer visits the elements, `memory` sorts the axes by their strides
+  // and flips reversed ones so that inner loops run along memory, which only keeps the
+  // pairing of elements across operands, while `row_major` keeps the order of the shape
+  enum class traversal { memory, row_major };
+
+  // joint traversal of several operands, broadcast against each other, in runs handed to
+  // a callback as `func(ptrs..., strides..., count)`, a pointer and an element stride per
+  // operand for `count` elements. Axes of extent 1 are dropped and adjacent axes which are
+  // contiguous in every operand are merged, so that contiguous operands make a single run.
+  // Operands made from const arrays get const pointers.
+  template<typename... _Types>
+  class nditer {
+  public:
+    static constexpr size_t N { sizeof...(_Types) };
+
+    // operands of the shape `dim`, broadcast ones having zero strides
+    nditer(const dimension &dim, const std::array<ma::stride, N> &strides, _Types *...data,
+      traversal order = traversal::memory) noexcept;
+
+    // operands broadcast to their common shape, which throws std::invalid_argument when
+    // they do not broadcast
+    template<typename... _Arrays, typename = std::enable_if_t<sizeof...(_Arrays) == N
+                                    && (!std::is_base_of_v<nditer, _Arrays> && ...)>>
+    explicit nditer(_Arrays &...arrays);
+    template<typename... _Arrays, typename = std::enable_if_t<sizeof...(_Arrays) == N
+                                    && (!std::is_base_of_v<nditer, _Arrays> && ...)>>
+    nditer(traversal order, _Arrays &...arrays);
+
+    // getters
+    int ndims() const noexcept { return m_ndims; }
+    size_t extent(const int axis) const noexcept { return m_extent[axis]; }
+    ptrdiff_t stride(const size_t operand, const int axis) const noexcept
+    {
+      return m_steps[operand][axis];
+    }
+    size_t size() const noexcept { return m_size; }
+    // elements per run, the extent of the innermost axis
+    size_t run_length() const noexcept { return m_size ? m_extent[m_ndims - 1] : 0; }
+
+    // runs over every element, or the elements [begin, end) in the order of the traversal
+    template<typename _Func>
+    void for_each(_Func &&func) const;
+    template<typename _Func>
+    void for_each(size_t begin, size_t end, _Func &&func) const;
+
+    // runs over ranges of about `grain` elements across the threads of the default
+    // executor, so `func` must be safe to call concurrently on disjoint runs
+    template<typename _Func>
+    void parallel_for_each(size_t grain, _Func &&func) const;
+
+  private:
+    std::tuple<_Types *...> m_data;
+    int m_ndims;
+    detail::extents_t m_extent;
+    std::array<detail::steps_t, N> m_steps;
+    size_t m_size;
+
+    void coalesce(traversal order) noexcept;
+  };
+
+  template<typename... _Arrays>
+  nditer(_Arrays &...arrays) -> nditer<detail::element_t<_Arrays>...>;
+
+  template<typename... _Arrays>
+  nditer(traversal order, _Arrays &...arrays) -> nditer<detail::element_t<_Arrays>...>;
+
+  // in-header definitions
+
+  template<typename _Type>
+  flat_iterator<_Type>::flat_iterator(_Type *data, const dimension &dim,
+    const stride &strides, const size_t position) noexcept
+    : p_base { data }, p_current { data }, m_position { 0 }, m_size { 1 }, m_ndims { 0 }
+  {
+    std::array<detail::steps_t, 1> steps {};
+    for (int i { 0 }; i < dim.ndims(); ++i) {
+      m_size *= dim[i];
+      if (dim[i] == 1) continue;
+      m_extent[m_ndims]   = dim[i];
+      steps[0][m_ndims++] = strides[i];
+    }
+    if (m_ndims == 0) m_extent[0] = 1, m_ndims = 1;
+    m_ndims = detail::merge_axes(m_ndims, m_extent, steps);
+    m_step  = steps[0];
+    seek(position);
+  }
+
+  template<typename _Type>
+  template<typename _Other, typename>
+  flat_iterator<_Type>::flat_iterator(const flat_iterator<_Other> &other) noexcept
+    : p_base { other.p_base }, p_current { other.p_current },
+      m_position { other.m_position }, m_size { other.m_size }, m_ndims { other.m_ndims },
+      m_extent { other.m_extent }, m_counter { other.m_counter }, m_step { other.m_step }
+  { }
+
+  template<typename _Type>
+  void flat_iterator<_Type>::seek(size_t position) noexcept
+  {
+    m_position = position;
+    p_current  = p_base;
+    if (position >= m_size) return;
+    for (int axis { m_ndims }; axis-- > 0;) {
+      m_counter[axis] = position % m_extent[axis];
+      position /= m_extent[axis];
+      p_current += ptrdiff_t(m_counter[axis]) * m_step[axis];
+    }
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> &flat_iterator<_Type>::operator++() noexcept
+  {
+    const int inner { m_ndims - 1 };
+    if (++m_position < m_size && ++m_counter[inner] < m_extent[inner])
+      p_current += m_step[inner];
+    else
+      seek(m_position);
+    return *this;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> &flat_iterator<_Type>::operator--() noexcept
+  {
+    const int inner { m_ndims - 1 };
+    if (m_position < m_size && m_counter[inner] > 0) {
+      --m_position, --m_counter[inner];
+      p_current -= m_step[inner];
+    } else
+      seek(m_position - 1);
+    return *this;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> flat_iterator<_Type>::operator++(int) noexcept
+  {
+    flat_iterator out { *this };
+    ++*this;
+    return out;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> flat_iterator<_Type>::operator--(int) noexcept
+  {
+    flat_iterator out { *this };
+    --*this;
+    return out;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> &flat_iterator<_Type>::operator+=(
+    const difference_type n) noexcept
+  {
+    // moves within the innermost run need no division
+    const int inner { m_ndims - 1 };
+    const size_t position { size_t(difference_type(m_position) + n) };
+    const difference_type counter { difference_type(m_counter[inner]) + n };
+    if (m_position < m_size && position < m_size && counter >= 0
+        && counter < difference_type(m_extent[inner])) {
+      m_position       = position;
+      m_counter[inner] = size_t(counter);
+      p_current += n * m_step[inner];
+    } else
+      seek(position);
+    return *this;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> flat_iterator<_Type>::operator+(
+    const difference_type n) const noexcept
+  {
+    flat_iterator out { *this };
+    return out += n;
+  }
+
+  template<typename _Type>
+  inline flat_iterator<_Type> flat_iterator<_Type>::operator-(
+    const difference_type n) const noexcept
+  {
+    flat_iterator out { *this };
+    return out += -n;
+  }
+
+  template<typename _Type>
+  inline bool flat_iterator<_Type>::operator==(const flat_iterator &rhs) const noexcept
+  {
+    return m_position == rhs.m_position && p_base == rhs.p_base;
+  }
+
+  template<typename _Type>
+  inline bool flat_iterator<_Type>::operator<(const flat_iterator &rhs) const noexcept
+  {
+    return m_position < rhs.m_position;
+  }
+
+  template<typename... _Types>
+  nditer<_Types...>::nditer(const dimension &dim, const std::array<ma::stride, N> &strides,
+    _Types *...data, const traversal order) noexcept
+    : m_data { data... }, m_ndims { dim.ndims() }, m_extent {}, m_steps {}, m_size { 1 }
+  {
+    for (int i { 0 }; i < m_ndims; ++i) {
+      m_extent[i] = dim[i];
+      m_size *= dim[i];
+      for (size_t k { 0 }; k < N; ++k) m_steps[k][i] = strides[k][i];
+    }
+    coalesce(order);
+  }
+
+  template<typename... _Types>
+  template<typename... _Arrays, typename>
+  nditer<_Types...>::nditer(_Arrays &...arrays) : nditer { traversal::memory, arrays... }
+  { }
+
+  template<typename... _Types>
+  template<typename... _Arrays, typename>
+  nditer<_Types...>::nditer(const traversal order, _Arrays &...arrays)
+    : m_data { arrays.data()... }, m_ndims { 0 }, m_extent {}, m_steps {}, m_size { 1 }
+  {
+    dimension dim { std::get<0>(std::forward_as_tuple(arrays...)).dim() };
+    ((dim = broadcast(dim, arrays.dim())), ...);
+    m_ndims = dim.ndims();
+    for (int i { 0 }; i < m_ndims; ++i) {
+      m_extent[i] = dim[i];
+      m_size *= dim[i];
+    }
+
+    // strides aligned at the last axis, zero along broadcast axes
+    size_t k { 0 };
+    ((
+       [&](const auto &a) {
+         const int lead { m_ndims - a.dim().ndims() };
+         for (int i { lead }; i < m_ndims; ++i)
+           m_steps[k][i] = a.dim()[i - lead] == 1 ? 0 : a.strides()[i - lead];
+         ++k;
+       }(arrays)),
+      ...);
+    coalesce(order);
+  }
+
+  template<typename... _Types>
+  void nditer<_Types...>::coalesce(const traversal order) noexcept
+  {
+    if (m_size == 0) return void(m_ndims = 0);
+
+    // axes of extent 1 take no part in the traversal
+    int kept { 0 };
+    for (int i { 0 }; i < m_ndims; ++i) {
+      if (m_extent[i] == 1) continue;
+      m_extent[kept] = m_extent[i];
+      for (size_t k { 0 }; k < N; ++k) m_steps[k][kept] = m_steps[k][i];
+      ++kept;
+    }
+    m_ndims = kept;
+
+    if (order == traversal::memory) {
+      // axes running backwards in every operand are walked forwards from their last element
+      for (int i { 0 }; i < m_ndims; ++i) {
+        bool reversed { false }, flippable { true };
+        for (size_t k { 0 }; k < N; ++k)
+          reversed |= m_steps[k][i] < 0, flippable &= m_steps[k][i] <= 0;
+        if (!reversed || !flippable) continue;
+        const ptrdiff_t last { ptrdiff_t(m_extent[i] - 1) };
+        std::apply(
+          [&](auto *&...ptrs) {
+            size_t k { 0 };
+            ((ptrs += last * m_steps[k][i], m_steps[k][i] = -m_steps[k][i], ++k), ...);
+          },
+          m_data);
+      }
+
+      // a stable insertion sort of the axes, an axis going inside another when the first
+      // operand which strides along both steps less along it
+      const auto inside = [this](const int a, const int b) {
+        for (size_t k { 0 }; k < N; ++k) {
+          const ptrdiff_t x { std::abs(m_steps[k][a]) }, y { std::abs(m_steps[k][b]) };
+          if (x == 0 || y == 0 || x == y) continue;
+          return x < y;
+        }
+        return false;
+      };
+      for (int i { 1 }; i < m_ndims; ++i)
+        for (int j { i }; j > 0 && inside(j - 1, j); --j) {
+          std::swap(m_extent[j - 1], m_extent[j]);
+          for (size_t k { 0 }; k < N; ++k) std::swap(m_steps[k][j - 1], m_steps[k][j]);
+        }
+    }
+
+    if (m_ndims == 0) m_extent[0] = 1, m_ndims = 1;
+    m_ndims = detail::merge_axes(m_ndims, m_extent, m_steps);
+  }
+
+  template<typename... _Types>
+  template<typename _Func>
+  void nditer<_Types...>::for_each(_Func &&func) const
+  {
+    for_each(0, m_size, std::forward<_Func>(func));
+  }
+
+  template<typename... _Types>
+  template<typename _Func>
+  void nditer<_Types...>::for_each(const size_t begin, const size_t end, _Func &&func) const
+  {
+    detail::walk_runs(m_ndims, m_extent, m_steps, begin, std::min(end, m_size), func, m_data);
+  }
+
+  template<typename... _Types>
+  template<typename _Func>
+  void nditer<_Types...>::parallel_for_each(const size_t grain, _Func &&func) const
+  {
+    if (m_size < 2 * grain) return for_each(func);
+    default_executor().parallel_for(m_size, std::max<size_t>(grain, 1),
+      [this, &func](const size_t begin, const size_t end) { for_each(begin, end, func); });
+  }
+
+}  // namespace covdel::ma
+
+#endif
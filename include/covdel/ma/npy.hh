@@ -0,0 +1,124 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_NPY_HH_1701208554__
+#define __COVDEL_INCLUDE_COVDEL_MA_NPY_HH_1701208554__
+
+#include "multiarray.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    struct mapped_file;
+  }
+
+  // protection of arrays mapped from files, which are never modified through them,
+  // writing to a read_only array faults while copy_on_write arrays get private copies of
+  // the pages they write to
+  enum class mapping { read_only, copy_on_write };
+
+  // array stored in a .npy file
+  struct npy_header {
+    datatype type;
+    dimension dim;
+    bool fortran_order;  // column-major payload, loaded as a transposed view
+    bool swapped;        // byte order differs from the host, loaded as a converted copy
+  };
+
+  npy_header inspect_npy(const std::string &path);
+
+  // maps a .npy file and returns a view of its payload, which is neither read nor copied,
+  // so loading takes the same time for any file size, only payloads in the other byte
+  // order are loaded into a new array, throws std::invalid_argument if the file holds
+  // another datatype
+  template<typename _MultiArray>
+  _MultiArray load_npy(const std::string &path, mapping map = mapping::copy_on_write);
+
+  // streams the array into a .npy file, straight from its buffer when it is laid out in
+  // row or column-major order
+  template<typename _DType>
+  void save_npy(const std::string &path, const multiarray<_DType> &array);
+
+  // .npz archive mapped once, every array returned is a view into the shared mapping,
+  // which outlives the archive as long as any of them does, members stored misaligned for
+  // their datatype are copied, and deflate compressed ones, as np.savez_compressed writes
+  // them, are decompressed into a new array on every access
+  class npz_archive {
+  public:
+    explicit npz_archive(const std::string &path, mapping map = mapping::copy_on_write);
+
+    // member names without their .npy suffix, in archive order
+    std::vector<std::string> names() const;
+    bool contains(const std::string &name) const noexcept;
+    npy_header header(const std::string &name) const;
+
+    template<typename _MultiArray>
+    _MultiArray get(const std::string &name) const;
+
+  private:
+    struct member {
+      std::string name;
+      std::size_t offset;    // of the .npy data within the file
+      std::size_t size;      // within the file
+      std::size_t unpacked;  // once decompressed
+      std::uint32_t crc;
+      int method;            // of compression, 0 when stored
+    };
+
+    std::shared_ptr<detail::mapped_file> p_file;
+    std::vector<member> m_members;
+
+    const member &find(const std::string &name) const;
+  };
+
+  // streams arrays into a new .npz archive, uncompressed so that npz_archive maps them
+  // back, with every payload aligned to ALIGNMENT, archives over 4GiB use zip64 records,
+  // the archive is complete once closed, explicitly or by the destructor
+  class npz_writer {
+  public:
+    explicit npz_writer(const std::string &path);
+    npz_writer(const npz_writer &) = delete;
+    npz_writer &operator=(const npz_writer &) = delete;
+    ~npz_writer() noexcept;
+
+    template<typename _DType>
+    void add(const std::string &name, const multiarray<_DType> &array);
+    void close();
+
+  private:
+    struct entry {
+      std::string name;
+      std::size_t offset;  // of the local header within the file
+      std::size_t size;
+      std::uint32_t crc;
+    };
+
+    std::ofstream m_out;
+    std::vector<entry> m_entries;
+  };
+
+}  // namespace covdel::ma
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_QUANTIZE_HH_1702475298__
+#define __COVDEL_INCLUDE_COVDEL_MA_QUANTIZE_HH_1702475298__
+
+#include "multiarray.hh"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace covdel::ma
+{
+  // affine mapping of the integers of a quantized array onto real values, real = scale *
+  // (q - zero_point), with a single scale and zero point for the whole array, or one for
+  // each index along `axis`
+  struct quantization {
+    std::vector<float> scales { 1.f };
+    std::vector<std::int32_t> zero_points { 0 };
+    int axis { -1 };
+  };
+
+  // int8 or uint8 array along with the quantization of its values
+  template<typename _DType>
+  struct quantized {
+    static_assert(std::is_same_v<_DType, dtype::int8> || std::is_same_v<_DType, dtype::uint8>,
+      "quantized arrays hold int8 or uint8 values");
+
+    multiarray<_DType> values;
+    quantization params;
+  };
+
+  // quantization mapping the range of `x`, extended to include zero, onto the integers of
+  // `type`, int8 or uint8, over the whole array or each index along `axis`. Symmetric ones
+  // map zero onto 0, or 128 for uint8, and the largest magnitude onto 127.
+  quantization calibrate(const multiarray<dtype::float32> &x, const datatype type,
+    const int axis = -1, const bool symmetric = false);
+
+  // values rounded to nearest even and saturated, through the astype kernels
+  template<typename _DType>
+  quantized<_DType> quantize(const multiarray<dtype::float32> &x, const quantization &params);
+
+  template<typename _DType>
+  multiarray<dtype::float32> dequantize(const quantized<_DType> &q);
+
+  // epilogue of quantized products written back as integers, a bias for each column of
+  // the product, in units of the product of the scales of the operands, is added to the
+  // sums before they are scaled to the output, which is clamped below at its zero point
+  // under `relu`
+  struct requantization {
+    std::vector<std::int32_t> bias {};
+    bool relu { false };
+  };
+
+  // products of int8 and uint8 matrices, in any combination, which accumulate exactly in
+  // int32 over packed panels with the kernels of each instruction set level of simd.hh,
+  // vnni dot products being used on avx512 cpus which have them, and are split across
+  // the threads of the default executor with identical results. As with gemm, operands
+  // are read through their strides and `transpose_a`, `transpose_b` swap their axes. a is
+  // quantized as a whole, b as a whole or along its columns, and products are limited to
+  // a depth of 32768, over which the sums could overflow.
+
+  // c = (op(a) - zero_a)(op(b) - zero_b)
+  template<typename _ADType, typename _BDType>
+  multiarray<dtype::int32> &qgemm(const quantized<_ADType> &a, const quantized<_BDType> &b,
+    multiarray<dtype::int32> &c, const bool transpose_a = false,
+    const bool transpose_b = false);
+
+  // the same products, with the bias of the epilogue, requantized to the parameters of c
+  // in the same pass, which must be a single scale and zero point
+  template<typename _ADType, typename _BDType, typename _CDType>
+  quantized<_CDType> &qgemm(const quantized<_ADType> &a, const quantized<_BDType> &b,
+    quantized<_CDType> &c, const requantization &epilogue = {},
+    const bool transpose_a = false, const bool transpose_b = false);
+
+}  // namespace covdel::ma
+
+#endif
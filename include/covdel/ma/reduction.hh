@@ -0,0 +1,127 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_REDUCTION_HH_1700611245__
+#define __COVDEL_INCLUDE_COVDEL_MA_REDUCTION_HH_1700611245__
+
+#include "multiarray.hh"
+
+#include <type_traits>
+#include <vector>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    enum class reduce_op { sum, prod, mean, var, stddev, min, max, argmin, argmax, any, all };
+
+    // sums and products of integers accumulate in 64 bits, booleans are counted as int64
+    template<typename _DType, typename _Type = typename _DType::type>
+    using accumulated_t = std::conditional_t<std::is_floating_point_v<_Type>, _DType,
+      std::conditional_t<std::is_unsigned_v<_Type> && !std::is_same_v<_Type, bool>,
+        dtype::uint64, dtype::int64>>;
+
+    // moments of everything but float32 are computed in double precision
+    template<typename _DType>
+    using averaged_t =
+      std::conditional_t<std::is_same_v<_DType, dtype::float32>, dtype::float32, dtype::float64>;
+
+    // bitmask of the given axes, negative ones counting back from the last
+    unsigned axis_mask(const dimension &dim, const std::vector<int> &axes);
+
+    // reduces the axes set in the `axes` bitmask into the contiguous `out`, whose elements
+    // follow the remaining axes in row-major order, `ddof` only applies to var and stddev
+    template<typename _DType, typename _RType>
+    void reduce(const reduce_op op, const multiarray<_DType> &a, const unsigned axes,
+      const size_t ddof, multiarray<_RType> &out);
+
+  }  // namespace detail
+
+// reduction over the whole array, returning a value, or along the given axes, returning an
+// array which keeps the reduced axes with an extent of 1 under `keepdims`
+#define REDUCTION_FUNCTION(name, label, result)                                        \
+ template<typename _DType>                                                             \
+ typename multiarray<result>::native_type name(const multiarray<_DType> &a)            \
+ {                                                                                     \
+  multiarray<result> out { dimension(1), uninitialized };                              \
+  const unsigned axes { (1U << a.dim().ndims()) - 1 };                                 \
+  detail::reduce<_DType, result>(detail::reduce_op::label, a, axes, 0, out);           \
+  return out.data()[0];                                                                \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> name(                                                              \
+   const multiarray<_DType> &a, const std::vector<int> &axes, const bool keepdims = false)\
+ {                                                                                     \
+  const unsigned mask { detail::axis_mask(a.dim(), axes) };                            \
+  multiarray<result> out { reduced(a.dim(), mask, keepdims), uninitialized };          \
+  detail::reduce<_DType, result>(detail::reduce_op::label, a, mask, 0, out);           \
+  return out;                                                                          \
+ }                                                                                     \
+                                                                                       \
+ template<typename _DType>                                                             \
+ multiarray<result> name(const multiarray<_DType> &a, const int axis,                  \
+   const bool keepdims = false)                                                        \
+ {                                                                                     \
+  return name(a, std::vector<int> { axis }, keepdims);                                 \
+ }
+
+  // floating point sums are pairwise or Kahan compensated, and split into chunks which only
+  // depend on the shape, so results are identical for any number of threads
+  REDUCTION_FUNCTION(sum, sum, detail::accumulated_t<_DType>)
+  REDUCTION_FUNCTION(prod, prod, detail::accumulated_t<_DType>)
+  REDUCTION_FUNCTION(mean, mean, detail::averaged_t<_DType>)
+
+  // population moments, see the overloads below for other degrees of freedom
+  REDUCTION_FUNCTION(var, var, detail::averaged_t<_DType>)
+  REDUCTION_FUNCTION(stddev, stddev, detail::averaged_t<_DType>)
+
+  // extremes propagate NaN, and throw on empty reductions, which have no identity
+  REDUCTION_FUNCTION(min, min, _DType)
+  REDUCTION_FUNCTION(max, max, _DType)
+
+  // first position of an extreme, flat over the reduced axes in row-major order
+  REDUCTION_FUNCTION(argmin, argmin, dtype::uint64)
+  REDUCTION_FUNCTION(argmax, argmax, dtype::uint64)
+
+  // truth of any or all elements, NaN counting as true
+  REDUCTION_FUNCTION(any, any, dtype::bool8)
+  REDUCTION_FUNCTION(all, all, dtype::bool8)
+
+#undef REDUCTION_FUNCTION
+
+// variance and standard deviation divided by `n - ddof`, NaN when that is not positive
+#define MOMENT_FUNCTION(name)                                                           \
+ template<typename _DType>                                                             \
+ multiarray<detail::averaged_t<_DType>> name(const multiarray<_DType> &a,              \
+   const std::vector<int> &axes, const bool keepdims, const size_t ddof)               \
+ {                                                                                     \
+  using result = detail::averaged_t<_DType>;                                           \
+  const unsigned mask { detail::axis_mask(a.dim(), axes) };                            \
+  multiarray<result> out { reduced(a.dim(), mask, keepdims), uninitialized };          \
+  detail::reduce<_DType, result>(detail::reduce_op::name, a, mask, ddof, out);         \
+  return out;                                                                          \
+ }
+
+  MOMENT_FUNCTION(var)
+  MOMENT_FUNCTION(stddev)
+
+#undef MOMENT_FUNCTION
+
+}  // namespace covdel::ma
+
+#endif
@@ -0,0 +1,41 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __COVDEL_INCLUDE_COVDEL_MA_SIMD_HH_1700473021__
+#define __COVDEL_INCLUDE_COVDEL_MA_SIMD_HH_1700473021__
+
+#include <string>
+
+namespace covdel::ma
+{
+  // instruction set levels of the runtime dispatched kernels, in increasing order
+  enum class isa { scalar, sse2, avx2, avx512 };
+
+  // highest level supported by both this build and the running cpu
+  isa max_isa() noexcept;
+
+  // level whose kernels are currently dispatched, defaults to max_isa()
+  isa active_isa() noexcept;
+
+  // restricts dispatch to the given level, mostly useful for benchmarks and testing
+  void set_isa(const isa level);
+
+  std::string str(const isa level);
+
+}  // namespace covdel::ma
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_NN_CONV_HH_1702561174__
+#define __COVDEL_INCLUDE_COVDEL_NN_CONV_HH_1702561174__
+
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/quantize.hh"
+#include "covdel/nn/workspace.hh"
+
+#include <array>
+#include <cstddef>
+
+namespace covdel::nn
+{
+  // memory order of batches of images, channels before or after the spatial axes
+  enum class layout { nchw, nhwc };
+
+  // `im2col` lowers any convolution onto gemm, `direct` runs 1x1 kernels of stride 1
+  // without padding as a single gemm and depthwise ones, of one input channel per group,
+  // as loops over the taps, and `winograd` computes 3x3 kernels of stride and dilation 1
+  // and a single group as F(2x2, 3x3) tiles. `automatic` picks one per shape.
+  enum class conv_algorithm { automatic, im2col, direct, winograd };
+
+  // pairs are along (height, width), the output extent of an axis being (size + 2 *
+  // padding - dilation * (kernel - 1) - 1) / stride + 1
+  struct conv2d_params {
+    std::array<std::size_t, 2> stride { 1, 1 };
+    std::array<std::size_t, 2> padding { 0, 0 };
+    std::array<std::size_t, 2> dilation { 1, 1 };
+    std::size_t groups { 1 };
+    layout format { layout::nchw };
+    conv_algorithm algorithm { conv_algorithm::automatic };
+  };
+
+  // 2-D convolutions (cross-correlations, as in other frameworks) of batches of images of
+  // shape (batch, channels, height, width), or (batch, height, width, channels) for nhwc,
+  // with `weight` of shape (filters, channels / groups, kernel height, kernel width) and
+  // an optional `bias` of one value per filter, which may be empty. Inputs and outputs of
+  // any strides are accepted, and the work is split across the threads of the default
+  // executor. Temporaries come from the workspace `ws`, so that repeated convolutions of
+  // the same shapes allocate nothing once warmed up.
+
+  // shape of the output, throws std::invalid_argument for mismatched shapes
+  ma::dimension conv2d_shape(const ma::dimension &input, const ma::dimension &weight,
+    const conv2d_params &params = {});
+
+  // algorithm the convolution of these shapes runs with, the requested one or, when
+  // automatic, the choice of a cost model which is cached per shape
+  conv_algorithm conv2d_algorithm(const ma::dimension &input, const ma::dimension &weight,
+    const conv2d_params &params = {});
+
+  ma::float32 &conv2d(const ma::float32 &input, const ma::float32 &weight,
+    const ma::float32 &bias, ma::float32 &out, const conv2d_params &params = {},
+    workspace &ws = default_workspace());
+
+  // quantized convolutions of uint8 or int8 inputs, quantized as a whole, by int8 weights
+  // quantized as a whole or per filter, always lowered with im2col onto qgemm, whose
+  // epilogue adds the bias of each filter and optionally clamps at zero before the sums
+  // are requantized to `out`
+  template<typename _IDType, typename _ODType>
+  ma::quantized<_ODType> &conv2d(const ma::quantized<_IDType> &input,
+    const ma::quantized<ma::dtype::int8> &weight, const ma::requantization &epilogue,
+    ma::quantized<_ODType> &out, const conv2d_params &params = {},
+    workspace &ws = default_workspace());
+
+  // gradients of the convolution of `params` with respect to its input and to its
+  // weights, given the gradient `grad` of its output, written to the array given for
+  // them, or added onto it when `accumulate`. Both are lowered with im2col onto gemm, and
+  // the gradient of the bias is the sum of `grad` over all but the filter axis.
+  ma::float32 &conv2d_input_grad(const ma::float32 &grad, const ma::float32 &weight,
+    ma::float32 &input_grad, const conv2d_params &params = {}, bool accumulate = false,
+    workspace &ws = default_workspace());
+
+  ma::float32 &conv2d_weight_grad(const ma::float32 &input, const ma::float32 &grad,
+    ma::float32 &weight_grad, const conv2d_params &params = {}, bool accumulate = false,
+    workspace &ws = default_workspace());
+
+  // results in new arrays
+  inline ma::float32 conv2d(const ma::float32 &input, const ma::float32 &weight,
+    const ma::float32 &bias, const conv2d_params &params = {})
+  {
+    ma::float32 out { conv2d_shape(input.dim(), weight.dim(), params), ma::uninitialized };
+    conv2d(input, weight, bias, out, params);
+    return out;
+  }
+
+  inline ma::float32 conv2d(const ma::float32 &input, const ma::float32 &weight,
+    const conv2d_params &params = {})
+  {
+    return conv2d(input, weight, ma::float32 { ma::dimension(0) }, params);
+  }
+
+}  // namespace covdel::nn
+
+#endif
@@ -0,0 +1,88 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_NN_GRAPH_HH_1703091637__
+#define __COVDEL_INCLUDE_COVDEL_NN_GRAPH_HH_1703091637__
+
+#include "covdel/nn/module.hh"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace covdel::nn
+{
+  // static graph of the inference of a module on inputs of one shape, traced once from
+  // its forward pass. Element-wise operations are fused into the convolution, product or
+  // reduction they follow, such as a bias and an activation, or else into chains which
+  // make a single pass over their operands, and every intermediate result is placed at an
+  // offset of a single arena by the liveness of the values, results which die where a
+  // chain starts being overwritten in place. Once warmed up, runs allocate nothing.
+  // Parameters are referred to rather than copied, so in-place updates of them are seen,
+  // while a graph is unaffected by later changes to the structure of the module.
+  class graph {
+  public:
+    // timing of a node over the runs since the last reset_profile
+    struct node_profile {
+      std::string name;  // operations of the node, such as conv2d+add+maximum
+      std::size_t calls;
+      double seconds;
+    };
+
+    // traces `model` on an input of shape `input`, throws std::invalid_argument when the
+    // forward pass is not made of the operations of tensor.hh
+    graph(module &model, const ma::dimension &input);
+    graph(const graph &) = delete;
+    graph &operator=(const graph &) = delete;
+    ~graph() noexcept;
+
+    // output of the module for an input of the traced shape and any strides, a view into
+    // the arena which is overwritten by the next run
+    const ma::float32 &run(const ma::float32 &input);
+
+    // copies the output into `out`, of the shape of output()
+    ma::float32 &run(const ma::float32 &input, ma::float32 &out);
+
+    const ma::dimension &input() const noexcept;
+    const ma::dimension &output() const noexcept;
+
+    // number of nodes once fused
+    std::size_t size() const noexcept;
+
+    // bytes of the arena holding every intermediate result, and those the results would
+    // take if each had a buffer of its own
+    std::size_t planned_bytes() const noexcept;
+    std::size_t unplanned_bytes() const noexcept;
+    // bytes of the workspace of the convolutions, grown by the first run
+    std::size_t workspace_bytes() const noexcept;
+
+    std::vector<node_profile> profile() const;
+    void reset_profile() noexcept;
+
+    // table of the nodes with their timings, followed by the planned memory
+    std::string report() const;
+
+  private:
+    struct state;
+    std::unique_ptr<state> p_state;
+  };
+
+}  // namespace covdel::nn
+
+#endif
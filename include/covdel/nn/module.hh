@@ -0,0 +1,136 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_NN_MODULE_HH_1703004218__
+#define __COVDEL_INCLUDE_COVDEL_NN_MODULE_HH_1703004218__
+
+#include "covdel/nn/tensor.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace covdel::nn
+{
+  // layer of a network, whose forward pass is any composition of tensor operations, so
+  // that it is differentiated by the tape, and traced into a graph by graph.hh
+  class module {
+  public:
+    virtual ~module() = default;
+
+    virtual tensor forward(const tensor &input) = 0;
+    tensor operator()(const tensor &input) { return forward(input); }
+
+    // trainable tensors of this module and of those it holds
+    virtual std::vector<tensor> parameters() const { return {}; }
+    void zero_grad();
+  };
+
+  // seeds the generator which initializes the parameters of new modules on the calling
+  // thread, so that they are reproducible
+  void manual_seed(std::uint32_t seed) noexcept;
+
+  // x w + b over the last axis of the input, w of shape (in, out), initialized uniformly
+  // within 1 / sqrt(in)
+  class linear final : public module {
+  public:
+    linear(std::size_t in, std::size_t out, bool bias = true);
+
+    tensor forward(const tensor &input) override;
+    std::vector<tensor> parameters() const override;
+
+    tensor weight, bias;
+  };
+
+  // conv2d of conv.hh with a weight of shape (out, in / groups, kernel height, kernel
+  // width) and a bias per filter, initialized uniformly within 1 / sqrt(fan in)
+  class convolution final : public module {
+  public:
+    convolution(std::size_t in, std::size_t out, std::array<std::size_t, 2> kernel,
+      const conv2d_params &params = {}, bool bias = true);
+
+    tensor forward(const tensor &input) override;
+    std::vector<tensor> parameters() const override;
+
+    tensor weight, bias;
+    conv2d_params params;
+  };
+
+  enum class activation { relu, sigmoid };
+
+  class activation_layer final : public module {
+  public:
+    explicit activation_layer(activation kind) noexcept;
+
+    tensor forward(const tensor &input) override;
+
+    activation kind;
+  };
+
+  // x * scale + shift per channel, a batch normalization folded for inference, channels
+  // along the axis after the batch, or the last one for nhwc inputs
+  class affine final : public module {
+  public:
+    explicit affine(std::size_t channels, layout format = layout::nchw);
+
+    tensor forward(const tensor &input) override;
+    std::vector<tensor> parameters() const override;
+
+    tensor scale, shift;
+    layout format;
+  };
+
+  // modules applied in turn
+  class sequential final : public module {
+  public:
+    // appends a module constructed in place, returning it
+    template<typename _Module, typename... _Args>
+    _Module &add(_Args &&...args)
+    {
+      auto layer { std::make_unique<_Module>(std::forward<_Args>(args)...) };
+      _Module &out { *layer };
+      m_layers.push_back(std::move(layer));
+      return out;
+    }
+
+    tensor forward(const tensor &input) override;
+    std::vector<tensor> parameters() const override;
+
+  private:
+    std::vector<std::unique_ptr<module>> m_layers;
+  };
+
+  // x + f(x), over a body which keeps the shape of its input
+  class residual final : public module {
+  public:
+    explicit residual(std::unique_ptr<module> body) noexcept;
+
+    tensor forward(const tensor &input) override;
+    std::vector<tensor> parameters() const override;
+
+    module &body() noexcept { return *p_body; }
+
+  private:
+    std::unique_ptr<module> p_body;
+  };
+
+}  // namespace covdel::nn
+
+#endif
@@ -0,0 +1,145 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_NN_TENSOR_HH_1702913650__
+#define __COVDEL_INCLUDE_COVDEL_NN_TENSOR_HH_1702913650__
+
+#include "covdel/ma/factory.hh"
+#include "covdel/nn/conv.hh"
+
+#include <memory>
+#include <vector>
+
+namespace covdel::nn
+{
+  namespace detail
+  {
+    struct node;
+  }
+
+  // float32 array which records the operations it goes through, so that `backward`
+  // computes the gradients of a result with respect to every tensor it came from which
+  // requires them. Copies of a tensor share its value and its gradient.
+  //
+  // Operations are recorded only when one of their operands requires gradients and
+  // gradients are enabled on the calling thread, otherwise they cost as much as the
+  // array operation itself. `backward` runs the recorded operations in reverse order of
+  // their creation, and frees each one, along with the arrays it kept, as soon as it has
+  // passed its gradient on, so that a second backward pass through the same operations
+  // throws. Gradients of leaves are added in place onto those of earlier passes, until
+  // cleared with `zero_grad`.
+  class tensor {
+  public:
+    tensor();
+    // leaf over the array, sharing its buffer
+    tensor(const ma::float32 &value, bool requires_grad = false);
+
+    const ma::float32 &value() const noexcept;
+    // the value of a leaf may be updated in place, such as by an optimizer step, which
+    // operations recorded before then do not see
+    ma::float32 &value() noexcept;
+    const ma::dimension &dim() const noexcept;
+
+    bool requires_grad() const noexcept;
+    // leaves only, the gradients of results follow those of their operands
+    tensor &set_requires_grad(bool requires = true);
+    bool is_leaf() const noexcept;
+
+    // accumulated gradient, an empty array of dimension (0) until the first backward
+    // pass reaches this tensor, which only happens for leaves
+    const ma::float32 &grad() const noexcept;
+    // zeroes the gradient in place, keeping its buffer for the next pass
+    void zero_grad() noexcept;
+
+    // gradients of this tensor, of a single element, with respect to the leaves
+    void backward();
+    // vector-jacobian product of `grad`, of the shape of this tensor
+    void backward(const ma::float32 &grad);
+
+    // the same value, recording nothing further
+    tensor detach() const;
+
+  private:
+    std::shared_ptr<detail::node> p_node;
+
+    explicit tensor(std::shared_ptr<detail::node> node) noexcept;
+
+    friend struct detail::node;
+  };
+
+  // whether operations on the calling thread are recorded
+  bool grad_enabled() noexcept;
+
+  // disables recording on the calling thread for its scope, for inference and for
+  // parameter updates, restoring the previous state when it ends
+  class no_grad {
+  public:
+    no_grad() noexcept;
+    no_grad(const no_grad &) = delete;
+    no_grad &operator=(const no_grad &) = delete;
+    ~no_grad() noexcept;
+
+  private:
+    bool m_previous;
+  };
+
+  // differentiable operations, returning new tensors. Element-wise operands broadcast
+  // against each other as in `ma`, and their gradients are summed back over the
+  // broadcast axes.
+  tensor add(const tensor &a, const tensor &b);
+  tensor subtract(const tensor &a, const tensor &b);
+  tensor multiply(const tensor &a, const tensor &b);
+  tensor divide(const tensor &a, const tensor &b);
+  tensor add(const tensor &a, float b);
+  tensor multiply(const tensor &a, float b);
+
+  tensor negative(const tensor &a);
+  tensor exp(const tensor &a);
+  tensor log(const tensor &a);
+  tensor sqrt(const tensor &a);
+  tensor relu(const tensor &a);
+  tensor sigmoid(const tensor &a);
+
+  // reductions over every element, to a tensor of dimension (1), or along axes
+  tensor sum(const tensor &a);
+  tensor sum(const tensor &a, const std::vector<int> &axes, bool keepdims = false);
+  tensor mean(const tensor &a);
+  tensor mean(const tensor &a, const std::vector<int> &axes, bool keepdims = false);
+
+  // product of matrices, or of stacks of them, the leading axes of `a` and `b` being the
+  // same, or `b` being a single matrix which multiplies every one of `a`
+  tensor matmul(const tensor &a, const tensor &b);
+
+  // conv2d of conv.hh, with an optional bias which may be an empty tensor
+  tensor conv2d(const tensor &input, const tensor &weight, const tensor &bias,
+    const conv2d_params &params = {});
+  tensor conv2d(const tensor &input, const tensor &weight, const conv2d_params &params = {});
+
+  inline tensor operator+(const tensor &a, const tensor &b) { return add(a, b); }
+  inline tensor operator-(const tensor &a, const tensor &b) { return subtract(a, b); }
+  inline tensor operator*(const tensor &a, const tensor &b) { return multiply(a, b); }
+  inline tensor operator/(const tensor &a, const tensor &b) { return divide(a, b); }
+  inline tensor operator-(const tensor &a) { return negative(a); }
+  inline tensor operator+(const tensor &a, const float b) { return add(a, b); }
+  inline tensor operator-(const tensor &a, const float b) { return add(a, -b); }
+  inline tensor operator*(const tensor &a, const float b) { return multiply(a, b); }
+  inline tensor operator*(const float a, const tensor &b) { return multiply(b, a); }
+
+}  // namespace covdel::nn
+
+#endif
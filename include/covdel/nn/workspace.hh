@@ -0,0 +1,60 @@
+// Copyright (C) 2022 Dasu Pradyumna
+//
+// This file is part of CoVDeL.
+//
+// CoVDeL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// CoVDeL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with CoVDeL.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef __COVDEL_INCLUDE_COVDEL_NN_WORKSPACE_HH_1702561187__
+#define __COVDEL_INCLUDE_COVDEL_NN_WORKSPACE_HH_1702561187__
+
+#include "covdel/ma/allocator.hh"
+
+#include <cstddef>
+
+namespace covdel::nn
+{
+  // memory for the temporaries of layers, such as im2col columns, which only grows to
+  // the largest request and is kept across calls, so that a stream of inputs of the same
+  // shapes allocates nothing once warmed up. A workspace serves one operation at a time,
+  // and memory it handed out stays valid until the next `reserve`.
+  class workspace {
+  public:
+    explicit workspace(ma::allocator &alloc = ma::aligned_allocator::instance()) noexcept;
+    workspace(const workspace &) = delete;
+    workspace &operator=(const workspace &) = delete;
+    ~workspace() noexcept;
+
+    // at least `bytes` of memory aligned to 64 bytes, of unspecified contents
+    void *reserve(std::size_t bytes);
+    // returns the memory to the allocator
+    void release() noexcept;
+
+    std::size_t capacity() const noexcept;
+    // number of times the memory had to grow, flat once warmed up
+    std::size_t allocations() const noexcept;
+
+  private:
+    ma::allocator *p_alloc;
+    void *p_data;
+    std::size_t m_capacity;
+    std::size_t m_allocations;
+  };
+
+  // workspace of the calling thread, used by layers unless given another one
+  workspace &default_workspace() noexcept;
+
+}  // namespace covdel::nn
+
+#endif
@@ -0,0 +1,249 @@
+#include "formats.hh"
+
+#include "ma/files.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace covdel::cv::detail
+{
+  using ma::detail::read_le;
+  using ma::detail::write_le;
+
+  namespace
+  {
+    constexpr uint32_t RGB { 0 }, BITFIELDS { 3 }, ALPHA_BITFIELDS { 6 };
+
+    // a channel within the pixels of 16 or 32 bits, scaled up from its width
+    struct field {
+      uint32_t mask;
+      int shift;
+      uint32_t max;
+
+      field() noexcept : mask {}, shift {}, max {} { }
+
+      explicit field(const uint32_t m) noexcept : mask { m }, shift {}, max {}
+      {
+        if (!mask) return;
+        while (!(mask >> shift & 1)) ++shift;
+        max = mask >> shift;
+      }
+
+      uint8_t operator()(const uint32_t pixel) const noexcept
+      {
+        return uint8_t(((pixel & mask) >> shift) * 255 / max);
+      }
+    };
+
+    struct bmp_info {
+      size_t width, height, channels;
+      bool bottom_up;
+      int bits;
+      size_t pixels, row;  // offset of the first stored row, and bytes between rows
+      std::array<field, 4> fields;
+      bool gray;
+      std::array<std::array<uint8_t, 3>, 256> palette;
+    };
+
+    bmp_info parse(const char *bytes, const size_t length)
+    {
+      if (length < 26 || bytes[0] != 'B' || bytes[1] != 'M')
+        malformed("bmp", "bad signature");
+      bmp_info info {};
+      info.pixels = read_le(bytes + 10, 4);
+      const size_t header { read_le(bytes + 14, 4) };
+      if (header != 12 && (header < 40 || header > 124))
+        malformed("bmp", "unknown header");
+      if (14 + header > length) malformed("bmp", "truncated header");
+
+      // os/2 headers hold 16-bit extents and 3-byte palette entries
+      int64_t width, height;
+      uint32_t compression { RGB }, colors { 0 };
+      if (header == 12) {
+        width = int64_t(read_le(bytes + 18, 2));
+        height = int64_t(read_le(bytes + 20, 2));
+        info.bits = int(read_le(bytes + 24, 2));
+      } else {
+        width = int32_t(read_le(bytes + 18, 4));
+        height = int32_t(read_le(bytes + 22, 4));
+        info.bits = int(read_le(bytes + 28, 2));
+        compression = uint32_t(read_le(bytes + 30, 4));
+        colors = uint32_t(read_le(bytes + 46, 4));
+      }
+      if (width <= 0 || height == 0) malformed("bmp", "empty image");
+      info.width = size_t(width);
+      info.height = size_t(height < 0 ? -height : height);
+      info.bottom_up = height > 0;
+
+      const int bits { info.bits };
+      const bool masked { compression == BITFIELDS || compression == ALPHA_BITFIELDS };
+      if (compression != RGB && !(masked && (bits == 16 || bits == 32)))
+        throw std::invalid_argument { "unsupported bmp compression "
+                                      + std::to_string(compression) };
+      if (bits != 1 && bits != 4 && bits != 8 && bits != 16 && bits != 24 && bits != 32)
+        malformed("bmp", "bad bit count");
+
+      info.row = (size_t(bits) * info.width + 31) / 32 * 4;
+      if (info.pixels > length || (length - info.pixels) / info.row < info.height)
+        malformed("bmp", "truncated pixels");
+
+      // masks follow the basic header, or belong to the later ones
+      size_t table { 14 + header };
+      if (masked) {
+        const size_t count { compression == ALPHA_BITFIELDS ? size_t(4) : 3 };
+        const size_t at { header == 40 ? table : 54 };
+        if (header == 40) table += 4 * count;
+        if (at + 4 * (header >= 56 ? 4 : count) > length)
+          malformed("bmp", "truncated masks");
+        for (size_t c { 0 }; c < (header >= 56 ? 4 : count); ++c)
+          info.fields[c] = field { uint32_t(read_le(bytes + at + 4 * c, 4)) };
+      } else if (bits == 16) {
+        info.fields = { field { 0x7C00 }, field { 0x03E0 }, field { 0x001F }, field {} };
+      }
+      const auto &f { info.fields };
+      if ((bits == 16 || masked) && !(f[0].mask && f[1].mask && f[2].mask))
+        malformed("bmp", "empty colour mask");
+      if (bits == 16 || bits == 32) info.channels = info.fields[3].mask ? 4 : 3;
+      if (bits == 24 || (bits == 32 && !masked)) info.channels = 3;
+
+      if (bits <= 8) {
+        const size_t entry { header == 12 ? size_t(3) : 4 }, limit { size_t(1) << bits };
+        const size_t count { colors && colors < limit ? size_t(colors) : limit };
+        if (table + entry * count > length) malformed("bmp", "truncated palette");
+        info.gray = true;
+        for (size_t i { 0 }; i < count; ++i) {
+          const auto *e { reinterpret_cast<const uint8_t *>(bytes + table + entry * i) };
+          info.palette[i] = { e[2], e[1], e[0] };
+          info.gray &= e[0] == e[1] && e[1] == e[2];
+        }
+        info.channels = info.gray ? 1 : 3;
+      }
+      return info;
+    }
+
+  }  // namespace
+
+  image_header bmp_header(const char *bytes, const size_t length)
+  {
+    const auto info { parse(bytes, length) };
+    return { image_format::bmp,
+      ma::dimension { info.height, info.width, info.channels } };
+  }
+
+  void bmp_decode(const char *bytes, const size_t length, uint8_t *out,
+    const ptrdiff_t row_stride)
+  {
+    const auto info { parse(bytes, length) };
+    const size_t width { info.width };
+    const auto &[r, g, b, a] { info.fields };
+    const bool standard { r.mask == 0xFF0000 && g.mask == 0xFF00 && b.mask == 0xFF };
+
+    for (size_t y { 0 }; y < info.height; ++y, out += row_stride) {
+      const auto *src { reinterpret_cast<const uint8_t *>(
+        bytes + info.pixels + (info.bottom_up ? info.height - 1 - y : y) * info.row) };
+      switch (info.bits) {
+      case 24:
+        for (size_t x { 0 }; x < width; ++x, src += 3)
+          out[3 * x] = src[2], out[3 * x + 1] = src[1], out[3 * x + 2] = src[0];
+        break;
+
+      case 32:
+        if (info.channels == 3 && (!r.mask || standard)) {
+          for (size_t x { 0 }; x < width; ++x, src += 4)
+            out[3 * x] = src[2], out[3 * x + 1] = src[1], out[3 * x + 2] = src[0];
+          break;
+        }
+        if (standard && a.mask == 0xFF000000) {
+          for (size_t x { 0 }; x < width; ++x, src += 4)
+            out[4 * x] = src[2], out[4 * x + 1] = src[1], out[4 * x + 2] = src[0],
+                    out[4 * x + 3] = src[3];
+          break;
+        }
+        [[fallthrough]];
+
+      case 16: {
+        const size_t step { size_t(info.bits) / 8 }, channels { info.channels };
+        for (size_t x { 0 }; x < width; ++x) {
+          const auto *at { reinterpret_cast<const char *>(src + step * x) };
+          const auto pixel { uint32_t(read_le(at, int(step))) };
+          uint8_t *p { out + channels * x };
+          p[0] = r(pixel), p[1] = g(pixel), p[2] = b(pixel);
+          if (channels == 4) p[3] = a(pixel);
+        }
+        break;
+      }
+
+      default: {
+        // indices are packed from the high bits of each byte
+        const int bits { info.bits }, per_byte { 8 / bits };
+        const unsigned mask { (1U << bits) - 1 };
+        for (size_t x { 0 }; x < width; ++x) {
+          const unsigned shift { unsigned(8 - bits - bits * int(x % size_t(per_byte))) };
+          const auto &color { info.palette[src[x / size_t(per_byte)] >> shift & mask] };
+          if (info.gray)
+            out[x] = color[0];
+          else
+            std::memcpy(out + 3 * x, color.data(), 3);
+        }
+      }
+      }
+    }
+  }
+
+  // 8-bit gray palettes, 24-bit rgb, and 32-bit rgba in a v4 header, stored bottom-up
+  void bmp_encode(std::ostream &out, const ma::uint8 &image)
+  {
+    const size_t height { image.dim()[0] }, width { image.dim()[1] };
+    const size_t channels { image.dim()[2] };
+    const size_t bits { channels == 1 ? size_t(8) : 8 * channels };
+    const size_t header { channels == 4 ? size_t(108) : 40 };
+    const size_t palette { channels == 1 ? size_t(1024) : 0 };
+    const size_t row { (bits * width + 31) / 32 * 4 }, pixels { 14 + header + palette };
+    if (height > 0x7FFFFFFF || width > 0x7FFFFFFF || row * height > 0xFFFFFFFF - pixels)
+      throw std::invalid_argument { "image too large for a bmp file" };
+
+    std::string head { "BM" };
+    write_le(head, pixels + row * height, 4);
+    write_le(head, 0, 4);
+    write_le(head, pixels, 4);
+    write_le(head, header, 4);
+    write_le(head, width, 4);
+    write_le(head, height, 4);
+    write_le(head, 1, 2);
+    write_le(head, bits, 2);
+    write_le(head, channels == 4 ? BITFIELDS : RGB, 4);
+    write_le(head, row * height, 4);
+    write_le(head, 2835, 4);  // 72 dpi
+    write_le(head, 2835, 4);
+    write_le(head, channels == 1 ? 256 : 0, 4);
+    write_le(head, 0, 4);
+    if (channels == 4) {
+      for (const uint32_t mask : { 0xFF0000U, 0xFF00U, 0xFFU, 0xFF000000U })
+        write_le(head, mask, 4);
+      write_le(head, 0x73524742, 4);  // 'sRGB'
+      head.append(48, '\0');
+    }
+    for (size_t i { 0 }; i < palette / 4; ++i) write_le(head, i * 0x010101, 4);
+    out.write(head.data(), std::streamsize(head.size()));
+
+    const auto scratch { std::make_unique<uint8_t[]>(width * channels) };
+    const auto stored { std::make_unique<uint8_t[]>(row) };
+    std::fill_n(stored.get(), row, uint8_t(0));
+    for (size_t y { height }; y-- > 0;) {
+      const uint8_t *src { image_row(image, y, scratch.get()) };
+      if (channels == 1) {
+        std::memcpy(stored.get(), src, width);
+      } else {
+        uint8_t *dst { stored.get() };
+        for (size_t x { 0 }; x < width; ++x, src += channels, dst += channels) {
+          dst[0] = src[2], dst[1] = src[1], dst[2] = src[0];
+          if (channels == 4) dst[3] = src[3];
+        }
+      }
+      out.write(reinterpret_cast<const char *>(stored.get()), std::streamsize(row));
+    }
+  }
+
+}  // namespace covdel::cv::detail
@@ -0,0 +1,363 @@
+#include "covdel/cv/color.hh"
+
+#include "color_kernels.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+#include "image.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace covdel::cv
+{
+  const detail::color_table &detail::converters() noexcept
+  {
+    static const auto s_tables { [] {
+      std::array<color_table, 4> tables {};
+      scalar::fill(tables[int(ma::isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+      sse2::fill(tables[int(ma::isa::sse2)]);
+      avx2::fill(tables[int(ma::isa::avx2)]);
+      avx512::fill(tables[int(ma::isa::avx512)]);
+#endif
+      return tables;
+    }() };
+    return s_tables[int(ma::active_isa())];
+  }
+
+  namespace
+  {
+    using std::ptrdiff_t;
+    using std::size_t;
+    using std::uint8_t;
+    using detail::extent;
+    using detail::image;
+
+    bool subsampled(const color space) noexcept
+    {
+      return space == color::yuv420p || space == color::nv12 || space == color::yuyv;
+    }
+
+    size_t channels_of(const color space) noexcept
+    {
+      return space == color::gray ? 1 : space == color::yuyv ? 2 : 3;
+    }
+
+    // sample units of a format in a datatype, as multiples of the [0, 255] of the planes
+    template<typename _Type>
+    std::array<float, 3> units(const color space) noexcept
+    {
+      constexpr bool bytes { std::is_same_v<_Type, uint8_t> };
+      const float unit { bytes ? 1.0F : 1.0F / 255 };
+      if (space == color::hsv) return { bytes ? 0.5F : 1.0F, unit, unit };
+      return { unit, unit, unit };
+    }
+
+    // samples of an image in a format, where subsampled formats keep the size of their
+    // luma and the strides of the array
+    template<typename _DType>
+    auto samples(const ma::multiarray<_DType> &array, const pixel_format format)
+    {
+      using native = typename ma::multiarray<_DType>::native_type;
+      const auto [height, width] { detail::color_size(array.dim(), format) };
+      const auto &s { array.strides() };
+      auto *data { const_cast<native *>(array.data()) };
+      if (array.ndims() == 2)
+        return image<native> { data, height, width, 1, s[0], s[1], 1 };
+      if (format.layout == packing::planar && !subsampled(format.space))
+        return image<native> { data, height, width, array.dim()[0], s[1], s[2], s[0] };
+      return image<native> { data, height, width, array.dim()[2], s[0], s[1], s[2] };
+    }
+
+    template<typename _In, typename _Out>
+    struct color_job {
+      image<const _In> src;
+      image<_Out> dst;
+      color from, to;
+      std::array<float, 3> scale, shift;  // of the destination channels
+      bool direct;  // rgb planes are decoded straight into the destination rows
+    };
+
+    // rows of rgb planes of each thread, grown to the widest image converted
+    float *planes_of(const size_t count) noexcept
+    {
+      thread_local std::vector<float> s_planes {};
+      if (s_planes.size() < count) s_planes.resize(count);
+      return s_planes.data();
+    }
+
+    // decodes row `y` of the source into rgb planes, through `scale` and `shift` which are
+    // identities unless rgb, bgr, gray and subsampled sources are decoded straight into
+    // their destination
+    template<typename _In, typename _Out>
+    void decode(const color_job<_In, _Out> &job, const size_t y, float *const *rgb,
+      const float *scale, const float *shift)
+    {
+      const auto &ops { detail::converters() };
+      const auto &src { job.src };
+      const _In *row { src.data + ptrdiff_t(y) * src.row };
+      const auto load = [&](const _In *const *in, const float *a) {
+        if constexpr (std::is_same_v<_In, uint8_t>)
+          ops.load_u8(in, src.pixel, 3, a, shift, rgb, src.width);
+        else
+          ops.load_f32(in, src.pixel, 3, a, shift, rgb, src.width);
+      };
+
+      if (!subsampled(job.from)) {
+        const auto unit { units<_In>(job.from) };
+        const float a[3] { scale[0] / unit[0], scale[1] / unit[1], scale[2] / unit[2] };
+        const ptrdiff_t c { src.channel };
+        if (job.from == color::gray) {
+          const _In *in[3] { row, row, row };
+          load(in, a);
+        } else {
+          const bool swap { job.from == color::bgr };
+          const _In *in[3] { row + (swap ? 2 * c : 0), row + c, row + (swap ? 0 : 2 * c) };
+          load(in, a);
+        }
+        if (job.from == color::hsv) ops.hsv_to_rgb(rgb, src.width);
+        if (job.from == color::yuv) ops.yuv_to_rgb(rgb, src.width);
+        return;
+      }
+
+      if constexpr (std::is_same_v<_In, uint8_t>) {
+        if (job.from == color::yuyv) {
+          const uint8_t *u { row + src.channel }, *v { u + src.pixel };
+          ops.yuv420_to_rgb(row, src.pixel, u, v, 2 * src.pixel, scale, shift, rgb,
+            src.width);
+        } else if (job.from == color::nv12) {
+          const uint8_t *uv { src.data + ptrdiff_t(src.height + y / 2) * src.row };
+          ops.yuv420_to_rgb(row, src.pixel, uv, uv + src.pixel, 2 * src.pixel, scale,
+            shift, rgb, src.width);
+        } else {
+          // contiguous planes of a quarter of the luma each
+          const size_t quarter { src.height * src.width / 4 }, half { src.width / 2 };
+          const uint8_t *u { src.data + src.height * src.width + y / 2 * half };
+          ops.yuv420_to_rgb(row, 1, u, u + quarter, 1, scale, shift, rgb, src.width);
+        }
+      }
+    }
+
+    // encodes rgb planes into row `y` of a destination which is not subsampled
+    template<typename _In, typename _Out>
+    void encode(const color_job<_In, _Out> &job, const size_t y, float *const *rgb)
+    {
+      const auto &ops { detail::converters() };
+      const auto &dst { job.dst };
+      _Out *row { dst.data + ptrdiff_t(y) * dst.row };
+      const ptrdiff_t c { dst.channel };
+      const auto store = [&](const float *const *planes, const size_t channels,
+                           _Out *const *out) {
+        if constexpr (std::is_same_v<_Out, uint8_t>)
+          ops.store_u8(planes, channels, job.scale.data(), job.shift.data(), out,
+            dst.pixel, dst.width);
+        else
+          ops.store_f32(planes, channels, job.scale.data(), job.shift.data(), out,
+            dst.pixel, dst.width);
+      };
+
+      if (job.to == color::gray) {
+        ops.rgb_to_gray(rgb, rgb[0], dst.width);
+        _Out *out[1] { row };
+        store(rgb, 1, out);
+        return;
+      }
+      if (job.to == color::hsv) ops.rgb_to_hsv(rgb, dst.width);
+      if (job.to == color::yuv) ops.rgb_to_yuv(rgb, dst.width);
+      const bool swap { job.to == color::bgr };
+      const float *planes[3] { rgb[swap ? 2 : 0], rgb[1], rgb[swap ? 0 : 2] };
+      _Out *out[3] { row, row + c, row + 2 * c };
+      store(planes, 3, out);
+    }
+
+    // luma of row `y`, and chroma of the pair of rows from `y` down for yuv420p and nv12,
+    // or of the row itself for yuyv
+    template<typename _In>
+    void encode_subsampled(const color_job<_In, uint8_t> &job, const size_t y,
+      float *const *top, float *const *bottom)
+    {
+      const auto &ops { detail::converters() };
+      const auto &dst { job.dst };
+      const auto luma = [&](const size_t at, const float *const *rgb) {
+        ops.rgb_to_luma(rgb, dst.data + ptrdiff_t(at) * dst.row, dst.pixel, dst.width);
+      };
+      luma(y, top);
+      if (job.to == color::yuyv) {
+        uint8_t *row { dst.data + ptrdiff_t(y) * dst.row };
+        ops.rgb_to_chroma(top, top, row + dst.channel, row + dst.pixel + dst.channel,
+          2 * dst.pixel, dst.width);
+        return;
+      }
+      luma(y + 1, bottom);
+      if (job.to == color::nv12) {
+        uint8_t *uv { dst.data + ptrdiff_t(dst.height + y / 2) * dst.row };
+        ops.rgb_to_chroma(top, bottom, uv, uv + dst.pixel, 2 * dst.pixel, dst.width);
+      } else {
+        const size_t quarter { dst.height * dst.width / 4 }, half { dst.width / 2 };
+        uint8_t *u { dst.data + dst.height * dst.width + y / 2 * half };
+        ops.rgb_to_chroma(top, bottom, u, u + quarter, 1, dst.width);
+      }
+    }
+
+    // steps of `rows` rows, 2 when either side subsamples chroma across rows
+    template<typename _In, typename _Out>
+    void convert_rows(const color_job<_In, _Out> &job, const size_t rows,
+      const size_t begin, const size_t end)
+    {
+      const size_t width { job.src.width };
+      float *scratch { planes_of(6 * width) };
+      float *const rgb[2][3] { { scratch, scratch + width, scratch + 2 * width },
+        { scratch + 3 * width, scratch + 4 * width, scratch + 5 * width } };
+      constexpr float identity[3] { 1, 1, 1 }, zeros[3] { 0, 0, 0 };
+
+      for (size_t step { begin }; step < end; ++step)
+        for (size_t k { 0 }; k < rows; ++k) {
+          const size_t y { step * rows + k };
+          if (job.direct) {
+            // planes of the destination in rgb order
+            auto &dst { job.dst };
+            _Out *row { dst.data + ptrdiff_t(y) * dst.row };
+            const bool swap { job.to == color::bgr };
+            const ptrdiff_t r { swap ? 2 : 0 }, b { swap ? 0 : 2 };
+            float *const planes[3] { reinterpret_cast<float *>(row + r * dst.channel),
+              reinterpret_cast<float *>(row + dst.channel),
+              reinterpret_cast<float *>(row + b * dst.channel) };
+            const float scale[3] { job.scale[size_t(r)], job.scale[1],
+              job.scale[size_t(b)] };
+            const float shift[3] { job.shift[size_t(r)], job.shift[1],
+              job.shift[size_t(b)] };
+            decode(job, y, planes, scale, shift);
+            continue;
+          }
+          decode(job, y, rgb[k], identity, zeros);
+          if constexpr (std::is_same_v<_Out, uint8_t>) {
+            if (job.to == color::yuyv) {
+              encode_subsampled(job, y, rgb[k], rgb[k]);
+              continue;
+            }
+            if (subsampled(job.to)) {
+              if (k == 1) encode_subsampled(job, y - 1, rgb[0], rgb[1]);
+              continue;
+            }
+          }
+          encode(job, y, rgb[k]);
+        }
+    }
+
+  }  // namespace
+
+  namespace detail
+  {
+    ma::dimension color_shape(const size_t height, const size_t width,
+      const pixel_format format)
+    {
+      if (format.space == color::yuv420p || format.space == color::nv12)
+        return ma::dimension(height * 3 / 2, width);
+      const size_t channels { channels_of(format.space) };
+      if (format.layout == packing::planar && format.space != color::yuyv)
+        return ma::dimension(channels, height, width);
+      return ma::dimension(height, width, channels);
+    }
+
+    std::array<size_t, 2> color_size(const ma::dimension &dim, const pixel_format format)
+    {
+      const auto fail = [&] {
+        return std::invalid_argument { "shape " + dim.str()
+                                       + " does not fit the colour format" };
+      };
+      const color space { format.space };
+      if (space == color::yuv420p || space == color::nv12) {
+        if (dim.ndims() != 2 || dim[0] % 3 != 0 || dim[1] % 2 != 0) throw fail();
+        return { dim[0] / 3 * 2, dim[1] };
+      }
+      if (space == color::gray && dim.ndims() == 2) return { dim[0], dim[1] };
+      if (dim.ndims() != 3) throw fail();
+      if (space == color::yuyv) {
+        if (dim[2] != 2 || dim[1] % 2 != 0) throw fail();
+      } else if (format.layout == packing::planar) {
+        if (dim[0] != channels_of(space)) throw fail();
+        return { dim[1], dim[2] };
+      } else if (dim[2] != channels_of(space)) {
+        throw fail();
+      }
+      return { dim[0], dim[1] };
+    }
+  }  // namespace detail
+
+  template<typename _InDType, typename _OutDType>
+  void convert_color(const ma::multiarray<_InDType> &source, const pixel_format from,
+    ma::multiarray<_OutDType> &destination, const pixel_format to,
+    const normalization &norm)
+  {
+    using in_type = typename ma::multiarray<_InDType>::native_type;
+    using out_type = typename ma::multiarray<_OutDType>::native_type;
+    constexpr bool bytes { std::is_same_v<out_type, uint8_t> };
+    if ((subsampled(from.space) && !std::is_same_v<in_type, uint8_t>)
+        || (subsampled(to.space) && !bytes))
+      throw std::invalid_argument { "yuv420p, nv12 and yuyv images are uint8" };
+    const normalization none {};
+    if (bytes && (norm.mean != none.mean || norm.std != none.std))
+      throw std::invalid_argument { "only float32 results are normalized" };
+    if (from.space == color::yuv420p && !source.is_contiguous())
+      throw std::invalid_argument { "yuv420p images must be contiguous" };
+    if (to.space == color::yuv420p && !destination.is_contiguous())
+      throw std::invalid_argument { "yuv420p images must be contiguous" };
+
+    auto in { samples(source, from) };
+    const auto out { samples(destination, to) };
+    if (in.height != out.height || in.width != out.width)
+      throw std::invalid_argument { "cannot convert an image of shape "
+                                    + source.dim().str() + " into one of shape "
+                                    + destination.dim().str() };
+    if (out.height == 0 || out.width == 0) return;
+
+    // overlapping arrays are converted from a copy, since rows of different formats and
+    // strides need not overlap row by row
+    std::optional<ma::multiarray<_InDType>> copy {};
+    const auto [in_low, in_high] { extent(detail::layout(source)) };
+    const auto [out_low, out_high] { extent(detail::layout(destination)) };
+    if (in_low < out_high && out_low < in_high) {
+      copy = source.copy();
+      in = samples(*copy, from);
+    }
+
+    color_job<in_type, out_type> job { { in.data, in.height, in.width, in.channels, in.row,
+                                         in.pixel, in.channel },
+      out, from.space, to.space, {}, {}, false };
+    const auto unit { units<out_type>(to.space) };
+    for (size_t c { 0 }; c < 3; ++c) {
+      job.scale[c] = unit[c] / norm.std[c];
+      job.shift[c] = -norm.mean[c] / norm.std[c];
+    }
+    job.direct = !bytes && (to.space == color::rgb || to.space == color::bgr)
+                 && out.pixel == 1 && from.space != color::hsv && from.space != color::yuv;
+
+    const bool pairs { to.space == color::yuv420p || to.space == color::nv12
+                       || from.space == color::yuv420p || from.space == color::nv12 };
+    const size_t rows { pairs ? 2U : 1U };
+    const size_t pixel_bytes { in.channels * sizeof(in_type)
+                               + out.channels * sizeof(out_type) };
+    const size_t row_bytes { rows * in.width * pixel_bytes };
+    const size_t grain { std::max<size_t>(ma::grain_size() / row_bytes, 1) };
+    ma::default_executor().parallel_for(out.height / rows, grain,
+      [&job, rows](size_t begin, size_t end) { convert_rows(job, rows, begin, end); });
+  }
+
+  /////////////////////////////// TEMPLATE INSTANTIATIONS ////////////////////////////////
+
+#define COLOR_INSTANTIATIONS(in, out)                                                    \
+ template void convert_color<in, out>(const ma::multiarray<in> &, const pixel_format,   \
+   ma::multiarray<out> &, const pixel_format, const normalization &);
+
+  COLOR_INSTANTIATIONS(ma::dtype::uint8, ma::dtype::uint8);
+  COLOR_INSTANTIATIONS(ma::dtype::uint8, ma::dtype::float32);
+  COLOR_INSTANTIATIONS(ma::dtype::float32, ma::dtype::uint8);
+  COLOR_INSTANTIATIONS(ma::dtype::float32, ma::dtype::float32);
+
+}  // namespace covdel::cv
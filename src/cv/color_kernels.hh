@@ -0,0 +1,63 @@
+#ifndef __COVDEL_SRC_CV_COLOR_KERNELS_HH_1701643402__
+#define __COVDEL_SRC_CV_COLOR_KERNELS_HH_1701643402__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace covdel::cv::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // inner loops of colour conversion over a row of `width` pixels, converting from and to
+  // rows of float samples of each channel, `planes`, which hold samples over [0, 255]
+  // and hue in degrees. Samples of a channel lie `step` elements apart.
+  struct color_table {
+    // planes[c][x] = in[c][x * step] * scale[c] + shift[c], for each of `channels`
+    void (*load_u8)(const std::uint8_t *const *in, ptrdiff_t step, size_t channels,
+      const float *scale, const float *shift, float *const *planes, size_t width);
+    void (*load_f32)(const float *const *in, ptrdiff_t step, size_t channels,
+      const float *scale, const float *shift, float *const *planes, size_t width);
+
+    // out[c][x * step] = planes[c][x] * scale[c] + shift[c], uint8 results rounded to
+    // nearest and saturated
+    void (*store_u8)(const float *const *planes, size_t channels, const float *scale,
+      const float *shift, std::uint8_t *const *out, ptrdiff_t step, size_t width);
+    void (*store_f32)(const float *const *planes, size_t channels, const float *scale,
+      const float *shift, float *const *out, ptrdiff_t step, size_t width);
+
+    // transforms of rgb planes in place, and the luma of gray into `out`, which may be
+    // the first of them
+    void (*rgb_to_yuv)(float *const *planes, size_t width);
+    void (*yuv_to_rgb)(float *const *planes, size_t width);
+    void (*rgb_to_hsv)(float *const *planes, size_t width);
+    void (*hsv_to_rgb)(float *const *planes, size_t width);
+    void (*rgb_to_gray)(const float *const *planes, float *out, size_t width);
+
+    // rgb planes of a row of subsampled limited range yuv, luma at y[x * y_step] and
+    // chroma at u[x / 2 * uv_step] and v[x / 2 * uv_step], through scale and shift as
+    // loads are, for an even `width`
+    void (*yuv420_to_rgb)(const std::uint8_t *y, ptrdiff_t y_step, const std::uint8_t *u,
+      const std::uint8_t *v, ptrdiff_t uv_step, const float *scale, const float *shift,
+      float *const *planes, size_t width);
+
+    // luma of a row of rgb planes, and chroma of its pairs of pixels averaged with those
+    // of the `bottom` row, which may be the same
+    void (*rgb_to_luma)(const float *const *planes, std::uint8_t *y, ptrdiff_t y_step,
+      size_t width);
+    void (*rgb_to_chroma)(const float *const *top, const float *const *bottom,
+      std::uint8_t *u, std::uint8_t *v, ptrdiff_t uv_step, size_t width);
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(color_table &table) noexcept; }
+  namespace sse2 { void fill(color_table &table) noexcept; }
+  namespace avx2 { void fill(color_table &table) noexcept; }
+  namespace avx512 { void fill(color_table &table) noexcept; }
+
+  // loops of the currently active instruction set level of the multiarray module
+  const color_table &converters() noexcept;
+
+}  // namespace covdel::cv::detail
+
+#endif
@@ -0,0 +1,336 @@
+// Row loops of colour conversion, compiled once per instruction set level as the filter
+// loops, see filter_kernels.inl. Every level computes the same operations in the same
+// order, so that results are identical across them.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "color_kernels.hh"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace covdel::cv::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+    using std::uint8_t;
+
+    // luma weights of BT.601, and the scales of the chroma of its full range
+    constexpr float KR { 0.299F }, KG { 0.587F }, KB { 0.114F };
+    constexpr float CB { 0.564F }, CR { 0.713F };
+
+    // limited range of BT.601, luma over [16, 235] and chroma over [16, 240]
+    constexpr float LY { 1.164384F }, LRV { 1.596027F }, LGU { 0.391762F };
+    constexpr float LGV { 0.812968F }, LBU { 2.017232F };
+    constexpr float YR { 0.256788F }, YG { 0.504129F }, YB { 0.097906F };
+    constexpr float UR { 0.148223F }, UG { 0.290993F }, UB { 0.439216F };
+    constexpr float VR { 0.439216F }, VG { 0.367788F }, VB { 0.071427F };
+
+    // runs a loop with the usual steps known at compile time, so that interleaved
+    // samples vectorize as such
+    template<typename _Loop>
+    void with_step(const ptrdiff_t step, const _Loop &loop)
+    {
+      switch (step) {
+        case 1: return loop(std::integral_constant<ptrdiff_t, 1> {});
+        case 2: return loop(std::integral_constant<ptrdiff_t, 2> {});
+        case 3: return loop(std::integral_constant<ptrdiff_t, 3> {});
+        case 4: return loop(std::integral_constant<ptrdiff_t, 4> {});
+        default: return loop(step);
+      }
+    }
+
+    uint8_t saturate(const float v) noexcept
+    {
+      return uint8_t(int(std::min(std::max(v, 0.0F), 255.0F) + 0.5F));
+    }
+
+    ////////////////////////////////////// PLANES ////////////////////////////////////////
+
+    // interleaved pixels of 3 channels are read and written whole, from the first
+    // channel in memory, so that they vectorize as groups
+    template<typename _Type>
+    bool interleaved(_Type *const *at, const ptrdiff_t step, const size_t channels,
+      int *order) noexcept
+    {
+      if (channels != 3 || step != 3) return false;
+      const _Type *first { std::min({ at[0], at[1], at[2] }) };
+      for (size_t c { 0 }; c < 3; ++c) {
+        order[c] = int(at[c] - first);
+        if (order[c] > 2) return false;
+      }
+      return order[0] != order[1] && order[1] != order[2] && order[0] != order[2];
+    }
+
+    template<typename _Type>
+    void load(const _Type *const *in, const ptrdiff_t step, const size_t channels,
+      const float *scale, const float *shift, float *const *planes, const size_t width)
+    {
+      int order[3];
+      if (interleaved(in, step, channels, order)) {
+        // planes and their affine maps by position in the pixel
+        const _Type *from { in[0] - order[0] };
+        float *to[3];
+        float a[3], b[3];
+        for (size_t c { 0 }; c < 3; ++c) {
+          to[order[c]] = planes[c];
+          a[order[c]] = scale[c];
+          b[order[c]] = shift[c];
+        }
+        float *to0 { to[0] }, *to1 { to[1] }, *to2 { to[2] };
+        for (size_t x { 0 }; x < width; ++x) {
+          to0[x] = float(from[3 * x]) * a[0] + b[0];
+          to1[x] = float(from[3 * x + 1]) * a[1] + b[1];
+          to2[x] = float(from[3 * x + 2]) * a[2] + b[2];
+        }
+        return;
+      }
+      with_step(step, [&](const auto s) {
+        for (size_t c { 0 }; c < channels; ++c) {
+          const _Type *from { in[c] };
+          float *to { planes[c] };
+          const float a { scale[c] }, b { shift[c] };
+          for (size_t x { 0 }; x < width; ++x)
+            to[x] = float(from[ptrdiff_t(x) * s]) * a + b;
+        }
+      });
+    }
+
+    template<typename _Type>
+    _Type sample(const float v) noexcept
+    {
+      if constexpr (std::is_same_v<_Type, uint8_t>)
+        return saturate(v);
+      else
+        return v;
+    }
+
+    template<typename _Type>
+    void store(const float *const *planes, const size_t channels, const float *scale,
+      const float *shift, _Type *const *out, const ptrdiff_t step, const size_t width)
+    {
+      int order[3];
+      if (interleaved(out, step, channels, order)) {
+        _Type *to { out[0] - order[0] };
+        const float *from[3];
+        float a[3], b[3];
+        for (size_t c { 0 }; c < 3; ++c) {
+          from[order[c]] = planes[c];
+          a[order[c]] = scale[c];
+          b[order[c]] = shift[c];
+        }
+        const float *from0 { from[0] }, *from1 { from[1] }, *from2 { from[2] };
+        for (size_t x { 0 }; x < width; ++x) {
+          to[3 * x] = sample<_Type>(from0[x] * a[0] + b[0]);
+          to[3 * x + 1] = sample<_Type>(from1[x] * a[1] + b[1]);
+          to[3 * x + 2] = sample<_Type>(from2[x] * a[2] + b[2]);
+        }
+        return;
+      }
+      with_step(step, [&](const auto s) {
+        for (size_t c { 0 }; c < channels; ++c) {
+          const float *from { planes[c] };
+          _Type *to { out[c] };
+          const float a { scale[c] }, b { shift[c] };
+          for (size_t x { 0 }; x < width; ++x)
+            to[ptrdiff_t(x) * s] = sample<_Type>(from[x] * a + b);
+        }
+      });
+    }
+
+    //////////////////////////////////// TRANSFORMS //////////////////////////////////////
+
+    void rgb_to_yuv(float *const *planes, const size_t width)
+    {
+      float *r { planes[0] }, *g { planes[1] }, *b { planes[2] };
+      for (size_t x { 0 }; x < width; ++x) {
+        const float y { KR * r[x] + KG * g[x] + KB * b[x] };
+        const float u { (b[x] - y) * CB + 128 }, v { (r[x] - y) * CR + 128 };
+        r[x] = y;
+        g[x] = u;
+        b[x] = v;
+      }
+    }
+
+    // the exact inverse of rgb_to_yuv
+    void yuv_to_rgb(float *const *planes, const size_t width)
+    {
+      constexpr float RV { 1 / CR }, BU { 1 / CB };
+      constexpr float GU { KB / CB / KG }, GV { KR / CR / KG };
+      float *py { planes[0] }, *pu { planes[1] }, *pv { planes[2] };
+      for (size_t x { 0 }; x < width; ++x) {
+        const float y { py[x] }, u { pu[x] - 128 }, v { pv[x] - 128 };
+        py[x] = y + RV * v;
+        pu[x] = y - GU * u - GV * v;
+        pv[x] = y + BU * u;
+      }
+    }
+
+    // hue by the sextant of the largest channel, without branches so that it vectorizes
+    void rgb_to_hsv(float *const *planes, const size_t width)
+    {
+      float *pr { planes[0] }, *pg { planes[1] }, *pb { planes[2] };
+      for (size_t x { 0 }; x < width; ++x) {
+        const float r { pr[x] }, g { pg[x] }, b { pb[x] };
+        const float v { std::max(std::max(r, g), b) };
+        const float d { v - std::min(std::min(r, g), b) };
+        // differences are all zero where d or v is, whatever they are divided by
+        const float sector { 60 / (d > 0 ? d : 1) };
+        float h { v == r ? (g - b) * sector : v == g ? (b - r) * sector + 120
+                                                     : (r - g) * sector + 240 };
+        h = h < 0 ? h + 360 : h;
+        pr[x] = h;
+        pg[x] = 255 * d / (v > 0 ? v : 1);
+        pb[x] = v;
+      }
+    }
+
+    // each channel is a piecewise linear function of the hue, v less a part of its
+    // saturation rising and falling over the sextants around it, which unlike a switch
+    // over them vectorizes
+    void hsv_to_rgb(float *const *planes, const size_t width)
+    {
+      float *ph { planes[0] }, *ps { planes[1] }, *pv { planes[2] };
+      const auto channel = [](const float n, const float h, const float chroma,
+                             const float v) {
+        float k { n + h };
+        k = k >= 6 ? k - 6 : k;
+        return v - chroma * std::max(std::min(std::min(k, 4 - k), 1.0F), 0.0F);
+      };
+      for (size_t x { 0 }; x < width; ++x) {
+        // hues wrapped into [0, 6) sextants
+        float h { ph[x] * (1.0F / 60) };
+        h -= 6 * float(int(h * (1.0F / 6)));
+        h = h < 0 ? h + 6 : h;
+        const float v { pv[x] }, chroma { v * ps[x] * (1.0F / 255) };
+        ph[x] = channel(5, h, chroma, v);
+        ps[x] = channel(3, h, chroma, v);
+        pv[x] = channel(1, h, chroma, v);
+      }
+    }
+
+    void rgb_to_gray(const float *const *planes, float *out, const size_t width)
+    {
+      const float *r { planes[0] }, *g { planes[1] }, *b { planes[2] };
+      for (size_t x { 0 }; x < width; ++x) out[x] = KR * r[x] + KG * g[x] + KB * b[x];
+    }
+
+    //////////////////////////////////// SUBSAMPLED //////////////////////////////////////
+
+    // pairs of pixels share their chroma, whose terms are computed first for blocks of
+    // pairs, so that both loops vectorize
+    template<typename _YStep, typename _UVStep>
+    void yuv420_pairs(const uint8_t *y, const _YStep ys, const uint8_t *u,
+      const uint8_t *v, const _UVStep uvs, const float *scale, const float *shift,
+      float *r, float *g, float *b, const size_t pairs)
+    {
+      constexpr size_t BLOCK { 64 };
+      const float ar { scale[0] }, ag { scale[1] }, ab { scale[2] };
+      const float br { shift[0] }, bg { shift[1] }, bb { shift[2] };
+      float dr[BLOCK], dg[BLOCK], db[BLOCK];
+      for (size_t first { 0 }; first < pairs; first += BLOCK) {
+        const size_t count { std::min(pairs - first, BLOCK) };
+        const uint8_t *cu { u + ptrdiff_t(first) * uvs };
+        const uint8_t *cv { v + ptrdiff_t(first) * uvs };
+        for (size_t i { 0 }; i < count; ++i) {
+          const float cb { float(cu[ptrdiff_t(i) * uvs]) - 128 };
+          const float cr { float(cv[ptrdiff_t(i) * uvs]) - 128 };
+          dr[i] = LRV * cr;
+          dg[i] = -LGU * cb - LGV * cr;
+          db[i] = LBU * cb;
+        }
+        const uint8_t *luma { y + ptrdiff_t(2 * first) * ys };
+        float *pr { r + 2 * first }, *pg { g + 2 * first }, *pb { b + 2 * first };
+        for (size_t i { 0 }; i < count; ++i) {
+          const float l0 { LY * (float(luma[ptrdiff_t(2 * i) * ys]) - 16) };
+          const float l1 { LY * (float(luma[ptrdiff_t(2 * i + 1) * ys]) - 16) };
+          pr[2 * i] = (l0 + dr[i]) * ar + br;
+          pr[2 * i + 1] = (l1 + dr[i]) * ar + br;
+          pg[2 * i] = (l0 + dg[i]) * ag + bg;
+          pg[2 * i + 1] = (l1 + dg[i]) * ag + bg;
+          pb[2 * i] = (l0 + db[i]) * ab + bb;
+          pb[2 * i + 1] = (l1 + db[i]) * ab + bb;
+        }
+      }
+    }
+
+    // the layouts of yuv420p, nv12 and yuyv are known at compile time, chroma of the last
+    // two interleaved so that it is read as pairs
+    void yuv420_to_rgb(const uint8_t *y, const ptrdiff_t y_step, const uint8_t *u,
+      const uint8_t *v, const ptrdiff_t uv_step, const float *scale, const float *shift,
+      float *const *planes, const size_t width)
+    {
+      using one = std::integral_constant<ptrdiff_t, 1>;
+      using two = std::integral_constant<ptrdiff_t, 2>;
+      using four = std::integral_constant<ptrdiff_t, 4>;
+      float *r { planes[0] }, *g { planes[1] }, *b { planes[2] };
+      const size_t pairs { width / 2 };
+      if (y_step == 1 && uv_step == 1)
+        yuv420_pairs(y, one {}, u, v, one {}, scale, shift, r, g, b, pairs);
+      else if (y_step == 1 && uv_step == 2 && v == u + 1)
+        yuv420_pairs(y, one {}, u, u + 1, two {}, scale, shift, r, g, b, pairs);
+      else if (y_step == 2 && uv_step == 4 && v == u + 2)
+        yuv420_pairs(y, two {}, u, u + 2, four {}, scale, shift, r, g, b, pairs);
+      else
+        yuv420_pairs(y, y_step, u, v, uv_step, scale, shift, r, g, b, pairs);
+    }
+
+    void rgb_to_luma(const float *const *planes, uint8_t *y, const ptrdiff_t y_step,
+      const size_t width)
+    {
+      with_step(y_step, [&](const auto s) {
+        const float *r { planes[0] }, *g { planes[1] }, *b { planes[2] };
+        uint8_t *to { y };
+        for (size_t x { 0 }; x < width; ++x)
+          to[ptrdiff_t(x) * s] = saturate(YR * r[x] + YG * g[x] + YB * b[x] + 16);
+      });
+    }
+
+    // means of the pairs are taken for blocks of them first, so that both loops vectorize
+    void rgb_to_chroma(const float *const *top, const float *const *bottom, uint8_t *u,
+      uint8_t *v, const ptrdiff_t uv_step, const size_t width)
+    {
+      constexpr size_t BLOCK { 64 };
+      const size_t pairs { width / 2 };
+      float means[3][BLOCK];
+      with_step(uv_step, [&](const auto s) {
+        for (size_t first { 0 }; first < pairs; first += BLOCK) {
+          const size_t count { std::min(pairs - first, BLOCK) };
+          for (size_t c { 0 }; c < 3; ++c) {
+            const float *above { top[c] + 2 * first }, *below { bottom[c] + 2 * first };
+            float *mean { means[c] };
+            for (size_t i { 0 }; i < count; ++i)
+              mean[i] = (above[2 * i] + above[2 * i + 1] + below[2 * i] + below[2 * i + 1])
+                        * 0.25F;
+          }
+          uint8_t *pu { u + ptrdiff_t(first) * s }, *pv { v + ptrdiff_t(first) * s };
+          for (size_t i { 0 }; i < count; ++i) {
+            const float r { means[0][i] }, g { means[1][i] }, b { means[2][i] };
+            pu[ptrdiff_t(i) * s] = saturate(UB * b - UR * r - UG * g + 128);
+            pv[ptrdiff_t(i) * s] = saturate(VR * r - VG * g - VB * b + 128);
+          }
+        }
+      });
+    }
+
+  }  // namespace
+
+  void fill(color_table &table) noexcept
+  {
+    table.load_u8 = load<uint8_t>;
+    table.load_f32 = load<float>;
+    table.store_u8 = store<uint8_t>;
+    table.store_f32 = store<float>;
+    table.rgb_to_yuv = rgb_to_yuv;
+    table.yuv_to_rgb = yuv_to_rgb;
+    table.rgb_to_hsv = rgb_to_hsv;
+    table.hsv_to_rgb = hsv_to_rgb;
+    table.rgb_to_gray = rgb_to_gray;
+    table.yuv420_to_rgb = yuv420_to_rgb;
+    table.rgb_to_luma = rgb_to_luma;
+    table.rgb_to_chroma = rgb_to_chroma;
+  }
+
+}  // namespace covdel::cv::detail::COVDEL_KERNEL_ISA
@@ -0,0 +1,2 @@
+#define COVDEL_KERNEL_ISA avx512
+#include "color_kernels.inl"
@@ -0,0 +1,440 @@
+#include "covdel/cv/filter.hh"
+
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+#include "filter_kernels.hh"
+#include "image.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace covdel::cv
+{
+  const detail::filter_table &detail::filters() noexcept
+  {
+    static const auto s_tables { [] {
+      std::array<filter_table, 4> tables {};
+      scalar::fill(tables[int(ma::isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+      sse2::fill(tables[int(ma::isa::sse2)]);
+      avx2::fill(tables[int(ma::isa::avx2)]);
+      avx512::fill(tables[int(ma::isa::avx512)]);
+#endif
+      return tables;
+    }() };
+    return s_tables[int(ma::active_isa())];
+  }
+
+  namespace
+  {
+    using std::ptrdiff_t;
+    using std::size_t;
+    using detail::extent;
+    using detail::image;
+    using detail::layout;
+    using detail::map_border;
+
+    /////////////////////////////////// FILTER SPECS /////////////////////////////////////
+
+    // separable filters run a row pass into a ring of filtered rows and a column pass over
+    // it, full ones keep the padded rows and run a row pass per kernel row, box filters
+    // keep running sums along the rows and down the columns
+    enum class stage { separable, full, box };
+
+    struct filter_spec {
+      stage kind;
+      int width, height;  // window
+      std::vector<float> kx, ky, kernel;
+      double scale;
+      border mode;
+      float value;
+
+      int ax() const noexcept { return (width - 1) / 2; }
+      int ay() const noexcept { return (height - 1) / 2; }
+    };
+
+    std::vector<float> taps(const ma::float32 &kernel, const char *name)
+    {
+      if (kernel.ndims() != 1 || kernel.size() == 0)
+        throw std::invalid_argument { std::string { name }
+                                      + " must be a non-empty 1-D kernel, got "
+                                      + kernel.dim().str() };
+      std::vector<float> values(kernel.size());
+      for (size_t i { 0 }; i < values.size(); ++i) values[i] = kernel(i);
+      return values;
+    }
+
+    bool symmetric(const std::vector<float> &k) noexcept
+    {
+      const size_t n { k.size() };
+      if (n % 2 == 0 || n == 1) return false;
+      for (size_t t { 0 }; t < n / 2; ++t)
+        if (k[t] != k[n - 1 - t]) return false;
+      return true;
+    }
+
+    filter_spec separable(std::vector<float> kx, std::vector<float> ky, const border mode,
+      const float value)
+    {
+      const int width { int(kx.size()) }, height { int(ky.size()) };
+      return { stage::separable, width, height, std::move(kx), std::move(ky), {}, 1, mode,
+        value };
+    }
+
+    // splits a kernel of rank one into the outer product of a column and a row through
+    // its largest element, to within float rounding
+    filter_spec split(const ma::float32 &kernel, const border mode, const float value)
+    {
+      if (kernel.ndims() != 2 || kernel.size() == 0)
+        throw std::invalid_argument { "kernel must be a non-empty 2-D array, got "
+                                      + kernel.dim().str() };
+      const size_t rows { kernel.dim()[0] }, columns { kernel.dim()[1] };
+      std::vector<float> k(rows * columns);
+      size_t pivot { 0 };
+      for (size_t i { 0 }; i < rows; ++i)
+        for (size_t j { 0 }; j < columns; ++j) {
+          k[i * columns + j] = kernel(i, j);
+          if (std::fabs(k[i * columns + j]) > std::fabs(k[pivot])) pivot = i * columns + j;
+        }
+
+      const size_t pr { pivot / columns }, pc { pivot % columns };
+      const double largest { std::fabs(k[pivot]) };
+      std::vector<float> kx(columns), ky(rows);
+      for (size_t j { 0 }; j < columns; ++j)
+        kx[j] = float(double(k[pr * columns + j]) / k[pivot]);
+      for (size_t i { 0 }; i < rows; ++i) ky[i] = k[i * columns + pc];
+      bool rank_one { largest > 0 };
+      for (size_t i { 0 }; i < rows && rank_one; ++i)
+        for (size_t j { 0 }; j < columns && rank_one; ++j)
+          rank_one = std::fabs(double(ky[i]) * kx[j] - k[i * columns + j]) <= 1e-6 * largest;
+      if (rank_one) return separable(std::move(kx), std::move(ky), mode, value);
+      return { stage::full, int(columns), int(rows), {}, {}, std::move(k), 1, mode, value };
+    }
+
+    ////////////////////////////////////// ENGINE ////////////////////////////////////////
+
+    template<typename _Out>
+    void column(const detail::filter_table &ops, const bool symmetric,
+      const float *const *rows, const float *k, const int taps, _Out *out,
+      const size_t count)
+    {
+      if constexpr (std::is_same_v<_Out, std::uint8_t>)
+        (symmetric ? ops.column_symmetric_u8 : ops.column_u8)(rows, k, taps, out, count);
+      else
+        (symmetric ? ops.column_symmetric : ops.column)(rows, k, taps, out, count);
+    }
+
+    // filters the output rows [begin, end), with a ring of the row pass results of the
+    // source rows they span, kept small enough to stay in the L1 or L2 cache
+    template<typename _In, typename _Out>
+    void filter_band(const filter_spec &f, const image<const _In> &src,
+      const image<_Out> &dst, const std::vector<ptrdiff_t> &pads, const size_t begin,
+      const size_t end)
+    {
+      const auto &ops { detail::filters() };
+      const size_t channels { src.channels }, count { src.width * channels };
+      const size_t padded_count { (src.width + size_t(f.width) - 1) * channels };
+      const size_t ax { size_t(f.ax()) };
+      const size_t slots { size_t(f.height) + (f.kind == stage::box) };
+      const size_t slot_count { f.kind == stage::full ? padded_count : count };
+      const bool sym_x { symmetric(f.kx) }, sym_y { symmetric(f.ky) };
+
+      // box sums read a pixel past the padded row, which they never keep
+      std::vector<float> padded(f.kind == stage::full ? 0 : padded_count + channels);
+      std::vector<float> ring(slots * slot_count);
+      // short box windows sum through the vectorized row pass, windows of uint8 samples
+      // whose sums stay below 2^24 are summed exactly in float
+      const bool box { f.kind == stage::box }, short_box { box && f.width <= 9 };
+      const bool exact { std::is_same_v<_In, std::uint8_t> && box
+        && double(f.width) * f.height * 255 < 16777216.0
+        && (f.mode != border::constant
+          || (f.value >= 0 && f.value <= 255 && f.value == std::floor(f.value))) };
+      const std::vector<float> ones(short_box ? size_t(f.width) : 0, 1.0F);
+      std::vector<double> sums(box && !exact ? count : 0);
+      std::vector<float> exact_sums(exact ? count : 0);
+      std::vector<float> acc(f.kind == stage::full ? count : 0);
+      std::vector<_Out> staged(dst.packed() ? 0 : count);
+      std::vector<const float *> rows(size_t(f.height));
+
+      const ptrdiff_t first { ptrdiff_t(begin) - f.ay() };
+      const auto slot = [&](const ptrdiff_t r) {
+        return ring.data() + size_t(r - first) % slots * slot_count;
+      };
+
+      // source row r, converted and padded with the border columns, then row filtered
+      const auto produce = [&](const ptrdiff_t r) {
+        float *row { f.kind == stage::full ? slot(r) : padded.data() };
+        const ptrdiff_t y { map_border(r, src.height, f.mode) };
+        if (y < 0) {
+          std::fill_n(row, padded_count, f.value);
+        } else {
+          const _In *in { src.data + y * src.row };
+          float *inner { row + ax * channels };
+          if constexpr (std::is_same_v<_In, std::uint8_t>)
+            if (src.packed()) ops.widen(in, inner, count);
+          if constexpr (std::is_same_v<_In, float>)
+            if (src.packed()) std::memcpy(inner, in, count * sizeof(float));
+          if (!src.packed())
+            for (size_t x { 0 }; x < src.width; ++x)
+              for (size_t c { 0 }; c < channels; ++c)
+                inner[x * channels + c] =
+                  float(in[ptrdiff_t(x) * src.pixel + ptrdiff_t(c) * src.channel]);
+
+          for (size_t j { 0 }; j < pads.size(); ++j) {
+            float *pad { row + (j < ax ? j : j + src.width) * channels };
+            for (size_t c { 0 }; c < channels; ++c)
+              pad[c] = pads[j] < 0 ? f.value : inner[size_t(pads[j]) * channels + c];
+          }
+        }
+
+        float *out { slot(r) };
+        if (f.kind == stage::separable) {
+          (sym_x ? ops.row_symmetric : ops.row)(row, f.kx.data(), f.width, channels, out,
+            count);
+        } else if (short_box) {
+          ops.row(row, ones.data(), f.width, channels, out, count);
+        } else if (box) {
+          ops.box_row(row, f.width, channels, out, count);
+        }
+      };
+
+      ptrdiff_t next { first };
+      const ptrdiff_t lead { ptrdiff_t(slots) - f.ay() };
+      for (size_t y { begin }; y < end; ++y) {
+        for (; next < ptrdiff_t(y) + lead; ++next) produce(next);
+        _Out *out { dst.packed() ? dst.data + ptrdiff_t(y) * dst.row : staged.data() };
+        const ptrdiff_t top { ptrdiff_t(y) - f.ay() };
+
+        if (f.kind == stage::separable) {
+          for (int t { 0 }; t < f.height; ++t) rows[size_t(t)] = slot(top + t);
+          column(ops, sym_y, rows.data(), f.ky.data(), f.height, out, count);
+        } else if (f.kind == stage::full) {
+          for (int t { 0 }; t < f.height; ++t)
+            (t ? ops.row_add : ops.row)(slot(top + t), f.kernel.data() + t * f.width,
+              f.width, channels, acc.data(), count);
+          if constexpr (std::is_same_v<_Out, std::uint8_t>)
+            ops.narrow(acc.data(), out, count);
+          else
+            std::memcpy(out, acc.data(), count * sizeof(float));
+        } else {
+          if (y == begin) {
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(exact_sums.begin(), exact_sums.end(), 0.0F);
+            for (int t { 0 }; t < f.height; ++t) {
+              const float *row { slot(top + t) };
+              if (exact)
+                for (size_t i { 0 }; i < count; ++i) exact_sums[i] += row[i];
+              else
+                for (size_t i { 0 }; i < count; ++i) sums[i] += row[i];
+            }
+          }
+          const float *add { slot(top + f.height) }, *sub { slot(top) };
+          if constexpr (std::is_same_v<_Out, std::uint8_t>) {
+            if (exact)
+              ops.box_exact_u8(exact_sums.data(), add, sub, f.scale, out, count);
+            else
+              ops.box_u8(sums.data(), add, sub, f.scale, out, count);
+          } else {
+            ops.box(sums.data(), add, sub, f.scale, out, count);
+          }
+        }
+
+        if (!dst.packed()) {
+          _Out *row { dst.data + ptrdiff_t(y) * dst.row };
+          for (size_t x { 0 }; x < dst.width; ++x)
+            for (size_t c { 0 }; c < channels; ++c)
+              row[ptrdiff_t(x) * dst.pixel + ptrdiff_t(c) * dst.channel] =
+                staged[x * channels + c];
+        }
+      }
+    }
+
+    template<typename _DType, typename _RType>
+    void run(const filter_spec &f, const ma::multiarray<_DType> &source,
+      ma::multiarray<_RType> &destination)
+    {
+      using in_type = typename ma::multiarray<_DType>::native_type;
+      using out_type = typename ma::multiarray<_RType>::native_type;
+      if (destination.dim() != source.dim())
+        throw std::invalid_argument { "expected an array of shape " + source.dim().str()
+                                      + ", got " + destination.dim().str() };
+      if (f.mode != border::constant && f.mode != border::replicate
+          && f.mode != border::reflect)
+        throw std::invalid_argument { "unknown border mode" };
+
+      const auto out { layout(destination) };
+      auto in { layout(source) };
+      if (in.height == 0 || in.width == 0 || in.channels == 0) return;
+
+      // overlapping arrays are filtered from a copy, since bands read each other's rows
+      ma::multiarray<_DType> copy { ma::dimension(1) };
+      const auto [in_low, in_high] { extent(in) };
+      const auto [out_low, out_high] { extent(out) };
+      if (in_low < out_high && out_low < in_high) {
+        copy = source.copy();
+        in = layout(copy);
+      }
+      const image<const in_type> src { in.data, in.height, in.width, in.channels, in.row,
+        in.pixel, in.channel };
+
+      // columns of the left and right borders of the padded rows
+      std::vector<ptrdiff_t> pads;
+      for (int j { 0 }; j < f.width - 1; ++j)
+        pads.push_back(map_border(
+          j < f.ax() ? j - f.ax() : ptrdiff_t(in.width) + j - f.ax(), in.width, f.mode));
+
+      // bands have a fixed height, long enough to amortize the rows of their ring filled
+      // beyond them, so that running sums and thus results never depend on the executor
+      const size_t band { std::max<size_t>(32, 4 * size_t(f.height)) };
+      const size_t bands { (in.height + band - 1) / band };
+      const size_t band_bytes {
+        band * in.width * in.channels * (sizeof(in_type) + sizeof(out_type)) };
+      const size_t grain { std::max<size_t>(ma::grain_size() / band_bytes, 1) };
+      ma::default_executor().parallel_for(bands, grain, [&](size_t begin, size_t end) {
+        for (; begin < end; ++begin)
+          filter_band<in_type, out_type>(f, src, out, pads, begin * band,
+            std::min((begin + 1) * band, in.height));
+      });
+    }
+
+    std::vector<float> values(const ma::float32 &kernel)
+    {
+      std::vector<float> v(kernel.size());
+      for (size_t i { 0 }; i < v.size(); ++i) v[i] = kernel.data()[i];
+      return v;
+    }
+
+  }  // namespace
+
+  template<typename _DType>
+  void filter2d(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const ma::float32 &kernel, const border mode, const float value)
+  {
+    run(split(kernel, mode, value), src, dst);
+  }
+
+  template<typename _DType>
+  void sep_filter2d(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const ma::float32 &kx, const ma::float32 &ky, const border mode, const float value)
+  {
+    run(separable(taps(kx, "kx"), taps(ky, "ky"), mode, value), src, dst);
+  }
+
+  ma::float32 gaussian_kernel(const int size, double sigma)
+  {
+    if (size < 1 || size % 2 == 0)
+      throw std::invalid_argument { "gaussian kernels must have an odd size" };
+    if (sigma <= 0) sigma = 0.3 * ((size - 1) * 0.5 - 1) + 0.8;
+
+    std::vector<double> weights(static_cast<size_t>(size));
+    double total { 0 };
+    for (int i { 0 }; i < size; ++i) {
+      const double x { double(i - (size - 1) / 2) };
+      total += weights[size_t(i)] = std::exp(-x * x / (2 * sigma * sigma));
+    }
+    ma::float32 kernel { ma::dimension(size_t(size)), ma::uninitialized };
+    for (int i { 0 }; i < size; ++i) kernel.data()[i] = float(weights[size_t(i)] / total);
+    return kernel;
+  }
+
+  template<typename _DType>
+  void gaussian_blur(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const int size, const double sigma, const border mode)
+  {
+    const auto taps { values(gaussian_kernel(size, sigma)) };
+    run(separable(taps, taps, mode, 0), src, dst);
+  }
+
+  template<typename _DType>
+  void box_filter(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst,
+    const int rows, const int columns, const bool normalize, const border mode,
+    const float value)
+  {
+    if (rows < 1 || columns < 1)
+      throw std::invalid_argument { "box windows must span at least a pixel" };
+    const double scale { normalize ? 1.0 / (double(rows) * columns) : 1.0 };
+    run(filter_spec { stage::box, columns, rows, {}, {}, {}, scale, mode, value }, src, dst);
+  }
+
+  ma::float32 sobel_kernel(const int size, const int order)
+  {
+    if (size != 1 && size != 3 && size != 5 && size != 7)
+      throw std::invalid_argument { "sobel kernels have a size of 1, 3, 5 or 7" };
+    if (order < 0 || order > 2 || (size > 1 && order >= size))
+      throw std::invalid_argument { "sobel derivatives have an order of 0 to 2, below the "
+                                    "size" };
+
+    // binomial smoothing convolved with central differences
+    const int n { size == 1 ? (order ? 3 : 1) : size };
+    std::vector<int> k(size_t(n) + 1);
+    k[0] = 1;
+    for (int i { 0 }; i < n - order - 1; ++i) {
+      int previous { k[0] };
+      for (int j { 1 }; j <= n; ++j) {
+        const int current { k[size_t(j)] + k[size_t(j) - 1] };
+        k[size_t(j) - 1] = previous;
+        previous = current;
+      }
+    }
+    for (int i { 0 }; i < order; ++i) {
+      int previous { -k[0] };
+      for (int j { 1 }; j <= n; ++j) {
+        const int current { k[size_t(j) - 1] - k[size_t(j)] };
+        k[size_t(j) - 1] = previous;
+        previous = current;
+      }
+    }
+
+    ma::float32 kernel { ma::dimension(size_t(n)), ma::uninitialized };
+    for (int i { 0 }; i < n; ++i) kernel.data()[i] = float(k[size_t(i)]);
+    return kernel;
+  }
+
+  template<typename _DType>
+  void sobel(const ma::multiarray<_DType> &src, ma::float32 &dst, const int dx,
+    const int dy, const int size, const border mode)
+  {
+    if (dx < 0 || dy < 0 || dx + dy == 0)
+      throw std::invalid_argument { "sobel needs a derivative along either axis" };
+    run(separable(values(sobel_kernel(size, dx)), values(sobel_kernel(size, dy)), mode, 0),
+      src, dst);
+  }
+
+  template<typename _DType>
+  void scharr(const ma::multiarray<_DType> &src, ma::float32 &dst, const int dx,
+    const int dy, const border mode)
+  {
+    if (dx < 0 || dy < 0 || dx + dy != 1)
+      throw std::invalid_argument { "scharr takes a first derivative along a single axis" };
+    const std::vector<float> derivative { -1, 0, 1 }, smoothing { 3, 10, 3 };
+    run(separable(dx ? derivative : smoothing, dy ? derivative : smoothing, mode, 0), src,
+      dst);
+  }
+
+  /////////////////////////////// TEMPLATE INSTANTIATIONS ////////////////////////////////
+
+#define FILTER_INSTANTIATIONS(type)                                                   \
+ template void filter2d<type>(const ma::multiarray<type> &, ma::multiarray<type> &,    \
+   const ma::float32 &, const border, const float);                                    \
+ template void sep_filter2d<type>(const ma::multiarray<type> &,                        \
+   ma::multiarray<type> &, const ma::float32 &, const ma::float32 &, const border,      \
+   const float);                                                                       \
+ template void gaussian_blur<type>(const ma::multiarray<type> &,                       \
+   ma::multiarray<type> &, const int, const double, const border);                     \
+ template void box_filter<type>(const ma::multiarray<type> &, ma::multiarray<type> &,  \
+   const int, const int, const bool, const border, const float);                       \
+ template void sobel<type>(const ma::multiarray<type> &, ma::float32 &, const int,     \
+   const int, const int, const border);                                                \
+ template void scharr<type>(const ma::multiarray<type> &, ma::float32 &, const int,    \
+   const int, const border);
+
+  FILTER_INSTANTIATIONS(ma::dtype::uint8);
+  FILTER_INSTANTIATIONS(ma::dtype::float32);
+
+}  // namespace covdel::cv
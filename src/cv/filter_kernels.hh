@@ -0,0 +1,61 @@
+#ifndef __COVDEL_SRC_CV_FILTER_KERNELS_HH_1701471265__
+#define __COVDEL_SRC_CV_FILTER_KERNELS_HH_1701471265__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace covdel::cv::detail
+{
+  using std::size_t;
+
+  // inner loops of the filtering engine over rows of float samples, pixels of `step`
+  // interleaved channels, kernels of symmetric taps are folded to halve the products
+  struct filter_table {
+    // out[i] = sum of k[t] * in[i + t * step] over the taps, or added onto out
+    void (*row)(const float *in, const float *k, int taps, size_t step, float *out,
+      size_t count);
+    void (*row_add)(const float *in, const float *k, int taps, size_t step, float *out,
+      size_t count);
+    void (*row_symmetric)(const float *in, const float *k, int taps, size_t step,
+      float *out, size_t count);
+
+    // out[i] = sum of k[t] * rows[t][i] over the taps, the uint8 ones rounded to nearest
+    // and saturated
+    void (*column)(const float *const *rows, const float *k, int taps, float *out,
+      size_t count);
+    void (*column_u8)(const float *const *rows, const float *k, int taps,
+      std::uint8_t *out, size_t count);
+    void (*column_symmetric)(const float *const *rows, const float *k, int taps,
+      float *out, size_t count);
+    void (*column_symmetric_u8)(const float *const *rows, const float *k, int taps,
+      std::uint8_t *out, size_t count);
+
+    // out[i] = sum of in[i + t * step] over the taps, from running sums along the row
+    void (*box_row)(const float *in, int taps, size_t step, float *out, size_t count);
+
+    // running box sums, sums[i] += add[i] - sub[i] after storing sums[i] * scale, in
+    // float when the sums of uint8 samples stay exact
+    void (*box)(double *sums, const float *add, const float *sub, double scale, float *out,
+      size_t count);
+    void (*box_u8)(double *sums, const float *add, const float *sub, double scale,
+      std::uint8_t *out, size_t count);
+    void (*box_exact_u8)(float *sums, const float *add, const float *sub, double scale,
+      std::uint8_t *out, size_t count);
+
+    // conversions of samples to and from floats, rounded to nearest and saturated
+    void (*widen)(const std::uint8_t *in, float *out, size_t count);
+    void (*narrow)(const float *in, std::uint8_t *out, size_t count);
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(filter_table &table) noexcept; }
+  namespace sse2 { void fill(filter_table &table) noexcept; }
+  namespace avx2 { void fill(filter_table &table) noexcept; }
+  namespace avx512 { void fill(filter_table &table) noexcept; }
+
+  // loops of the currently active instruction set level of the multiarray module
+  const filter_table &filters() noexcept;
+
+}  // namespace covdel::cv::detail
+
+#endif
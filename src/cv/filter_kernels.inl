@@ -0,0 +1,326 @@
+// Row loops of the filtering engine, compiled once per instruction set level. Each
+// including translation unit defines COVDEL_KERNEL_ISA and is built with the matching
+// target flags, so the loops below are auto-vectorized for that level. As in the
+// multiarray kernels, everything but fill() has internal linkage and no out-of-line
+// library templates are used.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "filter_kernels.hh"
+
+namespace covdel::cv::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+    // outputs accumulated at once, which stay in registers or the L1 cache across taps
+    constexpr size_t BLOCK { 64 };
+
+    inline float saturate(const float v) noexcept
+    {
+      const float low { v > 0.0F ? v : 0.0F };
+      return low < 255.0F ? low : 255.0F;
+    }
+
+    inline size_t block(const size_t i, const size_t count) noexcept
+    {
+      return count - i < BLOCK ? count - i : BLOCK;
+    }
+
+    template<typename _Out>
+    inline _Out convert(const float v) noexcept
+    {
+      if constexpr (sizeof(_Out) == 1)
+        return _Out(int(saturate(v) + 0.5F));
+      else
+        return v;
+    }
+
+    template<typename _Out>
+    void store(const float *acc, _Out *dst, const size_t n) noexcept
+    {
+      for (size_t j { 0 }; j < n; ++j) dst[j] = convert<_Out>(acc[j]);
+    }
+
+    // kernels of up to MAX_FIXED taps are unrolled so that sums stay in registers, longer
+    // ones accumulate blocks of outputs tap by tap, summing in the same order
+    constexpr int MAX_FIXED { 9 };
+
+    /////////////////////////////////////// ROWS /////////////////////////////////////////
+
+    template<int _Taps, bool _Add>
+    void row_fixed(const float *in, const float *k, const size_t step, float *out,
+      const size_t count)
+    {
+      float kt[_Taps];
+      for (int t { 0 }; t < _Taps; ++t) kt[t] = k[t];
+      for (size_t i { 0 }; i < count; ++i) {
+        float sum { kt[0] * in[i] };
+        for (int t { 1 }; t < _Taps; ++t) sum += kt[t] * in[i + size_t(t) * step];
+        if constexpr (_Add)
+          out[i] += sum;
+        else
+          out[i] = sum;
+      }
+    }
+
+    template<bool _Add>
+    void row_blocked(const float *in, const float *k, const int taps, const size_t step,
+      float *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; i += BLOCK) {
+        const size_t n { block(i, count) };
+        const float *src { in + i };
+        float acc[BLOCK];
+        for (size_t j { 0 }; j < n; ++j) acc[j] = k[0] * src[j];
+        for (int t { 1 }; t < taps; ++t) {
+          const float kt { k[t] };
+          const float *tap { src + size_t(t) * step };
+          for (size_t j { 0 }; j < n; ++j) acc[j] += kt * tap[j];
+        }
+        float *dst { out + i };
+        if constexpr (_Add)
+          for (size_t j { 0 }; j < n; ++j) dst[j] += acc[j];
+        else
+          for (size_t j { 0 }; j < n; ++j) dst[j] = acc[j];
+      }
+    }
+
+    template<bool _Add, int _Taps = 1>
+    void row(const float *in, const float *k, const int taps, const size_t step,
+      float *out, const size_t count)
+    {
+      if constexpr (_Taps > MAX_FIXED)
+        row_blocked<_Add>(in, k, taps, step, out, count);
+      else if (taps == _Taps)
+        row_fixed<_Taps, _Add>(in, k, step, out, count);
+      else
+        row<_Add, _Taps + 1>(in, k, taps, step, out, count);
+    }
+
+    // taps mirrored around the centre one share their product
+    template<int _Half>
+    void row_symmetric_fixed(const float *in, const float *k, const size_t step,
+      float *out, const size_t count)
+    {
+      float kt[_Half + 1];
+      for (int t { 0 }; t <= _Half; ++t) kt[t] = k[_Half + t];
+      for (size_t i { 0 }; i < count; ++i) {
+        float sum { kt[0] * in[i + size_t(_Half) * step] };
+        for (int t { 1 }; t <= _Half; ++t)
+          sum += kt[t]
+            * (in[i + size_t(_Half - t) * step] + in[i + size_t(_Half + t) * step]);
+        out[i] = sum;
+      }
+    }
+
+    void row_symmetric_blocked(const float *in, const float *k, const int taps,
+      const size_t step, float *out, const size_t count)
+    {
+      const int half { taps / 2 };
+      for (size_t i { 0 }; i < count; i += BLOCK) {
+        const size_t n { block(i, count) };
+        const float *centre { in + i + size_t(half) * step };
+        float acc[BLOCK];
+        const float kc { k[half] };
+        for (size_t j { 0 }; j < n; ++j) acc[j] = kc * centre[j];
+        for (int t { 1 }; t <= half; ++t) {
+          const float kt { k[half + t] };
+          const float *left { centre - size_t(t) * step };
+          const float *right { centre + size_t(t) * step };
+          for (size_t j { 0 }; j < n; ++j) acc[j] += kt * (left[j] + right[j]);
+        }
+        float *dst { out + i };
+        for (size_t j { 0 }; j < n; ++j) dst[j] = acc[j];
+      }
+    }
+
+    template<int _Half = 1>
+    void row_symmetric(const float *in, const float *k, const int taps, const size_t step,
+      float *out, const size_t count)
+    {
+      if constexpr (2 * _Half + 1 > MAX_FIXED)
+        row_symmetric_blocked(in, k, taps, step, out, count);
+      else if (taps == 2 * _Half + 1)
+        row_symmetric_fixed<_Half>(in, k, step, out, count);
+      else
+        row_symmetric<_Half + 1>(in, k, taps, step, out, count);
+    }
+
+    ////////////////////////////////////// COLUMNS ///////////////////////////////////////
+
+    template<int _Taps, typename _Out>
+    void column_fixed(const float *const *rows, const float *k, _Out *out,
+      const size_t count)
+    {
+      float kt[_Taps];
+      const float *src[_Taps];
+      for (int t { 0 }; t < _Taps; ++t) kt[t] = k[t], src[t] = rows[t];
+      for (size_t i { 0 }; i < count; ++i) {
+        float sum { kt[0] * src[0][i] };
+        for (int t { 1 }; t < _Taps; ++t) sum += kt[t] * src[t][i];
+        out[i] = convert<_Out>(sum);
+      }
+    }
+
+    template<typename _Out>
+    void column_blocked(const float *const *rows, const float *k, const int taps,
+      _Out *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; i += BLOCK) {
+        const size_t n { block(i, count) };
+        float acc[BLOCK];
+        const float k0 { k[0] };
+        const float *first { rows[0] + i };
+        for (size_t j { 0 }; j < n; ++j) acc[j] = k0 * first[j];
+        for (int t { 1 }; t < taps; ++t) {
+          const float kt { k[t] };
+          const float *src { rows[t] + i };
+          for (size_t j { 0 }; j < n; ++j) acc[j] += kt * src[j];
+        }
+        store(acc, out + i, n);
+      }
+    }
+
+    template<typename _Out, int _Taps = 1>
+    void column(const float *const *rows, const float *k, const int taps, _Out *out,
+      const size_t count)
+    {
+      if constexpr (_Taps > MAX_FIXED)
+        column_blocked(rows, k, taps, out, count);
+      else if (taps == _Taps)
+        column_fixed<_Taps>(rows, k, out, count);
+      else
+        column<_Out, _Taps + 1>(rows, k, taps, out, count);
+    }
+
+    template<int _Half, typename _Out>
+    void column_symmetric_fixed(const float *const *rows, const float *k, _Out *out,
+      const size_t count)
+    {
+      float kt[_Half + 1];
+      const float *above[_Half + 1], *below[_Half + 1];
+      for (int t { 0 }; t <= _Half; ++t)
+        kt[t] = k[_Half + t], above[t] = rows[_Half - t], below[t] = rows[_Half + t];
+      for (size_t i { 0 }; i < count; ++i) {
+        float sum { kt[0] * above[0][i] };
+        for (int t { 1 }; t <= _Half; ++t) sum += kt[t] * (above[t][i] + below[t][i]);
+        out[i] = convert<_Out>(sum);
+      }
+    }
+
+    template<typename _Out>
+    void column_symmetric_blocked(const float *const *rows, const float *k, const int taps,
+      _Out *out, const size_t count)
+    {
+      const int half { taps / 2 };
+      for (size_t i { 0 }; i < count; i += BLOCK) {
+        const size_t n { block(i, count) };
+        float acc[BLOCK];
+        const float kc { k[half] };
+        const float *centre { rows[half] + i };
+        for (size_t j { 0 }; j < n; ++j) acc[j] = kc * centre[j];
+        for (int t { 1 }; t <= half; ++t) {
+          const float kt { k[half + t] };
+          const float *above { rows[half - t] + i }, *below { rows[half + t] + i };
+          for (size_t j { 0 }; j < n; ++j) acc[j] += kt * (above[j] + below[j]);
+        }
+        store(acc, out + i, n);
+      }
+    }
+
+    template<typename _Out, int _Half = 1>
+    void column_symmetric(const float *const *rows, const float *k, const int taps,
+      _Out *out, const size_t count)
+    {
+      if constexpr (2 * _Half + 1 > MAX_FIXED)
+        column_symmetric_blocked(rows, k, taps, out, count);
+      else if (taps == 2 * _Half + 1)
+        column_symmetric_fixed<_Half>(rows, k, out, count);
+      else
+        column_symmetric<_Out, _Half + 1>(rows, k, taps, out, count);
+    }
+
+    /////////////////////////////////////// BOXES ////////////////////////////////////////
+
+    // out[i] = sum of in[i + t * step] over the taps, kept running along the row in double,
+    // the sums of each channel are independent and stay in registers for up to 4 channels
+    template<size_t _Step>
+    void box_row_fixed(const float *in, const int taps, float *out, const size_t count)
+    {
+      double sum[_Step] {};
+      for (size_t t { 0 }; t < size_t(taps); ++t)
+        for (size_t c { 0 }; c < _Step; ++c) sum[c] += double(in[t * _Step + c]);
+      const float *add { in + size_t(taps) * _Step };
+      for (size_t i { 0 }; i < count; i += _Step)
+        for (size_t c { 0 }; c < _Step; ++c) {
+          out[i + c] = float(sum[c]);
+          sum[c] += double(add[i + c]) - double(in[i + c]);
+        }
+    }
+
+    void box_row(const float *in, const int taps, const size_t step, float *out,
+      const size_t count)
+    {
+      switch (step) {
+      case 1: return box_row_fixed<1>(in, taps, out, count);
+      case 2: return box_row_fixed<2>(in, taps, out, count);
+      case 3: return box_row_fixed<3>(in, taps, out, count);
+      case 4: return box_row_fixed<4>(in, taps, out, count);
+      }
+      for (size_t c { 0 }; c < step; ++c) {
+        double sum { 0 };
+        for (size_t t { 0 }; t < size_t(taps); ++t) sum += double(in[t * step + c]);
+        const float *add { in + size_t(taps) * step };
+        for (size_t i { c }; i < count; i += step) {
+          out[i] = float(sum);
+          sum += double(add[i]) - double(in[i]);
+        }
+      }
+    }
+
+    // sums of uint8 samples are exact in float up to 2^24, and kept in double otherwise
+    template<typename _Sum, typename _Out>
+    void box(_Sum *sums, const float *add, const float *sub, const double scale, _Out *out,
+      const size_t count)
+    {
+      const _Sum factor { _Sum(scale) };
+      for (size_t i { 0 }; i < count; ++i) {
+        out[i] = convert<_Out>(float(sums[i] * factor));
+        sums[i] += _Sum(add[i]) - _Sum(sub[i]);
+      }
+    }
+
+    //////////////////////////////////// CONVERSIONS /////////////////////////////////////
+
+    void widen(const std::uint8_t *in, float *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i) out[i] = float(in[i]);
+    }
+
+    void narrow(const float *in, std::uint8_t *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; i += BLOCK) store(in + i, out + i, block(i, count));
+    }
+
+  }  // namespace
+
+  void fill(filter_table &table) noexcept
+  {
+    table.row = row<false>;
+    table.row_add = row<true>;
+    table.row_symmetric = row_symmetric<>;
+    table.column = column<float>;
+    table.column_u8 = column<std::uint8_t>;
+    table.column_symmetric = column_symmetric<float>;
+    table.column_symmetric_u8 = column_symmetric<std::uint8_t>;
+    table.box_row = box_row;
+    table.box = box<double, float>;
+    table.box_u8 = box<double, std::uint8_t>;
+    table.box_exact_u8 = box<float, std::uint8_t>;
+    table.widen = widen;
+    table.narrow = narrow;
+  }
+
+}  // namespace covdel::cv::detail::COVDEL_KERNEL_ISA
@@ -0,0 +1,2 @@
+#define COVDEL_KERNEL_ISA avx512
+#include "filter_kernels.inl"
@@ -0,0 +1,2 @@
+#define COVDEL_KERNEL_ISA scalar
+#include "filter_kernels.inl"
@@ -0,0 +1,61 @@
+#ifndef __COVDEL_SRC_CV_FORMATS_HH_1701390412__
+#define __COVDEL_SRC_CV_FORMATS_HH_1701390412__
+
+#include "covdel/cv/imageio.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace covdel::cv::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // headers are parsed out of the whole mapped file, decoders write the samples of row y
+  // at `out + y * row_stride` with the pixels of a row contiguous
+
+  image_header pnm_header(const char *bytes, size_t length);
+  void pnm_decode(const char *bytes, size_t length, std::uint8_t *out,
+    ptrdiff_t row_stride);
+  void pnm_encode(std::ostream &out, const ma::uint8 &image);
+
+  image_header bmp_header(const char *bytes, size_t length);
+  void bmp_decode(const char *bytes, size_t length, std::uint8_t *out,
+    ptrdiff_t row_stride);
+  void bmp_encode(std::ostream &out, const ma::uint8 &image);
+
+  image_header png_header(const char *bytes, size_t length);
+  void png_decode(const char *bytes, size_t length, std::uint8_t *out,
+    ptrdiff_t row_stride);
+  void png_encode(std::ostream &out, const ma::uint8 &image, int level);
+
+  // row `y` of an image, in place if its pixels are contiguous or else gathered into
+  // `scratch`
+  const std::uint8_t *image_row(const ma::uint8 &image, size_t y,
+    std::uint8_t *scratch) noexcept;
+
+  [[noreturn]] inline void malformed(const char *format, const std::string &what)
+  {
+    throw std::invalid_argument { std::string { "malformed " } + format + " file, "
+                                  + what };
+  }
+
+  inline std::uint32_t read_be32(const char *bytes) noexcept
+  {
+    const auto *p { reinterpret_cast<const std::uint8_t *>(bytes) };
+    return std::uint32_t(p[0]) << 24 | std::uint32_t(p[1]) << 16
+         | std::uint32_t(p[2]) << 8
+         | p[3];
+  }
+
+  inline void write_be32(std::string &bytes, const std::uint32_t value)
+  {
+    for (int shift { 24 }; shift >= 0; shift -= 8) bytes += char(value >> shift & 0xFF);
+  }
+
+}  // namespace covdel::cv::detail
+
+#endif
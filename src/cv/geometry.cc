@@ -0,0 +1,614 @@
+#include "covdel/cv/geometry.hh"
+
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+#include "filter_kernels.hh"
+#include "geometry_kernels.hh"
+#include "image.hh"
+#include "ma/cache.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace covdel::cv
+{
+  const detail::resize_table &detail::resizers() noexcept
+  {
+    static const auto s_tables { [] {
+      std::array<resize_table, 4> tables {};
+      scalar::fill(tables[int(ma::isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+      sse2::fill(tables[int(ma::isa::sse2)]);
+      avx2::fill(tables[int(ma::isa::avx2)]);
+      avx512::fill(tables[int(ma::isa::avx512)]);
+#endif
+      return tables;
+    }() };
+    return s_tables[int(ma::active_isa())];
+  }
+
+  namespace
+  {
+    using std::int16_t;
+    using std::int32_t;
+    using std::ptrdiff_t;
+    using std::size_t;
+    using std::uint8_t;
+    using detail::extent;
+    using detail::image;
+    using detail::layout;
+    using detail::map_border;
+
+    // keys kernel of bicubic interpolation
+    constexpr double CUBIC { -0.75 };
+
+    double cubic(double x) noexcept
+    {
+      x = std::fabs(x);
+      if (x <= 1) return ((CUBIC + 2) * x - (CUBIC + 3)) * x * x + 1;
+      if (x < 2) return ((CUBIC * x - 5 * CUBIC) * x + 8 * CUBIC) * x - 4 * CUBIC;
+      return 0;
+    }
+
+    double triangle(const double x) noexcept
+    {
+      const double d { std::fabs(x) };
+      return d < 1 ? 1 - d : 0;
+    }
+
+    // fractional bits of the fixed-point bilinear weights
+    constexpr int FIXED_BITS { 11 };
+    constexpr int32_t FIXED_ONE { 1 << FIXED_BITS };
+
+    // images as floats are rounded to nearest and saturated as uint8
+    template<typename _Type>
+    _Type convert(const float v) noexcept
+    {
+      if constexpr (std::is_same_v<_Type, uint8_t>)
+        return uint8_t(int(std::min(std::max(v, 0.0F), 255.0F) + 0.5F));
+      else
+        return v;
+    }
+
+    template<typename _DType>
+    void check_shapes(const ma::multiarray<_DType> &src, const ma::multiarray<_DType> &dst)
+    {
+      layout(src);
+      layout(dst);
+      if (src.ndims() != dst.ndims() || (src.ndims() == 3 && src.dim()[2] != dst.dim()[2]))
+        throw std::invalid_argument { "expected an array with the channels of "
+                                      + src.dim().str() + ", got " + dst.dim().str() };
+    }
+
+    /////////////////////////////////// COEFFICIENTS /////////////////////////////////////
+
+    // weights of the `taps` source samples each destination sample of an axis reads, at
+    // indices clamped into the source, and of bilinear ones in fixed-point
+    struct coefficients {
+      int taps;
+      std::vector<int32_t> index;
+      std::vector<float> weights;
+      std::vector<int16_t> fixed;
+    };
+
+    std::shared_ptr<const coefficients> compute(const size_t src, const size_t dst,
+      const interpolation method, const bool antialias)
+    {
+      auto out { std::make_shared<coefficients>() };
+      const double scale { double(src) / double(dst) };
+      const auto clamp = [last { ptrdiff_t(src) - 1 }](const ptrdiff_t i) {
+        return int32_t(std::min(std::max(i, ptrdiff_t(0)), last));
+      };
+      const auto assign = [&](const int taps) {
+        out->taps = taps;
+        out->index.resize(dst * size_t(taps));
+        out->weights.resize(dst * size_t(taps));
+      };
+      const bool bicubic { method == interpolation::bicubic };
+
+      if (method == interpolation::nearest) {
+        assign(1);
+        for (size_t i { 0 }; i < dst; ++i) {
+          out->index[i] = clamp(ptrdiff_t(std::floor((double(i) + 0.5) * scale)));
+          out->weights[i] = 1;
+        }
+      } else if (method == interpolation::area && scale > 1) {
+        // the fractions of the source pixels covered by each destination one
+        const int taps { int(std::ceil(scale)) + 1 };
+        assign(taps);
+        for (size_t i { 0 }; i < dst; ++i) {
+          const double start { double(i) * scale };
+          const double end { std::min(double(i + 1) * scale, double(src)) };
+          const auto first { ptrdiff_t(std::floor(start)) };
+          for (int t { 0 }; t < taps; ++t) {
+            const ptrdiff_t j { first + t };
+            const double covered { std::min(end, double(j + 1))
+                                   - std::max(start, double(j)) };
+            out->index[i * size_t(taps) + size_t(t)] = clamp(j);
+            out->weights[i * size_t(taps) + size_t(t)]
+              = float(std::max(covered, 0.0) / scale);
+          }
+        }
+      } else if (antialias && scale > 1 && method != interpolation::area) {
+        // kernels stretched by the scale, truncated at the edges and normalized
+        const double support { (bicubic ? 2.0 : 1.0) * scale };
+        const int taps { int(std::ceil(support)) * 2 + 1 };
+        assign(taps);
+        std::vector<double> w(size_t(taps), 0.0);
+        for (size_t i { 0 }; i < dst; ++i) {
+          const double centre { (double(i) + 0.5) * scale };
+          const auto first { ptrdiff_t(std::floor(centre - support + 0.5)) };
+          const auto stop { ptrdiff_t(std::floor(centre + support + 0.5)) };
+          double total { 0 };
+          for (int t { 0 }; t < taps; ++t) {
+            const ptrdiff_t j { first + t };
+            const double x { (double(j) + 0.5 - centre) / scale };
+            w[size_t(t)] = j < 0 || j >= ptrdiff_t(src) || j >= stop ? 0
+                           : bicubic                               ? cubic(x)
+                                                                   : triangle(x);
+            total += w[size_t(t)];
+          }
+          for (int t { 0 }; t < taps; ++t) {
+            out->index[i * size_t(taps) + size_t(t)] = clamp(first + t);
+            out->weights[i * size_t(taps) + size_t(t)] = float(w[size_t(t)] / total);
+          }
+        }
+      } else {
+        // bilinear and bicubic interpolation, which `area` falls back to when upscaling
+        const int taps { bicubic ? 4 : 2 };
+        assign(taps);
+        if (!bicubic) out->fixed.resize(2 * dst);
+        for (size_t i { 0 }; i < dst; ++i) {
+          const double s { (double(i) + 0.5) * scale - 0.5 }, base { std::floor(s) };
+          const double f { s - base };
+          int32_t *index { out->index.data() + i * size_t(taps) };
+          float *w { out->weights.data() + i * size_t(taps) };
+          if (bicubic) {
+            for (int t { 0 }; t < 4; ++t) index[t] = clamp(ptrdiff_t(base) - 1 + t);
+            w[0] = float(cubic(f + 1));
+            w[1] = float(cubic(f));
+            w[2] = float(cubic(1 - f));
+            w[3] = float(cubic(2 - f));
+          } else {
+            index[0] = clamp(ptrdiff_t(base));
+            index[1] = clamp(ptrdiff_t(base) + 1);
+            w[0] = float(1 - f);
+            w[1] = float(f);
+            const auto high { int16_t(std::lround(f * FIXED_ONE)) };
+            out->fixed[2 * i] = int16_t(FIXED_ONE - high);
+            out->fixed[2 * i + 1] = high;
+          }
+        }
+      }
+      return out;
+    }
+
+    struct axis_key {
+      size_t src, dst;
+      interpolation method;
+      bool antialias;
+
+      bool operator==(const axis_key &rhs) const noexcept
+      {
+        return src == rhs.src && dst == rhs.dst && method == rhs.method
+               && antialias == rhs.antialias;
+      }
+    };
+
+    // the coefficients of the most recently used axes
+    std::shared_ptr<const coefficients> coefficients_of(const size_t src, const size_t dst,
+      const interpolation method, const bool antialias)
+    {
+      static ma::detail::mru_cache<axis_key, std::shared_ptr<const coefficients>, 16>
+        s_coefficients;
+      return s_coefficients.get({ src, dst, method, antialias },
+        [&] { return compute(src, dst, method, antialias); });
+    }
+
+    ////////////////////////////////////// RESIZE ////////////////////////////////////////
+
+    // buffers of each thread, grown to the largest images seen and kept across calls
+    template<typename _Type>
+    struct scratch {
+      std::vector<float> rows;
+      std::vector<int16_t> fixed;
+      std::vector<ptrdiff_t> held;
+      std::vector<const float *> pointers;
+      std::vector<_Type> source, target;
+    };
+
+    template<typename _Type>
+    scratch<_Type> &buffers()
+    {
+      thread_local scratch<_Type> s_scratch {};
+      return s_scratch;
+    }
+
+    template<typename _Type>
+    _Type *reserve(std::vector<_Type> &buffer, const size_t count)
+    {
+      if (buffer.size() < count) buffer.resize(count);
+      return buffer.data();
+    }
+
+    template<typename _Type>
+    struct resize_job {
+      image<const _Type> src;
+      image<_Type> dst;
+      const coefficients *x, *y;
+      bool nearest, fixed;
+    };
+
+    // nearest neighbours are copied without converting them
+    template<typename _Type>
+    void nearest_rows(const resize_job<_Type> &job, const size_t begin, const size_t end)
+    {
+      const auto &[src, dst, cx, cy, nearest, fixed] { job };
+      for (size_t y { begin }; y < end; ++y) {
+        const _Type *in { src.data + cy->index[y] * src.row };
+        _Type *out { dst.data + ptrdiff_t(y) * dst.row };
+        for (size_t x { 0 }; x < dst.width; ++x) {
+          const _Type *pixel { in + cx->index[x] * src.pixel };
+          for (size_t c { 0 }; c < src.channels; ++c)
+            out[ptrdiff_t(x) * dst.pixel + ptrdiff_t(c) * dst.channel] =
+              pixel[ptrdiff_t(c) * src.channel];
+        }
+      }
+    }
+
+    // resamples the destination rows [begin, end), from a ring of the horizontally
+    // resampled source rows they read, each produced once per range
+    template<typename _Type>
+    void resize_rows(const resize_job<_Type> &job, const size_t begin, const size_t end)
+    {
+      const auto &[src, dst, cx, cy, nearest, fixed] { job };
+      const auto &ops { detail::resizers() };
+      const auto &filters { detail::filters() };
+      const size_t channels { src.channels }, count { dst.width * channels };
+      const size_t slots { size_t(cy->taps) };
+
+      auto &s { buffers<_Type>() };
+      float *rows { fixed ? nullptr : reserve(s.rows, slots * count) };
+      int16_t *fixed_rows { fixed ? reserve(s.fixed, slots * count) : nullptr };
+      ptrdiff_t *held { reserve(s.held, slots) };
+      const float **pointers { reserve(s.pointers, slots) };
+      _Type *source { src.packed() ? nullptr : reserve(s.source, src.width * channels) };
+      _Type *target { dst.packed() ? nullptr : reserve(s.target, count) };
+      std::fill_n(held, slots, -1);
+
+      // rows of a window are fewer than the slots apart, so they never evict each other
+      const auto produce = [&](const ptrdiff_t r) {
+        const size_t slot { size_t(r) % slots };
+        if (held[slot] == r) return slot;
+        held[slot] = r;
+        const _Type *in { src.data + r * src.row };
+        if (!src.packed()) {
+          for (size_t x { 0 }; x < src.width; ++x)
+            for (size_t c { 0 }; c < channels; ++c)
+              source[x * channels + c] =
+                in[ptrdiff_t(x) * src.pixel + ptrdiff_t(c) * src.channel];
+          in = source;
+        }
+        if constexpr (std::is_same_v<_Type, uint8_t>) {
+          if (fixed)
+            ops.horizontal_fixed(in, cx->index.data(), cx->fixed.data(), channels,
+              fixed_rows + slot * count, dst.width);
+          else
+            ops.horizontal_u8(in, cx->index.data(), cx->weights.data(), cx->taps, channels,
+              rows + slot * count, dst.width);
+        } else {
+          ops.horizontal(in, cx->index.data(), cx->weights.data(), cx->taps, channels,
+            rows + slot * count, dst.width);
+        }
+        return slot;
+      };
+
+      for (size_t y { begin }; y < end; ++y) {
+        _Type *out { dst.packed() ? dst.data + ptrdiff_t(y) * dst.row : target };
+        const int32_t *iy { cy->index.data() + y * slots };
+        if constexpr (std::is_same_v<_Type, uint8_t>) {
+          if (fixed) {
+            const size_t top { produce(iy[0]) }, bottom { produce(iy[1]) };
+            ops.vertical_fixed(fixed_rows + top * count, fixed_rows + bottom * count,
+              cy->fixed[2 * y], cy->fixed[2 * y + 1], out, count);
+          } else {
+            for (size_t t { 0 }; t < slots; ++t)
+              pointers[t] = rows + produce(iy[t]) * count;
+            filters.column_u8(pointers, cy->weights.data() + y * slots, cy->taps, out,
+              count);
+          }
+        } else {
+          for (size_t t { 0 }; t < slots; ++t) pointers[t] = rows + produce(iy[t]) * count;
+          filters.column(pointers, cy->weights.data() + y * slots, cy->taps, out, count);
+        }
+
+        if (!dst.packed()) {
+          _Type *row { dst.data + ptrdiff_t(y) * dst.row };
+          for (size_t x { 0 }; x < dst.width; ++x)
+            for (size_t c { 0 }; c < channels; ++c)
+              row[ptrdiff_t(x) * dst.pixel + ptrdiff_t(c) * dst.channel] =
+                target[x * channels + c];
+        }
+      }
+    }
+
+    /////////////////////////////////////// WARP /////////////////////////////////////////
+
+    template<typename _Type>
+    struct warp_job {
+      image<const _Type> src;
+      image<_Type> dst;
+      std::array<double, 6> m;  // destination coordinates to source ones
+      border mode;
+      float value;
+    };
+
+    // floor of s * 2^_Bits, offset to be positive since truncation is cheaper than the
+    // library call, to 2^-21 of a pixel for coordinates within ±2^30
+    template<int _Bits>
+    ptrdiff_t scaled_floor(const double s) noexcept
+    {
+      constexpr ptrdiff_t OFFSET { ptrdiff_t(1) << (31 + _Bits) };
+      return ptrdiff_t(s * double(ptrdiff_t(1) << _Bits) + double(OFFSET)) - OFFSET;
+    }
+
+    // first tap around a source coordinate and its weights, the nearest pixel for a
+    // single tap and fixed-point ones for bilinear uint8 samples
+    template<int _Taps, bool _Fixed>
+    ptrdiff_t sample_axis(const double s, float *w, int32_t *q) noexcept
+    {
+      if constexpr (_Taps == 1) {
+        return scaled_floor<0>(s + 0.5);
+      } else if constexpr (_Fixed) {
+        const ptrdiff_t at { scaled_floor<FIXED_BITS>(s + 0.5 / FIXED_ONE) };
+        q[1] = int32_t(at & (FIXED_ONE - 1));
+        q[0] = FIXED_ONE - q[1];
+        return at >> FIXED_BITS;
+      } else {
+        const ptrdiff_t base { scaled_floor<0>(s) };
+        const auto f { float(s - double(base)) };
+        if constexpr (_Taps == 2) {
+          w[0] = 1 - f;
+          w[1] = f;
+        } else {
+          // the pieces of the cubic kernel at the four distances, without branches
+          constexpr auto A { float(CUBIC) };
+          const float g { 1 - f };
+          w[0] = ((A * (f + 1) - 5 * A) * (f + 1) + 8 * A) * (f + 1) - 4 * A;
+          w[1] = ((A + 2) * f - (A + 3)) * f * f + 1;
+          w[2] = ((A + 2) * g - (A + 3)) * g * g + 1;
+          w[3] = 1 - w[0] - w[1] - w[2];
+        }
+        return base - (_Taps / 2 - 1);
+      }
+    }
+
+    // weighted sum of the taps of a channel, read through at(i, j), in fixed-point with
+    // weights of 11 fractional bits for bilinear uint8 samples and in float otherwise
+    template<int _Taps, bool _Fixed, typename _Type, typename _At>
+    _Type blend(const float *wx, const float *wy, const int32_t *qx, const int32_t *qy,
+      const _At &at) noexcept
+    {
+      if constexpr (_Taps == 1) {
+        return at(0, 0);
+      } else if constexpr (_Fixed) {
+        int32_t sum { 1 << (2 * FIXED_BITS - 1) };
+        for (int i { 0 }; i < _Taps; ++i)
+          sum += qy[i] * (qx[0] * int32_t(at(i, 0)) + qx[1] * int32_t(at(i, 1)));
+        return _Type(sum >> (2 * FIXED_BITS));
+      } else {
+        float sum { 0 };
+        for (int i { 0 }; i < _Taps; ++i) {
+          float across { 0 };
+          for (int j { 0 }; j < _Taps; ++j) across += wx[j] * float(at(i, j));
+          sum += wy[i] * across;
+        }
+        return convert<_Type>(sum);
+      }
+    }
+
+    // pixels whose taps are all inside the source read them straight from their first,
+    // the others map each tap by the border mode; strides are held locally since stores
+    // of bytes may alias the job
+    template<int _Taps, size_t _Channels, typename _Type>
+    void warp_rows(const warp_job<_Type> &job, const size_t begin, const size_t end)
+    {
+      const auto &[src, dst, matrix, mode, value] { job };
+      constexpr bool fixed { std::is_same_v<_Type, uint8_t> && _Taps == 2 };
+      const size_t channels { _Channels ? _Channels : src.channels };
+      const _Type constant { convert<_Type>(value) };
+      const std::array<double, 6> m { matrix };
+      const _Type *const data { src.data };
+      const ptrdiff_t row { src.row }, pixel { src.pixel }, channel { src.channel };
+      const ptrdiff_t out_pixel { dst.pixel }, out_channel { dst.channel };
+      const ptrdiff_t width { ptrdiff_t(src.width) - _Taps };
+      const ptrdiff_t height { ptrdiff_t(src.height) - _Taps };
+      // coordinates far outside the source are all beyond its borders alike
+      constexpr double LIMIT { 1 << 30 };
+
+      for (size_t y { begin }; y < end; ++y) {
+        const double bx { m[1] * double(y) + m[2] }, by { m[4] * double(y) + m[5] };
+        _Type *const line { dst.data + ptrdiff_t(y) * dst.row };
+        for (size_t x { 0 }, count { dst.width }; x < count; ++x) {
+          const double sx { std::clamp(m[0] * double(x) + bx, -LIMIT, LIMIT) };
+          const double sy { std::clamp(m[3] * double(x) + by, -LIMIT, LIMIT) };
+          float wx[_Taps], wy[_Taps];
+          int32_t qx[_Taps], qy[_Taps];
+          const ptrdiff_t fx { sample_axis<_Taps, fixed>(sx, wx, qx) };
+          const ptrdiff_t fy { sample_axis<_Taps, fixed>(sy, wy, qy) };
+          _Type *const out { line + ptrdiff_t(x) * out_pixel };
+
+          if (fx >= 0 && fx <= width && fy >= 0 && fy <= height) {
+            const _Type *const first { data + fy * row + fx * pixel };
+            for (size_t c { 0 }; c < channels; ++c) {
+              const _Type *const in { first + ptrdiff_t(c) * channel };
+              out[ptrdiff_t(c) * out_channel] = blend<_Taps, fixed, _Type>(wx, wy, qx, qy,
+                [&](const int i, const int j) { return in[i * row + j * pixel]; });
+            }
+            continue;
+          }
+
+          ptrdiff_t ix[_Taps], iy[_Taps];
+          for (int t { 0 }; t < _Taps; ++t) {
+            ix[t] = map_border(fx + t, src.width, mode);
+            iy[t] = map_border(fy + t, src.height, mode);
+          }
+          for (size_t c { 0 }; c < channels; ++c) {
+            const _Type *const in { data + ptrdiff_t(c) * channel };
+            out[ptrdiff_t(c) * out_channel] = blend<_Taps, fixed, _Type>(wx, wy, qx, qy,
+              [&](const int i, const int j) {
+                return iy[i] < 0 || ix[j] < 0 ? constant : in[iy[i] * row + ix[j] * pixel];
+              });
+          }
+        }
+      }
+    }
+
+    // the usual channel counts unroll
+    template<int _Taps, typename _Type>
+    void warp_channels(const warp_job<_Type> &job, const size_t begin, const size_t end)
+    {
+      switch (job.src.channels) {
+        case 1: return warp_rows<_Taps, 1>(job, begin, end);
+        case 3: return warp_rows<_Taps, 3>(job, begin, end);
+        case 4: return warp_rows<_Taps, 4>(job, begin, end);
+        default: return warp_rows<_Taps, 0>(job, begin, end);
+      }
+    }
+
+  }  // namespace
+
+  template<typename _DType>
+  void resize(const ma::multiarray<_DType> &source, ma::multiarray<_DType> &destination,
+    const interpolation method, const bool antialias)
+  {
+    using type = typename ma::multiarray<_DType>::native_type;
+    check_shapes(source, destination);
+    if (method != interpolation::nearest && method != interpolation::bilinear
+        && method != interpolation::bicubic && method != interpolation::area)
+      throw std::invalid_argument { "unknown interpolation" };
+    const auto out { layout(destination) };
+    auto in { layout(source) };
+    if (out.height == 0 || out.width == 0 || out.channels == 0) return;
+    if (in.height == 0 || in.width == 0)
+      throw std::invalid_argument { "cannot resize an empty image" };
+
+    // overlapping arrays are resized from a copy, since rows read each other's sources
+    std::optional<ma::multiarray<_DType>> copy {};
+    const auto [in_low, in_high] { extent(in) };
+    const auto [out_low, out_high] { extent(out) };
+    if (in_low < out_high && out_low < in_high) {
+      copy = source.copy();
+      in = layout(*copy);
+    }
+
+    const auto cx { coefficients_of(in.width, out.width, method, antialias) };
+    const auto cy { coefficients_of(in.height, out.height, method, antialias) };
+    const bool nearest { method == interpolation::nearest };
+    const bool fixed { std::is_same_v<type, uint8_t> && !cx->fixed.empty()
+                       && !cy->fixed.empty() };
+    const resize_job<type> job { { in.data, in.height, in.width, in.channels, in.row,
+                                   in.pixel, in.channel },
+      out, cx.get(), cy.get(), nearest, fixed };
+
+    // ranges of rows span their ring a few times over, and read and write about the grain
+    const size_t ratio { std::max<size_t>(in.height / out.height, 1) };
+    const size_t row_bytes { (in.width * ratio + out.width) * in.channels * sizeof(type) };
+    const size_t grain { std::max(ma::grain_size() / row_bytes, 2 * size_t(cy->taps)) };
+    ma::default_executor().parallel_for(out.height, grain, [&job](size_t begin, size_t end) {
+      if (job.nearest)
+        nearest_rows(job, begin, end);
+      else
+        resize_rows(job, begin, end);
+    });
+  }
+
+  template<typename _DType>
+  void warp_affine(const ma::multiarray<_DType> &source, ma::multiarray<_DType> &destination,
+    const ma::float64 &matrix, const interpolation method, const border mode,
+    const float value, const bool inverse)
+  {
+    using type = typename ma::multiarray<_DType>::native_type;
+    check_shapes(source, destination);
+    if (matrix.dim() != ma::dimension(2, 3))
+      throw std::invalid_argument { "expected an affine matrix of shape (2, 3), got "
+                                    + matrix.dim().str() };
+    if (method != interpolation::nearest && method != interpolation::bilinear
+        && method != interpolation::bicubic)
+      throw std::invalid_argument { "warps interpolate nearest, bilinear or bicubic" };
+    if (mode != border::constant && mode != border::replicate && mode != border::reflect)
+      throw std::invalid_argument { "unknown border mode" };
+
+    std::array<double, 6> m {};
+    for (size_t i { 0 }; i < 6; ++i) m[i] = matrix(i / 3, i % 3);
+    if (!inverse) {
+      const double det { m[0] * m[4] - m[1] * m[3] };
+      if (det == 0 || !std::isfinite(det))
+        throw std::invalid_argument { "cannot invert a singular affine matrix" };
+      m = { m[4] / det, -m[1] / det, (m[1] * m[5] - m[4] * m[2]) / det, -m[3] / det,
+        m[0] / det, (m[3] * m[2] - m[0] * m[5]) / det };
+    }
+
+    const auto out { layout(destination) };
+    auto in { layout(source) };
+    if (out.height == 0 || out.width == 0 || out.channels == 0) return;
+    if (in.height == 0 || in.width == 0)
+      throw std::invalid_argument { "cannot warp an empty image" };
+
+    std::optional<ma::multiarray<_DType>> copy {};
+    const auto [in_low, in_high] { extent(in) };
+    const auto [out_low, out_high] { extent(out) };
+    if (in_low < out_high && out_low < in_high) {
+      copy = source.copy();
+      in = layout(*copy);
+    }
+
+    const warp_job<type> job { { in.data, in.height, in.width, in.channels, in.row,
+                                 in.pixel, in.channel },
+      out, m, mode, value };
+    const size_t row_bytes { 2 * out.width * out.channels * sizeof(type) };
+    const size_t grain { std::max<size_t>(ma::grain_size() / row_bytes, 1) };
+    ma::default_executor().parallel_for(out.height, grain,
+      [&job, method](size_t begin, size_t end) {
+        if (method == interpolation::nearest)
+          warp_channels<1>(job, begin, end);
+        else if (method == interpolation::bilinear)
+          warp_channels<2>(job, begin, end);
+        else
+          warp_channels<4>(job, begin, end);
+      });
+  }
+
+  ma::float64 rotation_matrix(const double x, const double y, const double angle,
+    const double scale)
+  {
+    const double radians { angle * M_PI / 180 };
+    const double a { scale * std::cos(radians) }, b { scale * std::sin(radians) };
+    ma::float64 matrix { ma::dimension(2, 3) };
+    const double values[6] { a, b, (1 - a) * x - b * y, -b, a, b * x + (1 - a) * y };
+    for (size_t i { 0 }; i < 6; ++i) matrix(i / 3, i % 3) = values[i];
+    return matrix;
+  }
+
+  /////////////////////////////// TEMPLATE INSTANTIATIONS ////////////////////////////////
+
+#define GEOMETRY_INSTANTIATIONS(type)                                                 \
+ template void resize<type>(const ma::multiarray<type> &, ma::multiarray<type> &,      \
+   const interpolation, const bool);                                                   \
+ template void warp_affine<type>(const ma::multiarray<type> &, ma::multiarray<type> &, \
+   const ma::float64 &, const interpolation, const border, const float, const bool);
+
+  GEOMETRY_INSTANTIATIONS(ma::dtype::uint8);
+  GEOMETRY_INSTANTIATIONS(ma::dtype::float32);
+
+}  // namespace covdel::cv
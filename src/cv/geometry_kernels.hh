@@ -0,0 +1,41 @@
+#ifndef __COVDEL_SRC_CV_GEOMETRY_KERNELS_HH_1701557845__
+#define __COVDEL_SRC_CV_GEOMETRY_KERNELS_HH_1701557845__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace covdel::cv::detail
+{
+  using std::size_t;
+
+  // inner loops of resizing over rows of pixels of `channels` interleaved samples, vertical
+  // float passes reuse the column loops of the filters
+  struct resize_table {
+    // out[x * channels + c] = sum over the taps of
+    // w[x * taps + t] * in[index[x * taps + t] * channels + c]
+    void (*horizontal)(const float *in, const std::int32_t *index, const float *w,
+      int taps, size_t channels, float *out, size_t width);
+    void (*horizontal_u8)(const std::uint8_t *in, const std::int32_t *index,
+      const float *w, int taps, size_t channels, float *out, size_t width);
+
+    // bilinear passes in 16-bit fixed-point, with pairs of weights of 11 fractional bits
+    // summing to 2048, the horizontal one keeps 7 fractional bits of the samples and the
+    // vertical one multiplies their high halves and rounds them to uint8
+    void (*horizontal_fixed)(const std::uint8_t *in, const std::int32_t *index,
+      const std::int16_t *w, size_t channels, std::int16_t *out, size_t width);
+    void (*vertical_fixed)(const std::int16_t *top, const std::int16_t *bottom,
+      std::int16_t w0, std::int16_t w1, std::uint8_t *out, size_t count);
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(resize_table &table) noexcept; }
+  namespace sse2 { void fill(resize_table &table) noexcept; }
+  namespace avx2 { void fill(resize_table &table) noexcept; }
+  namespace avx512 { void fill(resize_table &table) noexcept; }
+
+  // loops of the currently active instruction set level of the multiarray module
+  const resize_table &resizers() noexcept;
+
+}  // namespace covdel::cv::detail
+
+#endif
@@ -0,0 +1,131 @@
+// Row loops of resizing, compiled once per instruction set level as the filter loops, see
+// filter_kernels.inl. Sums run in the same order on every level, so that results are
+// identical across them.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "geometry_kernels.hh"
+
+namespace covdel::cv::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+    using std::int16_t;
+    using std::int32_t;
+    using std::uint8_t;
+
+    //////////////////////////////////// HORIZONTAL //////////////////////////////////////
+
+    // sums of pixels of up to 4 channels stay in registers, and the taps of bilinear and
+    // bicubic kernels are unrolled
+    template<size_t _Channels, int _Taps, typename _In>
+    void horizontal_pixels(const _In *in, const int32_t *index, const float *w,
+      const int taps, float *out, const size_t width)
+    {
+      const size_t n { size_t(_Taps ? _Taps : taps) };
+      for (size_t x { 0 }; x < width; ++x) {
+        const int32_t *ix { index + x * n };
+        const float *wx { w + x * n };
+        float sum[_Channels];
+        const _In *first { in + size_t(ix[0]) * _Channels };
+        for (size_t c { 0 }; c < _Channels; ++c) sum[c] = wx[0] * float(first[c]);
+        for (size_t t { 1 }; t < n; ++t) {
+          const _In *pixel { in + size_t(ix[t]) * _Channels };
+          for (size_t c { 0 }; c < _Channels; ++c) sum[c] += wx[t] * float(pixel[c]);
+        }
+        for (size_t c { 0 }; c < _Channels; ++c) out[x * _Channels + c] = sum[c];
+      }
+    }
+
+    template<size_t _Channels, typename _In>
+    void horizontal_taps(const _In *in, const int32_t *index, const float *w,
+      const int taps, float *out, const size_t width)
+    {
+      if (taps == 2)
+        horizontal_pixels<_Channels, 2>(in, index, w, taps, out, width);
+      else if (taps == 4)
+        horizontal_pixels<_Channels, 4>(in, index, w, taps, out, width);
+      else
+        horizontal_pixels<_Channels, 0>(in, index, w, taps, out, width);
+    }
+
+    template<typename _In>
+    void horizontal(const _In *in, const int32_t *index, const float *w, const int taps,
+      const size_t channels, float *out, const size_t width)
+    {
+      switch (channels) {
+      case 1: return horizontal_taps<1>(in, index, w, taps, out, width);
+      case 2: return horizontal_taps<2>(in, index, w, taps, out, width);
+      case 3: return horizontal_taps<3>(in, index, w, taps, out, width);
+      case 4: return horizontal_taps<4>(in, index, w, taps, out, width);
+      }
+      for (size_t x { 0 }; x < width; ++x) {
+        const int32_t *ix { index + x * size_t(taps) };
+        const float *wx { w + x * size_t(taps) };
+        for (size_t c { 0 }; c < channels; ++c) {
+          float sum { wx[0] * float(in[size_t(ix[0]) * channels + c]) };
+          for (size_t t { 1 }; t < size_t(taps); ++t)
+            sum += wx[t] * float(in[size_t(ix[t]) * channels + c]);
+          out[x * channels + c] = sum;
+        }
+      }
+    }
+
+    template<size_t _Channels>
+    void horizontal_fixed_pixels(const uint8_t *in, const int32_t *index, const int16_t *w,
+      int16_t *out, const size_t width)
+    {
+      for (size_t x { 0 }; x < width; ++x) {
+        const int32_t w0 { w[2 * x] }, w1 { w[2 * x + 1] };
+        const uint8_t *a { in + size_t(index[2 * x]) * _Channels };
+        const uint8_t *b { in + size_t(index[2 * x + 1]) * _Channels };
+        for (size_t c { 0 }; c < _Channels; ++c)
+          out[x * _Channels + c] = int16_t((w0 * a[c] + w1 * b[c]) >> 4);
+      }
+    }
+
+    void horizontal_fixed(const uint8_t *in, const int32_t *index, const int16_t *w,
+      const size_t channels, int16_t *out, const size_t width)
+    {
+      switch (channels) {
+      case 1: return horizontal_fixed_pixels<1>(in, index, w, out, width);
+      case 2: return horizontal_fixed_pixels<2>(in, index, w, out, width);
+      case 3: return horizontal_fixed_pixels<3>(in, index, w, out, width);
+      case 4: return horizontal_fixed_pixels<4>(in, index, w, out, width);
+      }
+      for (size_t x { 0 }; x < width; ++x) {
+        const int32_t w0 { w[2 * x] }, w1 { w[2 * x + 1] };
+        const uint8_t *a { in + size_t(index[2 * x]) * channels };
+        const uint8_t *b { in + size_t(index[2 * x + 1]) * channels };
+        for (size_t c { 0 }; c < channels; ++c)
+          out[x * channels + c] = int16_t((w0 * a[c] + w1 * b[c]) >> 4);
+      }
+    }
+
+    ///////////////////////////////////// VERTICAL ///////////////////////////////////////
+
+    // samples of 7 fractional bits times weights of 11 keep 2 in the high halves, whose sum
+    // never exceeds 1020
+    void vertical_fixed(const int16_t *top, const int16_t *bottom, const int16_t w0,
+      const int16_t w1, uint8_t *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i) {
+        const auto a { int16_t((int32_t(top[i]) * w0) >> 16) };
+        const auto b { int16_t((int32_t(bottom[i]) * w1) >> 16) };
+        out[i] = uint8_t((a + b + 2) >> 2);
+      }
+    }
+
+  }  // namespace
+
+  void fill(resize_table &table) noexcept
+  {
+    table.horizontal = horizontal<float>;
+    table.horizontal_u8 = horizontal<uint8_t>;
+    table.horizontal_fixed = horizontal_fixed;
+    table.vertical_fixed = vertical_fixed;
+  }
+
+}  // namespace covdel::cv::detail::COVDEL_KERNEL_ISA
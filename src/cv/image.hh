@@ -0,0 +1,72 @@
+#ifndef __COVDEL_SRC_CV_IMAGE_HH_1701557340__
+#define __COVDEL_SRC_CV_IMAGE_HH_1701557340__
+
+#include "covdel/cv/filter.hh"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace covdel::cv::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // layout of an image as rows of interleaved channels
+  template<typename _Type>
+  struct image {
+    _Type *data;
+    size_t height, width, channels;
+    ptrdiff_t row, pixel, channel;
+
+    // pixels are contiguous within each row
+    bool packed() const noexcept { return channel == 1 && pixel == ptrdiff_t(channels); }
+  };
+
+  template<typename _DType>
+  auto layout(const ma::multiarray<_DType> &array)
+  {
+    using native = typename ma::multiarray<_DType>::native_type;
+    const int ndims { int(array.ndims()) };
+    if (ndims != 2 && ndims != 3)
+      throw std::invalid_argument { "images must have the shape (height, width) or "
+                                    "(height, width, channels), got "
+                                    + array.dim().str() };
+    const auto &dim { array.dim() };
+    const auto &s { array.strides() };
+    return image<native> { const_cast<native *>(array.data()), dim[0], dim[1],
+      ndims == 3 ? dim[2] : 1, s[0], s[1], ndims == 3 ? s[2] : 1 };
+  }
+
+  // lowest and highest addresses of the elements of an array
+  template<typename _Type>
+  std::pair<const char *, const char *> extent(const image<_Type> &img) noexcept
+  {
+    ptrdiff_t low { 0 }, high { 0 };
+    const std::array<std::pair<size_t, ptrdiff_t>, 3> axes { { { img.height, img.row },
+      { img.width, img.pixel }, { img.channels, img.channel } } };
+    for (const auto &[count, stride] : axes)
+      (stride < 0 ? low : high) += ptrdiff_t(count - 1) * stride;
+    const auto *base { reinterpret_cast<const char *>(img.data) };
+    return { base + low * ptrdiff_t(sizeof(_Type)),
+      base + (high + 1) * ptrdiff_t(sizeof(_Type)) };
+  }
+
+  // maps a coordinate beyond [0, count) inside it, or to -1 for the constant value
+  inline ptrdiff_t map_border(ptrdiff_t i, const size_t count, const border mode) noexcept
+  {
+    const auto n { ptrdiff_t(count) };
+    if (i >= 0 && i < n) return i;
+    if (mode == border::constant) return -1;
+    if (mode == border::replicate) return i < 0 ? 0 : n - 1;
+    if (n == 1) return 0;
+    const ptrdiff_t period { 2 * n - 2 };
+    i %= period;
+    if (i < 0) i += period;
+    return i < n ? i : period - i;
+  }
+
+}  // namespace covdel::cv::detail
+
+#endif
@@ -0,0 +1,186 @@
+#include "covdel/cv/imageio.hh"
+
+#include "covdel/ma/executor.hh"
+#include "formats.hh"
+#include "ma/files.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace covdel::cv
+{
+  namespace
+  {
+    image_format detect(const char *bytes, const size_t length)
+    {
+      if (length >= 8 && std::memcmp(bytes, "\x89PNG\r\n\x1A\n", 8) == 0)
+        return image_format::png;
+      if (length >= 2 && bytes[0] == 'B' && bytes[1] == 'M') return image_format::bmp;
+      if (length >= 2 && bytes[0] == 'P' && bytes[1] >= '1' && bytes[1] <= '6')
+        return image_format::pnm;
+      throw std::invalid_argument { "unrecognized image format" };
+    }
+
+    image_header parse_header(const char *bytes, const size_t length)
+    {
+      switch (detect(bytes, length)) {
+      case image_format::pnm: return detail::pnm_header(bytes, length);
+      case image_format::bmp: return detail::bmp_header(bytes, length);
+      default: return detail::png_header(bytes, length);
+      }
+    }
+
+    void decode(const image_header &header, const char *bytes, const size_t length,
+      uint8_t *out, const ptrdiff_t row_stride)
+    {
+      switch (header.format) {
+      case image_format::pnm: return detail::pnm_decode(bytes, length, out, row_stride);
+      case image_format::bmp: return detail::bmp_decode(bytes, length, out, row_stride);
+      default: return detail::png_decode(bytes, length, out, row_stride);
+      }
+    }
+
+    std::string extension(const std::filesystem::path &path)
+    {
+      std::string ext { path.extension().string() };
+      for (char &c : ext) c = char(std::tolower(static_cast<unsigned char>(c)));
+      return ext;
+    }
+
+    bool is_pnm(const std::string &ext) noexcept
+    {
+      return ext == ".pbm" || ext == ".pgm" || ext == ".ppm" || ext == ".pnm";
+    }
+
+    // the trailing (width, channels) axes must be laid out as packed pixels
+    void check_pixels(const ma::uint8 &array, const ma::dimension &dim)
+    {
+      if (array.dim() != dim)
+        throw std::invalid_argument { "expected an array of shape " + dim.str() + ", got "
+                                      + array.dim().str() };
+      const int axis { dim.ndims() - 1 };
+      if (array.strides()[axis] != 1 || array.strides()[axis - 1] != ptrdiff_t(dim[axis]))
+        throw std::invalid_argument { "image pixels must be contiguous within rows" };
+    }
+
+  }  // namespace
+
+  const uint8_t *detail::image_row(const ma::uint8 &image, const size_t y,
+    uint8_t *scratch) noexcept
+  {
+    const auto &s { image.strides() };
+    const size_t width { image.dim()[1] }, channels { image.dim()[2] };
+    const uint8_t *row { image.data() + ptrdiff_t(y) * s[0] };
+    if (s[2] == 1 && s[1] == ptrdiff_t(channels)) return row;
+
+    for (size_t x { 0 }; x < width; ++x)
+      for (size_t c { 0 }; c < channels; ++c)
+        scratch[x * channels + c] = row[ptrdiff_t(x) * s[1] + ptrdiff_t(c) * s[2]];
+    return scratch;
+  }
+
+  image_header inspect_image(const std::string &path)
+  {
+    const ma::detail::mapped_file file { path, ma::mapping::read_only };
+    return parse_header(file.addr, file.length);
+  }
+
+  void read_image(const std::string &path, ma::uint8 &out)
+  {
+    const ma::detail::mapped_file file { path, ma::mapping::read_only };
+    const auto header { parse_header(file.addr, file.length) };
+    check_pixels(out, header.dim);
+    decode(header, file.addr, file.length, out.data(), out.strides()[0]);
+  }
+
+  ma::uint8 read_image(const std::string &path)
+  {
+    const ma::detail::mapped_file file { path, ma::mapping::read_only };
+    const auto header { parse_header(file.addr, file.length) };
+    ma::uint8 out { header.dim, ma::uninitialized };
+    decode(header, file.addr, file.length, out.data(), out.strides()[0]);
+    return out;
+  }
+
+  void read_images(const std::vector<std::string> &paths, ma::uint8 &batch)
+  {
+    if (batch.ndims() != 4 || batch.dim()[0] != paths.size())
+      throw std::invalid_argument { "batch must have the shape (count, height, width, "
+                                    "channels)" };
+    const auto &dim { batch.dim() };
+    check_pixels(batch, dim);
+
+    const ma::dimension image_dim { dim[1], dim[2], dim[3] };
+    const auto &s { batch.strides() };
+    uint8_t *const data { batch.data() };
+    ma::default_executor().parallel_for(paths.size(), 1, [&](size_t begin, size_t end) {
+      for (; begin < end; ++begin) {
+        const ma::detail::mapped_file file { paths[begin], ma::mapping::read_only };
+        const auto header { parse_header(file.addr, file.length) };
+        if (header.dim != image_dim)
+          throw std::invalid_argument { paths[begin] + " has the shape "
+                                        + header.dim.str() + ", not " + image_dim.str() };
+        decode(header, file.addr, file.length, data + ptrdiff_t(begin) * s[0], s[1]);
+      }
+    });
+  }
+
+  std::vector<ma::uint8> read_images(const std::vector<std::string> &paths)
+  {
+    // arrays come from the calling thread's allocator, images are decoded in parallel
+    std::vector<ma::uint8> images;
+    images.reserve(paths.size());
+    for (const auto &path : paths)
+      images.emplace_back(inspect_image(path).dim, ma::uninitialized);
+
+    ma::default_executor().parallel_for(paths.size(), 1, [&](size_t begin, size_t end) {
+      for (; begin < end; ++begin) read_image(paths[begin], images[begin]);
+    });
+    return images;
+  }
+
+  std::vector<std::string> list_images(const std::string &directory)
+  {
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator { directory }) {
+      const std::string ext { extension(entry.path()) };
+      if (entry.is_regular_file() && (ext == ".png" || ext == ".bmp" || is_pnm(ext)))
+        paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+  }
+
+  void write_image(const std::string &path, const ma::uint8 &image, const int level)
+  {
+    if (image.ndims() != 3 || image.dim()[2] < 1 || image.dim()[2] > 4)
+      throw std::invalid_argument { "images must have the shape (height, width, "
+                                    "channels) with 1 to 4 channels" };
+    const std::string ext { extension(path) };
+    if (ext != ".png" && ext != ".bmp" && !is_pnm(ext))
+      throw std::invalid_argument { "no image format has the extension of " + path };
+    const size_t channels { image.dim()[2] };
+    if ((is_pnm(ext) && channels != 1 && channels != 3)
+        || (ext == ".bmp" && channels == 2))
+      throw std::invalid_argument { ext + " files cannot hold " + std::to_string(channels)
+                                    + " channels" };
+    if (level < 0 || level > 9)
+      throw std::invalid_argument { "compression level must be within 0 and 9" };
+
+    std::ofstream out { path, std::ios::binary | std::ios::trunc };
+    if (!out) ma::detail::fail("cannot create " + path);
+    out.exceptions(std::ios::badbit | std::ios::failbit);
+    if (ext == ".png")
+      detail::png_encode(out, image, level);
+    else if (ext == ".bmp")
+      detail::bmp_encode(out, image);
+    else
+      detail::pnm_encode(out, image);
+    out.close();
+  }
+
+}  // namespace covdel::cv
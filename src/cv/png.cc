@@ -0,0 +1,325 @@
+#include "formats.hh"
+
+#include "ma/codec.hh"
+#include "ma/zlib.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace covdel::cv::detail
+{
+  using ma::detail::deflater;
+  using ma::detail::inflater;
+
+  namespace
+  {
+    constexpr char SIGNATURE[] { "\x89PNG\r\n\x1A\n" };
+    constexpr int GRAY { 0 }, RGB { 2 }, PALETTE { 3 }, GRAY_ALPHA { 4 }, RGBA { 6 };
+
+    // bytes a chunk of IDAT is flushed at when writing
+    constexpr size_t CHUNK { 1 << 16 };
+
+    // interlaced passes as (x0, y0, dx, dy), a single one otherwise
+    constexpr std::array<std::array<size_t, 4>, 7> ADAM7 { { { 0, 0, 8, 8 },
+      { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 },
+      { 0, 1, 1, 2 } } };
+
+    struct png_info {
+      size_t width, height, channels;
+      int depth, color;
+      bool interlaced;
+      size_t samples;  // per pixel as stored
+      std::array<std::array<uint8_t, 4>, 256> palette;
+      std::vector<std::pair<const char *, size_t>> data;
+
+      // bytes of a stored row of `count` pixels, without its filter byte
+      size_t row_bytes(const size_t count) const noexcept
+      {
+        return (count * samples * size_t(depth) + 7) / 8;
+      }
+    };
+
+    // walks the chunks up to IEND, or only up to the first IDAT for headers
+    png_info parse(const char *bytes, const size_t length, const bool whole)
+    {
+      if (length < 8 || std::memcmp(bytes, SIGNATURE, 8) != 0)
+        malformed("png", "bad signature");
+      png_info info {};
+      bool header { false }, palette { false }, ended { false };
+      for (size_t pos { 8 }; !ended;) {
+        if (length - pos < 12) malformed("png", "truncated chunk");
+        const size_t size { read_be32(bytes + pos) };
+        const char *type { bytes + pos + 4 }, *data { bytes + pos + 8 };
+        if (size > length - pos - 12) malformed("png", "truncated chunk");
+        if (whole && read_be32(data + size) != ma::detail::crc32(0, type, size + 4))
+          malformed("png", "chunk checksum mismatch");
+        pos += size + 12;
+
+        const std::string name { type, 4 };
+        if (!header && name != "IHDR") malformed("png", "IHDR must come first");
+        if (name == "IHDR") {
+          if (header || size != 13) malformed("png", "bad IHDR");
+          header = true;
+          info.width = read_be32(data);
+          info.height = read_be32(data + 4);
+          info.depth = uint8_t(data[8]);
+          info.color = uint8_t(data[9]);
+          info.interlaced = data[12] == 1;
+          if (!info.width || !info.height || info.width > 0x7FFFFFFF
+              || info.height > 0x7FFFFFFF)
+            malformed("png", "bad extents");
+          if (data[10] || data[11] || uint8_t(data[12]) > 1)
+            malformed("png", "unknown compression, filter or interlace method");
+
+          const int d { info.depth };
+          const int c { info.color };
+          const bool low { d == 1 || d == 2 || d == 4 || d == 8 };
+          const bool high { d == 8 || d == 16 };
+          const bool valid { c == GRAY            ? low || d == 16
+                             : c == PALETTE       ? low
+                             : c == RGB || c == GRAY_ALPHA || c == RGBA ? high
+                                                  : false };
+          if (!valid) malformed("png", "bad colour type and bit depth");
+          info.samples = c == RGB ? 3 : c == GRAY_ALPHA ? 2 : c == RGBA ? 4 : 1;
+          info.channels = info.color == PALETTE ? 3 : info.samples;
+        } else if (name == "PLTE") {
+          if (size % 3 || size > 768) malformed("png", "bad PLTE");
+          palette = true;
+          for (size_t i { 0 }; i < size / 3; ++i)
+            info.palette[i] = { uint8_t(data[3 * i]), uint8_t(data[3 * i + 1]),
+              uint8_t(data[3 * i + 2]), 255 };
+        } else if (name == "tRNS" && info.color == PALETTE) {
+          // palette transparency makes rgba images, colour keys of other types are
+          // ignored
+          for (size_t i { 0 }; i < std::min<size_t>(size, 256); ++i)
+            info.palette[i][3] = uint8_t(data[i]);
+          info.channels = 4;
+        } else if (name == "IDAT") {
+          if (!whole) break;
+          info.data.emplace_back(data, size);
+        } else if (name == "IEND") {
+          ended = true;
+        } else if (!(type[0] & 0x20)) {
+          throw std::invalid_argument { "unsupported critical png chunk " + name };
+        }
+      }
+      if (info.color == PALETTE && !palette) malformed("png", "missing PLTE");
+      if (whole && info.data.empty()) malformed("png", "missing IDAT");
+      return info;
+    }
+
+    uint8_t paeth(const int a, const int b, const int c) noexcept
+    {
+      const int p { a + b - c }, pa { std::abs(p - a) }, pb { std::abs(p - b) },
+        pc { std::abs(p - c) };
+      return uint8_t(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+    }
+
+    // reverses the filter of a row into `dst`, `prior` is the previous row of the same
+    // pass or null for the first one, `bpp` is the distance of the left neighbours
+    void unfilter(const int filter, const uint8_t *src, const uint8_t *prior,
+      uint8_t *dst, const size_t count, const size_t bpp)
+    {
+      const size_t lead { std::min(bpp, count) };
+      switch (prior ? filter : filter == 2 ? 0 : filter == 4 ? 1 : filter) {
+      case 0: std::memcpy(dst, src, count); return;
+      case 1:
+        std::memcpy(dst, src, lead);
+        for (size_t i { bpp }; i < count; ++i) dst[i] = uint8_t(src[i] + dst[i - bpp]);
+        return;
+      case 2:
+        for (size_t i { 0 }; i < count; ++i) dst[i] = uint8_t(src[i] + prior[i]);
+        return;
+      case 3:
+        if (!prior) {
+          std::memcpy(dst, src, lead);
+          for (size_t i { bpp }; i < count; ++i)
+            dst[i] = uint8_t(src[i] + (dst[i - bpp] >> 1));
+          return;
+        }
+        for (size_t i { 0 }; i < lead; ++i) dst[i] = uint8_t(src[i] + (prior[i] >> 1));
+        for (size_t i { bpp }; i < count; ++i)
+          dst[i] = uint8_t(src[i] + ((dst[i - bpp] + prior[i]) >> 1));
+        return;
+      case 4:
+        for (size_t i { 0 }; i < lead; ++i) dst[i] = uint8_t(src[i] + prior[i]);
+        for (size_t i { bpp }; i < count; ++i)
+          dst[i] = uint8_t(src[i] + paeth(dst[i - bpp], prior[i], prior[i - bpp]));
+        return;
+      default: malformed("png", "unknown row filter");
+      }
+    }
+
+    // unpacks `count` stored pixels into every `dx`th pixel of an output row
+    void expand(const png_info &info, const uint8_t *raw, const size_t count,
+      uint8_t *out, const size_t dx)
+    {
+      const size_t channels { info.channels }, step { dx * channels };
+      if (info.depth == 16) {
+        // the most significant byte of each sample
+        for (size_t x { 0 }; x < count; ++x, out += step)
+          for (size_t c { 0 }; c < channels; ++c) out[c] = raw[2 * (x * channels + c)];
+      } else if (info.depth == 8 && info.color != PALETTE) {
+        for (size_t x { 0 }; x < count; ++x, out += step, raw += channels)
+          std::memcpy(out, raw, channels);
+      } else {
+        // low depth gray is scaled to 255, palette indices are looked up
+        const int depth { info.depth };
+        const unsigned mask { (1U << depth) - 1 }, scale { 255 / mask };
+        for (size_t x { 0 }; x < count; ++x, out += step) {
+          const size_t bit { x * size_t(depth) };
+          const unsigned shift { unsigned(8 - depth - int(bit & 7)) };
+          const unsigned value { unsigned(raw[bit >> 3]) >> shift & mask };
+          if (info.color == PALETTE)
+            std::memcpy(out, info.palette[value].data(), channels);
+          else
+            out[0] = uint8_t(value * scale);
+        }
+      }
+    }
+
+    void write_chunk(std::ostream &out, const char *type, const std::string &data)
+    {
+      std::string head;
+      write_be32(head, uint32_t(data.size()));
+      head.append(type, 4);
+      uint32_t crc { ma::detail::crc32(0, type, 4) };
+      crc = ma::detail::crc32(crc, data.data(), data.size());
+      std::string tail;
+      write_be32(tail, crc);
+      out.write(head.data(), std::streamsize(head.size()));
+      out.write(data.data(), std::streamsize(data.size()));
+      out.write(tail.data(), std::streamsize(tail.size()));
+    }
+
+  }  // namespace
+
+  image_header png_header(const char *bytes, const size_t length)
+  {
+    const auto info { parse(bytes, length, false) };
+    return { image_format::png,
+      ma::dimension { info.height, info.width, info.channels } };
+  }
+
+  void png_decode(const char *bytes, const size_t length, uint8_t *out,
+    const ptrdiff_t row_stride)
+  {
+    const auto info { parse(bytes, length, true) };
+    const size_t bpp { std::max<size_t>(info.samples * size_t(info.depth) / 8, 1) };
+    const size_t row { info.row_bytes(info.width) };
+    inflater in { info.data, row + 1 };
+
+    if (!info.interlaced && info.depth == 8 && info.color != PALETTE) {
+      // rows are unfiltered straight into the output, against the row above
+      const uint8_t *prior { nullptr };
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride) {
+        const uint8_t *src { in.next(row + 1) };
+        unfilter(src[0], src + 1, prior, out, row, bpp);
+        prior = out;
+      }
+      in.finish();
+      return;
+    }
+
+    // otherwise each pass keeps its two last stored rows
+    const auto rows { std::make_unique<uint8_t[]>(2 * row) };
+    uint8_t *current { rows.get() }, *previous { rows.get() + row };
+    const std::array<size_t, 4> single { 0, 0, 1, 1 };
+    for (int pass { 0 }; pass < (info.interlaced ? 7 : 1); ++pass) {
+      const auto &[x0, y0, dx, dy] { info.interlaced ? ADAM7[pass] : single };
+      if (x0 >= info.width || y0 >= info.height) continue;
+      const size_t count { (info.width - x0 + dx - 1) / dx };
+      const size_t bytes_count { info.row_bytes(count) };
+      bool first { true };
+      for (size_t y { y0 }; y < info.height; y += dy, first = false) {
+        const uint8_t *src { in.next(bytes_count + 1) };
+        unfilter(src[0], src + 1, first ? nullptr : previous, current, bytes_count, bpp);
+        uint8_t *row { out + ptrdiff_t(y) * row_stride + ptrdiff_t(x0 * info.channels) };
+        expand(info, current, count, row, dx);
+        std::swap(current, previous);
+      }
+    }
+    in.finish();
+  }
+
+  // 8-bit samples of the image's channels, each row filtered by whichever filter gives
+  // the smallest sum of absolute differences, as libpng does
+  void png_encode(std::ostream &out, const ma::uint8 &image, const int level)
+  {
+    const size_t height { image.dim()[0] }, width { image.dim()[1] };
+    const size_t channels { image.dim()[2] }, row { width * channels };
+    if (height > 0x7FFFFFFF || width > 0x7FFFFFFF)
+      throw std::invalid_argument { "image too large for a png file" };
+    out.write(SIGNATURE, 8);
+
+    std::string ihdr;
+    write_be32(ihdr, uint32_t(width));
+    write_be32(ihdr, uint32_t(height));
+    constexpr int COLOR[] { 0, GRAY, GRAY_ALPHA, RGB, RGBA };
+    ihdr += { char(8), char(COLOR[channels]), 0, 0, 0 };
+    write_chunk(out, "IHDR", ihdr);
+
+    // a buffer per filter, two for gathered rows, and the zeros above the first row
+    const auto buffers { std::make_unique<uint8_t[]>(8 * (row + 1)) };
+    std::array<uint8_t *, 8> rows;
+    for (size_t k { 0 }; k < 8; ++k) rows[k] = buffers.get() + k * (row + 1);
+    std::fill_n(rows[7], row + 1, uint8_t(0));
+
+    deflater compressor { level };
+    const uint8_t *prior { rows[7] };
+    for (size_t y { 0 }; y < height; ++y) {
+      const uint8_t *cur { image_row(image, y, rows[5 + (y & 1)]) };
+      for (int f { 0 }; f < (level ? 5 : 1); ++f) {
+        uint8_t *dst { rows[size_t(f)] };
+        *dst++ = uint8_t(f);
+        const size_t lead { std::min(channels, row) };
+        switch (f) {
+        case 0: std::memcpy(dst, cur, row); break;
+        case 1:
+          std::memcpy(dst, cur, lead);
+          for (size_t i { channels }; i < row; ++i)
+            dst[i] = uint8_t(cur[i] - cur[i - channels]);
+          break;
+        case 2:
+          for (size_t i { 0 }; i < row; ++i) dst[i] = uint8_t(cur[i] - prior[i]);
+          break;
+        case 3:
+          for (size_t i { 0 }; i < lead; ++i) dst[i] = uint8_t(cur[i] - (prior[i] >> 1));
+          for (size_t i { channels }; i < row; ++i)
+            dst[i] = uint8_t(cur[i] - ((cur[i - channels] + prior[i]) >> 1));
+          break;
+        default:
+          for (size_t i { 0 }; i < lead; ++i) dst[i] = uint8_t(cur[i] - prior[i]);
+          for (size_t i { channels }; i < row; ++i)
+            dst[i] = uint8_t(
+              cur[i] - paeth(cur[i - channels], prior[i], prior[i - channels]));
+        }
+      }
+
+      int best { 0 };
+      if (level) {
+        uint64_t best_sum { ~uint64_t(0) };
+        for (int f { 0 }; f < 5; ++f) {
+          uint64_t sum { 0 };
+          const auto *filtered { reinterpret_cast<const int8_t *>(rows[size_t(f)] + 1) };
+          for (size_t i { 0 }; i < row; ++i) sum += uint64_t(std::abs(int(filtered[i])));
+          if (sum < best_sum) best_sum = sum, best = f;
+        }
+      }
+      compressor.write(rows[size_t(best)], row + 1);
+      if (compressor.output().size() >= CHUNK) {
+        write_chunk(out, "IDAT", compressor.output());
+        compressor.output().clear();
+      }
+      prior = cur;
+    }
+    compressor.finish();
+    write_chunk(out, "IDAT", compressor.output());
+    write_chunk(out, "IEND", {});
+  }
+
+}  // namespace covdel::cv::detail
@@ -0,0 +1,162 @@
+#include "formats.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace covdel::cv::detail
+{
+  namespace
+  {
+    // P1 and P4 are bitmaps where 1 is black, P2 and P5 gray maps, P3 and P6 pixmaps, the
+    // first three written in ascii and the others in binary
+    struct pnm_info {
+      int kind;
+      size_t width, height, channels;
+      unsigned maxval;
+      size_t raster;  // offset of the samples
+    };
+
+    bool is_space(const char c) noexcept
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // skips whitespace and comments up to the next number
+    size_t skip(const char *bytes, const size_t length, size_t pos) noexcept
+    {
+      while (pos < length) {
+        if (bytes[pos] == '#')
+          while (pos < length && bytes[pos] != '\n') ++pos;
+        else if (is_space(bytes[pos]))
+          ++pos;
+        else
+          break;
+      }
+      return pos;
+    }
+
+    size_t number(const char *bytes, const size_t length, size_t &pos)
+    {
+      pos = skip(bytes, length, pos);
+      if (pos == length || bytes[pos] < '0' || bytes[pos] > '9')
+        malformed("pnm", "expected a number");
+      size_t value { 0 };
+      for (; pos < length && bytes[pos] >= '0' && bytes[pos] <= '9'; ++pos) {
+        value = value * 10 + size_t(bytes[pos] - '0');
+        if (value > (size_t(1) << 32)) malformed("pnm", "number out of range");
+      }
+      return value;
+    }
+
+    pnm_info parse(const char *bytes, const size_t length)
+    {
+      if (length < 3 || bytes[0] != 'P' || bytes[1] < '1' || bytes[1] > '6')
+        malformed("pnm", "bad signature");
+      pnm_info info {};
+      info.kind = bytes[1] - '0';
+      size_t pos { 2 };
+      info.width = number(bytes, length, pos);
+      info.height = number(bytes, length, pos);
+      info.channels = info.kind == 3 || info.kind == 6 ? 3 : 1;
+      const bool bitmap { info.kind == 1 || info.kind == 4 };
+      info.maxval = bitmap ? 1 : unsigned(number(bytes, length, pos));
+      if (!info.width || !info.height) malformed("pnm", "empty image");
+      if (info.width > 8 * length || info.height > 8 * length / info.width)
+        malformed("pnm", "image larger than the file");
+      if (!info.maxval || info.maxval > 65535) malformed("pnm", "bad maximum value");
+
+      // a single whitespace separates the header from binary samples
+      if (pos == length || !is_space(bytes[pos])) malformed("pnm", "truncated header");
+      info.raster = pos + 1;
+      if (info.kind >= 4) {
+        const size_t sample { info.maxval > 255 ? size_t(2) : 1 };
+        const size_t row { info.kind == 4 ? (info.width + 7) / 8
+                                          : info.width * info.channels * sample };
+        if ((length - info.raster) / row < info.height)
+          malformed("pnm", "truncated samples");
+      }
+      return info;
+    }
+
+    // samples of other maximum values are scaled to 255, rounding to nearest
+    std::array<uint8_t, 256> scale_table(const unsigned maxval) noexcept
+    {
+      std::array<uint8_t, 256> table {};
+      for (unsigned v { 0 }; v < 256; ++v)
+        table[v] = uint8_t((std::min(v, maxval) * 255 + maxval / 2) / maxval);
+      return table;
+    }
+
+  }  // namespace
+
+  image_header pnm_header(const char *bytes, const size_t length)
+  {
+    const auto info { parse(bytes, length) };
+    return { image_format::pnm,
+      ma::dimension { info.height, info.width, info.channels } };
+  }
+
+  void pnm_decode(const char *bytes, const size_t length, uint8_t *out,
+    const ptrdiff_t row_stride)
+  {
+    const auto info { parse(bytes, length) };
+    const size_t samples { info.width * info.channels };
+    const auto *raster { reinterpret_cast<const uint8_t *>(bytes + info.raster) };
+
+    if (info.kind == 4) {
+      const size_t row { (info.width + 7) / 8 };
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride, raster += row)
+        for (size_t x { 0 }; x < info.width; ++x)
+          out[x] = raster[x >> 3] >> (7 - (x & 7)) & 1 ? 0 : 255;
+    } else if (info.kind >= 5 && info.maxval == 255) {
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride, raster += samples)
+        std::memcpy(out, raster, samples);
+    } else if (info.kind >= 5 && info.maxval < 256) {
+      const auto table { scale_table(info.maxval) };
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride, raster += samples)
+        for (size_t i { 0 }; i < samples; ++i) out[i] = table[raster[i]];
+    } else if (info.kind >= 5) {
+      // 16-bit samples are big-endian
+      const uint32_t maxval { info.maxval };
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride, raster += 2 * samples)
+        for (size_t i { 0 }; i < samples; ++i) {
+          const uint32_t v { std::min<uint32_t>(raster[2 * i] << 8 | raster[2 * i + 1],
+            maxval) };
+          out[i] = uint8_t((v * 255 + maxval / 2) / maxval);
+        }
+    } else {
+      // ascii bitmaps may run their digits together
+      size_t pos { info.raster };
+      const uint32_t maxval { info.maxval };
+      for (size_t y { 0 }; y < info.height; ++y, out += row_stride)
+        for (size_t i { 0 }; i < samples; ++i) {
+          if (info.kind == 1) {
+            pos = skip(bytes, length, pos);
+            if (pos == length || (bytes[pos] != '0' && bytes[pos] != '1'))
+              malformed("pnm", "expected a bit");
+            out[i] = bytes[pos++] == '1' ? 0 : 255;
+            continue;
+          }
+          const size_t v { std::min<size_t>(number(bytes, length, pos), maxval) };
+          out[i] = uint8_t((v * 255 + maxval / 2) / maxval);
+        }
+    }
+  }
+
+  void pnm_encode(std::ostream &out, const ma::uint8 &image)
+  {
+    const size_t height { image.dim()[0] }, width { image.dim()[1] };
+    const size_t channels { image.dim()[2] };
+    const std::string header { (channels == 1 ? "P5\n" : "P6\n") + std::to_string(width)
+                               + " " + std::to_string(height) + "\n255\n" };
+    out.write(header.data(), std::streamsize(header.size()));
+
+    const auto scratch { std::make_unique<uint8_t[]>(width * channels) };
+    for (size_t y { 0 }; y < height; ++y)
+      out.write(reinterpret_cast<const char *>(image_row(image, y, scratch.get())),
+        std::streamsize(width * channels));
+  }
+
+}  // namespace covdel::cv::detail
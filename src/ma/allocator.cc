@@ -0,0 +1,211 @@
+#include "covdel/ma/allocator.hh"
+
+#include <array>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace covdel::ma
+{
+  namespace
+  {
+    constexpr std::align_val_t ALIGN { ALIGNMENT };
+
+    // four classes per power of two from 64B up to 4GiB, the first one covering [0, 64]
+    constexpr int MIN_LOG { 6 }, MAX_LOG { 32 };
+    constexpr int CLASSES { (MAX_LOG - MIN_LOG) * 4 + 1 };
+
+    // class index and rounded size of a request, CLASSES when it is too large to cache
+    std::pair<int, size_t> size_class(const size_t bytes) noexcept
+    {
+      if (bytes <= (size_t(1) << MIN_LOG)) return { 0, size_t(1) << MIN_LOG };
+      if (bytes > (size_t(1) << MAX_LOG)) return { CLASSES, bytes };
+
+      // 2^k < bytes <= 2^(k + 1), split into quarters
+      const int k { 63 - __builtin_clzll(bytes - 1) };
+      const size_t step { size_t(1) << (k - 2) };
+      const size_t j { (bytes - (size_t(1) << k) + step - 1) / step };
+      return { (k - MIN_LOG) * 4 + int(j), (size_t(1) << k) + j * step };
+    }
+
+    void *heap_allocate(const size_t bytes) { return ::operator new(bytes, ALIGN); }
+
+    void heap_deallocate(void *ptr) noexcept { ::operator delete(ptr, ALIGN); }
+
+    // set once the calling thread's cache is destroyed, buffers released by destructors
+    // running later during thread exit go straight back to the heap
+    thread_local bool t_exited { false };
+
+    thread_local allocator *t_default { nullptr };
+
+  }  // namespace
+
+  namespace detail
+  {
+    struct thread_cache {
+      ~thread_cache()
+      {
+        release();
+        t_exited = true;
+      }
+
+      void release() noexcept
+      {
+        auto &pool { pool_allocator::instance() };
+        for (int c { -1 }; ++c < CLASSES;) {
+          for (void *ptr : m_free[c]) heap_deallocate(ptr);
+          m_free[c].clear();
+        }
+        pool.m_cached.fetch_sub(m_bytes, std::memory_order_relaxed);
+        m_bytes = 0;
+      }
+
+      std::array<std::vector<void *>, CLASSES> m_free;
+      size_t m_bytes { 0 };
+    };
+
+  }  // namespace detail
+
+  namespace
+  {
+    thread_local detail::thread_cache t_cache;
+  }
+
+  ////////////////////////////////// ALIGNED ALLOCATOR ///////////////////////////////////
+
+  void *aligned_allocator::allocate(const size_t bytes)
+  {
+    return heap_allocate(bytes ? bytes : 1);
+  }
+
+  void aligned_allocator::deallocate(void *ptr, size_t) noexcept
+  {
+    heap_deallocate(ptr);
+  }
+
+  aligned_allocator &aligned_allocator::instance() noexcept
+  {
+    static aligned_allocator s_allocator;
+    return s_allocator;
+  }
+
+  /////////////////////////////////// POOL ALLOCATOR /////////////////////////////////////
+
+  void *pool_allocator::allocate(const size_t bytes)
+  {
+    const auto [cls, size] = size_class(bytes);
+    if (cls < CLASSES && !t_exited) {
+      auto &cached { t_cache.m_free[cls] };
+      if (!cached.empty()) {
+        void *ptr { cached.back() };
+        cached.pop_back();
+        t_cache.m_bytes -= size;
+        m_cached.fetch_sub(size, std::memory_order_relaxed);
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+      }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return heap_allocate(size);
+  }
+
+  void pool_allocator::deallocate(void *ptr, const size_t bytes) noexcept
+  {
+    if (!ptr) return;
+
+    const auto [cls, size] = size_class(bytes);
+    if (cls < CLASSES && !t_exited
+      && t_cache.m_bytes + size <= m_limit.load(std::memory_order_relaxed)) {
+      try {
+        t_cache.m_free[cls].push_back(ptr);
+      } catch (const std::bad_alloc &) {
+        heap_deallocate(ptr);
+        return;
+      }
+      t_cache.m_bytes += size;
+      m_cached.fetch_add(size, std::memory_order_relaxed);
+      return;
+    }
+    heap_deallocate(ptr);
+  }
+
+  pool_allocator::statistics pool_allocator::stats() const noexcept
+  {
+    return { m_hits.load(), m_misses.load(), m_cached.load() };
+  }
+
+  void pool_allocator::reset_stats() noexcept
+  {
+    m_hits.store(0);
+    m_misses.store(0);
+  }
+
+  size_t pool_allocator::limit() const noexcept
+  {
+    return m_limit.load();
+  }
+
+  void pool_allocator::set_limit(const size_t bytes) noexcept
+  {
+    m_limit.store(bytes);
+  }
+
+  void pool_allocator::trim() noexcept
+  {
+    if (!t_exited) t_cache.release();
+  }
+
+  pool_allocator &pool_allocator::instance() noexcept
+  {
+    static pool_allocator s_allocator;
+    return s_allocator;
+  }
+
+  ///////////////////////////////// TRACKING ALLOCATOR /////////////////////////////////
+
+  tracking_allocator::tracking_allocator(allocator &upstream) noexcept
+    : p_upstream { &upstream }
+  { }
+
+  void *tracking_allocator::allocate(const size_t bytes)
+  {
+    void *ptr { p_upstream->allocate(bytes) };
+    const size_t live { m_live.fetch_add(bytes, std::memory_order_relaxed) + bytes };
+    size_t peak { m_peak.load(std::memory_order_relaxed) };
+    while (peak < live && !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+      ;
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  void tracking_allocator::deallocate(void *ptr, const size_t bytes) noexcept
+  {
+    if (!ptr) return;
+    p_upstream->deallocate(ptr, bytes);
+    m_live.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  tracking_allocator::statistics tracking_allocator::stats() const noexcept
+  {
+    return { m_live.load(), m_peak.load(), m_allocations.load() };
+  }
+
+  void tracking_allocator::reset_peak() noexcept
+  {
+    m_peak.store(m_live.load());
+    m_allocations.store(0);
+  }
+
+  ////////////////////////////////// DEFAULT ALLOCATOR ///////////////////////////////////
+
+  allocator &default_allocator() noexcept
+  {
+    return t_default ? *t_default : pool_allocator::instance();
+  }
+
+  void set_default_allocator(allocator &alloc) noexcept
+  {
+    t_default = &alloc;
+  }
+
+}  // namespace covdel::ma
@@ -0,0 +1,224 @@
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/instrument.hh"
+
+#include "kernels.hh"
+#include "parallel.hh"
+
+#include <stdexcept>
+
+namespace covdel::ma::detail
+{
+  namespace
+  {
+    // input viewed with the output's shape, never expanded beyond a small tile
+    template<typename _DType, typename _RType>
+    multiarray<_DType> prepare(const multiarray<_DType> &a, const multiarray<_RType> &out)
+    {
+      return tiled(unaliased(a, out).broadcast_to(out.dim()));
+    }
+
+  }  // namespace
+
+  ////////////////////////////////////// TILING ////////////////////////////////////////
+
+  // innermost runs shorter than this are worth tiling broadcast operands for
+  static constexpr size_t SHORT_RUN { 16 };
+  // tiles grow over trailing axes until runs reach this many elements
+  static constexpr size_t TILE_RUN { 1024 };
+  // largest tile of a broadcast operand, in elements, kept cache resident
+  static constexpr size_t MAX_TILE { 1UL << 14 };
+
+  // an operand broadcast over a short innermost extent, like (3) against (H, W, 3), makes
+  // every run as short as that extent, so its pattern is repeated over the trailing axes
+  // into a small cache resident tile, which leaves contiguous runs of a full row instead
+  template<typename _DType>
+  multiarray<_DType> tiled(const multiarray<_DType> &view)
+  {
+    const auto &dim { view.dim() };
+    const auto &strides { view.strides() };
+    const int ndims { dim.ndims() };
+    if (ndims < 2 || view.size() == 0 || dim[ndims - 1] >= SHORT_RUN) return view;
+
+    // the tile spans the trailing axes from `first`, leading axes must all be broadcast
+    int first { ndims };
+    size_t tile { 1 };
+    bool repeats { false };
+    while (first > 0 && tile < TILE_RUN && tile * dim[first - 1] <= MAX_TILE) {
+      tile *= dim[--first];
+      repeats |= strides[first] == 0 && dim[first] > 1;
+    }
+    for (int i { 0 }; i < first; ++i)
+      if (strides[i] != 0 && dim[i] > 1) return view;
+    if (!repeats || first == ndims - 1) return view;
+
+    auto pattern { view };
+    for (int i { 0 }; i < first; ++i) pattern = pattern.slice(i, 0, 1);
+    return pattern.copy().broadcast_to(dim);
+  }
+
+  ////////////////////////////////////// KERNELS ///////////////////////////////////////
+
+  template<typename _DType, typename _RType>
+  binary_kernel<typename _DType::type, typename _RType::type> find_kernel(const binary_op op)
+  {
+    using native_type = typename _DType::type;
+    using result_type = typename _RType::type;
+
+    binary_kernel<native_type, result_type> kernel {};
+    if (int(op) < ARITHMETIC_OPS) {
+      if constexpr (std::is_same_v<native_type, result_type>)
+        kernel = kernels<native_type>().arithmetic[int(op)];
+    } else if constexpr (std::is_same_v<result_type, bool>)
+      kernel = kernels<native_type>().comparison[int(op) - int(binary_op::equal)];
+    if (!kernel) throw std::logic_error { "operation does not yield this datatype" };
+    return kernel;
+  }
+
+  template<typename _DType>
+  unary_kernel<typename _DType::type> find_kernel(const unary_op op)
+  {
+    return kernels<typename _DType::type>().unary[int(op)];
+  }
+
+  template<typename _DType>
+  clamp_kernel<typename _DType::type> find_clamp_kernel()
+  {
+    return kernels<typename _DType::type>().clamp;
+  }
+
+  template<typename _DType>
+  convert_kernel<typename _DType::type> find_convert_kernel(const datatype type)
+  {
+    return kernels<typename _DType::type>().convert[int(type)];
+  }
+
+  ////////////////////////////////////// BINARY ////////////////////////////////////////
+
+  template<typename _DType, typename _RType>
+  void binary(const binary_op op, const elementwise_arg<_DType> &a,
+    const elementwise_arg<_DType> &b, multiarray<_RType> &out)
+  {
+    using native_type = typename multiarray<_DType>::native_type;
+    using result_type = typename multiarray<_RType>::native_type;
+    COVDEL_PROBE(
+      operation::elementwise, _DType::s_type, out.size() * sizeof(result_type));
+
+    const auto kernel { find_kernel<_DType, _RType>(op) };
+    const operand result { out.data(), out.strides() };
+    if (a.array && b.array) {
+      const auto lhs { prepare(*a.array, out) }, rhs { prepare(*b.array, out) };
+      parallel_runs(
+        out.dim(),
+        [kernel](result_type *o, const native_type *x, const native_type *y, ptrdiff_t so,
+          ptrdiff_t sx, ptrdiff_t sy, size_t count) { kernel(x, sx, y, sy, o, so, count); },
+        result, operand { lhs.data(), lhs.strides() }, operand { rhs.data(), rhs.strides() });
+    } else if (a.array) {
+      const auto lhs { prepare(*a.array, out) };
+      const native_type *y { &b.value };
+      parallel_runs(
+        out.dim(),
+        [kernel, y](result_type *o, const native_type *x, ptrdiff_t so, ptrdiff_t sx,
+          size_t count) { kernel(x, sx, y, 0, o, so, count); },
+        result, operand { lhs.data(), lhs.strides() });
+    } else if (b.array) {
+      const auto rhs { prepare(*b.array, out) };
+      const native_type *x { &a.value };
+      parallel_runs(
+        out.dim(),
+        [kernel, x](result_type *o, const native_type *y, ptrdiff_t so, ptrdiff_t sy,
+          size_t count) { kernel(x, 0, y, sy, o, so, count); },
+        result, operand { rhs.data(), rhs.strides() });
+    } else
+      throw std::invalid_argument { "at least one operand must be an array" };
+  }
+
+  /////////////////////////////////////// UNARY ////////////////////////////////////////
+
+  template<typename _DType>
+  void unary(const unary_op op, const multiarray<_DType> &a, multiarray<_DType> &out)
+  {
+    using native_type = typename multiarray<_DType>::native_type;
+
+    COVDEL_PROBE(
+      operation::elementwise, _DType::s_type, out.size() * sizeof(native_type));
+
+    const auto kernel { find_kernel<_DType>(op) };
+    const auto src { prepare(a, out) };
+    parallel_runs(
+      out.dim(),
+      [kernel](native_type *o, const native_type *x, ptrdiff_t so, ptrdiff_t sx,
+        size_t count) { kernel(x, sx, o, so, count); },
+      operand { out.data(), out.strides() }, operand { src.data(), src.strides() });
+  }
+
+  template<typename _DType>
+  void clamp(const multiarray<_DType> &a, const typename multiarray<_DType>::native_type lo,
+    const typename multiarray<_DType>::native_type hi, multiarray<_DType> &out)
+  {
+    using native_type = typename multiarray<_DType>::native_type;
+
+    COVDEL_PROBE(
+      operation::elementwise, _DType::s_type, out.size() * sizeof(native_type));
+
+    const auto kernel { find_clamp_kernel<_DType>() };
+    const auto src { prepare(a, out) };
+    parallel_runs(
+      out.dim(),
+      [kernel, lo, hi](native_type *o, const native_type *x, ptrdiff_t so, ptrdiff_t sx,
+        size_t count) { kernel(x, sx, lo, hi, o, so, count); },
+      operand { out.data(), out.strides() }, operand { src.data(), src.strides() });
+  }
+
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+#define ELEMENTWISE_INSTANTIATIONS(type)                                              \
+ template binary_kernel<typename multiarray<type>::native_type,                         \
+   typename multiarray<type>::native_type>                                             \
+ find_kernel<type, type>(const binary_op);                                             \
+ template unary_kernel<typename multiarray<type>::native_type> find_kernel<type>(      \
+   const unary_op);                                                                    \
+ template clamp_kernel<typename multiarray<type>::native_type>                         \
+ find_clamp_kernel<type>();                                                            \
+ template convert_kernel<typename multiarray<type>::native_type>                       \
+ find_convert_kernel<type>(const datatype);                                            \
+ template multiarray<type> tiled<type>(const multiarray<type> &);                      \
+ template void binary<type, type>(const binary_op, const elementwise_arg<type> &,      \
+   const elementwise_arg<type> &, multiarray<type> &);                                \
+ template void unary<type>(                                                           \
+   const unary_op, const multiarray<type> &, multiarray<type> &);                     \
+ template void clamp<type>(const multiarray<type> &,                                   \
+   const typename multiarray<type>::native_type,                                       \
+   const typename multiarray<type>::native_type, multiarray<type> &);
+
+  // bool8 comparisons are served by its arithmetic instantiation above
+#define COMPARISON_INSTANTIATIONS(type)                                               \
+ template binary_kernel<typename multiarray<type>::native_type, bool>                   \
+ find_kernel<type, dtype::bool8>(const binary_op);                                     \
+ template void binary<type, dtype::bool8>(const binary_op,                             \
+   const elementwise_arg<type> &, const elementwise_arg<type> &,                       \
+   multiarray<dtype::bool8> &);
+
+  ELEMENTWISE_INSTANTIATIONS(dtype::bool8);
+  ELEMENTWISE_INSTANTIATIONS(dtype::int8);
+  ELEMENTWISE_INSTANTIATIONS(dtype::int16);
+  ELEMENTWISE_INSTANTIATIONS(dtype::int32);
+  ELEMENTWISE_INSTANTIATIONS(dtype::int64);
+  ELEMENTWISE_INSTANTIATIONS(dtype::uint8);
+  ELEMENTWISE_INSTANTIATIONS(dtype::uint16);
+  ELEMENTWISE_INSTANTIATIONS(dtype::uint32);
+  ELEMENTWISE_INSTANTIATIONS(dtype::uint64);
+  ELEMENTWISE_INSTANTIATIONS(dtype::float32);
+  ELEMENTWISE_INSTANTIATIONS(dtype::float64);
+
+  COMPARISON_INSTANTIATIONS(dtype::int8);
+  COMPARISON_INSTANTIATIONS(dtype::int16);
+  COMPARISON_INSTANTIATIONS(dtype::int32);
+  COMPARISON_INSTANTIATIONS(dtype::int64);
+  COMPARISON_INSTANTIATIONS(dtype::uint8);
+  COMPARISON_INSTANTIATIONS(dtype::uint16);
+  COMPARISON_INSTANTIATIONS(dtype::uint32);
+  COMPARISON_INSTANTIATIONS(dtype::uint64);
+  COMPARISON_INSTANTIATIONS(dtype::float32);
+  COMPARISON_INSTANTIATIONS(dtype::float64);
+
+}  // namespace covdel::ma::detail
@@ -0,0 +1,42 @@
+#ifndef __COVDEL_SRC_MA_CACHE_HH_1703542170__
+#define __COVDEL_SRC_MA_CACHE_HH_1703542170__
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <utility>
+
+namespace covdel::ma::detail
+{
+  // values of the most recently used keys, those missing computed outside the lock by
+  // `get`, so that concurrent misses of a key compute it twice
+  template<typename _Key, typename _Value, std::size_t _Capacity>
+  class mru_cache {
+  public:
+    template<typename _Compute>
+    _Value get(const _Key &key, _Compute &&compute)
+    {
+      {
+        const std::lock_guard lock { m_mutex };
+        for (auto it { m_entries.begin() }; it != m_entries.end(); ++it)
+          if (it->first == key) {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return it->second;
+          }
+      }
+
+      _Value computed { compute() };
+      const std::lock_guard lock { m_mutex };
+      m_entries.emplace_front(key, computed);
+      if (m_entries.size() > _Capacity) m_entries.pop_back();
+      return computed;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::list<std::pair<_Key, _Value>> m_entries;  // most recently used first
+  };
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,510 @@
+#include "covdel/ma/chunked.hh"
+
+#include "codec.hh"
+#include "files.hh"
+#include "parallel.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace covdel::ma
+{
+  namespace
+  {
+    using detail::read_le;
+    using detail::write_le;
+    using extents = std::array<size_t, 6>;
+
+    // the fixed header is followed by the tiles, then by the index, holding the offset and
+    // size of every tile in row-major order, an offset of 0 marking tiles never written,
+    // and the trailer, holding the offset of the index
+    constexpr char MAGIC[] { "CVDLTILE" }, END_MAGIC[] { "CVDLTEND" };
+    constexpr size_t VERSION { 1 }, HEADER { 128 }, TRAILER { 16 }, ENTRY { 16 };
+    constexpr uint64_t SHUFFLED { 1 };
+
+    constexpr size_t WIDTHS[] { 1, 1, 2, 4, 8, 1, 2, 4, 8, 4, 8 };
+
+    // blocks are compressed in batches of about this many bytes
+    constexpr size_t BATCH { size_t(1) << 26 };
+
+    [[noreturn]] void malformed(const std::string &what)
+    {
+      throw std::invalid_argument { "malformed chunked file, " + what };
+    }
+
+    template<typename _MultiArray>
+    struct array_traits;
+
+    template<typename _DType>
+    struct array_traits<multiarray<_DType>> {
+      using dtype = _DType;
+    };
+
+    // tiles of a dimension along every axis, rounded up
+    extents tile_counts(const dimension &dim, const dimension &tile) noexcept
+    {
+      extents counts {};
+      for (int i { -1 }; ++i < dim.ndims();) counts[i] = (dim[i] + tile[i] - 1) / tile[i];
+      return counts;
+    }
+
+    // calls `func(coords)` over the tile coordinates [lo, hi) in row-major order
+    template<typename _Func>
+    void for_each_tile(const int ndims, const extents &lo, const extents &hi, _Func &&func)
+    {
+      for (int i { -1 }; ++i < ndims;)
+        if (lo[i] >= hi[i]) return;
+      extents coords { lo };
+      while (true) {
+        func(coords);
+        int axis { ndims };
+        while (--axis >= 0 && ++coords[axis] == hi[axis]) coords[axis] = lo[axis];
+        if (axis < 0) return;
+      }
+    }
+
+    size_t flat(const int ndims, const extents &coords, const extents &counts) noexcept
+    {
+      size_t id { 0 };
+      for (int i { -1 }; ++i < ndims;) id = id * counts[i] + coords[i];
+      return id;
+    }
+
+    // origin and clipped extent of a tile, and its number of elements
+    struct tile_box {
+      extents origin, extent;
+      size_t size;
+    };
+
+    tile_box box_of(const dimension &dim, const dimension &tile, const extents &coords)
+    {
+      tile_box box { {}, {}, 1 };
+      for (int i { -1 }; ++i < dim.ndims();) {
+        box.origin[i] = coords[i] * tile[i];
+        box.extent[i] = std::min(tile[i], dim[i] - box.origin[i]);
+        box.size *= box.extent[i];
+      }
+      return box;
+    }
+
+    std::array<ptrdiff_t, 6> row_major(const int ndims, const extents &extent) noexcept
+    {
+      std::array<ptrdiff_t, 6> steps {};
+      ptrdiff_t step { 1 };
+      for (int i { ndims }; i-- > 0;) steps[i] = step, step *= ptrdiff_t(extent[i]);
+      return steps;
+    }
+
+    // shuffled, compressed and kept raw when that does not pay off
+    std::string encode(const char *raw, const size_t count, const size_t width,
+      const bool shuffle)
+    {
+      const size_t bytes { count * width };
+      std::string blob(detail::lz_bound(bytes), '\0');
+      size_t size;
+      if (shuffle && width > 1) {
+        const std::unique_ptr<char[]> shuffled { new char[bytes] };
+        detail::shuffle(raw, count, width, shuffled.get());
+        size = detail::lz_compress(shuffled.get(), bytes, blob.data());
+      } else
+        size = detail::lz_compress(raw, bytes, blob.data());
+      if (size >= bytes) return std::string { raw, bytes };
+      blob.resize(size);
+      return blob;
+    }
+
+  }  // namespace
+
+  /////////////////////////////////// CHUNKED WRITER /////////////////////////////////////
+
+  chunked_writer::chunked_writer(const std::string &path, const datatype type,
+    const dimension &dim, const dimension &tile, const bool shuffle)
+    : m_out {}, m_type { type }, m_dim { dim }, m_tile { tile }, m_shuffle { shuffle },
+      m_index {}
+  {
+    if (tile.ndims() != dim.ndims())
+      throw std::invalid_argument { "tiles must have as many dimensions as the array" };
+    size_t bytes { WIDTHS[int(type)] };
+    for (int i { -1 }; ++i < dim.ndims();) {
+      if (tile[i] == 0) throw std::invalid_argument { "tile extents must be positive" };
+      bytes *= tile[i];
+    }
+    if (bytes >= (size_t(1) << 32))
+      throw std::invalid_argument { "tiles must be under 4GiB" };
+
+    const extents counts { tile_counts(dim, tile) };
+    size_t tiles { 1 };
+    for (int i { -1 }; ++i < dim.ndims();) tiles *= counts[i];
+    m_index.assign(tiles, { 0, 0 });
+
+    m_out.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_out) detail::fail("cannot create " + path);
+    m_out.exceptions(std::ios::badbit | std::ios::failbit);
+
+    std::string header { MAGIC, 8 };
+    write_le(header, VERSION, 2);
+    write_le(header, uint64_t(type), 1);
+    write_le(header, uint64_t(dim.ndims()), 1);
+    write_le(header, shuffle ? SHUFFLED : 0, 4);
+    for (int i { -1 }; ++i < 6;) write_le(header, i < dim.ndims() ? dim[i] : 0, 8);
+    for (int i { -1 }; ++i < 6;) write_le(header, i < dim.ndims() ? tile[i] : 0, 8);
+    header.resize(HEADER, '\0');
+    m_out.write(header.data(), std::streamsize(header.size()));
+  }
+
+  chunked_writer::~chunked_writer() noexcept
+  {
+    try {
+      close();
+    } catch (...) { }
+  }
+
+  template<typename _DType>
+  void chunked_writer::write(const index &origin, const multiarray<_DType> &block)
+  {
+    using native_type = typename multiarray<_DType>::native_type;
+    if (!m_out.is_open()) throw std::logic_error { "chunked file is already closed" };
+    if (_DType::s_type != m_type)
+      throw std::invalid_argument { "block datatype differs from the file" };
+    const int ndims { m_dim.ndims() };
+    if (origin.ndims() != ndims || block.ndims() != size_t(ndims))
+      throw std::invalid_argument { "block must have as many dimensions as the array" };
+
+    extents lo {}, hi {};
+    for (int i { -1 }; ++i < ndims;) {
+      const size_t end { origin[i] + block.dim()[i] };
+      if (end > m_dim[i]) throw std::out_of_range { "block exceeds the array" };
+      if (origin[i] % m_tile[i] || (end % m_tile[i] && end != m_dim[i]))
+        throw std::invalid_argument { "block must cover whole tiles" };
+      lo[i] = origin[i] / m_tile[i];
+      hi[i] = (end + m_tile[i] - 1) / m_tile[i];
+    }
+    std::vector<extents> tiles;
+    for_each_tile(ndims, lo, hi, [&tiles](const extents &coords) { tiles.push_back(coords); });
+    if (tiles.empty()) return;
+
+    // tiles are gathered out of the block and compressed in parallel, a batch at a time,
+    // then appended in order
+    const extents counts { tile_counts(m_dim, m_tile) };
+    const size_t width { sizeof(native_type) };
+    const size_t tile_bytes { box_of(m_dim, m_tile, lo).size * width };
+    const size_t per_batch { std::max<size_t>(BATCH / tile_bytes, 1) };
+    std::vector<std::string> blobs;
+    for (size_t first { 0 }; first < tiles.size(); first += per_batch) {
+      const size_t count { std::min(per_batch, tiles.size() - first) };
+      blobs.assign(count, {});
+      detail::parallel_for(count, 1, [&](const size_t begin, const size_t end) {
+        for (size_t k { begin }; k < end; ++k) {
+          const tile_box box { box_of(m_dim, m_tile, tiles[first + k]) };
+          const std::unique_ptr<native_type[]> raw { new native_type[box.size] };
+
+          // position of the tile within the block
+          const native_type *src { block.data() };
+          std::array<std::array<ptrdiff_t, 6>, 2> steps {};
+          steps[0] = row_major(ndims, box.extent);
+          for (int i { -1 }; ++i < ndims;) {
+            steps[1][i] = block.strides()[i];
+            src += ptrdiff_t(box.origin[i] - origin[i]) * steps[1][i];
+          }
+          detail::for_each_run(
+            ndims, box.extent, steps,
+            [](native_type *d, const native_type *x, ptrdiff_t, ptrdiff_t sx, size_t n) {
+              for (size_t i { 0 }; i < n; ++i, x += sx) d[i] = *x;
+            },
+            raw.get(), src);
+          blobs[k] = encode(
+            reinterpret_cast<const char *>(raw.get()), box.size, width, m_shuffle);
+        }
+      });
+
+      for (size_t k { 0 }; k < count; ++k) {
+        const size_t id { flat(ndims, tiles[first + k], counts) };
+        m_index[id] = { uint64_t(m_out.tellp()), blobs[k].size() };
+        m_out.write(blobs[k].data(), std::streamsize(blobs[k].size()));
+      }
+    }
+  }
+
+  void chunked_writer::close()
+  {
+    if (!m_out.is_open()) return;
+
+    std::string tail;
+    const uint64_t offset { uint64_t(m_out.tellp()) };
+    for (const auto &[tile_offset, size] : m_index) {
+      write_le(tail, tile_offset, 8);
+      write_le(tail, size, 8);
+    }
+    write_le(tail, offset, 8);
+    tail.append(END_MAGIC, 8);
+    m_out.write(tail.data(), std::streamsize(tail.size()));
+    m_out.close();
+  }
+
+  template<typename _DType>
+  void save_chunked(const std::string &path, const multiarray<_DType> &array,
+    const dimension &tile, const bool shuffle)
+  {
+    chunked_writer out { path, array.type(), array.dim(), tile, shuffle };
+    out.write(detail::make_shape<index>({}, array.dim().ndims()), array);
+    out.close();
+  }
+
+  //////////////////////////////////// CHUNKED ARRAY /////////////////////////////////////
+
+  struct chunked_array::state {
+    using buffer = std::shared_ptr<const std::vector<char>>;
+
+    state(const std::string &path, const size_t cache_bytes)
+      : file { path, mapping::read_only }, type {}, dim { 1 }, tile { 1 }, shuffled {},
+        counts {}, tiles { 1 }, entries {}, limit { cache_bytes }
+    {
+      const char *base { file.addr };
+      if (file.length < HEADER + TRAILER || std::memcmp(base, MAGIC, 8) != 0)
+        throw std::invalid_argument { path + " is not a chunked file" };
+      if (read_le(base + 8, 2) != VERSION) malformed("unsupported version");
+      if (read_le(base + 10, 1) > uint64_t(datatype::float64)) malformed("unknown datatype");
+      const int ndims { int(read_le(base + 11, 1)) };
+      if (ndims < 1 || ndims > 6) malformed("unsupported dimensions");
+
+      extents d {}, t {};
+      for (int i { -1 }; ++i < ndims;) {
+        d[i] = read_le(base + 16 + 8 * i, 8);
+        t[i] = read_le(base + 64 + 8 * i, 8);
+        if (t[i] == 0) malformed("empty tiles");
+      }
+      type     = datatype(read_le(base + 10, 1));
+      dim      = detail::make_shape<dimension>(d, ndims);
+      tile     = detail::make_shape<dimension>(t, ndims);
+      shuffled = read_le(base + 12, 4) & SHUFFLED;
+      counts   = tile_counts(dim, tile);
+      for (int i { -1 }; ++i < ndims;) {
+        if (counts[i] != 0 && tiles > SIZE_MAX / counts[i]) malformed("too many tiles");
+        tiles *= counts[i];
+      }
+
+      const char *trailer { base + file.length - TRAILER };
+      if (std::memcmp(trailer + 8, END_MAGIC, 8) != 0) malformed("no index, not closed");
+      const size_t offset { read_le(trailer, 8) };
+      if (offset < HEADER || offset > file.length - TRAILER) malformed("bad index");
+      const size_t index_bytes { file.length - TRAILER - offset };
+      if (index_bytes % ENTRY != 0 || index_bytes / ENTRY != tiles) malformed("bad index");
+      entries = base + offset;
+    }
+
+    // decompressed tile, null when it was never written
+    buffer decode(const size_t id, const size_t count) const
+    {
+      const size_t offset { read_le(entries + id * ENTRY, 8) };
+      const size_t size { read_le(entries + id * ENTRY + 8, 8) };
+      if (offset == 0) return nullptr;
+      const size_t width { WIDTHS[int(type)] }, bytes { count * width };
+      const size_t index_start { size_t(entries - file.addr) };
+      if (offset < HEADER || offset > index_start || size > bytes
+          || size > index_start - offset)
+        malformed("tile out of bounds");
+
+      auto out { std::make_shared<std::vector<char>>(bytes) };
+      const char *blob { file.addr + offset };
+      if (size == bytes)
+        std::memcpy(out->data(), blob, bytes);
+      else if (shuffled && width > 1) {
+        const std::unique_ptr<char[]> scratch { new char[bytes] };
+        detail::lz_decompress(blob, size, scratch.get(), bytes);
+        detail::unshuffle(scratch.get(), count, width, out->data());
+      } else
+        detail::lz_decompress(blob, size, out->data(), bytes);
+      return out;
+    }
+
+    // decompressed outside the lock, concurrent misses of a tile decompress it twice
+    buffer fetch(const size_t id, const size_t count)
+    {
+      {
+        const std::lock_guard lock { mutex };
+        const auto it { cache.find(id) };
+        if (it != cache.end()) {
+          ++hits;
+          order.splice(order.begin(), order, it->second.second);
+          return it->second.first;
+        }
+        ++misses;
+      }
+
+      buffer tile { decode(id, count) };
+      if (!tile) return tile;
+      const std::lock_guard lock { mutex };
+      if (tile->size() <= limit && cache.find(id) == cache.end()) {
+        order.push_front(id);
+        cache.emplace(id, std::make_pair(tile, order.begin()));
+        cached += tile->size();
+        evict();
+      }
+      return tile;
+    }
+
+    // drops the least recently used tiles over the limit, with the mutex held
+    void evict()
+    {
+      while (cached > limit) {
+        const auto it { cache.find(order.back()) };
+        cached -= it->second.first->size();
+        cache.erase(it);
+        order.pop_back();
+      }
+    }
+
+    detail::mapped_file file;
+    datatype type;
+    dimension dim, tile;
+    bool shuffled;
+    extents counts;
+    size_t tiles;
+    const char *entries;
+
+    std::mutex mutex {};
+    std::list<size_t> order {};  // most recently used first
+    std::unordered_map<size_t, std::pair<buffer, std::list<size_t>::iterator>> cache {};
+    size_t limit, cached { 0 }, hits { 0 }, misses { 0 };
+  };
+
+  chunked_array::chunked_array(const std::string &path, const size_t cache_bytes)
+    : p_state { std::make_unique<state>(path, cache_bytes) }
+  { }
+
+  chunked_array::chunked_array(chunked_array &&move) noexcept = default;
+  chunked_array &chunked_array::operator=(chunked_array &&move) noexcept = default;
+  chunked_array::~chunked_array() noexcept = default;
+
+  datatype chunked_array::type() const noexcept
+  {
+    return p_state->type;
+  }
+
+  const dimension &chunked_array::dim() const noexcept
+  {
+    return p_state->dim;
+  }
+
+  const dimension &chunked_array::tile() const noexcept
+  {
+    return p_state->tile;
+  }
+
+  // overlapped tiles are copied into the region as they are decompressed, each by the
+  // thread which fetched it
+  template<typename _MultiArray>
+  _MultiArray chunked_array::read(const index &start, const dimension &shape) const
+  {
+    using native_type = typename _MultiArray::native_type;
+    state &s { *p_state };
+    if (array_traits<_MultiArray>::dtype::s_type != s.type)
+      throw std::invalid_argument { "array is stored as another datatype" };
+    const int ndims { s.dim.ndims() };
+    if (start.ndims() != ndims || shape.ndims() != ndims)
+      throw std::invalid_argument { "region must have as many dimensions as the array" };
+
+    extents lo {}, hi {}, extent {};
+    for (int i { -1 }; ++i < ndims;) {
+      if (start[i] > s.dim[i] || shape[i] > s.dim[i] - start[i])
+        throw std::out_of_range { "region exceeds the array" };
+      extent[i] = shape[i];
+      lo[i]     = start[i] / s.tile[i];
+      hi[i]     = shape[i] ? (start[i] + shape[i] - 1) / s.tile[i] + 1 : lo[i];
+    }
+    std::vector<extents> tiles;
+    for_each_tile(ndims, lo, hi, [&tiles](const extents &coords) { tiles.push_back(coords); });
+
+    _MultiArray out { shape, uninitialized };
+    const auto out_steps { row_major(ndims, extent) };
+    detail::parallel_for(tiles.size(), 1, [&](const size_t begin, const size_t end) {
+      for (size_t k { begin }; k < end; ++k) {
+        const tile_box box { box_of(s.dim, s.tile, tiles[k]) };
+        const auto tile { s.fetch(flat(ndims, tiles[k], s.counts), box.size) };
+
+        // overlap of the tile and the region
+        const std::array<std::array<ptrdiff_t, 6>, 2> steps { out_steps,
+          row_major(ndims, box.extent) };
+        extents overlap {};
+        native_type *dst { out.data() };
+        const native_type *src {};
+        if (tile) src = reinterpret_cast<const native_type *>(tile->data());
+        for (int i { -1 }; ++i < ndims;) {
+          const size_t from { std::max(box.origin[i], start[i]) };
+          overlap[i] = std::min(box.origin[i] + box.extent[i], start[i] + shape[i]) - from;
+          dst += ptrdiff_t(from - start[i]) * steps[0][i];
+          if (src) src += ptrdiff_t(from - box.origin[i]) * steps[1][i];
+        }
+
+        if (!src) {
+          detail::for_each_run(
+            ndims, overlap, std::array<std::array<ptrdiff_t, 6>, 1> { steps[0] },
+            [](native_type *d, ptrdiff_t, size_t n) { std::fill_n(d, n, native_type {}); },
+            dst);
+          continue;
+        }
+        detail::for_each_run(
+          ndims, overlap, steps,
+          [](native_type *d, const native_type *x, ptrdiff_t, ptrdiff_t, size_t n) {
+            std::memcpy(d, x, n * sizeof(native_type));
+          },
+          dst, src);
+      }
+    });
+    return out;
+  }
+
+  template<typename _MultiArray>
+  _MultiArray chunked_array::read() const
+  {
+    return read<_MultiArray>(detail::make_shape<index>({}, dim().ndims()), dim());
+  }
+
+  chunked_array::statistics chunked_array::stats() const noexcept
+  {
+    const std::lock_guard lock { p_state->mutex };
+    return { p_state->hits, p_state->misses, p_state->cached };
+  }
+
+  size_t chunked_array::cache_limit() const noexcept
+  {
+    const std::lock_guard lock { p_state->mutex };
+    return p_state->limit;
+  }
+
+  void chunked_array::set_cache_limit(const size_t bytes)
+  {
+    const std::lock_guard lock { p_state->mutex };
+    p_state->limit = bytes;
+    p_state->evict();
+  }
+
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+#define CHUNKED_INSTANTIATIONS(type)                                                    \
+ template void chunked_writer::write<type>(const index &, const multiarray<type> &);   \
+ template void save_chunked<type>(                                                     \
+   const std::string &, const multiarray<type> &, const dimension &, const bool);      \
+ template multiarray<type> chunked_array::read<multiarray<type>>(                      \
+   const index &, const dimension &) const;                                            \
+ template multiarray<type> chunked_array::read<multiarray<type>>() const;
+
+  CHUNKED_INSTANTIATIONS(dtype::bool8);
+  CHUNKED_INSTANTIATIONS(dtype::int8);
+  CHUNKED_INSTANTIATIONS(dtype::int16);
+  CHUNKED_INSTANTIATIONS(dtype::int32);
+  CHUNKED_INSTANTIATIONS(dtype::int64);
+  CHUNKED_INSTANTIATIONS(dtype::uint8);
+  CHUNKED_INSTANTIATIONS(dtype::uint16);
+  CHUNKED_INSTANTIATIONS(dtype::uint32);
+  CHUNKED_INSTANTIATIONS(dtype::uint64);
+  CHUNKED_INSTANTIATIONS(dtype::float32);
+  CHUNKED_INSTANTIATIONS(dtype::float64);
+
+}  // namespace covdel::ma
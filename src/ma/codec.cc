@@ -0,0 +1,211 @@
+#include "codec.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace covdel::ma::detail
+{
+  namespace
+  {
+    // the last literals of a block are never matched, so that decoders may copy matches
+    // in whole words, as in LZ4
+    constexpr size_t MIN_MATCH { 4 }, LAST_LITERALS { 5 }, MATCH_LIMIT { 12 };
+    constexpr size_t MAX_OFFSET { 65535 };
+    constexpr int HASH_LOG { 14 };
+
+    uint32_t load32(const uint8_t *p) noexcept
+    {
+      uint32_t value;
+      std::memcpy(&value, p, 4);
+      return value;
+    }
+
+    uint32_t hash(const uint32_t sequence) noexcept
+    {
+      return sequence * 2654435761U >> (32 - HASH_LOG);
+    }
+
+    uint8_t *put_length(uint8_t *out, size_t length) noexcept
+    {
+      for (; length >= 255; length -= 255) *out++ = 255;
+      *out++ = uint8_t(length);
+      return out;
+    }
+
+    uint8_t *put_literals(uint8_t *out, const uint8_t *src, const size_t length) noexcept
+    {
+      if (length) std::memcpy(out, src, length);
+      return out + length;
+    }
+
+    [[noreturn]] void corrupt()
+    {
+      throw std::invalid_argument { "corrupt compressed block" };
+    }
+
+  }  // namespace
+
+  // greedy parse, the step grows over incompressible stretches
+  size_t lz_compress(const char *src, const size_t size, char *dst) noexcept
+  {
+    const auto *in { reinterpret_cast<const uint8_t *>(src) };
+    auto *out { reinterpret_cast<uint8_t *>(dst) };
+    const uint8_t *anchor { in }, *end { in + size };
+
+    if (size > MATCH_LIMIT) {
+      std::array<uint32_t, 1 << HASH_LOG> table {};
+      const uint8_t *limit { end - MATCH_LIMIT };
+      for (const uint8_t *ip { in + 1 }; ip < limit;) {
+        const uint32_t sequence { load32(ip) };
+        uint32_t &slot { table[hash(sequence)] };
+        const uint8_t *ref { in + slot };
+        slot = uint32_t(ip - in);
+        if (size_t(ip - ref) > MAX_OFFSET || load32(ref) != sequence) {
+          ip += 1 + (size_t(ip - anchor) >> 6);
+          continue;
+        }
+
+        size_t match { MIN_MATCH };
+        const size_t most { size_t(end - LAST_LITERALS - ip) };
+        while (match < most && ip[match] == ref[match]) ++match;
+
+        const size_t literals { size_t(ip - anchor) }, extra { match - MIN_MATCH };
+        uint8_t *token { out++ };
+        *token = uint8_t(std::min<size_t>(literals, 15) << 4 | std::min<size_t>(extra, 15));
+        if (literals >= 15) out = put_length(out, literals - 15);
+        out = put_literals(out, anchor, literals);
+        *out++ = uint8_t(ip - ref);
+        *out++ = uint8_t((ip - ref) >> 8);
+        if (extra >= 15) out = put_length(out, extra - 15);
+
+        ip += match;
+        anchor = ip;
+      }
+    }
+
+    const size_t literals { size_t(end - anchor) };
+    *out++ = uint8_t(std::min<size_t>(literals, 15) << 4);
+    if (literals >= 15) out = put_length(out, literals - 15);
+    out = put_literals(out, anchor, literals);
+    return size_t(out - reinterpret_cast<uint8_t *>(dst));
+  }
+
+  // every length and offset is checked, blocks come from files
+  void lz_decompress(const char *src, const size_t compressed, char *dst, const size_t size)
+  {
+    const auto *in { reinterpret_cast<const uint8_t *>(src) };
+    const uint8_t *in_end { in + compressed };
+    auto *out { reinterpret_cast<uint8_t *>(dst) };
+    uint8_t *const out_begin { out }, *const out_end { out + size };
+
+    const auto length = [&in, in_end](size_t value) {
+      if (value != 15) return value;
+      for (uint8_t byte { 255 }; byte == 255; value += byte) {
+        if (in == in_end) corrupt();
+        byte = *in++;
+      }
+      return value;
+    };
+
+    while (true) {
+      if (in == in_end) corrupt();
+      const uint8_t token { *in++ };
+      const size_t literals { length(token >> 4) };
+      if (literals > size_t(in_end - in) || literals > size_t(out_end - out)) corrupt();
+      if (literals) std::memcpy(out, in, literals);
+      in += literals, out += literals;
+      if (in == in_end) break;
+
+      if (in_end - in < 2) corrupt();
+      const size_t offset { size_t(in[0]) | size_t(in[1]) << 8 };
+      in += 2;
+      const size_t match { length(token & 15) + MIN_MATCH };
+      if (offset == 0 || offset > size_t(out - out_begin) || match > size_t(out_end - out))
+        corrupt();
+
+      // overlapping matches repeat their last `offset` bytes
+      const uint8_t *ref { out - offset };
+      if (offset >= match)
+        std::memcpy(out, ref, match);
+      else
+        for (size_t i { 0 }; i < match; ++i) out[i] = ref[i];
+      out += match;
+    }
+    if (out != out_end) corrupt();
+  }
+
+  namespace
+  {
+    template<size_t _Width>
+    void shuffle(const char *src, const size_t count, char *dst) noexcept
+    {
+      for (size_t i { 0 }; i < count; ++i)
+        for (size_t b { 0 }; b < _Width; ++b) dst[b * count + i] = src[i * _Width + b];
+    }
+
+    template<size_t _Width>
+    void unshuffle(const char *src, const size_t count, char *dst) noexcept
+    {
+      for (size_t i { 0 }; i < count; ++i)
+        for (size_t b { 0 }; b < _Width; ++b) dst[i * _Width + b] = src[b * count + i];
+    }
+
+  }  // namespace
+
+  void shuffle(const char *src, const size_t count, const size_t width, char *dst) noexcept
+  {
+    switch (width) {
+    case 2: return shuffle<2>(src, count, dst);
+    case 4: return shuffle<4>(src, count, dst);
+    case 8: return shuffle<8>(src, count, dst);
+    default: std::memcpy(dst, src, count * width);
+    }
+  }
+
+  void unshuffle(const char *src, const size_t count, const size_t width, char *dst) noexcept
+  {
+    switch (width) {
+    case 2: return unshuffle<2>(src, count, dst);
+    case 4: return unshuffle<4>(src, count, dst);
+    case 8: return unshuffle<8>(src, count, dst);
+    default: std::memcpy(dst, src, count * width);
+    }
+  }
+
+  namespace
+  {
+    // over 8 bytes per step
+    constexpr auto CRC_TABLES { [] {
+      std::array<std::array<uint32_t, 256>, 8> tables {};
+      for (uint32_t i { 0 }; i < 256; ++i) {
+        uint32_t crc { i };
+        for (int k { 0 }; k < 8; ++k) crc = crc & 1 ? 0xEDB88320 ^ crc >> 1 : crc >> 1;
+        tables[0][i] = crc;
+      }
+      for (uint32_t i { 0 }; i < 256; ++i)
+        for (int k { 1 }; k < 8; ++k)
+          tables[k][i] = tables[k - 1][i] >> 8 ^ tables[0][tables[k - 1][i] & 0xFF];
+      return tables;
+    }() };
+
+  }  // namespace
+
+  uint32_t crc32(uint32_t crc, const char *bytes, size_t length) noexcept
+  {
+    const auto &t { CRC_TABLES };
+    const auto *p { reinterpret_cast<const uint8_t *>(bytes) };
+    crc = ~crc;
+    for (; length >= 8; length -= 8, p += 8) {
+      crc ^= uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16
+           | uint32_t(p[3]) << 24;
+      crc = t[7][crc & 0xFF] ^ t[6][crc >> 8 & 0xFF] ^ t[5][crc >> 16 & 0xFF]
+          ^ t[4][crc >> 24] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for (; length; --length) crc = t[0][(crc ^ *p++) & 0xFF] ^ crc >> 8;
+    return ~crc;
+  }
+
+}  // namespace covdel::ma::detail
@@ -0,0 +1,34 @@
+#ifndef __COVDEL_SRC_MA_CODEC_HH_1701301927__
+#define __COVDEL_SRC_MA_CODEC_HH_1701301927__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace covdel::ma::detail
+{
+  using std::size_t;
+
+  // largest compressed size of `size` bytes
+  constexpr size_t lz_bound(const size_t size) noexcept
+  {
+    return size + size / 255 + 16;
+  }
+
+  // LZ4-style block compression, sequences of literals followed by a match of at least 4
+  // bytes within the last 64KiB, returns the compressed size, at most lz_bound(size)
+  size_t lz_compress(const char *src, size_t size, char *dst) noexcept;
+
+  // throws std::invalid_argument unless the block decompresses to exactly `size` bytes
+  void lz_decompress(const char *src, size_t compressed, char *dst, size_t size);
+
+  // groups the same byte of every element together, so that the slowly varying high bytes
+  // of numbers form long runs which compress well
+  void shuffle(const char *src, size_t count, size_t width, char *dst) noexcept;
+  void unshuffle(const char *src, size_t count, size_t width, char *dst) noexcept;
+
+  // zip and png checksum of `length` more bytes, continuing from `crc`, 0 to start
+  std::uint32_t crc32(std::uint32_t crc, const char *bytes, size_t length) noexcept;
+
+}  // namespace covdel::ma::detail
+
+#endif
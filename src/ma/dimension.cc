@@ -1,103 +1,153 @@
 #include "covdel/ma/dimension.hh"
 
+#include <algorithm>
 #include <numeric>
 
 namespace covdel::ma
 {
   //////////////////////////////////////// _DSI //////////////////////////////////////////
 
-  ////////////// CONSTRUCTORS //////////////
-
-  _dsi::_dsi(const _dsi &copy) : p_data { new size_t[MAX_SIZE] {} }, m_len { copy.m_len }
-  {
-    std::copy(copy.p_data, copy.p_data + m_len, p_data);
-  }
-
-  _dsi::_dsi(_dsi &&move) noexcept : p_data { move.p_data }, m_len { move.m_len }
-  {
-    move.p_data = nullptr;
-  }
-
-  _dsi::~_dsi() noexcept { delete[] p_data; }
-
   //////////////// OPERATORS ///////////////
 
-  _dsi &_dsi::operator=(_dsi rhs) noexcept
-  {
-    this->swap(rhs);
-    return *this;
-  }
-
-  size_t _dsi::operator[](const int idx) const
+  template<typename _Type>
+  bool _dsi<_Type>::operator==(const _dsi &rhs) const noexcept
   {
-    return idx < m_len ? p_data[idx] : throw std::out_of_range { "index out of bounds" };
+    auto first { m_data.cbegin() };
+    return m_len == rhs.m_len && std::equal(first, first + m_len, rhs.m_data.cbegin());
   }
 
-  bool _dsi::operator==(const _dsi &rhs) const noexcept
+  template<typename _Type>
+  bool _dsi<_Type>::operator!=(const _dsi &rhs) const noexcept
   {
-    return m_len == rhs.m_len && std::equal(p_data, p_data + m_len, rhs.p_data);
+    return !(*this == rhs);
   }
 
-  bool _dsi::operator!=(const _dsi &rhs) const noexcept { return !(*this == rhs); }
-
-  std::ostream &operator<<(std::ostream &out, const _dsi &obj)
+  template<typename _Type>
+  std::ostream &operator<<(std::ostream &out, const _dsi<_Type> &obj)
   {
     return out << obj.str();
   }
 
   ///////////////// GENERAL ////////////////
 
-  void _dsi::swap(_dsi &b) noexcept
+  template<typename _Type>
+  void _dsi<_Type>::swap(_dsi &b) noexcept
   {
     std::swap(m_len, b.m_len);
-    std::swap(p_data, b.p_data);
+    std::swap(m_data, b.m_data);
   }
 
-  int _dsi::ndims() const noexcept { return m_len; }
-
-  std::string _dsi::str() const
+  template<typename _Type>
+  std::string _dsi<_Type>::str() const
   {
     std::string out { "( " };
-    for (int i { -1 }; ++i < m_len;) out += std::to_string(p_data[i]) + ' ';
+    for (int i { -1 }; ++i < m_len;) out += std::to_string(m_data[i]) + ' ';
     return out + ')';
   }
 
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+  template class _dsi<size_t>;
+  template class _dsi<ptrdiff_t>;
+  template std::ostream &operator<<(std::ostream &out, const _dsi<size_t> &obj);
+  template std::ostream &operator<<(std::ostream &out, const _dsi<ptrdiff_t> &obj);
+
   ///////////////////////////////////// DIMENSION ////////////////////////////////////////
 
   size_t dimension::size() const noexcept
   {
-    return std::accumulate(p_data, p_data + m_len, 1UL, std::multiplies<size_t> {});
+    auto first { m_data.cbegin() };
+    return std::accumulate(first, first + m_len, 1UL, std::multiplies<size_t> {});
   }
 
   void dimension::squeeze()
   {
     int i { -1 }, j { 0 };
     while (++i < m_len)
-      if (p_data[i] != 1) p_data[j++] = p_data[i];
+      if (m_data[i] != 1) m_data[j++] = m_data[i];
     m_len = j;
   }
 
+  dimension broadcast(const dimension &a, const dimension &b)
+  {
+    const auto &longer { a.ndims() >= b.ndims() ? a : b };
+    const auto &shorter { a.ndims() >= b.ndims() ? b : a };
+    const int offset { longer.ndims() - shorter.ndims() };
+
+    dimension out { longer };
+    for (int i { offset }; i < longer.ndims(); ++i) {
+      const size_t x { longer[i] }, y { shorter[i - offset] };
+      if (x != y && x != 1 && y != 1)
+        throw std::invalid_argument { "dimensions are not broadcast compatible" };
+      out.m_data[i] = x == 1 ? y : x;
+    }
+    return out;
+  }
+
+  dimension reduced(const dimension &dim, const unsigned axes, const bool keepdims)
+  {
+    dimension out { dim };
+    out.m_len = 0;
+    for (int i { -1 }; ++i < dim.ndims();)
+      if (!(axes >> i & 1U))
+        out.m_data[out.m_len++] = dim[i];
+      else if (keepdims)
+        out.m_data[out.m_len++] = 1;
+    if (out.m_len == 0) out.m_data[out.m_len++] = 1;
+    return out;
+  }
+
+  /////////////////////////////////////// STRIDE /////////////////////////////////////////
+
+  stride::stride(const dimension &dim) noexcept : _dsi { 1 }
+  {
+    m_len = dim.ndims();
+    ptrdiff_t step { 1 };
+    for (int i { m_len }; i-- > 0;) {
+      m_data[i] = step;
+      step *= static_cast<ptrdiff_t>(dim[i]);
+    }
+  }
+
   /////////////////////////////////////// INDEX //////////////////////////////////////////
 
+  // bounds are checked in the same pass which accumulates the position
+
   size_t index::flat(const dimension &dim) const
   {
-    if (*this >= dim) throw std::out_of_range { "index out of corresponding dimension" };
+    if (m_len != dim.m_len)
+      throw std::invalid_argument { "index is incompatible with given dimension" };
 
-    size_t stride { 1 }, flat_idx { p_data[m_len - 1] };
-    for (int i { m_len }; --i > 0;) {
-      stride *= dim[i];
-      flat_idx += stride * p_data[i - 1];
+    size_t flat_idx { 0 };
+    for (int i { -1 }; ++i < m_len;) {
+      if (m_data[i] >= dim.m_data[i])
+        throw std::out_of_range { "index out of corresponding dimension" };
+      flat_idx = flat_idx * dim.m_data[i] + m_data[i];
     }
     return flat_idx;
   }
 
+  ptrdiff_t index::offset(const dimension &dim, const stride &strides) const
+  {
+    if (m_len != dim.m_len)
+      throw std::invalid_argument { "index is incompatible with given dimension" };
+
+    ptrdiff_t offset { 0 };
+    for (int i { -1 }; ++i < m_len;) {
+      if (m_data[i] >= dim.m_data[i])
+        throw std::out_of_range { "index out of corresponding dimension" };
+      offset += static_cast<ptrdiff_t>(m_data[i]) * strides.m_data[i];
+    }
+    return offset;
+  }
+
   bool index::operator<(const dimension &dim) const
   {
     if (m_len != dim.ndims())
       throw std::invalid_argument { "index is incompatible with given dimension" };
 
     for (int i { -1 }; ++i < m_len;)
-      if (p_data[i] >= dim[i]) return false;
+      if (m_data[i] >= dim[i]) return false;
     return true;
   }
 
@@ -0,0 +1,262 @@
+#include "covdel/ma/executor.hh"
+
+#include "parallel.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace covdel::ma
+{
+  namespace
+  {
+    using loop_body = std::function<void(size_t, size_t)>;
+
+    // one parallel_for call, living on the stack of the thread which made it
+    struct job {
+      const loop_body &func;
+      const size_t grain;
+      std::atomic<size_t> remaining;
+      std::atomic<bool> failed { false };
+      std::exception_ptr error {};
+      std::mutex mutex {};
+      std::condition_variable done {};
+    };
+
+    struct task {
+      job *owner;
+      size_t begin, end;
+    };
+
+    // the owning worker pushes and pops at the back, thieves take the oldest and largest
+    // ranges from the front
+    struct task_queue {
+      std::mutex mutex;
+      std::deque<task> tasks;
+    };
+
+    // pool and queue of the calling thread, when it is a worker
+    thread_local const void *t_pool { nullptr };
+    thread_local size_t t_queue { 0 };
+
+    thread_local executor *t_default { nullptr };
+
+    std::atomic<size_t> s_grain { size_t(1) << 18 };
+
+  }  // namespace
+
+  ////////////////////////////////// SERIAL EXECUTOR ////////////////////////////////////
+
+  size_t serial_executor::concurrency() const noexcept
+  {
+    return 1;
+  }
+
+  void serial_executor::parallel_for(const size_t count, size_t, const loop_body &func)
+  {
+    if (count) func(0, count);
+  }
+
+  serial_executor &serial_executor::instance() noexcept
+  {
+    static serial_executor s_executor;
+    return s_executor;
+  }
+
+  //////////////////////////////////// THREAD POOL ///////////////////////////////////////
+
+  struct thread_pool::state {
+    explicit state(const size_t threads) : queues(threads) { }
+
+    // queue index `self` is the number of workers for threads outside the pool
+    bool find(const size_t self, task &t)
+    {
+      const size_t workers { queues.size() };
+      if (self < workers) {
+        std::lock_guard lock { queues[self].mutex };
+        auto &own { queues[self].tasks };
+        if (!own.empty()) {
+          t = own.back();
+          own.pop_back();
+          queued.fetch_sub(1);
+          return true;
+        }
+      }
+      for (size_t i { 1 }; i <= workers; ++i) {
+        auto &victim { queues[(self + i) % workers] };
+        std::lock_guard lock { victim.mutex };
+        if (!victim.tasks.empty()) {
+          t = victim.tasks.front();
+          victim.tasks.pop_front();
+          queued.fetch_sub(1);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void push(const size_t queue, const task &t)
+    {
+      {
+        std::lock_guard lock { queues[queue].mutex };
+        queues[queue].tasks.push_back(t);
+        queued.fetch_add(1);
+      }
+      // pairs with the predicate check of sleeping workers
+      { std::lock_guard lock { sleep_mutex }; }
+      wake.notify_one();
+    }
+
+    void run(const size_t self, task t)
+    {
+      job &j { *t.owner };
+      if (self < queues.size())
+        while (t.end - t.begin >= 2 * j.grain) {
+          const size_t mid { t.begin + (t.end - t.begin) / 2 };
+          push(self, { t.owner, mid, t.end });
+          t.end = mid;
+        }
+
+      if (!j.failed.load(std::memory_order_relaxed)) try {
+          j.func(t.begin, t.end);
+        } catch (...) {
+          std::lock_guard lock { j.mutex };
+          if (!j.error) j.error = std::current_exception();
+          j.failed.store(true);
+        }
+
+      // the job is released by its caller as soon as nothing remains, which it observes
+      // under the mutex, so the last worker touching it still holds the mutex
+      std::lock_guard lock { j.mutex };
+      if (j.remaining.fetch_sub(t.end - t.begin) == t.end - t.begin) j.done.notify_all();
+    }
+
+    void work(const size_t self)
+    {
+      t_pool  = this;
+      t_queue = self;
+      task t;
+      while (true) {
+        if (find(self, t)) {
+          run(self, t);
+          continue;
+        }
+        std::unique_lock lock { sleep_mutex };
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+      }
+    }
+
+    std::vector<task_queue> queues;
+    std::vector<std::thread> threads {};
+    std::atomic<size_t> queued { 0 }, next { 0 };
+    std::mutex sleep_mutex {};
+    std::condition_variable wake {};
+    bool stopping { false };
+  };
+
+  thread_pool::thread_pool(const size_t threads) : p_state { new state { threads } }
+  {
+    p_state->threads.reserve(threads);
+    for (size_t w { 0 }; w < threads; ++w)
+      p_state->threads.emplace_back([s = p_state.get(), w] { s->work(w); });
+  }
+
+  thread_pool::~thread_pool() noexcept
+  {
+    {
+      std::lock_guard lock { p_state->sleep_mutex };
+      p_state->stopping = true;
+    }
+    p_state->wake.notify_all();
+    for (auto &thread : p_state->threads) thread.join();
+  }
+
+  size_t thread_pool::concurrency() const noexcept
+  {
+    return p_state->queues.size() + 1;
+  }
+
+  void thread_pool::parallel_for(const size_t count, size_t grain, const loop_body &func)
+  {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    const size_t workers { p_state->queues.size() };
+    if (workers == 0 || count < 2 * grain) return func(0, count);
+
+    job j { func, grain, count };
+    const size_t self { t_pool == p_state.get() ? t_queue : workers };
+    if (self < workers)
+      p_state->run(self, { &j, 0, count });
+    else {
+      // outside callers hand a share to each worker, which splits it further
+      const size_t shares { std::min(count / grain, workers + 1) };
+      for (size_t s { 1 }; s < shares; ++s)
+        p_state->push(p_state->next.fetch_add(1) % workers,
+          { &j, count * s / shares, count * (s + 1) / shares });
+      p_state->run(self, { &j, 0, count / shares });
+    }
+
+    // help with any queued task until the job is done, ranges of this job may have been
+    // stolen by workers, and later split further behind the queues already searched
+    task t;
+    while (j.remaining.load() > 0) {
+      if (p_state->find(self, t)) {
+        p_state->run(self, t);
+        continue;
+      }
+      std::unique_lock lock { j.mutex };
+      j.done.wait_for(
+        lock, std::chrono::microseconds(50), [&j] { return j.remaining.load() == 0; });
+    }
+    std::lock_guard lock { j.mutex };
+    if (j.error) std::rethrow_exception(j.error);
+  }
+
+  // never destroyed, as its workers may still release thread local resources which are
+  // destroyed at exit
+  thread_pool &thread_pool::instance()
+  {
+    static thread_pool *s_pool { new thread_pool {
+      std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1 } };
+    return *s_pool;
+  }
+
+  /////////////////////////////////////// DEFAULTS ///////////////////////////////////////
+
+  executor &default_executor()
+  {
+    return t_default ? *t_default : thread_pool::instance();
+  }
+
+  void set_default_executor(executor &exec) noexcept
+  {
+    t_default = &exec;
+  }
+
+  size_t grain_size() noexcept
+  {
+    return s_grain.load(std::memory_order_relaxed);
+  }
+
+  void set_grain_size(const size_t bytes) noexcept
+  {
+    s_grain.store(std::max<size_t>(bytes, 1), std::memory_order_relaxed);
+  }
+
+  namespace detail
+  {
+    void parallel_for(const size_t count, const size_t grain, const loop_body &func)
+    {
+      default_executor().parallel_for(count, grain, func);
+    }
+
+  }  // namespace detail
+
+}  // namespace covdel::ma
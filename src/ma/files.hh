@@ -0,0 +1,64 @@
+#ifndef __COVDEL_SRC_MA_FILES_HH_1701297310__
+#define __COVDEL_SRC_MA_FILES_HH_1701297310__
+
+#include "covdel/ma/npy.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace covdel::ma::detail
+{
+  // private mapping of a whole file, writable pages are copied on write
+  struct mapped_file {
+    mapped_file(const std::string &path, const mapping map);
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    ~mapped_file() noexcept;
+
+    char *addr;
+    std::size_t length;
+  };
+
+  // std::system_error of errno
+  [[noreturn]] void fail(const std::string &what);
+
+  // little-endian fields of the file formats
+
+  inline std::uint64_t read_le(const char *bytes, const int count) noexcept
+  {
+    std::uint64_t value { 0 };
+    for (int i { count }; i-- > 0;) value = value << 8 | std::uint8_t(bytes[i]);
+    return value;
+  }
+
+  inline void write_le(std::string &bytes, std::uint64_t value, const int count)
+  {
+    for (int i { -1 }; ++i < count; value >>= 8) bytes += char(value & 0xFF);
+  }
+
+  template<typename _Shape, std::size_t... K>
+  _Shape make_shape(const std::array<std::size_t, 6> &extent, std::index_sequence<K...>)
+  {
+    return _Shape { extent[K]... };
+  }
+
+  // dimension or index of the first `ndims` extents
+  template<typename _Shape>
+  _Shape make_shape(const std::array<std::size_t, 6> &extent, const int ndims)
+  {
+    switch (ndims) {
+    case 1: return make_shape<_Shape>(extent, std::make_index_sequence<1> {});
+    case 2: return make_shape<_Shape>(extent, std::make_index_sequence<2> {});
+    case 3: return make_shape<_Shape>(extent, std::make_index_sequence<3> {});
+    case 4: return make_shape<_Shape>(extent, std::make_index_sequence<4> {});
+    case 5: return make_shape<_Shape>(extent, std::make_index_sequence<5> {});
+    default: return make_shape<_Shape>(extent, std::make_index_sequence<6> {});
+    }
+  }
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __COVDEL_SRC_MA_GEMM_KERNELS_HH_1701870216__
+#define __COVDEL_SRC_MA_GEMM_KERNELS_HH_1701870216__
+
+#include <cstddef>
+
+namespace covdel::ma::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // packing and register blocked kernels of matrix products, over panels of `mr` rows of a
+  // and `nr` columns of b, the blocks of the product fitting each level of the caches
+  template<typename _Type>
+  struct gemm_table {
+    // tile of the micro kernel, and depth, rows and columns of the cache blocks
+    size_t mr, nr, kc, mc, nc;
+
+    // a[i * rs + p * cs] of an `m` x `k` block into panels of `mr` rows, each stored as
+    // `k` columns of `mr` elements, rows past `m` padded with zeros
+    void (*pack_a)(const _Type *a, ptrdiff_t rs, ptrdiff_t cs, size_t m, size_t k,
+      _Type *panels);
+    // b[p * rs + j * cs] of a `k` x `n` block into panels of `nr` columns, each stored as
+    // `k` rows of `nr` elements, columns past `n` padded with zeros
+    void (*pack_b)(const _Type *b, ptrdiff_t rs, ptrdiff_t cs, size_t k, size_t n,
+      _Type *panels);
+
+    // c = alpha * a b + beta * c for an `m` x `n` corner of the tile of a pair of panels
+    // of depth `k`, c is not read when beta is zero
+    void (*kernel)(size_t k, const _Type *a, const _Type *b, _Type alpha, _Type beta,
+      _Type *c, ptrdiff_t rs, ptrdiff_t cs, size_t m, size_t n);
+
+    // inner product of two strided runs
+    _Type (*dot)(const _Type *x, ptrdiff_t sx, const _Type *y, ptrdiff_t sy, size_t count);
+  };
+
+  struct gemm_registry {
+    gemm_table<float> float32;
+    gemm_table<double> float64;
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(gemm_registry &registry) noexcept; }
+  namespace sse2 { void fill(gemm_registry &registry) noexcept; }
+  namespace avx2 { void fill(gemm_registry &registry) noexcept; }
+  namespace avx512 { void fill(gemm_registry &registry) noexcept; }
+
+  // kernels of the currently active instruction set level
+  template<typename _Type>
+  const gemm_table<_Type> &gemm_kernels() noexcept;
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,204 @@
+// Packing and micro kernels of matrix products, compiled once per instruction set level as
+// the element-wise kernels, see kernels.inl. The micro kernel keeps its tile of the
+// product in generic vectors as wide as the registers of the level, as many rows as they
+// hold besides the operands, so the accumulators never leave registers. Levels with fused
+// multiply-adds are built with contraction, so their results differ from the others in the
+// last bits, while the order of the sums is the same on every level.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "gemm_kernels.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace covdel::ma::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+#if defined(__AVX512F__)
+    static constexpr size_t REGISTER_BYTES { 64 }, REGISTERS { 32 };
+#elif defined(__AVX__)
+    static constexpr size_t REGISTER_BYTES { 32 }, REGISTERS { 16 };
+#else
+    static constexpr size_t REGISTER_BYTES { 16 }, REGISTERS { 16 };
+#endif
+
+    // tiles are two registers wide, and as tall as the registers left for accumulators
+    template<typename _Type>
+    struct tile {
+      typedef _Type vector __attribute__((vector_size(REGISTER_BYTES)));
+      static constexpr size_t LANES { REGISTER_BYTES / sizeof(_Type) };
+      static constexpr size_t MR { REGISTERS == 32 ? 12 : 6 }, NR { 2 * LANES };
+
+      // depth of the panels, keeping a panel of b in the L1 cache, and rows of a and
+      // columns of b of the blocks kept in the L2 and last level caches
+      static constexpr size_t KC { 256 }, MC { MR * 16 }, NC { NR * 128 };
+    };
+
+    ////////////////////////////////////// PACKING ///////////////////////////////////////
+
+    template<typename _Type>
+    void pack_a(const _Type *a, const ptrdiff_t rs, const ptrdiff_t cs, const size_t m,
+      const size_t k, _Type *panels)
+    {
+      constexpr size_t MR { tile<_Type>::MR };
+      for (size_t first { 0 }; first < m; first += MR, panels += MR * k) {
+        const size_t rows { std::min(MR, m - first) };
+        const _Type *from { a + ptrdiff_t(first) * rs };
+        // reading along the tighter of the two strides
+        if (cs == 1)
+          for (size_t i { 0 }; i < rows; ++i)
+            for (size_t p { 0 }; p < k; ++p)
+              panels[p * MR + i] = from[ptrdiff_t(i) * rs + ptrdiff_t(p)];
+        else if (std::abs(cs) < std::abs(rs))
+          for (size_t i { 0 }; i < rows; ++i)
+            for (size_t p { 0 }; p < k; ++p)
+              panels[p * MR + i] = from[ptrdiff_t(i) * rs + ptrdiff_t(p) * cs];
+        else
+          for (size_t p { 0 }; p < k; ++p)
+            for (size_t i { 0 }; i < rows; ++i)
+              panels[p * MR + i] = from[ptrdiff_t(i) * rs + ptrdiff_t(p) * cs];
+        for (size_t p { 0 }; p < k; ++p)
+          for (size_t i { rows }; i < MR; ++i) panels[p * MR + i] = 0;
+      }
+    }
+
+    template<typename _Type>
+    void pack_b(const _Type *b, const ptrdiff_t rs, const ptrdiff_t cs, const size_t k,
+      const size_t n, _Type *panels)
+    {
+      constexpr size_t NR { tile<_Type>::NR };
+      for (size_t first { 0 }; first < n; first += NR, panels += NR * k) {
+        const size_t columns { std::min(NR, n - first) };
+        const _Type *from { b + ptrdiff_t(first) * cs };
+        if (cs == 1 && columns == NR)
+          for (size_t p { 0 }; p < k; ++p)
+            std::memcpy(panels + p * NR, from + ptrdiff_t(p) * rs, sizeof(_Type) * NR);
+        else if (std::abs(cs) < std::abs(rs))
+          for (size_t p { 0 }; p < k; ++p)
+            for (size_t j { 0 }; j < NR; ++j)
+              panels[p * NR + j] = j < columns ? from[ptrdiff_t(p) * rs + ptrdiff_t(j) * cs]
+                                               : _Type(0);
+        else {
+          for (size_t j { 0 }; j < columns; ++j)
+            for (size_t p { 0 }; p < k; ++p)
+              panels[p * NR + j] = from[ptrdiff_t(p) * rs + ptrdiff_t(j) * cs];
+          for (size_t p { 0 }; p < k; ++p)
+            for (size_t j { columns }; j < NR; ++j) panels[p * NR + j] = 0;
+        }
+      }
+    }
+
+    ////////////////////////////////////// KERNELS ///////////////////////////////////////
+
+    template<typename _Type>
+    void kernel(const size_t k, const _Type *a, const _Type *b, const _Type alpha,
+      const _Type beta, _Type *c, const ptrdiff_t rs, const ptrdiff_t cs, const size_t m,
+      const size_t n)
+    {
+      using vector = typename tile<_Type>::vector;
+      constexpr size_t MR { tile<_Type>::MR }, NR { tile<_Type>::NR };
+      constexpr size_t LANES { tile<_Type>::LANES };
+
+      vector acc[MR][2] {};
+      for (size_t p { 0 }; p < k; ++p, a += MR, b += NR) {
+        vector b0, b1;
+        std::memcpy(&b0, b, sizeof(vector));
+        std::memcpy(&b1, b + LANES, sizeof(vector));
+        for (size_t i { 0 }; i < MR; ++i) {
+          // subtracting zero broadcasts without an addition, as it is exact
+          const vector ai { a[i] - vector {} };
+          acc[i][0] += ai * b0;
+          acc[i][1] += ai * b1;
+        }
+      }
+
+      if (m == MR && n == NR && cs == 1) {
+        for (size_t i { 0 }; i < MR; ++i) {
+          _Type *row { c + ptrdiff_t(i) * rs };
+          vector c0 { acc[i][0] * alpha }, c1 { acc[i][1] * alpha };
+          if (beta != _Type(0)) {
+            vector old0, old1;
+            std::memcpy(&old0, row, sizeof(vector));
+            std::memcpy(&old1, row + LANES, sizeof(vector));
+            c0 += old0 * beta;
+            c1 += old1 * beta;
+          }
+          std::memcpy(row, &c0, sizeof(vector));
+          std::memcpy(row + LANES, &c1, sizeof(vector));
+        }
+        return;
+      }
+
+      // corners and strided rows of c go through the tile in memory
+      _Type product[MR][NR];
+      for (size_t i { 0 }; i < MR; ++i) {
+        std::memcpy(product[i], &acc[i][0], sizeof(vector));
+        std::memcpy(product[i] + LANES, &acc[i][1], sizeof(vector));
+      }
+      for (size_t i { 0 }; i < m; ++i) {
+        _Type *row { c + ptrdiff_t(i) * rs };
+        if (beta == _Type(0))
+          for (size_t j { 0 }; j < n; ++j) row[ptrdiff_t(j) * cs] = alpha * product[i][j];
+        else
+          for (size_t j { 0 }; j < n; ++j)
+            row[ptrdiff_t(j) * cs] = alpha * product[i][j] + beta * row[ptrdiff_t(j) * cs];
+      }
+    }
+
+    // lanes of one register of the widest level, so that sums are split alike on every
+    // level
+    static constexpr size_t DOT_BYTES { 64 };
+
+    template<typename _Type>
+    _Type dot(const _Type *x, const ptrdiff_t sx, const _Type *y, const ptrdiff_t sy,
+      const size_t count)
+    {
+      typedef _Type vector __attribute__((vector_size(DOT_BYTES)));
+      constexpr size_t WIDTH { DOT_BYTES / sizeof(_Type) };
+
+      size_t i { 0 };
+      _Type sum { 0 };
+      if (sx == 1 && sy == 1) {
+        vector acc[2] {}, u, v;
+        for (; i + 2 * WIDTH <= count; i += 2 * WIDTH)
+          for (size_t r { 0 }; r < 2; ++r) {
+            std::memcpy(&u, x + i + r * WIDTH, sizeof(vector));
+            std::memcpy(&v, y + i + r * WIDTH, sizeof(vector));
+            acc[r] += u * v;
+          }
+        acc[0] += acc[1];
+        for (size_t l { 0 }; l < WIDTH; ++l) sum += acc[0][l];
+      }
+      for (; i < count; ++i) sum += x[ptrdiff_t(i) * sx] * y[ptrdiff_t(i) * sy];
+      return sum;
+    }
+
+    template<typename _Type>
+    void fill_table(gemm_table<_Type> &table) noexcept
+    {
+      table.mr = tile<_Type>::MR;
+      table.nr = tile<_Type>::NR;
+      table.kc = tile<_Type>::KC;
+      table.mc = tile<_Type>::MC;
+      table.nc = tile<_Type>::NC;
+
+      table.pack_a = pack_a<_Type>;
+      table.pack_b = pack_b<_Type>;
+      table.kernel = kernel<_Type>;
+      table.dot    = dot<_Type>;
+    }
+
+  }  // namespace
+
+  void fill(gemm_registry &registry) noexcept
+  {
+    fill_table(registry.float32);
+    fill_table(registry.float64);
+  }
+
+}  // namespace covdel::ma::detail::COVDEL_KERNEL_ISA
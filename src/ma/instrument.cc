@@ -0,0 +1,326 @@
+#include "covdel/ma/instrument.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace covdel::ma
+{
+  namespace
+  {
+    using counter = std::atomic<std::uint64_t>;
+
+    // a probed call on the timeline, with the live bytes after it for allocations
+    struct event {
+      operation op;
+      datatype type;
+      std::size_t bytes;
+      std::int64_t start, duration;
+      std::int64_t live;
+    };
+
+    // counters of one thread, only ever written by it, with relaxed loads and stores
+    // rather than read-modify-writes, and read by snapshots from any thread
+    struct thread_counters {
+      std::array<counter, OPERATIONS> calls {}, nanoseconds {};
+      std::array<std::array<counter, LATENCY_BUCKETS>, OPERATIONS> histogram {};
+      std::array<std::array<counter, 3>, DATATYPES> bytes {};
+      unsigned id;
+
+      std::mutex events_mutex;
+      std::vector<event> events;
+    };
+
+    void bump(counter &c, const std::uint64_t value) noexcept
+    {
+      c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // counters of every live thread and those merged from exited ones, the baseline of
+    // the last reset being subtracted from their sum
+    struct registry {
+      std::mutex mutex;
+      std::vector<thread_counters *> threads;
+      instrument_snapshot retired {}, baseline {};
+      std::vector<std::pair<unsigned, event>> retired_events;
+      unsigned next_id { 0 };
+
+      std::atomic<std::int64_t> live { 0 }, peak { 0 };
+      std::atomic<bool> tracing { false };
+      const std::chrono::steady_clock::time_point origin {
+        std::chrono::steady_clock::now()
+      };
+
+      // never destroyed, threads may outlive static objects
+      static registry &instance()
+      {
+        static registry *state { new registry };
+        return *state;
+      }
+    };
+
+    void accumulate(instrument_snapshot &total, const thread_counters &counters) noexcept
+    {
+      for (std::size_t o { 0 }; o < OPERATIONS; ++o) {
+        auto &stats { total.operations[o] };
+        stats.calls += counters.calls[o].load(std::memory_order_relaxed);
+        stats.nanoseconds += counters.nanoseconds[o].load(std::memory_order_relaxed);
+        for (std::size_t b { 0 }; b < LATENCY_BUCKETS; ++b)
+          stats.histogram[b] += counters.histogram[o][b].load(std::memory_order_relaxed);
+      }
+      for (std::size_t t { 0 }; t < DATATYPES; ++t) {
+        auto &bytes { total.datatypes[t] };
+        bytes.allocated += counters.bytes[t][0].load(std::memory_order_relaxed);
+        bytes.copied += counters.bytes[t][1].load(std::memory_order_relaxed);
+        bytes.converted += counters.bytes[t][2].load(std::memory_order_relaxed);
+      }
+    }
+
+    // whether the handle of the calling thread is alive, trivially destructible so that
+    // probes of later thread-exit destructors can still read it
+    thread_local bool alive { false };
+
+    // registers the counters of the calling thread on its first probe, and merges them
+    // into the retired ones when it exits
+    struct thread_handle {
+      thread_counters counters;
+
+      thread_handle()
+      {
+        auto &state { registry::instance() };
+        const std::lock_guard lock { state.mutex };
+        counters.id = state.next_id++;
+        state.threads.push_back(&counters);
+        alive = true;
+      }
+
+      ~thread_handle()
+      {
+        alive = false;
+        auto &state { registry::instance() };
+        const std::lock_guard lock { state.mutex };
+        accumulate(state.retired, counters);
+        const std::lock_guard events { counters.events_mutex };
+        for (const auto &e : counters.events)
+          state.retired_events.emplace_back(counters.id, e);
+        auto &threads { state.threads };
+        threads.erase(std::find(threads.begin(), threads.end(), &counters));
+      }
+    };
+
+    // counters of the calling thread, null when they could not be registered, which is
+    // retried by its next probe, or once they were retired at its exit
+    thread_counters *local() noexcept
+    {
+      thread_local bool retired { false };
+      if (retired) return nullptr;
+      try {
+        thread_local thread_handle handle;
+        if (!alive) return retired = true, nullptr;
+        return &handle.counters;
+      } catch (...) {
+        return nullptr;
+      }
+    }
+
+    std::int64_t now(const registry &state) noexcept
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - state.origin)
+        .count();
+    }
+
+    std::size_t bucket(const std::uint64_t nanoseconds) noexcept
+    {
+      std::size_t b { 0 };
+      while (b + 1 < LATENCY_BUCKETS && nanoseconds >> (b + 1)) ++b;
+      return b;
+    }
+
+    const char *const DATATYPE_NAMES[DATATYPES] { "bool8", "int8", "int16", "int32",
+      "int64", "uint8", "uint16", "uint32", "uint64", "float32", "float64" };
+
+  }  // namespace
+
+  std::string str(const operation op)
+  {
+    static const char *const names[OPERATIONS] { "allocate", "copy", "convert", "fill",
+      "compare", "elementwise", "reduce", "matmul" };
+    return names[std::size_t(op)];
+  }
+
+  double operation_stats::percentile(const double fraction) const noexcept
+  {
+    const double target { std::clamp(fraction, 0., 1.) * double(calls) };
+    std::uint64_t seen { 0 };
+    for (std::size_t b { 0 }; b < LATENCY_BUCKETS; ++b)
+      if (histogram[b] && double(seen += histogram[b]) >= target)
+        return double(std::uint64_t(1) << (b + 1));
+    return 0.;
+  }
+
+  const operation_stats &instrument_snapshot::operator[](
+    const operation op) const noexcept
+  {
+    return operations[std::size_t(op)];
+  }
+
+  const datatype_bytes &instrument_snapshot::operator[](
+    const datatype type) const noexcept
+  {
+    return datatypes[std::size_t(type)];
+  }
+
+  instrument_snapshot snapshot()
+  {
+    auto &state { registry::instance() };
+    const std::lock_guard lock { state.mutex };
+    instrument_snapshot total { state.retired };
+    for (const auto *counters : state.threads) accumulate(total, *counters);
+
+    const auto &base { state.baseline };
+    for (std::size_t o { 0 }; o < OPERATIONS; ++o) {
+      total.operations[o].calls -= base.operations[o].calls;
+      total.operations[o].nanoseconds -= base.operations[o].nanoseconds;
+      for (std::size_t b { 0 }; b < LATENCY_BUCKETS; ++b)
+        total.operations[o].histogram[b] -= base.operations[o].histogram[b];
+    }
+    for (std::size_t t { 0 }; t < DATATYPES; ++t) {
+      total.datatypes[t].allocated -= base.datatypes[t].allocated;
+      total.datatypes[t].copied -= base.datatypes[t].copied;
+      total.datatypes[t].converted -= base.datatypes[t].converted;
+    }
+    total.live_bytes = std::size_t(std::max<std::int64_t>(state.live.load(), 0));
+    total.peak_bytes = std::size_t(std::max<std::int64_t>(state.peak.load(), 0));
+    return total;
+  }
+
+  // the baseline is taken under the lock, counters of running threads are left alone
+  void reset_instrumentation()
+  {
+    auto &state { registry::instance() };
+    const std::lock_guard lock { state.mutex };
+    state.baseline = state.retired;
+    for (const auto *counters : state.threads) accumulate(state.baseline, *counters);
+    state.peak = state.live.load();
+  }
+
+  void start_trace()
+  {
+    auto &state { registry::instance() };
+    const std::lock_guard lock { state.mutex };
+    state.retired_events.clear();
+    for (auto *counters : state.threads) {
+      const std::lock_guard events { counters->events_mutex };
+      counters->events.clear();
+    }
+    state.tracing = true;
+  }
+
+  void stop_trace() noexcept
+  {
+    registry::instance().tracing = false;
+  }
+
+  bool tracing() noexcept
+  {
+    return registry::instance().tracing.load(std::memory_order_relaxed);
+  }
+
+  void write_chrome_trace(std::ostream &out)
+  {
+    auto &state { registry::instance() };
+    std::vector<std::pair<unsigned, event>> events;
+    {
+      const std::lock_guard lock { state.mutex };
+      events = state.retired_events;
+      for (auto *counters : state.threads) {
+        const std::lock_guard guard { counters->events_mutex };
+        for (const auto &e : counters->events) events.emplace_back(counters->id, e);
+      }
+    }
+    std::stable_sort(events.begin(), events.end(),
+      [](const auto &a, const auto &b) { return a.second.start < b.second.start; });
+
+    // timestamps are in microseconds with nanosecond decimals
+    const auto micros = [&out](const std::int64_t ns) {
+      out << ns / 1000 << '.' << char('0' + ns / 100 % 10) << char('0' + ns / 10 % 10)
+          << char('0' + ns % 10);
+    };
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first { true };
+    for (const auto &[tid, e] : events) {
+      out << (first ? "\n" : ",\n") << "{\"name\": \"" << str(e.op) << "\", \"cat\": \""
+          << DATATYPE_NAMES[std::size_t(e.type)]
+          << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid << ", \"ts\": ";
+      micros(e.start);
+      out << ", \"dur\": ";
+      micros(e.duration);
+      out << ", \"args\": {\"bytes\": " << e.bytes << "}}";
+      if (e.live >= 0) {
+        out << ",\n{\"name\": \"live bytes\", \"ph\": \"C\", \"pid\": 1, \"ts\": ";
+        micros(e.start + e.duration);
+        out << ", \"args\": {\"bytes\": " << e.live << "}}";
+      }
+      first = false;
+    }
+    out << "\n]}\n";
+  }
+
+  namespace detail
+  {
+    probe::probe(
+      const operation op, const datatype type, const std::size_t bytes) noexcept
+      : m_op { op }, m_type { type }, m_bytes { bytes },
+        m_start { now(registry::instance()) }, m_exceptions { std::uncaught_exceptions() }
+    { }
+
+    probe::~probe() noexcept
+    {
+      if (std::uncaught_exceptions() > m_exceptions) return;
+      auto &state { registry::instance() };
+      const std::int64_t elapsed { std::max<std::int64_t>(now(state) - m_start, 0) };
+      const std::size_t o { std::size_t(m_op) }, t { std::size_t(m_type) };
+
+      // live bytes are kept even when the sample is dropped, releases are never dropped
+      std::int64_t live { -1 };
+      if (m_op == operation::allocate) {
+        live = state.live.fetch_add(std::int64_t(m_bytes), std::memory_order_relaxed)
+               + std::int64_t(m_bytes);
+        std::int64_t peak { state.peak.load(std::memory_order_relaxed) };
+        while (live > peak && !state.peak.compare_exchange_weak(peak, live)) { }
+      }
+
+      thread_counters *const local_counters { local() };
+      if (!local_counters) return;
+      thread_counters &counters { *local_counters };
+      bump(counters.calls[o], 1);
+      bump(counters.nanoseconds[o], std::uint64_t(elapsed));
+      bump(counters.histogram[o][bucket(std::uint64_t(elapsed))], 1);
+      if (m_op == operation::allocate)
+        bump(counters.bytes[t][0], m_bytes);
+      else if (m_op == operation::copy)
+        bump(counters.bytes[t][1], m_bytes);
+      else if (m_op == operation::convert)
+        bump(counters.bytes[t][2], m_bytes);
+
+      if (!state.tracing.load(std::memory_order_relaxed)) return;
+      try {
+        const std::lock_guard lock { counters.events_mutex };
+        counters.events.push_back({ m_op, m_type, m_bytes, m_start, elapsed, live });
+      } catch (...) {
+        // events are dropped rather than failing the operation
+      }
+    }
+
+    void record_release(const std::size_t bytes) noexcept
+    {
+      registry::instance().live.fetch_sub(std::int64_t(bytes), std::memory_order_relaxed);
+    }
+
+  }  // namespace detail
+
+}  // namespace covdel::ma
@@ -0,0 +1,86 @@
+#ifndef __COVDEL_SRC_MA_KERNELS_HH_1700473488__
+#define __COVDEL_SRC_MA_KERNELS_HH_1700473488__
+
+#include "covdel/ma/arithmetic.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace covdel::ma::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  static constexpr int ARITHMETIC_OPS { 6 };
+  static constexpr int COMPARISON_OPS { 6 };
+  static constexpr int UNARY_OPS { 5 };
+  static constexpr int DATATYPES { 11 };
+
+  // integer sums and products wrap around in 64 bits, floating point ones accumulate in
+  // double precision
+  template<typename _Type>
+  using accumulator_t =
+    std::conditional_t<std::is_floating_point_v<_Type>, double, std::uint64_t>;
+
+  template<typename _Type>
+  struct reduction_table {
+    using acc_type = accumulator_t<_Type>;
+
+    // folding a strided run into a single value, float minima and maxima propagate NaNs
+    acc_type (*sum)(const _Type *x, ptrdiff_t sx, size_t count);
+    acc_type (*prod)(const _Type *x, ptrdiff_t sx, size_t count);
+    double (*sumsq)(const _Type *x, ptrdiff_t sx, size_t count, double center);
+    _Type (*min)(const _Type *x, ptrdiff_t sx, size_t count, _Type init);
+    _Type (*max)(const _Type *x, ptrdiff_t sx, size_t count, _Type init);
+    std::uint64_t (*nonzero)(const _Type *x, ptrdiff_t sx, size_t count);
+
+    // accumulating a strided run element-wise into a row of accumulators, floating point
+    // sums carry a Kahan compensation per element in `comp`
+    void (*sum_row)(const _Type *x, ptrdiff_t sx, acc_type *row, acc_type *comp, size_t count);
+    void (*prod_row)(const _Type *x, ptrdiff_t sx, acc_type *row, size_t count);
+    void (*sumsq_row)(const _Type *x, ptrdiff_t sx, const double *center, double *row,
+      double *comp, size_t count);
+    void (*min_row)(const _Type *x, ptrdiff_t sx, _Type *row, size_t count);
+    void (*max_row)(const _Type *x, ptrdiff_t sx, _Type *row, size_t count);
+    void (*nonzero_row)(const _Type *x, ptrdiff_t sx, std::uint64_t *row, size_t count);
+  };
+
+  template<typename _Type>
+  struct kernel_table {
+    binary_kernel<_Type, _Type> arithmetic[ARITHMETIC_OPS];
+    binary_kernel<_Type, bool> comparison[COMPARISON_OPS];
+    unary_kernel<_Type> unary[UNARY_OPS];
+    clamp_kernel<_Type> clamp;
+    convert_kernel<_Type> convert[DATATYPES];
+    reduction_table<_Type> reduce;
+  };
+
+  // kernels of every datatype compiled for one instruction set level
+  struct kernel_registry {
+    kernel_table<bool> bool8;
+    kernel_table<std::int8_t> int8;
+    kernel_table<std::int16_t> int16;
+    kernel_table<std::int32_t> int32;
+    kernel_table<std::int64_t> int64;
+    kernel_table<std::uint8_t> uint8;
+    kernel_table<std::uint16_t> uint16;
+    kernel_table<std::uint32_t> uint32;
+    kernel_table<std::uint64_t> uint64;
+    kernel_table<float> float32;
+    kernel_table<double> float64;
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(kernel_registry &registry) noexcept; }
+  namespace sse2 { void fill(kernel_registry &registry) noexcept; }
+  namespace avx2 { void fill(kernel_registry &registry) noexcept; }
+  namespace avx512 { void fill(kernel_registry &registry) noexcept; }
+
+  // kernels of the currently active instruction set level
+  template<typename _Type>
+  const kernel_table<_Type> &kernels() noexcept;
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,671 @@
+// Element-wise, conversion and reduction kernel bodies, compiled once per instruction set
+// level. Each including translation unit defines COVDEL_KERNEL_ISA and is built with the
+// matching target flags, so the loops below are auto-vectorized for that level.
+// Everything except the fill() entry point has internal linkage, and no out-of-line
+// library templates are used, so code generated for a wider instruction set can never be
+// picked by the linker for another translation unit.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "kernels.hh"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace covdel::ma::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+    template<typename _Type>
+    static constexpr bool is_int { std::is_integral_v<_Type> && !std::is_same_v<_Type, bool> };
+
+    // integer arithmetic is carried out unsigned, so overflow wraps instead of being UB
+    template<typename _Type, bool = is_int<_Type>>
+    struct wide {
+      using type = _Type;
+    };
+
+    template<typename _Type>
+    struct wide<_Type, true> {
+      using type = std::conditional_t<(sizeof(_Type) < sizeof(unsigned)), unsigned,
+        std::make_unsigned_t<_Type>>;
+    };
+
+    template<typename _Type>
+    using wide_t = typename wide<_Type>::type;
+
+    // integers clamped to the range of another integer type, compared without conversions
+    // which could wrap
+    template<typename _To, typename _From>
+    inline _To saturate_int(const _From x)
+    {
+      using limits = std::numeric_limits<_To>;
+      if constexpr (std::is_signed_v<_From>)
+        if (x < 0) {
+          if constexpr (std::is_signed_v<_To>)
+            return std::int64_t(x) < std::int64_t(limits::lowest()) ? limits::lowest()
+                                                                    : _To(x);
+          else
+            return _To(0);
+        }
+      return std::uint64_t(x) > std::uint64_t(limits::max()) ? limits::max() : _To(x);
+    }
+
+    // rounds, saturates and converts a single value, floating point values are clamped in
+    // their own precision where it holds the limits of the output exactly, and compared
+    // against them otherwise, as the rounded up maximum is out of range itself
+    template<typename _To, bool _Nearest, bool _Saturate, typename _Value>
+    inline _To narrow(_Value v)
+    {
+      using limits = std::numeric_limits<_To>;
+      if constexpr (std::is_same_v<_To, bool>)
+        return v != 0;
+      else if constexpr (!is_int<_To>)
+        return _To(v);
+      else if constexpr (!std::is_floating_point_v<_Value>) {
+        if constexpr (_Saturate)
+          return saturate_int<_To>(v);
+        else
+          return _To(v);
+      } else {
+        if constexpr (_Nearest) {
+          if constexpr (std::is_same_v<_Value, float>)
+            v = __builtin_rintf(v);
+          else
+            v = __builtin_rint(v);
+        }
+        if constexpr (_Saturate) {
+          constexpr _Value lo { _Value(limits::lowest()) }, hi { _Value(limits::max()) };
+          if constexpr (limits::digits <= std::numeric_limits<_Value>::digits) {
+            v = v == v ? v : _Value(0);
+            v = v < lo ? lo : v;
+            v = v > hi ? hi : v;
+          } else
+            return v != v ? _To(0)
+              : v <= lo   ? limits::lowest()
+              : v >= hi   ? limits::max()
+                          : _To(v);
+        }
+        return _To(v);
+      }
+    }
+
+    ///////////////////////////////////// OPERATIONS /////////////////////////////////////
+
+    struct add_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b)
+      {
+        if constexpr (is_int<_Type>)
+          return _Type(wide_t<_Type>(a) + wide_t<_Type>(b));
+        else
+          return _Type(a + b);
+      }
+    };
+
+    struct subtract_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b)
+      {
+        if constexpr (is_int<_Type>)
+          return _Type(wide_t<_Type>(a) - wide_t<_Type>(b));
+        else
+          return _Type(a - b);
+      }
+    };
+
+    struct multiply_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b)
+      {
+        if constexpr (is_int<_Type>)
+          return _Type(wide_t<_Type>(a) * wide_t<_Type>(b));
+        else
+          return _Type(a * b);
+      }
+    };
+
+    // integer division by zero yields zero, and signed MIN / -1 wraps
+    struct divide_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b)
+      {
+        if constexpr (std::is_floating_point_v<_Type>)
+          return a / b;
+        else if constexpr (std::is_signed_v<_Type>) {
+          if (b == -1) return _Type(wide_t<_Type>(0) - wide_t<_Type>(a));
+          return b == 0 ? _Type(0) : _Type(a / b);
+        } else
+          return b == 0 ? _Type(0) : _Type(a / b);
+      }
+    };
+
+    struct minimum_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b) { return b < a ? b : a; }
+    };
+
+    struct maximum_op {
+      template<typename _Type>
+      static _Type apply(_Type a, _Type b) { return a < b ? b : a; }
+    };
+
+    struct equal_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a == b; }
+    };
+
+    struct not_equal_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a != b; }
+    };
+
+    struct less_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a < b; }
+    };
+
+    struct less_equal_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a <= b; }
+    };
+
+    struct greater_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a > b; }
+    };
+
+    struct greater_equal_op {
+      template<typename _Type>
+      static bool apply(_Type a, _Type b) { return a >= b; }
+    };
+
+    struct abs_op {
+      template<typename _Type>
+      static _Type apply(_Type a)
+      {
+        if constexpr (std::is_same_v<_Type, float>)
+          return __builtin_fabsf(a);
+        else if constexpr (std::is_floating_point_v<_Type>)
+          return __builtin_fabs(a);
+        else if constexpr (std::is_signed_v<_Type>)
+          return a < 0 ? _Type(wide_t<_Type>(0) - wide_t<_Type>(a)) : a;
+        else
+          return a;
+      }
+    };
+
+    struct negative_op {
+      template<typename _Type>
+      static _Type apply(_Type a)
+      {
+        if constexpr (is_int<_Type>)
+          return _Type(wide_t<_Type>(0) - wide_t<_Type>(a));
+        else if constexpr (std::is_same_v<_Type, bool>)
+          return a;
+        else
+          return -a;
+      }
+    };
+
+    // transcendental functions of integers are evaluated in double precision, then
+    // truncated and saturated to the integer type, NaN results such as the square roots
+    // and logarithms of negative values giving zero
+    struct sqrt_op {
+      template<typename _Type>
+      static _Type apply(_Type a)
+      {
+        if constexpr (std::is_same_v<_Type, float>)
+          return __builtin_sqrtf(a);
+        else
+          return narrow<_Type, false, true>(__builtin_sqrt(double(a)));
+      }
+    };
+
+    struct exp_op {
+      template<typename _Type>
+      static _Type apply(_Type a)
+      {
+        if constexpr (std::is_same_v<_Type, float>)
+          return __builtin_expf(a);
+        else
+          return narrow<_Type, false, true>(__builtin_exp(double(a)));
+      }
+    };
+
+    struct log_op {
+      template<typename _Type>
+      static _Type apply(_Type a)
+      {
+        if constexpr (std::is_same_v<_Type, float>)
+          return __builtin_logf(a);
+        else
+          return narrow<_Type, false, true>(__builtin_log(double(a)));
+      }
+    };
+
+    ////////////////////////////////////// KERNELS ///////////////////////////////////////
+
+    // contiguous and scalar-operand runs get dedicated loops the vectorizer can handle
+    template<typename _Op, typename _Type, typename _RType>
+    void binary(const _Type *a, ptrdiff_t sa, const _Type *b, ptrdiff_t sb, _RType *out,
+      ptrdiff_t so, size_t count)
+    {
+      if (so == 1 && sa == 1 && sb == 1)
+        for (size_t i { 0 }; i < count; ++i) out[i] = _Op::apply(a[i], b[i]);
+      else if (so == 1 && sa == 1 && sb == 0) {
+        const _Type value { *b };
+        for (size_t i { 0 }; i < count; ++i) out[i] = _Op::apply(a[i], value);
+      } else if (so == 1 && sa == 0 && sb == 1) {
+        const _Type value { *a };
+        for (size_t i { 0 }; i < count; ++i) out[i] = _Op::apply(value, b[i]);
+      } else
+        for (size_t i { 0 }; i < count; ++i, a += sa, b += sb, out += so)
+          *out = _Op::apply(*a, *b);
+    }
+
+    template<typename _Op, typename _Type>
+    void unary(const _Type *a, ptrdiff_t sa, _Type *out, ptrdiff_t so, size_t count)
+    {
+      if (so == 1 && sa == 1)
+        for (size_t i { 0 }; i < count; ++i) out[i] = _Op::apply(a[i]);
+      else
+        for (size_t i { 0 }; i < count; ++i, a += sa, out += so) *out = _Op::apply(*a);
+    }
+
+    template<typename _Type>
+    void clamp(const _Type *a, ptrdiff_t sa, _Type lo, _Type hi, _Type *out, ptrdiff_t so,
+      size_t count)
+    {
+      if (so == 1 && sa == 1)
+        for (size_t i { 0 }; i < count; ++i) {
+          const _Type value { a[i] < lo ? lo : a[i] };
+          out[i] = hi < value ? hi : value;
+        }
+      else
+        for (size_t i { 0 }; i < count; ++i, a += sa, out += so) {
+          const _Type value { *a < lo ? lo : *a };
+          *out = hi < value ? hi : value;
+        }
+    }
+
+    //////////////////////////////////// CONVERSIONS /////////////////////////////////////
+
+    // precision of scaled conversions, float32 unless either datatype holds values it
+    // cannot represent exactly
+    template<typename _Type>
+    static constexpr bool fits_float {
+      sizeof(_Type) <= 2 || std::is_same_v<_Type, float>
+    };
+
+    template<typename _From, typename _To>
+    using scaled_t =
+      std::conditional_t<fits_float<_From> && fits_float<_To>, float, double>;
+
+    template<typename _From, typename _To, bool _Nearest, bool _Saturate, bool _Scaled>
+    void convert_run(const _From *a, ptrdiff_t sa, _To *out, ptrdiff_t so, size_t count,
+      const conversion &conv)
+    {
+      using value_type = scaled_t<_From, _To>;
+      const value_type scale { value_type(conv.scale) };
+      const value_type offset { value_type(conv.offset) };
+      const auto apply = [scale, offset](const _From x) {
+        if constexpr (_Scaled)
+          return narrow<_To, _Nearest, _Saturate>(value_type(x) * scale + offset);
+        else
+          return narrow<_To, _Nearest, _Saturate>(x);
+      };
+      if (so == 1 && sa == 1)
+        for (size_t i { 0 }; i < count; ++i) out[i] = apply(a[i]);
+      else
+        for (size_t i { 0 }; i < count; ++i, a += sa, out += so) *out = apply(*a);
+    }
+
+    // rounding only matters for floating point values converted to integers, and
+    // saturation for integer outputs
+    template<typename _From, typename _To>
+    void convert(const _From *a, ptrdiff_t sa, void *out, ptrdiff_t so, size_t count,
+      const conversion &conv)
+    {
+      using run_type =
+        void (*)(const _From *, ptrdiff_t, _To *, ptrdiff_t, size_t, const conversion &);
+      constexpr bool rounds { is_int<_To> }, floats { std::is_floating_point_v<_From> };
+
+      // loops specialized for each combination of options, indexed by the nearest,
+      // saturate and scaled bits, options which do not apply share one instantiation
+      constexpr run_type runs[8] {
+        convert_run<_From, _To, false, false, false>,
+        convert_run<_From, _To, false, false, true>,
+        convert_run<_From, _To, false, rounds, false>,
+        convert_run<_From, _To, false, rounds, true>,
+        convert_run<_From, _To, rounds && floats, false, false>,
+        convert_run<_From, _To, rounds, false, true>,
+        convert_run<_From, _To, rounds && floats, rounds, false>,
+        convert_run<_From, _To, rounds, rounds, true>,
+      };
+
+      const bool nearest { conv.round == rounding::nearest_even };
+      const bool scaled { conv.scale != 1 || conv.offset != 0 };
+      const run_type run { runs[int(nearest) << 2 | int(conv.saturate) << 1 | int(scaled)] };
+      run(a, sa, static_cast<_To *>(out), so, count, conv);
+    }
+
+    ///////////////////////////////////// REDUCTIONS /////////////////////////////////////
+
+    // independent partial results per run, enough for the vectorizer to fill a register
+    static constexpr size_t LANES { 8 };
+    // runs up to this length are summed lane-wise, longer ones are halved recursively
+    static constexpr size_t PAIRWISE_BLOCK { 128 };
+
+    // pairwise summation of f(x) in double precision, the rounding error grows as O(log n)
+    // instead of O(n) and the result only depends on the run length
+    template<typename _Type, typename _Func>
+    double pairwise(const _Type *x, ptrdiff_t sx, size_t count, _Func f)
+    {
+      if (count < LANES) {
+        double sum { 0 };
+        for (size_t i { 0 }; i < count; ++i) sum += f(x[ptrdiff_t(i) * sx]);
+        return sum;
+      }
+
+      if (count <= PAIRWISE_BLOCK) {
+        double lane[LANES];
+        for (size_t l { 0 }; l < LANES; ++l) lane[l] = f(x[ptrdiff_t(l) * sx]);
+        size_t i { LANES };
+        if (sx == 1)
+          for (; i + LANES <= count; i += LANES)
+            for (size_t l { 0 }; l < LANES; ++l) lane[l] += f(x[i + l]);
+        else
+          for (; i + LANES <= count; i += LANES)
+            for (size_t l { 0 }; l < LANES; ++l) lane[l] += f(x[ptrdiff_t(i + l) * sx]);
+        double sum { ((lane[0] + lane[1]) + (lane[2] + lane[3]))
+          + ((lane[4] + lane[5]) + (lane[6] + lane[7])) };
+        for (; i < count; ++i) sum += f(x[ptrdiff_t(i) * sx]);
+        return sum;
+      }
+
+      size_t half { count / 2 };
+      half -= half % LANES;
+      return pairwise(x, sx, half, f) + pairwise(x + ptrdiff_t(half) * sx, sx, count - half, f);
+    }
+
+    template<typename _Type>
+    accumulator_t<_Type> sum(const _Type *x, ptrdiff_t sx, size_t count)
+    {
+      if constexpr (std::is_floating_point_v<_Type>)
+        return pairwise(x, sx, count, [](const _Type v) { return double(v); });
+      else {
+        std::uint64_t sum { 0 };
+        if constexpr (sizeof(_Type) <= 2) {
+          // narrow integers are summed in 32-bit blocks which cannot overflow, fitting
+          // twice the lanes of 64-bit accumulators into each register
+          using block_t =
+            std::conditional_t<std::is_signed_v<_Type>, std::int32_t, std::uint32_t>;
+          constexpr size_t BLOCK { 1UL << 15 };
+          if (sx == 1) {
+            for (size_t first { 0 }; first < count; first += BLOCK) {
+              const size_t last { first + BLOCK < count ? first + BLOCK : count };
+              block_t block { 0 };
+              for (size_t i { first }; i < last; ++i) block += block_t(x[i]);
+              sum += std::uint64_t(std::int64_t(block));
+            }
+            return sum;
+          }
+        }
+        if (sx == 1)
+          for (size_t i { 0 }; i < count; ++i) sum += std::uint64_t(x[i]);
+        else
+          for (size_t i { 0 }; i < count; ++i, x += sx) sum += std::uint64_t(*x);
+        return sum;
+      }
+    }
+
+    template<typename _Type>
+    accumulator_t<_Type> prod(const _Type *x, ptrdiff_t sx, size_t count)
+    {
+      accumulator_t<_Type> prod { 1 };
+      for (size_t i { 0 }; i < count; ++i, x += sx) prod *= accumulator_t<_Type>(*x);
+      return prod;
+    }
+
+    // squared deviations from `center`, the second pass of a variance
+    template<typename _Type>
+    double sumsq(const _Type *x, ptrdiff_t sx, size_t count, double center)
+    {
+      return pairwise(x, sx, count, [center](const _Type v) {
+        const double d { double(v) - center };
+        return d * d;
+      });
+    }
+
+    // NaN compares false both ways, so it is picked explicitly and then kept
+    struct min_pick {
+      template<typename _Type>
+      static _Type ordered(_Type m, _Type v) { return v < m ? v : m; }
+
+      template<typename _Type>
+      static _Type apply(_Type m, _Type v)
+      {
+        if constexpr (std::is_floating_point_v<_Type>)
+          return (v < m || v != v) ? v : m;
+        else
+          return ordered(m, v);
+      }
+    };
+
+    struct max_pick {
+      template<typename _Type>
+      static _Type ordered(_Type m, _Type v) { return m < v ? v : m; }
+
+      template<typename _Type>
+      static _Type apply(_Type m, _Type v)
+      {
+        if constexpr (std::is_floating_point_v<_Type>)
+          return (m < v || v != v) ? v : m;
+        else
+          return ordered(m, v);
+      }
+    };
+
+    // one register of the level this unit is built for, so that no vector is passed in a
+    // way the ABI of that level does not define
+#if defined(__AVX512F__)
+    static constexpr size_t VECTOR_BYTES { 64 };
+#elif defined(__AVX__)
+    static constexpr size_t VECTOR_BYTES { 32 };
+#else
+    static constexpr size_t VECTOR_BYTES { 16 };
+#endif
+
+    // the vectorizer leaves compare-and-select reductions of floats alone, so contiguous
+    // runs are folded with generic vectors, noting NaNs on the side instead of picking them
+    template<typename _Pick, typename _Type>
+    _Type extreme_vector(const _Type *x, size_t count, size_t &i, _Type init)
+    {
+      typedef _Type vector __attribute__((vector_size(VECTOR_BYTES)));
+      constexpr size_t WIDTH { VECTOR_BYTES / sizeof(_Type) };
+
+      vector lane { vector {} + init }, value;
+      decltype(value != value) unordered {};
+      for (; i + WIDTH <= count; i += WIDTH) {
+        __builtin_memcpy(&value, x + i, sizeof(value));
+        lane = _Pick::ordered(lane, value);
+        if constexpr (std::is_floating_point_v<_Type>) unordered |= value != value;
+      }
+      for (size_t l { 0 }; l < WIDTH; ++l) {
+        if constexpr (std::is_floating_point_v<_Type>)
+          if (unordered[l]) return _Type(__builtin_nan(""));
+        init = _Pick::apply(init, _Type(lane[l]));
+      }
+      return init;
+    }
+
+    template<typename _Pick, typename _Type>
+    _Type extreme(const _Type *x, ptrdiff_t sx, size_t count, _Type init)
+    {
+      size_t i { 0 };
+      if constexpr (!std::is_same_v<_Type, bool>)
+        if (sx == 1) init = extreme_vector<_Pick>(x, count, i, init);
+      for (; i < count; ++i) init = _Pick::apply(init, x[ptrdiff_t(i) * sx]);
+      return init;
+    }
+
+    template<typename _Type>
+    std::uint64_t nonzero(const _Type *x, ptrdiff_t sx, size_t count)
+    {
+      std::uint64_t nonzero { 0 };
+      if (sx == 1)
+        for (size_t i { 0 }; i < count; ++i) nonzero += x[i] != _Type(0);
+      else
+        for (size_t i { 0 }; i < count; ++i, x += sx) nonzero += *x != _Type(0);
+      return nonzero;
+    }
+
+    // Kahan summation keeps the low order bits lost by each float64 addition in `comp`
+    template<typename _Type>
+    void sum_row(const _Type *x, ptrdiff_t sx, accumulator_t<_Type> *row,
+      accumulator_t<_Type> *comp, size_t count)
+    {
+      if constexpr (std::is_same_v<_Type, float>) {
+        // float32 values lose nothing in a double accumulator for any practical length
+        if (sx == 1)
+          for (size_t i { 0 }; i < count; ++i) row[i] += double(x[i]);
+        else
+          for (size_t i { 0 }; i < count; ++i, x += sx) row[i] += double(*x);
+      } else if constexpr (std::is_floating_point_v<_Type>) {
+        if (sx == 1)
+          for (size_t i { 0 }; i < count; ++i) {
+            const double y { double(x[i]) - comp[i] }, t { row[i] + y };
+            comp[i] = (t - row[i]) - y;
+            row[i]  = t;
+          }
+        else
+          for (size_t i { 0 }; i < count; ++i, x += sx) {
+            const double y { double(*x) - comp[i] }, t { row[i] + y };
+            comp[i] = (t - row[i]) - y;
+            row[i]  = t;
+          }
+      } else if (sx == 1)
+        for (size_t i { 0 }; i < count; ++i) row[i] += std::uint64_t(x[i]);
+      else
+        for (size_t i { 0 }; i < count; ++i, x += sx) row[i] += std::uint64_t(*x);
+    }
+
+    template<typename _Type>
+    void prod_row(const _Type *x, ptrdiff_t sx, accumulator_t<_Type> *row, size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i, x += sx) row[i] *= accumulator_t<_Type>(*x);
+    }
+
+    template<typename _Type>
+    void sumsq_row(const _Type *x, ptrdiff_t sx, const double *center, double *row,
+      double *comp, size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i, x += sx) {
+        const double d { double(*x) - center[i] };
+        const double y { d * d - comp[i] }, t { row[i] + y };
+        comp[i] = (t - row[i]) - y;
+        row[i]  = t;
+      }
+    }
+
+    template<typename _Pick, typename _Type>
+    void extreme_row(const _Type *x, ptrdiff_t sx, _Type *row, size_t count)
+    {
+      if (sx == 1)
+        for (size_t i { 0 }; i < count; ++i) row[i] = _Pick::apply(row[i], x[i]);
+      else
+        for (size_t i { 0 }; i < count; ++i, x += sx) row[i] = _Pick::apply(row[i], *x);
+    }
+
+    template<typename _Type>
+    void nonzero_row(const _Type *x, ptrdiff_t sx, std::uint64_t *row, size_t count)
+    {
+      if (sx == 1)
+        for (size_t i { 0 }; i < count; ++i) row[i] += x[i] != _Type(0);
+      else
+        for (size_t i { 0 }; i < count; ++i, x += sx) row[i] += *x != _Type(0);
+    }
+
+    template<typename _Type>
+    void fill_reductions(reduction_table<_Type> &table) noexcept
+    {
+      table.sum     = sum<_Type>;
+      table.prod    = prod<_Type>;
+      table.sumsq   = sumsq<_Type>;
+      table.min     = extreme<min_pick, _Type>;
+      table.max     = extreme<max_pick, _Type>;
+      table.nonzero = nonzero<_Type>;
+
+      table.sum_row     = sum_row<_Type>;
+      table.prod_row    = prod_row<_Type>;
+      table.sumsq_row   = sumsq_row<_Type>;
+      table.min_row     = extreme_row<min_pick, _Type>;
+      table.max_row     = extreme_row<max_pick, _Type>;
+      table.nonzero_row = nonzero_row<_Type>;
+    }
+
+    template<typename _Type>
+    void fill_table(kernel_table<_Type> &table) noexcept
+    {
+      table.arithmetic[int(binary_op::add)]      = binary<add_op, _Type, _Type>;
+      table.arithmetic[int(binary_op::subtract)] = binary<subtract_op, _Type, _Type>;
+      table.arithmetic[int(binary_op::multiply)] = binary<multiply_op, _Type, _Type>;
+      table.arithmetic[int(binary_op::divide)]   = binary<divide_op, _Type, _Type>;
+      table.arithmetic[int(binary_op::minimum)]  = binary<minimum_op, _Type, _Type>;
+      table.arithmetic[int(binary_op::maximum)]  = binary<maximum_op, _Type, _Type>;
+
+      constexpr int base { int(binary_op::equal) };
+      table.comparison[int(binary_op::equal) - base]     = binary<equal_op, _Type, bool>;
+      table.comparison[int(binary_op::not_equal) - base] = binary<not_equal_op, _Type, bool>;
+      table.comparison[int(binary_op::less) - base]      = binary<less_op, _Type, bool>;
+      table.comparison[int(binary_op::less_equal) - base] =
+        binary<less_equal_op, _Type, bool>;
+      table.comparison[int(binary_op::greater) - base] = binary<greater_op, _Type, bool>;
+      table.comparison[int(binary_op::greater_equal) - base] =
+        binary<greater_equal_op, _Type, bool>;
+
+      table.unary[int(unary_op::abs)]      = unary<abs_op, _Type>;
+      table.unary[int(unary_op::negative)] = unary<negative_op, _Type>;
+      table.unary[int(unary_op::sqrt)]     = unary<sqrt_op, _Type>;
+      table.unary[int(unary_op::exp)]      = unary<exp_op, _Type>;
+      table.unary[int(unary_op::log)]      = unary<log_op, _Type>;
+
+      table.clamp = clamp<_Type>;
+
+      table.convert[int(datatype::bool8)]   = convert<_Type, bool>;
+      table.convert[int(datatype::int8)]    = convert<_Type, std::int8_t>;
+      table.convert[int(datatype::int16)]   = convert<_Type, std::int16_t>;
+      table.convert[int(datatype::int32)]   = convert<_Type, std::int32_t>;
+      table.convert[int(datatype::int64)]   = convert<_Type, std::int64_t>;
+      table.convert[int(datatype::uint8)]   = convert<_Type, std::uint8_t>;
+      table.convert[int(datatype::uint16)]  = convert<_Type, std::uint16_t>;
+      table.convert[int(datatype::uint32)]  = convert<_Type, std::uint32_t>;
+      table.convert[int(datatype::uint64)]  = convert<_Type, std::uint64_t>;
+      table.convert[int(datatype::float32)] = convert<_Type, float>;
+      table.convert[int(datatype::float64)] = convert<_Type, double>;
+
+      fill_reductions(table.reduce);
+    }
+
+  }  // namespace
+
+  void fill(kernel_registry &registry) noexcept
+  {
+    fill_table(registry.bool8);
+    fill_table(registry.int8);
+    fill_table(registry.int16);
+    fill_table(registry.int32);
+    fill_table(registry.int64);
+    fill_table(registry.uint8);
+    fill_table(registry.uint16);
+    fill_table(registry.uint32);
+    fill_table(registry.uint64);
+    fill_table(registry.float32);
+    fill_table(registry.float64);
+  }
+
+}  // namespace covdel::ma::detail::COVDEL_KERNEL_ISA
@@ -0,0 +1,342 @@
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/instrument.hh"
+
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/simd.hh"
+#include "gemm_kernels.hh"
+#include "parallel.hh"
+#include "scratch.hh"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <type_traits>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    template<typename _Type>
+    const gemm_table<_Type> &gemm_kernels() noexcept
+    {
+      static const auto s_levels { [] {
+        std::array<gemm_registry, 4> levels {};
+        scalar::fill(levels[int(isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+        sse2::fill(levels[int(isa::sse2)]);
+        avx2::fill(levels[int(isa::avx2)]);
+        avx512::fill(levels[int(isa::avx512)]);
+#endif
+        return levels;
+      }() };
+      const auto &registry { s_levels[int(active_isa())] };
+      if constexpr (std::is_same_v<_Type, float>)
+        return registry.float32;
+      else
+        return registry.float64;
+    }
+
+    template const gemm_table<float> &gemm_kernels() noexcept;
+    template const gemm_table<double> &gemm_kernels() noexcept;
+
+  }  // namespace detail
+
+  namespace
+  {
+    using detail::gemm_table;
+    using detail::scratch;
+
+    // flops of a product below which stacks of them are split across threads instead of
+    // each product on its own
+    static constexpr size_t SMALL_PRODUCT { 1UL << 22 };
+
+    // an operand as a stack of matrices along its leading axes, vectors being a single
+    // row of a or column of b
+    struct layout {
+      layout(const dimension &dim, const stride &strides, const bool column,
+        const bool transposed)
+      {
+        const int ndims { dim.ndims() };
+        if (ndims == 1) {
+          is_vector = true;
+          (column ? rows : cols) = dim[0];
+          (column ? rs : cs)     = strides[0];
+          return;
+        }
+        nlead = ndims - 2;
+        for (int i { -1 }; ++i < nlead;) lead[i] = dim[i], lead_step[i] = strides[i];
+        rows = dim[ndims - 2], cols = dim[ndims - 1];
+        rs = strides[ndims - 2], cs = strides[ndims - 1];
+        if (transposed) std::swap(rows, cols), std::swap(rs, cs);
+      }
+
+      int nlead { 0 };
+      std::array<size_t, 6> lead {};
+      std::array<ptrdiff_t, 6> lead_step {};
+      size_t rows { 1 }, cols { 1 };
+      ptrdiff_t rs { 0 }, cs { 0 };
+      bool is_vector { false };
+    };
+
+    dimension shape_of(const std::array<size_t, 6> &e, const int ndims)
+    {
+      switch (ndims) {
+        case 1: return { e[0] };
+        case 2: return { e[0], e[1] };
+        case 3: return { e[0], e[1], e[2] };
+        case 4: return { e[0], e[1], e[2], e[3] };
+        case 5: return { e[0], e[1], e[2], e[3], e[4] };
+        default: return { e[0], e[1], e[2], e[3], e[4], e[5] };
+      }
+    }
+
+    // leading axes of the product, then the rows of a and columns of b unless vectors
+    dimension product_shape(const layout &a, const layout &b)
+    {
+      if (a.is_vector && b.is_vector)
+        throw std::invalid_argument { "the product of two vectors is a scalar, see dot" };
+      if (a.cols != b.rows)
+        throw std::invalid_argument { "inner extents of the operands differ" };
+
+      const int nlead { std::max(a.nlead, b.nlead) };
+      std::array<size_t, 6> extent {};
+      for (int i { -1 }; ++i < nlead;) {
+        const int ia { i - (nlead - a.nlead) }, ib { i - (nlead - b.nlead) };
+        const size_t x { ia < 0 ? 1 : a.lead[ia] }, y { ib < 0 ? 1 : b.lead[ib] };
+        if (x != y && x != 1 && y != 1)
+          throw std::invalid_argument { "leading axes are not broadcast compatible" };
+        extent[i] = x == 1 ? y : x;
+      }
+      int ndims { nlead };
+      if (!a.is_vector) extent[ndims++] = a.rows;
+      if (!b.is_vector) extent[ndims++] = b.cols;
+      return shape_of(extent, ndims);
+    }
+
+    // operands which share memory with the output are read from a copy
+    template<typename _DType>
+    multiarray<_DType> unshared(const multiarray<_DType> &a, const multiarray<_DType> &c)
+    {
+      if (a.size() == 0 || c.size() == 0) return a;
+      const auto [a_first, a_last] { detail::footprint(a) };
+      const auto [c_first, c_last] { detail::footprint(c) };
+      return a_last < c_first || c_last < a_first ? a : a.copy();
+    }
+
+    template<typename _Type>
+    struct matrix {
+      _Type *data;
+      ptrdiff_t rs, cs;
+    };
+
+    // c = beta * c, without reading c when beta is zero
+    template<typename _Type>
+    void scale(const matrix<_Type> &c, const size_t m, const size_t n, const _Type beta)
+    {
+      for (size_t i { 0 }; i < m; ++i) {
+        _Type *row { c.data + ptrdiff_t(i) * c.rs };
+        for (size_t j { 0 }; j < n; ++j)
+          row[ptrdiff_t(j) * c.cs] = beta == _Type(0) ? _Type(0) : beta * row[ptrdiff_t(j) * c.cs];
+      }
+    }
+
+    // loops of a product split across threads, or run inline for products of a stack
+    // which are themselves split
+    template<typename _Func>
+    void run(const bool threaded, const size_t count, const size_t grain, _Func &&func)
+    {
+      if (threaded)
+        detail::parallel_for(count, grain, func);
+      else if (count)
+        func(0, count);
+    }
+
+    ////////////////////////////////////// PRODUCTS //////////////////////////////////////
+
+    // products with a single row or column are inner products along contiguous runs
+    template<typename _Type>
+    void multiply_dots(const gemm_table<_Type> &k, const size_t m, const size_t n,
+      const size_t depth, const _Type alpha, const matrix<const _Type> &a,
+      const matrix<const _Type> &b, const _Type beta, const matrix<_Type> &c,
+      const bool threaded)
+    {
+      const size_t count { m * n };
+      const size_t grain { std::max<size_t>(grain_size() / (depth * 2 * sizeof(_Type) + 1), 1) };
+      run(threaded, count, grain, [&](const size_t begin, const size_t end) {
+        for (size_t t { begin }; t < end; ++t) {
+          const size_t i { n == 1 ? t : 0 }, j { n == 1 ? 0 : t };
+          const _Type sum { k.dot(a.data + ptrdiff_t(i) * a.rs, a.cs,
+            b.data + ptrdiff_t(j) * b.cs, b.rs, depth) };
+          _Type &out { c.data[ptrdiff_t(i) * c.rs + ptrdiff_t(j) * c.cs] };
+          out = beta == _Type(0) ? alpha * sum : alpha * sum + beta * out;
+        }
+      });
+    }
+
+    // blocks of `kc` rows of b are packed into panels of `nr` columns kept in the last
+    // level cache, and blocks of `mc` rows of a into panels of `mr` rows kept in the L2
+    // cache by each task, whose micro kernels run over every pair of panels, so that every
+    // element of c sums its products in the same order however the blocks are split
+    template<typename _Type>
+    void multiply_blocked(const gemm_table<_Type> &k, const size_t m, const size_t n,
+      const size_t depth, const _Type alpha, const matrix<const _Type> &a,
+      const matrix<const _Type> &b, const _Type beta, const matrix<_Type> &c,
+      const bool threaded)
+    {
+      const size_t mr { k.mr }, nr { k.nr };
+      const size_t kc { std::min(k.kc, depth) }, mc { std::min(k.mc, (m + mr - 1) / mr * mr) };
+      const size_t nc { std::min(k.nc, (n + nr - 1) / nr * nr) };
+      const size_t threads { threaded ? default_executor().concurrency() : 1 };
+      scratch<_Type> packed_b { kc * nc };
+
+      for (size_t jc { 0 }; jc < n; jc += nc) {
+        const size_t width { std::min(nc, n - jc) }, panels { (width + nr - 1) / nr };
+        for (size_t pc { 0 }; pc < depth; pc += kc) {
+          const size_t height { std::min(kc, depth - pc) };
+          const _Type *from { b.data + ptrdiff_t(pc) * b.rs + ptrdiff_t(jc) * b.cs };
+          run(threaded, panels, std::max<size_t>(grain_size() / (kc * nr * sizeof(_Type)), 1),
+            [&](const size_t begin, const size_t end) {
+              k.pack_b(from + ptrdiff_t(begin * nr) * b.cs, b.rs, b.cs, height,
+                std::min(end * nr, width) - begin * nr, packed_b.data + begin * nr * height);
+            });
+
+          // blocks of rows, split further into groups of panels of b to keep every
+          // thread busy
+          const size_t blocks { (m + mc - 1) / mc };
+          const size_t groups { threads == 1 ? 1
+                                             : std::clamp<size_t>((4 * threads + blocks - 1) / blocks,
+                                                 1, panels) };
+          const _Type scale_c { pc == 0 ? beta : _Type(1) };
+          run(threaded, blocks * groups, 1, [&](const size_t begin, const size_t end) {
+            scratch<_Type> packed_a { mc * height };
+            for (size_t task { begin }; task < end; ++task) {
+              const size_t ic { task / groups * mc }, group { task % groups };
+              const size_t rows { std::min(mc, m - ic) };
+              if (task == begin || group == 0)
+                k.pack_a(a.data + ptrdiff_t(ic) * a.rs + ptrdiff_t(pc) * a.cs, a.rs, a.cs,
+                  rows, height, packed_a.data);
+              const size_t first { group * panels / groups };
+              const size_t last { (group + 1) * panels / groups };
+              for (size_t jr { first * nr }; jr < last * nr; jr += nr)
+                for (size_t ir { 0 }; ir < rows; ir += mr)
+                  k.kernel(height, packed_a.data + ir * height, packed_b.data + jr * height,
+                    alpha, scale_c,
+                    c.data + ptrdiff_t(ic + ir) * c.rs + ptrdiff_t(jc + jr) * c.cs, c.rs,
+                    c.cs, std::min(mr, rows - ir), std::min(nr, width - jr));
+            }
+          });
+        }
+      }
+    }
+
+    template<typename _Type>
+    void multiply(const gemm_table<_Type> &k, const size_t m, const size_t n,
+      const size_t depth, const _Type alpha, const matrix<const _Type> &a,
+      const matrix<const _Type> &b, const _Type beta, const matrix<_Type> &c,
+      const bool threaded)
+    {
+      if (m == 0 || n == 0) return;
+      if (depth == 0 || alpha == _Type(0)) return scale(c, m, n, beta);
+      if ((m == 1 || n == 1) && a.cs == 1 && b.rs == 1)
+        return multiply_dots(k, m, n, depth, alpha, a, b, beta, c, threaded);
+      multiply_blocked(k, m, n, depth, alpha, a, b, beta, c, threaded);
+    }
+
+  }  // namespace
+
+  namespace detail
+  {
+    dimension matmul_shape(const dimension &a, const dimension &b)
+    {
+      return product_shape(layout { a, stride { a }, false, false },
+        layout { b, stride { b }, true, false });
+    }
+
+    template<typename _DType>
+    void gemm(const multiarray<_DType> &a, const bool transpose_a,
+      const multiarray<_DType> &b, const bool transpose_b,
+      const typename multiarray<_DType>::native_type alpha,
+      const typename multiarray<_DType>::native_type beta, multiarray<_DType> &c)
+    {
+      using native_type = typename multiarray<_DType>::native_type;
+      static_assert(std::is_floating_point_v<native_type>,
+        "matrix products are defined for float32 and float64 arrays");
+
+      if (c.dim() != product_shape(layout { a.dim(), a.strides(), false, transpose_a },
+                       layout { b.dim(), b.strides(), true, transpose_b }))
+        throw std::invalid_argument { "output shape does not match the product" };
+      if (c.size() == 0) return;
+      COVDEL_PROBE(operation::matmul, _DType::s_type, c.size() * sizeof(native_type));
+
+      const multiarray<_DType> x { unshared(a, c) }, y { unshared(b, c) };
+      const layout la { x.dim(), x.strides(), false, transpose_a };
+      const layout lb { y.dim(), y.strides(), true, transpose_b };
+      const size_t m { la.rows }, n { lb.cols }, depth { la.cols };
+
+      // axes of c past its leading ones are the rows and columns of the product
+      int nlead { c.dim().ndims() };
+      ptrdiff_t crs { 0 }, ccs { 0 };
+      if (!lb.is_vector) ccs = c.strides()[--nlead];
+      if (!la.is_vector) crs = c.strides()[--nlead];
+
+      size_t count { 1 };
+      for (int i { -1 }; ++i < nlead;) count *= c.dim()[i];
+      const auto &k { gemm_kernels<native_type>() };
+      const auto product = [&](const size_t t, const bool threaded) {
+        ptrdiff_t oa { 0 }, ob { 0 }, oc { 0 };
+        size_t rest { t };
+        for (int i { nlead }; i-- > 0;) {
+          const size_t at { rest % c.dim()[i] };
+          rest /= c.dim()[i];
+          oc += ptrdiff_t(at) * c.strides()[i];
+          const int ia { i - (nlead - la.nlead) }, ib { i - (nlead - lb.nlead) };
+          if (ia >= 0 && la.lead[ia] != 1) oa += ptrdiff_t(at) * la.lead_step[ia];
+          if (ib >= 0 && lb.lead[ib] != 1) ob += ptrdiff_t(at) * lb.lead_step[ib];
+        }
+        multiply<native_type>(k, m, n, depth, alpha, { x.data() + oa, la.rs, la.cs },
+          { y.data() + ob, lb.rs, lb.cs }, beta, { c.data() + oc, crs, ccs }, threaded);
+      };
+
+      // stacks of small products run one product per task
+      const size_t flops { 2 * m * n * std::max<size_t>(depth, 1) };
+      if (count > 1 && flops < SMALL_PRODUCT)
+        parallel_for(count, std::max<size_t>(SMALL_PRODUCT / flops, 1),
+          [&](const size_t begin, const size_t end) {
+            for (size_t t { begin }; t < end; ++t) product(t, false);
+          });
+      else
+        for (size_t t { 0 }; t < count; ++t) product(t, true);
+    }
+
+    template<typename _DType>
+    typename multiarray<_DType>::native_type dot(
+      const multiarray<_DType> &a, const multiarray<_DType> &b)
+    {
+      using native_type = typename multiarray<_DType>::native_type;
+      static_assert(std::is_floating_point_v<native_type>,
+        "inner products are defined for float32 and float64 arrays");
+
+      if (a.ndims() != 1 || b.ndims() != 1 || a.size() != b.size())
+        throw std::invalid_argument { "inner products take two vectors of the same length" };
+      return gemm_kernels<native_type>().dot(a.data(), a.strides()[0], b.data(),
+        b.strides()[0], a.size());
+    }
+
+    //////// TEMPLATE INSTANTIATIONS /////////
+
+#define LINALG_INSTANTIATIONS(dtype)                                                    \
+ template void gemm(const multiarray<dtype> &a, const bool transpose_a,                \
+   const multiarray<dtype> &b, const bool transpose_b,                                 \
+   const typename multiarray<dtype>::native_type alpha,                                \
+   const typename multiarray<dtype>::native_type beta, multiarray<dtype> &c);          \
+ template typename multiarray<dtype>::native_type dot(                                 \
+   const multiarray<dtype> &a, const multiarray<dtype> &b);
+
+    LINALG_INSTANTIATIONS(dtype::float32)
+    LINALG_INSTANTIATIONS(dtype::float64)
+
+#undef LINALG_INSTANTIATIONS
+
+  }  // namespace detail
+
+}  // namespace covdel::ma
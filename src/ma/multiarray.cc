@@ -1,6 +1,12 @@
 #include "covdel/ma/multiarray.hh"
 
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/instrument.hh"
+#include "parallel.hh"
+
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 
 namespace covdel::ma
 {
@@ -21,34 +27,56 @@ namespace covdel::ma
   ////////////// CONSTRUCTORS //////////////
 
   template<typename _DType>
-  multiarray<_DType>::multiarray(const dimension &dim)
-    : p_data { new native_type[dim.size()] {} }, m_dim { dim }, m_is_base { true }
+  multiarray<_DType>::multiarray(const dimension &dim, allocator &alloc)
+    : multiarray { dim, native_type {}, alloc }
   { }
 
   template<typename _DType>
-  multiarray<_DType>::multiarray(const dimension &dim, const native_type value)
-    : multiarray { dim }
+  multiarray<_DType>::multiarray(
+    const dimension &dim, const native_type value, allocator &alloc)
+    : multiarray { dim, uninitialized, alloc }
   {
     this->fill(value);
   }
 
+  // the deleter keeps the allocator and size the buffer was requested with
+  template<typename _DType>
+  multiarray<_DType>::multiarray(const dimension &dim, uninitialized_t, allocator &alloc)
+    : p_base {}, p_data {}, m_dim { dim }, m_stride { dim }, m_is_base { true }
+  {
+    const size_t bytes { dim.size() * sizeof(native_type) };
+    COVDEL_PROBE(operation::allocate, _DType::s_type, bytes);
+    auto *buffer { static_cast<native_type *>(alloc.allocate(bytes)) };
+    p_base.reset(buffer, [&alloc, bytes](native_type *ptr) {
+      COVDEL_PROBE_RELEASE(bytes);
+      alloc.deallocate(ptr, bytes);
+    });
+    p_data = buffer;
+  }
+
+  template<typename _DType>
+  multiarray<_DType>::multiarray(native_type *data, const dimension &dim,
+    const stride &strides, const std::shared_ptr<void> &owner)
+    : p_base { owner, data }, p_data { data }, m_dim { dim }, m_stride { strides },
+      m_is_base { true }
+  { }
+
   template<typename _DType>
   multiarray<_DType>::multiarray(const multiarray &copy)
-    : p_data { copy.p_data }, m_dim { copy.m_dim }, m_is_base { false }
+    : p_base { copy.p_base }, p_data { copy.p_data }, m_dim { copy.m_dim },
+      m_stride { copy.m_stride }, m_is_base { false }
   { }
 
   template<typename _DType>
   multiarray<_DType>::multiarray(multiarray &&move) noexcept
-    : p_data {}, m_dim { 0 }, m_is_base {}
+    : p_base {}, p_data {}, m_dim { 0 }, m_stride { 0 }, m_is_base {}
   {
     this->swap(move);
   }
 
+  // buffer is released by the last view holding it
   template<typename _DType>
-  multiarray<_DType>::~multiarray() noexcept
-  {
-    if (m_is_base) delete[] p_data;
-  }
+  multiarray<_DType>::~multiarray() noexcept = default;
 
   //////////////// OPERATORS ///////////////
 
@@ -62,8 +90,21 @@ namespace covdel::ma
   template<typename _DType>
   bool multiarray<_DType>::operator==(const multiarray &rhs) const noexcept
   {
-    return m_dim == rhs.m_dim
-        && std::equal(p_data, p_data + m_dim.size(), rhs.p_data, rhs.p_data + rhs.size());
+    if (m_dim != rhs.m_dim) return false;
+    COVDEL_PROBE(operation::compare, _DType::s_type, size() * sizeof(native_type));
+
+    // ranges stop early once any of them found a difference
+    std::atomic<bool> equal { true };
+    detail::parallel_runs(
+      m_dim,
+      [&equal](const native_type *a, const native_type *b, ptrdiff_t sa, ptrdiff_t sb,
+        size_t count) {
+        if (!equal.load(std::memory_order_relaxed)) return;
+        for (size_t i { 0 }; i < count; ++i, a += sa, b += sb)
+          if (*a != *b) return equal.store(false, std::memory_order_relaxed);
+      },
+      detail::operand { p_data, m_stride }, detail::operand { rhs.p_data, rhs.m_stride });
+    return equal;
   }
 
   template<typename _DType>
@@ -82,14 +123,14 @@ namespace covdel::ma
   typename multiarray<_DType>::native_type &multiarray<_DType>::operator[](
     const index &idx)
   {
-    return const_cast<native_type &>(const_cast<const multiarray &>(*this)[idx]);
+    return p_data[idx.offset(m_dim, m_stride)];
   }
 
   template<typename _DType>
   const typename multiarray<_DType>::native_type &multiarray<_DType>::operator[](
     const index &idx) const
   {
-    return p_data[idx.flat(m_dim)];
+    return p_data[idx.offset(m_dim, m_stride)];
   }
 
   // FIXME add explicit instantiations?
@@ -131,6 +172,17 @@ namespace covdel::ma
     return m_is_base;
   }
 
+  template<typename _DType>
+  bool multiarray<_DType>::is_contiguous() const noexcept
+  {
+    ptrdiff_t step { 1 };
+    for (int i { m_dim.ndims() }; i-- > 0;) {
+      if (m_dim[i] != 1 && m_stride[i] != step) return false;
+      step *= static_cast<ptrdiff_t>(m_dim[i]);
+    }
+    return true;
+  }
+
   // TODO finish implementing this after indexing has been added
   template<typename _DType>
   std::string multiarray<_DType>::str() const noexcept
@@ -138,15 +190,39 @@ namespace covdel::ma
     return "<NOT_IMPLEMENTED_YET>";
   }
 
+  ////////////// ELEMENT ACCESS ////////////
+
+  template<typename _DType>
+  typename multiarray<_DType>::native_type &multiarray<_DType>::at(const index &idx)
+  {
+    return p_data[idx.offset(m_dim, m_stride)];
+  }
+
+  template<typename _DType>
+  const typename multiarray<_DType>::native_type &multiarray<_DType>::at(
+    const index &idx) const
+  {
+    return p_data[idx.offset(m_dim, m_stride)];
+  }
+
   ///////////////// GENERAL ////////////////
 
+  // vectorized for the active instruction set and split over the default executor
   template<typename _DType>
   template<typename _AsArray, typename _AsType>
-  _AsArray multiarray<_DType>::astype() const
+  _AsArray multiarray<_DType>::astype(const conversion &conv) const
   {
-    _AsArray out { m_dim };
-    for (size_t i { -1UL }; ++i < m_dim.size();)
-      out.p_data[i] = static_cast<_AsType>(p_data[i]);
+    _AsArray out { m_dim, uninitialized };
+    [[maybe_unused]] constexpr operation op { std::is_same_v<_AsArray, multiarray>
+                                                ? operation::copy
+                                                : operation::convert };
+    COVDEL_PROBE(op, out.type(), out.size() * sizeof(_AsType));
+    const auto kernel { detail::find_convert_kernel<_DType>(out.type()) };
+    detail::parallel_runs(
+      m_dim,
+      [kernel, &conv](const native_type *src, _AsType *dst, ptrdiff_t ss, ptrdiff_t ds,
+        size_t count) { kernel(src, ss, dst, ds, count, conv); },
+      detail::operand { p_data, m_stride }, detail::operand { out.p_data, out.m_stride });
     return out;
   }
 
@@ -156,11 +232,19 @@ namespace covdel::ma
     return astype<multiarray<_DType>>();
   }
 
+  template<typename _DType>
+  multiarray<_DType> multiarray<_DType>::ascontiguous() const
+  {
+    return is_contiguous() ? *this : copy();
+  }
+
   template<typename _DType>
   void multiarray<_DType>::swap(multiarray &other) noexcept
   {
+    p_base.swap(other.p_base);
     std::swap(p_data, other.p_data);
     m_dim.swap(other.m_dim);
+    m_stride.swap(other.m_stride);
     std::swap(m_is_base, other.m_is_base);
   }
 
@@ -171,7 +255,9 @@ namespace covdel::ma
   {
     if (m_dim.size() != new_dim.size())
       throw std::invalid_argument { "array size should be preserved during reshape" };
-    m_dim = new_dim;
+    if (!is_contiguous()) *this = copy();
+    m_dim    = new_dim;
+    m_stride = stride { new_dim };
     return *this;
   }
 
@@ -184,16 +270,106 @@ namespace covdel::ma
   template<typename _DType>
   multiarray<_DType> &multiarray<_DType>::squeeze()
   {
+    int j { 0 };
+    for (int i { -1 }; ++i < m_dim.m_len;)
+      if (m_dim.m_data[i] != 1) m_stride.m_data[j++] = m_stride.m_data[i];
+    m_stride.m_len = j;
     m_dim.squeeze();
     return *this;
   }
 
+  template<typename _DType>
+  multiarray<_DType> &multiarray<_DType>::transpose()
+  {
+    std::reverse(m_dim.m_data.begin(), m_dim.m_data.begin() + m_dim.m_len);
+    std::reverse(m_stride.m_data.begin(), m_stride.m_data.begin() + m_stride.m_len);
+    return *this;
+  }
+
+  template<typename _DType>
+  multiarray<_DType> &multiarray<_DType>::permute(const index &axes)
+  {
+    const int ndims { m_dim.ndims() };
+    if (axes.ndims() != ndims)
+      throw std::invalid_argument { "permutation must list every axis exactly once" };
+
+    auto dim { m_dim };
+    auto strides { m_stride };
+    unsigned seen { 0 };
+    for (int i { -1 }; ++i < ndims;) {
+      const size_t axis { axes[i] };
+      if (axis >= size_t(ndims) || seen & (1U << axis))
+        throw std::invalid_argument { "permutation must list every axis exactly once" };
+      seen |= 1U << axis;
+      dim.m_data[i]     = m_dim.m_data[axis];
+      strides.m_data[i] = m_stride.m_data[axis];
+    }
+    m_dim    = dim;
+    m_stride = strides;
+    return *this;
+  }
+
+  ////////////////// VIEWS /////////////////
+
+  template<typename _DType>
+  multiarray<_DType> multiarray<_DType>::slice(
+    int axis, ptrdiff_t start, ptrdiff_t stop, ptrdiff_t step) const
+  {
+    if (axis < 0 || axis >= m_dim.ndims())
+      throw std::out_of_range { "slice axis out of bounds" };
+    if (step == 0) throw std::invalid_argument { "slice step cannot be zero" };
+
+    // bounds follow [start, stop) for positive steps and (stop, start] for negative ones,
+    // without python's wrap-around of negative positions
+    const auto extent { static_cast<ptrdiff_t>(m_dim[axis]) };
+    const ptrdiff_t span { step > 0 ? stop - start : start - stop };
+    const ptrdiff_t count { span > 0 ? (span - 1) / std::abs(step) + 1 : 0 };
+    if (count
+      && (start < 0 || start >= extent || start + (count - 1) * step < 0
+        || start + (count - 1) * step >= extent))
+      throw std::out_of_range { "slice bounds out of corresponding dimension" };
+
+    multiarray view { *this };
+    if (count) view.p_data += start * m_stride[axis];
+    view.m_dim.m_data[axis] = static_cast<size_t>(count);
+    view.m_stride.m_data[axis] *= step;
+    return view;
+  }
+
+  template<typename _DType>
+  multiarray<_DType> multiarray<_DType>::broadcast_to(const dimension &new_dim) const
+  {
+    const int ndims { new_dim.ndims() }, offset { ndims - m_dim.ndims() };
+    if (offset < 0)
+      throw std::invalid_argument { "cannot broadcast to a lower dimensional shape" };
+
+    multiarray view { *this };
+    view.m_dim    = new_dim;
+    view.m_stride = stride { new_dim };
+    for (int i { -1 }; ++i < ndims;) {
+      if (i < offset || m_dim[i - offset] != new_dim[i]) {
+        if (i >= offset && m_dim[i - offset] != 1)
+          throw std::invalid_argument { "array is not broadcastable to given dimension" };
+        view.m_stride.m_data[i] = 0;
+      } else
+        view.m_stride.m_data[i] = m_stride[i - offset];
+    }
+    return view;
+  }
+
   //////////// ITEM MANIPULATION ///////////
 
   template<typename _DType>
   void multiarray<_DType>::fill(const native_type value)
   {
-    std::fill_n(p_data, m_dim.size(), value);
+    COVDEL_PROBE(operation::fill, _DType::s_type, size() * sizeof(native_type));
+    detail::parallel_runs(
+      m_dim,
+      [value](native_type *dst, ptrdiff_t step, size_t count) {
+        if (step == 1) return void(std::fill_n(dst, count, value));
+        for (size_t i { 0 }; i < count; ++i, dst += step) *dst = value;
+      },
+      detail::operand { p_data, m_stride });
   }
 
   //////// TEMPLATE INSTANTIATIONS /////////
@@ -212,29 +388,22 @@ namespace covdel::ma
   template class multiarray<dtype::float64>;
 
   // multiarray::astype method
-#define ASTYPE_INSTANTIATIONS(from_type)                            \
- template multiarray<dtype::bool8>                                  \
- multiarray<from_type>::astype<multiarray<dtype::bool8>>() const;   \
- template multiarray<dtype::int8>                                   \
- multiarray<from_type>::astype<multiarray<dtype::int8>>() const;    \
- template multiarray<dtype::int16>                                  \
- multiarray<from_type>::astype<multiarray<dtype::int16>>() const;   \
- template multiarray<dtype::int32>                                  \
- multiarray<from_type>::astype<multiarray<dtype::int32>>() const;   \
- template multiarray<dtype::int64>                                  \
- multiarray<from_type>::astype<multiarray<dtype::int64>>() const;   \
- template multiarray<dtype::uint8>                                  \
- multiarray<from_type>::astype<multiarray<dtype::uint8>>() const;   \
- template multiarray<dtype::uint16>                                 \
- multiarray<from_type>::astype<multiarray<dtype::uint16>>() const;  \
- template multiarray<dtype::uint32>                                 \
- multiarray<from_type>::astype<multiarray<dtype::uint32>>() const;  \
- template multiarray<dtype::uint64>                                 \
- multiarray<from_type>::astype<multiarray<dtype::uint64>>() const;  \
- template multiarray<dtype::float32>                                \
- multiarray<from_type>::astype<multiarray<dtype::float32>>() const; \
- template multiarray<dtype::float64>                                \
- multiarray<from_type>::astype<multiarray<dtype::float64>>() const;
+#define ASTYPE_INSTANTIATION(from_type, to_type)                                  \
+ template multiarray<to_type> multiarray<from_type>::astype<multiarray<to_type>>( \
+   const conversion &) const;
+
+#define ASTYPE_INSTANTIATIONS(from_type)         \
+ ASTYPE_INSTANTIATION(from_type, dtype::bool8)   \
+ ASTYPE_INSTANTIATION(from_type, dtype::int8)    \
+ ASTYPE_INSTANTIATION(from_type, dtype::int16)   \
+ ASTYPE_INSTANTIATION(from_type, dtype::int32)   \
+ ASTYPE_INSTANTIATION(from_type, dtype::int64)   \
+ ASTYPE_INSTANTIATION(from_type, dtype::uint8)   \
+ ASTYPE_INSTANTIATION(from_type, dtype::uint16)  \
+ ASTYPE_INSTANTIATION(from_type, dtype::uint32)  \
+ ASTYPE_INSTANTIATION(from_type, dtype::uint64)  \
+ ASTYPE_INSTANTIATION(from_type, dtype::float32) \
+ ASTYPE_INSTANTIATION(from_type, dtype::float64)
 
   ASTYPE_INSTANTIATIONS(dtype::bool8);
   ASTYPE_INSTANTIATIONS(dtype::int8);
@@ -0,0 +1,649 @@
+#include "covdel/ma/npy.hh"
+
+#include "codec.hh"
+#include "files.hh"
+#include "traverse.hh"
+#include "zlib.hh"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    mapped_file::mapped_file(const std::string &path, const mapping map)
+      : addr {}, length {}
+    {
+      const int fd { ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+      if (fd < 0) fail("cannot open " + path);
+      struct stat info { };
+      if (::fstat(fd, &info) != 0) {
+        const int error { errno };
+        ::close(fd);
+        errno = error;
+        fail("cannot stat " + path);
+      }
+      length = size_t(info.st_size);
+      if (length == 0) {
+        ::close(fd);
+        throw std::invalid_argument { path + " is empty" };
+      }
+
+      const int protection { map == mapping::read_only ? PROT_READ
+                                                       : PROT_READ | PROT_WRITE };
+      void *ptr { ::mmap(nullptr, length, protection, MAP_PRIVATE, fd, 0) };
+      const int error { errno };
+      ::close(fd);
+      if (ptr == MAP_FAILED) {
+        errno = error;
+        fail("cannot map " + path);
+      }
+      addr = static_cast<char *>(ptr);
+    }
+
+    mapped_file::~mapped_file() noexcept
+    {
+      ::munmap(addr, length);
+    }
+
+    void fail(const std::string &what)
+    {
+      throw std::system_error { errno, std::generic_category(), what };
+    }
+
+  }  // namespace detail
+
+  namespace
+  {
+    using detail::crc32;
+    using detail::fail;
+    using detail::read_le;
+    using detail::write_le;
+
+    [[noreturn]] void malformed(const std::string &what)
+    {
+      throw std::invalid_argument { "malformed " + what };
+    }
+
+    template<typename _MultiArray>
+    struct array_traits;
+
+    template<typename _DType>
+    struct array_traits<multiarray<_DType>> {
+      using dtype = _DType;
+    };
+
+    constexpr bool BIG_ENDIAN_HOST { __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ };
+
+    // numpy type codes and widths, indexed by datatype
+    constexpr char KINDS[] { 'b', 'i', 'i', 'i', 'i', 'u', 'u', 'u', 'u', 'f', 'f' };
+    constexpr size_t WIDTHS[] { 1, 1, 2, 4, 8, 1, 2, 4, 8, 4, 8 };
+
+    ////////////// NPY HEADERS ///////////////
+
+    constexpr char MAGIC[] { "\x93NUMPY" };
+
+    std::string descr(const datatype type)
+    {
+      const size_t width { WIDTHS[int(type)] };
+      const char order { width == 1 ? '|' : BIG_ENDIAN_HOST ? '>' : '<' };
+      return std::string { order, KINDS[int(type)] } + std::to_string(width);
+    }
+
+    datatype parse_descr(const std::string_view descr, bool &swapped)
+    {
+      if (descr.size() < 3 || std::string_view { "<>|=" }.find(descr[0]) == descr.npos)
+        malformed("datatype descriptor");
+      const std::string_view code { descr.substr(1) };
+      for (int type { -1 }; ++type < 11;)
+        if (code[0] == KINDS[type] && code.substr(1) == std::to_string(WIDTHS[type])) {
+          const bool little { descr[0] == '<' }, big { descr[0] == '>' };
+          swapped = WIDTHS[type] > 1 && (BIG_ENDIAN_HOST ? little : big);
+          return datatype(type);
+        }
+      throw std::invalid_argument { "unsupported datatype " + std::string { descr } };
+    }
+
+    // value following `'key':` in the header dictionary
+    std::string_view value_of(const std::string_view dict, const std::string_view key)
+    {
+      for (const char quote : { '\'', '"' }) {
+        const std::string quoted { quote + std::string { key } + quote };
+        size_t pos { dict.find(quoted) };
+        if (pos == dict.npos) continue;
+        pos = dict.find_first_not_of(" ", pos + quoted.size());
+        if (pos == dict.npos || dict[pos] != ':') break;
+        pos = dict.find_first_not_of(" ", pos + 1);
+        if (pos != dict.npos) return dict.substr(pos);
+        break;
+      }
+      malformed(".npy header, no " + std::string { key });
+    }
+
+    // 0-d arrays are loaded with the shape (1)
+    dimension parse_shape(const std::string_view shape)
+    {
+      if (shape.empty() || shape[0] != '(') malformed(".npy shape");
+      std::array<size_t, 6> extent {};
+      int ndims { 0 };
+      for (size_t pos { 1 };;) {
+        pos = shape.find_first_not_of(" ,", pos);
+        if (pos == shape.npos) malformed(".npy shape");
+        if (shape[pos] == ')') break;
+        if (shape[pos] < '0' || shape[pos] > '9') malformed(".npy shape");
+        if (ndims == 6)
+          throw std::invalid_argument { "arrays of over 6 dimensions are unsupported" };
+        size_t value { 0 };
+        for (; pos < shape.size() && shape[pos] >= '0' && shape[pos] <= '9'; ++pos) {
+          const size_t digit { size_t(shape[pos] - '0') };
+          if (value > (SIZE_MAX - digit) / 10) malformed(".npy shape, extent overflows");
+          value = value * 10 + digit;
+        }
+        extent[ndims++] = value;
+      }
+      if (ndims == 0) extent[ndims++] = 1;
+      return detail::make_shape<dimension>(extent, ndims);
+    }
+
+    struct parsed_header {
+      npy_header header;
+      size_t payload;  // offset from the magic string
+    };
+
+    // numpy writes the dictionary in a fixed order, which is not relied on
+    parsed_header parse_header(const char *bytes, const size_t length)
+    {
+      if (length < 10 || std::memcmp(bytes, MAGIC, 6) != 0) malformed(".npy file");
+      const int major { uint8_t(bytes[6]) };
+      if (major < 1 || major > 3)
+        throw std::invalid_argument { "unsupported version " + std::to_string(major) };
+      const size_t start { major == 1 ? 10U : 12U };
+      if (length < start) malformed(".npy header");
+      const size_t size { read_le(bytes + 8, major == 1 ? 2 : 4) };
+      if (size > length - start) malformed(".npy header");
+      const std::string_view dict { bytes + start, size };
+
+      bool swapped { false };
+      const std::string_view type { value_of(dict, "descr") };
+      const size_t end { type.empty() ? type.npos : type.find(type[0], 1) };
+      if (end == type.npos) malformed(".npy datatype descriptor");
+      const datatype dtype { parse_descr(type.substr(1, end - 1), swapped) };
+
+      const std::string_view order { value_of(dict, "fortran_order") };
+      const bool fortran_order { order.substr(0, 4) == "True" };
+      if (!fortran_order && order.substr(0, 5) != "False") malformed(".npy order");
+
+      // the element and byte counts are checked, extents come from files
+      const dimension dim { parse_shape(value_of(dict, "shape")) };
+      size_t total { WIDTHS[int(dtype)] };
+      for (int i { -1 }; ++i < dim.ndims();) {
+        if (dim[i] != 0 && total > SIZE_MAX / dim[i]) malformed(".npy shape, too large");
+        total *= dim[i];
+      }
+      if (total > length - start - size) malformed(".npy payload, file is truncated");
+      return { { dtype, dim, fortran_order, swapped }, start + size };
+    }
+
+    // padded with spaces so that the payload starts at a multiple of ALIGNMENT
+    std::string make_header(const datatype type, const dimension &dim, const bool fortran)
+    {
+      std::string dict { "{'descr': '" + descr(type) + "', 'fortran_order': " };
+      dict += fortran ? "True" : "False";
+      dict += ", 'shape': (";
+      for (int i { -1 }; ++i < dim.ndims();) dict += std::to_string(dim[i]) + ", ";
+      dict.resize(dict.size() - (dim.ndims() > 1 ? 2 : 1));
+      dict += "), }";
+
+      const bool large { dict.size() + 11 > 0xFFFF };
+      const size_t start { large ? 12U : 10U };
+      const size_t used { start + dict.size() + 1 };
+      const size_t total { (used + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT };
+      std::string header { MAGIC, 6 };
+      header += char(large ? 2 : 1);
+      header += '\0';
+      write_le(header, total - start, large ? 4 : 2);
+      header += dict;
+      header.resize(total - 1, ' ');
+      return header += '\n';
+    }
+
+    /////////////// PAYLOADS /////////////////
+
+    // whether the payload is written straight from the buffer, as column-major when the
+    // array is not laid out in row-major order
+    template<typename _DType>
+    bool is_column_major(const multiarray<_DType> &array)
+    {
+      if (array.is_contiguous()) return false;
+      ptrdiff_t step { 1 };
+      for (int i { -1 }; ++i < array.dim().ndims();) {
+        if (array.dim()[i] != 1 && array.strides()[i] != step) return false;
+        step *= ptrdiff_t(array.dim()[i]);
+      }
+      return true;
+    }
+
+    // calls `sink(bytes, length)` over the payload in bounded pieces, other layouts than
+    // row and column-major are gathered into a staging buffer first
+    template<typename _DType, typename _Sink>
+    void write_payload(const multiarray<_DType> &array, _Sink &&sink)
+    {
+      using native_type = typename multiarray<_DType>::native_type;
+      constexpr size_t PIECE { size_t(1) << 22 };
+      if (array.is_contiguous() || is_column_major(array)) {
+        const char *bytes { reinterpret_cast<const char *>(array.data()) };
+        for (size_t left { array.size() * sizeof(native_type) }; left;) {
+          const size_t length { std::min(left, PIECE) };
+          sink(bytes, length);
+          bytes += length, left -= length;
+        }
+        return;
+      }
+
+      constexpr size_t CAPACITY { PIECE / sizeof(native_type) };
+      const std::unique_ptr<native_type[]> staging { new native_type[CAPACITY] };
+      size_t used { 0 };
+      detail::for_each_run(
+        array.dim(),
+        [&](const native_type *src, ptrdiff_t step, size_t count) {
+          while (count) {
+            const size_t length { std::min(count, CAPACITY - used) };
+            for (size_t i { 0 }; i < length; ++i, src += step) staging[used + i] = *src;
+            count -= length;
+            if ((used += length) == CAPACITY) {
+              sink(reinterpret_cast<const char *>(staging.get()), PIECE);
+              used = 0;
+            }
+          }
+        },
+        detail::operand { array.data(), array.strides() });
+      sink(reinterpret_cast<const char *>(staging.get()), used * sizeof(native_type));
+    }
+
+    // view of a payload within the mapping, copied when it is misaligned or byte swapped,
+    // or when there is no mapping to keep alive
+    template<typename _MultiArray>
+    _MultiArray make_array(
+      const std::shared_ptr<detail::mapped_file> &file, const char *bytes, size_t length)
+    {
+      using native_type = typename _MultiArray::native_type;
+      const auto [header, payload] { parse_header(bytes, length) };
+      if (header.type != array_traits<_MultiArray>::dtype::s_type)
+        throw std::invalid_argument { "array is stored as another datatype" };
+
+      // column-major payloads are row-major arrays of the reversed shape
+      dimension dim { header.dim };
+      if (header.fortran_order) {
+        std::array<size_t, 6> extent {};
+        for (int i { -1 }; ++i < dim.ndims();) extent[i] = dim[dim.ndims() - 1 - i];
+        dim = detail::make_shape<dimension>(extent, dim.ndims());
+      }
+
+      const char *data { bytes + payload };
+      const auto address { reinterpret_cast<uintptr_t>(data) };
+      const bool aligned { address % alignof(native_type) == 0 };
+      if (file && !header.swapped && aligned) {
+        _MultiArray view { reinterpret_cast<native_type *>(const_cast<char *>(data)), dim,
+          stride { dim }, file };
+        if (header.fortran_order) view.transpose();
+        return view;
+      }
+
+      _MultiArray copy { dim, uninitialized };
+      auto *out { reinterpret_cast<char *>(copy.data()) };
+      const size_t size { dim.size() * sizeof(native_type) };
+      std::memcpy(out, data, size);
+      if (header.swapped)
+        for (size_t i { 0 }; i < size; i += sizeof(native_type))
+          std::reverse(out + i, out + i + sizeof(native_type));
+      if (header.fortran_order) copy.transpose();
+      return copy;
+    }
+
+    ////////////// ZIP RECORDS ///////////////
+
+    constexpr uint32_t LOCAL_HEADER { 0x04034B50 }, CENTRAL_HEADER { 0x02014B50 };
+    constexpr uint32_t END_RECORD { 0x06054B50 }, END_RECORD64 { 0x06064B50 },
+      END_LOCATOR64 { 0x07064B50 };
+
+    constexpr uint64_t MAX16 { 0xFFFF }, MAX32 { 0xFFFFFFFF };
+
+    // 1980-01-01 00:00, the earliest dos timestamp, keeps archives reproducible
+    constexpr uint32_t DOS_DATE { 1 << 5 | 1 };
+
+    constexpr int STORED { 0 }, DEFLATED { 8 };
+
+    // .npy data of a deflated member, checked against the size and checksum of its entry
+    std::string inflate(const char *data, const size_t size, const size_t unpacked,
+      const uint32_t crc)
+    {
+      constexpr size_t PIECE { size_t(1) << 16 };
+      detail::inflater in { { { data, size } }, PIECE, true };
+      std::string out(unpacked, '\0');
+      for (size_t done { 0 }; done < unpacked; done += PIECE) {
+        const size_t length { std::min(PIECE, unpacked - done) };
+        std::memcpy(out.data() + done, in.next(length), length);
+      }
+      in.finish();
+      if (crc32(0, out.data(), out.size()) != crc) malformed(".npz member, bad checksum");
+      return out;
+    }
+
+  }  // namespace
+
+  ////////////////////////////////////// NPY FILES ///////////////////////////////////////
+
+  npy_header inspect_npy(const std::string &path)
+  {
+    const detail::mapped_file file { path, mapping::read_only };
+    return parse_header(file.addr, file.length).header;
+  }
+
+  template<typename _MultiArray>
+  _MultiArray load_npy(const std::string &path, const mapping map)
+  {
+    const auto file { std::make_shared<detail::mapped_file>(path, map) };
+    return make_array<_MultiArray>(file, file->addr, file->length);
+  }
+
+  template<typename _DType>
+  void save_npy(const std::string &path, const multiarray<_DType> &array)
+  {
+    std::ofstream out { path, std::ios::binary | std::ios::trunc };
+    if (!out) fail("cannot create " + path);
+    out.exceptions(std::ios::badbit | std::ios::failbit);
+
+    const auto header { make_header(array.type(), array.dim(), is_column_major(array)) };
+    out.write(header.data(), std::streamsize(header.size()));
+    write_payload(array, [&out](const char *bytes, size_t length) {
+      out.write(bytes, std::streamsize(length));
+    });
+    out.close();
+  }
+
+  ///////////////////////////////////// NPZ ARCHIVE //////////////////////////////////////
+
+  npz_archive::npz_archive(const std::string &path, const mapping map)
+    : p_file { std::make_shared<detail::mapped_file>(path, map) }, m_members {}
+  {
+    const char *base { p_file->addr };
+    const size_t length { p_file->length };
+
+    // the end record is only followed by a comment of at most 64KiB
+    if (length < 22) malformed(".npz archive");
+    size_t end { length - 22 };
+    while (read_le(base + end, 4) != END_RECORD)
+      if (end-- == 0 || length - end > 22 + MAX16) malformed(".npz archive");
+
+    size_t count { read_le(base + end + 10, 2) }, offset { read_le(base + end + 16, 4) };
+    if ((count == MAX16 || offset == MAX32) && end >= 20
+      && read_le(base + end - 20, 4) == END_LOCATOR64) {
+      const size_t record { read_le(base + end - 12, 8) };
+      if (record > end - 20 || end - 20 - record < 56
+        || read_le(base + record, 4) != END_RECORD64)
+        malformed(".npz archive, no zip64 end record");
+      count  = read_le(base + record + 32, 8);
+      offset = read_le(base + record + 48, 8);
+    }
+
+    for (size_t pos { offset }; count--;) {
+      if (pos > length || length - pos < 46 || read_le(base + pos, 4) != CENTRAL_HEADER)
+        malformed(".npz central directory");
+      const char *entry { base + pos };
+      const size_t names { read_le(entry + 28, 2) }, extras { read_le(entry + 30, 2) };
+      size_t size { read_le(entry + 20, 4) }, unpacked { read_le(entry + 24, 4) };
+      size_t local { read_le(entry + 42, 4) };
+      const auto crc { uint32_t(read_le(entry + 16, 4)) };
+      const auto method { int(read_le(entry + 10, 2)) };
+      pos += 46 + names + extras + read_le(entry + 32, 2);
+      if (pos > length) malformed(".npz central directory");
+
+      // zip64 fields only follow for the ones which overflowed, in this order
+      for (const char *extra { entry + 46 + names }, *stop { extra + extras };
+           extra + 4 <= stop; extra += 4 + read_le(extra + 2, 2)) {
+        if (read_le(extra, 2) != 1) continue;
+        const char *field { extra + 4 };
+        const size_t span { std::min<size_t>(read_le(extra + 2, 2), stop - field) };
+        if (span < 8 * size_t((unpacked == MAX32) + (size == MAX32) + (local == MAX32)))
+          malformed(".npz zip64 field");
+        if (unpacked == MAX32) unpacked = read_le(field, 8), field += 8;
+        if (size == MAX32) size = read_le(field, 8), field += 8;
+        if (local == MAX32) local = read_le(field, 8);
+      }
+
+      if (local > length || length - local < 30
+        || read_le(base + local, 4) != LOCAL_HEADER)
+        malformed(".npz local header");
+      const size_t data { local + 30 + read_le(base + local + 26, 2)
+                          + read_le(base + local + 28, 2) };
+      if (data > length || size > length - data) malformed(".npz member, truncated");
+
+      std::string name { entry + 46, names };
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".npy") == 0)
+        name.resize(name.size() - 4);
+      m_members.push_back({ std::move(name), data, size, unpacked, crc, method });
+    }
+  }
+
+  std::vector<std::string> npz_archive::names() const
+  {
+    std::vector<std::string> names;
+    for (const auto &m : m_members) names.push_back(m.name);
+    return names;
+  }
+
+  bool npz_archive::contains(const std::string &name) const noexcept
+  {
+    return std::any_of(m_members.begin(), m_members.end(),
+      [&name](const member &m) { return m.name == name; });
+  }
+
+  npy_header npz_archive::header(const std::string &name) const
+  {
+    const member &m { find(name) };
+    if (m.method == DEFLATED) {
+      const auto bytes { inflate(p_file->addr + m.offset, m.size, m.unpacked, m.crc) };
+      return parse_header(bytes.data(), bytes.size()).header;
+    }
+    return parse_header(p_file->addr + m.offset, m.size).header;
+  }
+
+  // deflated members are decompressed into arrays of their own
+  template<typename _MultiArray>
+  _MultiArray npz_archive::get(const std::string &name) const
+  {
+    const member &m { find(name) };
+    if (m.method == DEFLATED) {
+      const auto bytes { inflate(p_file->addr + m.offset, m.size, m.unpacked, m.crc) };
+      return make_array<_MultiArray>(nullptr, bytes.data(), bytes.size());
+    }
+    return make_array<_MultiArray>(p_file, p_file->addr + m.offset, m.size);
+  }
+
+  const npz_archive::member &npz_archive::find(const std::string &name) const
+  {
+    const auto it { std::find_if(m_members.begin(), m_members.end(),
+      [&name](const member &m) { return m.name == name; }) };
+    if (it == m_members.end()) throw std::out_of_range { "no array named " + name };
+    if (it->method != STORED && it->method != DEFLATED)
+      throw std::invalid_argument { "unsupported compression of .npz member " + name };
+    return *it;
+  }
+
+  ///////////////////////////////////// NPZ WRITER ///////////////////////////////////////
+
+  npz_writer::npz_writer(const std::string &path)
+    : m_out { path, std::ios::binary | std::ios::trunc }, m_entries {}
+  {
+    if (!m_out) fail("cannot create " + path);
+    m_out.exceptions(std::ios::badbit | std::ios::failbit);
+  }
+
+  npz_writer::~npz_writer() noexcept
+  {
+    try {
+      close();
+    } catch (...) { }
+  }
+
+  // sizes are known upfront, only the checksum is patched once the payload is written
+  template<typename _DType>
+  void npz_writer::add(const std::string &name, const multiarray<_DType> &array)
+  {
+    if (!m_out.is_open()) throw std::logic_error { "archive is already closed" };
+
+    const auto header { make_header(array.type(), array.dim(), is_column_major(array)) };
+    const std::string file { name + ".npy" };
+    const size_t size { header.size() + array.size() * sizeof(typename _DType::type) };
+    const size_t offset { size_t(m_out.tellp()) };
+    const bool large { size >= MAX32 };
+
+    std::string local;
+    write_le(local, LOCAL_HEADER, 4);
+    write_le(local, large ? 45 : 20, 2);  // version needed to extract
+    write_le(local, 0, 2);                // flags
+    write_le(local, 0, 2);                // stored
+    write_le(local, 0, 2);                // time
+    write_le(local, DOS_DATE, 2);
+    write_le(local, 0, 4);  // checksum
+    write_le(local, large ? MAX32 : size, 4);
+    write_le(local, large ? MAX32 : size, 4);
+    write_le(local, file.size(), 2);
+
+    std::string extra;
+    if (large) {
+      write_le(extra, 1, 2);
+      write_le(extra, 16, 2);
+      write_le(extra, size, 8);
+      write_le(extra, size, 8);
+    }
+
+    // padding field, as written by zipalign, puts the payload on an aligned offset
+    const size_t used { offset + local.size() + 2 + file.size() + extra.size() + 6 };
+    const size_t padding { (ALIGNMENT - used % ALIGNMENT) % ALIGNMENT };
+    write_le(extra, 0xD935, 2);
+    write_le(extra, 2 + padding, 2);
+    write_le(extra, ALIGNMENT, 2);
+    extra.append(padding, '\0');
+
+    write_le(local, extra.size(), 2);
+    local += file + extra + header;
+    m_out.write(local.data(), std::streamsize(local.size()));
+
+    uint32_t crc { crc32(0, header.data(), header.size()) };
+    write_payload(array, [this, &crc](const char *bytes, size_t length) {
+      crc = crc32(crc, bytes, length);
+      m_out.write(bytes, std::streamsize(length));
+    });
+
+    std::string field;
+    write_le(field, crc, 4);
+    m_out.seekp(std::streamoff(offset + 14));
+    m_out.write(field.data(), 4);
+    m_out.seekp(0, std::ios::end);
+    m_entries.push_back({ file, offset, size, crc });
+  }
+
+  void npz_writer::close()
+  {
+    if (!m_out.is_open()) return;
+
+    const size_t start { size_t(m_out.tellp()) };
+    std::string directory;
+    for (const auto &e : m_entries) {
+      const bool large { e.size >= MAX32 }, far { e.offset >= MAX32 };
+      std::string extra;
+      if (large || far) {
+        write_le(extra, 1, 2);
+        write_le(extra, (large ? 16 : 0) + (far ? 8 : 0), 2);
+        if (large) write_le(extra, e.size, 8), write_le(extra, e.size, 8);
+        if (far) write_le(extra, e.offset, 8);
+      }
+
+      write_le(directory, CENTRAL_HEADER, 4);
+      write_le(directory, 45, 2);                        // version made by
+      write_le(directory, large || far ? 45 : 20, 2);  // version needed to extract
+      write_le(directory, 0, 2);                         // flags
+      write_le(directory, 0, 2);                         // stored
+      write_le(directory, 0, 2);                         // time
+      write_le(directory, DOS_DATE, 2);
+      write_le(directory, e.crc, 4);
+      write_le(directory, large ? MAX32 : e.size, 4);
+      write_le(directory, large ? MAX32 : e.size, 4);
+      write_le(directory, e.name.size(), 2);
+      write_le(directory, extra.size(), 2);
+      write_le(directory, 0, 2);  // comment length
+      write_le(directory, 0, 2);  // disk
+      write_le(directory, 0, 2);  // internal attributes
+      write_le(directory, 0, 4);  // external attributes
+      write_le(directory, far ? MAX32 : e.offset, 4);
+      directory += e.name + extra;
+    }
+
+    const size_t count { m_entries.size() }, size { directory.size() };
+    if (count >= MAX16 || start >= MAX32 || size >= MAX32) {
+      write_le(directory, END_RECORD64, 4);
+      write_le(directory, 44, 8);  // size of the remaining record
+      write_le(directory, 45, 2);
+      write_le(directory, 45, 2);
+      write_le(directory, 0, 4);
+      write_le(directory, 0, 4);
+      write_le(directory, count, 8);
+      write_le(directory, count, 8);
+      write_le(directory, size, 8);
+      write_le(directory, start, 8);
+      write_le(directory, END_LOCATOR64, 4);
+      write_le(directory, 0, 4);
+      write_le(directory, start + size, 8);
+      write_le(directory, 1, 4);  // disks
+    }
+    write_le(directory, END_RECORD, 4);
+    write_le(directory, 0, 2);
+    write_le(directory, 0, 2);
+    write_le(directory, std::min(count, MAX16), 2);
+    write_le(directory, std::min(count, MAX16), 2);
+    write_le(directory, std::min(size, MAX32), 4);
+    write_le(directory, std::min(start, MAX32), 4);
+    write_le(directory, 0, 2);  // comment length
+
+    m_out.write(directory.data(), std::streamsize(directory.size()));
+    m_out.close();
+  }
+
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+#define NPY_INSTANTIATIONS(type)                                                        \
+ template multiarray<type> load_npy<multiarray<type>>(                                   \
+   const std::string &, const mapping);                                                  \
+ template void save_npy<type>(const std::string &, const multiarray<type> &);            \
+ template multiarray<type> npz_archive::get<multiarray<type>>(const std::string &)       \
+   const;                                                                                \
+ template void npz_writer::add<type>(const std::string &, const multiarray<type> &);
+
+  NPY_INSTANTIATIONS(dtype::bool8);
+  NPY_INSTANTIATIONS(dtype::int8);
+  NPY_INSTANTIATIONS(dtype::int16);
+  NPY_INSTANTIATIONS(dtype::int32);
+  NPY_INSTANTIATIONS(dtype::int64);
+  NPY_INSTANTIATIONS(dtype::uint8);
+  NPY_INSTANTIATIONS(dtype::uint16);
+  NPY_INSTANTIATIONS(dtype::uint32);
+  NPY_INSTANTIATIONS(dtype::uint64);
+  NPY_INSTANTIATIONS(dtype::float32);
+  NPY_INSTANTIATIONS(dtype::float64);
+
+}  // namespace covdel::ma
@@ -0,0 +1,33 @@
+#ifndef __COVDEL_SRC_MA_PARALLEL_HH_1700612003__
+#define __COVDEL_SRC_MA_PARALLEL_HH_1700612003__
+
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/nditer.hh"
+#include "traverse.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+namespace covdel::ma::detail
+{
+  // calls `func(begin, end)` over consecutive ranges covering [0, count), each at least
+  // `grain` long, on the default executor and returning once all are done, ranges only
+  // split the work so results must never depend on them
+  void parallel_for(std::size_t count, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)> &func);
+
+  // runs over the common shape of all operands in memory order, see nditer, over ranges of
+  // about grain_size() bytes of all operands, small shapes run inline, so `func` must be
+  // safe to call concurrently on disjoint runs and must not depend on their order
+  template<typename _Func, typename... _Types>
+  void parallel_runs(const dimension &dim, _Func &&func, operand<_Types>... ops)
+  {
+    const size_t grain { std::max<size_t>(grain_size() / (sizeof(_Types) + ...), 1) };
+    const nditer<_Types...> iter { dim, { ops.strides... }, ops.data... };
+    iter.parallel_for_each(grain, func);
+  }
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __COVDEL_SRC_MA_QGEMM_KERNELS_HH_1702475310__
+#define __COVDEL_SRC_MA_QGEMM_KERNELS_HH_1702475310__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace covdel::ma::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // packing and register blocked kernels of quantized products, over uint8 values of a
+  // and int8 values of b, operands of the other signedness being flipped into them by
+  // their sign bit. Panels hold `mr` rows of a or `nr` columns of b, each along the whole
+  // depth padded with zeros to a multiple of `align`, as elements of `bytes` each.
+  struct qgemm_table {
+    size_t mr, nr, align, bytes;
+
+    // a[i * rs + p * cs] ^ flip of an `m` x `k` block into panels of `mr` rows, rows past
+    // `m` being zeros, and the sum of each row of the block into `sums`
+    void (*pack_a)(const std::uint8_t *a, ptrdiff_t rs, ptrdiff_t cs, size_t m, size_t k,
+      std::uint8_t flip, void *panels, std::int32_t *sums);
+    // b[p * rs + j * cs] ^ flip of a `k` x `n` block into panels of `nr` columns, columns
+    // past `n` being zeros, and the sum of each column of the block into `sums`
+    void (*pack_b)(const std::uint8_t *b, ptrdiff_t rs, ptrdiff_t cs, size_t k, size_t n,
+      std::uint8_t flip, void *panels, std::int32_t *sums);
+
+    // int32 sums of an `m` x `n` corner of the tile of a pair of panels of padded depth
+    // `k`, into rows of `ld` elements
+    void (*kernel)(size_t k, const void *a, const void *b, std::int32_t *sums, size_t ld,
+      size_t m, size_t n);
+
+    // a row of `n` sums into sums[j] + col[j] - row * zero[j], the sums of the products of
+    // the operands less their zero points, wrapping around in 32 bits
+    void (*finish)(const std::int32_t *sums, const std::int32_t *col,
+      const std::int32_t *zero, std::int32_t row, size_t n, std::int32_t *out, ptrdiff_t cs);
+    // the same products scaled by `scale[j]`, rounded to nearest even, shifted by the
+    // `zero_point` of the output and clamped to [lo, hi], stored as bytes
+    void (*requantize)(const std::int32_t *sums, const std::int32_t *col,
+      const std::int32_t *zero, std::int32_t row, const float *scale, std::int32_t zero_point,
+      std::int32_t lo, std::int32_t hi, size_t n, std::uint8_t *out, ptrdiff_t cs);
+  };
+
+  // registration entry points, one per instruction set translation unit, vnni kernels
+  // being a variant of the avx512 level for cpus with byte dot products
+  namespace scalar { void fill(qgemm_table &table) noexcept; }
+  namespace sse2 { void fill(qgemm_table &table) noexcept; }
+  namespace avx2 { void fill(qgemm_table &table) noexcept; }
+  namespace avx512 { void fill(qgemm_table &table) noexcept; }
+  namespace avx512vnni { void fill(qgemm_table &table) noexcept; }
+
+  // kernels of the currently active instruction set level
+  const qgemm_table &qgemm_kernels() noexcept;
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,193 @@
+// Packing and micro kernels of quantized products, compiled once per instruction set
+// level as the float ones, see gemm_kernels.inl. Each element of the tile of a micro
+// kernel is a sum along the depth, which the loop below spells out as plain reductions of
+// integer products for the vectorizer to turn into multiply-adds of pairs of 16 bit
+// values, or into dot products of groups of four bytes with vnni. Products are exact, so
+// every level gives identical results.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "qgemm_kernels.hh"
+
+namespace covdel::ma::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+#if defined(__AVX512F__)
+    static constexpr size_t REGISTER_BYTES { 64 }, REGISTERS { 32 };
+#elif defined(__AVX__)
+    static constexpr size_t REGISTER_BYTES { 32 }, REGISTERS { 16 };
+#else
+    static constexpr size_t REGISTER_BYTES { 16 }, REGISTERS { 16 };
+#endif
+
+#if defined(__AVX512VNNI__)
+    // bytes are multiplied and added in groups of four
+    using a_type = std::uint8_t;
+    using b_type = std::int8_t;
+    static constexpr size_t MR { 4 }, NR { 6 };
+#else
+    // bytes are widened, multiplied and added in pairs
+    using a_type = std::int16_t;
+    using b_type = std::int16_t;
+    static constexpr size_t MR { REGISTERS == 32 ? 6 : 4 }, NR { 4 };
+#endif
+
+    // panels are padded to whole registers, so that the reductions need no remainder
+    static constexpr size_t ALIGN { REGISTER_BYTES / sizeof(a_type) };
+
+    constexpr size_t padded(const size_t k) noexcept
+    {
+      return (k + ALIGN - 1) / ALIGN * ALIGN;
+    }
+
+    ////////////////////////////////////// PACKING ///////////////////////////////////////
+
+    void pack_a(const std::uint8_t *a, const ptrdiff_t rs, const ptrdiff_t cs,
+      const size_t m, const size_t k, const std::uint8_t flip, void *out,
+      std::int32_t *sums)
+    {
+      const size_t depth { padded(k) };
+      a_type *panels { static_cast<a_type *>(out) };
+      for (size_t first { 0 }; first < m; first += MR, panels += MR * depth)
+        for (size_t i { 0 }; i < MR; ++i) {
+          a_type *row { panels + i * depth };
+          size_t p { 0 };
+          if (first + i < m) {
+            const std::uint8_t *from { a + ptrdiff_t(first + i) * rs };
+            std::int32_t sum { 0 };
+            for (; p < k; ++p) {
+              const std::uint8_t x { std::uint8_t(from[ptrdiff_t(p) * cs] ^ flip) };
+              row[p] = a_type(x);
+              sum += x;
+            }
+            sums[first + i] = sum;
+          }
+          for (; p < depth; ++p) row[p] = 0;
+        }
+    }
+
+    void pack_b(const std::uint8_t *b, const ptrdiff_t rs, const ptrdiff_t cs,
+      const size_t k, const size_t n, const std::uint8_t flip, void *out,
+      std::int32_t *sums)
+    {
+      const size_t depth { padded(k) };
+      b_type *panels { static_cast<b_type *>(out) };
+      for (size_t first { 0 }; first < n; first += NR, panels += NR * depth) {
+        const size_t columns { n - first < NR ? n - first : NR };
+        const std::uint8_t *from { b + ptrdiff_t(first) * cs };
+        // reading along the tighter of the two strides
+        if ((cs < 0 ? -cs : cs) < (rs < 0 ? -rs : rs)) {
+          std::int32_t sum[NR] {};
+          for (size_t p { 0 }; p < k; ++p)
+            for (size_t j { 0 }; j < columns; ++j) {
+              const std::uint8_t bits { from[ptrdiff_t(p) * rs + ptrdiff_t(j) * cs] };
+              const std::int8_t x { std::int8_t(bits ^ flip) };
+              panels[j * depth + p] = b_type(x);
+              sum[j] += x;
+            }
+          for (size_t j { 0 }; j < columns; ++j) sums[first + j] = sum[j];
+        } else
+          for (size_t j { 0 }; j < columns; ++j) {
+            std::int32_t sum { 0 };
+            for (size_t p { 0 }; p < k; ++p) {
+              const std::uint8_t bits { from[ptrdiff_t(p) * rs + ptrdiff_t(j) * cs] };
+              const std::int8_t x { std::int8_t(bits ^ flip) };
+              panels[j * depth + p] = b_type(x);
+              sum += x;
+            }
+            sums[first + j] = sum;
+          }
+        for (size_t j { 0 }; j < NR; ++j)
+          for (size_t p { j < columns ? k : 0 }; p < depth; ++p)
+            panels[j * depth + p] = 0;
+      }
+    }
+
+    ////////////////////////////////////// KERNELS ///////////////////////////////////////
+
+    // every accumulator of the tile is a reduction along the depth of a row of a and a
+    // column of b, all of them kept in registers across the loop
+    inline void multiply(const size_t k, const a_type *__restrict a,
+      const b_type *__restrict b, std::int32_t (&acc)[MR][NR])
+    {
+      for (size_t p { 0 }; p < k; ++p)
+#pragma GCC unroll 8
+        for (size_t i { 0 }; i < MR; ++i)
+#pragma GCC unroll 8
+          for (size_t j { 0 }; j < NR; ++j)
+            acc[i][j] += std::int32_t(a[i * k + p]) * std::int32_t(b[j * k + p]);
+    }
+
+    void kernel(const size_t k, const void *a, const void *b, std::int32_t *sums,
+      const size_t ld, const size_t m, const size_t n)
+    {
+      std::int32_t acc[MR][NR] {};
+      multiply(k, static_cast<const a_type *>(a), static_cast<const b_type *>(b), acc);
+      for (size_t i { 0 }; i < m; ++i)
+        for (size_t j { 0 }; j < n; ++j) sums[i * ld + j] = acc[i][j];
+    }
+
+    // corrections for the zero points wrap around, as only their total must fit
+    inline std::int32_t corrected(const std::int32_t sum, const std::int32_t col,
+      const std::int32_t zero, const std::uint32_t row) noexcept
+    {
+      return std::int32_t(
+        std::uint32_t(sum) + std::uint32_t(col) - row * std::uint32_t(zero));
+    }
+
+    void finish(const std::int32_t *sums, const std::int32_t *col,
+      const std::int32_t *zero, const std::int32_t row, const size_t n, std::int32_t *out,
+      const ptrdiff_t cs)
+    {
+      const std::uint32_t r { std::uint32_t(row) };
+      if (cs == 1)
+        for (size_t j { 0 }; j < n; ++j) out[j] = corrected(sums[j], col[j], zero[j], r);
+      else
+        for (size_t j { 0 }; j < n; ++j)
+          out[ptrdiff_t(j) * cs] = corrected(sums[j], col[j], zero[j], r);
+    }
+
+    // adding and subtracting 1.5 * 2^23 rounds to nearest even every value within the
+    // clamped range of a byte
+    static constexpr float ROUNDING { 12582912.f };
+
+    void requantize(const std::int32_t *sums, const std::int32_t *col,
+      const std::int32_t *zero, const std::int32_t row, const float *scale,
+      const std::int32_t zero_point, const std::int32_t lo, const std::int32_t hi,
+      const size_t n, std::uint8_t *out, const ptrdiff_t cs)
+    {
+      const std::uint32_t r { std::uint32_t(row) };
+      const float low { float(lo - zero_point) }, high { float(hi - zero_point) };
+      const auto apply = [&](const size_t j) {
+        float v { float(corrected(sums[j], col[j], zero[j], r)) * scale[j] };
+        v = v < low ? low : v;
+        v = v > high ? high : v;
+        v = (v + ROUNDING) - ROUNDING;
+        return std::uint8_t(std::int32_t(v) + zero_point);
+      };
+      if (cs == 1)
+        for (size_t j { 0 }; j < n; ++j) out[j] = apply(j);
+      else
+        for (size_t j { 0 }; j < n; ++j) out[ptrdiff_t(j) * cs] = apply(j);
+    }
+
+  }  // namespace
+
+  void fill(qgemm_table &table) noexcept
+  {
+    table.mr    = MR;
+    table.nr    = NR;
+    table.align = ALIGN;
+    table.bytes = sizeof(a_type);
+
+    table.pack_a     = pack_a;
+    table.pack_b     = pack_b;
+    table.kernel     = kernel;
+    table.finish     = finish;
+    table.requantize = requantize;
+  }
+
+}  // namespace covdel::ma::detail::COVDEL_KERNEL_ISA
@@ -0,0 +1,2 @@
+#define COVDEL_KERNEL_ISA avx512vnni
+#include "qgemm_kernels.inl"
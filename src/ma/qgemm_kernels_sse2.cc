@@ -0,0 +1,2 @@
+#define COVDEL_KERNEL_ISA sse2
+#include "qgemm_kernels.inl"
@@ -0,0 +1,408 @@
+#include "covdel/ma/quantize.hh"
+
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/reduction.hh"
+#include "covdel/ma/simd.hh"
+#include "parallel.hh"
+#include "qgemm_kernels.hh"
+#include "scratch.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace covdel::ma
+{
+  namespace detail
+  {
+    const qgemm_table &qgemm_kernels() noexcept
+    {
+      static const auto s_levels { [] {
+        std::array<qgemm_table, 5> levels {};
+        scalar::fill(levels[int(isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+        sse2::fill(levels[int(isa::sse2)]);
+        avx2::fill(levels[int(isa::avx2)]);
+        avx512::fill(levels[int(isa::avx512)]);
+        avx512vnni::fill(levels[4]);
+#endif
+        return levels;
+      }() };
+#ifdef COVDEL_X86_KERNELS
+      static const bool s_vnni { __builtin_cpu_supports("avx512vnni") != 0 };
+#else
+      static const bool s_vnni { false };
+#endif
+      const isa level { active_isa() };
+      return s_levels[level == isa::avx512 && s_vnni ? 4 : int(level)];
+    }
+
+  }  // namespace detail
+
+  namespace
+  {
+    using detail::qgemm_table;
+    using detail::scratch;
+
+    // depth over which the sums of products of bytes less their zero points may overflow
+    static constexpr size_t MAX_DEPTH { 1UL << 15 };
+
+    // bytes of the panels of b shared by all tasks, kept in the L2 cache while the panels
+    // of a go through the L1 cache
+    static constexpr size_t PANEL_BYTES { 1UL << 18 };
+
+    template<typename _DType>
+    static constexpr bool is_int8_v { std::is_same_v<_DType, dtype::int8> };
+
+    // integers of each quantized datatype
+    std::pair<std::int32_t, std::int32_t> limits(const datatype type)
+    {
+      if (type == datatype::int8) return { -128, 127 };
+      if (type == datatype::uint8) return { 0, 255 };
+      throw std::invalid_argument { "quantized arrays hold int8 or uint8 values" };
+    }
+
+    // number of scales and zero points of an array of the given shape
+    size_t channels(const quantization &params, const dimension &dim)
+    {
+      if (params.axis < -1 || params.axis >= dim.ndims())
+        throw std::invalid_argument { "quantization axis is out of range" };
+      const size_t count { params.axis < 0 ? 1 : dim[params.axis] };
+      if (params.scales.size() != count || params.zero_points.size() != count)
+        throw std::invalid_argument { "quantization parameters do not match the array" };
+      return count;
+    }
+
+    // the parameters of one channel whose real values range over [lo, hi]
+    void fit(const float lo, const float hi, const datatype type, const bool symmetric,
+      float &scale, std::int32_t &zero_point)
+    {
+      const auto [qmin, qmax] { limits(type) };
+      if (symmetric) {
+        scale      = std::max(std::abs(lo), std::abs(hi)) / 127;
+        zero_point = type == datatype::int8 ? 0 : 128;
+      } else {
+        const float low { std::min(lo, 0.f) }, high { std::max(hi, 0.f) };
+        scale      = (high - low) / float(qmax - qmin);
+        zero_point = std::int32_t(std::clamp(std::nearbyint(float(qmin) - low / scale),
+          float(qmin), float(qmax)));
+      }
+      if (!(scale > 0) || !std::isfinite(scale))
+        scale = 1, zero_point = symmetric ? zero_point : 0;
+    }
+
+    // converts every element of `x` into the same view of `out`
+    template<typename _From, typename _To>
+    void convert(const multiarray<_From> &x, multiarray<_To> &out, const conversion &conv)
+    {
+      using from_type = typename multiarray<_From>::native_type;
+      using to_type   = typename multiarray<_To>::native_type;
+      const auto kernel { detail::find_convert_kernel<_From>(_To::s_type) };
+      detail::parallel_runs(
+        x.dim(),
+        [kernel, &conv](const from_type *src, to_type *dst, ptrdiff_t ss, ptrdiff_t ds,
+          size_t count) { kernel(src, ss, dst, ds, count, conv); },
+        detail::operand { x.data(), x.strides() },
+        detail::operand { out.data(), out.strides() });
+    }
+
+    // a quantized operand as the bytes of its matrix op(x)
+    struct matrix {
+      const std::uint8_t *data;
+      ptrdiff_t rs, cs;
+      size_t rows, cols;
+    };
+
+    template<typename _DType>
+    matrix matrix_of(const multiarray<_DType> &x, const bool transposed)
+    {
+      if (x.ndims() != 2)
+        throw std::invalid_argument { "quantized products take matrices" };
+      matrix out { reinterpret_cast<const std::uint8_t *>(x.data()), x.strides()[0],
+        x.strides()[1], x.dim()[0], x.dim()[1] };
+      if (transposed) std::swap(out.rs, out.cs), std::swap(out.rows, out.cols);
+      return out;
+    }
+
+    // destination of the sums of the products, int32 or requantized to bytes when `scale`
+    // is given
+    struct target {
+      void *data;
+      ptrdiff_t rs, cs;
+      const float *scale;
+      std::int32_t zero_point, lo, hi;
+    };
+
+    // products of a, whose bytes are flipped by `flip_a` into uint8 values of zero point
+    // `zero_a`, and b, flipped into int8 values of zero points `zero_b` for each column,
+    // blocks of columns of b being packed into panels shared by all tasks, and blocks of
+    // rows of a into panels of each task, whose sums are finished one row at a time
+    void multiply(const qgemm_table &k, const matrix &a, const std::uint8_t flip_a,
+      const std::int32_t zero_a, const matrix &b, const std::uint8_t flip_b,
+      const std::int32_t *zero_b, const std::int32_t *bias, const target &c)
+    {
+      const size_t m { a.rows }, n { b.cols }, depth { a.cols };
+      if (m == 0 || n == 0) return;
+
+      const size_t mr { k.mr }, nr { k.nr };
+      const size_t padded { (depth + k.align - 1) / k.align * k.align };
+      const size_t panel { std::max<size_t>(padded * k.bytes, 1) };
+      const size_t nc { std::min(std::max<size_t>(PANEL_BYTES / (nr * panel), 1) * nr,
+        (n + nr - 1) / nr * nr) };
+      const size_t mc { std::min(mr * 16, (m + mr - 1) / mr * mr) };
+      const size_t threads { default_executor().concurrency() };
+
+      scratch<std::uint8_t> packed_b { nc * panel };
+      scratch<std::int32_t> col_sums { nc }, col { nc };
+      for (size_t jc { 0 }; jc < n; jc += nc) {
+        const size_t width { std::min(nc, n - jc) }, panels { (width + nr - 1) / nr };
+        detail::parallel_for(panels, std::max<size_t>(grain_size() / (nr * panel), 1),
+          [&](const size_t begin, const size_t end) {
+            k.pack_b(b.data + ptrdiff_t(jc + begin * nr) * b.cs, b.rs, b.cs, depth,
+              std::min(end * nr, width) - begin * nr, flip_b,
+              packed_b.data + begin * nr * panel, col_sums.data + begin * nr);
+          });
+
+        // terms of the zero points and bias of each column, wrapping around
+        for (size_t j { 0 }; j < width; ++j)
+          col.data[j] = std::int32_t(std::uint32_t(bias ? bias[jc + j] : 0)
+            + std::uint32_t(depth) * std::uint32_t(zero_a) * std::uint32_t(zero_b[jc + j])
+            - std::uint32_t(zero_a) * std::uint32_t(col_sums.data[j]));
+
+        // blocks of rows, split further into groups of panels of b to keep every thread
+        // busy
+        const size_t blocks { (m + mc - 1) / mc };
+        const size_t groups { threads == 1
+            ? 1
+            : std::clamp<size_t>((4 * threads + blocks - 1) / blocks, 1, panels) };
+        const auto work { [&](const size_t begin, const size_t end) {
+          scratch<std::uint8_t> packed_a { mc * panel };
+          scratch<std::int32_t> row_sums { mc }, sums { mr * nc };
+          for (size_t task { begin }; task < end; ++task) {
+            const size_t ic { task / groups * mc }, group { task % groups };
+            const size_t rows { std::min(mc, m - ic) };
+            if (task == begin || group == 0)
+              k.pack_a(a.data + ptrdiff_t(ic) * a.rs, a.rs, a.cs, rows, depth, flip_a,
+                packed_a.data, row_sums.data);
+            const size_t first { group * panels / groups * nr };
+            const size_t last { std::min((group + 1) * panels / groups * nr, width) };
+            const size_t ld { last - first };
+            for (size_t ir { 0 }; ir < rows; ir += mr) {
+              const size_t tile { std::min(mr, rows - ir) };
+              for (size_t jr { first }; jr < last; jr += nr)
+                k.kernel(padded, packed_a.data + ir * panel, packed_b.data + jr * panel,
+                  sums.data + (jr - first), ld, tile, std::min(nr, width - jr));
+              for (size_t i { 0 }; i < tile; ++i) {
+                const ptrdiff_t at { ptrdiff_t(ic + ir + i) * c.rs
+                                     + ptrdiff_t(jc + first) * c.cs };
+                if (c.scale)
+                  k.requantize(sums.data + i * ld, col.data + first, zero_b + jc + first,
+                    row_sums.data[ir + i], c.scale + jc + first, c.zero_point, c.lo, c.hi,
+                    ld, static_cast<std::uint8_t *>(c.data) + at, c.cs);
+                else
+                  k.finish(sums.data + i * ld, col.data + first, zero_b + jc + first,
+                    row_sums.data[ir + i], ld, static_cast<std::int32_t *>(c.data) + at,
+                    c.cs);
+              }
+            }
+          }
+        } };
+        detail::parallel_for(blocks * groups, 1, work);
+      }
+    }
+
+    // checks the operands, and runs their product into `c` with zero points and scales of
+    // the normalized operands
+    template<typename _ADType, typename _BDType, typename _CDType>
+    void product(const quantized<_ADType> &a, const quantized<_BDType> &b,
+      multiarray<_CDType> &c, const bool transpose_a, const bool transpose_b,
+      const std::vector<std::int32_t> &bias, target out)
+    {
+      const matrix x { matrix_of(a.values, transpose_a) };
+      const matrix y { matrix_of(b.values, transpose_b) };
+      if (x.cols != y.rows)
+        throw std::invalid_argument { "inner extents of the operands differ" };
+      if (c.ndims() != 2 || c.dim()[0] != x.rows || c.dim()[1] != y.cols)
+        throw std::invalid_argument { "output shape does not match the product" };
+      if (x.cols > MAX_DEPTH)
+        throw std::invalid_argument {
+          "quantized products are limited to a depth of 32768"
+        };
+      if (channels(a.params, a.values.dim()) != 1)
+        throw std::invalid_argument {
+          "left operands of quantized products are quantized as a whole"
+        };
+      const size_t nb { channels(b.params, b.values.dim()) };
+      if (nb != 1 && b.params.axis != (transpose_b ? 0 : 1))
+        throw std::invalid_argument {
+          "right operands are quantized along their columns"
+        };
+      if (!bias.empty() && bias.size() != y.cols)
+        throw std::invalid_argument { "a bias needs a value for every column" };
+
+      // int8 values of a are shifted up and uint8 values of b down by 128, as are their
+      // zero points
+      const auto flip_a { std::uint8_t(is_int8_v<_ADType> ? 0x80 : 0) };
+      const auto flip_b { std::uint8_t(is_int8_v<_BDType> ? 0 : 0x80) };
+      const std::int32_t zero_a { a.params.zero_points[0] + (flip_a ? 128 : 0) };
+      std::vector<std::int32_t> zero_b(y.cols);
+      for (size_t j { 0 }; j < y.cols; ++j)
+        zero_b[j] = b.params.zero_points[nb == 1 ? 0 : j] - (flip_b ? 128 : 0);
+
+      out.data = c.data();
+      out.rs = c.strides()[0], out.cs = c.strides()[1];
+      multiply(detail::qgemm_kernels(), x, flip_a, zero_a, y, flip_b, zero_b.data(),
+        bias.empty() ? nullptr : bias.data(), out);
+    }
+
+    // outputs overlapping an operand are computed into a temporary
+    template<typename _DType, typename _Operand>
+    bool overlaps(const multiarray<_DType> &c, const multiarray<_Operand> &x)
+    {
+      if (c.size() == 0 || x.size() == 0) return false;
+      const auto [c_first, c_last] { detail::footprint(c) };
+      const auto [x_first, x_last] { detail::footprint(x) };
+      return !(x_last < c_first || c_last < x_first);
+    }
+
+  }  // namespace
+
+  quantization calibrate(const multiarray<dtype::float32> &x, const datatype type,
+    const int axis, const bool symmetric)
+  {
+    limits(type);
+    if (axis < -1 || axis >= int(x.ndims()))
+      throw std::invalid_argument { "quantization axis is out of range" };
+
+    quantization params;
+    params.axis = axis;
+    if (axis < 0) {
+      fit(min(x), max(x), type, symmetric, params.scales[0], params.zero_points[0]);
+      return params;
+    }
+
+    std::vector<int> others;
+    for (int i { 0 }; i < int(x.ndims()); ++i)
+      if (i != axis) others.push_back(i);
+    const auto lo { min(x, others) }, hi { max(x, others) };
+    const size_t count { x.dim()[axis] };
+    params.scales.resize(count);
+    params.zero_points.resize(count);
+    for (size_t i { 0 }; i < count; ++i)
+      fit(lo.data()[i], hi.data()[i], type, symmetric, params.scales[i],
+        params.zero_points[i]);
+    return params;
+  }
+
+  template<typename _DType>
+  quantized<_DType> quantize(
+    const multiarray<dtype::float32> &x, const quantization &params)
+  {
+    const size_t count { channels(params, x.dim()) };
+    quantized<_DType> out { multiarray<_DType> { x.dim(), uninitialized }, params };
+    for (size_t i { 0 }; i < count; ++i) {
+      const conversion conv { rounding::nearest_even, true, 1. / params.scales[i],
+        double(params.zero_points[i]) };
+      if (params.axis < 0)
+        convert(x, out.values, conv);
+      else {
+        auto channel { out.values.slice(params.axis, i, i + 1) };
+        convert(x.slice(params.axis, i, i + 1), channel, conv);
+      }
+    }
+    return out;
+  }
+
+  template<typename _DType>
+  multiarray<dtype::float32> dequantize(const quantized<_DType> &q)
+  {
+    const quantization &params { q.params };
+    const size_t count { channels(params, q.values.dim()) };
+    multiarray<dtype::float32> out { q.values.dim(), uninitialized };
+    for (size_t i { 0 }; i < count; ++i) {
+      const double scale { params.scales[i] };
+      const conversion conv { rounding::truncate, false, scale,
+        -scale * params.zero_points[i] };
+      if (params.axis < 0)
+        convert(q.values, out, conv);
+      else {
+        auto channel { out.slice(params.axis, i, i + 1) };
+        convert(q.values.slice(params.axis, i, i + 1), channel, conv);
+      }
+    }
+    return out;
+  }
+
+  template<typename _ADType, typename _BDType>
+  multiarray<dtype::int32> &qgemm(const quantized<_ADType> &a,
+    const quantized<_BDType> &b, multiarray<dtype::int32> &c, const bool transpose_a,
+    const bool transpose_b)
+  {
+    product(a, b, c, transpose_a, transpose_b, {}, { nullptr, 0, 0, nullptr, 0, 0, 0 });
+    return c;
+  }
+
+  template<typename _ADType, typename _BDType, typename _CDType>
+  quantized<_CDType> &qgemm(const quantized<_ADType> &a, const quantized<_BDType> &b,
+    quantized<_CDType> &c, const requantization &epilogue, const bool transpose_a,
+    const bool transpose_b)
+  {
+    if (channels(c.params, c.values.dim()) != 1)
+      throw std::invalid_argument {
+        "outputs of quantized products are quantized as a whole"
+      };
+    if (overlaps(c.values, a.values) || overlaps(c.values, b.values)) {
+      quantized<_CDType> out { multiarray<_CDType> { c.values.dim(), uninitialized },
+        c.params };
+      qgemm(a, b, out, epilogue, transpose_a, transpose_b);
+      convert(out.values, c.values, {});
+      return c;
+    }
+
+    // each column is scaled by the product of the scales of its operands over that of c
+    const size_t n { c.values.ndims() == 2 ? c.values.dim()[1] : 0 };
+    const size_t nb { b.params.scales.size() };
+    std::vector<float> scale(n);
+    for (size_t j { 0 }; j < n; ++j)
+      scale[j] = float(double(a.params.scales[0]) * b.params.scales[nb == 1 ? 0 : j]
+        / c.params.scales[0]);
+
+    auto [lo, hi] { limits(_CDType::s_type) };
+    const std::int32_t zero_point { c.params.zero_points[0] };
+    if (epilogue.relu) lo = std::clamp(zero_point, lo, hi);
+    product(a, b, c.values, transpose_a, transpose_b, epilogue.bias,
+      { nullptr, 0, 0, scale.data(), zero_point, lo, hi });
+    return c;
+  }
+
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+#define QUANTIZED_INSTANTIATIONS(qtype)                                                 \
+ template quantized<qtype> quantize(const multiarray<dtype::float32> &x,              \
+   const quantization &params);                                                        \
+ template multiarray<dtype::float32> dequantize(const quantized<qtype> &q);
+
+#define QGEMM_INSTANTIATIONS(a_dtype, b_dtype)                                          \
+ template multiarray<dtype::int32> &qgemm(const quantized<a_dtype> &a,                 \
+   const quantized<b_dtype> &b, multiarray<dtype::int32> &c, const bool transpose_a,    \
+   const bool transpose_b);                                                            \
+ template quantized<dtype::int8> &qgemm(const quantized<a_dtype> &a,                   \
+   const quantized<b_dtype> &b, quantized<dtype::int8> &c,                             \
+   const requantization &epilogue, const bool transpose_a, const bool transpose_b);     \
+ template quantized<dtype::uint8> &qgemm(const quantized<a_dtype> &a,                  \
+   const quantized<b_dtype> &b, quantized<dtype::uint8> &c,                            \
+   const requantization &epilogue, const bool transpose_a, const bool transpose_b);
+
+  QUANTIZED_INSTANTIATIONS(dtype::int8)
+  QUANTIZED_INSTANTIATIONS(dtype::uint8)
+
+  QGEMM_INSTANTIATIONS(dtype::uint8, dtype::int8)
+  QGEMM_INSTANTIATIONS(dtype::uint8, dtype::uint8)
+  QGEMM_INSTANTIATIONS(dtype::int8, dtype::int8)
+  QGEMM_INSTANTIATIONS(dtype::int8, dtype::uint8)
+
+#undef QUANTIZED_INSTANTIATIONS
+#undef QGEMM_INSTANTIATIONS
+
+}  // namespace covdel::ma
@@ -0,0 +1,465 @@
+#include "covdel/ma/reduction.hh"
+#include "covdel/ma/instrument.hh"
+
+#include "kernels.hh"
+#include "parallel.hh"
+#include "traverse.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace covdel::ma::detail
+{
+  namespace
+  {
+    // elements reduced per task, fixed so that results never depend on the thread count
+    static constexpr size_t CHUNK { 1UL << 15 };
+    // innermost kept extents at least this long are accumulated row by row
+    static constexpr size_t ROW_RUN { 16 };
+    // widest row of accumulators a task updates, kept cache resident
+    static constexpr size_t ROW_BLOCK { 1UL << 12 };
+    // fewer row tasks than this also split the reduced axes, to keep threads busy
+    static constexpr size_t MIN_TASKS { 16 };
+
+    // axes of the input split into kept and reduced groups, each in their original order
+    struct plan {
+      template<typename _DType>
+      plan(const multiarray<_DType> &a, const unsigned axes)
+      {
+        for (int i { -1 }; ++i < a.dim().ndims();) {
+          const size_t extent { a.dim()[i] };
+          const ptrdiff_t step { a.strides()[i] };
+          if (axes >> i & 1U) {
+            red_ext[nred] = extent, red_str[nred++] = step;
+            count *= extent;
+          } else {
+            kept_ext[nkept] = extent, kept_str[nkept++] = step;
+            nout *= extent;
+          }
+        }
+        // reducing no axes reduces a single element per output
+        if (nred == 0) red_ext[nred] = 1, red_str[nred++] = 0;
+      }
+
+      // offset of the input block behind the output element `o`, in row-major order
+      ptrdiff_t offset(size_t o) const noexcept
+      {
+        ptrdiff_t offset { 0 };
+        for (int i { nkept }; i-- > 0;) {
+          offset += ptrdiff_t(o % kept_ext[i]) * kept_str[i];
+          o /= kept_ext[i];
+        }
+        return offset;
+      }
+
+      // rows suit inputs whose innermost kept axis is long and more tightly packed than
+      // every reduced axis, as when reducing the leading axis of a contiguous array
+      bool rowwise() const noexcept
+      {
+        if (nkept == 0 || kept_ext[nkept - 1] < ROW_RUN) return false;
+        const ptrdiff_t inner { std::abs(kept_str[nkept - 1]) };
+        for (int i { -1 }; ++i < nred;)
+          if (red_ext[i] > 1 && std::abs(red_str[i]) < inner) return false;
+        return true;
+      }
+
+      int nkept { 0 }, nred { 0 };
+      std::array<size_t, 6> kept_ext {}, red_ext {};
+      std::array<ptrdiff_t, 6> kept_str {}, red_str {};
+      size_t nout { 1 }, count { 1 };
+    };
+
+    ////////////////////////////////////// ENGINES ///////////////////////////////////////
+
+    // reduces the block of every output element on its own, split into chunks along the
+    // outermost reduced axis, `run(acc, o, x, sx, n, position)` folds the run of `n`
+    // elements starting at flat `position` in the block, and chunk partials are merged in
+    // order by `merge(acc, partial)`
+    template<typename _Acc, typename _Type, typename _Run, typename _Merge>
+    std::vector<_Acc> fold_blocks(const plan &p, const _Type *data, const _Acc &identity,
+      _Run run, _Merge merge)
+    {
+      if (p.nout == 0 || p.count == 0) return std::vector<_Acc>(p.nout, identity);
+
+      const size_t inner { p.count / p.red_ext[0] };
+      const size_t rows { std::max<size_t>(1, CHUNK / inner) };
+      const size_t chunks { (p.red_ext[0] + rows - 1) / rows };
+      const size_t elements { std::min(rows, p.red_ext[0]) * inner };
+
+      std::vector<_Acc> partial(p.nout * chunks, identity);
+      parallel_for(partial.size(), std::max<size_t>(1, CHUNK / elements),
+        [&](const size_t begin, const size_t end) {
+          for (size_t task { begin }; task < end; ++task) {
+            const size_t o { task / chunks }, first { task % chunks * rows };
+            auto extent { p.red_ext };
+            extent[0] = std::min(rows, p.red_ext[0] - first);
+            size_t position { first * inner };
+            _Acc &acc { partial[task] };
+            for_each_run(p.nred, extent, { p.red_str },
+              [&](const _Type *x, const ptrdiff_t sx, const size_t n) {
+                run(acc, o, x, sx, n, position);
+                position += n;
+              },
+              data + p.offset(o) + ptrdiff_t(first) * p.red_str[0]);
+          }
+        });
+
+      for (size_t o { 0 }; o < p.nout; ++o) {
+        partial[o] = partial[o * chunks];
+        for (size_t c { 1 }; c < chunks; ++c) merge(partial[o], partial[o * chunks + c]);
+      }
+      partial.resize(p.nout);
+      return partial;
+    }
+
+    // accumulates every element of the reduced axes into a row of outputs along the
+    // innermost kept axis at once, `row(acc, comp, o, x, sx, n)` updates the `n`
+    // accumulators from output `o` on, with floating point compensations in `comp`
+    template<typename _Acc, typename _Type, typename _Row, typename _Merge>
+    std::vector<_Acc> fold_rows(const plan &p, const _Type *data, const _Acc &identity,
+      _Row row, _Merge merge)
+    {
+      if (p.nout == 0 || p.count == 0) return std::vector<_Acc>(p.nout, identity);
+
+      const size_t width { p.kept_ext[p.nkept - 1] };
+      const ptrdiff_t step { p.kept_str[p.nkept - 1] };
+      const size_t blocks { (width + ROW_BLOCK - 1) / ROW_BLOCK };
+      const size_t lines { p.nout / width * blocks };
+
+      // splitting the outermost reduced axis too, when rows alone leave threads idle
+      size_t chunks { 1 };
+      if (lines < MIN_TASKS)
+        chunks = std::clamp<size_t>(
+          std::min(MIN_TASKS / lines, p.count * width / CHUNK), 1, p.red_ext[0]);
+      const size_t rows { (p.red_ext[0] + chunks - 1) / chunks };
+      chunks = (p.red_ext[0] + rows - 1) / rows;
+      const size_t elements { rows * (p.count / p.red_ext[0]) * std::min(width, ROW_BLOCK) };
+
+      std::vector<_Acc> partial(p.nout * chunks, identity);
+      parallel_for(lines * chunks, std::max<size_t>(1, CHUNK / elements),
+        [&](const size_t begin, const size_t end) {
+          std::vector<_Acc> comp(std::min(width, ROW_BLOCK));
+          for (size_t task { begin }; task < end; ++task) {
+            const size_t c { task / lines }, line { task % lines };
+            const size_t first_col { line % blocks * ROW_BLOCK };
+            const size_t n { std::min(ROW_BLOCK, width - first_col) };
+            const size_t o { line / blocks * width + first_col };
+            const size_t first { c * rows };
+            auto extent { p.red_ext };
+            extent[0] = std::min(rows, p.red_ext[0] - first);
+
+            _Acc *acc { partial.data() + c * p.nout + o };
+            std::fill_n(comp.begin(), n, _Acc {});
+            for_each_run(p.nred, extent, { p.red_str },
+              [&](const _Type *x, const ptrdiff_t sx, const size_t count) {
+                for (size_t i { 0 }; i < count; ++i, x += sx)
+                  row(acc, comp.data(), o, x, step, n);
+              },
+              data + p.offset(o) + ptrdiff_t(first) * p.red_str[0]);
+            if constexpr (std::is_floating_point_v<_Acc>)
+              for (size_t i { 0 }; i < n; ++i) acc[i] -= comp[i];
+          }
+        });
+
+      for (size_t c { 1 }; c < chunks; ++c)
+        for (size_t o { 0 }; o < p.nout; ++o) merge(partial[o], partial[c * p.nout + o]);
+      partial.resize(p.nout);
+      return partial;
+    }
+
+    /////////////////////////////////////// FOLDS ////////////////////////////////////////
+
+    template<typename _Type>
+    using acc_t = accumulator_t<_Type>;
+
+    template<typename _Type>
+    std::vector<acc_t<_Type>> sums(const plan &p, const _Type *data)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      const auto merge = [](acc_t<_Type> &acc, const acc_t<_Type> &x) { acc += x; };
+      if (p.rowwise())
+        return fold_rows(p, data, acc_t<_Type>(0),
+          [&k](auto *acc, auto *comp, size_t, const _Type *x, ptrdiff_t sx, size_t n) {
+            k.sum_row(x, sx, acc, comp, n);
+          },
+          merge);
+      return fold_blocks(p, data, acc_t<_Type>(0),
+        [&k](auto &acc, size_t, const _Type *x, ptrdiff_t sx, size_t n, size_t) {
+          acc += k.sum(x, sx, n);
+        },
+        merge);
+    }
+
+    template<typename _Type>
+    std::vector<acc_t<_Type>> products(const plan &p, const _Type *data)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      const auto merge = [](acc_t<_Type> &acc, const acc_t<_Type> &x) { acc *= x; };
+      if (p.rowwise())
+        return fold_rows(p, data, acc_t<_Type>(1),
+          [&k](auto *acc, auto *, size_t, const _Type *x, ptrdiff_t sx, size_t n) {
+            k.prod_row(x, sx, acc, n);
+          },
+          merge);
+      return fold_blocks(p, data, acc_t<_Type>(1),
+        [&k](auto &acc, size_t, const _Type *x, ptrdiff_t sx, size_t n, size_t) {
+          acc *= k.prod(x, sx, n);
+        },
+        merge);
+    }
+
+    // squared deviations from a center per output element
+    template<typename _Type>
+    std::vector<double> squares(const plan &p, const _Type *data, const double *center)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      const auto merge = [](double &acc, const double &x) { acc += x; };
+      if (p.rowwise())
+        return fold_rows(p, data, 0.0,
+          [&k, center](double *acc, double *comp, size_t o, const _Type *x, ptrdiff_t sx,
+            size_t n) { k.sumsq_row(x, sx, center + o, acc, comp, n); },
+          merge);
+      return fold_blocks(p, data, 0.0,
+        [&k, center](double &acc, size_t o, const _Type *x, ptrdiff_t sx, size_t n, size_t) {
+          acc += k.sumsq(x, sx, n, center[o]);
+        },
+        merge);
+    }
+
+    template<typename _Type>
+    bool is_nan(const _Type value) noexcept
+    {
+      if constexpr (std::is_floating_point_v<_Type>)
+        return value != value;
+      else
+        return false;
+    }
+
+    // strictly better candidates replace the current extreme, so the first one is kept
+    template<bool _Min, typename _Type>
+    bool better(const _Type candidate, const _Type current) noexcept
+    {
+      if (is_nan(current)) return false;
+      if (is_nan(candidate)) return true;
+      return _Min ? candidate < current : current < candidate;
+    }
+
+    template<bool _Min, typename _Type>
+    std::vector<_Type> extremes(const plan &p, const _Type *data)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      using limits = std::numeric_limits<_Type>;
+      _Type identity {};
+      if constexpr (std::is_floating_point_v<_Type>)
+        identity = _Min ? limits::infinity() : -limits::infinity();
+      else
+        identity = _Min ? limits::max() : limits::lowest();
+
+      const auto merge = [](_Type &acc, const _Type &x) {
+        if (better<_Min>(x, acc)) acc = x;
+      };
+      const auto fold { _Min ? k.min : k.max };
+      const auto fold_row { _Min ? k.min_row : k.max_row };
+      if (p.rowwise())
+        return fold_rows(p, data, identity,
+          [fold_row](_Type *acc, _Type *, size_t, const _Type *x, ptrdiff_t sx, size_t n) {
+            fold_row(x, sx, acc, n);
+          },
+          merge);
+      return fold_blocks(p, data, identity,
+        [fold](_Type &acc, size_t, const _Type *x, ptrdiff_t sx, size_t n, size_t) {
+          acc = fold(x, sx, n, acc);
+        },
+        merge);
+    }
+
+    template<typename _Type>
+    struct position {
+      _Type value;
+      size_t index;
+      bool found;
+    };
+
+    // the extreme of each run is found with the kernels, and only then located
+    template<bool _Min, typename _Type>
+    std::vector<position<_Type>> positions(const plan &p, const _Type *data)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      const auto fold { _Min ? k.min : k.max };
+      return fold_blocks(p, data, position<_Type> { _Type {}, 0, false },
+        [fold](auto &acc, size_t, const _Type *x, ptrdiff_t sx, size_t n, size_t first) {
+          const _Type extreme { fold(x, sx, n, *x) };
+          if (acc.found && !better<_Min>(extreme, acc.value)) return;
+          size_t i { 0 };
+          while (!(x[ptrdiff_t(i) * sx] == extreme || is_nan(x[ptrdiff_t(i) * sx]))) ++i;
+          acc = { extreme, first + i, true };
+        },
+        [](auto &acc, const auto &x) {
+          if (x.found && (!acc.found || better<_Min>(x.value, acc.value))) acc = x;
+        });
+    }
+
+    template<typename _Type>
+    std::vector<std::uint64_t> nonzeros(const plan &p, const _Type *data)
+    {
+      const auto &k { kernels<_Type>().reduce };
+      const auto merge = [](std::uint64_t &acc, const std::uint64_t &x) { acc += x; };
+      if (p.rowwise())
+        return fold_rows(p, data, std::uint64_t(0),
+          [&k](auto *acc, auto *, size_t, const _Type *x, ptrdiff_t sx, size_t n) {
+            k.nonzero_row(x, sx, acc, n);
+          },
+          merge);
+      return fold_blocks(p, data, std::uint64_t(0),
+        [&k](auto &acc, size_t, const _Type *x, ptrdiff_t sx, size_t n, size_t) {
+          acc += k.nonzero(x, sx, n);
+        },
+        merge);
+    }
+
+    // integer sums wrap around in unsigned arithmetic, signed ones are read back as such
+    template<typename _Type>
+    double to_double(const acc_t<_Type> acc) noexcept
+    {
+      if constexpr (std::is_signed_v<_Type> && std::is_integral_v<_Type>)
+        return double(std::int64_t(acc));
+      else
+        return double(acc);
+    }
+
+    template<typename _Type>
+    std::vector<double> means(const plan &p, const _Type *data)
+    {
+      const auto acc { sums(p, data) };
+      std::vector<double> mean(acc.size());
+      for (size_t o { 0 }; o < acc.size(); ++o)
+        mean[o] = to_double<_Type>(acc[o]) / double(p.count);
+      return mean;
+    }
+
+  }  // namespace
+
+  //////////////////////////////////////// REDUCE ////////////////////////////////////////
+
+  unsigned axis_mask(const dimension &dim, const std::vector<int> &axes)
+  {
+    unsigned mask { 0 };
+    for (const int axis : axes) {
+      if (axis < -dim.ndims() || axis >= dim.ndims())
+        throw std::out_of_range { "axis out of bounds" };
+      const int bit { axis < 0 ? axis + dim.ndims() : axis };
+      if (mask >> bit & 1U) throw std::invalid_argument { "repeated axis" };
+      mask |= 1U << bit;
+    }
+    return mask;
+  }
+
+  template<typename _DType, typename _RType>
+  void reduce(const reduce_op op, const multiarray<_DType> &a, const unsigned axes,
+    const size_t ddof, multiarray<_RType> &out)
+  {
+    using native_type = typename multiarray<_DType>::native_type;
+    using result_type = typename multiarray<_RType>::native_type;
+    COVDEL_PROBE(operation::reduce, _DType::s_type, a.size() * sizeof(native_type));
+
+    const plan p { a, axes };
+    if (out.size() != p.nout || !out.is_contiguous())
+      throw std::invalid_argument { "output does not match the reduced shape" };
+    if (p.count == 0 && p.nout != 0
+      && (op == reduce_op::min || op == reduce_op::max || op == reduce_op::argmin
+        || op == reduce_op::argmax))
+      throw std::invalid_argument { "zero-size reduction has no identity" };
+
+    const native_type *data { a.data() };
+    result_type *dst { out.data() };
+    const auto store = [dst](const auto &values, auto convert) {
+      for (size_t o { 0 }; o < values.size(); ++o) dst[o] = result_type(convert(values[o]));
+    };
+    const auto same = [](const auto value) { return value; };
+
+    switch (op) {
+      case reduce_op::sum: store(sums(p, data), same); break;
+      case reduce_op::prod: store(products(p, data), same); break;
+      case reduce_op::mean: store(means(p, data), same); break;
+      case reduce_op::var:
+      case reduce_op::stddev: {
+        const auto center { means(p, data) };
+        const double dof { double(p.count) - double(ddof) };
+        const bool root { op == reduce_op::stddev };
+        store(squares(p, data, center.data()), [dof, root](const double ss) {
+          const double var { dof > 0 ? ss / dof : std::numeric_limits<double>::quiet_NaN() };
+          return root ? std::sqrt(var) : var;
+        });
+        break;
+      }
+      // boolean extremes are counted instead, as std::vector<bool> packs its elements
+      case reduce_op::min:
+        if constexpr (std::is_same_v<native_type, bool>)
+          store(nonzeros(p, data), [&p](const std::uint64_t n) { return n == p.count; });
+        else
+          store(extremes<true>(p, data), same);
+        break;
+      case reduce_op::max:
+        if constexpr (std::is_same_v<native_type, bool>)
+          store(nonzeros(p, data), [](const std::uint64_t n) { return n != 0; });
+        else
+          store(extremes<false>(p, data), same);
+        break;
+      case reduce_op::argmin:
+        store(positions<true>(p, data), [](const auto &x) { return x.index; });
+        break;
+      case reduce_op::argmax:
+        store(positions<false>(p, data), [](const auto &x) { return x.index; });
+        break;
+      case reduce_op::any:
+        store(nonzeros(p, data), [](const std::uint64_t n) { return n != 0; });
+        break;
+      case reduce_op::all:
+        store(nonzeros(p, data), [&p](const std::uint64_t n) { return n == p.count; });
+        break;
+    }
+  }
+
+  //////// TEMPLATE INSTANTIATIONS /////////
+
+// every input reduces into the wide accumulation, averaging, index and truth datatypes
+#define REDUCTION_INSTANTIATIONS(type)                                                \
+ template void reduce<type, dtype::int64>(const reduce_op, const multiarray<type> &,    \
+   const unsigned, const size_t, multiarray<dtype::int64> &);                          \
+ template void reduce<type, dtype::uint64>(const reduce_op, const multiarray<type> &,   \
+   const unsigned, const size_t, multiarray<dtype::uint64> &);                         \
+ template void reduce<type, dtype::float32>(const reduce_op, const multiarray<type> &,  \
+   const unsigned, const size_t, multiarray<dtype::float32> &);                        \
+ template void reduce<type, dtype::float64>(const reduce_op, const multiarray<type> &,  \
+   const unsigned, const size_t, multiarray<dtype::float64> &);                        \
+ template void reduce<type, dtype::bool8>(const reduce_op, const multiarray<type> &,    \
+   const unsigned, const size_t, multiarray<dtype::bool8> &);
+
+// extremes keep the datatype, wherever that is not among the results above
+#define EXTREME_INSTANTIATIONS(type)                                                  \
+ template void reduce<type, type>(const reduce_op, const multiarray<type> &,           \
+   const unsigned, const size_t, multiarray<type> &);
+
+  REDUCTION_INSTANTIATIONS(dtype::bool8);
+  REDUCTION_INSTANTIATIONS(dtype::int8);
+  REDUCTION_INSTANTIATIONS(dtype::int16);
+  REDUCTION_INSTANTIATIONS(dtype::int32);
+  REDUCTION_INSTANTIATIONS(dtype::int64);
+  REDUCTION_INSTANTIATIONS(dtype::uint8);
+  REDUCTION_INSTANTIATIONS(dtype::uint16);
+  REDUCTION_INSTANTIATIONS(dtype::uint32);
+  REDUCTION_INSTANTIATIONS(dtype::uint64);
+  REDUCTION_INSTANTIATIONS(dtype::float32);
+  REDUCTION_INSTANTIATIONS(dtype::float64);
+
+  EXTREME_INSTANTIATIONS(dtype::int8);
+  EXTREME_INSTANTIATIONS(dtype::int16);
+  EXTREME_INSTANTIATIONS(dtype::int32);
+  EXTREME_INSTANTIATIONS(dtype::uint8);
+  EXTREME_INSTANTIATIONS(dtype::uint16);
+  EXTREME_INSTANTIATIONS(dtype::uint32);
+
+}  // namespace covdel::ma::detail
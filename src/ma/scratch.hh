@@ -0,0 +1,29 @@
+#ifndef __COVDEL_SRC_MA_SCRATCH_HH_1702475322__
+#define __COVDEL_SRC_MA_SCRATCH_HH_1702475322__
+
+#include "covdel/ma/allocator.hh"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace covdel::ma::detail
+{
+  // uninitialized buffer from the pool, so that steady streams of operations needing
+  // temporaries never reach the heap, never shared between threads
+  template<typename _Type>
+  struct scratch {
+    explicit scratch(const std::size_t count)
+      : bytes { std::max<std::size_t>(count, 1) * sizeof(_Type) },
+        data { static_cast<_Type *>(pool_allocator::instance().allocate(bytes)) }
+    { }
+    scratch(const scratch &) = delete;
+    scratch &operator=(const scratch &) = delete;
+    ~scratch() noexcept { pool_allocator::instance().deallocate(data, bytes); }
+
+    const std::size_t bytes;
+    _Type *const data;
+  };
+
+}  // namespace covdel::ma::detail
+
+#endif
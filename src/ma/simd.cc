@@ -0,0 +1,113 @@
+#include "covdel/ma/simd.hh"
+
+#include "kernels.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace covdel::ma
+{
+  namespace
+  {
+    isa detect() noexcept
+    {
+#ifdef COVDEL_X86_KERNELS
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+        return isa::avx512;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return isa::avx2;
+      if (__builtin_cpu_supports("sse2")) return isa::sse2;
+#endif
+      return isa::scalar;
+    }
+
+    // one fully populated registry per instruction set level the build provides
+    struct dispatcher {
+      dispatcher() noexcept : m_max { detect() }, m_active { int(m_max) }
+      {
+        detail::scalar::fill(m_levels[int(isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+        detail::sse2::fill(m_levels[int(isa::sse2)]);
+        detail::avx2::fill(m_levels[int(isa::avx2)]);
+        detail::avx512::fill(m_levels[int(isa::avx512)]);
+#endif
+      }
+
+      const detail::kernel_registry &active() const noexcept
+      {
+        return m_levels[m_active.load(std::memory_order_relaxed)];
+      }
+
+      detail::kernel_registry m_levels[4];
+      const isa m_max;
+      std::atomic<int> m_active;
+    };
+
+    dispatcher &instance() noexcept
+    {
+      static dispatcher s_dispatcher;
+      return s_dispatcher;
+    }
+
+  }  // namespace
+
+  isa max_isa() noexcept { return instance().m_max; }
+
+  isa active_isa() noexcept { return isa(instance().m_active.load()); }
+
+  void set_isa(const isa level)
+  {
+    if (int(level) < int(isa::scalar) || int(level) > int(max_isa()))
+      throw std::invalid_argument { "instruction set is not supported on this cpu" };
+    instance().m_active.store(int(level));
+  }
+
+  std::string str(const isa level)
+  {
+    switch (level) {
+      case isa::scalar: return "scalar";
+      case isa::sse2: return "sse2";
+      case isa::avx2: return "avx2";
+      case isa::avx512: return "avx512";
+    }
+    throw std::invalid_argument { "unknown instruction set" };
+  }
+
+  namespace detail
+  {
+    template<typename _Type>
+    const kernel_table<_Type> &kernels() noexcept
+    {
+      const auto &registry { instance().active() };
+      if constexpr (std::is_same_v<_Type, bool>) return registry.bool8;
+      if constexpr (std::is_same_v<_Type, std::int8_t>) return registry.int8;
+      if constexpr (std::is_same_v<_Type, std::int16_t>) return registry.int16;
+      if constexpr (std::is_same_v<_Type, std::int32_t>) return registry.int32;
+      if constexpr (std::is_same_v<_Type, std::int64_t>) return registry.int64;
+      if constexpr (std::is_same_v<_Type, std::uint8_t>) return registry.uint8;
+      if constexpr (std::is_same_v<_Type, std::uint16_t>) return registry.uint16;
+      if constexpr (std::is_same_v<_Type, std::uint32_t>) return registry.uint32;
+      if constexpr (std::is_same_v<_Type, std::uint64_t>) return registry.uint64;
+      if constexpr (std::is_same_v<_Type, float>) return registry.float32;
+      if constexpr (std::is_same_v<_Type, double>) return registry.float64;
+    }
+
+    //////// TEMPLATE INSTANTIATIONS /////////
+
+    template const kernel_table<bool> &kernels() noexcept;
+    template const kernel_table<std::int8_t> &kernels() noexcept;
+    template const kernel_table<std::int16_t> &kernels() noexcept;
+    template const kernel_table<std::int32_t> &kernels() noexcept;
+    template const kernel_table<std::int64_t> &kernels() noexcept;
+    template const kernel_table<std::uint8_t> &kernels() noexcept;
+    template const kernel_table<std::uint16_t> &kernels() noexcept;
+    template const kernel_table<std::uint32_t> &kernels() noexcept;
+    template const kernel_table<std::uint64_t> &kernels() noexcept;
+    template const kernel_table<float> &kernels() noexcept;
+    template const kernel_table<double> &kernels() noexcept;
+
+  }  // namespace detail
+
+}  // namespace covdel::ma
@@ -0,0 +1,72 @@
+#ifndef __COVDEL_SRC_MA_TRAVERSE_HH_1700402117__
+#define __COVDEL_SRC_MA_TRAVERSE_HH_1700402117__
+
+#include "covdel/ma/dimension.hh"
+#include "covdel/ma/nditer.hh"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+
+namespace covdel::ma::detail
+{
+  // operand of a strided traversal, the first element and its per-axis strides
+  template<typename _Type>
+  struct operand {
+    _Type *data;
+    const stride &strides;
+  };
+
+  template<typename _Type>
+  operand(_Type *, const stride &) -> operand<_Type>;
+
+  // walks the elements [begin, end) of `extent` over `ndims` axes in row-major order, with
+  // per-operand element strides, calling `func(ptrs..., inner_strides..., count)` once per
+  // run along the innermost axis, adjacent axes which are contiguous in every operand are
+  // merged into longer runs
+  template<typename _Func, typename... _Types>
+  void for_each_run(int ndims, std::array<size_t, 6> extent,
+    std::array<std::array<ptrdiff_t, 6>, sizeof...(_Types)> steps, size_t begin, size_t end,
+    _Func &&func, _Types *...data)
+  {
+    for (int i { -1 }; ++i < ndims;)
+      if (extent[i] == 0) return;
+    if (begin >= end) return;
+
+    // 0-d arrays are a single run of one element
+    if (ndims == 0) extent[0] = 1, ndims = 1;
+
+    ndims = merge_axes(ndims, extent, steps);
+    walk_runs(ndims, extent, steps, begin, end, func, std::tuple<_Types *...> { data... });
+  }
+
+  // walks every element of `extent`, see above
+  template<typename _Func, typename... _Types>
+  void for_each_run(int ndims, std::array<size_t, 6> extent,
+    std::array<std::array<ptrdiff_t, 6>, sizeof...(_Types)> steps, _Func &&func,
+    _Types *...data)
+  {
+    size_t size { 1 };
+    for (int i { -1 }; ++i < ndims;) size *= extent[i];
+    for_each_run(ndims, extent, steps, 0, size, std::forward<_Func>(func), data...);
+  }
+
+  // walks the common shape of all operands, see above
+  template<typename _Func, typename... _Types>
+  void for_each_run(const dimension &dim, _Func &&func, operand<_Types>... ops)
+  {
+    const int ndims { dim.ndims() };
+    std::array<size_t, 6> extent {};
+    std::array<std::array<ptrdiff_t, 6>, sizeof...(_Types)> steps {};
+    for (int i { -1 }; ++i < ndims;) {
+      extent[i] = dim[i];
+      size_t k { 0 };
+      ((steps[k++][i] = ops.strides[i]), ...);
+    }
+    for_each_run(ndims, extent, steps, std::forward<_Func>(func), ops.data...);
+  }
+
+}  // namespace covdel::ma::detail
+
+#endif
@@ -0,0 +1,766 @@
+#include "zlib.hh"
+
+#include "files.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace covdel::ma::detail
+{
+  namespace
+  {
+    constexpr size_t WINDOW { 32768 }, MIN_MATCH { 3 }, MAX_MATCH { 258 };
+    constexpr int FAST_BITS { 10 }, HASH_BITS { 15 };
+
+    constexpr std::array<uint16_t, 29> LENGTH_BASE { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15,
+      17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr std::array<uint8_t, 29> LENGTH_EXTRA { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+      2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    constexpr std::array<uint16_t, 30> DISTANCE_BASE { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25,
+      33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+      8193, 12289, 16385, 24577 };
+    constexpr std::array<uint8_t, 30> DISTANCE_EXTRA { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+      5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    // order of the lengths of the code length alphabet in dynamic block headers
+    constexpr std::array<uint8_t, 19> CODE_ORDER { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11,
+      4, 12, 3, 13, 2, 14, 1, 15 };
+
+    // length and distance codes by value, distances above 256 by their value >> 7
+    constexpr auto LENGTH_CODE { [] {
+      std::array<uint8_t, MAX_MATCH + 1> codes {};
+      for (int code { 0 }; code < 29; ++code) {
+        const size_t end { LENGTH_BASE[code] + (size_t(1) << LENGTH_EXTRA[code]) };
+        for (size_t length { LENGTH_BASE[code] }; length < std::min(end, MAX_MATCH + 1);
+             ++length)
+          codes[length] = uint8_t(code);
+      }
+      return codes;
+    }() };
+
+    constexpr auto DISTANCE_CODE { [] {
+      std::array<uint8_t, 512> codes {};
+      for (int code { 0 }; code < 30; ++code) {
+        const size_t end { DISTANCE_BASE[code] + (size_t(1) << DISTANCE_EXTRA[code]) };
+        for (size_t distance { DISTANCE_BASE[code] }; distance < end; ++distance)
+          codes[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)] =
+            uint8_t(code);
+      }
+      return codes;
+    }() };
+
+    uint8_t distance_code(const size_t distance) noexcept
+    {
+      return DISTANCE_CODE[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+    }
+
+    // longest hash chain walked, match length ending the search, and whether a match
+    // waits for a longer one at the next byte
+    struct effort {
+      int chain;
+      size_t nice;
+      bool lazy;
+    };
+
+    constexpr std::array<effort, 10> LEVELS { { { 0, 0, false }, { 4, 16, false },
+      { 8, 32, false }, { 16, 64, false }, { 16, 32, true }, { 32, 64, true },
+      { 128, 128, true }, { 256, 258, true }, { 1024, 258, true },
+      { 4096, 258, true } } };
+
+    constexpr size_t BLOCK { 1 << 17 };
+
+    [[noreturn]] void corrupt()
+    {
+      throw std::invalid_argument { "corrupt deflate stream" };
+    }
+
+    uint32_t reverse(uint32_t code, const int length) noexcept
+    {
+      uint32_t reversed { 0 };
+      for (int i { -1 }; ++i < length; code >>= 1) reversed = reversed << 1 | (code & 1);
+      return reversed;
+    }
+
+    // bit reversed canonical codes of the given lengths
+    void assign_codes(const uint8_t *lengths, const int count, uint16_t *codes) noexcept
+    {
+      std::array<uint16_t, 16> counts {}, next {};
+      for (int i { -1 }; ++i < count;) ++counts[lengths[i]];
+      counts[0] = 0;
+      for (int length { 1 }; length < 16; ++length)
+        next[length] = uint16_t((next[length - 1] + counts[length - 1]) << 1);
+      for (int i { -1 }; ++i < count;)
+        if (lengths[i]) codes[i] = uint16_t(reverse(next[lengths[i]]++, lengths[i]));
+    }
+
+    // huffman code lengths of at most `limit` bits, a lone symbol gets a sibling so that
+    // every code is complete
+    void limited_lengths(const uint32_t *freqs, const int count, const int limit,
+      uint8_t *lengths)
+    {
+      std::vector<std::pair<uint32_t, int>> symbols;
+      for (int i { -1 }; ++i < count;)
+        if (freqs[i]) symbols.emplace_back(freqs[i], i);
+      std::fill(lengths, lengths + count, uint8_t(0));
+      if (symbols.size() < 2) {
+        const int used { symbols.empty() ? 0 : symbols[0].second };
+        lengths[used] = lengths[used == 0 ? 1 : 0] = 1;
+        return;
+      }
+      std::sort(symbols.begin(), symbols.end());
+
+      // leaves and internal nodes are both taken in ascending order of weight from two
+      // queues, parents always come after their children
+      const size_t leaves { symbols.size() }, nodes { 2 * leaves - 1 };
+      std::vector<uint64_t> weight(nodes);
+      std::vector<size_t> parent(nodes);
+      for (size_t i { 0 }; i < leaves; ++i) weight[i] = symbols[i].first;
+      size_t leaf { 0 }, internal { leaves };
+      for (size_t next { leaves }; next < nodes; ++next) {
+        const auto take = [&] {
+          return leaf < leaves && (internal >= next || weight[leaf] <= weight[internal])
+                 ? leaf++
+                 : internal++;
+        };
+        const size_t a { take() }, b { take() };
+        weight[next] = weight[a] + weight[b];
+        parent[a] = parent[b] = next;
+      }
+      std::vector<int> depth(nodes);
+      std::array<uint32_t, 33> counts {};
+      for (size_t i { nodes - 1 }; i-- > 0;) {
+        depth[i] = depth[parent[i]] + 1;
+        if (i < leaves) ++counts[std::min(depth[i], 32)];
+      }
+
+      // deeper leaves move up to the limit, then leaves are pushed down one level at a
+      // time until the code is complete again
+      for (int length { limit + 1 }; length <= 32; ++length)
+        counts[limit] += counts[length], counts[length] = 0;
+      uint32_t total { 0 };
+      for (int length { limit }; length > 0; --length)
+        total += counts[length] << (limit - length);
+      for (; total != uint32_t(1) << limit; --total) {
+        --counts[limit];
+        for (int length { limit - 1 }; length > 0; --length)
+          if (counts[length]) {
+            --counts[length];
+            counts[length + 1] += 2;
+            break;
+          }
+      }
+
+      // the most frequent symbols get the shortest codes
+      size_t j { leaves };
+      for (int length { 1 }; length <= limit; ++length)
+        for (uint32_t k { counts[length] }; k > 0; --k)
+          lengths[symbols[--j].second] = uint8_t(length);
+    }
+
+    uint32_t hash3(const uint8_t *p) noexcept
+    {
+      return (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16) * 2654435761U
+          >> (32 - HASH_BITS);
+    }
+
+  }  // namespace
+
+  uint32_t adler32(uint32_t adler, const uint8_t *bytes, size_t length) noexcept
+  {
+    // sums stay below 2^32 over 5552 bytes
+    uint32_t a { adler & 0xFFFF }, b { adler >> 16 };
+    while (length) {
+      size_t n { std::min<size_t>(length, 5552) };
+      length -= n;
+      for (; n >= 4; n -= 4, bytes += 4) {
+        b += 4 * a + 4 * bytes[0] + 3 * bytes[1] + 2 * bytes[2] + bytes[3];
+        a += uint32_t(bytes[0]) + bytes[1] + bytes[2] + bytes[3];
+      }
+      for (; n; --n) b += a += *bytes++;
+      a %= 65521;
+      b %= 65521;
+    }
+    return b << 16 | a;
+  }
+
+  ////////////////////////////////////// INFLATER ////////////////////////////////////////
+
+  void inflater::table::build(const uint8_t *lengths, const int count)
+  {
+    std::fill(std::begin(counts), std::end(counts), uint16_t(0));
+    for (int i { -1 }; ++i < count;) ++counts[lengths[i]];
+    counts[0] = 0;
+
+    // over-subscribed codes are corrupt, incomplete ones fail on their missing codes
+    int left { 1 };
+    for (int length { 1 }; length < 16; ++length)
+      if ((left = 2 * left - counts[length]) < 0) corrupt();
+
+    std::array<uint16_t, 16> offsets {};
+    for (int length { 1 }; length < 15; ++length)
+      offsets[length + 1] = uint16_t(offsets[length] + counts[length]);
+    for (int i { -1 }; ++i < count;)
+      if (lengths[i]) symbols[offsets[lengths[i]]++] = uint16_t(i);
+
+    std::fill(std::begin(fast), std::end(fast), uint16_t(0));
+    uint32_t code { 0 };
+    int index { 0 };
+    for (int length { 1 }; length <= FAST_BITS; ++length, code <<= 1)
+      for (int k { 0 }; k < counts[length]; ++k, ++code) {
+        const auto entry { uint16_t(symbols[index++] << 4 | length) };
+        for (uint32_t f { reverse(code, length) }; f < (1U << FAST_BITS);
+             f += 1U << length)
+          fast[f] = entry;
+      }
+  }
+
+  int inflater::table::decode(inflater &in)
+  {
+    const uint16_t entry { fast[in.peek(FAST_BITS)] };
+    if (entry) {
+      in.consume(entry & 15);
+      return entry >> 4;
+    }
+
+    // longer codes are read bit by bit, in canonical order
+    int code { 0 }, first { 0 }, index { 0 };
+    for (int length { 1 }; length < 16; ++length) {
+      code |= int(in.bits(1));
+      const int count { counts[length] };
+      if (code - count < first) return symbols[index + code - first];
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    }
+    corrupt();
+  }
+
+  inflater::inflater(std::vector<std::pair<const char *, size_t>> pieces,
+    const size_t largest, const bool raw)
+    : m_pieces { std::move(pieces) }, m_piece {}, m_pos {}, m_bits {}, m_count {},
+      m_padding {},
+      m_window(std::max<size_t>(1 << 20, 2 * (WINDOW + largest + MAX_MATCH))), m_read {},
+      m_end {}, m_state { state::header }, m_raw { raw }, m_last {}, m_stored {},
+      m_lengths {}, m_distances {}, m_adler { 1 }
+  {
+    if (raw) return;
+    const uint32_t method { bits(8) }, flags { bits(8) };
+    if ((method & 15) != 8 || method >> 4 > 7 || (method << 8 | flags) % 31
+        || flags & 0x20)
+      throw std::invalid_argument { "corrupt zlib header" };
+  }
+
+  const uint8_t *inflater::next(const size_t count)
+  {
+    if (m_end - m_read < count) {
+      reserve(count);
+      produce(m_read + count);
+      if (m_end - m_read < count)
+        throw std::invalid_argument { "truncated deflate stream" };
+    }
+    const uint8_t *bytes { m_window.data() + m_read };
+    if (!m_raw) m_adler = adler32(m_adler, bytes, count);
+    m_read += count;
+    return bytes;
+  }
+
+  void inflater::finish()
+  {
+    // a final empty block may still follow, anything else is data beyond the end
+    reserve(1);
+    if (m_end != m_read) corrupt();
+    produce(m_end + 1);
+    if (m_end != m_read || m_state != state::done) corrupt();
+    if (m_raw) return;
+
+    consume(m_count & 7);
+    uint32_t adler { 0 };
+    for (int i { 0 }; i < 4; ++i) adler = adler << 8 | bits(8);
+    if (adler != m_adler) throw std::invalid_argument { "zlib checksum mismatch" };
+  }
+
+  void inflater::reserve(const size_t count) noexcept
+  {
+    if (m_read + count + MAX_MATCH <= m_window.size()) return;
+
+    // keeps the unread bytes and the history matches may refer to
+    const size_t keep { std::min(m_read, m_end - std::min(m_end, WINDOW)) };
+    std::memmove(m_window.data(), m_window.data() + keep, m_end - keep);
+    m_read -= keep;
+    m_end -= keep;
+  }
+
+  void inflater::refill() noexcept
+  {
+    while (m_count < 56) {
+      if (m_piece == m_pieces.size()) {
+        // zeros past the end, which are corrupt once consumed
+        m_count += 8;
+        m_padding += 8;
+        continue;
+      }
+      const auto &[data, size] { m_pieces[m_piece] };
+      if (m_pos + 8 <= size) {
+        // whole words, the bits above the count are the next bytes in either case
+        m_bits |= read_le(data + m_pos, 8) << m_count;
+        const int taken { (63 - m_count) >> 3 };
+        m_pos += size_t(taken);
+        m_count += 8 * taken;
+      } else if (m_pos == size) {
+        ++m_piece;
+        m_pos = 0;
+      } else {
+        m_bits |= uint64_t(uint8_t(data[m_pos++])) << m_count;
+        m_count += 8;
+      }
+    }
+  }
+
+  uint32_t inflater::peek(const int count) noexcept
+  {
+    if (m_count < count) refill();
+    return uint32_t(m_bits & ((uint64_t(1) << count) - 1));
+  }
+
+  void inflater::consume(const int count)
+  {
+    m_bits >>= count;
+    if ((m_count -= count) < m_padding)
+      throw std::invalid_argument { "truncated deflate stream" };
+  }
+
+  uint32_t inflater::bits(const int count)
+  {
+    const uint32_t value { peek(count) };
+    consume(count);
+    return value;
+  }
+
+  void inflater::block_header()
+  {
+    m_last = bits(1);
+    switch (bits(2)) {
+    case 0: {
+      consume(m_count & 7);
+      const uint32_t length { bits(16) };
+      if (length != (~bits(16) & 0xFFFF)) corrupt();
+      m_stored = length;
+      m_state = state::stored;
+      return;
+    }
+    case 1: {
+      std::array<uint8_t, 318> lengths {};
+      std::fill(lengths.begin(), lengths.begin() + 144, uint8_t(8));
+      std::fill(lengths.begin() + 144, lengths.begin() + 256, uint8_t(9));
+      std::fill(lengths.begin() + 256, lengths.begin() + 280, uint8_t(7));
+      std::fill(lengths.begin() + 280, lengths.begin() + 288, uint8_t(8));
+      std::fill(lengths.begin() + 288, lengths.end(), uint8_t(5));
+      m_lengths.build(lengths.data(), 288);
+      m_distances.build(lengths.data() + 288, 30);
+      m_state = state::huffman;
+      return;
+    }
+    case 2:
+      dynamic_tables();
+      m_state = state::huffman;
+      return;
+    default: corrupt();
+    }
+  }
+
+  void inflater::dynamic_tables()
+  {
+    const int lengths_count { int(bits(5)) + 257 }, distances_count { int(bits(5)) + 1 };
+    const int codes_count { int(bits(4)) + 4 };
+    if (lengths_count > 286 || distances_count > 30) corrupt();
+
+    std::array<uint8_t, 19> code_lengths {};
+    for (int i { -1 }; ++i < codes_count;) code_lengths[CODE_ORDER[i]] = uint8_t(bits(3));
+    table codes;
+    codes.build(code_lengths.data(), 19);
+
+    std::array<uint8_t, 316> lengths {};
+    const int total { lengths_count + distances_count };
+    for (int i { 0 }; i < total;) {
+      const int symbol { codes.decode(*this) };
+      if (symbol < 16) {
+        lengths[i++] = uint8_t(symbol);
+        continue;
+      }
+      uint8_t value { 0 };
+      int repeat;
+      if (symbol == 16) {
+        if (i == 0) corrupt();
+        value = lengths[i - 1];
+        repeat = 3 + int(bits(2));
+      } else {
+        repeat = symbol == 17 ? 3 + int(bits(3)) : 11 + int(bits(7));
+      }
+      if (i + repeat > total) corrupt();
+      for (; repeat; --repeat) lengths[i++] = value;
+    }
+    if (lengths[256] == 0) corrupt();
+    m_lengths.build(lengths.data(), lengths_count);
+    m_distances.build(lengths.data() + lengths_count, distances_count);
+  }
+
+  // decodes until the window holds `limit` bytes or the stream ends, matches may overrun
+  // the limit by less than MAX_MATCH bytes
+  void inflater::produce(const size_t limit)
+  {
+    uint8_t *const window { m_window.data() };
+    while (m_end < limit && m_state != state::done) {
+      switch (m_state) {
+      case state::header: block_header(); break;
+
+      case state::stored:
+        while (m_stored && m_end < limit) {
+          if (m_count - m_padding >= 8) {
+            window[m_end++] = uint8_t(bits(8));
+            --m_stored;
+            continue;
+          }
+          if (m_padding) corrupt();
+          m_bits = 0;
+          while (m_piece < m_pieces.size() && m_pos == m_pieces[m_piece].second)
+            ++m_piece, m_pos = 0;
+          if (m_piece == m_pieces.size()) corrupt();
+          const auto &[data, size] { m_pieces[m_piece] };
+          const size_t n { std::min({ m_stored, limit - m_end, size - m_pos }) };
+          std::memcpy(window + m_end, data + m_pos, n);
+          m_end += n;
+          m_stored -= n;
+          if ((m_pos += n) == size) ++m_piece, m_pos = 0;
+        }
+        if (!m_stored) m_state = m_last ? state::done : state::header;
+        break;
+
+      case state::huffman:
+        while (m_end < limit) {
+          int symbol { m_lengths.decode(*this) };
+          if (symbol < 256) {
+            window[m_end++] = uint8_t(symbol);
+            continue;
+          }
+          if (symbol == 256) {
+            m_state = m_last ? state::done : state::header;
+            break;
+          }
+          if ((symbol -= 257) >= 29) corrupt();
+          const size_t length { LENGTH_BASE[symbol] + bits(LENGTH_EXTRA[symbol]) };
+          const int code { m_distances.decode(*this) };
+          if (code >= 30) corrupt();
+          const size_t distance { DISTANCE_BASE[code] + bits(DISTANCE_EXTRA[code]) };
+          if (distance > m_end) corrupt();
+
+          // overlapping matches repeat their last `distance` bytes
+          uint8_t *out { window + m_end };
+          const uint8_t *ref { out - distance };
+          if (distance >= length)
+            std::memcpy(out, ref, length);
+          else
+            for (size_t i { 0 }; i < length; ++i) out[i] = ref[i];
+          m_end += length;
+        }
+        break;
+
+      default: break;
+      }
+    }
+  }
+
+  ////////////////////////////////////// DEFLATER ////////////////////////////////////////
+
+  deflater::deflater(const int level)
+    : m_level { level }, m_input {}, m_offset {}, m_pos {},
+      m_head(size_t(1) << HASH_BITS), m_prev(WINDOW), m_out {}, m_bits {}, m_count {},
+      m_adler { 1 }
+  {
+    if (level < 0 || level > 9)
+      throw std::invalid_argument { "compression level must be within 0 and 9" };
+
+    const uint32_t method { 0x78 };
+    const uint32_t speed { level < 2 ? 0U : level < 6 ? 1U : level == 6 ? 2U : 3U };
+    const uint32_t flags { speed << 6 | (31 - (method << 8 | speed << 6) % 31) % 31 };
+    m_out += char(method);
+    m_out += char(flags);
+  }
+
+  void deflater::write(const uint8_t *src, const size_t count)
+  {
+    m_adler = adler32(m_adler, src, count);
+    m_input.insert(m_input.end(), src, src + count);
+    while (m_offset + m_input.size() - m_pos >= BLOCK + MAX_MATCH)
+      compress(m_pos + BLOCK, false);
+  }
+
+  std::string &deflater::output() noexcept
+  {
+    return m_out;
+  }
+
+  void deflater::finish()
+  {
+    compress(m_offset + m_input.size(), true);
+    align();
+    for (int shift { 24 }; shift >= 0; shift -= 8) m_out += char(m_adler >> shift & 0xFF);
+  }
+
+  void deflater::put(const uint32_t value, const int count)
+  {
+    m_bits |= uint64_t(value) << m_count;
+    if ((m_count += count) >= 32) {
+      for (int i { 0 }; i < 4; ++i, m_bits >>= 8) m_out += char(m_bits & 0xFF);
+      m_count -= 32;
+    }
+  }
+
+  void deflater::align()
+  {
+    for (; m_count > 0; m_count -= 8, m_bits >>= 8) m_out += char(m_bits & 0xFF);
+    m_count = 0;
+    m_bits = 0;
+  }
+
+  // lz77 over [m_pos, end) then a block of whichever encoding is the smallest
+  void deflater::compress(const size_t end, const bool last)
+  {
+    const size_t available { m_offset + m_input.size() }, begin { m_pos };
+    const uint8_t *const input { m_input.data() };
+    const auto at = [input, this](const size_t pos) { return input + (pos - m_offset); };
+
+    // literals below 256, matches as 1 << 31 | (length - 3) << 16 | distance
+    std::vector<uint32_t> tokens;
+    std::array<uint32_t, 286> literal_freqs {};
+    std::array<uint32_t, 30> distance_freqs {};
+    const auto literal = [&](const size_t pos) {
+      tokens.push_back(*at(pos));
+      ++literal_freqs[*at(pos)];
+    };
+    const auto match = [&](const size_t length, const size_t distance) {
+      tokens.push_back(
+        uint32_t(1) << 31 | uint32_t(length - MIN_MATCH) << 16 | uint32_t(distance));
+      ++literal_freqs[257 + LENGTH_CODE[length]];
+      ++distance_freqs[distance_code(distance)];
+    };
+    const auto insert = [&](const size_t pos) {
+      if (pos + MIN_MATCH > available) return;
+      uint32_t &head { m_head[hash3(at(pos))] };
+      m_prev[pos & (WINDOW - 1)] = head;
+      head = uint32_t(pos - m_offset + 1);
+    };
+
+    const effort &e { LEVELS[m_level] };
+    // longest match at `pos` beyond `shortest` bytes, as (length, distance)
+    const auto longest = [&](const size_t pos,
+                           const size_t shortest) -> std::pair<size_t, size_t> {
+      if (pos + MIN_MATCH > available) return { 0, 0 };
+      uint32_t &head { m_head[hash3(at(pos))] };
+      uint32_t chain { head };
+      m_prev[pos & (WINDOW - 1)] = chain;
+      head = uint32_t(pos - m_offset + 1);
+
+      const size_t limit { std::min(MAX_MATCH, available - pos) };
+      const uint8_t *cur { at(pos) };
+      size_t best { std::max(shortest, MIN_MATCH - 1) }, distance { 0 };
+      for (int steps { e.chain }; chain && steps-- && best < limit;) {
+        const size_t candidate { m_offset + chain - 1 };
+        if (pos - candidate >= WINDOW) break;
+        const uint8_t *ref { at(candidate) };
+        if (ref[best] == cur[best] && ref[0] == cur[0] && ref[1] == cur[1]) {
+          size_t length { 2 };
+          while (length < limit && ref[length] == cur[length]) ++length;
+          if (length > best) {
+            best = length;
+            distance = pos - candidate;
+            if (length >= e.nice) break;
+          }
+        }
+        const uint32_t next { m_prev[candidate & (WINDOW - 1)] };
+        if (next >= chain) break;
+        chain = next;
+      }
+      return { distance ? best : 0, distance };
+    };
+
+    size_t pos { begin };
+    if (m_level > 0) {
+      // a pending match found at pos - 1 is emitted unless pos starts a longer one
+      size_t pending_length { 0 }, pending_distance { 0 };
+      bool pending { false };
+      while (pos < end) {
+        const auto [length, distance] { longest(pos, pending ? pending_length : 0) };
+        if (pending) {
+          if (pending_length >= MIN_MATCH && length <= pending_length) {
+            match(pending_length, pending_distance);
+            for (size_t k { pos + 1 }; k < pos - 1 + pending_length; ++k) insert(k);
+            pos += pending_length - 1;
+            pending = false;
+            continue;
+          }
+          literal(pos - 1);
+          pending = false;
+        }
+        if (length >= MIN_MATCH && (!e.lazy || length >= e.nice)) {
+          match(length, distance);
+          for (size_t k { pos + 1 }; k < pos + length; ++k) insert(k);
+          pos += length;
+        } else if (e.lazy) {
+          pending = true;
+          pending_length = length;
+          pending_distance = distance;
+          ++pos;
+        } else {
+          literal(pos++);
+        }
+      }
+      if (pending) {
+        if (pending_length >= MIN_MATCH) {
+          match(pending_length, pending_distance);
+          for (size_t k { pos }; k < pos - 1 + pending_length; ++k) insert(k);
+          pos += pending_length - 1;
+        } else {
+          literal(pos - 1);
+        }
+      }
+    }
+    pos = std::max(pos, end);
+    ++literal_freqs[256];
+
+    // extra bits of lengths and distances, the same under every code
+    uint64_t extra { 0 };
+    for (int code { 0 }; code < 29; ++code)
+      extra += uint64_t(literal_freqs[257 + code]) * LENGTH_EXTRA[code];
+    for (int code { 0 }; code < 30; ++code)
+      extra += uint64_t(distance_freqs[code]) * DISTANCE_EXTRA[code];
+
+    std::array<uint8_t, 286> literal_lengths;
+    std::array<uint8_t, 30> distance_lengths;
+    std::array<uint32_t, 30> used_distances { distance_freqs };
+    const auto unused = [](const uint32_t f) { return !f; };
+    if (std::all_of(used_distances.begin(), used_distances.end(), unused))
+      used_distances[0] = 1;
+    limited_lengths(literal_freqs.data(), 286, 15, literal_lengths.data());
+    limited_lengths(used_distances.data(), 30, 15, distance_lengths.data());
+
+    // code lengths of both alphabets, run length encoded as (symbol, extra bits, count)
+    int literal_count { 286 }, distance_count { 30 };
+    while (literal_count > 257 && !literal_lengths[literal_count - 1]) --literal_count;
+    while (distance_count > 1 && !distance_lengths[distance_count - 1]) --distance_count;
+    std::array<uint8_t, 316> all {};
+    std::copy_n(literal_lengths.begin(), literal_count, all.begin());
+    std::copy_n(distance_lengths.begin(), distance_count, all.begin() + literal_count);
+    const int total { literal_count + distance_count };
+
+    std::vector<std::array<uint8_t, 3>> runs;
+    std::array<uint32_t, 19> code_freqs {};
+    const auto run = [&](const int symbol, const int value, const int count) {
+      runs.push_back({ uint8_t(symbol), uint8_t(value), uint8_t(count) });
+      ++code_freqs[symbol];
+    };
+    for (int i { 0 }; i < total;) {
+      const uint8_t value { all[i] };
+      int repeat { 1 };
+      while (i + repeat < total && all[i + repeat] == value) ++repeat;
+      i += repeat;
+      if (value == 0) {
+        for (; repeat >= 11; repeat -= std::min(repeat, 138))
+          run(18, std::min(repeat, 138) - 11, 7);
+        if (repeat >= 3) run(17, repeat - 3, 3), repeat = 0;
+      } else {
+        run(value, 0, 0);
+        for (--repeat; repeat >= 3; repeat -= std::min(repeat, 6))
+          run(16, std::min(repeat, 6) - 3, 2);
+      }
+      for (; repeat > 0; --repeat) run(value, 0, 0);
+    }
+    std::array<uint8_t, 19> code_lengths;
+    limited_lengths(code_freqs.data(), 19, 7, code_lengths.data());
+    int codes_count { 19 };
+    while (codes_count > 4 && !code_lengths[CODE_ORDER[codes_count - 1]]) --codes_count;
+
+    uint64_t dynamic_bits { 17 + 3 * uint64_t(codes_count) + extra };
+    for (const auto &r : runs) dynamic_bits += code_lengths[r[0]] + r[2];
+    uint64_t fixed_bits { 3 + extra };
+    for (int s { 0 }; s < 286; ++s) {
+      dynamic_bits += uint64_t(literal_freqs[s]) * literal_lengths[s];
+      const int fixed_length { s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8 };
+      fixed_bits += uint64_t(literal_freqs[s]) * uint64_t(fixed_length);
+    }
+    for (int s { 0 }; s < 30; ++s) {
+      dynamic_bits += uint64_t(distance_freqs[s]) * distance_lengths[s];
+      fixed_bits += uint64_t(distance_freqs[s]) * 5;
+    }
+    const size_t size { pos - begin };
+    const uint64_t stored_bits { 8 * uint64_t(size) + 40 * (size / 65535 + 1) + 7 };
+
+    if (m_level == 0 || (stored_bits <= fixed_bits && stored_bits <= dynamic_bits)) {
+      size_t start { begin };
+      do {
+        const size_t length { std::min<size_t>(pos - start, 65535) };
+        put(last && start + length == pos, 1);
+        put(0, 2);
+        align();
+        for (const uint32_t field : { uint32_t(length), uint32_t(~length & 0xFFFF) }) {
+          m_out += char(field & 0xFF);
+          m_out += char(field >> 8);
+        }
+        m_out.append(reinterpret_cast<const char *>(at(start)), length);
+        start += length;
+      } while (start < pos);
+    } else {
+      std::array<uint16_t, 286> literal_codes {};
+      std::array<uint16_t, 30> distance_codes {};
+      put(last, 1);
+      if (fixed_bits <= dynamic_bits) {
+        put(1, 2);
+        for (int s { 0 }; s < 286; ++s)
+          literal_lengths[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
+        distance_lengths.fill(5);
+      } else {
+        put(2, 2);
+        put(uint32_t(literal_count - 257), 5);
+        put(uint32_t(distance_count - 1), 5);
+        put(uint32_t(codes_count - 4), 4);
+        for (int i { -1 }; ++i < codes_count;) put(code_lengths[CODE_ORDER[i]], 3);
+        std::array<uint16_t, 19> length_codes {};
+        assign_codes(code_lengths.data(), 19, length_codes.data());
+        for (const auto &r : runs) {
+          put(length_codes[r[0]], code_lengths[r[0]]);
+          if (r[2]) put(r[1], r[2]);
+        }
+      }
+      assign_codes(literal_lengths.data(), 286, literal_codes.data());
+      assign_codes(distance_lengths.data(), 30, distance_codes.data());
+
+      for (const uint32_t token : tokens) {
+        if (!(token >> 31)) {
+          put(literal_codes[token], literal_lengths[token]);
+          continue;
+        }
+        const size_t length { (token >> 16 & 0xFF) + MIN_MATCH };
+        const size_t distance { token & 0xFFFF };
+        const int lcode { LENGTH_CODE[length] }, dcode { distance_code(distance) };
+        put(literal_codes[257 + lcode], literal_lengths[257 + lcode]);
+        put(uint32_t(length - LENGTH_BASE[lcode]), LENGTH_EXTRA[lcode]);
+        put(distance_codes[dcode], distance_lengths[dcode]);
+        put(uint32_t(distance - DISTANCE_BASE[dcode]), DISTANCE_EXTRA[dcode]);
+      }
+      put(literal_codes[256], literal_lengths[256]);
+    }
+
+    // drops the input beyond the reach of later matches, chains hold positions past the
+    // first byte kept plus one
+    m_pos = pos;
+    if (m_pos - m_offset > WINDOW + BLOCK) {
+      const size_t drop { m_pos - WINDOW - m_offset };
+      m_input.erase(m_input.begin(), m_input.begin() + ptrdiff_t(drop));
+      m_offset += drop;
+      for (auto *chains : { &m_head, &m_prev })
+        for (uint32_t &entry : *chains) entry = entry > drop ? uint32_t(entry - drop) : 0;
+    }
+  }
+
+}  // namespace covdel::ma::detail
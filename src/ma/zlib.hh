@@ -0,0 +1,101 @@
+#ifndef __COVDEL_SRC_MA_ZLIB_HH_1701389214__
+#define __COVDEL_SRC_MA_ZLIB_HH_1701389214__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace covdel::ma::detail
+{
+  using std::size_t;
+
+  // streaming decoder of a zlib stream split over pieces, such as the IDAT chunks of a
+  // png, which decompresses no further than asked into a window of its own, so that
+  // callers take rows straight out of it, throws std::invalid_argument on corrupt streams
+  class inflater {
+  public:
+    // `largest` is the longest run of bytes ever asked for at once, `raw` streams are
+    // bare deflate data without the zlib header and checksum, as the members of zip
+    // archives, which carry a crc32 of their own
+    inflater(std::vector<std::pair<const char *, size_t>> pieces, size_t largest,
+      bool raw = false);
+
+    // next `count` bytes of the stream, valid until the next call
+    const std::uint8_t *next(size_t count);
+
+    // checks that the stream ends here and matches its checksum
+    void finish();
+
+  private:
+    struct table {
+      void build(const std::uint8_t *lengths, int count);
+      int decode(inflater &in);
+
+      // symbol << 4 | length of the codes of up to FAST_BITS bits, read lsb first
+      std::uint16_t fast[1 << 10];
+      std::uint16_t counts[16], symbols[288];
+    };
+
+    enum class state { header, stored, huffman, done };
+
+    std::vector<std::pair<const char *, size_t>> m_pieces;
+    size_t m_piece, m_pos;
+    std::uint64_t m_bits;
+    int m_count, m_padding;
+
+    std::vector<std::uint8_t> m_window;
+    size_t m_read, m_end;
+    state m_state;
+    bool m_raw, m_last;
+    size_t m_stored;
+    table m_lengths, m_distances;
+    std::uint32_t m_adler;
+
+    void reserve(size_t count) noexcept;
+    void refill() noexcept;
+    std::uint32_t peek(int count) noexcept;
+    void consume(int count);
+    std::uint32_t bits(int count);
+    void block_header();
+    void dynamic_tables();
+    void produce(size_t limit);
+  };
+
+  // zlib stream encoder, at levels from 0 for stored blocks to 9 for the slowest search,
+  // compressing whenever a block of input is pending and keeping the last 32KiB of input
+  class deflater {
+  public:
+    explicit deflater(int level);
+
+    void write(const std::uint8_t *src, size_t count);
+
+    // compressed bytes so far, which the caller takes and clears
+    std::string &output() noexcept;
+
+    // compresses the remaining input and appends the checksum
+    void finish();
+
+  private:
+    int m_level;
+    std::vector<std::uint8_t> m_input;
+    size_t m_offset, m_pos;
+    std::vector<std::uint32_t> m_head, m_prev;
+    std::string m_out;
+    std::uint64_t m_bits;
+    int m_count;
+    std::uint32_t m_adler;
+
+    void put(std::uint32_t value, int count);
+    void align();
+    void compress(size_t end, bool last);
+  };
+
+  // adler32 checksum of zlib streams, continuing from `adler`, 1 to start
+  std::uint32_t adler32(std::uint32_t adler, const std::uint8_t *bytes,
+    size_t length) noexcept;
+
+}  // namespace covdel::ma::detail
+
+#endif
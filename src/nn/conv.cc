@@ -0,0 +1,1131 @@
+#include "covdel/nn/conv.hh"
+
+#include "conv_kernels.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/simd.hh"
+#include "ma/cache.hh"
+#include "ma/parallel.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace covdel::nn
+{
+  const detail::conv_table &detail::convolutions() noexcept
+  {
+    static const auto s_tables { [] {
+      std::array<conv_table, 4> tables {};
+      scalar::fill(tables[int(ma::isa::scalar)]);
+#ifdef COVDEL_X86_KERNELS
+      sse2::fill(tables[int(ma::isa::sse2)]);
+      avx2::fill(tables[int(ma::isa::avx2)]);
+      avx512::fill(tables[int(ma::isa::avx512)]);
+#endif
+      return tables;
+    }() };
+    return s_tables[int(ma::active_isa())];
+  }
+
+  namespace
+  {
+    using std::ptrdiff_t;
+    using std::size_t;
+    using ma::dimension;
+    using ma::stride;
+
+    // bound of the temporaries of a pass over a part of the batch, larger passes only
+    // grow the workspace without speeding up their products
+    constexpr size_t BUDGET { size_t(16) << 20 };
+
+    // lanes of the winograd transforms at once, which stay in the L1 cache
+    constexpr size_t LANES { 64 };
+
+    // cost of moving a gathered or transformed value through memory, written once and
+    // read back by a product, in multiply-adds of gemm
+    constexpr double MOVE { 8 };
+
+    // shapes of a convolution, pairs along (height, width)
+    struct geometry {
+      size_t batch, channels, height, width;
+      size_t filters, kh, kw;
+      size_t out_h, out_w;
+      size_t sh, sw, ph, pw, dh, dw;
+      size_t groups;
+      layout format;
+
+      size_t group_channels() const noexcept { return channels / groups; }
+      size_t group_filters() const noexcept { return filters / groups; }
+      size_t depth() const noexcept { return group_channels() * kh * kw; }
+      size_t pixels() const noexcept { return out_h * out_w; }
+      size_t tiles_h() const noexcept { return (out_h + 1) / 2; }
+      size_t tiles_w() const noexcept { return (out_w + 1) / 2; }
+      bool nhwc() const noexcept { return format == layout::nhwc; }
+
+      auto fields() const noexcept
+      {
+        return std::tie(batch, channels, height, width, filters, kh, kw, sh, sw, ph, pw,
+          dh, dw, groups, format);
+      }
+      bool operator==(const geometry &rhs) const noexcept
+      {
+        return fields() == rhs.fields();
+      }
+    };
+
+    geometry validate(const dimension &input, const dimension &weight,
+      const conv2d_params &params)
+    {
+      if (input.ndims() != 4 || weight.ndims() != 4)
+        throw std::invalid_argument { "convolutions need 4-d inputs and weights" };
+
+      geometry g {};
+      g.format   = params.format;
+      g.batch    = input[0];
+      g.channels = input[g.nhwc() ? 3 : 1];
+      g.height   = input[g.nhwc() ? 1 : 2];
+      g.width    = input[g.nhwc() ? 2 : 3];
+      g.filters  = weight[0];
+      g.kh       = weight[2];
+      g.kw       = weight[3];
+      g.groups   = params.groups;
+      std::tie(g.sh, g.sw) = std::pair { params.stride[0], params.stride[1] };
+      std::tie(g.ph, g.pw) = std::pair { params.padding[0], params.padding[1] };
+      std::tie(g.dh, g.dw) = std::pair { params.dilation[0], params.dilation[1] };
+
+      if (!g.channels || !g.filters || !g.kh || !g.kw)
+        throw std::invalid_argument { "convolutions need channels, filters and kernels" };
+      if (!g.groups || g.channels % g.groups || g.filters % g.groups)
+        throw std::invalid_argument { "groups must divide the channels and filters" };
+      if (weight[1] != g.group_channels())
+        throw std::invalid_argument { "weights must span the channels of one group" };
+      if (!g.sh || !g.sw || !g.dh || !g.dw)
+        throw std::invalid_argument { "strides and dilations must be positive" };
+
+      const size_t span_h { g.dh * (g.kh - 1) + 1 }, span_w { g.dw * (g.kw - 1) + 1 };
+      if (span_h > g.height + 2 * g.ph || span_w > g.width + 2 * g.pw)
+        throw std::invalid_argument {
+          "dilated kernels must fit within the padded input"
+        };
+      g.out_h = (g.height + 2 * g.ph - span_h) / g.sh + 1;
+      g.out_w = (g.width + 2 * g.pw - span_w) / g.sw + 1;
+      return g;
+    }
+
+    dimension shape(const geometry &g)
+    {
+      return g.nhwc() ? dimension(g.batch, g.out_h, g.out_w, g.filters)
+                      : dimension(g.batch, g.filters, g.out_h, g.out_w);
+    }
+
+    ////////////////////////////////////// PLANS ////////////////////////////////////////
+
+    bool pointwise(const geometry &g) noexcept
+    {
+      return g.kh == 1 && g.kw == 1 && g.sh == 1 && g.sw == 1 && !g.ph && !g.pw;
+    }
+
+    bool depthwise(const geometry &g) noexcept
+    {
+      return g.group_channels() == 1;
+    }
+
+    bool winograd_fits(const geometry &g) noexcept
+    {
+      return g.kh == 3 && g.kw == 3 && g.sh == 1 && g.sw == 1 && g.dh == 1 && g.dw == 1
+             && g.groups == 1;
+    }
+
+    // multiply-adds of both products and the values their operands move through memory,
+    // winograd trading 9 products per output for 4 against transforms on both sides
+    bool prefer_winograd(const geometry &g) noexcept
+    {
+      const double c { double(g.channels) }, m { double(g.filters) };
+      const double pixels { double(g.batch * g.pixels()) };
+      const double tiles { double(g.batch * g.tiles_h() * g.tiles_w()) };
+      const double im2col { 9 * c * m * pixels + MOVE * 9 * c * pixels };
+      const double winograd { 16 * c * m * tiles + MOVE * 16 * (c + m) * tiles
+                              + MOVE * 16 * c * m };
+      return winograd < im2col;
+    }
+
+    struct plan {
+      conv_algorithm algorithm;
+      size_t chunk;  // images, or rows of winograd tiles, per pass
+    };
+
+    plan compute(const geometry &g, const conv_algorithm requested)
+    {
+      auto algorithm { requested };
+      if (algorithm == conv_algorithm::automatic)
+        algorithm = pointwise(g) || depthwise(g)        ? conv_algorithm::direct
+                    : winograd_fits(g) && prefer_winograd(g) ? conv_algorithm::winograd
+                                                             : conv_algorithm::im2col;
+      if (algorithm == conv_algorithm::direct && !pointwise(g) && !depthwise(g))
+        throw std::invalid_argument {
+          "direct convolutions need 1x1 kernels of stride 1 without padding, "
+          "or depthwise ones"
+        };
+      if (algorithm == conv_algorithm::winograd && !winograd_fits(g))
+        throw std::invalid_argument {
+          "winograd convolutions need 3x3 kernels of stride and dilation 1 and one group"
+        };
+
+      size_t chunk { 1 };
+      if (algorithm == conv_algorithm::im2col) {
+        const size_t bytes { g.depth() * g.pixels() * sizeof(float) };
+        chunk = std::clamp<size_t>(
+          BUDGET / std::max<size_t>(bytes, 1), 1, std::max<size_t>(g.batch, 1));
+      } else if (algorithm == conv_algorithm::winograd) {
+        const size_t bytes { 16 * g.tiles_w() * (g.channels + g.filters)
+                             * sizeof(float) };
+        chunk = std::clamp<size_t>(
+          BUDGET / bytes, 1, std::max<size_t>(g.batch * g.tiles_h(), 1));
+      }
+      return { algorithm, chunk };
+    }
+
+    // plans of the most recently used shapes
+    plan plan_of(const geometry &g, const conv_algorithm requested)
+    {
+      static ma::detail::mru_cache<std::pair<geometry, conv_algorithm>, plan, 32> s_plans;
+      return s_plans.get({ g, requested }, [&] { return compute(g, requested); });
+    }
+
+    ///////////////////////////////////// HELPERS ///////////////////////////////////////
+
+    // view over memory of the workspace or of a contiguous operand
+    template<typename _Type>
+    auto view(const _Type *data, const dimension &dim, const stride &strides)
+    {
+      using dtype = std::conditional_t<std::is_same_v<_Type, float>, ma::dtype::float32,
+        std::conditional_t<std::is_same_v<_Type, std::int8_t>, ma::dtype::int8,
+          ma::dtype::uint8>>;
+      return ma::multiarray<dtype> { const_cast<_Type *>(data), dim, strides, nullptr };
+    }
+
+    // tasks per range of the default executor, for tasks touching `bytes` each
+    size_t grain(const size_t bytes) noexcept
+    {
+      return std::max<size_t>(ma::grain_size() / std::max<size_t>(bytes, 1), 1);
+    }
+
+    // 64 byte aligned parts of the workspace, in order
+    struct carver {
+      char *next;
+
+      template<typename _Type>
+      _Type *take(const size_t count) noexcept
+      {
+        auto *out { reinterpret_cast<_Type *>(next) };
+        next += (count * sizeof(_Type) + 63) / 64 * 64;
+        return out;
+      }
+    };
+
+    template<typename _ADType, typename _BDType>
+    bool overlaps(
+      const ma::multiarray<_ADType> &a, const ma::multiarray<_BDType> &b) noexcept
+    {
+      if (!a.size() || !b.size()) return false;
+      const auto [a_first, a_last] { ma::detail::footprint(a) };
+      const auto [b_first, b_last] { ma::detail::footprint(b) };
+      return !(a_last < b_first || b_last < a_first);
+    }
+
+    // operands are read as contiguous arrays, copied when they overlap the output
+    template<typename _DType, typename _ODType>
+    ma::multiarray<_DType> operand(const ma::multiarray<_DType> &a,
+      const ma::multiarray<_ODType> &out)
+    {
+      return overlaps(a, out) ? a.copy() : a.ascontiguous();
+    }
+
+    template<typename _DType>
+    void copy_into(const ma::multiarray<_DType> &src, ma::multiarray<_DType> &dst)
+    {
+      using native_type = typename ma::multiarray<_DType>::native_type;
+      ma::detail::parallel_runs(
+        dst.dim(),
+        [](const native_type *s, native_type *d, ptrdiff_t ss, ptrdiff_t ds,
+          size_t count) {
+          for (size_t i { 0 }; i < count; ++i)
+            d[ptrdiff_t(i) * ds] = s[ptrdiff_t(i) * ss];
+        },
+        ma::detail::operand { src.data(), src.strides() },
+        ma::detail::operand { dst.data(), dst.strides() });
+    }
+
+    // [first, last) of the outputs along an axis whose tap at `shift`, its offset less
+    // the padding, reads within [0, size)
+    std::pair<size_t, size_t> valid(const size_t outputs, const size_t size,
+      const size_t step, const ptrdiff_t shift) noexcept
+    {
+      const ptrdiff_t s { ptrdiff_t(step) }, n { ptrdiff_t(size) };
+      const size_t first { shift >= 0 ? 0 : size_t((s - 1 - shift) / s) };
+      const size_t last { n > shift ? std::min(outputs, size_t((n - shift - 1) / s + 1))
+                                    : 0 };
+      return { std::min(first, last), last };
+    }
+
+    // weights of shape (filters, channels, kh, kw) reordered to (filters, kh, kw,
+    // channels), the order in which im2col gathers the channels of nhwc pixels
+    template<typename _Type>
+    void channels_last(const _Type *w, const geometry &g, _Type *out)
+    {
+      const size_t cg { g.group_channels() }, taps { g.kh * g.kw };
+      for (size_t f { 0 }; f < g.filters; ++f)
+        for (size_t c { 0 }; c < cg; ++c)
+          for (size_t t { 0 }; t < taps; ++t)
+            out[(f * taps + t) * cg + c] = w[(f * cg + c) * taps + t];
+    }
+
+    // outputs of a convolution with a bias start from it, and products are added on
+    void initialize(float *y, const float *bias, const geometry &g)
+    {
+      const size_t filters { g.filters }, pixels { g.pixels() };
+      if (g.nhwc())
+        ma::detail::parallel_for(g.batch * pixels, grain(filters * sizeof(float)),
+          [=](const size_t begin, const size_t end) {
+            for (size_t p { begin }; p < end; ++p)
+              std::copy_n(bias, filters, y + p * filters);
+          });
+      else
+        ma::detail::parallel_for(g.batch * filters, grain(pixels * sizeof(float)),
+          [=](const size_t begin, const size_t end) {
+            for (size_t t { begin }; t < end; ++t)
+              std::fill_n(y + t * pixels, pixels, bias[t % filters]);
+          });
+    }
+
+    ///////////////////////////////////// IM2COL ////////////////////////////////////////
+
+    // rows of the columns of one channel plane of an nchw image, element (k, p) of the
+    // columns being at cols[k * k_step + p * p_step], for k over the taps of the channel
+    template<typename _Type>
+    void columns_nchw(const _Type *plane, const geometry &g, const _Type pad, _Type *cols,
+      const ptrdiff_t k_step, const ptrdiff_t p_step)
+    {
+      for (size_t ky { 0 }; ky < g.kh; ++ky)
+        for (size_t kx { 0 }; kx < g.kw; ++kx) {
+          _Type *row { cols + ptrdiff_t(ky * g.kw + kx) * k_step };
+          const ptrdiff_t sy { ptrdiff_t(ky * g.dh) - ptrdiff_t(g.ph) };
+          const ptrdiff_t sx { ptrdiff_t(kx * g.dw) - ptrdiff_t(g.pw) };
+          const auto [x0, x1] { valid(g.out_w, g.width, g.sw, sx) };
+          for (size_t oy { 0 }; oy < g.out_h; ++oy) {
+            _Type *dst { row + ptrdiff_t(oy * g.out_w) * p_step };
+            const ptrdiff_t iy { ptrdiff_t(oy * g.sh) + sy };
+            if (iy < 0 || iy >= ptrdiff_t(g.height)) {
+              for (size_t ox { 0 }; ox < g.out_w; ++ox) dst[ptrdiff_t(ox) * p_step] = pad;
+              continue;
+            }
+            const _Type *src { plane + iy * ptrdiff_t(g.width) };
+            for (size_t ox { 0 }; ox < x0; ++ox) dst[ptrdiff_t(ox) * p_step] = pad;
+            if (p_step == 1 && g.sw == 1)
+              std::copy(src + (ptrdiff_t(x0) + sx), src + (ptrdiff_t(x1) + sx), dst + x0);
+            else
+              for (size_t ox { x0 }; ox < x1; ++ox)
+                dst[ptrdiff_t(ox) * p_step] = src[ptrdiff_t(ox * g.sw) + sx];
+            for (size_t ox { x1 }; ox < g.out_w; ++ox) dst[ptrdiff_t(ox) * p_step] = pad;
+          }
+        }
+    }
+
+    // columns of one output row of an nhwc image, whose channels start at those of the
+    // group, element (k, p) being at cols[p * p_step + k] for k over (ky, kx, channel)
+    template<typename _Type>
+    void columns_nhwc(const _Type *image, const geometry &g, const size_t oy,
+      const _Type pad, _Type *cols, const ptrdiff_t p_step)
+    {
+      const size_t cg { g.group_channels() };
+      for (size_t ox { 0 }; ox < g.out_w; ++ox) {
+        _Type *dst { cols + ptrdiff_t(ox) * p_step };
+        for (size_t ky { 0 }; ky < g.kh; ++ky) {
+          const ptrdiff_t iy { ptrdiff_t(oy * g.sh + ky * g.dh) - ptrdiff_t(g.ph) };
+          for (size_t kx { 0 }; kx < g.kw; ++kx, dst += cg) {
+            const ptrdiff_t ix { ptrdiff_t(ox * g.sw + kx * g.dw) - ptrdiff_t(g.pw) };
+            if (iy < 0 || iy >= ptrdiff_t(g.height) || ix < 0 || ix >= ptrdiff_t(g.width))
+              std::fill_n(dst, cg, pad);
+            else
+              std::copy_n(
+                image + (size_t(iy) * g.width + size_t(ix)) * g.channels, cg, dst);
+          }
+        }
+      }
+    }
+
+    // gathers the columns of images [n0, n0 + count) for a group, as (count, depth,
+    // pixels) for nchw images and (count * pixels, depth) for nhwc ones, or the latter
+    // for both when `rows`
+    template<typename _Type>
+    void gather(const _Type *in, const geometry &g, const size_t group, const size_t n0,
+      const size_t count, const _Type pad, _Type *cols, const bool rows)
+    {
+      const size_t cg { g.group_channels() }, depth { g.depth() }, pixels { g.pixels() };
+      const size_t plane { g.height * g.width }, taps { g.kh * g.kw };
+      if (g.nhwc())
+        ma::detail::parallel_for(count * g.out_h, grain(g.out_w * depth * sizeof(_Type)),
+          [&](const size_t begin, const size_t end) {
+            for (size_t t { begin }; t < end; ++t) {
+              const size_t n { n0 + t / g.out_h }, oy { t % g.out_h };
+              columns_nhwc(in + n * plane * g.channels + group * cg, g, oy, pad,
+                cols + t * g.out_w * depth, ptrdiff_t(depth));
+            }
+          });
+      else
+        ma::detail::parallel_for(count * cg, grain(taps * pixels * sizeof(_Type)),
+          [&](const size_t begin, const size_t end) {
+            for (size_t t { begin }; t < end; ++t) {
+              const size_t n { n0 + t / cg }, c { t % cg };
+              const _Type *source { in + (n * g.channels + group * cg + c) * plane };
+              _Type *image { cols + (t / cg) * depth * pixels };
+              if (rows)
+                columns_nchw(source, g, pad, image + c * taps, 1, ptrdiff_t(depth));
+              else
+                columns_nchw(
+                  source, g, pad, image + c * taps * pixels, ptrdiff_t(pixels), 1);
+            }
+          });
+    }
+
+    void run_im2col(const float *in, const float *w, const float *bias, float *y,
+      const geometry &g, const plan &p, workspace &ws)
+    {
+      const size_t mg { g.group_filters() };
+      const size_t depth { g.depth() }, pixels { g.pixels() }, filters { g.filters };
+      const auto K { ptrdiff_t(depth) }, P { ptrdiff_t(pixels) },
+        M { ptrdiff_t(filters) };
+
+      const size_t floats { p.chunk * depth * pixels + (g.nhwc() ? filters * depth : 0) };
+      carver parts { static_cast<char *>(ws.reserve(floats * sizeof(float) + 128)) };
+      auto *cols { parts.take<float>(p.chunk * depth * pixels) };
+      if (g.nhwc()) {
+        auto *reordered { parts.take<float>(filters * depth) };
+        channels_last(w, g, reordered);
+        w = reordered;
+      }
+
+      if (bias) initialize(y, bias, g);
+      const float beta { bias ? 1.F : 0.F };
+      for (size_t n0 { 0 }; n0 < g.batch; n0 += p.chunk) {
+        const size_t count { std::min(p.chunk, g.batch - n0) };
+        for (size_t group { 0 }; group < g.groups; ++group) {
+          gather(in, g, group, n0, count, 0.F, cols, false);
+          auto weights {
+            view(w + group * mg * depth, dimension(mg, depth), stride(K, 1))
+          };
+          if (g.nhwc()) {
+            auto a { view(cols, dimension(count * pixels, depth), stride(K, 1)) };
+            auto c { view(y + n0 * pixels * filters + group * mg,
+              dimension(count * pixels, mg), stride(M, 1)) };
+            ma::gemm(a, weights, c, 1.F, beta, false, true);
+          } else {
+            auto b { view(cols, dimension(count, depth, pixels), stride(K * P, P, 1)) };
+            auto c { view(y + (n0 * filters + group * mg) * pixels,
+              dimension(count, mg, pixels), stride(M * P, P, 1)) };
+            ma::gemm(weights, b, c, 1.F, beta);
+          }
+        }
+      }
+    }
+
+    ///////////////////////////////////// DIRECT ////////////////////////////////////////
+
+    // 1x1 kernels of stride 1 are products of the weights with the images as they are
+    void run_pointwise(const float *in, const float *w, const float *bias, float *y,
+      const geometry &g)
+    {
+      const size_t cg { g.group_channels() }, mg { g.group_filters() },
+        pixels { g.pixels() };
+      const auto C { ptrdiff_t(g.channels) }, M { ptrdiff_t(g.filters) },
+        P { ptrdiff_t(pixels) };
+      if (bias) initialize(y, bias, g);
+      const float beta { bias ? 1.F : 0.F };
+      for (size_t group { 0 }; group < g.groups; ++group) {
+        auto weights {
+          view(w + group * mg * cg, dimension(mg, cg), stride(ptrdiff_t(cg), 1))
+        };
+        if (g.nhwc()) {
+          auto a { view(in + group * cg, dimension(g.batch * pixels, cg), stride(C, 1)) };
+          auto c { view(y + group * mg, dimension(g.batch * pixels, mg), stride(M, 1)) };
+          ma::gemm(a, weights, c, 1.F, beta, false, true);
+        } else {
+          auto b { view(in + group * cg * pixels, dimension(g.batch, cg, pixels),
+            stride(C * P, P, 1)) };
+          auto c { view(y + group * mg * pixels, dimension(g.batch, mg, pixels),
+            stride(M * P, P, 1)) };
+          ma::gemm(weights, b, c, 1.F, beta);
+        }
+      }
+    }
+
+    // depthwise filters slide over their channel, each of `mg` filters of a group adding
+    // its taps onto output rows which stay in the L1 cache
+    void run_depthwise(const float *in, const float *w, const float *bias, float *y,
+      const geometry &g, workspace &ws)
+    {
+      const auto &kernels { detail::convolutions() };
+      const size_t mg { g.group_filters() }, taps { g.kh * g.kw }, filters { g.filters };
+      const size_t plane { g.height * g.width }, pixels { g.pixels() };
+
+      if (!g.nhwc()) {
+        ma::detail::parallel_for(g.batch * filters, grain(pixels * taps * sizeof(float)),
+          [&](const size_t begin, const size_t end) {
+            for (size_t t { begin }; t < end; ++t) {
+              const size_t n { t / filters }, f { t % filters };
+              const float *source { in + (n * g.channels + f / mg) * plane };
+              const float *k { w + f * taps };
+              for (size_t oy { 0 }; oy < g.out_h; ++oy) {
+                float *row { y + t * pixels + oy * g.out_w };
+                std::fill_n(row, g.out_w, bias ? bias[f] : 0.F);
+                for (size_t ky { 0 }; ky < g.kh; ++ky) {
+                  const ptrdiff_t iy { ptrdiff_t(oy * g.sh + ky * g.dh)
+                                       - ptrdiff_t(g.ph) };
+                  if (iy < 0 || iy >= ptrdiff_t(g.height)) continue;
+                  const float *line { source + size_t(iy) * g.width };
+                  for (size_t kx { 0 }; kx < g.kw; ++kx) {
+                    const ptrdiff_t sx { ptrdiff_t(kx * g.dw) - ptrdiff_t(g.pw) };
+                    const auto [x0, x1] { valid(g.out_w, g.width, g.sw, sx) };
+                    if (x0 < x1)
+                      kernels.madd(line + size_t(ptrdiff_t(x0 * g.sw) + sx),
+                        ptrdiff_t(g.sw), k[ky * g.kw + kx], row + x0, x1 - x0);
+                  }
+                }
+              }
+            }
+          });
+        return;
+      }
+
+      // taps of all filters are laid out along the channels, (kh, kw, filters)
+      auto *k { static_cast<float *>(ws.reserve(taps * filters * sizeof(float))) };
+      for (size_t f { 0 }; f < filters; ++f)
+        for (size_t t { 0 }; t < taps; ++t) k[t * filters + f] = w[f * taps + t];
+
+      ma::detail::parallel_for(g.batch * g.out_h,
+        grain(g.out_w * filters * taps * sizeof(float)),
+        [&](const size_t begin, const size_t end) {
+          for (size_t t { begin }; t < end; ++t) {
+            const size_t n { t / g.out_h }, oy { t % g.out_h };
+            const float *image { in + n * plane * g.channels };
+            for (size_t ox { 0 }; ox < g.out_w; ++ox) {
+              float *out { y + (t * g.out_w + ox) * filters };
+              if (bias)
+                std::copy_n(bias, filters, out);
+              else
+                std::fill_n(out, filters, 0.F);
+              for (size_t ky { 0 }; ky < g.kh; ++ky) {
+                const ptrdiff_t iy { ptrdiff_t(oy * g.sh + ky * g.dh) - ptrdiff_t(g.ph) };
+                if (iy < 0 || iy >= ptrdiff_t(g.height)) continue;
+                for (size_t kx { 0 }; kx < g.kw; ++kx) {
+                  const ptrdiff_t ix { ptrdiff_t(ox * g.sw + kx * g.dw)
+                                       - ptrdiff_t(g.pw) };
+                  if (ix < 0 || ix >= ptrdiff_t(g.width)) continue;
+                  const float *source {
+                    image + (size_t(iy) * g.width + size_t(ix)) * g.channels
+                  };
+                  const float *taps_of { k + (ky * g.kw + kx) * filters };
+                  if (mg == 1)
+                    kernels.madd_lanes(source, taps_of, out, filters);
+                  else
+                    for (size_t c { 0 }; c < g.channels; ++c)
+                      for (size_t m { 0 }; m < mg; ++m)
+                        out[c * mg + m] += taps_of[c * mg + m] * source[c];
+                }
+              }
+            }
+          }
+        });
+    }
+
+    //////////////////////////////////// WINOGRAD ///////////////////////////////////////
+
+    // the 16 matrices of transformed values lie a cache line further apart than their
+    // size, so that the rows of a tile, written and read together, never share the sets
+    // of the L1 cache as they would at multiples of 4KiB
+    size_t spaced(const size_t size) noexcept
+    {
+      return size + 64 / sizeof(float);
+    }
+
+    // 3x3 filters transformed into the 4x4 u = G g G^T, stored as 16 matrices of shape
+    // (filters, channels), through blocks of rows which are written out contiguously
+    void transform_weights(const float *w, const geometry &g, float *u)
+    {
+      const size_t size { g.filters * g.channels }, spacing { spaced(size) };
+      const size_t blocks { (size + LANES - 1) / LANES };
+      ma::detail::parallel_for(blocks, grain(16 * LANES * sizeof(float)),
+        [=](const size_t begin, const size_t end) {
+          float out[16][LANES];
+          for (size_t block { begin }; block < end; ++block) {
+            const size_t t0 { block * LANES }, width { std::min(LANES, size - t0) };
+            for (size_t l { 0 }; l < width; ++l) {
+              const float *k { w + (t0 + l) * 9 };
+              float s[4][3];
+              for (int j { 0 }; j < 3; ++j) {
+                s[0][j] = k[j];
+                s[1][j] = 0.5F * (k[j] + k[3 + j] + k[6 + j]);
+                s[2][j] = 0.5F * (k[j] - k[3 + j] + k[6 + j]);
+                s[3][j] = k[6 + j];
+              }
+              for (int i { 0 }; i < 4; ++i) {
+                out[i * 4][l]     = s[i][0];
+                out[i * 4 + 1][l] = 0.5F * (s[i][0] + s[i][1] + s[i][2]);
+                out[i * 4 + 2][l] = 0.5F * (s[i][0] - s[i][1] + s[i][2]);
+                out[i * 4 + 3][l] = s[i][2];
+              }
+            }
+            for (size_t xi { 0 }; xi < 16; ++xi)
+              std::copy_n(out[xi], width, u + xi * spacing + t0);
+          }
+        });
+    }
+
+    // tiles of a pass, `count` rows of tiles from the row `first`, each row covering two
+    // output rows of an image, with transformed values laid out as 16 matrices of
+    // (channels, tiles) for nchw images or (tiles, channels) for nhwc ones, so that the
+    // lanes of the transforms run along contiguous rows of images
+    struct tile_rows {
+      size_t first, count;
+    };
+
+    void transform_input(
+      const float *in, const geometry &g, const tile_rows rows, float *v)
+    {
+      const auto &kernels { detail::convolutions() };
+      const size_t channels { g.channels }, plane { g.height * g.width };
+      const size_t th { g.tiles_h() }, tw { g.tiles_w() }, tiles { rows.count * tw };
+      const size_t spacing { spaced(tiles * channels) };
+
+      if (g.nhwc()) {
+        const size_t blocks { (channels + LANES - 1) / LANES };
+        ma::detail::parallel_for(tiles * blocks, grain(16 * LANES * sizeof(float)),
+          [&](const size_t begin, const size_t end) {
+            float d[16 * LANES], out[16 * LANES];
+            for (size_t task { begin }; task < end; ++task) {
+              const size_t t { task / blocks }, c0 { task % blocks * LANES };
+              const size_t width { std::min(LANES, channels - c0) };
+              const size_t row { rows.first + t / tw }, n { row / th };
+              const ptrdiff_t y0 { ptrdiff_t(row % th * 2) - ptrdiff_t(g.ph) };
+              const ptrdiff_t x0 { ptrdiff_t(t % tw * 2) - ptrdiff_t(g.pw) };
+              for (ptrdiff_t r { 0 }; r < 4; ++r)
+                for (ptrdiff_t s { 0 }; s < 4; ++s) {
+                  const ptrdiff_t iy { y0 + r }, ix { x0 + s };
+                  float *lanes { d + (r * 4 + s) * ptrdiff_t(width) };
+                  if (iy < 0 || iy >= ptrdiff_t(g.height) || ix < 0
+                      || ix >= ptrdiff_t(g.width))
+                    std::fill_n(lanes, width, 0.F);
+                  else
+                    std::copy_n(
+                      in + (n * plane + size_t(iy) * g.width + size_t(ix)) * channels
+                        + c0,
+                      width, lanes);
+                }
+              kernels.winograd_input(d, out, width);
+              for (size_t xi { 0 }; xi < 16; ++xi)
+                std::copy_n(
+                  out + xi * width, width, v + xi * spacing + t * channels + c0);
+            }
+          });
+        return;
+      }
+
+      const size_t blocks { (tw + LANES - 1) / LANES };
+      const size_t per_channel { rows.count * blocks };
+      ma::detail::parallel_for(channels * per_channel, grain(16 * LANES * sizeof(float)),
+        [&](const size_t begin, const size_t end) {
+          float d[16 * LANES], out[16 * LANES];
+          for (size_t task { begin }; task < end; ++task) {
+            const size_t c { task / per_channel }, rest { task % per_channel };
+            const size_t row { rows.first + rest / blocks };
+            const size_t tx0 { rest % blocks * LANES };
+            const size_t width { std::min(LANES, tw - tx0) }, n { row / th };
+            const float *source { in + (n * channels + c) * plane };
+            const ptrdiff_t y0 { ptrdiff_t(row % th * 2) - ptrdiff_t(g.ph) };
+            for (ptrdiff_t r { 0 }; r < 4; ++r) {
+              const ptrdiff_t iy { y0 + r };
+              for (ptrdiff_t s { 0 }; s < 4; ++s) {
+                float *lanes { d + (r * 4 + s) * ptrdiff_t(width) };
+                if (iy < 0 || iy >= ptrdiff_t(g.height)) {
+                  std::fill_n(lanes, width, 0.F);
+                  continue;
+                }
+                // lane l reads column 2 * (tx0 + l) + s - pw
+                const ptrdiff_t shift { ptrdiff_t(2 * tx0) + s - ptrdiff_t(g.pw) };
+                const auto [l0, l1] { valid(width, g.width, 2, shift) };
+                const float *line { source + size_t(iy) * g.width };
+                std::fill_n(lanes, l0, 0.F);
+                for (size_t l { l0 }; l < l1; ++l)
+                  lanes[l] = line[ptrdiff_t(2 * l) + shift];
+                std::fill(lanes + l1, lanes + width, 0.F);
+              }
+            }
+            kernels.winograd_input(d, out, width);
+            const size_t t { (row - rows.first) * tw + tx0 };
+            for (size_t xi { 0 }; xi < 16; ++xi)
+              std::copy_n(out + xi * width, width, v + xi * spacing + c * tiles + t);
+          }
+        });
+    }
+
+    // products of the tiles of a pass, laid out as the transformed inputs with filters in
+    // place of channels, back to the outputs they cover
+    void transform_output(const float *m, const geometry &g, const tile_rows rows,
+      const float *bias, float *y)
+    {
+      const auto &kernels { detail::convolutions() };
+      const size_t filters { g.filters }, pixels { g.pixels() };
+      const size_t th { g.tiles_h() }, tw { g.tiles_w() }, tiles { rows.count * tw };
+      const size_t spacing { spaced(tiles * filters) };
+
+      if (g.nhwc()) {
+        const size_t blocks { (filters + LANES - 1) / LANES };
+        ma::detail::parallel_for(tiles * blocks, grain(16 * LANES * sizeof(float)),
+          [&](const size_t begin, const size_t end) {
+            float products[16 * LANES], out[4 * LANES];
+            for (size_t task { begin }; task < end; ++task) {
+              const size_t t { task / blocks }, f0 { task % blocks * LANES };
+              const size_t width { std::min(LANES, filters - f0) };
+              const size_t row { rows.first + t / tw }, n { row / th };
+              const size_t y0 { row % th * 2 }, x0 { t % tw * 2 };
+              for (size_t xi { 0 }; xi < 16; ++xi)
+                std::copy_n(
+                  m + xi * spacing + t * filters + f0, width, products + xi * width);
+              kernels.winograd_output(products, out, width);
+              for (size_t r { 0 }; r < 2 && y0 + r < g.out_h; ++r)
+                for (size_t s { 0 }; s < 2 && x0 + s < g.out_w; ++s) {
+                  float *dst {
+                    y + (n * pixels + (y0 + r) * g.out_w + x0 + s) * filters + f0
+                  };
+                  const float *lanes { out + (r * 2 + s) * width };
+                  if (bias)
+                    for (size_t l { 0 }; l < width; ++l) dst[l] = lanes[l] + bias[f0 + l];
+                  else
+                    std::copy_n(lanes, width, dst);
+                }
+            }
+          });
+        return;
+      }
+
+      const size_t blocks { (tw + LANES - 1) / LANES };
+      const size_t per_filter { rows.count * blocks };
+      ma::detail::parallel_for(filters * per_filter, grain(16 * LANES * sizeof(float)),
+        [&](const size_t begin, const size_t end) {
+          float products[16 * LANES], out[4 * LANES];
+          for (size_t task { begin }; task < end; ++task) {
+            const size_t f { task / per_filter }, rest { task % per_filter };
+            const size_t row { rows.first + rest / blocks };
+            const size_t tx0 { rest % blocks * LANES };
+            const size_t width { std::min(LANES, tw - tx0) }, n { row / th };
+            const size_t t { (row - rows.first) * tw + tx0 };
+            for (size_t xi { 0 }; xi < 16; ++xi)
+              std::copy_n(m + xi * spacing + f * tiles + t, width, products + xi * width);
+            kernels.winograd_output(products, out, width);
+            const float b { bias ? bias[f] : 0.F };
+            for (size_t r { 0 }; r < 2 && row % th * 2 + r < g.out_h; ++r) {
+              float *line {
+                y + (n * filters + f) * pixels + (row % th * 2 + r) * g.out_w
+              };
+              for (size_t s { 0 }; s < 2; ++s) {
+                // lane l writes column 2 * (tx0 + l) + s
+                const size_t count { std::min(width, (g.out_w - s + 1) / 2 - tx0) };
+                const float *lanes { out + (r * 2 + s) * width };
+                for (size_t l { 0 }; l < count; ++l)
+                  line[2 * (tx0 + l) + s] = lanes[l] + b;
+              }
+            }
+          }
+        });
+    }
+
+    void run_winograd(const float *in, const float *w, const float *bias, float *y,
+      const geometry &g, const plan &p, workspace &ws)
+    {
+      const size_t channels { g.channels }, filters { g.filters };
+      const size_t rows { g.batch * g.tiles_h() }, tw { g.tiles_w() };
+      const auto C { ptrdiff_t(channels) }, M { ptrdiff_t(filters) };
+
+      const size_t most { p.chunk * tw };
+      const size_t floats { spaced(filters * channels) + spaced(most * channels)
+                            + spaced(most * filters) };
+      carver parts {
+        static_cast<char *>(ws.reserve(floats * 16 * sizeof(float) + 192))
+      };
+      auto *u { parts.take<float>(16 * spaced(filters * channels)) };
+      auto *v { parts.take<float>(16 * spaced(most * channels)) };
+      auto *m { parts.take<float>(16 * spaced(most * filters)) };
+      transform_weights(w, g, u);
+
+      auto weights { view(u, dimension(16, filters, channels),
+        stride(ptrdiff_t(spaced(filters * channels)), C, 1)) };
+      for (size_t first { 0 }; first < rows; first += p.chunk) {
+        const tile_rows pass { first, std::min(p.chunk, rows - first) };
+        const size_t tiles { pass.count * tw };
+        const auto T { ptrdiff_t(tiles) };
+        const auto V { ptrdiff_t(spaced(tiles * channels)) },
+          P { ptrdiff_t(spaced(tiles * filters)) };
+        transform_input(in, g, pass, v);
+        if (g.nhwc()) {
+          auto a { view(v, dimension(16, tiles, channels), stride(V, C, 1)) };
+          auto c { view(m, dimension(16, tiles, filters), stride(P, M, 1)) };
+          ma::gemm(a, weights, c, 1.F, 0.F, false, true);
+        } else {
+          auto b { view(v, dimension(16, channels, tiles), stride(V, T, 1)) };
+          auto c { view(m, dimension(16, filters, tiles), stride(P, T, 1)) };
+          ma::gemm(weights, b, c);
+        }
+        transform_output(m, g, pass, bias, y);
+      }
+    }
+
+    ///////////////////////////////////// GRADIENTS /////////////////////////////////////
+
+    // adds the columns of one channel plane back onto it, the reverse of columns_nchw
+    // over rows of taps of `pixels` columns
+    void scatter_nchw(const float *cols, const geometry &g, float *plane)
+    {
+      for (size_t ky { 0 }; ky < g.kh; ++ky)
+        for (size_t kx { 0 }; kx < g.kw; ++kx) {
+          const float *row { cols + (ky * g.kw + kx) * g.pixels() };
+          const ptrdiff_t sy { ptrdiff_t(ky * g.dh) - ptrdiff_t(g.ph) };
+          const ptrdiff_t sx { ptrdiff_t(kx * g.dw) - ptrdiff_t(g.pw) };
+          const auto [x0, x1] { valid(g.out_w, g.width, g.sw, sx) };
+          for (size_t oy { 0 }; oy < g.out_h; ++oy) {
+            const ptrdiff_t iy { ptrdiff_t(oy * g.sh) + sy };
+            if (iy < 0 || iy >= ptrdiff_t(g.height)) continue;
+            float *dst { plane + iy * ptrdiff_t(g.width) + sx };
+            const float *src { row + oy * g.out_w };
+            for (size_t ox { x0 }; ox < x1; ++ox) dst[ox * g.sw] += src[ox];
+          }
+        }
+    }
+
+    // adds the columns of one nhwc image, rows of (ky, kx, channel) per pixel, back onto
+    // the channels of its group
+    void scatter_nhwc(const float *cols, const geometry &g, float *image)
+    {
+      const size_t cg { g.group_channels() };
+      for (size_t oy { 0 }; oy < g.out_h; ++oy)
+        for (size_t ox { 0 }; ox < g.out_w; ++ox) {
+          const float *src { cols + (oy * g.out_w + ox) * g.depth() };
+          for (size_t ky { 0 }; ky < g.kh; ++ky) {
+            const ptrdiff_t iy { ptrdiff_t(oy * g.sh + ky * g.dh) - ptrdiff_t(g.ph) };
+            for (size_t kx { 0 }; kx < g.kw; ++kx, src += cg) {
+              const ptrdiff_t ix { ptrdiff_t(ox * g.sw + kx * g.dw) - ptrdiff_t(g.pw) };
+              if (iy < 0 || iy >= ptrdiff_t(g.height) || ix < 0
+                  || ix >= ptrdiff_t(g.width))
+                continue;
+              float *dst { image + (size_t(iy) * g.width + size_t(ix)) * g.channels };
+              for (size_t c { 0 }; c < cg; ++c) dst[c] += src[c];
+            }
+          }
+        }
+    }
+
+    // gradient of the input added onto `dx`, the columns of the output gradient
+    // multiplied by the transposed weights, then scattered back onto the pixels they
+    // were gathered from
+    void run_input_grad(const float *dy, const float *w, float *dx, const geometry &g,
+      const size_t chunk, workspace &ws)
+    {
+      const size_t cg { g.group_channels() }, mg { g.group_filters() };
+      const size_t depth { g.depth() }, pixels { g.pixels() }, filters { g.filters };
+      const size_t plane { g.height * g.width }, taps { g.kh * g.kw };
+      const auto K { ptrdiff_t(depth) }, P { ptrdiff_t(pixels) };
+      const auto M { ptrdiff_t(filters) };
+
+      const size_t reordered_size { g.nhwc() ? filters * depth : 0 };
+      carver parts { static_cast<char *>(
+        ws.reserve((chunk * depth * pixels + reordered_size) * sizeof(float) + 128)) };
+      auto *cols { parts.take<float>(chunk * depth * pixels) };
+      if (g.nhwc()) {
+        auto *reordered { parts.take<float>(filters * depth) };
+        channels_last(w, g, reordered);
+        w = reordered;
+      }
+
+      for (size_t n0 { 0 }; n0 < g.batch; n0 += chunk) {
+        const size_t count { std::min(chunk, g.batch - n0) };
+        for (size_t group { 0 }; group < g.groups; ++group) {
+          auto weights {
+            view(w + group * mg * depth, dimension(mg, depth), stride(K, 1))
+          };
+          if (g.nhwc()) {
+            auto a { view(dy + n0 * pixels * filters + group * mg,
+              dimension(count * pixels, mg), stride(M, 1)) };
+            auto c { view(cols, dimension(count * pixels, depth), stride(K, 1)) };
+            ma::gemm(a, weights, c);
+            // pixels of neighbouring outputs overlap, so images are the unit of work
+            ma::detail::parallel_for(count, 1, [&](const size_t begin, const size_t end) {
+              for (size_t i { begin }; i < end; ++i)
+                scatter_nhwc(cols + i * pixels * depth, g,
+                  dx + (n0 + i) * plane * g.channels + group * cg);
+            });
+          } else {
+            auto b { view(dy + (n0 * filters + group * mg) * pixels,
+              dimension(count, mg, pixels), stride(M * P, P, 1)) };
+            auto c { view(cols, dimension(count, depth, pixels), stride(K * P, P, 1)) };
+            ma::gemm(weights, b, c, 1.F, 0.F, true);
+            ma::detail::parallel_for(count * cg, grain(taps * pixels * sizeof(float)),
+              [&](const size_t begin, const size_t end) {
+                for (size_t t { begin }; t < end; ++t) {
+                  const size_t i { t / cg }, ch { t % cg };
+                  scatter_nchw(cols + (i * depth + ch * taps) * pixels, g,
+                    dx + ((n0 + i) * g.channels + group * cg + ch) * plane);
+                }
+              });
+          }
+        }
+      }
+    }
+
+    // gradient of the weights written to `dw` of shape (filters, depth), the depth in the
+    // order of the columns, so (kh, kw, channels) for nhwc images, as the products of the
+    // output gradient with the transposed columns of the input
+    void run_weight_grad(const float *in, const float *dy, float *dw, const geometry &g,
+      const size_t chunk, float *cols)
+    {
+      const size_t mg { g.group_filters() };
+      const size_t depth { g.depth() }, pixels { g.pixels() }, filters { g.filters };
+      const auto K { ptrdiff_t(depth) }, P { ptrdiff_t(pixels) };
+      const auto M { ptrdiff_t(filters) };
+
+      for (size_t n0 { 0 }; n0 < g.batch; n0 += chunk) {
+        const size_t count { std::min(chunk, g.batch - n0) };
+        for (size_t group { 0 }; group < g.groups; ++group) {
+          gather(in, g, group, n0, count, 0.F, cols, false);
+          auto c { view(dw + group * mg * depth, dimension(mg, depth), stride(K, 1)) };
+          if (g.nhwc()) {
+            auto a { view(dy + n0 * pixels * filters + group * mg,
+              dimension(count * pixels, mg), stride(M, 1)) };
+            auto b { view(cols, dimension(count * pixels, depth), stride(K, 1)) };
+            ma::gemm(a, b, c, 1.F, n0 ? 1.F : 0.F, true);
+          } else
+            for (size_t i { 0 }; i < count; ++i) {
+              auto a { view(dy + ((n0 + i) * filters + group * mg) * pixels,
+                dimension(mg, pixels), stride(P, 1)) };
+              auto b {
+                view(cols + i * depth * pixels, dimension(depth, pixels), stride(P, 1))
+              };
+              ma::gemm(a, b, c, 1.F, n0 + i ? 1.F : 0.F, false, true);
+            }
+        }
+      }
+    }
+
+  }  // namespace
+
+  ma::dimension conv2d_shape(const ma::dimension &input, const ma::dimension &weight,
+    const conv2d_params &params)
+  {
+    return shape(validate(input, weight, params));
+  }
+
+  conv_algorithm conv2d_algorithm(const ma::dimension &input, const ma::dimension &weight,
+    const conv2d_params &params)
+  {
+    return plan_of(validate(input, weight, params), params.algorithm).algorithm;
+  }
+
+  ma::float32 &conv2d(const ma::float32 &input, const ma::float32 &weight,
+    const ma::float32 &bias, ma::float32 &out, const conv2d_params &params, workspace &ws)
+  {
+    const auto g { validate(input.dim(), weight.dim(), params) };
+    if (bias.size() && (bias.ndims() != 1 || bias.dim()[0] != g.filters))
+      throw std::invalid_argument { "bias must hold one value per filter" };
+    if (out.dim() != shape(g))
+      throw std::invalid_argument { "output shape does not match the convolution" };
+    const auto p { plan_of(g, params.algorithm) };
+    if (!out.size()) return out;
+
+    // outputs which are strided are computed aside and copied in
+    const auto x { operand(input, out) }, w { operand(weight, out) };
+    const auto b { operand(bias, out) };
+    ma::float32 y { out.is_contiguous() ? out
+                                        : ma::float32 { out.dim(), ma::uninitialized } };
+    const float *bias_data { b.size() ? b.data() : nullptr };
+
+    switch (p.algorithm) {
+      case conv_algorithm::direct:
+        if (pointwise(g))
+          run_pointwise(x.data(), w.data(), bias_data, y.data(), g);
+        else
+          run_depthwise(x.data(), w.data(), bias_data, y.data(), g, ws);
+        break;
+      case conv_algorithm::winograd:
+        run_winograd(x.data(), w.data(), bias_data, y.data(), g, p, ws);
+        break;
+      default:
+        run_im2col(x.data(), w.data(), bias_data, y.data(), g, p, ws);
+    }
+
+    if (y.data() != out.data()) copy_into(y, out);
+    return out;
+  }
+
+  ma::float32 &conv2d_input_grad(const ma::float32 &grad, const ma::float32 &weight,
+    ma::float32 &input_grad, const conv2d_params &params, const bool accumulate,
+    workspace &ws)
+  {
+    const auto g { validate(input_grad.dim(), weight.dim(), params) };
+    if (grad.dim() != shape(g))
+      throw std::invalid_argument { "gradient shape does not match the convolution" };
+    if (!input_grad.size()) return input_grad;
+
+    // strided gradients are computed aside, then added or copied in
+    const auto dy { operand(grad, input_grad) }, w { operand(weight, input_grad) };
+    const bool direct { input_grad.is_contiguous() };
+    ma::float32 dx { direct ? input_grad
+                            : ma::float32 { input_grad.dim(), ma::uninitialized } };
+    if (!direct || !accumulate) dx.fill(0.F);
+    const size_t chunk { plan_of(g, conv_algorithm::im2col).chunk };
+    run_input_grad(dy.data(), w.data(), dx.data(), g, chunk, ws);
+
+    if (direct) return input_grad;
+    if (accumulate) return ma::add(input_grad, dx, input_grad);
+    copy_into(dx, input_grad);
+    return input_grad;
+  }
+
+  ma::float32 &conv2d_weight_grad(const ma::float32 &input, const ma::float32 &grad,
+    ma::float32 &weight_grad, const conv2d_params &params, const bool accumulate,
+    workspace &ws)
+  {
+    const auto g { validate(input.dim(), weight_grad.dim(), params) };
+    if (grad.dim() != shape(g))
+      throw std::invalid_argument { "gradient shape does not match the convolution" };
+    if (!weight_grad.size()) return weight_grad;
+
+    const auto x { operand(input, weight_grad) }, dy { operand(grad, weight_grad) };
+    const size_t chunk { plan_of(g, conv_algorithm::im2col).chunk };
+    const size_t depth { g.depth() }, cg { g.group_channels() };
+    carver parts { static_cast<char *>(ws.reserve(
+      (chunk * depth * g.pixels() + g.filters * depth) * sizeof(float) + 128)) };
+    auto *cols { parts.take<float>(chunk * depth * g.pixels()) };
+    auto *dw { parts.take<float>(g.filters * depth) };
+    if (g.batch)
+      run_weight_grad(x.data(), dy.data(), dw, g, chunk, cols);
+    else
+      std::fill_n(dw, g.filters * depth, 0.F);
+
+    // the products in the order of the weights
+    const auto K { ptrdiff_t(depth) }, C { ptrdiff_t(cg) }, W { ptrdiff_t(g.kw) };
+    const auto *products_data { static_cast<const float *>(dw) };
+    const auto products { g.nhwc()
+        ? view(products_data, weight_grad.dim(), stride(K, 1, W * C, C))
+        : view(products_data, weight_grad.dim(), stride(weight_grad.dim())) };
+    if (accumulate) return ma::add(weight_grad, products, weight_grad);
+    copy_into(products, weight_grad);
+    return weight_grad;
+  }
+
+  template<typename _IDType, typename _ODType>
+  ma::quantized<_ODType> &conv2d(const ma::quantized<_IDType> &input,
+    const ma::quantized<ma::dtype::int8> &weight, const ma::requantization &epilogue,
+    ma::quantized<_ODType> &out, const conv2d_params &params, workspace &ws)
+  {
+    using in_type = typename ma::multiarray<_IDType>::native_type;
+
+    const auto g { validate(input.values.dim(), weight.values.dim(), params) };
+    if (out.values.dim() != shape(g))
+      throw std::invalid_argument { "output shape does not match the convolution" };
+    if (input.params.zero_points.size() != 1)
+      throw std::invalid_argument {
+        "quantized convolutions need inputs quantized as a whole"
+      };
+    const auto &wq { weight.params };
+    const bool per_filter { wq.axis == 0 && wq.scales.size() == g.filters
+                            && wq.zero_points.size() == g.filters };
+    if (!per_filter && (wq.scales.size() != 1 || wq.zero_points.size() != 1))
+      throw std::invalid_argument {
+        "weights must be quantized as a whole or per filter"
+      };
+    if (!epilogue.bias.empty() && epilogue.bias.size() != g.filters)
+      throw std::invalid_argument { "bias must hold one value per filter" };
+    if (params.algorithm != conv_algorithm::automatic
+        && params.algorithm != conv_algorithm::im2col)
+      throw std::invalid_argument { "quantized convolutions only run as im2col" };
+    if (!out.values.size()) return out;
+
+    // outputs of nchw images are transposed products, of one image at a time
+    const auto p { plan_of(g, conv_algorithm::im2col) };
+    const size_t chunk { g.nhwc() ? p.chunk : 1 }, mg { g.group_filters() };
+    const size_t depth { g.depth() }, pixels { g.pixels() }, filters { g.filters };
+    const auto K { ptrdiff_t(depth) }, M { ptrdiff_t(filters) };
+    const auto P { ptrdiff_t(pixels) };
+
+    const auto x { operand(input.values, out.values) };
+    const auto w { operand(weight.values, out.values) };
+    auto y { out.values.is_contiguous()
+        ? out.values
+        : ma::multiarray<_ODType> { out.values.dim(), ma::uninitialized } };
+
+    const size_t reordered_size { g.nhwc() ? filters * depth : 0 };
+    carver parts { static_cast<char *>(
+      ws.reserve(chunk * pixels * depth * sizeof(in_type) + reordered_size + 128)) };
+    auto *cols { parts.take<in_type>(chunk * pixels * depth) };
+    const std::int8_t *wd { w.data() };
+    if (g.nhwc()) {
+      auto *reordered { parts.take<std::int8_t>(filters * depth) };
+      channels_last(wd, g, reordered);
+      wd = reordered;
+    }
+
+    // padding reads as the zero point, which stands for zero
+    const auto pad { in_type(input.params.zero_points[0]) };
+    for (size_t group { 0 }; group < g.groups; ++group) {
+      ma::quantized<ma::dtype::int8> weights { view(wd + group * mg * depth,
+                                                 dimension(mg, depth), stride(K, 1)),
+        wq };
+      ma::requantization tail { {}, epilogue.relu };
+      const auto first { ptrdiff_t(group * mg) }, last { ptrdiff_t((group + 1) * mg) };
+      if (per_filter) {
+        weights.params.scales.assign(wq.scales.begin() + first, wq.scales.begin() + last);
+        weights.params.zero_points.assign(wq.zero_points.begin() + first,
+          wq.zero_points.begin() + last);
+      }
+      if (!epilogue.bias.empty())
+        tail.bias.assign(epilogue.bias.begin() + first, epilogue.bias.begin() + last);
+
+      for (size_t n0 { 0 }; n0 < g.batch; n0 += chunk) {
+        const size_t count { std::min(chunk, g.batch - n0) };
+        gather(x.data(), g, group, n0, count, pad, cols, true);
+        const ma::quantized<_IDType> a {
+          view(cols, dimension(count * pixels, depth), stride(K, 1)), input.params
+        };
+        ma::quantized<_ODType> c {
+          g.nhwc() ? view(y.data() + n0 * pixels * filters + group * mg,
+                       dimension(count * pixels, mg), stride(M, 1))
+                   : view(y.data() + (n0 * filters + group * mg) * pixels,
+                       dimension(pixels, mg), stride(1, P)),
+          out.params
+        };
+        ma::qgemm(a, weights, c, tail, false, true);
+      }
+    }
+
+    if (y.data() != out.values.data()) copy_into(y, out.values);
+    return out;
+  }
+
+#define INSTANTIATE(input_type, output_type)                                          \
+  template ma::quantized<ma::dtype::output_type> &conv2d(                             \
+    const ma::quantized<ma::dtype::input_type> &,                                     \
+    const ma::quantized<ma::dtype::int8> &, const ma::requantization &,               \
+    ma::quantized<ma::dtype::output_type> &, const conv2d_params &, workspace &);
+
+  INSTANTIATE(uint8, uint8)
+  INSTANTIATE(uint8, int8)
+  INSTANTIATE(int8, uint8)
+  INSTANTIATE(int8, int8)
+
+#undef INSTANTIATE
+
+}  // namespace covdel::nn
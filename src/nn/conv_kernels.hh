@@ -0,0 +1,36 @@
+#ifndef __COVDEL_SRC_NN_CONV_KERNELS_HH_1702561203__
+#define __COVDEL_SRC_NN_CONV_KERNELS_HH_1702561203__
+
+#include <cstddef>
+
+namespace covdel::nn::detail
+{
+  using std::ptrdiff_t;
+  using std::size_t;
+
+  // inner loops of the direct and winograd convolutions over lanes of float samples,
+  // lanes being pixels of a row, channels of a pixel or tiles of a channel
+  struct conv_table {
+    // out[i] += w * in[i * step], a tap of a depthwise filter along a row
+    void (*madd)(const float *in, ptrdiff_t step, float w, float *out, size_t count);
+    // out[i] += w[i] * in[i], a tap of depthwise filters across the channels of a pixel
+    void (*madd_lanes)(const float *in, const float *w, float *out, size_t count);
+
+    // winograd F(2x2, 3x3) transforms of 4x4 input tiles d, as 16 rows of `count` lanes,
+    // into v = B^T d B, and of 4x4 products m into 2x2 outputs y = A^T m A
+    void (*winograd_input)(const float *d, float *v, size_t count);
+    void (*winograd_output)(const float *m, float *y, size_t count);
+  };
+
+  // registration entry points, one per instruction set translation unit
+  namespace scalar { void fill(conv_table &table) noexcept; }
+  namespace sse2 { void fill(conv_table &table) noexcept; }
+  namespace avx2 { void fill(conv_table &table) noexcept; }
+  namespace avx512 { void fill(conv_table &table) noexcept; }
+
+  // loops of the currently active instruction set level of the multiarray module
+  const conv_table &convolutions() noexcept;
+
+}  // namespace covdel::nn::detail
+
+#endif
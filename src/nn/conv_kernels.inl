@@ -0,0 +1,89 @@
+// Lane loops of the convolutions, compiled once per instruction set level. Each including
+// translation unit defines COVDEL_KERNEL_ISA and is built with the matching target flags,
+// so the loops below are auto-vectorized for that level. As in the multiarray kernels,
+// everything but fill() has internal linkage and no out-of-line library templates are
+// used.
+
+#ifndef COVDEL_KERNEL_ISA
+ #error "COVDEL_KERNEL_ISA must name the instruction set namespace"
+#endif
+
+#include "conv_kernels.hh"
+
+namespace covdel::nn::detail::COVDEL_KERNEL_ISA
+{
+  namespace
+  {
+    void madd(const float *in, const ptrdiff_t step, const float w, float *out,
+      const size_t count)
+    {
+      if (step == 1)
+        for (size_t i { 0 }; i < count; ++i) out[i] += w * in[i];
+      else
+        for (size_t i { 0 }; i < count; ++i) out[i] += w * in[ptrdiff_t(i) * step];
+    }
+
+    void madd_lanes(const float *in, const float *w, float *out, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i) out[i] += w[i] * in[i];
+    }
+
+    // lanes of each of the 16 values of a tile are `count` consecutive floats, row by
+    // row
+    void winograd_input(const float *__restrict d, float *__restrict v, const size_t count)
+    {
+      // B^T along the columns into v, then B along the rows in place
+      for (size_t c { 0 }; c < 4; ++c) {
+        const float *d0 { d + c * count }, *d1 { d0 + 4 * count };
+        const float *d2 { d1 + 4 * count }, *d3 { d2 + 4 * count };
+        float *t0 { v + c * count }, *t1 { t0 + 4 * count };
+        float *t2 { t1 + 4 * count }, *t3 { t2 + 4 * count };
+        for (size_t i { 0 }; i < count; ++i) {
+          const float a { d0[i] }, b { d1[i] }, e { d2[i] }, f { d3[i] };
+          t0[i] = a - e;
+          t1[i] = b + e;
+          t2[i] = e - b;
+          t3[i] = b - f;
+        }
+      }
+      for (size_t r { 0 }; r < 4; ++r) {
+        float *__restrict v0 { v + 4 * r * count }, *__restrict v1 { v0 + count };
+        float *__restrict v2 { v1 + count }, *__restrict v3 { v2 + count };
+        for (size_t i { 0 }; i < count; ++i) {
+          const float a { v0[i] }, b { v1[i] }, e { v2[i] }, f { v3[i] };
+          v0[i] = a - e;
+          v1[i] = b + e;
+          v2[i] = e - b;
+          v3[i] = b - f;
+        }
+      }
+    }
+
+    // products to the 2x2 outputs, 4 groups of `count` lanes, row by row
+    void winograd_output(const float *__restrict m, float *__restrict y, const size_t count)
+    {
+      for (size_t i { 0 }; i < count; ++i) {
+        float x[16], s[8];
+        for (int k { 0 }; k < 16; ++k) x[k] = m[size_t(k) * count + i];
+        for (int c { 0 }; c < 4; ++c) {
+          s[c]     = x[c] + x[4 + c] + x[8 + c];
+          s[4 + c] = x[4 + c] - x[8 + c] - x[12 + c];
+        }
+        for (int r { 0 }; r < 2; ++r) {
+          y[size_t(2 * r) * count + i]     = s[4 * r] + s[4 * r + 1] + s[4 * r + 2];
+          y[size_t(2 * r + 1) * count + i] = s[4 * r + 1] - s[4 * r + 2] - s[4 * r + 3];
+        }
+      }
+    }
+
+  }  // namespace
+
+  void fill(conv_table &table) noexcept
+  {
+    table.madd = madd;
+    table.madd_lanes = madd_lanes;
+    table.winograd_input = winograd_input;
+    table.winograd_output = winograd_output;
+  }
+
+}  // namespace covdel::nn::detail::COVDEL_KERNEL_ISA
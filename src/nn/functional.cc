@@ -0,0 +1,269 @@
+#include "covdel/nn/tensor.hh"
+
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/reduction.hh"
+#include "tape.hh"
+
+#include <stdexcept>
+
+namespace covdel::nn
+{
+  namespace
+  {
+    using detail::op_code;
+    using detail::operation;
+
+    // gradient of a reduction spread back over the elements it reduced
+    ma::float32 spread(const ma::float32 &grad, const ma::dimension &reduced,
+      const ma::dimension &dim)
+    {
+      ma::float32 kept { grad };
+      return kept.reshape(reduced).broadcast_to(dim);
+    }
+
+    std::vector<int> every(const ma::dimension &dim)
+    {
+      std::vector<int> out;
+      for (int i { 0 }; i < dim.ndims(); ++i) out.push_back(i);
+      return out;
+    }
+
+    // axes as non-negative positions
+    std::vector<int> resolved(const ma::dimension &dim, const std::vector<int> &axes)
+    {
+      const unsigned mask { ma::detail::axis_mask(dim, axes) };
+      std::vector<int> out;
+      for (int i { 0 }; i < dim.ndims(); ++i)
+        if (mask >> i & 1U) out.push_back(i);
+      return out;
+    }
+
+    size_t extent(const ma::dimension &dim, const std::vector<int> &axes)
+    {
+      size_t count { 1 };
+      for (const int axis : axes) count *= dim[axis];
+      return count;
+    }
+
+    tensor reduction(const tensor &a, const std::vector<int> &axes, const bool keepdims,
+      const float scale, const op_code code)
+    {
+      const auto dim { a.dim() };
+      ma::float32 out { ma::sum(a.value(), axes, keepdims) };
+      if (scale != 1.F) ma::multiply(out, scale, out);
+      const auto kept { ma::reduced(dim, ma::detail::axis_mask(dim, axes), true) };
+      return detail::result(out, { &a }, { code, 0.F, resolved(dim, axes), keepdims },
+        [dim, kept, scale](operation &op, const ma::float32 &g) {
+          if (scale == 1.F)
+            op.pass(0, spread(g, kept, dim), false);
+          else
+            op.pass(0, spread(ma::multiply(g, scale), kept, dim), false);
+        });
+    }
+
+  }  // namespace
+
+  //////////////////////////////////// ELEMENT-WISE /////////////////////////////////////
+
+  tensor add(const tensor &a, const tensor &b)
+  {
+    const ma::float32 out { ma::add(a.value(), b.value()) };
+    return detail::result(out, { &a, &b }, { op_code::add },
+      [](operation &op, const ma::float32 &g) {
+        op.pass(0, g, false);
+        op.pass(1, g, true);
+      });
+  }
+
+  tensor subtract(const tensor &a, const tensor &b)
+  {
+    const ma::float32 out { ma::subtract(a.value(), b.value()) };
+    return detail::result(out, { &a, &b }, { op_code::subtract },
+      [](operation &op, const ma::float32 &g) {
+        op.pass(0, g, false);
+        if (op.needs(1)) op.pass(1, ma::negative(g), true);
+      });
+  }
+
+  tensor multiply(const tensor &a, const tensor &b)
+  {
+    const ma::float32 out { ma::multiply(a.value(), b.value()) };
+    return detail::result(out, { &a, &b }, { op_code::multiply },
+      [x = a.value(), y = b.value()](operation &op, const ma::float32 &g) {
+        if (op.needs(0)) op.pass(0, ma::multiply(g, y), true);
+        if (op.needs(1)) op.pass(1, ma::multiply(g, x), true);
+      });
+  }
+
+  tensor divide(const tensor &a, const tensor &b)
+  {
+    const ma::float32 out { ma::divide(a.value(), b.value()) };
+    return detail::result(out, { &a, &b }, { op_code::divide },
+      [y = b.value(), out](operation &op, const ma::float32 &g) {
+        const ma::float32 da { ma::divide(g, y) };
+        if (op.needs(1)) op.pass(1, ma::negative(ma::multiply(da, out)), true);
+        op.pass(0, da, true);
+      });
+  }
+
+  tensor add(const tensor &a, const float b)
+  {
+    const ma::float32 out { ma::add(a.value(), b) };
+    return detail::result(out, { &a }, { op_code::add_scalar, b },
+      [](operation &op, const ma::float32 &g) { op.pass(0, g, true); });
+  }
+
+  tensor multiply(const tensor &a, const float b)
+  {
+    const ma::float32 out { ma::multiply(a.value(), b) };
+    return detail::result(out, { &a }, { op_code::multiply_scalar, b },
+      [b](operation &op, const ma::float32 &g) { op.pass(0, ma::multiply(g, b), true); });
+  }
+
+  tensor negative(const tensor &a)
+  {
+    const ma::float32 out { ma::negative(a.value()) };
+    return detail::result(out, { &a }, { op_code::negative },
+      [](operation &op, const ma::float32 &g) { op.pass(0, ma::negative(g), true); });
+  }
+
+  tensor exp(const tensor &a)
+  {
+    const ma::float32 out { ma::exp(a.value()) };
+    return detail::result(out, { &a }, { op_code::exp },
+      [out](operation &op, const ma::float32 &g) {
+        op.pass(0, ma::multiply(g, out), true);
+      });
+  }
+
+  tensor log(const tensor &a)
+  {
+    const ma::float32 out { ma::log(a.value()) };
+    return detail::result(out, { &a }, { op_code::log },
+      [x = a.value()](operation &op, const ma::float32 &g) {
+        op.pass(0, ma::divide(g, x), true);
+      });
+  }
+
+  tensor sqrt(const tensor &a)
+  {
+    const ma::float32 out { ma::sqrt(a.value()) };
+    return detail::result(out, { &a }, { op_code::sqrt },
+      [out](operation &op, const ma::float32 &g) {
+        ma::float32 d { ma::divide(g, out) };
+        op.pass(0, ma::multiply(d, 0.5F, d), true);
+      });
+  }
+
+  tensor relu(const tensor &a)
+  {
+    const ma::float32 out { ma::maximum(a.value(), 0.F) };
+    return detail::result(out, { &a }, { op_code::relu },
+      [out](operation &op, const ma::float32 &g) {
+        ma::float32 d { ma::greater(out, 0.F).astype<ma::float32>() };
+        op.pass(0, ma::multiply(d, g, d), true);
+      });
+  }
+
+  tensor sigmoid(const tensor &a)
+  {
+    ma::float32 out { ma::exp(ma::negative(a.value())) };
+    out = ma::divide(1.F, ma::add(out, 1.F, out));
+    return detail::result(out, { &a }, { op_code::sigmoid },
+      [out](operation &op, const ma::float32 &g) {
+        ma::float32 d { ma::subtract(1.F, out) };
+        ma::multiply(d, out, d);
+        op.pass(0, ma::multiply(d, g, d), true);
+      });
+  }
+
+  ///////////////////////////////////// REDUCTIONS //////////////////////////////////////
+
+  tensor sum(const tensor &a)
+  {
+    return reduction(a, every(a.dim()), false, 1.F, op_code::sum);
+  }
+
+  tensor sum(const tensor &a, const std::vector<int> &axes, const bool keepdims)
+  {
+    return reduction(a, axes, keepdims, 1.F, op_code::sum);
+  }
+
+  tensor mean(const tensor &a)
+  {
+    const float scale { 1.F / float(a.value().size()) };
+    return reduction(a, every(a.dim()), false, scale, op_code::mean);
+  }
+
+  tensor mean(const tensor &a, const std::vector<int> &axes, const bool keepdims)
+  {
+    const float scale { 1.F / float(extent(a.dim(), resolved(a.dim(), axes))) };
+    return reduction(a, axes, keepdims, scale, op_code::mean);
+  }
+
+  ////////////////////////////////////// PRODUCTS ///////////////////////////////////////
+
+  tensor matmul(const tensor &a, const tensor &b)
+  {
+    const auto &da { a.dim() }, &db { b.dim() };
+    const int na { da.ndims() }, nb { db.ndims() };
+    bool stacked { na >= 2 && nb == na };
+    for (int i { 0 }; stacked && i < na - 2; ++i) stacked = da[i] == db[i];
+    if (na < 2 || (nb != 2 && !stacked))
+      throw std::invalid_argument {
+        "matmul of tensors needs matrices, stacks of the same shape, or a stack and a matrix"
+      };
+
+    const ma::float32 out { ma::matmul(a.value(), b.value()) };
+    return detail::result(out, { &a, &b }, { op_code::matmul },
+      [x = a.value(), y = b.value(), stacked](operation &op, const ma::float32 &g) {
+        // da = g b^T, db = a^T g summed over the stack, added straight onto the gradients
+        if (op.needs(0)) {
+          auto [sum, held] { op.sink(0) };
+          ma::gemm(g, y, *sum, 1.F, held ? 1.F : 0.F, false, true);
+        }
+        if (op.needs(1)) {
+          auto [sum, held] { op.sink(1) };
+          if (stacked)
+            ma::gemm(x, g, *sum, 1.F, held ? 1.F : 0.F, true);
+          else {
+            const int n { x.dim().ndims() };
+            const size_t k { x.dim()[n - 1] }, m { x.size() / std::max<size_t>(k, 1) };
+            ma::float32 rows { x.ascontiguous() }, grads { g.ascontiguous() };
+            rows.reshape(ma::dimension(m, k));
+            grads.reshape(ma::dimension(m, g.dim()[n - 1]));
+            ma::gemm(rows, grads, *sum, 1.F, held ? 1.F : 0.F, true);
+          }
+        }
+      });
+  }
+
+  tensor conv2d(const tensor &input, const tensor &weight, const tensor &bias,
+    const conv2d_params &params)
+  {
+    const ma::float32 out { conv2d(input.value(), weight.value(), bias.value(), params) };
+    const detail::traced_op traced { op_code::conv2d, 0.F, {}, false, params };
+    return detail::result(out, { &input, &weight, &bias }, traced,
+      [x = input.value(), w = weight.value(), params](operation &op, const ma::float32 &g) {
+        if (op.needs(0)) {
+          auto [sum, held] { op.sink(0) };
+          conv2d_input_grad(g, w, *sum, params, held);
+        }
+        if (op.needs(1)) {
+          auto [sum, held] { op.sink(1) };
+          conv2d_weight_grad(x, g, *sum, params, held);
+        }
+        if (op.needs(2))
+          op.pass(2, ma::sum(g, params.format == layout::nhwc ? std::vector { 0, 1, 2 }
+                                                                : std::vector { 0, 2, 3 }),
+            true);
+      });
+  }
+
+  tensor conv2d(const tensor &input, const tensor &weight, const conv2d_params &params)
+  {
+    return conv2d(input, weight, tensor {}, params);
+  }
+
+}  // namespace covdel::nn
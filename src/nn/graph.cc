@@ -0,0 +1,666 @@
+#include "covdel/nn/graph.hh"
+
+#include "covdel/ma/allocator.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/reduction.hh"
+#include "ma/kernels.hh"
+#include "ma/parallel.hh"
+#include "tape.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace covdel::nn
+{
+  namespace
+  {
+    using detail::op_code;
+    using ma::detail::binary_op;
+    using ma::detail::unary_op;
+    using steps_t = std::array<ptrdiff_t, 6>;
+
+    constexpr int INPUT { 0 };
+
+    // elements each step of a chain goes over before the next one, so that the running
+    // result stays in the cache across steps
+    constexpr std::size_t CHUNK { 4096 };
+
+    constexpr const char *BINARY_NAMES[] { "add", "subtract", "multiply", "divide",
+      "minimum", "maximum" };
+    constexpr const char *UNARY_NAMES[] { "abs", "negative", "sqrt", "exp", "log" };
+
+    // element-wise operation on the running result of a node, with another value or a
+    // scalar for binary ones
+    struct step {
+      bool binary;
+      binary_op bop;
+      unary_op uop;
+      int side { -1 };
+      float scalar {};
+      bool main_left { true };
+
+      ma::detail::binary_kernel<float, float> binary_kernel {};
+      ma::detail::unary_kernel<float> unary_kernel {};
+
+      // the side operand broadcast over the result, set by each run
+      const float *side_data {};
+      steps_t side_steps {};
+    };
+
+    enum class node_kind { conv2d, matmul, reduce, chain };
+
+    // convolutions, products and reductions write their result and run their steps over
+    // it, chains run their first step from their first input, or copy it without steps
+    struct op_node {
+      node_kind kind;
+      std::vector<int> inputs;
+      int output;
+      conv2d_params params {};
+      unsigned mask {};
+      float scale { 1.F };
+      std::vector<step> steps {};
+
+      std::string name {};
+      std::size_t calls {};
+      double seconds {};
+    };
+
+    struct value {
+      ma::dimension dim;
+      int producer { -1 };  // none for the input and constants
+      ma::float32 array { ma::dimension(0) };  // of constants, or a view of the arena
+      int last { -1 };                          // last node reading it
+      int buffer { -1 };
+    };
+
+    // region of the arena, shared by a chain result with its first input when that dies
+    // there
+    struct buffer {
+      std::size_t bytes;
+      int first, last;
+      std::size_t offset {};
+    };
+
+    std::size_t aligned(const std::size_t bytes) noexcept
+    {
+      return (bytes + ma::ALIGNMENT - 1) / ma::ALIGNMENT * ma::ALIGNMENT;
+    }
+
+    // strides of `a` broadcast over `dim`, aligned at the last axis
+    steps_t broadcast(const ma::float32 &a, const ma::dimension &dim) noexcept
+    {
+      steps_t out {};
+      const int lead { dim.ndims() - a.dim().ndims() };
+      for (int i { lead }; i < dim.ndims(); ++i)
+        out[i] = a.dim()[i - lead] == 1 ? 0 : a.strides()[i - lead];
+      return out;
+    }
+
+    // appends the trace of the calling thread to `trace` while alive
+    class tracing {
+    public:
+      explicit tracing(std::vector<detail::traced_op> &trace) noexcept
+        : p_previous { detail::active_trace() }
+      {
+        detail::active_trace() = &trace;
+      }
+      tracing(const tracing &) = delete;
+      tracing &operator=(const tracing &) = delete;
+      ~tracing() noexcept { detail::active_trace() = p_previous; }
+
+    private:
+      std::vector<detail::traced_op> *p_previous;
+    };
+
+    void copy(const float *a, float *o, ptrdiff_t sa, ptrdiff_t so, std::size_t count)
+    {
+      for (ptrdiff_t i { 0 }; i < ptrdiff_t(count); ++i) o[i * so] = a[i * sa];
+    }
+
+    // one node over the elements [begin, end) of its result
+    struct pass {
+      const op_node *node;
+      int ndims;
+      std::array<std::size_t, 6> extent;
+      const float *source;
+      steps_t source_steps;
+      float *out;
+      steps_t out_steps;
+
+      void operator()(const std::size_t begin, const std::size_t end) const
+      {
+        for (std::size_t first { begin }; first < end; first += CHUNK)
+          run(first, std::min(end, first + CHUNK));
+      }
+
+      void run(const std::size_t begin, const std::size_t end) const
+      {
+        if (node->steps.empty()) {
+          const std::array<steps_t, 2> steps { source_steps, out_steps };
+          ma::detail::for_each_run(ndims, extent, steps, begin, end,
+            [](const float *a, float *o, ptrdiff_t sa, ptrdiff_t so, std::size_t count) {
+              copy(a, o, sa, so, count);
+            },
+            source, out);
+          return;
+        }
+
+        // later steps, and every one of products, update the result in place
+        const float *from { source };
+        steps_t from_steps { source_steps };
+        for (const step &s : node->steps) {
+          if (!s.binary) {
+            const std::array<steps_t, 2> steps { from_steps, out_steps };
+            ma::detail::for_each_run(ndims, extent, steps, begin, end,
+              [&s](const float *a, float *o, ptrdiff_t sa, ptrdiff_t so,
+                std::size_t count) { s.unary_kernel(a, sa, o, so, count); },
+              from, out);
+          } else if (s.side < 0) {
+            const std::array<steps_t, 2> steps { from_steps, out_steps };
+            ma::detail::for_each_run(ndims, extent, steps, begin, end,
+              [&s](const float *a, float *o, ptrdiff_t sa, ptrdiff_t so,
+                std::size_t count) {
+                if (s.main_left)
+                  s.binary_kernel(a, sa, &s.scalar, 0, o, so, count);
+                else
+                  s.binary_kernel(&s.scalar, 0, a, sa, o, so, count);
+              },
+              from, out);
+          } else {
+            const std::array<steps_t, 3> steps { from_steps, s.side_steps, out_steps };
+            ma::detail::for_each_run(ndims, extent, steps, begin, end,
+              [&s](const float *a, const float *b, float *o, ptrdiff_t sa, ptrdiff_t sb,
+                ptrdiff_t so, std::size_t count) {
+                if (s.main_left)
+                  s.binary_kernel(a, sa, b, sb, o, so, count);
+                else
+                  s.binary_kernel(b, sb, a, sa, o, so, count);
+              },
+              from, s.side_data, out);
+          }
+          from       = out;
+          from_steps = out_steps;
+        }
+      }
+    };
+
+    // sums of `a` over the axes of `mask` into the contiguous `out`, times `scale`
+    struct reduction {
+      const float *data;
+      int kept, folded;
+      std::array<std::size_t, 6> kept_extent, folded_extent;
+      steps_t kept_steps;
+      std::array<steps_t, 1> folded_steps;
+      float scale;
+      float *out;
+
+      void operator()(const std::size_t begin, const std::size_t end) const
+      {
+        const auto sum { ma::detail::kernels<float>().reduce.sum };
+        for (std::size_t o { begin }; o < end; ++o) {
+          const float *base { data };
+          for (std::size_t i { o }, axis { std::size_t(kept) }; axis-- > 0;) {
+            base += ptrdiff_t(i % kept_extent[axis]) * kept_steps[axis];
+            i /= kept_extent[axis];
+          }
+          double total { 0. };
+          ma::detail::for_each_run(folded, folded_extent, folded_steps,
+            [&](const float *x, ptrdiff_t sx, std::size_t count) {
+              total += sum(x, sx, count);
+            },
+            base);
+          out[o] = float(total * scale);
+        }
+      }
+    };
+
+  }  // namespace
+
+  struct graph::state {
+    std::vector<value> values;
+    std::vector<op_node> nodes;
+    int result { INPUT };
+    ma::dimension input_dim;
+    std::size_t planned { 0 }, unplanned { 0 };
+    workspace ws {};
+    const ma::float32 *p_input { nullptr };
+
+    explicit state(const ma::dimension &input) : input_dim { input }
+    {
+      values.push_back({ input });
+    }
+
+    const ma::float32 &array(const int id) const noexcept
+    {
+      return id == INPUT ? *p_input : values[id].array;
+    }
+
+    int add_value(const ma::dimension &dim, const int producer)
+    {
+      values.push_back({ dim, producer });
+      return int(values.size()) - 1;
+    }
+
+    int add_node(op_node node, const ma::dimension &dim)
+    {
+      node.output = add_value(dim, int(nodes.size()));
+      nodes.push_back(std::move(node));
+      return nodes.back().output;
+    }
+
+    void lower(const std::vector<detail::traced_op> &trace, const detail::node *input,
+      const detail::node *output);
+    void eliminate();
+    void plan();
+    void execute(op_node &node);
+  };
+
+  /////////////////////////////////////// TRACING ///////////////////////////////////////
+
+  void graph::state::lower(const std::vector<detail::traced_op> &trace,
+    const detail::node *input, const detail::node *output)
+  {
+    std::unordered_map<const detail::node *, int> ids { { input, INPUT } };
+    std::unordered_map<const detail::node *, int> uses { { output, 1 } };
+    for (const auto &op : trace)
+      for (const auto &in : op.inputs) ++uses[in.get()];
+
+    // operands which are neither the input nor results of the trace are constants, such
+    // as parameters, whose buffers are shared
+    const auto id_of = [&](const std::shared_ptr<detail::node> &n) {
+      auto [it, inserted] { ids.try_emplace(n.get(), 0) };
+      if (inserted) {
+        values.push_back({ n->value.dim() });
+        values.back().array = n->value;
+        it->second = int(values.size()) - 1;
+      }
+      return it->second;
+    };
+
+    // element-wise steps run in place at the end of the node which made their main
+    // operand, when nothing else reads it and the other operand is ready by then,
+    // otherwise they start a chain
+    const auto elementwise = [&](const detail::traced_op &op, std::vector<step> steps) {
+      const ma::dimension &dim { op.output->value.dim() };
+      const int a { id_of(op.inputs[0]) };
+      const int b { op.inputs.size() > 1 ? id_of(op.inputs[1]) : -1 };
+      const auto fusable = [&](const int main, const detail::node *n, const int side) {
+        const int producer { values[main].producer };
+        return producer >= 0 && uses[n] == 1 && values[main].dim == dim
+               && (side < 0 || values[side].producer < producer);
+      };
+
+      int main { a }, side { b };
+      if (b >= 0 && !fusable(a, op.inputs[0].get(), b)
+          && (fusable(b, op.inputs[1].get(), a)
+            || (values[a].dim != dim && values[b].dim == dim)))
+        std::swap(main, side);
+      if (side >= 0) {
+        steps.front().side      = side;
+        steps.front().main_left = main == a;
+      }
+
+      const detail::node *n { (main == a ? op.inputs[0] : op.inputs[1]).get() };
+      if (fusable(main, n, side)) {
+        auto &producer { nodes[values[main].producer].steps };
+        producer.insert(producer.end(), steps.begin(), steps.end());
+        ids[op.output.get()] = main;
+      } else
+        ids[op.output.get()] = add_node({ node_kind::chain, { main }, 0, {}, 0, 1.F,
+                                          std::move(steps) },
+          dim);
+    };
+
+    const auto binary = [](const binary_op op, const float scalar = 0.F,
+                          const bool main_left = true) {
+      return step { true, op, unary_op::abs, -1, scalar, main_left };
+    };
+    const auto unary = [](const unary_op op) {
+      return step { false, binary_op::add, op };
+    };
+
+    for (const auto &op : trace) {
+      switch (op.code) {
+      case op_code::add: elementwise(op, { binary(binary_op::add) }); break;
+      case op_code::subtract: elementwise(op, { binary(binary_op::subtract) }); break;
+      case op_code::multiply: elementwise(op, { binary(binary_op::multiply) }); break;
+      case op_code::divide: elementwise(op, { binary(binary_op::divide) }); break;
+      case op_code::add_scalar:
+        elementwise(op, { binary(binary_op::add, op.scalar) });
+        break;
+      case op_code::multiply_scalar:
+        elementwise(op, { binary(binary_op::multiply, op.scalar) });
+        break;
+      case op_code::negative: elementwise(op, { unary(unary_op::negative) }); break;
+      case op_code::exp: elementwise(op, { unary(unary_op::exp) }); break;
+      case op_code::log: elementwise(op, { unary(unary_op::log) }); break;
+      case op_code::sqrt: elementwise(op, { unary(unary_op::sqrt) }); break;
+      case op_code::relu: elementwise(op, { binary(binary_op::maximum, 0.F) }); break;
+      case op_code::sigmoid:
+        // 1 / (1 + exp(-x)), as the eager sigmoid computes it
+        elementwise(op, { unary(unary_op::negative), unary(unary_op::exp),
+                          binary(binary_op::add, 1.F),
+                          binary(binary_op::divide, 1.F, false) });
+        break;
+      case op_code::sum:
+      case op_code::mean: {
+        const int a { id_of(op.inputs[0]) };
+        const unsigned mask { ma::detail::axis_mask(values[a].dim, op.axes) };
+        std::size_t count { 1 };
+        for (const int axis : op.axes) count *= values[a].dim[axis];
+        const float scale { op.code == op_code::mean ? 1.F / float(count) : 1.F };
+        ids[op.output.get()] = add_node({ node_kind::reduce, { a }, 0, {}, mask, scale },
+          op.output->value.dim());
+        break;
+      }
+      case op_code::matmul:
+        ids[op.output.get()] = add_node(
+          { node_kind::matmul, { id_of(op.inputs[0]), id_of(op.inputs[1]) } },
+          op.output->value.dim());
+        break;
+      case op_code::conv2d:
+        ids[op.output.get()] = add_node({ node_kind::conv2d,
+                                          { id_of(op.inputs[0]), id_of(op.inputs[1]),
+                                            id_of(op.inputs[2]) },
+                                          0, op.params },
+          op.output->value.dim());
+        break;
+      }
+    }
+
+    // a result which is the input or a constant is copied, so that it is always the
+    // arena's
+    const auto found { ids.find(output) };
+    if (found == ids.end())
+      throw std::invalid_argument { "module output does not come from its input" };
+    result = found->second;
+    if (values[result].producer < 0)
+      result = add_node({ node_kind::chain, { result } }, values[result].dim);
+  }
+
+  void graph::state::eliminate()
+  {
+    std::vector<bool> needed(values.size(), false);
+    needed[result] = true;
+    std::vector<op_node> kept;
+    for (auto it { nodes.rbegin() }; it != nodes.rend(); ++it) {
+      if (!needed[it->output]) continue;
+      for (const int in : it->inputs) needed[in] = true;
+      for (const step &s : it->steps)
+        if (s.side >= 0) needed[s.side] = true;
+      kept.push_back(std::move(*it));
+    }
+    nodes.assign(std::make_move_iterator(kept.rbegin()),
+      std::make_move_iterator(kept.rend()));
+    for (auto &v : values) v.producer = -1;
+    for (std::size_t i { 0 }; i < nodes.size(); ++i)
+      values[nodes[i].output].producer = int(i);
+  }
+
+  ////////////////////////////////////// PLANNING ///////////////////////////////////////
+
+  void graph::state::plan()
+  {
+    const int count { int(nodes.size()) };
+    for (int i { 0 }; i < count; ++i) {
+      for (const int in : nodes[i].inputs) values[in].last = i;
+      for (const step &s : nodes[i].steps)
+        if (s.side >= 0) values[s.side].last = i;
+    }
+    values[result].last = count;
+
+    // a chain result takes over the buffer of its first input when that dies there and
+    // no step reads it as well
+    std::vector<buffer> buffers;
+    for (int i { 0 }; i < count; ++i) {
+      auto &node { nodes[i] };
+      value &out { values[node.output] };
+      unplanned += aligned(out.dim.size() * sizeof(float));
+      if (node.kind == node_kind::chain) {
+        value &in { values[node.inputs[0]] };
+        bool reusable { in.producer >= 0 && in.last == i && in.dim == out.dim };
+        for (const step &s : node.steps) reusable &= s.side != node.inputs[0];
+        if (reusable) {
+          out.buffer                = in.buffer;
+          buffers[out.buffer].last = out.last;
+          continue;
+        }
+      }
+      out.buffer = int(buffers.size());
+      buffers.push_back({ aligned(out.dim.size() * sizeof(float)), i, out.last });
+    }
+
+    // first fit of the largest buffers first, below those alive at the same time
+    std::vector<int> order(buffers.size());
+    for (std::size_t i { 0 }; i < order.size(); ++i) order[i] = int(i);
+    std::stable_sort(order.begin(), order.end(),
+      [&](const int a, const int b) { return buffers[a].bytes > buffers[b].bytes; });
+    std::vector<int> placed;
+    for (const int b : order) {
+      buffer &next { buffers[b] };
+      std::vector<const buffer *> overlapping;
+      for (const int p : placed)
+        if (buffers[p].first <= next.last && next.first <= buffers[p].last)
+          overlapping.push_back(&buffers[p]);
+      std::sort(overlapping.begin(), overlapping.end(),
+        [](const buffer *x, const buffer *y) { return x->offset < y->offset; });
+      std::size_t offset { 0 };
+      for (const buffer *p : overlapping) {
+        if (offset + next.bytes <= p->offset) break;
+        offset = std::max(offset, p->offset + p->bytes);
+      }
+      next.offset = offset;
+      planned     = std::max(planned, offset + next.bytes);
+      placed.push_back(b);
+    }
+
+    // views keep the arena alive, so that results outlive the graph
+    ma::allocator *alloc { &ma::default_allocator() };
+    const std::size_t bytes { std::max<std::size_t>(planned, ma::ALIGNMENT) };
+    const std::shared_ptr<void> arena { alloc->allocate(bytes),
+      [alloc, bytes](void *ptr) { alloc->deallocate(ptr, bytes); } };
+    for (auto &v : values)
+      if (v.buffer >= 0) {
+        float *data { reinterpret_cast<float *>(
+          static_cast<char *>(arena.get()) + buffers[v.buffer].offset) };
+        v.array = ma::float32 { data, v.dim, ma::stride(v.dim), arena };
+      }
+
+    for (auto &node : nodes) {
+      for (step &s : node.steps)
+        if (s.binary)
+          s.binary_kernel =
+            ma::detail::find_kernel<ma::dtype::float32, ma::dtype::float32>(s.bop);
+        else
+          s.unary_kernel = ma::detail::find_kernel<ma::dtype::float32>(s.uop);
+
+      switch (node.kind) {
+      case node_kind::conv2d: node.name = "conv2d"; break;
+      case node_kind::matmul: node.name = "matmul"; break;
+      case node_kind::reduce: node.name = node.scale == 1.F ? "sum" : "mean"; break;
+      case node_kind::chain: node.name = node.steps.empty() ? "copy" : ""; break;
+      }
+      for (const step &s : node.steps) {
+        if (!node.name.empty()) node.name += '+';
+        node.name += s.binary ? BINARY_NAMES[int(s.bop)] : UNARY_NAMES[int(s.uop)];
+      }
+    }
+  }
+
+  ////////////////////////////////////// EXECUTION //////////////////////////////////////
+
+  void graph::state::execute(op_node &node)
+  {
+    ma::float32 &out { values[node.output].array };
+    const ma::dimension &dim { out.dim() };
+
+    switch (node.kind) {
+    case node_kind::conv2d:
+      conv2d(array(node.inputs[0]), array(node.inputs[1]), array(node.inputs[2]), out,
+        node.params, ws);
+      break;
+    case node_kind::matmul:
+      ma::matmul(array(node.inputs[0]), array(node.inputs[1]), out);
+      break;
+    case node_kind::reduce: {
+      const ma::float32 &a { array(node.inputs[0]) };
+      reduction r { a.data(), 0, 0, {}, {}, {}, {}, node.scale, out.data() };
+      for (int i { 0 }; i < a.dim().ndims(); ++i)
+        if (node.mask >> i & 1U) {
+          r.folded_extent[r.folded]      = a.dim()[i];
+          r.folded_steps[0][r.folded++] = a.strides()[i];
+        } else {
+          r.kept_extent[r.kept]  = a.dim()[i];
+          r.kept_steps[r.kept++] = a.strides()[i];
+        }
+      std::size_t folded { 1 };
+      for (int i { 0 }; i < r.folded; ++i) folded *= r.folded_extent[i];
+      const std::size_t grain { std::max<std::size_t>(
+        ma::grain_size() / (std::max<std::size_t>(folded, 1) * sizeof(float)), 1) };
+      const reduction *context { &r };
+      ma::detail::parallel_for(out.size(), grain,
+        [context](std::size_t begin, std::size_t end) { (*context)(begin, end); });
+      break;
+    }
+    case node_kind::chain: break;
+    }
+    if (node.kind != node_kind::chain && node.steps.empty()) return;
+
+    pass p { &node, dim.ndims(), {}, out.data(), {}, out.data(), {} };
+    for (int i { 0 }; i < dim.ndims(); ++i) p.extent[i] = dim[i];
+    p.out_steps = p.source_steps = broadcast(out, dim);
+    if (node.kind == node_kind::chain) {
+      const ma::float32 &source { array(node.inputs[0]) };
+      p.source       = source.data();
+      p.source_steps = broadcast(source, dim);
+    }
+    for (step &s : node.steps)
+      if (s.side >= 0) {
+        s.side_data  = array(s.side).data();
+        s.side_steps = broadcast(array(s.side), dim);
+      }
+
+    const std::size_t grain { std::max(CHUNK, ma::grain_size() / (2 * sizeof(float))) };
+    const pass *context { &p };
+    ma::detail::parallel_for(out.size(), grain,
+      [context](std::size_t begin, std::size_t end) { (*context)(begin, end); });
+  }
+
+  //////////////////////////////////////// GRAPH ////////////////////////////////////////
+
+  graph::graph(module &model, const ma::dimension &input)
+    : p_state { std::make_unique<state>(input) }
+  {
+    std::vector<detail::traced_op> trace;
+    const tensor x { ma::float32 { input, 0.F } };
+    tensor y;
+    {
+      const no_grad guard;
+      const tracing scope { trace };
+      y = model.forward(x);
+    }
+    p_state->lower(trace, detail::node::of(x).get(), detail::node::of(y).get());
+    p_state->eliminate();
+    p_state->plan();
+  }
+
+  graph::~graph() noexcept = default;
+
+  const ma::float32 &graph::run(const ma::float32 &input)
+  {
+    if (input.dim() != p_state->input_dim)
+      throw std::invalid_argument { "input shape does not match the traced one" };
+    p_state->p_input = &input;
+    for (auto &node : p_state->nodes) {
+      const auto start { std::chrono::steady_clock::now() };
+      p_state->execute(node);
+      const std::chrono::duration<double> elapsed { std::chrono::steady_clock::now()
+                                                    - start };
+      node.seconds += elapsed.count();
+      ++node.calls;
+    }
+    p_state->p_input = nullptr;
+    return p_state->values[p_state->result].array;
+  }
+
+  ma::float32 &graph::run(const ma::float32 &input, ma::float32 &out)
+  {
+    if (out.dim() != output())
+      throw std::invalid_argument { "output shape does not match the traced one" };
+    const ma::float32 &result { run(input) };
+    ma::detail::parallel_runs(out.dim(), copy, ma::detail::operand { result.data(),
+      result.strides() }, ma::detail::operand { out.data(), out.strides() });
+    return out;
+  }
+
+  const ma::dimension &graph::input() const noexcept
+  {
+    return p_state->input_dim;
+  }
+
+  const ma::dimension &graph::output() const noexcept
+  {
+    return p_state->values[p_state->result].dim;
+  }
+
+  std::size_t graph::size() const noexcept
+  {
+    return p_state->nodes.size();
+  }
+
+  std::size_t graph::planned_bytes() const noexcept
+  {
+    return p_state->planned;
+  }
+
+  std::size_t graph::unplanned_bytes() const noexcept
+  {
+    return p_state->unplanned;
+  }
+
+  std::size_t graph::workspace_bytes() const noexcept
+  {
+    return p_state->ws.capacity();
+  }
+
+  std::vector<graph::node_profile> graph::profile() const
+  {
+    std::vector<node_profile> out;
+    for (const auto &node : p_state->nodes)
+      out.push_back({ node.name, node.calls, node.seconds });
+    return out;
+  }
+
+  void graph::reset_profile() noexcept
+  {
+    for (auto &node : p_state->nodes) node.calls = 0, node.seconds = 0.;
+  }
+
+  std::string graph::report() const
+  {
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-4s %-40s %8s %12s %12s\n", "#", "node", "calls",
+      "total ms", "mean us");
+    out += line;
+    double total { 0. };
+    for (std::size_t i { 0 }; i < p_state->nodes.size(); ++i) {
+      const auto &node { p_state->nodes[i] };
+      const double mean { node.calls ? node.seconds / double(node.calls) : 0. };
+      std::snprintf(line, sizeof(line), "%-4zu %-40s %8zu %12.3f %12.1f\n", i,
+        node.name.c_str(), node.calls, node.seconds * 1e3, mean * 1e6);
+      out += line;
+      total += node.seconds;
+    }
+    std::snprintf(line, sizeof(line),
+      "total %.3f ms, arena %zu bytes for %zu bytes of results, workspace %zu bytes\n",
+      total * 1e3, planned_bytes(), unplanned_bytes(), workspace_bytes());
+    out += line;
+    return out;
+  }
+
+}  // namespace covdel::nn
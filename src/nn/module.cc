@@ -0,0 +1,142 @@
+#include "covdel/nn/module.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace covdel::nn
+{
+  namespace
+  {
+    thread_local std::mt19937 t_generator { 5489U };
+
+    // uniform within the bound, the scale of kaiming initialization under relu
+    ma::float32 uniform(const ma::dimension &dim, const std::size_t fan_in)
+    {
+      const float bound { 1.F / std::sqrt(float(std::max<std::size_t>(fan_in, 1))) };
+      std::uniform_real_distribution<float> distribution { -bound, bound };
+      ma::float32 out { dim, ma::uninitialized };
+      float *data { out.data() };
+      for (std::size_t i { 0 }; i < out.size(); ++i) data[i] = distribution(t_generator);
+      return out;
+    }
+
+  }  // namespace
+
+  void module::zero_grad()
+  {
+    for (auto &parameter : parameters()) parameter.zero_grad();
+  }
+
+  void manual_seed(const std::uint32_t seed) noexcept
+  {
+    t_generator.seed(seed);
+  }
+
+  ////////////////////////////////////// LINEAR /////////////////////////////////////////
+
+  linear::linear(const std::size_t in, const std::size_t out, const bool bias)
+    : weight { uniform(ma::dimension(in, out), in), true },
+      bias { bias ? tensor { uniform(ma::dimension(out), in), true } : tensor {} }
+  { }
+
+  tensor linear::forward(const tensor &input)
+  {
+    const auto product { matmul(input, weight) };
+    return bias.value().size() ? product + bias : product;
+  }
+
+  std::vector<tensor> linear::parameters() const
+  {
+    if (!bias.value().size()) return { weight };
+    return { weight, bias };
+  }
+
+  //////////////////////////////////// CONVOLUTION //////////////////////////////////////
+
+  convolution::convolution(const std::size_t in, const std::size_t out,
+    const std::array<std::size_t, 2> kernel, const conv2d_params &params, const bool bias)
+    : weight { uniform(ma::dimension(out, in / std::max<std::size_t>(params.groups, 1),
+                         kernel[0], kernel[1]),
+                 in / std::max<std::size_t>(params.groups, 1) * kernel[0] * kernel[1]),
+        true },
+      bias {}, params { params }
+  {
+    const std::size_t fan_in { weight.value().size() / std::max<std::size_t>(out, 1) };
+    if (bias) this->bias = tensor { uniform(ma::dimension(out), fan_in), true };
+  }
+
+  tensor convolution::forward(const tensor &input)
+  {
+    return conv2d(input, weight, bias, params);
+  }
+
+  std::vector<tensor> convolution::parameters() const
+  {
+    if (!bias.value().size()) return { weight };
+    return { weight, bias };
+  }
+
+  ///////////////////////////////////// ACTIVATION //////////////////////////////////////
+
+  activation_layer::activation_layer(const activation kind) noexcept : kind { kind }
+  { }
+
+  tensor activation_layer::forward(const tensor &input)
+  {
+    return kind == activation::relu ? relu(input) : sigmoid(input);
+  }
+
+  /////////////////////////////////////// AFFINE ////////////////////////////////////////
+
+  affine::affine(const std::size_t channels, const layout format)
+    : scale { ma::float32 { format == layout::nhwc ? ma::dimension(channels)
+                                                   : ma::dimension(channels, 1, 1),
+                1.F },
+        true },
+      shift { ma::float32 { scale.dim(), 0.F }, true }, format { format }
+  { }
+
+  tensor affine::forward(const tensor &input)
+  {
+    return input * scale + shift;
+  }
+
+  std::vector<tensor> affine::parameters() const
+  {
+    return { scale, shift };
+  }
+
+  ///////////////////////////////////// CONTAINERS //////////////////////////////////////
+
+  tensor sequential::forward(const tensor &input)
+  {
+    tensor out { input };
+    for (auto &layer : m_layers) out = layer->forward(out);
+    return out;
+  }
+
+  std::vector<tensor> sequential::parameters() const
+  {
+    std::vector<tensor> out;
+    for (const auto &layer : m_layers) {
+      auto inner { layer->parameters() };
+      out.insert(out.end(), inner.begin(), inner.end());
+    }
+    return out;
+  }
+
+  residual::residual(std::unique_ptr<module> body) noexcept : p_body { std::move(body) }
+  { }
+
+  tensor residual::forward(const tensor &input)
+  {
+    return input + p_body->forward(input);
+  }
+
+  std::vector<tensor> residual::parameters() const
+  {
+    return p_body->parameters();
+  }
+
+}  // namespace covdel::nn
@@ -0,0 +1,123 @@
+#ifndef __COVDEL_SRC_NN_TAPE_HH_1702913671__
+#define __COVDEL_SRC_NN_TAPE_HH_1702913671__
+
+#include "covdel/nn/tensor.hh"
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace covdel::nn::detail
+{
+  struct operation;
+
+  // value of a tensor, shared by its copies
+  struct node {
+    ma::float32 value { ma::dimension(0) };
+    ma::float32 grad { ma::dimension(0) };  // of leaves, once a pass reached them
+    bool has_grad { false };
+    bool requires_grad { false };
+    std::shared_ptr<operation> creator;  // none for leaves
+
+    // where gradients of this value are summed, the leaf itself or, for results, the
+    // operation which made it, which hands them on to its operands
+    std::pair<ma::float32 *, bool *> target() noexcept;
+
+    // adds `grad` onto the gradient, adopting its buffer when it is the first one and
+    // `owned`, referred to by nothing else
+    void accumulate(const ma::float32 &grad, bool owned);
+
+    static tensor wrap(std::shared_ptr<node> node) noexcept { return tensor { std::move(node) }; }
+    static const std::shared_ptr<node> &of(const tensor &t) noexcept { return t.p_node; }
+  };
+
+  // an operation recorded on the tape, whose backward function turns the gradient of its
+  // result into those of its operands
+  struct operation {
+    using backward_function = std::function<void(operation &op, const ma::float32 &grad)>;
+
+    std::vector<std::shared_ptr<node>> inputs;
+    backward_function backward;
+    ma::float32 grad { ma::dimension(0) };  // of the result, summed over its uses
+    bool has_grad { false };
+    bool freed { false };
+    std::uint64_t sequence { 0 };  // order of creation, operands always come first
+
+    // whether operand `i` wants a gradient
+    bool needs(const std::size_t i) const noexcept { return inputs[i]->requires_grad; }
+
+    // adds `grad`, summed over the axes it was broadcast along, onto operand `i`
+    void pass(std::size_t i, const ma::float32 &grad, bool owned);
+
+    // gradient of operand `i`, for products which add straight onto it, and whether it
+    // already holds one, it is left unset otherwise
+    std::pair<ma::float32 *, bool> sink(std::size_t i);
+
+    // frees the function and what it kept, the operands and the gradient
+    void release() noexcept;
+  };
+
+  // operations of the functions of tensor.hh, as seen by traces
+  enum class op_code {
+    add,
+    subtract,
+    multiply,
+    divide,
+    add_scalar,
+    multiply_scalar,
+    negative,
+    exp,
+    log,
+    sqrt,
+    relu,
+    sigmoid,
+    sum,
+    mean,
+    matmul,
+    conv2d
+  };
+
+  // an operation on the values of `inputs`, which made `output`, along with its
+  // attributes, those which do not apply being left as they are
+  struct traced_op {
+    op_code code;
+    float scalar {};
+    std::vector<int> axes {};
+    bool keepdims {};
+    conv2d_params params {};
+    std::vector<std::shared_ptr<node>> inputs {};
+    std::shared_ptr<node> output {};
+  };
+
+  // operations on the calling thread are appended to the active trace, if any
+  std::vector<traced_op> *&active_trace() noexcept;
+
+  // whether an operation on these operands is recorded
+  bool recording(std::initializer_list<const tensor *> inputs) noexcept;
+
+  // result of an operation on `inputs`, recorded with `backward`
+  tensor record(const ma::float32 &value, std::initializer_list<const tensor *> inputs,
+    operation::backward_function backward);
+
+  // result of every operation, recorded when recording(inputs), which is the only case
+  // where the backward function is kept, and traced when a trace is active
+  template<typename _Backward>
+  tensor result(const ma::float32 &value, std::initializer_list<const tensor *> inputs,
+    traced_op op, _Backward &&backward)
+  {
+    tensor out { value };
+    if (recording(inputs)) out = record(value, inputs, std::forward<_Backward>(backward));
+    if (auto *trace { active_trace() }) {
+      for (const tensor *t : inputs) op.inputs.push_back(node::of(*t));
+      op.output = node::of(out);
+      trace->push_back(std::move(op));
+    }
+    return out;
+  }
+
+}  // namespace covdel::nn::detail
+
+#endif
@@ -0,0 +1,230 @@
+#include "covdel/nn/tensor.hh"
+
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/reduction.hh"
+#include "tape.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace covdel::nn
+{
+  namespace
+  {
+    thread_local bool t_enabled { true };
+
+    thread_local std::vector<detail::traced_op> *t_trace { nullptr };
+
+    // operations of every thread are ordered, as a graph may span threads
+    std::atomic<std::uint64_t> s_sequence { 0 };
+
+    // sum of `grad` over the axes it was broadcast along from `dim`
+    ma::float32 reduce_to(const ma::float32 &grad, const ma::dimension &dim)
+    {
+      const int lead { grad.dim().ndims() - dim.ndims() };
+      std::vector<int> axes;
+      for (int i { 0 }; i < grad.dim().ndims(); ++i)
+        if (i < lead || (dim[i - lead] == 1 && grad.dim()[i] != 1)) axes.push_back(i);
+      ma::float32 out { ma::sum(grad, axes, true) };
+      return out.reshape(dim);
+    }
+
+  }  // namespace
+
+  /////////////////////////////////////// TAPE //////////////////////////////////////////
+
+  std::pair<ma::float32 *, bool *> detail::node::target() noexcept
+  {
+    if (creator) return { &creator->grad, &creator->has_grad };
+    return { &grad, &has_grad };
+  }
+
+  void detail::node::accumulate(const ma::float32 &grad, const bool owned)
+  {
+    auto [sum, present] { target() };
+    if (*present)
+      ma::add(*sum, grad, *sum);
+    else
+      *sum = owned && grad.is_contiguous() ? grad : grad.copy();
+    *present = true;
+  }
+
+  void detail::operation::pass(const size_t i, const ma::float32 &grad, const bool owned)
+  {
+    if (!needs(i)) return;
+    const auto &dim { inputs[i]->value.dim() };
+    if (grad.dim() == dim)
+      inputs[i]->accumulate(grad, owned);
+    else
+      inputs[i]->accumulate(reduce_to(grad, dim), true);
+  }
+
+  std::pair<ma::float32 *, bool> detail::operation::sink(const size_t i)
+  {
+    auto [sum, present] { inputs[i]->target() };
+    const bool held { *present };
+    if (!held) *sum = ma::float32 { inputs[i]->value.dim(), ma::uninitialized };
+    *present = true;
+    return { sum, held };
+  }
+
+  void detail::operation::release() noexcept
+  {
+    backward = nullptr;
+    inputs.clear();
+    grad     = ma::float32 { ma::dimension(0) };
+    has_grad = false;
+    freed    = true;
+  }
+
+  std::vector<detail::traced_op> *&detail::active_trace() noexcept
+  {
+    return t_trace;
+  }
+
+  bool detail::recording(std::initializer_list<const tensor *> inputs) noexcept
+  {
+    return t_enabled
+           && std::any_of(inputs.begin(), inputs.end(),
+             [](const tensor *t) { return t->requires_grad(); });
+  }
+
+  tensor detail::record(const ma::float32 &value, std::initializer_list<const tensor *> inputs,
+    operation::backward_function backward)
+  {
+    auto op { std::make_shared<operation>() };
+    for (const tensor *t : inputs) op->inputs.push_back(node::of(*t));
+    op->backward = std::move(backward);
+    op->sequence = s_sequence.fetch_add(1, std::memory_order_relaxed);
+
+    auto result { std::make_shared<node>() };
+    result->value         = value;
+    result->requires_grad = true;
+    result->creator       = std::move(op);
+    return node::wrap(std::move(result));
+  }
+
+  ////////////////////////////////////// TENSOR /////////////////////////////////////////
+
+  tensor::tensor() : p_node { std::make_shared<detail::node>() }
+  { }
+
+  tensor::tensor(const ma::float32 &value, const bool requires_grad)
+    : p_node { std::make_shared<detail::node>() }
+  {
+    p_node->value         = value;
+    p_node->requires_grad = requires_grad;
+  }
+
+  tensor::tensor(std::shared_ptr<detail::node> node) noexcept : p_node { std::move(node) }
+  { }
+
+  const ma::float32 &tensor::value() const noexcept
+  {
+    return p_node->value;
+  }
+
+  ma::float32 &tensor::value() noexcept
+  {
+    return p_node->value;
+  }
+
+  const ma::dimension &tensor::dim() const noexcept
+  {
+    return p_node->value.dim();
+  }
+
+  bool tensor::requires_grad() const noexcept
+  {
+    return p_node->requires_grad;
+  }
+
+  tensor &tensor::set_requires_grad(const bool requires)
+  {
+    if (!is_leaf())
+      throw std::invalid_argument { "only leaves may change whether they require gradients" };
+    p_node->requires_grad = requires;
+    return *this;
+  }
+
+  bool tensor::is_leaf() const noexcept
+  {
+    return !p_node->creator;
+  }
+
+  const ma::float32 &tensor::grad() const noexcept
+  {
+    return p_node->grad;
+  }
+
+  void tensor::zero_grad() noexcept
+  {
+    if (p_node->has_grad) p_node->grad.fill(0.F);
+  }
+
+  void tensor::backward()
+  {
+    if (p_node->value.size() != 1)
+      throw std::invalid_argument { "gradients can only be implied for single elements" };
+    backward(ma::float32 { dim(), 1.F });
+  }
+
+  void tensor::backward(const ma::float32 &grad)
+  {
+    if (!p_node->requires_grad)
+      throw std::invalid_argument { "tensor does not require gradients" };
+    if (grad.dim() != dim())
+      throw std::invalid_argument { "gradient shape does not match the tensor" };
+
+    // operations the result came from, run from the latest, each one having received the
+    // gradients of every later use of its result by then
+    std::vector<std::shared_ptr<detail::operation>> tape;
+    std::unordered_set<const detail::operation *> seen;
+    if (p_node->creator) tape.push_back(p_node->creator);
+    for (size_t i { 0 }; i < tape.size(); ++i) {
+      if (tape[i]->freed)
+        throw std::logic_error { "operations were already freed by a backward pass" };
+      for (const auto &input : tape[i]->inputs)
+        if (input->creator && seen.insert(input->creator.get()).second)
+          tape.push_back(input->creator);
+    }
+    std::sort(tape.begin(), tape.end(),
+      [](const auto &a, const auto &b) { return a->sequence > b->sequence; });
+
+    p_node->accumulate(grad, false);
+    for (auto &op : tape) {
+      if (op->has_grad) {
+        const ma::float32 result { std::move(op->grad) };
+        op->grad     = ma::float32 { ma::dimension(0) };
+        op->has_grad = false;
+        op->backward(*op, result);
+      }
+      op->release();
+    }
+  }
+
+  tensor tensor::detach() const
+  {
+    return tensor { p_node->value };
+  }
+
+  ////////////////////////////////////// GRADIENTS //////////////////////////////////////
+
+  bool grad_enabled() noexcept
+  {
+    return t_enabled;
+  }
+
+  no_grad::no_grad() noexcept : m_previous { t_enabled }
+  {
+    t_enabled = false;
+  }
+
+  no_grad::~no_grad() noexcept
+  {
+    t_enabled = m_previous;
+  }
+
+}  // namespace covdel::nn
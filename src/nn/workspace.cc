@@ -0,0 +1,58 @@
+#include "covdel/nn/workspace.hh"
+
+#include <algorithm>
+
+namespace covdel::nn
+{
+  namespace
+  {
+    // capacities are rounded to pages, so that slightly varying requests share them
+    constexpr std::size_t PAGE { 4096 };
+  }
+
+  workspace::workspace(ma::allocator &alloc) noexcept
+    : p_alloc { &alloc }, p_data { nullptr }, m_capacity { 0 }, m_allocations { 0 }
+  { }
+
+  workspace::~workspace() noexcept
+  {
+    release();
+  }
+
+  void *workspace::reserve(const std::size_t bytes)
+  {
+    if (bytes <= m_capacity && p_data) return p_data;
+
+    // the old contents are never needed, so they are released before growing
+    release();
+    const std::size_t capacity { std::max<std::size_t>((bytes + PAGE - 1) / PAGE, 1) * PAGE };
+    p_data     = p_alloc->allocate(capacity);
+    m_capacity = capacity;
+    ++m_allocations;
+    return p_data;
+  }
+
+  void workspace::release() noexcept
+  {
+    if (p_data) p_alloc->deallocate(p_data, m_capacity);
+    p_data     = nullptr;
+    m_capacity = 0;
+  }
+
+  std::size_t workspace::capacity() const noexcept
+  {
+    return m_capacity;
+  }
+
+  std::size_t workspace::allocations() const noexcept
+  {
+    return m_allocations;
+  }
+
+  workspace &default_workspace() noexcept
+  {
+    thread_local workspace s_workspace;
+    return s_workspace;
+  }
+
+}  // namespace covdel::nn
@@ -0,0 +1,317 @@
+#include "../utils.hh"
+#include "covdel/cv/color.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace covdel;
+using ma::D;
+using cv::color;
+using cv::packing;
+
+using triple = std::array<double, 3>;
+
+// reference conversions of [0, 255] samples in double precision, hue in degrees
+triple hsv_of(const triple &p)
+{
+  const auto [r, g, b] { p };
+  const double v { std::max({ r, g, b }) }, d { v - std::min({ r, g, b }) };
+  double h { d == 0 ? 0
+             : v == r ? 60 * (g - b) / d
+             : v == g ? 120 + 60 * (b - r) / d
+                      : 240 + 60 * (r - g) / d };
+  if (h < 0) h += 360;
+  return { h, v == 0 ? 0 : 255 * d / v, v };
+}
+
+triple yuv_of(const triple &p)
+{
+  const double y { 0.299 * p[0] + 0.587 * p[1] + 0.114 * p[2] };
+  return { y, (p[2] - y) * 0.564 + 128, (p[0] - y) * 0.713 + 128 };
+}
+
+// limited range yuv of BT.601, both ways
+triple limited_of(const triple &p)
+{
+  const auto [r, g, b] { p };
+  return { 16 + 0.256788 * r + 0.504129 * g + 0.097906 * b,
+    128 - 0.148223 * r - 0.290993 * g + 0.439216 * b,
+    128 + 0.439216 * r - 0.367788 * g - 0.071427 * b };
+}
+
+triple rgb_of_limited(const double y, const double u, const double v)
+{
+  const double l { 1.164384 * (y - 16) };
+  return { l + 1.596027 * (v - 128), l - 0.391762 * (u - 128) - 0.812968 * (v - 128),
+    l + 2.017232 * (u - 128) };
+}
+
+double saturated(const double v) { return std::min(std::max(v, 0.0), 255.0); }
+
+// uint8 results within one of the saturated reference
+template<typename _Image, typename _Reference>
+bool near(const _Image &image, const _Reference &reference, const double tolerance = 1)
+{
+  for (size_t i { 0 }; i < image.dim()[0]; ++i)
+    for (size_t j { 0 }; j < image.dim()[1]; ++j) {
+      const triple want { reference(i, j) };
+      for (size_t c { 0 }; c < image.dim()[2]; ++c)
+        if (std::fabs(double(image(i, j, c)) - want[c]) > tolerance) return false;
+    }
+  return true;
+}
+
+bool spaces()
+{
+  const auto a { generate<ma::uint8>(D(13, 22, 3), 3) };
+  const auto rgb = [&](const size_t i, const size_t j) {
+    return triple { double(a(i, j, 0)), double(a(i, j, 1)), double(a(i, j, 2)) };
+  };
+
+  const auto bgr { cv::convert_color<ma::uint8>(a, color::rgb, color::bgr) };
+  ASSERT(near(bgr, [&](size_t i, size_t j) {
+    return triple { rgb(i, j)[2], rgb(i, j)[1], rgb(i, j)[0] };
+  }, 0));
+  ASSERT(cv::convert_color<ma::uint8>(bgr, color::bgr, color::rgb) == a);
+
+  auto gray { cv::convert_color<ma::uint8>(a, color::rgb, color::gray) };
+  ASSERT(gray.dim() == D(13, 22, 1));
+  ASSERT(near(gray, [&](size_t i, size_t j) { return yuv_of(rgb(i, j)); }));
+  const auto spread { cv::convert_color<ma::uint8>(gray, color::gray, color::rgb) };
+  ASSERT(near(spread, [&](size_t i, size_t j) {
+    return triple { double(gray(i, j, 0)), double(gray(i, j, 0)), double(gray(i, j, 0)) };
+  }, 0));
+
+  // hue wraps around, so that 0 and 180 are one apart
+  const auto hsv { cv::convert_color<ma::uint8>(a, color::rgb, color::hsv) };
+  for (size_t i { 0 }; i < 13; ++i)
+    for (size_t j { 0 }; j < 22; ++j) {
+      const auto want { hsv_of(rgb(i, j)) };
+      const double dh { std::fabs(hsv(i, j, 0) - want[0] / 2) };
+      ASSERT(std::min(dh, 180 - dh) <= 1);
+      ASSERT(std::fabs(hsv(i, j, 1) - want[1]) <= 1 && hsv(i, j, 2) == want[2]);
+    }
+  const auto yuv { cv::convert_color<ma::uint8>(a, color::rgb, color::yuv) };
+  ASSERT(near(yuv, [&](size_t i, size_t j) { return yuv_of(rgb(i, j)); }));
+
+  // float32 samples range over [0, 1], hue over degrees, and round trips are exact up
+  // to their precision
+  const auto f { cv::convert_color<ma::float32>(a, color::rgb, color::rgb) };
+  ASSERT(std::fabs(f(3, 4, 1) - a(3, 4, 1) / 255.0) < 1e-6);
+  ASSERT(cv::convert_color<ma::uint8>(f, color::rgb, color::rgb) == a);
+  const auto fhsv { cv::convert_color<ma::float32>(f, color::rgb, color::hsv) };
+  const auto want { hsv_of(rgb(5, 7)) };
+  ASSERT(std::fabs(fhsv(5, 7, 0) - want[0]) < 1e-3);
+  ASSERT(std::fabs(fhsv(5, 7, 1) - want[1] / 255) < 1e-6);
+  for (const color space : { color::hsv, color::yuv, color::bgr }) {
+    const auto there { cv::convert_color<ma::float32>(f, color::rgb, space) };
+    const auto back { cv::convert_color<ma::float32>(there, space, color::rgb) };
+    for (size_t i { 0 }; i < f.size(); ++i)
+      ASSERT(std::fabs(back.data()[i] - f.data()[i]) < 1e-4);
+    ASSERT(cv::convert_color<ma::uint8>(
+             cv::convert_color<ma::uint8>(f, color::rgb, space), space, color::rgb)
+             .dim()
+           == a.dim());
+  }
+  TEST_SUCCESS;
+}
+
+bool subsampled()
+{
+  constexpr size_t H { 6 }, W { 10 };
+  const auto planes { generate<ma::uint8>(D(H * 3 / 2, W), 5) };
+  const uint8_t *p { planes.data() };
+  const auto luma = [&](size_t i, size_t j) { return double(p[i * W + j]); };
+  const auto u = [&](size_t i, size_t j) {
+    return double(p[H * W + i / 2 * W / 2 + j / 2]);
+  };
+  const auto v = [&](size_t i, size_t j) {
+    return double(p[H * W + H * W / 4 + i / 2 * W / 2 + j / 2]);
+  };
+  const auto decoded = [&](size_t i, size_t j) {
+    auto rgb { rgb_of_limited(luma(i, j), u(i, j), v(i, j)) };
+    for (auto &s : rgb) s = saturated(s);
+    return rgb;
+  };
+
+  // the same samples as yuv420p, nv12 and yuyv
+  const auto i420 { cv::convert_color<ma::uint8>(planes, color::yuv420p, color::rgb) };
+  ASSERT(i420.dim() == D(H, W, 3) && near(i420, decoded));
+  ma::uint8 nv12 { D(H * 3 / 2, W) }, yuyv { D(H, W, 2) };
+  for (size_t i { 0 }; i < H; ++i)
+    for (size_t j { 0 }; j < W; ++j) {
+      nv12(i, j) = uint8_t(luma(i, j));
+      yuyv(i, j, 0) = uint8_t(luma(i, j));
+      yuyv(i, j, 1) = uint8_t(j % 2 ? v(i, j) : u(i, j));
+      nv12(H + i / 2, j) = uint8_t(j % 2 ? v(i, j) : u(i, j));
+    }
+  ASSERT(cv::convert_color<ma::uint8>(nv12, color::nv12, color::rgb) == i420);
+  ASSERT(cv::convert_color<ma::uint8>(yuyv, color::yuyv, color::rgb) == i420);
+
+  // encoding averages the chroma of each 2x2 block, or pair for yuyv
+  const auto a { generate<ma::uint8>(D(H, W, 3), 7) };
+  const auto at = [&](size_t i, size_t j) {
+    return triple { double(a(i, j, 0)), double(a(i, j, 1)), double(a(i, j, 2)) };
+  };
+  const auto encoded { cv::convert_color<ma::uint8>(a, color::rgb, color::nv12) };
+  const auto planar { cv::convert_color<ma::uint8>(a, color::rgb, color::yuv420p) };
+  const auto packed { cv::convert_color<ma::uint8>(a, color::rgb, color::yuyv) };
+  ASSERT(encoded.dim() == D(H * 3 / 2, W) && packed.dim() == D(H, W, 2));
+  for (size_t i { 0 }; i < H; ++i)
+    for (size_t j { 0 }; j < W; ++j) {
+      const double y { saturated(limited_of(at(i, j))[0]) };
+      ASSERT(std::fabs(encoded(i, j) - y) <= 1 && planar(i, j) == encoded(i, j));
+      ASSERT(packed(i, j, 0) == encoded(i, j));
+      if (i % 2 || j % 2) continue;
+      triple block {}, pair {};
+      for (size_t k { 0 }; k < 4; ++k)
+        for (size_t c { 0 }; c < 3; ++c) {
+          block[c] += at(i + k / 2, j + k % 2)[c] / 4;
+          if (k < 2) pair[c] += at(i, j + k)[c] / 2;
+        }
+      const auto chroma { limited_of(block) }, row_chroma { limited_of(pair) };
+      const uint8_t *q { planar.data() + H * W + i / 2 * W / 2 + j / 2 };
+      ASSERT(std::fabs(encoded(H + i / 2, j) - chroma[1]) <= 1);
+      ASSERT(q[0] == encoded(H + i / 2, j));
+      ASSERT(std::fabs(encoded(H + i / 2, j + 1) - chroma[2]) <= 1);
+      ASSERT(q[H * W / 4] == encoded(H + i / 2, j + 1));
+      ASSERT(std::fabs(packed(i, j, 1) - row_chroma[1]) <= 1);
+      ASSERT(std::fabs(packed(i, j + 1, 1) - row_chroma[2]) <= 1);
+    }
+
+  // between subsampled formats, through rgb
+  const auto recoded { cv::convert_color<ma::uint8>(nv12, color::nv12, color::yuyv) };
+  const auto back { cv::convert_color<ma::uint8>(recoded, color::yuyv, color::nv12) };
+  ASSERT(back.dim() == nv12.dim());
+  TEST_SUCCESS;
+}
+
+bool layouts()
+{
+  const auto nv12 { generate<ma::uint8>(D(36, 40), 9) };
+  const cv::normalization norm { { 0.485F, 0.456F, 0.406F }, { 0.229F, 0.224F, 0.225F } };
+
+  // planar results are decoded straight into their planes, interleaved ones through rows
+  // of planes, with the same results
+  const auto chw { cv::convert_color<ma::float32>(nv12, color::nv12,
+    { color::rgb, packing::planar }, norm) };
+  ASSERT(chw.dim() == D(3, 24, 40));
+  auto hwc { cv::convert_color<ma::float32>(nv12, color::nv12, color::rgb, norm) };
+  ASSERT(hwc.permute({ 2, 0, 1 }) == chw);
+  const auto plain { cv::convert_color<ma::float32>(nv12, color::nv12, color::bgr) };
+  for (size_t c { 0 }; c < 3; ++c)
+    for (size_t i { 0 }; i < 24; ++i)
+      for (size_t j { 0 }; j < 40; ++j) {
+        const float want { (plain(i, j, 2 - c) - norm.mean[c]) / norm.std[c] };
+        ASSERT(std::fabs(chw(c, i, j) - want) < 1e-5F);
+      }
+  const auto bgr_chw { cv::convert_color<ma::float32>(nv12, color::nv12,
+    { color::bgr, packing::planar }) };
+  auto plain_chw { plain.copy() };
+  ASSERT(plain_chw.permute({ 2, 0, 1 }) == bgr_chw);
+
+  // strided sources and destinations, such as channels first views and flipped rows
+  const auto a { generate<ma::uint8>(D(24, 40, 3), 11) };
+  const auto gray { cv::convert_color<ma::uint8>(a, color::rgb, color::gray) };
+  auto planes { a.copy().permute({ 2, 0, 1 }).copy() };
+  ASSERT(cv::convert_color<ma::uint8>(planes, { color::rgb, packing::planar },
+           { color::gray, packing::planar })
+           .reshape(D(24, 40, 1))
+         == gray);
+  auto view { planes };
+  view.permute({ 1, 2, 0 });
+  ASSERT(cv::convert_color<ma::uint8>(view, color::rgb, color::gray) == gray);
+  auto flipped { a.copy() }, reflected { flipped.slice(0, 23, -1, -1) };
+  const auto mirrored { cv::convert_color<ma::uint8>(reflected, color::rgb, color::hsv) };
+  ma::uint8 hsv { D(24, 40, 3) };
+  auto hsv_reflected { hsv.slice(0, 23, -1, -1) };
+  cv::convert_color(a, color::rgb, hsv_reflected, color::hsv);
+  ASSERT(hsv == mirrored);
+
+  // overlapping arrays convert from a copy
+  auto in_place { a.copy() };
+  cv::convert_color(in_place, color::rgb, in_place, color::bgr);
+  ASSERT(in_place == cv::convert_color<ma::uint8>(a, color::rgb, color::bgr));
+  const auto reflected_yuv {
+    cv::convert_color<ma::uint8>(reflected, color::rgb, color::yuv) };
+  cv::convert_color(reflected, color::rgb, flipped, color::yuv);
+  ASSERT(flipped == reflected_yuv);
+  TEST_SUCCESS;
+}
+
+bool errors()
+{
+  const ma::float32 f { D(6, 4) };
+  const ma::uint8 nv12 { D(6, 4) }, odd { D(6, 5) }, rgb { D(4, 4, 3) };
+  ma::uint8 small { D(2, 4, 3) }, bytes { D(4, 4, 3) };
+  ma::float32 floats { D(4, 4, 3) };
+  // floats or odd sizes of subsampled formats, and mismatched shapes
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(f, color::nv12, floats, color::rgb););
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(odd, color::nv12, bytes, color::rgb););
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(nv12, color::nv12, small, color::rgb););
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(rgb, color::rgb, floats, color::nv12););
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(rgb, { color::rgb, packing::planar }, bytes, color::rgb););
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(rgb, color::rgb, bytes, color::bgr, { { 0, 0, 0 }, { 2, 2, 2 } }););
+  const ma::uint8 wide { D(6, 8) };
+  EXPECT_THROW(std::invalid_argument,
+    cv::convert_color(wide.slice(1, 0, 4), color::yuv420p, bytes, color::rgb););
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  const auto a { generate<ma::uint8>(D(30, 70, 3), 13) };
+  const auto nv12 { generate<ma::uint8>(D(45, 70), 17) };
+  const auto convert = [&] {
+    return std::array<ma::float32, 2> {
+      cv::convert_color<ma::float32>(nv12, color::nv12, { color::rgb, packing::planar },
+        { { 0.5F, 0.4F, 0.3F }, { 0.2F, 0.3F, 0.4F } }),
+      cv::convert_color<ma::float32>(a, color::bgr, color::hsv) };
+  };
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  const auto expected { convert() };
+  const auto yuyv { cv::convert_color<ma::uint8>(a, color::rgb, color::yuyv) };
+  const auto gray { cv::convert_color<ma::uint8>(nv12, color::nv12, color::gray) };
+
+  // every level and any split into ranges of rows give identical results
+  ma::thread_pool pool { 3 };
+  ma::set_default_executor(pool);
+  const size_t grain { ma::grain_size() };
+  ma::set_grain_size(1);
+  for (int i { int(ma::isa::scalar) }; i <= int(ma::max_isa()); ++i) {
+    ma::set_isa(ma::isa(i));
+    const auto got { convert() };
+    ASSERT(got[0] == expected[0] && got[1] == expected[1]);
+    ASSERT(cv::convert_color<ma::uint8>(a, color::rgb, color::yuyv) == yuyv);
+    ASSERT(cv::convert_color<ma::uint8>(nv12, color::nv12, color::gray) == gray);
+  }
+  ma::set_grain_size(grain);
+  ma::set_default_executor(ma::thread_pool::instance());
+  ma::set_isa(level);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "color.hh", "colour conversion" };
+
+  tester.run("Spaces", spaces);
+  tester.run("Subsampled", subsampled);
+  tester.run("Layouts", layouts);
+  tester.run("Errors", errors);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,197 @@
+#include "../utils.hh"
+#include "covdel/cv/filter.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using cv::border;
+
+ma::float32 kernel2d(const std::vector<std::vector<float>> &rows)
+{
+  ma::float32 k { D(rows.size(), rows[0].size()) };
+  for (size_t i { 0 }; i < rows.size(); ++i)
+    for (size_t j { 0 }; j < rows[0].size(); ++j) k(i, j) = rows[i][j];
+  return k;
+}
+
+ma::float32 outer(const ma::float32 &kx, const ma::float32 &ky)
+{
+  ma::float32 k { D(ky.size(), kx.size()) };
+  for (size_t i { 0 }; i < ky.size(); ++i)
+    for (size_t j { 0 }; j < kx.size(); ++j) k(i, j) = ky(i) * kx(j);
+  return k;
+}
+
+// plain correlation of (height, width, channels) samples in double precision
+std::vector<double> reference(const std::vector<double> &src, const D &dim,
+  const ma::float32 &k, const border mode, const double value)
+{
+  const auto n { ptrdiff_t(dim[0]) }, m { ptrdiff_t(dim[1]) };
+  const size_t channels { dim.ndims() == 3 ? dim[2] : 1 };
+  const auto kh { ptrdiff_t(k.dim()[0]) }, kw { ptrdiff_t(k.dim()[1]) };
+  const auto map = [&](ptrdiff_t i, const ptrdiff_t size) -> ptrdiff_t {
+    if (i >= 0 && i < size) return i;
+    if (mode == border::constant) return -1;
+    if (mode == border::replicate) return i < 0 ? 0 : size - 1;
+    if (size == 1) return 0;
+    while (i < 0 || i >= size) i = i < 0 ? -i : 2 * size - 2 - i;
+    return i;
+  };
+  std::vector<double> out(src.size());
+  for (ptrdiff_t y { 0 }; y < n; ++y)
+    for (ptrdiff_t x { 0 }; x < m; ++x)
+      for (size_t c { 0 }; c < channels; ++c) {
+        double sum { 0 };
+        for (ptrdiff_t i { 0 }; i < kh; ++i)
+          for (ptrdiff_t j { 0 }; j < kw; ++j) {
+            const ptrdiff_t sy { map(y + i - (kh - 1) / 2, n) };
+            const ptrdiff_t sx { map(x + j - (kw - 1) / 2, m) };
+            const double v { sy < 0 || sx < 0 ? value
+                                              : src[size_t(sy * m + sx) * channels + c] };
+            sum += double(k(size_t(i), size_t(j))) * v;
+          }
+        out[size_t(y * m + x) * channels + c] = sum;
+      }
+  return out;
+}
+
+bool kernels()
+{
+  const auto k5 { cv::sobel_kernel(5, 1) }, s5 { cv::sobel_kernel(5, 0) };
+  ASSERT(k5 == ma::float32(kernel2d({ { -1, -2, 0, 2, 1 } }).reshape(D(5))));
+  ASSERT(s5 == ma::float32(kernel2d({ { 1, 4, 6, 4, 1 } }).reshape(D(5))));
+  ASSERT(cv::sobel_kernel(3, 2) == ma::float32(kernel2d({ { 1, -2, 1 } }).reshape(D(3))));
+  ASSERT(cv::sobel_kernel(1, 0).size() == 1 && cv::sobel_kernel(1, 1).size() == 3);
+  EXPECT_THROW(std::invalid_argument, cv::sobel_kernel(4, 1););
+  EXPECT_THROW(std::invalid_argument, cv::sobel_kernel(3, 3););
+
+  const auto g { cv::gaussian_kernel(7, 1.5) };
+  double total { 0 };
+  for (size_t i { 0 }; i < 7; ++i) total += g(i);
+  ASSERT(std::fabs(total - 1) < 1e-6 && g(3) > g(2) && g(2) == g(4) && g(0) == g(6));
+  ASSERT(cv::gaussian_kernel(3)(1) > 0.5f);
+  EXPECT_THROW(std::invalid_argument, cv::gaussian_kernel(4););
+  TEST_SUCCESS;
+}
+
+bool filters()
+{
+  const D color { 23, 37, 3 }, gray { 31, 19 };
+  const auto a { generate<ma::uint8>(color, 3) };
+  const auto b { generate<ma::float32>(gray, 5) };
+  const auto sa { samples(a) }, sb { samples(b) };
+  const auto full { kernel2d({ { 1, 0, -1 }, { 2, 0.5f, -2 }, { 0, 1, 1 } }) };
+  const auto wide { kernel2d(
+    { { 0.1f, 0.2f, 0.3f, 0.1f }, { 0.05f, 0.1f, 0.05f, 0.1f } }) };
+  const auto kx { cv::gaussian_kernel(5, 1.2) }, ky { cv::gaussian_kernel(3, 0.8) };
+  const auto dx { cv::sobel_kernel(3, 1) }, sm { cv::sobel_kernel(3, 0) };
+
+  for (const border mode : { border::constant, border::replicate, border::reflect }) {
+    ASSERT(close(cv::filter2d(a, full, mode, 9), reference(sa, color, full, mode, 9)));
+    ASSERT(close(cv::filter2d(b, wide, mode, 2), reference(sb, gray, wide, mode, 2)));
+    ASSERT(close(cv::filter2d(b, outer(kx, ky), mode, 1),
+      reference(sb, gray, outer(kx, ky), mode, 1)));
+    ASSERT(close(cv::sep_filter2d(a, kx, ky, mode, 100),
+      reference(sa, color, outer(kx, ky), mode, 100)));
+    ASSERT(close(cv::gaussian_blur(b, 7, 0, mode),
+      reference(sb, gray, outer(cv::gaussian_kernel(7), cv::gaussian_kernel(7)), mode, 0)));
+
+    const ma::float32 mean5x3 { D(5, 3), 1.f / 15 }, ones3x4 { D(3, 4), 1.f };
+    ASSERT(close(cv::box_filter(a, 5, 3, true, mode, 40),
+      reference(sa, color, mean5x3, mode, 40)));
+    ASSERT(close(cv::box_filter(b, 3, 4, false, mode, 7),
+      reference(sb, gray, ones3x4, mode, 7)));
+
+    ASSERT(close(cv::sobel(a, 1, 0, 3, mode),
+      reference(sa, color, outer(dx, sm), mode, 0)));
+    ASSERT(close(cv::sobel(b, 1, 2, 5, mode),
+      reference(sb, gray, outer(cv::sobel_kernel(5, 1), cv::sobel_kernel(5, 2)), mode, 0)));
+    const auto scharr_y { kernel2d({ { -3, -10, -3 }, { 0, 0, 0 }, { 3, 10, 3 } }) };
+    ASSERT(close(cv::scharr(a, 0, 1, mode), reference(sa, color, scharr_y, mode, 0)));
+  }
+
+  // kernels larger than the image reflect back and forth
+  const auto tiny { generate<ma::float32>(D(2, 3), 11) };
+  const ma::float32 big { D(9, 9), 0.01f };
+  ASSERT(close(cv::filter2d(tiny, big),
+    reference(samples(tiny), D(2, 3), big, border::reflect, 0)));
+
+  EXPECT_THROW(std::invalid_argument, cv::gaussian_blur(ma::uint8(D(4)), 3););
+  EXPECT_THROW(std::invalid_argument, cv::filter2d(b, ma::float32(D(3))););
+  EXPECT_THROW(std::invalid_argument, cv::sep_filter2d(b, kx, full););
+  EXPECT_THROW(std::invalid_argument, cv::box_filter(b, 0, 3););
+  EXPECT_THROW(std::invalid_argument, cv::scharr(b, 1, 1););
+  ma::float32 wrong { D(31, 18) };
+  EXPECT_THROW(std::invalid_argument, cv::gaussian_blur(b, wrong, 3););
+  TEST_SUCCESS;
+}
+
+bool layouts()
+{
+  const auto a { generate<ma::uint8>(D(40, 30, 4), 9) };
+  const auto expected { cv::gaussian_blur(a, 5) };
+
+  // strided sources and destinations, such as channels first views
+  auto planar { a.copy().permute({ 2, 0, 1 }).copy() };
+  auto view { planar };
+  view.permute({ 1, 2, 0 });
+  ma::uint8 out { D(4, 40, 30) };
+  auto out_view { out };
+  out_view.permute({ 1, 2, 0 });
+  cv::gaussian_blur(view, out_view, 5);
+  ASSERT(out_view == expected);
+
+  // a flipped view of itself is filtered from a copy
+  auto in_place { a.copy() };
+  cv::gaussian_blur(in_place, in_place, 5);
+  ASSERT(in_place == expected);
+  auto flipped { a.copy() }, reflected { flipped.slice(0, 39, -1, -1) };
+  const auto mirrored { cv::box_filter(reflected, 3, 3) };
+  cv::box_filter(reflected, flipped, 3, 3);
+  ASSERT(flipped == mirrored);
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  const auto a { generate<ma::uint8>(D(64, 150, 3), 13) };
+  const auto b { generate<ma::float32>(D(70, 90), 17) };
+  const auto full { kernel2d({ { 1, 2, 1 }, { 0, 3, 0 }, { -1, 0, 2 } }) };
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  const auto ga { cv::gaussian_blur(a, 7) }, fa { cv::filter2d(a, full) };
+  const auto bb { cv::box_filter(b, 5, 5) }, sb { cv::sobel(b, 1, 1) };
+
+  // every level and any split into bands give identical results
+  ma::thread_pool pool { 3 };
+  ma::set_default_executor(pool);
+  const size_t grain { ma::grain_size() };
+  ma::set_grain_size(1);
+  for (int i { int(ma::isa::scalar) }; i <= int(ma::max_isa()); ++i) {
+    ma::set_isa(ma::isa(i));
+    ASSERT(cv::gaussian_blur(a, 7) == ga && cv::filter2d(a, full) == fa);
+    ASSERT(cv::box_filter(b, 5, 5) == bb && cv::sobel(b, 1, 1) == sb);
+  }
+  ma::set_grain_size(grain);
+  ma::set_default_executor(ma::thread_pool::instance());
+  ma::set_isa(level);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "filter.hh", "image filtering" };
+
+  tester.run("Kernels", kernels);
+  tester.run("Filters", filters);
+  tester.run("Layouts", layouts);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
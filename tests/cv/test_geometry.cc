@@ -0,0 +1,309 @@
+#include "../utils.hh"
+#include "covdel/cv/geometry.hh"
+#include "covdel/ma/allocator.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using cv::border;
+using cv::interpolation;
+
+double cubic(double x)
+{
+  x = std::fabs(x);
+  if (x <= 1) return 1.25 * x * x * x - 2.25 * x * x + 1;
+  if (x < 2) return -0.75 * x * x * x + 3.75 * x * x - 6 * x + 3;
+  return 0;
+}
+
+// weights of the source samples of each destination one along an axis
+std::vector<std::vector<double>> weights(const size_t src, const size_t dst,
+  const interpolation method)
+{
+  const double scale { double(src) / double(dst) };
+  std::vector<std::vector<double>> out(dst, std::vector<double>(src, 0.0));
+  const auto clamp = [&](const double i) {
+    return size_t(std::min(std::max(i, 0.0), double(src - 1)));
+  };
+  for (size_t i { 0 }; i < dst; ++i) {
+    const double s { (double(i) + 0.5) * scale - 0.5 }, base { std::floor(s) };
+    if (method == interpolation::nearest)
+      out[i][clamp(std::floor((double(i) + 0.5) * scale))] = 1;
+    else if (method == interpolation::area && scale > 1)
+      for (size_t j { 0 }; j < src; ++j) {
+        const double low { std::max(double(i) * scale, double(j)) };
+        const double high { std::min(double(i + 1) * scale, double(j + 1)) };
+        out[i][j] = std::max(high - low, 0.0) / scale;
+      }
+    else if (method == interpolation::bicubic)
+      for (int t { -1 }; t <= 2; ++t) out[i][clamp(base + t)] += cubic(s - (base + t));
+    else {
+      out[i][clamp(base)] += 1 - (s - base);
+      out[i][clamp(base + 1)] += s - base;
+    }
+  }
+  return out;
+}
+
+std::vector<double> reference(const std::vector<double> &src, const D &dim,
+  const size_t height, const size_t width, const interpolation method)
+{
+  const size_t channels { dim.ndims() == 3 ? dim[2] : 1 };
+  const auto wy { weights(dim[0], height, method) }, wx { weights(dim[1], width, method) };
+  std::vector<double> out(height * width * channels, 0.0);
+  for (size_t y { 0 }; y < height; ++y)
+    for (size_t x { 0 }; x < width; ++x)
+      for (size_t i { 0 }; i < dim[0]; ++i)
+        for (size_t j { 0 }; j < dim[1]; ++j)
+          for (size_t c { 0 }; c < channels; ++c)
+            out[(y * width + x) * channels + c] +=
+              wy[y][i] * wx[x][j] * src[(i * dim[1] + j) * channels + c];
+  return out;
+}
+
+bool resizes()
+{
+  const D color { 23, 37, 3 }, gray { 31, 19 };
+  const auto a { generate<ma::uint8>(color, 3) };
+  const auto b { generate<ma::float32>(gray, 5) };
+  const auto sa { samples(a) }, sb { samples(b) };
+
+  for (const auto method : { interpolation::nearest, interpolation::bilinear,
+         interpolation::bicubic, interpolation::area }) {
+    ASSERT(cv::resize(a, 23, 37, method) == a && cv::resize(b, 31, 19, method) == b);
+    for (const auto &[h, w] : std::vector<std::pair<size_t, size_t>> {
+           { 7, 12 }, { 11, 16 }, { 50, 41 }, { 23, 90 }, { 1, 1 } }) {
+      ASSERT(close(cv::resize(a, h, w, method), reference(sa, color, h, w, method)));
+      ASSERT(close(cv::resize(b, h, w, method), reference(sb, gray, h, w, method)));
+    }
+  }
+
+  // halving averages blocks of 2 x 2 pixels
+  const auto even { generate<ma::uint8>(D(22, 36, 3), 21) };
+  const auto halved { cv::resize(even, 11, 18, interpolation::area) };
+  for (size_t y { 0 }; y < 11; ++y)
+    for (size_t x { 0 }; x < 18; ++x) {
+      const double mean { (double(even(2 * y, 2 * x, 1)) + even(2 * y, 2 * x + 1, 1)
+                           + even(2 * y + 1, 2 * x, 1) + even(2 * y + 1, 2 * x + 1, 1))
+                          / 4 };
+      ASSERT(std::fabs(halved(y, x, 1) - mean) <= 0.5);
+    }
+
+  // antialiased kernels low-pass a checkerboard towards its mean, which bilinear
+  // interpolation aliases into another checkerboard when it samples every third pixel
+  ma::uint8 board { D(48, 48) };
+  for (size_t y { 0 }; y < 48; ++y)
+    for (size_t x { 0 }; x < 48; ++x) board(y, x) = (x + y) % 2 ? 255 : 0;
+  for (const auto method : { interpolation::bilinear, interpolation::bicubic }) {
+    const auto smooth { cv::resize(board, 16, 16, method, true) };
+    for (size_t i { 0 }; i < smooth.size(); ++i)
+      ASSERT(std::fabs(smooth.data()[i] - 127.5) < 20);
+  }
+  const auto aliased { cv::resize(board, 16, 16, interpolation::bilinear) };
+  ASSERT(aliased(0, 0) == 0 && aliased(0, 1) == 255);
+
+  EXPECT_THROW(std::invalid_argument, cv::resize(a, 4, 4, interpolation(7)););
+  ma::uint8 gray_out { D(5, 5) }, wide { D(5, 5, 4) };
+  EXPECT_THROW(std::invalid_argument, cv::resize(a, gray_out););
+  EXPECT_THROW(std::invalid_argument, cv::resize(a, wide););
+  EXPECT_THROW(std::invalid_argument, cv::resize(ma::uint8(D(2, 2, 2, 2)), 4, 4););
+  TEST_SUCCESS;
+}
+
+// bilinear or bicubic sample of a source with borders, at a coordinate of the source
+double sample(const std::vector<double> &src, const D &dim, const double sx,
+  const double sy, const size_t c, const interpolation method, const border mode,
+  const double value)
+{
+  const auto n { ptrdiff_t(dim[0]) }, m { ptrdiff_t(dim[1]) };
+  const size_t channels { dim.ndims() == 3 ? dim[2] : 1 };
+  const auto map = [&](ptrdiff_t i, const ptrdiff_t size) -> ptrdiff_t {
+    if (i >= 0 && i < size) return i;
+    if (mode == border::constant) return -1;
+    if (mode == border::replicate) return i < 0 ? 0 : size - 1;
+    if (size == 1) return 0;
+    while (i < 0 || i >= size) i = i < 0 ? -i : 2 * size - 2 - i;
+    return i;
+  };
+  const auto at = [&](const ptrdiff_t y, const ptrdiff_t x) {
+    const ptrdiff_t i { map(y, n) }, j { map(x, m) };
+    return i < 0 || j < 0 ? value : src[size_t(i * m + j) * channels + c];
+  };
+  if (method == interpolation::nearest)
+    return at(ptrdiff_t(std::floor(sy + 0.5)), ptrdiff_t(std::floor(sx + 0.5)));
+  const double bx { std::floor(sx) }, by { std::floor(sy) };
+  const int low { method == interpolation::bicubic ? -1 : 0 };
+  const int high { method == interpolation::bicubic ? 2 : 1 };
+  double sum { 0 };
+  for (int i { low }; i <= high; ++i)
+    for (int j { low }; j <= high; ++j) {
+      const double wy { method == interpolation::bicubic ? cubic(sy - by - i)
+                                                         : 1 - std::fabs(sy - by - i) };
+      const double wx { method == interpolation::bicubic ? cubic(sx - bx - j)
+                                                         : 1 - std::fabs(sx - bx - j) };
+      sum += wy * wx * at(ptrdiff_t(by) + i, ptrdiff_t(bx) + j);
+    }
+  return sum;
+}
+
+bool warps()
+{
+  const D color { 23, 37, 3 }, gray { 31, 19 };
+  const auto a { generate<ma::uint8>(color, 7) };
+  const auto b { generate<ma::float32>(gray, 9) };
+  ma::float64 identity { D(2, 3), 0.0 };
+  identity(0, 0) = identity(1, 1) = 1;
+  for (const auto method :
+    { interpolation::nearest, interpolation::bilinear, interpolation::bicubic }) {
+    ASSERT(cv::warp_affine(a, identity, 23, 37, method) == a);
+    ASSERT(cv::warp_affine(b, identity, 31, 19, method) == b);
+  }
+
+  // whole pixel shifts fill the uncovered pixels with the border value
+  auto shift { identity.copy() };
+  shift(0, 2) = 2;
+  shift(1, 2) = -3;
+  const auto shifted { cv::warp_affine(a, shift, 23, 37, interpolation::bilinear,
+    border::constant, 9) };
+  for (size_t y { 0 }; y < 23; ++y)
+    for (size_t x { 0 }; x < 37; ++x)
+      for (size_t c { 0 }; c < 3; ++c)
+        ASSERT(shifted(y, x, c) == (x < 2 || y >= 20 ? 9 : a(y + 3, x - 2, c)));
+
+  // quarter turns of a square image around its centre move whole pixels
+  const auto square { generate<ma::uint8>(D(16, 16, 2), 11) };
+  const auto turn { cv::rotation_matrix(7.5, 7.5, 90) };
+  for (const auto method : { interpolation::nearest, interpolation::bilinear }) {
+    const auto turned { cv::warp_affine(square, turn, 16, 16, method) };
+    for (size_t y { 0 }; y < 16; ++y)
+      for (size_t x { 0 }; x < 16; ++x)
+        ASSERT(turned(y, x, 1) == square(x, 15 - y, 1));
+  }
+
+  // rotated, scaled and sheared
+  const auto sa { samples(a) }, sb { samples(b) };
+  auto m { cv::rotation_matrix(10, 12, 33, 0.8) };
+  m(0, 1) += 0.2;
+  const double det { m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0) };
+  const double inv[6] { m(1, 1) / det, -m(0, 1) / det,
+    (m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2)) / det, -m(1, 0) / det, m(0, 0) / det,
+    (m(1, 0) * m(0, 2) - m(0, 0) * m(1, 2)) / det };
+  for (const auto method :
+    { interpolation::nearest, interpolation::bilinear, interpolation::bicubic })
+    for (const border mode : { border::constant, border::replicate, border::reflect }) {
+      const auto wa { cv::warp_affine(a, m, 20, 30, method, mode, 40) };
+      const auto wb { cv::warp_affine(b, m, 25, 17, method, mode, 3) };
+      std::vector<double> ea(wa.size()), eb(wb.size());
+      for (size_t y { 0 }; y < 25; ++y)
+        for (size_t x { 0 }; x < 30; ++x) {
+          const double sx { inv[0] * double(x) + inv[1] * double(y) + inv[2] };
+          const double sy { inv[3] * double(x) + inv[4] * double(y) + inv[5] };
+          for (size_t c { 0 }; y < 20 && c < 3; ++c)
+            ea[(y * 30 + x) * 3 + c] = sample(sa, color, sx, sy, c, method, mode, 40);
+          if (x < 17) eb[y * 17 + x] = sample(sb, gray, sx, sy, 0, method, mode, 3);
+        }
+      ASSERT(close(wa, ea) && close(wb, eb));
+    }
+
+  // the inverse map samples the source directly
+  auto back { identity.copy() };
+  back(0, 2) = -2;
+  back(1, 2) = 3;
+  ASSERT(cv::warp_affine(a, back, 23, 37, interpolation::bilinear, border::constant, 9,
+           true)
+         == shifted);
+
+  ma::float64 singular { D(2, 3), 1.0 }, wrong { D(3, 3), 0.0 };
+  EXPECT_THROW(std::invalid_argument, cv::warp_affine(a, singular, 5, 5););
+  EXPECT_THROW(std::invalid_argument, cv::warp_affine(a, wrong, 5, 5););
+  EXPECT_THROW(std::invalid_argument,
+    cv::warp_affine(a, identity, 5, 5, interpolation::area););
+  TEST_SUCCESS;
+}
+
+bool layouts()
+{
+  const auto a { generate<ma::uint8>(D(40, 30, 4), 13) };
+  const auto expected { cv::resize(a, 17, 45, interpolation::bicubic) };
+
+  // strided sources and destinations, such as channels first views
+  auto planar { a.copy().permute({ 2, 0, 1 }).copy() };
+  auto view { planar };
+  view.permute({ 1, 2, 0 });
+  ma::uint8 out { D(4, 17, 45) };
+  auto out_view { out };
+  out_view.permute({ 1, 2, 0 });
+  cv::resize(view, out_view, interpolation::bicubic);
+  ASSERT(out_view == expected);
+  cv::resize(view, out_view, interpolation::nearest);
+  ASSERT(out_view == cv::resize(a, 17, 45, interpolation::nearest));
+
+  // a flipped view of itself is warped from a copy
+  const auto turn { cv::rotation_matrix(14.5, 19.5, 30) };
+  auto flipped { a.copy() }, reflected { flipped.slice(0, 39, -1, -1) };
+  const auto turned { cv::warp_affine(reflected, turn, 40, 30) };
+  cv::warp_affine(reflected, flipped, turn);
+  ASSERT(flipped == turned);
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  const auto a { generate<ma::uint8>(D(64, 150, 3), 17) };
+  const auto b { generate<ma::float32>(D(70, 90), 19) };
+  const auto turn { cv::rotation_matrix(40, 30, 17, 1.3) };
+  const auto level { ma::active_isa() };
+  ma::set_isa(ma::isa::scalar);
+  const auto linear { cv::resize(a, 41, 97) };
+  const auto cubic { cv::resize(b, 140, 33, interpolation::bicubic, true) };
+  const auto area { cv::resize(a, 13, 29, interpolation::area) };
+  const auto warped { cv::warp_affine(a, turn, 50, 60, interpolation::bicubic) };
+
+  // every level and any split into ranges of rows give identical results
+  ma::thread_pool pool { 3 };
+  ma::set_default_executor(pool);
+  const size_t grain { ma::grain_size() };
+  ma::set_grain_size(1);
+  for (int i { int(ma::isa::scalar) }; i <= int(ma::max_isa()); ++i) {
+    ma::set_isa(ma::isa(i));
+    ASSERT(cv::resize(a, 41, 97) == linear);
+    ASSERT(cv::resize(b, 140, 33, interpolation::bicubic, true) == cubic);
+    ASSERT(cv::resize(a, 13, 29, interpolation::area) == area);
+    ASSERT(cv::warp_affine(a, turn, 50, 60, interpolation::bicubic) == warped);
+  }
+  ma::set_grain_size(grain);
+  ma::set_isa(level);
+
+  // frames of a stream are resized without allocating once the weights are cached
+  ma::set_default_executor(ma::serial_executor::instance());
+  ma::uint8 frame { D(50, 80, 3) };
+  for (const auto method : { interpolation::bilinear, interpolation::area }) {
+    cv::resize(a, frame, method);
+    ma::tracking_allocator tracker;
+    {
+      const scoped_allocator scope { tracker };
+      cv::resize(a, frame, method);
+    }
+    ASSERT(tracker.stats().allocations == 0);
+  }
+  ma::set_default_executor(ma::thread_pool::instance());
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "geometry.hh", "geometric transforms" };
+
+  tester.run("Resizes", resizes);
+  tester.run("Warps", warps);
+  tester.run("Layouts", layouts);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
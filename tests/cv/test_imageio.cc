@@ -0,0 +1,297 @@
+#include "../utils.hh"
+#include "covdel/cv/imageio.hh"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+using namespace covdel;
+using ma::D;
+using ma::I;
+
+void write_file(const std::string &path, const std::string &bytes)
+{
+  std::ofstream { path, std::ios::binary } << bytes;
+}
+
+// smooth gradients with noise of the seeded sequence on every third row, so that every
+// png filter gets picked
+ma::uint8 gradients(const D &dim)
+{
+  auto out { generate<ma::uint8>(dim, 7) };
+  auto *data { out.data() };
+  for (size_t i { 0 }; i < out.size(); ++i) {
+    const size_t x { i / dim[2] % dim[1] }, y { i / dim[2] / dim[1] };
+    const auto noise { y % 3 == 0 ? data[i] >> 5 : 0 };
+    data[i] = uint8_t(x + 2 * y + (i % dim[2]) * 50 + size_t(noise));
+  }
+  return out;
+}
+
+// value of sample c of the pixel (y, x) in the fixtures
+uint8_t pattern(const size_t y, const size_t x, const size_t c)
+{
+  return uint8_t((y * 40 + x * 30 + c * 70) % 256);
+}
+
+// fixtures encoded by zlib and python, with two IDAT chunks and an ancillary one
+const std::string rgb8 {
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x07"
+  "\x00\x00\x00\x05\x08\x02\x00\x00\x00\x06\xf8\x61\x8f\x00\x00\x00\x0f\x74\x45\x58"
+  "\x74\x43\x6f\x6d\x6d\x65\x6e\x74\x00\x66\x69\x78\x74\x75\x72\x65\x97\x0f\xc6\x58"
+  "\x00\x00\x00\x1e\x49\x44\x41\x54\x78\xda\x63\x60\x70\xeb\x91\x4b\x59\x65\xd3\x74"
+  "\x22\x6a\xc1\xb3\x8a\x7d\x2c\xd3\xee\x28\x6d\xf9\xe5\xc0\xa8\x91\xb7\x45\x4b\xa3"
+  "\x99\xc1\x00\x00\x00\x1e\x49\x44\x41\x54\x0e\x03\x30\x69\x60\x03\xcc\x01\xc5\xd3"
+  "\x94\x95\x17\x2b\xa3\x02\x16\xa0\x0c\x54\x9b\x06\x9c\x90\x03\x00\x59\x7b\x17\xd0"
+  "\x44\x1e\xfa\x22\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82"
+  , 156 };
+const std::string gray16 {
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x09"
+  "\x00\x00\x00\x06\x10\x00\x00\x00\x01\x13\x3b\x07\xcc\x00\x00\x00\x0f\x74\x45\x58"
+  "\x74\x43\x6f\x6d\x6d\x65\x6e\x74\x00\x66\x69\x78\x74\x75\x72\x65\x97\x0f\xc6\x58"
+  "\x00\x00\x00\x29\x49\x44\x41\x54\x78\xda\x63\x60\x60\xfe\xf0\x99\xa1\xa2\x9a\x65"
+  "\xc1\xe2\x0a\x20\x60\xb0\xb1\xdf\xb2\x9d\xf1\xce\xfd\x8a\x0a\xa6\x80\xe0\x9e\xfe"
+  "\x13\xa7\x59\xd8\x1d\x9c\x19\xe4\x14\x5b\x27\xb1\xbc\x00\x00\x00\x29\x49\x44\x41"
+  "\x54\xa3\x62\xa7\xcd\xbc\x74\x95\x31\xaf\xd0\x06\x0c\x98\x02\xa0\x80\x51\x43\x5b"
+  "\x0e\x0d\xc0\xe5\x10\x80\xb9\xa7\xcf\x1c\x08\xb6\x03\x81\x39\x14\x00\x00\x7a\x8e"
+  "\x25\x6d\x48\xbd\x38\x57\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82"
+  , 178 };
+const std::string ga8 {
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x06"
+  "\x00\x00\x00\x07\x08\x04\x00\x00\x01\xf6\x9e\xc4\xf0\x00\x00\x00\x0f\x74\x45\x58"
+  "\x74\x43\x6f\x6d\x6d\x65\x6e\x74\x00\x66\x69\x78\x74\x75\x72\x65\x97\x0f\xc6\x58"
+  "\x00\x00\x00\x2a\x49\x44\x41\x54\x78\xda\x63\x60\x70\x63\xa8\xd8\xc7\xb2\xe0\x59"
+  "\x45\x05\x83\x4d\x13\xe3\x1d\x25\xa6\x80\x69\x3d\x97\x4e\xf0\x31\x9f\x78\x9d\xf7"
+  "\xee\x5d\x1e\x83\x5c\x4a\xd4\x82\x69\x77\x71\x90\x81\x4f\x00\x00\x00\x2a\x49\x44"
+  "\x41\x54\x18\xf3\xb6\xd8\x00\x01\x53\x00\x18\x30\xaf\x0f\x3a\xe6\xe6\xe6\xc6\xa8"
+  "\x91\x27\x07\x07\x50\x29\xa8\x82\x9e\xf5\xe6\xdb\xcd\xb7\x03\x91\xb9\xb9\x39\x00"
+  "\xcd\x2f\x21\xa6\xb2\x92\x7f\xe7\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82"
+  , 180 };
+const std::string palette2 {
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x05"
+  "\x00\x00\x00\x03\x02\x03\x00\x00\x00\x26\x58\x2d\x6b\x00\x00\x00\x0c\x50\x4c\x54"
+  "\x45\x0a\x14\x1e\x28\x32\x3c\x46\x50\x5a\x64\x6e\x78\xc6\x48\x77\xdf\x00\x00\x00"
+  "\x03\x74\x52\x4e\x53\x00\x80\xff\xec\xf7\xb3\x18\x00\x00\x00\x0f\x74\x45\x58\x74"
+  "\x43\x6f\x6d\x6d\x65\x6e\x74\x00\x66\x69\x78\x74\x75\x72\x65\x97\x0f\xc6\x58\x00"
+  "\x00\x00\x08\x49\x44\x41\x54\x78\xda\x63\x90\x66\x60\xcc\xb9\x42\x40\x21\xd8\x00"
+  "\x00\x00\x09\x49\x44\x41\x54\xc2\xe4\xea\x00\x00\x07\x23\x01\xe4\x8e\xeb\x9f\x7f"
+  "\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82"
+  , 152 };
+const std::string gray1 {
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x0a"
+  "\x00\x00\x00\x02\x01\x00\x00\x00\x00\x49\x1a\x70\x7d\x00\x00\x00\x0f\x74\x45\x58"
+  "\x74\x43\x6f\x6d\x6d\x65\x6e\x74\x00\x66\x69\x78\x74\x75\x72\x65\x97\x0f\xc6\x58"
+  "\x00\x00\x00\x07\x49\x44\x41\x54\x78\xda\x63\x08\x75\x60\x5c\x6b\x48\x83\x90\x00"
+  "\x00\x00\x07\x49\x44\x41\x54\x75\x0d\x00\x04\xdc\x02\x17\xf1\x8c\x8b\x30\x00\x00"
+  "\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82"
+  , 110 };
+const std::string bmp4 {
+  "\x42\x4d\x52\x00\x00\x00\x00\x00\x00\x00\x46\x00\x00\x00\x28\x00\x00\x00\x05\x00"
+  "\x00\x00\x03\x00\x00\x00\x01\x00\x04\x00\x00\x00\x00\x00\x0c\x00\x00\x00\x13\x0b"
+  "\x00\x00\x13\x0b\x00\x00\x04\x00\x00\x00\x00\x00\x00\x00\x00\x00\xff\x00\x00\xff"
+  "\x00\x00\xff\x00\x00\x00\x09\x09\x09\x00\x01\x23\x00\x00\x23\x01\x20\x00\x01\x23"
+  "\x00\x00"
+  , 82 };
+const std::string bmp16 {
+  "\x42\x4d\x52\x00\x00\x00\x00\x00\x00\x00\x42\x00\x00\x00\x28\x00\x00\x00\x03\x00"
+  "\x00\x00\xfe\xff\xff\xff\x01\x00\x10\x00\x03\x00\x00\x00\x10\x00\x00\x00\x13\x0b"
+  "\x00\x00\x13\x0b\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xf8\x00\x00\xe0\x07"
+  "\x00\x00\x1f\x00\x00\x00\x4a\x01\x31\x3b\x19\x7d\x00\x00\x15\x5c\xfc\x95\xc4\xd7"
+  "\x00\x00"
+  , 82 };
+
+bool round_trips()
+{
+  for (const size_t channels : { 1, 2, 3, 4 }) {
+    const auto a { gradients(D(37, 53, channels)) };
+    for (const int level : { 0, 1, 6, 9 }) {
+      cv::write_image(scratch("round_trip.png"), a, level);
+      ASSERT(cv::read_image(scratch("round_trip.png")) == a);
+    }
+    if (channels != 2) {
+      cv::write_image(scratch("round_trip.bmp"), a);
+      ASSERT(cv::read_image(scratch("round_trip.bmp")) == a);
+    }
+    if (channels == 1 || channels == 3) {
+      cv::write_image(scratch("round_trip.ppm"), a);
+      ASSERT(cv::read_image(scratch("round_trip.ppm")) == a);
+    }
+    const auto header { cv::inspect_image(scratch("round_trip.png")) };
+    ASSERT(header.format == cv::image_format::png && header.dim == a.dim());
+  }
+
+  // several deflate blocks, and views written through their strides
+  auto big { gradients(D(400, 300, 3)) };
+  const auto view { big.slice(0, 1, 399).permute(I(1, 0, 2)) };
+  cv::write_image(scratch("big.png"), view);
+  ASSERT(cv::read_image(scratch("big.png")) == view);
+  ASSERT(std::filesystem::file_size(scratch("big.png")) < view.size() / 2);
+  cv::write_image(scratch("big.bmp"), view);
+  ASSERT(cv::read_image(scratch("big.bmp")) == view);
+
+  EXPECT_THROW(std::invalid_argument,
+    cv::write_image(scratch("two.ppm"), gradients(D(2, 2, 2))););
+  EXPECT_THROW(std::invalid_argument, cv::write_image(scratch("image.jpg"), big););
+  EXPECT_THROW(std::invalid_argument,
+    cv::write_image(scratch("flat.png"), ma::uint8(D(4, 4))););
+  TEST_SUCCESS;
+}
+
+bool interop()
+{
+  const std::string path { scratch("fixture") };
+  write_file(path, rgb8);
+  const auto a { cv::read_image(path) };
+  ASSERT(a.dim() == D(5, 7, 3) && a(4, 6, 2) == pattern(4, 6, 2));
+  for (size_t i { 0 }; i < a.size(); ++i)
+    ASSERT(a.data()[i] == pattern(i / 21, i / 3 % 7, i % 3));
+
+  // interlaced 16-bit gray keeps the high bytes
+  write_file(path, gray16);
+  const auto b { cv::read_image(path) };
+  ASSERT(b.dim() == D(6, 9, 1));
+  for (size_t i { 0 }; i < b.size(); ++i) ASSERT(b.data()[i] == pattern(i / 9, i % 9, 0));
+
+  write_file(path, ga8);
+  const auto c { cv::read_image(path) };
+  ASSERT(c.dim() == D(7, 6, 2));
+  for (size_t i { 0 }; i < c.size(); ++i)
+    ASSERT(c.data()[i] == pattern(i / 12, i / 2 % 6, i % 2));
+
+  // palette transparency adds alpha, low depth gray is scaled
+  write_file(path, palette2);
+  const auto d { cv::read_image(path) };
+  ASSERT(d.dim() == D(3, 5, 4) && d(0, 0, 3) == 0 && d(0, 1, 3) == 128
+    && d(0, 3, 3) == 255);
+  ASSERT(d(1, 2, 0) == 100 && d(1, 2, 1) == 110 && d(2, 0, 2) == 90);
+  write_file(path, gray1);
+  const auto e { cv::read_image(path) };
+  ASSERT(e.dim() == D(2, 10, 1) && e(0, 0, 0) == 0 && e(0, 1, 0) == 255
+    && e(1, 0, 0) == 255);
+
+  // bottom-up palettes, and top-down bit fields scaled to 8 bits
+  write_file(path, bmp4);
+  const auto f { cv::read_image(path) };
+  ASSERT(f.dim() == D(3, 5, 3) && f(0, 0, 0) == 255 && f(0, 1, 1) == 255
+    && f(1, 0, 2) == 255);
+  ASSERT(f(2, 1, 0) == 0 && f(2, 1, 1) == 255 && f(1, 1, 0) == 9 && f(2, 3, 2) == 9);
+  write_file(path, bmp16);
+  const auto g { cv::read_image(path) };
+  ASSERT(g.dim() == D(2, 3, 3) && g(0, 0, 0) == 0 && g(0, 0, 1) == 40);
+  ASSERT(g(1, 2, 0) == 213 && g(1, 2, 2) == 32);
+
+  // ascii netpbm with comments and other maximum values
+  write_file(path, "P2\n# comment\n3 2\n# another\n15\n0 15 7\n1 2 3\n");
+  const auto h { cv::read_image(path) };
+  ASSERT(h.dim() == D(2, 3, 1) && h(0, 1, 0) == 255 && h(0, 2, 0) == 119
+    && h(1, 0, 0) == 17);
+  write_file(path, "P1 4 1 0110");
+  const auto k { cv::read_image(path) };
+  ASSERT(k(0, 0, 0) == 255 && k(0, 1, 0) == 0 && k(0, 2, 0) == 0 && k(0, 3, 0) == 255);
+  write_file(path, std::string { "P5 2 1 65535\n\xff\xff\x80\x00", 17 });
+  const auto m { cv::read_image(path) };
+  ASSERT(m(0, 0, 0) == 255 && m(0, 1, 0) == 128);
+  TEST_SUCCESS;
+}
+
+bool destinations()
+{
+  const auto a { gradients(D(20, 30, 3)) };
+  cv::write_image(scratch("destination.png"), a);
+  cv::write_image(scratch("destination.bmp"), a);
+
+  // rows land in a window of a larger array, the rest is untouched
+  ma::uint8 canvas { D(24, 40, 3), 7 };
+  auto window { canvas.slice(0, 2, 22).slice(1, 5, 35) };
+  cv::read_image(scratch("destination.png"), window);
+  ASSERT(window == a && canvas(1, 5, 0) == 7 && canvas(2, 4, 2) == 7
+    && canvas(22, 34, 1) == 7);
+  canvas.fill(7);
+  auto flipped { canvas.slice(0, 21, 1, -1).slice(1, 5, 35) };
+  cv::read_image(scratch("destination.bmp"), flipped);
+  ASSERT(flipped == a && canvas(0, 5, 0) == 7);
+
+  ma::uint8 wrong { D(30, 20, 3) };
+  EXPECT_THROW(std::invalid_argument, cv::read_image(scratch("destination.png"), wrong););
+  ma::uint8 planar { D(3, 20, 30) };
+  auto interleaved { planar.permute(I(1, 2, 0)) };
+  EXPECT_THROW(std::invalid_argument,
+    cv::read_image(scratch("destination.png"), interleaved););
+  TEST_SUCCESS;
+}
+
+bool batches()
+{
+  const auto directory { std::filesystem::temp_directory_path() / "covdel_test_batch" };
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directory(directory);
+  std::vector<ma::uint8> images;
+  const char *names[] { "a.png", "b.BMP", "c.ppm", "d.png", "e.bmp", "f.pgm" };
+  for (size_t i { 0 }; i < 6; ++i) {
+    images.push_back(gradients(D(16, 24, i == 5 ? 1 : 3)));
+    images.back().fill(uint8_t(i * 40));
+    cv::write_image((directory / names[i]).string(), images.back());
+  }
+  write_file((directory / "notes.txt").string(), "not an image");
+
+  const auto paths { cv::list_images(directory.string()) };
+  ASSERT(paths.size() == 6 && paths[1] == (directory / "b.BMP").string());
+  const auto decoded { cv::read_images(paths) };
+  for (size_t i { 0 }; i < 6; ++i) ASSERT(decoded[i] == images[i]);
+
+  const std::vector<std::string> same { paths.begin(), paths.end() - 1 };
+  ma::uint8 batch { D(5, 16, 24, 3) };
+  cv::read_images(same, batch);
+  for (size_t i { 0 }; i < 5; ++i) ASSERT(batch(i, 3, 7, 1) == uint8_t(i * 40));
+  ma::uint8 short_batch { D(4, 16, 24, 3) };
+  EXPECT_THROW(std::invalid_argument, cv::read_images(same, short_batch););
+  ma::uint8 mixed { D(6, 16, 24, 3) };
+  EXPECT_THROW(std::invalid_argument, cv::read_images(paths, mixed););
+  std::filesystem::remove_all(directory);
+  TEST_SUCCESS;
+}
+
+bool corruption()
+{
+  const std::string path { scratch("corrupt") };
+  cv::write_image(scratch("valid.png"), gradients(D(32, 32, 3)));
+  std::string bytes;
+  {
+    std::ifstream in { scratch("valid.png"), std::ios::binary };
+    bytes.assign(std::istreambuf_iterator<char> { in }, {});
+  }
+
+  write_file(path, bytes.substr(0, bytes.size() - 30));
+  EXPECT_THROW(std::invalid_argument, cv::read_image(path););
+  auto flipped { bytes };
+  flipped[60] = char(flipped[60] ^ 0x10);
+  write_file(path, flipped);
+  EXPECT_THROW(std::invalid_argument, cv::read_image(path););
+
+  write_file(path, "GIF89a");
+  EXPECT_THROW(std::invalid_argument, cv::inspect_image(path););
+  write_file(path, "P6 100000 100000 255\n");
+  EXPECT_THROW(std::invalid_argument, cv::inspect_image(path););
+  auto rle { bmp4 };
+  rle[30] = 2;
+  write_file(path, rle);
+  EXPECT_THROW(std::invalid_argument, cv::read_image(path););
+  EXPECT_THROW(std::system_error, cv::read_image(scratch("missing.png")););
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "imageio.hh", "image files" };
+
+  tester.run("RoundTrips", round_trips);
+  tester.run("Interop", interop);
+  tester.run("Destinations", destinations);
+  tester.run("Batches", batches);
+  tester.run("Corruption", corruption);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,160 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+
+#include <cstdint>
+#include <thread>
+
+using namespace covdel::ma;
+
+// counts the buffers handed out through the aligned heap
+class counting_allocator : public allocator {
+public:
+  void *allocate(size_t bytes) override
+  {
+    ++allocated;
+    return aligned_allocator::instance().allocate(bytes);
+  }
+
+  void deallocate(void *ptr, size_t bytes) noexcept override
+  {
+    ++released;
+    aligned_allocator::instance().deallocate(ptr, bytes);
+  }
+
+  int allocated { 0 }, released { 0 };
+};
+
+bool aligned(const void *ptr)
+{
+  return reinterpret_cast<std::uintptr_t>(ptr) % ALIGNMENT == 0;
+}
+
+bool factories()
+{
+  const auto z { zeros<int32>(D(3, 5)) };
+  const auto f { full<float64>(D(7), 2.5) };
+  auto e { empty<uint8>(D(4, 33)) };
+  ASSERT(z == int32(D(3, 5), 0) && f == float64(D(7), 2.5));
+  ASSERT(e.dim() == D(4, 33) && e.is_base() && e.is_contiguous());
+  e.fill(9);
+  ASSERT(e(3, 32) == 9 && empty<float32>(D(0)).size() == 0);
+
+  // every buffer is aligned for full width vector loads
+  for (size_t n { 1 }; n < 5000; n = n * 3 + 1) {
+    ASSERT(aligned(empty<uint8>(D(n)).data()) && aligned(zeros<int16>(D(n)).data()));
+    ASSERT(aligned(empty<float64>(D(n), aligned_allocator::instance()).data()));
+  }
+  TEST_SUCCESS;
+}
+
+bool pooling()
+{
+  auto &pool { pool_allocator::instance() };
+  pool.trim();
+  pool.reset_stats();
+
+  // released frames are handed out again, same sized or rounded to the same class
+  const void *first { empty<float32>(D(480, 640, 3)).data() };
+  const void *second { empty<float32>(D(480, 640, 3)).data() };
+  const void *third { empty<uint8>(D(480 * 640 * 3 * 4 - 100)).data() };
+  ASSERT(first == second && second == third);
+  auto stats { pool.stats() };
+  ASSERT(stats.misses == 1 && stats.hits == 2 && stats.cached_bytes >= 480 * 640 * 12);
+
+  // views keep their buffer out of the cache until the last one goes
+  auto frame { empty<float32>(D(480, 640, 3)) };
+  auto view { frame.slice(2, 0, 1) };
+  frame = float32 { D(1) };
+  ASSERT(pool.stats().cached_bytes == 0 && view.data() == first);
+  view = float32 { D(1) };
+  ASSERT(pool.stats().cached_bytes >= 480 * 640 * 12);
+
+  // temporaries of chained operations recycle each other's buffers
+  pool.reset_stats();
+  const auto a { full<float32>(D(1000), 1.f) };
+  for (int i { 0 }; i < 10; ++i) ASSERT(add(multiply(a, 2.f), a)(999) == 3.f);
+  ASSERT(pool.stats().misses <= 3);
+
+  // nothing above the limit is cached, trimming empties the calling thread's cache
+  const size_t limit { pool.limit() };
+  pool.set_limit(1 << 10);
+  pool.trim();
+  { const auto large { empty<uint8>(D(1 << 11)) }; }
+  ASSERT(pool.stats().cached_bytes == 0);
+  { const auto small { empty<uint8>(D(1 << 9)) }; }
+  ASSERT(pool.stats().cached_bytes == 1 << 9);
+  pool.trim();
+  ASSERT(pool.stats().cached_bytes == 0);
+  pool.set_limit(limit);
+  TEST_SUCCESS;
+}
+
+bool threads()
+{
+  auto &pool { pool_allocator::instance() };
+  pool.trim();
+
+  // caches belong to threads, and are returned to the heap when their thread exits
+  size_t cached { 0 };
+  std::thread worker { [&pool, &cached] {
+    for (int i { 0 }; i < 100; ++i) empty<int64>(D(64, 64)).fill(i);
+    cached = pool.stats().cached_bytes;
+  } };
+  worker.join();
+  ASSERT(cached == 64 * 64 * 8 && pool.stats().cached_bytes == 0);
+
+  // the default allocator is chosen per thread, buffers return to the one they came from
+  counting_allocator counter;
+  int16 spawned { D(1) };
+  set_default_allocator(counter);
+  auto local { full<int16>(D(10), 3) };
+  std::thread other { [&spawned] { spawned = zeros<int16>(D(10)); } };
+  other.join();
+  set_default_allocator(pool);
+  ASSERT(counter.allocated == 1 && aligned(local.data()));
+  local = spawned.copy();
+  ASSERT(counter.released == 1 && &default_allocator() == &pool);
+  TEST_SUCCESS;
+}
+
+bool tracking()
+{
+  counting_allocator counter;
+  tracking_allocator tracker { counter };
+
+  // live bytes follow the buffers, the peak keeps the most held at once
+  {
+    const auto a { empty<float32>(D(1000), tracker) };
+    {
+      const auto b { empty<uint8>(D(500), tracker) };
+      ASSERT(tracker.stats().live == 4500 && tracker.stats().peak == 4500);
+    }
+    ASSERT(tracker.stats().live == 4000 && tracker.stats().peak == 4500);
+  }
+  auto stats { tracker.stats() };
+  ASSERT(stats.live == 0 && stats.peak == 4500 && stats.allocations == 2);
+  ASSERT(counter.allocated == 2 && counter.released == 2);
+
+  // as the default allocator, it measures every temporary of a computation
+  tracker.reset_peak();
+  set_default_allocator(tracker);
+  const auto x { full<float32>(D(256), 1.f) };
+  const float32 y { multiply(add(x, 2.f), x) };
+  set_default_allocator(pool_allocator::instance());
+  stats = tracker.stats();
+  ASSERT(y(255) == 3.f && stats.live == 2048 && stats.peak == 3072 && stats.allocations == 3);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "allocator.hh", "aligned and pooled array buffers" };
+
+  tester.run("Factories", factories);
+  tester.run("Pooling", pooling);
+  tester.run("Threads", threads);
+  tester.run("Tracking", tracking);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,165 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using namespace covdel::ma;
+
+// odd sizes exercise the vector remainders of every instruction set level
+static const D shape { 7, 37 };
+
+bool arithmetic()
+{
+  auto a { generate<float32>(shape, [](size_t i) { return float(i) * 0.5f; }) };
+  auto b { generate<float32>(shape, [](size_t i) { return float(i % 5) + 1.f; }) };
+  float32 sum { a + b }, diff { a - b }, prod { a * b }, quot { a / b };
+  for (size_t i { 0 }; i < a.size(); ++i) {
+    ASSERT(sum.data()[i] == a.data()[i] + b.data()[i]);
+    ASSERT(diff.data()[i] == a.data()[i] - b.data()[i]);
+    ASSERT(prod.data()[i] == a.data()[i] * b.data()[i]);
+    ASSERT(quot.data()[i] == a.data()[i] / b.data()[i]);
+  }
+  ASSERT(sum.is_base() && (a * 2.f).eval() == (2.f * a).eval());
+  ASSERT((a * 2.f).eval() == (a + a).eval() && (1.f - a).eval() == (-(a - 1.f)).eval());
+  EXPECT_THROW(std::invalid_argument, (a + float32(D(37, 7))).eval(););
+  TEST_SUCCESS;
+}
+
+bool integers()
+{
+  auto a { generate<uint8>(shape, [](size_t i) { return std::uint8_t(i * 7); }) };
+  auto b { generate<uint8>(shape, [](size_t i) { return std::uint8_t(i % 3); }) };
+  uint8 sum { a + b }, quot { a / b };
+  for (size_t i { 0 }; i < a.size(); ++i) {
+    ASSERT(sum.data()[i] == std::uint8_t(a.data()[i] + b.data()[i]));
+    ASSERT(quot.data()[i] == (b.data()[i] ? a.data()[i] / b.data()[i] : 0));
+  }
+  auto c { array<int32>(D(4), -9) };
+  ASSERT(abs(c) == int32(D(4), 9) && int32(c / -1) == int32(D(4), 9));
+  ASSERT(int8(int8(D(2), -128) - std::int8_t(1)) == int8(D(2), 127));
+  TEST_SUCCESS;
+}
+
+bool comparisons()
+{
+  auto a { generate<int16>(shape, [](size_t i) { return std::int16_t(i % 11) - 5; }) };
+  auto lt { less(a, std::int16_t(0)) }, ge { greater_equal(a, std::int16_t(0)) };
+  ASSERT(lt.type() == datatype::bool8 && lt.dim() == shape);
+  for (size_t i { 0 }; i < a.size(); ++i)
+    ASSERT(lt.data()[i] == (a.data()[i] < 0) && ge.data()[i] != lt.data()[i]);
+  ASSERT(equal(a, a) == bool8(shape, true) && not_equal(a, a) == bool8(shape, false));
+  auto lo { minimum(a, std::int16_t(0)) }, hi { maximum(a, std::int16_t(0)) };
+  ASSERT(int16(lo + hi) == a);
+  auto clamped { clamp(a, std::int16_t(-2), std::int16_t(3)) };
+  ASSERT(clamped == minimum(maximum(a, std::int16_t(-2)), std::int16_t(3)));
+  TEST_SUCCESS;
+}
+
+bool math()
+{
+  auto a { generate<float64>(shape, [](size_t i) { return double(i) + 1.0; }) };
+  auto r { sqrt(a) }, e { exp(log(a)) };
+  for (size_t i { 0 }; i < a.size(); ++i) {
+    ASSERT(r.data()[i] == std::sqrt(a.data()[i]));
+    ASSERT(std::abs(e.data()[i] - a.data()[i]) < 1e-9 * a.data()[i]);
+  }
+
+  // integer results are truncated, saturated, and zero where they are NaN
+  using limits = std::numeric_limits<std::int32_t>;
+  const auto n { generate<int32>(D(5), [](size_t i) { return int(i) * 25 - 50; }) };
+  const auto r_n { sqrt(n) }, l_n { log(n) }, e_n { exp(n) };
+  ASSERT(r_n(0) == 0 && r_n(2) == 0 && r_n(3) == 5 && r_n(4) == 7);
+  ASSERT(l_n(0) == 0 && l_n(2) == limits::lowest() && l_n(4) == 3);
+  ASSERT(e_n(0) == 0 && e_n(2) == 1 && e_n(4) == limits::max());
+  TEST_SUCCESS;
+}
+
+bool in_place()
+{
+  auto a { array<float32>(D(4, 6), 1.f) };
+  const auto *buffer { a.data() };
+  a += 2.f, a *= a, a -= float32(D(4, 6), 1.f);
+  ASSERT(a.data() == buffer && a == float32(D(4, 6), 8.f));
+
+  // views are updated in place, overlapping inputs are read before being written
+  auto base { generate<int32>(D(4, 4), [](size_t i) { return int(i); }) };
+  auto t { base };
+  t.transpose();
+  int32 expected { base + t.copy() };
+  base += t;
+  ASSERT(base == expected);
+  auto column { base.slice(1, 1, 2) };
+  column *= 0;
+  ASSERT(CODE(base[{ 2, 1 }] == 0 && base[{ 2, 2 }] == expected[{ 2, 2 }]));
+  TEST_SUCCESS;
+}
+
+bool broadcasting()
+{
+  // per-channel normalization of an interleaved image
+  auto img { generate<float32>(D(5, 33, 3), [](size_t i) { return float(i); }) };
+  auto mean { generate<float32>(D(3), [](size_t i) { return float(i) + 1.f; }) };
+  float32 scaled { img * mean };
+  ASSERT(scaled.dim() == img.dim());
+  for (size_t y { 0 }; y < 5; ++y)
+    for (size_t x { 0 }; x < 33; ++x)
+      for (size_t c { 0 }; c < 3; ++c) ASSERT(scaled(y, x, c) == img(y, x, c) * mean(c));
+
+  // per-channel bias of a planar batch
+  auto batch { array<int32>(D(2, 3, 4, 5), 10) };
+  auto bias { generate<int32>(D(1, 3, 1, 1), [](size_t i) { return int(i); }) };
+  int32 biased { batch + bias };
+  ASSERT(biased.dim() == batch.dim());
+  ASSERT(biased(1, 0, 3, 4) == 10 && biased(0, 2, 1, 1) == 12);
+
+  // both operands stretched, and broadcasting into an existing output
+  auto column { generate<int32>(D(4, 1), [](size_t i) { return int(i) * 10; }) };
+  auto row { generate<int32>(D(6), [](size_t i) { return int(i); }) };
+  int32 grid { column + row };
+  ASSERT(grid.dim() == D(4, 6) && grid(3, 5) == 35 && grid(2, 0) == 20);
+  grid -= row;
+  ASSERT(grid == column.broadcast_to(D(4, 6)));
+  EXPECT_THROW(std::invalid_argument, row += grid;);
+  EXPECT_THROW(std::invalid_argument, add(img, float32(D(2))););
+
+  // results match fully materialized operands, also with strided views
+  auto view { img.slice(1, 1, 33, 2) };
+  ASSERT((view - mean).eval() == (view.copy() - mean.broadcast_to(view.dim()).copy()).eval());
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  auto a { generate<float32>(shape, [](size_t i) { return float(i) * 0.25f - 20.f; }) };
+  auto b { generate<uint8>(shape, [](size_t i) { return std::uint8_t(i * 13); }) };
+  const auto level { active_isa() };
+  set_isa(isa::scalar);
+  const float32 fa { sqrt(abs(a)) * a + 3.f };
+  const uint8 fb { maximum(b + b, std::uint8_t(9)) };
+  for (int i { int(isa::scalar) }; i <= int(max_isa()); ++i) {
+    set_isa(isa(i));
+    ASSERT(active_isa() == isa(i));
+    ASSERT(fa == sqrt(abs(a)) * a + 3.f && fb == maximum(b + b, std::uint8_t(9)));
+  }
+  set_isa(level);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "arithmetic.hh", "element-wise operations" };
+
+  tester.run("Arithmetic", arithmetic);
+  tester.run("Integers", integers);
+  tester.run("Comparisons", comparisons);
+  tester.run("Math", math);
+  tester.run("In-place", in_place);
+  tester.run("Broadcasting", broadcasting);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
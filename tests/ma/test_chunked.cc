@@ -0,0 +1,182 @@
+#include "../utils.hh"
+#include "covdel/ma/chunked.hh"
+#include "covdel/ma/factory.hh"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace covdel::ma;
+
+// region of `a` as a copy, from `start` with the extents of `shape`
+template<typename _MultiArray>
+_MultiArray region(const _MultiArray &a, const I &start, const D &shape)
+{
+  _MultiArray view { a };
+  for (int i { -1 }; ++i < a.dim().ndims();)
+    view = view.slice(i, start[i], start[i] + shape[i]);
+  return view.copy();
+}
+
+template<typename _MultiArray>
+bool round_trip(const typename _MultiArray::native_type value)
+{
+  const auto path { scratch("round_trip.cvt") };
+  const auto a { generate<_MultiArray>(D(9, 13), [value](size_t i) {
+    return value * (i % 5);
+  }) };
+  save_chunked(path, a, D(4, 4));
+  const chunked_array in { path };
+  ASSERT(in.type() == a.type() && in.dim() == a.dim() && in.tile() == D(4, 4));
+  ASSERT(in.read<_MultiArray>() == a);
+  TEST_SUCCESS;
+}
+
+bool datatypes()
+{
+  ASSERT(round_trip<bool8>(true) && round_trip<int8>(-7) && round_trip<int16>(-300));
+  ASSERT(round_trip<int32>(-70000) && round_trip<int64>(-(int64_t(1) << 40)));
+  ASSERT(round_trip<uint8>(200) && round_trip<uint16>(60000));
+  ASSERT(round_trip<uint32>(1U << 31) && round_trip<uint64>(uint64_t(1) << 63));
+  ASSERT(round_trip<float32>(-1.5f) && round_trip<float64>(1e300));
+  EXPECT_THROW(std::invalid_argument, chunked_array { scratch("round_trip.cvt") }
+                                        .read<float32>(););
+  TEST_SUCCESS;
+}
+
+bool compression()
+{
+  // noisy 16-bit frames only shrink once their high bytes are grouped
+  const auto path { scratch("frames.cvt") };
+  uint32_t state { 12345 };
+  const auto frames { generate<uint16>(D(4, 256, 256), [&state](size_t i) {
+    return uint16_t(1000 + i / 65536 * 300 + ((state = state * 1103515245U + 12345U) >> 26));
+  }) };
+  save_chunked(path, frames, D(1, 128, 128));
+  const auto shuffled { std::filesystem::file_size(path) };
+  ASSERT(chunked_array { path }.read<uint16>() == frames);
+  save_chunked(path, frames, D(1, 128, 128), false);
+  ASSERT(chunked_array { path }.read<uint16>() == frames);
+  ASSERT(shuffled < frames.size() * 2 * 3 / 5 && shuffled < std::filesystem::file_size(path));
+
+  // incompressible tiles are stored raw, strided views are gathered tile by tile
+  auto noise { generate<uint8>(D(300, 200), [&state](size_t) {
+    return uint8_t((state = state * 1103515245U + 12345U) >> 24);
+  }) };
+  const auto view { noise.transpose().slice(0, 199, -1, -1) };
+  save_chunked(path, view, D(64, 64));
+  ASSERT(chunked_array { path }.read<uint8>() == view);
+  ASSERT(std::filesystem::file_size(path) < 300 * 200 + 1024);
+  TEST_SUCCESS;
+}
+
+bool regions()
+{
+  const auto path { scratch("regions.cvt") };
+  const auto a { generate<float32>(D(50, 70, 3), [](size_t i) { return i * 0.5f; }) };
+  save_chunked(path, a, D(16, 16, 3));
+  chunked_array in { path };
+
+  // only the overlapped tiles are decompressed, once while they stay cached
+  ASSERT(in.read<float32>(I(0, 0, 0), D(16, 16, 3)) == region(a, I(0, 0, 0), D(16, 16, 3)));
+  ASSERT(in.stats().misses == 1 && in.stats().hits == 0);
+  ASSERT(in.read<float32>(I(10, 10, 1), D(10, 10, 2)) == region(a, I(10, 10, 1), D(10, 10, 2)));
+  ASSERT(in.stats().misses == 4 && in.stats().hits == 1);
+  ASSERT(in.read<float32>(I(49, 0, 0), D(1, 70, 3)) == region(a, I(49, 0, 0), D(1, 70, 3)));
+  ASSERT(in.read<float32>(I(5, 69, 2), D(45, 1, 1)) == region(a, I(5, 69, 2), D(45, 1, 1)));
+  ASSERT(in.read<float32>(I(3, 3, 0), D(0, 5, 3)).size() == 0);
+  ASSERT(in.read<float32>() == a);
+
+  // the cache holds the most recently used tiles up to its limit
+  ASSERT(in.stats().cached_bytes == a.size() * sizeof(float));
+  in.set_cache_limit(16 * 16 * 3 * sizeof(float));
+  ASSERT(in.stats().cached_bytes <= in.cache_limit());
+  in.read<float32>(I(48, 64, 0), D(2, 6, 3));
+  const size_t misses { in.stats().misses };
+  in.read<float32>(I(48, 64, 0), D(2, 6, 3));
+  ASSERT(in.stats().misses == misses);
+  in.set_cache_limit(0);
+  ASSERT(in.stats().cached_bytes == 0 && in.read<float32>() == a);
+
+  EXPECT_THROW(std::out_of_range, in.read<float32>(I(40, 0, 0), D(11, 1, 1)););
+  EXPECT_THROW(std::invalid_argument, in.read<float32>(I(0, 0), D(1, 1)););
+  TEST_SUCCESS;
+}
+
+bool blocks()
+{
+  // a stack written a frame at a time, the last one never written
+  const auto path { scratch("stack.cvt") };
+  const auto frame { generate<int16>(D(1, 100, 130), [](size_t i) { return int(i % 1000); }) };
+  {
+    chunked_writer out { path, datatype::int16, D(5, 100, 130), D(1, 64, 64) };
+    for (size_t z : { 3, 0, 1, 2 }) out.write(I(z, 0, 0), frame);
+    EXPECT_THROW(std::invalid_argument, out.write(I(4, 0, 10), frame.slice(2, 0, 64)););
+    EXPECT_THROW(std::invalid_argument, out.write(I(4, 0, 0), frame.slice(2, 0, 50)););
+    EXPECT_THROW(std::out_of_range, out.write(I(4, 64, 0), frame););
+    EXPECT_THROW(std::invalid_argument, out.write(I(4, 0, 0), frame.astype<int32>()););
+  }
+  const chunked_array in { path };
+  const auto stack { in.read<int16>() };
+  for (size_t z { 0 }; z < 4; ++z)
+    ASSERT(region(stack, I(z, 0, 0), D(1, 100, 130)) == frame);
+  ASSERT(region(stack, I(4, 0, 0), D(1, 100, 130)) == int16(D(1, 100, 130), 0));
+  TEST_SUCCESS;
+}
+
+bool corruption()
+{
+  const auto path { scratch("corrupt.cvt") };
+  const auto a { generate<uint16>(D(100, 100), [](size_t i) { return uint16_t(i / 7); }) };
+  save_chunked(path, a, D(100, 100));
+
+  // damaged blocks are detected instead of decoded out of bounds
+  {
+    std::fstream file { path, std::ios::in | std::ios::out | std::ios::binary };
+    file.seekp(128);
+    file.write(std::string(16, '\xff').data(), 16);
+  }
+  EXPECT_THROW(std::invalid_argument, chunked_array { path }.read<uint16>(););
+
+  // index entries pointing past the index are rejected
+  const auto b { generate<float32>(D(8, 8), [](size_t i) { return float(i); }) };
+  save_chunked(path, b, D(4, 4));
+  {
+    std::fstream file { path, std::ios::in | std::ios::out | std::ios::binary };
+    file.seekg(-16, std::ios::end);
+    char trailer[8];
+    file.read(trailer, 8);
+    uint64_t index {};
+    for (int i { 8 }; i-- > 0;) index = index << 8 | uint8_t(trailer[i]);
+    char entry[16] {};
+    entry[5] = 1, entry[8] = 8;
+    file.seekp(std::streamoff(index));
+    file.write(entry, 16);
+  }
+  EXPECT_THROW(std::invalid_argument, chunked_array { path }.read<float32>(););
+
+  // unclosed files have no index
+  chunked_writer open { path, datatype::uint8, D(10), D(5) };
+  open.write(I(0), uint8(D(5), 1));
+  EXPECT_THROW(std::invalid_argument, chunked_array { path };);
+  open.close();
+  const auto tail { chunked_array { path }.read<uint8>(I(3), D(5)) };
+  ASSERT(tail(1) == 1 && tail(2) == 0 && tail(4) == 0);
+  EXPECT_THROW(std::logic_error, open.write(I(5), uint8(D(5), 1)););
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "chunked.hh", "chunked array files" };
+
+  tester.run("Datatypes", datatypes);
+  tester.run("Compression", compression);
+  tester.run("Regions", regions);
+  tester.run("Blocks", blocks);
+  tester.run("Corruption", corruption);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
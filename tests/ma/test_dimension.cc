@@ -34,6 +34,10 @@ bool dsi_copy_move()
   d3 = d4, d2_ = d1;
   d4 = std::move(d2_);
   ASSERT(d3 != d4 && d3 == d2 && d4 == d1);
+  ASSERT(std::is_trivially_copyable_v<dimension> && std::is_trivially_copyable_v<index>);
+  constexpr dimension d5 { 4, 2 };
+  constexpr index i5 { 3, 1 };
+  ASSERT(d5.ndims() == 2 && i5.flat(d5) == 7);
   TEST_SUCCESS;
 }
 
@@ -58,6 +62,10 @@ bool dim_specific()
   auto d3 { d1 };
   d3.squeeze();
   ASSERT(d3.str() == "( 3 10 )");
+  ASSERT(broadcast(d1, dimension { 4 }) == dimension(3, 10, 4));
+  ASSERT(broadcast(dimension { 2, 1, 5 }, dimension { 7, 1 }) == dimension(2, 7, 5));
+  ASSERT(broadcast(d2, dimension { 5, 1 }) == d2);
+  EXPECT_THROW(std::invalid_argument, broadcast(d1, d2););
   TEST_SUCCESS;
 }
 
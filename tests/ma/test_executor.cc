@@ -0,0 +1,120 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/factory.hh"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel::ma;
+
+// records the loops handed to it and runs them on the calling thread
+class recording_executor : public executor {
+public:
+  size_t concurrency() const noexcept override { return 1; }
+
+  void parallel_for(size_t count, size_t grain,
+    const std::function<void(size_t, size_t)> &func) override
+  {
+    ++loops;
+    serial_executor::instance().parallel_for(count, grain, func);
+  }
+
+  int loops { 0 };
+};
+
+// every index is visited exactly once, in ranges no shorter than the grain
+bool covered(executor &exec, const size_t count, const size_t grain)
+{
+  std::vector<std::atomic<int>> visits(count);
+  std::atomic<bool> short_range { false };
+  exec.parallel_for(count, grain, [&](size_t begin, size_t end) {
+    if (end - begin < grain && end - begin < count) short_range = true;
+    for (size_t i { begin }; i < end; ++i) ++visits[i];
+  });
+  for (const auto &v : visits)
+    if (v != 1) return false;
+  return !short_range;
+}
+
+bool ranges()
+{
+  thread_pool pool { 3 };
+  ASSERT(pool.concurrency() == 4 && serial_executor::instance().concurrency() == 1);
+  for (const size_t count : { 0, 1, 7, 1000, 100003 })
+    for (const size_t grain : { 0, 1, 3, 64, 5000 })
+      ASSERT(covered(pool, count, grain) && covered(serial_executor::instance(), count, grain));
+  thread_pool inline_pool { 0 };
+  ASSERT(inline_pool.concurrency() == 1 && covered(inline_pool, 500, 1));
+
+  // loops nested inside ranges are helped along by the thread which waits for them
+  std::atomic<size_t> total { 0 };
+  pool.parallel_for(64, 1, [&](size_t begin, size_t end) {
+    for (size_t i { begin }; i < end; ++i)
+      pool.parallel_for(1000, 10, [&](size_t b, size_t e) { total += e - b; });
+  });
+  ASSERT(total == 64000);
+  TEST_SUCCESS;
+}
+
+bool exceptions()
+{
+  thread_pool pool { 3 };
+  std::atomic<int> calls { 0 };
+  EXPECT_THROW(std::runtime_error, pool.parallel_for(10000, 10, [&](size_t begin, size_t) {
+    ++calls;
+    if (begin >= 5000) throw std::runtime_error { "failed range" };
+  }););
+  ASSERT(calls > 0);
+
+  // the pool stays usable after a failed loop
+  ASSERT(covered(pool, 10000, 10));
+  TEST_SUCCESS;
+}
+
+bool operations()
+{
+  thread_pool pool { 3 };
+  set_default_executor(pool);
+  const size_t grain { grain_size() };
+  set_grain_size(1 << 12);
+
+  // large strided operands are split into ranges starting in the middle of rows
+  auto a { array<int32>(D(3, 1001, 7), 0) };
+  auto *data { a.data() };
+  for (size_t i { 0 }; i < a.size(); ++i) data[i] = int(i % 1009);
+  auto t { a };
+  t.permute({ 2, 0, 1 });
+  const auto copied { t.copy() };
+  ASSERT(copied.is_contiguous() && copied(6, 2, 1000) == a(2, 1000, 6));
+  ASSERT(copied == t && copied != a.copy().permute({ 2, 1, 0 }).reshape(copied.dim()));
+  const auto widened { t.astype<float64>() };
+  ASSERT(widened(3, 1, 500) == double(t(3, 1, 500)));
+
+  ASSERT(add(t, t) == multiply(copied, 2) && abs(negative(t)) == t);
+  auto reversed { a.slice(1, 1000, -1, -1) };
+  reversed.fill(5);
+  ASSERT(a == int32(D(3, 1001, 7), 5));
+
+  // small arrays never reach the executor, callers may bring their own
+  recording_executor recorder;
+  set_default_executor(recorder);
+  ASSERT(array<float32>(D(100), 1.f) == float32(D(100), 1.f) && recorder.loops == 0);
+  ASSERT(array<float32>(D(1 << 16), 1.f) == float32(D(1 << 16), 1.f) && recorder.loops == 3);
+
+  set_grain_size(grain);
+  set_default_executor(thread_pool::instance());
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "executor.hh", "parallel loops of array operations" };
+
+  tester.run("Ranges", ranges);
+  tester.run("Exceptions", exceptions);
+  tester.run("Operations", operations);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,172 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/factory.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <type_traits>
+
+using namespace covdel::ma;
+
+bool laziness()
+{
+  auto a { generate<float32>(D(3, 4), [](size_t i) { return float(i); }) };
+  auto b { array<float32>(D(3, 4), 2.f) };
+  auto expr { a * b + 1.f };
+  static_assert(!std::is_same_v<decltype(expr), float32>);
+  ASSERT(expr.dim() == D(3, 4));
+
+  // operands are captured by reference to their buffers, evaluation reads current values
+  b.fill(3.f);
+  float32 result { expr };
+  ASSERT(result.is_base() && result.dim() == D(3, 4));
+  for (size_t i { 0 }; i < a.size(); ++i) ASSERT(result.data()[i] == float(i) * 3.f + 1.f);
+  ASSERT(result == expr.eval());
+  TEST_SUCCESS;
+}
+
+bool fusion()
+{
+  // long runs cover several evaluation blocks and their remainders
+  auto img { generate<uint8>(D(37, 41, 3), [](size_t i) { return std::uint8_t(i * 7); }) };
+  auto mean { generate<float32>(D(3), [](size_t i) { return 100.f + float(i); }) };
+  auto stddev { generate<float32>(D(3), [](size_t i) { return 50.f + float(i) * 10.f; }) };
+
+  const float32 fused { (cast<dtype::float32>(img) - mean) / stddev * 0.5f };
+  const auto eager { multiply(divide(subtract(img.astype<float32>(),
+    mean.broadcast_to(img.dim()).copy()), stddev.broadcast_to(img.dim()).copy()), 0.5f) };
+  ASSERT(fused == eager);
+
+  // conversions with rounding and saturation stay fused as well
+  const conversion quantize { rounding::nearest_even, true };
+  const uint8 quantized { cast<dtype::uint8>(fused * 100.f + 128.f, quantize) };
+  ASSERT(quantized == float32(fused * 100.f + 128.f).astype<uint8>(quantize));
+
+  // nested functions of expressions stay lazy
+  auto x { generate<float64>(D(1000), [](size_t i) { return double(i) - 500.0; }) };
+  const float64 y { clamp(sqrt(abs(x * 2.0)) - 10.0, -5.0, 5.0) };
+  for (size_t i { 0 }; i < x.size(); ++i) {
+    const double v { std::sqrt(std::abs(x.data()[i] * 2.0)) - 10.0 };
+    ASSERT(y.data()[i] == std::min(std::max(v, -5.0), 5.0));
+  }
+  const int32 m { maximum(-generate<int32>(D(9), [](size_t i) { return int(i); }), -4) };
+  ASSERT(m(0) == 0 && m(4) == -4 && m(8) == -4);
+  TEST_SUCCESS;
+}
+
+bool destinations()
+{
+  // evaluation into existing arrays, views and broadcast shapes
+  auto a { generate<int32>(D(4, 6), [](size_t i) { return int(i); }) };
+  auto out { array<int32>(D(4, 6), 0) };
+  const auto *buffer { out.data() };
+  (a * 2 + a).eval(out);
+  ASSERT(out.data() == buffer && out == int32(a * 3));
+
+  auto row { generate<int32>(D(6), [](size_t i) { return int(i); }) };
+  (row + 1).eval(out);
+  ASSERT(out(3, 5) == 6 && out(0, 0) == 1);
+
+  auto column { out.slice(1, 2, 3) };
+  (a.slice(1, 0, 1) * 0 - 1).eval(column);
+  ASSERT(out(2, 2) == -1 && out(2, 1) == 2 && out(2, 3) == 4);
+  EXPECT_THROW(std::invalid_argument, (a + a).eval(row););
+
+  // strided and reversed operands
+  auto reversed { a.slice(1, 5, -1, -1) };
+  const int32 mirrored { reversed - a };
+  ASSERT(mirrored(0, 0) == 5 && mirrored(3, 5) == -5);
+  TEST_SUCCESS;
+}
+
+bool aliasing()
+{
+  // outputs which overlap their operands with another layout are never read after writes
+  auto a { generate<int32>(D(5, 5), [](size_t i) { return int(i); }) };
+  auto t { a };
+  t.transpose();
+  const int32 expected { a.copy() * 2 + t.copy() };
+  (a * 2 + t).eval(a);
+  ASSERT(a == expected);
+
+  auto v { generate<float32>(D(64), [](size_t i) { return float(i); }) };
+  v += v * v - 1.f;
+  ASSERT(v(7) == 7.f + 48.f && v(63) == 63.f + 63.f * 63.f - 1.f);
+  TEST_SUCCESS;
+}
+
+// counts the ranges of the loops it forwards to a pool
+class counting_executor : public executor {
+public:
+  explicit counting_executor(executor &exec) noexcept : m_exec { exec } { }
+
+  size_t concurrency() const noexcept override { return m_exec.concurrency(); }
+
+  void parallel_for(size_t count, size_t grain,
+    const std::function<void(size_t, size_t)> &func) override
+  {
+    m_exec.parallel_for(count, grain, [&](size_t begin, size_t end) {
+      ++ranges;
+      func(begin, end);
+    });
+  }
+
+  std::atomic<int> ranges { 0 };
+
+private:
+  executor &m_exec;
+};
+
+bool parallelism()
+{
+  thread_pool pool { 3 };
+  counting_executor counter { pool };
+  set_default_executor(counter);
+  const size_t grain { grain_size() };
+  set_grain_size(1 << 12);
+
+  // ranges start in the middle of runs of strided and broadcast operands
+  auto a { generate<int32>(D(3, 1001, 7), [](size_t i) { return int(i % 1009); }) };
+  auto t { a };
+  t.permute({ 2, 0, 1 });
+  const auto row { generate<int32>(D(1001), [](size_t i) { return int(i); }) };
+  const int32 fused { t * 3 - row + 1 };
+  ASSERT(counter.ranges > 1);
+  bool matches { true };
+  for (size_t k { 0 }; k < 7; ++k)
+    for (size_t i { 0 }; i < 3; ++i)
+      for (size_t j { 0 }; j < 1001; ++j)
+        matches &= fused(k, i, j) == a(i, j, k) * 3 - int(j) + 1;
+  ASSERT(matches);
+
+  // compound assignments split as well, in place and through strided outputs
+  auto b { a.copy() };
+  const int ranges { counter.ranges };
+  b += b * b;
+  ASSERT(counter.ranges > ranges && b == a * a + a);
+  auto s { a.copy() };
+  auto reversed { s.slice(1, 1000, -1, -1) };
+  reversed -= a.slice(1, 1000, -1, -1);
+  ASSERT(s == int32(D(3, 1001, 7), 0));
+
+  set_default_executor(serial_executor::instance());
+  ASSERT(int32 { t * 3 - row + 1 } == fused);
+  set_grain_size(grain);
+  set_default_executor(thread_pool::instance());
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "expression.hh", "lazily evaluated element-wise expressions" };
+
+  tester.run("Laziness", laziness);
+  tester.run("Fusion", fusion);
+  tester.run("Destinations", destinations);
+  tester.run("Aliasing", aliasing);
+  tester.run("Parallelism", parallelism);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
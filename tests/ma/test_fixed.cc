@@ -0,0 +1,115 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/fixed.hh"
+
+#include <stdexcept>
+
+using namespace covdel::ma;
+
+bool dimensions()
+{
+  constexpr fixed_dimension<3> d { 4, 5, 3 };
+  static_assert(d.size() == 60 && d.ndims() == 3, "sizes fold at compile time\n");
+  static_assert(d.strides()[0] == 15 && d.strides()[1] == 3 && d.strides()[2] == 1,
+    "strides fold at compile time\n");
+  ASSERT(dimension(d) == D(4, 5, 3));
+  ASSERT(fixed_dimension<3> { D(4, 5, 3) } == d);
+  ASSERT(fixed_dimension<3> { D(4, 5, 2) } != d);
+  EXPECT_THROW(std::invalid_argument, fixed_dimension<2> { D(4, 5, 3) };)
+
+  using image = static_dimension<480, 640, 3>;
+  static_assert(image::ndims == 3 && image::size == 480 * 640 * 3, "static shape\n");
+  static_assert(image::offset(2, 1, 2) == 2 * 640 * 3 + 3 + 2, "static offsets\n");
+  ASSERT(image::dim() == D(480, 640, 3));
+  TEST_SUCCESS;
+}
+
+bool conversions()
+{
+  float32 a { D(3, 4, 2) };
+  for (size_t i { 0 }; i < a.size(); ++i) a.data()[i] = float(i);
+
+  // views both ways share the buffer
+  fixed_multiarray<dtype::float32, 3> f { a };
+  ASSERT(f.data() == a.data() && f.is_contiguous());
+  ASSERT(f(2, 1, 1) == a(2, 1, 1));
+  f(0, 3, 1) = -1.F;
+  ASSERT(a(0, 3, 1) == -1.F);
+  const float32 &back = f;
+  ASSERT(back.data() == a.data() && back.dim() == a.dim());
+  EXPECT_THROW(std::invalid_argument, CODE(fixed_multiarray<dtype::float32, 2> g { a };))
+
+  // strided views keep their strides
+  float32 t { a };
+  t.transpose();
+  fixed_multiarray<dtype::float32, 3> ft { t };
+  ASSERT(!ft.is_contiguous() && ft.dim() == fixed_dimension<3>(2, 4, 3));
+  ASSERT(ft(1, 2, 0) == a(0, 2, 1));
+
+  static_multiarray<dtype::float32, 3, 4, 2> s { a };
+  ASSERT(s(2, 3, 1) == a(2, 3, 1) && s.data() == a.data());
+  using mismatched = static_multiarray<dtype::float32, 4, 3, 2>;
+  using transposed = static_multiarray<dtype::float32, 2, 4, 3>;
+  EXPECT_THROW(std::invalid_argument, mismatched { a };)
+  EXPECT_THROW(std::invalid_argument, transposed { t };)
+  const fixed_multiarray<dtype::float32, 3> fs { s };
+  ASSERT(fs.data() == a.data() && fs.dim() == s.dim());
+
+  // reshaping a dynamic view leaves the fixed view on its own buffer
+  fixed_multiarray<dtype::float32, 2> owner { [] {
+    float32 m { D(300, 400) };
+    for (size_t i { 0 }; i < m.size(); ++i) m.data()[i] = float(i);
+    return m.transpose();
+  }() };
+  auto reshaped { owner.view() };
+  reshaped.reshape(D(400, 300));
+  ASSERT(owner(0, 0) == 0.F && owner(1, 0) == 1.F && owner(0, 1) == 400.F);
+  ASSERT(owner.dim() == fixed_dimension<2>(400, 300) && !owner.is_contiguous());
+  TEST_SUCCESS;
+}
+
+bool loops()
+{
+  fixed_multiarray<dtype::int32, 3> f { fixed_dimension<3> { 2, 3, 4 } };
+  f.for_each_indexed([](int &value, size_t i, size_t j, size_t k) {
+    value = int(i * 100 + j * 10 + k);
+  });
+  ASSERT(f(1, 2, 3) == 123 && f(0, 1, 0) == 10);
+
+  // traversal of a strided view follows its own row-major order
+  int32 t { f.view() };
+  t.transpose();
+  const fixed_multiarray<dtype::int32, 3> ft { t };
+  int previous { -1 }, count { 0 };
+  bool ordered { true };
+  ft.for_each_indexed([&](const int &value, size_t k, size_t j, size_t i) {
+    ordered &= value == int(i * 100 + j * 10 + k);
+    ++count;
+  });
+  ASSERT(ordered && count == 24);
+  long sum { 0 };
+  ft.for_each([&](const int &value) { sum += value, previous = value; });
+  ASSERT(sum == 12 * 100 + 8 * (10 + 20) + 6 * (1 + 2 + 3) && previous == 123);
+
+  fixed_multiarray<dtype::int32, 3> filled { fixed_dimension<3> { 2, 2, 2 }, 7 };
+  filled.fill(3);
+  int total { 0 };
+  filled.for_each([&](int value) { total += value; });
+  ASSERT(total == 24);
+
+  static_multiarray<dtype::uint8, 2, 3> s { 5 };
+  s(1, 2) = 9;
+  ASSERT(s.view()(1, 2) == 9 && s(0, 0) == 5);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "fixed.hh", "multiarrays of fixed rank and static shape" };
+
+  tester.run("Dimensions", dimensions);
+  tester.run("Conversions", conversions);
+  tester.run("Loops", loops);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
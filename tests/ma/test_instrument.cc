@@ -0,0 +1,131 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/instrument.hh"
+#include "covdel/ma/reduction.hh"
+
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+using namespace covdel::ma;
+
+uint64_t calls(const instrument_snapshot &s)
+{
+  return std::accumulate(s.operations.begin(), s.operations.end(), uint64_t(0),
+    [](uint64_t total, const operation_stats &op) { return total + op.calls; });
+}
+
+bool counters()
+{
+  reset_instrumentation();
+  {
+    const float32 a { D(64, 64), 2.F };
+    const float32 b { a.copy() };
+    const uint8 c { a.astype<uint8>() };
+    const float32 d { add(a, b) };
+    sum(d);
+  }
+  const instrument_snapshot s { snapshot() };
+
+  // without COVDEL_INSTRUMENT the probes are compiled out and nothing is recorded
+  if (!instrumented()) {
+    ASSERT(calls(s) == 0 && s[datatype::float32].allocated == 0 && s.peak_bytes == 0);
+    TEST_SUCCESS;
+  }
+  const uint64_t bytes { 64 * 64 * sizeof(float) };
+  ASSERT(s[operation::allocate].calls >= 4 && s[operation::fill].calls == 1);
+  ASSERT(s[operation::copy].calls == 1 && s[operation::convert].calls == 1);
+  ASSERT(s[operation::elementwise].calls == 1 && s[operation::reduce].calls == 1);
+  ASSERT(s[datatype::float32].allocated >= 3 * bytes);
+  ASSERT(s[datatype::float32].copied == bytes && s[datatype::float32].converted == 0);
+  ASSERT(s[datatype::uint8].converted == 64 * 64);
+  ASSERT(s[datatype::uint8].allocated == 64 * 64);
+  ASSERT(s.peak_bytes >= s.live_bytes + 3 * bytes + 64 * 64);
+
+  // every call lands in a bucket of the histogram
+  for (const auto &op : s.operations) {
+    const auto &h { op.histogram };
+    ASSERT(std::accumulate(h.begin(), h.end(), uint64_t(0)) == op.calls);
+    if (op.calls) ASSERT(op.percentile(1.) * double(op.calls) >= double(op.nanoseconds));
+  }
+
+  reset_instrumentation();
+  const instrument_snapshot empty { snapshot() };
+  ASSERT(calls(empty) == 0 && empty.peak_bytes == empty.live_bytes);
+  TEST_SUCCESS;
+}
+
+bool threads()
+{
+  reset_instrumentation();
+  const float32 a { D(1000), 1.F };
+  std::thread workers[4];
+  for (auto &worker : workers)
+    worker = std::thread { [&a] {
+      for (int i { 0 }; i < 25; ++i) a.copy();
+    } };
+  for (auto &worker : workers) worker.join();
+
+  // counters of exited threads are kept
+  const instrument_snapshot s { snapshot() };
+  ASSERT(s[operation::copy].calls == (instrumented() ? 100 : 0));
+  const uint64_t copied { instrumented() ? 100 * 1000 * sizeof(float) : 0 };
+  ASSERT(s[datatype::float32].copied == copied);
+
+  // probes of destructors running after the counters of their thread were retired are
+  // dropped, their allocations still count as live bytes until released
+  struct exit_copy {
+    ~exit_copy() { a.copy(); }
+    const float32 &a;
+  };
+  const std::size_t live { snapshot().live_bytes };
+  std::thread { [&a] {
+    thread_local exit_copy last { a };
+    a.copy();
+  } }.join();
+  const instrument_snapshot after { snapshot() };
+  ASSERT(after[operation::copy].calls == (instrumented() ? 101 : 0));
+  ASSERT(after.live_bytes == live);
+  TEST_SUCCESS;
+}
+
+bool timeline()
+{
+  start_trace();
+  ASSERT(tracing());
+  {
+    const int32 a { D(128), 3 };
+    a.astype<float64>();
+  }
+  stop_trace();
+  const int32 untraced { D(16), 1 };
+
+  std::ostringstream out;
+  write_chrome_trace(out);
+  const std::string trace { out.str() };
+  ASSERT(trace.find("\"traceEvents\": [") != std::string::npos);
+  const std::string converted { "{\"name\": \"convert\", \"cat\": \"float64\"" };
+  ASSERT((trace.find(converted) != std::string::npos) == instrumented());
+  ASSERT((trace.find("\"live bytes\"") != std::string::npos) == instrumented());
+  ASSERT(trace.find("\"bytes\": 64}") == std::string::npos);
+
+  // each trace starts empty
+  start_trace();
+  stop_trace();
+  std::ostringstream again;
+  write_chrome_trace(again);
+  ASSERT(again.str().find("convert") == std::string::npos);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "instrument.hh", "instrumentation of array operations" };
+
+  tester.run("Counters", counters);
+  tester.run("Threads", threads);
+  tester.run("Timeline", timeline);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,211 @@
+#include "../utils.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cmath>
+#include <limits>
+
+using namespace covdel::ma;
+
+// values in [-1, 1] on a grid of hundredths, varying with the seed
+template<typename _MultiArray>
+_MultiArray uniform(const D &dim, const size_t seed)
+{
+  return generate<_MultiArray>(
+    dim, [seed](size_t i) { return double((i * 7919 + seed) % 201) / 100 - 1; });
+}
+
+// product of the matrices of two 2-D views in double precision
+template<typename _MultiArray>
+float64 reference(const _MultiArray &a, const _MultiArray &b)
+{
+  const size_t m { a.dim()[0] }, k { a.dim()[1] }, n { b.dim()[1] };
+  float64 out { D(m, n) };
+  for (size_t i { 0 }; i < m; ++i)
+    for (size_t j { 0 }; j < n; ++j) {
+      double sum { 0 };
+      for (size_t p { 0 }; p < k; ++p) sum += double(a(i, p)) * double(b(p, j));
+      out(i, j) = sum;
+    }
+  return out;
+}
+
+// every element within `tolerance` of the reference, relative to the depth of the sums
+template<typename _MultiArray>
+bool near(const _MultiArray &c, const float64 &expected, const double tolerance)
+{
+  if (c.dim() != expected.dim()) return false;
+  const size_t m { c.dim()[0] }, n { c.dim()[1] };
+  for (size_t i { 0 }; i < m; ++i)
+    for (size_t j { 0 }; j < n; ++j)
+      if (std::abs(double(c(i, j)) - expected(i, j)) > tolerance) return false;
+  return true;
+}
+
+bool products()
+{
+  // shapes around the tiles and cache blocks of every level, and past them
+  const size_t shapes[][3] { { 1, 1, 1 }, { 5, 3, 7 }, { 13, 33, 17 }, { 64, 64, 64 },
+    { 37, 300, 45 }, { 130, 520, 70 }, { 250, 70, 1100 } };
+  for (const auto &[m, k, n] : shapes) {
+    const auto a { uniform<float32>(D(m, k), m) }, b { uniform<float32>(D(k, n), n) };
+    const auto expected { reference(a, b) };
+    ASSERT(near(matmul(a, b), expected, 1e-5 * double(k)));
+    const auto a64 { uniform<float64>(D(m, k), m) }, b64 { uniform<float64>(D(k, n), n) };
+    ASSERT(near(matmul(a64, b64), reference(a64, b64), 1e-12 * double(k)));
+  }
+
+  // empty products, and products along no depth, which are zero
+  ASSERT(matmul(float32(D(0, 4)), float32(D(4, 3))).dim() == D(0, 3));
+  ASSERT(matmul(float64(D(3, 0)), float64(D(0, 2))) == float64(D(3, 2), 0.0));
+  TEST_SUCCESS;
+}
+
+bool scaling()
+{
+  const auto a { uniform<float64>(D(40, 30), 1) }, b { uniform<float64>(D(30, 50), 2) };
+  const auto ab { reference(a, b) };
+  auto c { uniform<float64>(D(40, 50), 3) };
+  const auto before { c.copy() };
+  gemm(a, b, c, 2.0, -0.5);
+  for (size_t i { 0 }; i < 40; ++i)
+    for (size_t j { 0 }; j < 50; ++j)
+      ASSERT(std::abs(c(i, j) - (2 * ab(i, j) - 0.5 * before(i, j))) < 1e-12);
+
+  // a zero beta never reads c, a zero alpha never reads a and b
+  auto garbage { float64(D(40, 50), std::numeric_limits<double>::quiet_NaN()) };
+  ASSERT(near(gemm(a, b, garbage), ab, 1e-12));
+  auto nan_a { float64(D(40, 30), std::numeric_limits<double>::quiet_NaN()) };
+  auto ones { float64(D(40, 50), 1.0) };
+  ASSERT(gemm(nan_a, b, ones, 0.0, 3.0) == float64(D(40, 50), 3.0));
+  TEST_SUCCESS;
+}
+
+bool transposed()
+{
+  // transposed operands are read through their strides, as flags or as views
+  const auto a { uniform<float32>(D(45, 70), 4) }, b { uniform<float32>(D(33, 45), 5) };
+  auto at { a }, bt { b };
+  at.transpose();
+  bt.transpose();
+  const auto expected { reference(at.copy(), bt.copy()) };
+  ASSERT(near(matmul(at, bt), expected, 1e-4));
+  float32 c { D(70, 33) };
+  ASSERT(near(gemm(a, b, c, 1.f, 0.f, true, true), expected, 1e-4));
+  ASSERT(gemm(a, b, c, 1.f, 0.f, true, true) == matmul(at.copy(), bt.copy()));
+
+  // reversed and sliced views
+  const auto big { uniform<float64>(D(60, 80), 6) };
+  const auto view { big.slice(0, 50, 10, -2).slice(1, 3, 80, 3) };
+  const auto square { uniform<float64>(D(26, 26), 7) };
+  ASSERT(near(matmul(view, square), reference(view.copy(), square), 1e-12));
+  TEST_SUCCESS;
+}
+
+bool batched()
+{
+  // stacks of matrices broadcast along their leading axes
+  const auto a { uniform<float32>(D(3, 1, 9, 20), 8) }, b { uniform<float32>(D(4, 20, 11), 9) };
+  const auto c { matmul(a, b) };
+  ASSERT(c.dim() == D(3, 4, 9, 11));
+  for (size_t i { 0 }; i < 3; ++i)
+    for (size_t j { 0 }; j < 4; ++j) {
+      const auto left { a.slice(0, i, i + 1).slice(1, 0, 1).copy().reshape(D(9, 20)) };
+      const auto right { b.slice(0, j, j + 1).copy().reshape(D(20, 11)) };
+      const auto product { c.slice(0, i, i + 1).slice(1, j, j + 1).copy().reshape(D(9, 11)) };
+      ASSERT(product == matmul(left, right));
+    }
+
+  // vectors are a row of a and a column of b, dropped from the result
+  const auto v { uniform<float32>(D(20), 10) };
+  const auto vb { matmul(v, b) }, av { matmul(a, v) };
+  ASSERT(vb.dim() == D(4, 11) && av.dim() == D(3, 1, 9));
+  for (size_t j { 0 }; j < 11; ++j) {
+    double sum { 0 };
+    for (size_t p { 0 }; p < 20; ++p) sum += double(v(p)) * double(b(2, p, j));
+    ASSERT(std::abs(vb(2, j) - sum) < 1e-5);
+  }
+
+  // matrix-vector products of linear layers, as inner products of contiguous rows
+  const auto weights { uniform<float64>(D(300, 513), 11) };
+  auto columns { weights };
+  columns.transpose();
+  const auto x { uniform<float64>(D(1, 513), 12) };
+  ASSERT(near(matmul(x, columns), reference(x, columns.copy()), 1e-12));
+  double squares { 0 }, reversed { 0 };
+  for (size_t p { 0 }; p < 20; ++p) squares += double(v(p)) * double(v(p));
+  for (size_t p { 0 }; p < 10; ++p) reversed += double(v(19 - 2 * p)) * double(v(p));
+  ASSERT(std::abs(dot(v, v) - squares) < 1e-5);
+  ASSERT(std::abs(dot(v.slice(0, 19, -1, -2), v.slice(0, 0, 10)) - reversed) < 1e-5);
+  TEST_SUCCESS;
+}
+
+bool aliasing()
+{
+  // outputs overlapping an operand are computed from a copy of it
+  auto a { uniform<float64>(D(30, 30), 13) };
+  const auto b { uniform<float64>(D(30, 30), 14) };
+  const auto expected { matmul(a, b) };
+  matmul(a, b, a);
+  ASSERT(a == expected);
+  auto squares { uniform<float32>(D(16, 16), 15) };
+  const auto twice { matmul(squares, squares) };
+  gemm(squares, squares, squares);
+  ASSERT(squares == twice);
+  TEST_SUCCESS;
+}
+
+bool errors()
+{
+  const float32 a { D(4, 5) }, b { D(6, 3) }, v { D(5) };
+  float32 c { D(4, 4) };
+  EXPECT_THROW(std::invalid_argument, matmul(a, b););
+  EXPECT_THROW(std::invalid_argument, matmul(v, v););
+  EXPECT_THROW(std::invalid_argument, matmul(a, float32(D(5, 3)), c););
+  EXPECT_THROW(std::invalid_argument, gemm(a, a, c););
+  EXPECT_THROW(std::invalid_argument, matmul(float32(D(2, 4, 5)), float32(D(3, 5, 2))););
+  EXPECT_THROW(std::invalid_argument, dot(v, float32(D(4))););
+  EXPECT_THROW(std::invalid_argument, dot(a, a););
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  // sums run in the same order on every level, which differ in fused multiply-adds only
+  const auto a { uniform<float32>(D(200, 300), 16) }, b { uniform<float32>(D(300, 150), 17) };
+  const auto expected { reference(a, b) };
+  const auto level { active_isa() };
+  for (int l { 0 }; l <= int(max_isa()); ++l) {
+    set_isa(isa(l));
+    ASSERT(near(matmul(a, b), expected, 1e-3));
+  }
+  set_isa(level);
+
+  // and results do not depend on the split across threads
+  const auto pooled { matmul(a, b) };
+  thread_pool pool { 3 };
+  set_default_executor(pool);
+  const auto shared { matmul(a, b) };
+  set_default_executor(serial_executor::instance());
+  const auto serial { matmul(a, b) };
+  set_default_executor(thread_pool::instance());
+  ASSERT(pooled == shared && shared == serial);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "linalg.hh", "matrix products" };
+
+  tester.run("Products", products);
+  tester.run("Scaling", scaling);
+  tester.run("Transposed", transposed);
+  tester.run("Batched", batched);
+  tester.run("Aliasing", aliasing);
+  tester.run("Errors", errors);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
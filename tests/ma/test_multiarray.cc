@@ -1,5 +1,10 @@
 #include "../utils.hh"
 #include "covdel/ma/factory.hh"
+#include "covdel/ma/simd.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 using namespace covdel::ma;
 
@@ -26,6 +31,11 @@ bool operators()
   EXPECT_THROW(std::out_of_range, CODE(d3[{ 2, 2 }]););
   ASSERT(bool(d1));
   ASSERT(!bool(int16 { D(1, 0) }));
+  auto f { array<float32>(D(2, 3, 4), 1.5f) };
+  f(1, 2, 3) = 4.f;
+  ASSERT(CODE(f.at({ 1, 2, 3 }) == 4.f && f(1, 2, 3) == f[{ 1, 2, 3 }]));
+  EXPECT_THROW(std::out_of_range, CODE(f.at({ 2, 0, 0 })););
+  EXPECT_THROW(std::invalid_argument, CODE(f.at({ 1, 0 })););
   TEST_SUCCESS;
 }
 
@@ -43,6 +53,9 @@ bool getters()
   ASSERT(d5.dim().str() == "( 4 2 )");
   ASSERT(d8.type() == datatype::uint32);
   ASSERT(d11.ndims() == 4 && d11.size() == 48 && d11.is_base());
+  ASSERT(d11.strides() == stride(24, 12, 4, 1) && d11.data() != nullptr);
+  auto t { d10.slice(3, 0, 4, 2) };
+  ASSERT(t.strides() == stride(24, 12, 4, 2) && t.data() == d10.data());
   // TODO add str() method after implementing
   TEST_SUCCESS;
 }
@@ -71,6 +84,71 @@ bool general()
   TEST_SUCCESS;
 }
 
+bool conversions()
+{
+  const float nan { std::numeric_limits<float>::quiet_NaN() };
+  const float values[8] { -1.5f, -0.5f, 0.5f, 1.5f, 2.5f, 254.6f, 300.f, nan };
+  auto f { array<float32>(D(8)) };
+  std::copy(values, values + 8, f.data());
+
+  // static_cast by default, integers wrapping around
+  const auto truncated { f.slice(0, 0, 7).astype<int16>() };
+  ASSERT(truncated(0) == -1 && truncated(1) == 0 && truncated(4) == 2);
+  ASSERT(truncated(6) == 300);
+  ASSERT(truncated.astype<uint8>()(6) == 44 && f.astype<bool8>()(7));
+
+  // round half to even, saturating to the range of the output with NaN as 0
+  const auto nearest { f.slice(0, 0, 6).astype<int16>({ rounding::nearest_even }) };
+  ASSERT(nearest(0) == -2 && nearest(1) == 0 && nearest(2) == 0 && nearest(4) == 2);
+  const auto bytes { f.astype<uint8>({ rounding::nearest_even, true }) };
+  const std::uint8_t expected[8] { 0, 0, 0, 2, 2, 255, 255, 0 };
+  for (size_t i { 0 }; i < 8; ++i) ASSERT(bytes(i) == expected[i]);
+
+  // integers saturate exactly, without going through floating point
+  const conversion saturate { rounding::truncate, true };
+  auto wide { array<int64>(D(5)) };
+  const std::int64_t big[5] { -70000, -200, 100, 70000, INT64_MIN };
+  std::copy(big, big + 5, wide.data());
+  const auto narrow { wide.astype<int16>(saturate) };
+  const auto narrower { wide.astype<uint8>(saturate) };
+  ASSERT(narrow(0) == -32768 && narrow(1) == -200 && narrow(3) == 32767);
+  ASSERT(narrow(4) == -32768);
+  ASSERT(narrower(1) == 0 && narrower(2) == 100 && narrower(3) == 255);
+  ASSERT(wide.astype<uint64>(saturate)(4) == 0);
+  ASSERT(array<uint64>(D(1), ~0ULL).astype<int64>(saturate)(0) == INT64_MAX);
+
+  // 64-bit limits are rounded up in floating point, and out of range themselves
+  auto huge { array<float64>(D(3)) };
+  huge(0) = 1e30, huge(1) = -1e30, huge(2) = 9.3e18;
+  const auto clamped { huge.astype<int64>({ rounding::nearest_even, true }) };
+  ASSERT(clamped(0) == INT64_MAX && clamped(1) == INT64_MIN && clamped(2) == INT64_MAX);
+  ASSERT(array<float32>(D(1), 3e9f).astype<int32>(saturate)(0) == INT32_MAX);
+
+  // fused scale and offset, on strided views split into several ranges
+  auto image { array<uint8>(D(600, 700)) };
+  for (size_t i { 0 }; i < image.size(); ++i) image.data()[i] = std::uint8_t(i * 7);
+  image.transpose();
+  const auto normal { image.astype<float32>({ rounding::truncate, false, 1 / 255., -.5 }) };
+  ASSERT(normal.dim() == D(700, 600));
+  for (size_t i { 0 }; i < 700; i += 13)
+    for (size_t j { 0 }; j < 600; j += 7)
+      ASSERT(normal(i, j) == float(image(i, j)) * float(1 / 255.) + float(-0.5));
+  const auto back { normal.astype<uint8>({ rounding::nearest_even, true, 255, 127.5 }) };
+  ASSERT(back == image);
+
+  // every instruction set level rounds and saturates alike
+  const auto level { active_isa() };
+  const conversion quantize { rounding::nearest_even, true, 300, 0.5 };
+  set_isa(isa::scalar);
+  const auto reference { normal.astype<int8>(quantize) };
+  for (int i { int(isa::scalar) }; i <= int(max_isa()); ++i) {
+    set_isa(isa(i));
+    ASSERT(normal.astype<int8>(quantize) == reference);
+  }
+  set_isa(level);
+  TEST_SUCCESS;
+}
+
 bool shape_manipulation()
 {
   auto d { array<int32>(D(3, 2, 5), 4) };
@@ -85,6 +163,49 @@ bool shape_manipulation()
   TEST_SUCCESS;
 }
 
+bool views()
+{
+  auto base { array<int32>(D(2, 3, 4)) };
+  for (size_t i { 0 }; i < 2; ++i)
+    for (size_t j { 0 }; j < 3; ++j)
+      for (size_t k { 0 }; k < 4; ++k) base[{ i, j, k }] = int(i * 100 + j * 10 + k);
+
+  auto t { base };
+  t.permute({ 2, 0, 1 });
+  ASSERT(t.dim().str() == "( 4 2 3 )" && !t.is_contiguous());
+  ASSERT(CODE(t[{ 3, 1, 2 }] == 123));
+  t.transpose();
+  ASSERT(t.dim().str() == "( 3 2 4 )" && CODE(t[{ 2, 1, 3 }] == 123));
+  EXPECT_THROW(std::invalid_argument, t.permute({ 0, 0, 1 }););
+
+  auto s { base.slice(1, 1, 3).slice(2, 3, -1, -2) };
+  ASSERT(s.dim().str() == "( 2 2 2 )" && !s.is_base());
+  ASSERT(CODE(s[{ 1, 0, 0 }] == 113 && s[{ 0, 1, 1 }] == 21));
+  EXPECT_THROW(std::out_of_range, base.slice(2, 0, 5););
+  s.fill(-1);
+  ASSERT(CODE(base[{ 1, 1, 3 }] == -1 && base[{ 1, 1, 2 }] == 112));
+
+  auto b { array<int32>(D(3), 7).broadcast_to(D(2, 4, 3)) };
+  ASSERT(b.dim().str() == "( 2 4 3 )" && b == int32(D(2, 4, 3), 7));
+  EXPECT_THROW(std::invalid_argument, base.broadcast_to(D(2, 2, 4)););
+
+  // views share ownership and outlive the array they were taken from
+  int32 view { D(1) };
+  {
+    auto owner { array<int32>(D(4, 4), 5) };
+    view = owner.slice(0, 1, 3);
+  }
+  ASSERT(view == int32(D(2, 4), 5));
+
+  auto c { s.ascontiguous() };
+  ASSERT(c.is_contiguous() && c.is_base() && c == s);
+  auto r { base.slice(0, 0, 1) };
+  ASSERT(r.ascontiguous().is_contiguous() && !r.ascontiguous().is_base());
+  t.reshape(D(24));
+  ASSERT(t.is_contiguous() && t.is_base());
+  TEST_SUCCESS;
+}
+
 int main()
 {
   UnitTestRunner tester { "multiarray.hh", "multiarray" };
@@ -94,7 +215,9 @@ int main()
   tester.run("Getters", getters);
   tester.run("Copy-Move", copy_move_semantics);
   tester.run("General", general);
+  tester.run("Conversions", conversions);
   tester.run("Shape Manipulation", shape_manipulation);
+  tester.run("Views", views);
 
   return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
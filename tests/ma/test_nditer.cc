@@ -0,0 +1,149 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/nditer.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel::ma;
+
+int32 counting(const D &dim)
+{
+  int32 out { dim };
+  std::iota(out.data(), out.data() + out.size(), 0);
+  return out;
+}
+
+bool iterators()
+{
+  int32 a { counting(D(3, 4, 5)) };
+  ASSERT(std::accumulate(begin(a), end(a), 0) == 59 * 60 / 2);
+  ASSERT(end(a) - begin(a) == 60 && begin(a)[17] == 17);
+
+  // views are walked in their own row-major order
+  int32 t { a };
+  t.transpose();
+  std::vector<int> expected;
+  for (size_t i { 0 }; i < 5; ++i)
+    for (size_t j { 0 }; j < 4; ++j)
+      for (size_t k { 0 }; k < 3; ++k) expected.push_back(t(i, j, k));
+  ASSERT(std::equal(begin(t), end(t), expected.begin(), expected.end()));
+  auto it { begin(t) + 13 };
+  ASSERT(*it == expected[13] && *(it - 11) == expected[2] && it[-13] == expected[0]);
+  --it, it -= 4;
+  ASSERT(*it-- == expected[8] && *it == expected[7] && it < begin(t) + 8);
+
+  // the algorithms of the standard library work on strided views in place
+  const int32 reversed { a.slice(2, 4, -1, -1) };
+  int32 r { reversed };
+  std::sort(begin(r), end(r));
+  ASSERT(std::is_sorted(cbegin(reversed), cend(reversed)));
+  ASSERT(a(0, 0, 4) == 0 && a(0, 0, 0) == 4 && a(2, 3, 4) == 55);
+  std::transform(begin(t), end(t), begin(t), [](int v) { return -v; });
+  ASSERT(a(2, 3, 4) == -55 && a(1, 0, 2) == -22);
+  int total { 0 };
+  for (const int v : reversed) total += v;
+  ASSERT(total == -59 * 60 / 2);
+
+  const int32 single { D(1, 1), 7 };
+  ASSERT(end(single) - begin(single) == 1 && *begin(single) == 7);
+  TEST_SUCCESS;
+}
+
+bool coalescing()
+{
+  // contiguous arrays are a single run whatever their rank
+  int32 a { counting(D(2, 3, 4, 5)) };
+  nditer flat { a };
+  ASSERT(flat.ndims() == 1 && flat.run_length() == 120);
+
+  // transposed views are reordered into memory order and merged back
+  int32 t { a };
+  t.transpose();
+  const nditer ordered { t };
+  ASSERT(ordered.ndims() == 1 && ordered.stride(0, 0) == 1);
+  const nditer rows { traversal::row_major, t };
+  ASSERT(rows.ndims() == 4 && rows.run_length() == 2);
+
+  // reversed axes are flipped, the traversal starting at the lowest address
+  const int32 reversed { a.slice(3, 4, -1, -1).slice(0, 1, -1, -1) };
+  const nditer forwards { reversed };
+  ASSERT(forwards.ndims() == 1 && forwards.stride(0, 0) == 1);
+  int expected { 0 };
+  bool walked { true };
+  forwards.for_each([&](const int *p, ptrdiff_t step, size_t count) {
+    for (size_t i { 0 }; i < count; ++i, p += step) walked &= *p == expected++;
+  });
+  ASSERT(walked && expected == 120);
+
+  // operands which disagree keep the order of the first one
+  int32 out { D(5, 4, 3, 2) };
+  const nditer pair { out, t };
+  ASSERT(pair.ndims() == 4 && pair.stride(0, 3) == 1 && pair.stride(1, 3) == 60);
+  pair.for_each([](int *o, const int *i, ptrdiff_t so, ptrdiff_t si, size_t count) {
+    for (size_t n { 0 }; n < count; ++n) o[n * so] = i[n * si];
+  });
+  ASSERT(out == t);
+
+  // strided views keep their gaps but lose unit axes
+  const int32 columns { a.slice(3, 0, 5, 2).slice(1, 1, 2) };
+  const nditer gaps { columns };
+  ASSERT(gaps.ndims() == 3 && gaps.size() == 2 * 4 * 3 && gaps.stride(0, 2) == 2);
+  TEST_SUCCESS;
+}
+
+bool broadcasting()
+{
+  const int32 a { counting(D(4, 1, 3)) }, b { counting(D(5, 1)) };
+  int32 out { D(4, 5, 3) };
+  const nditer iter { out, a, b };
+  ASSERT(iter.size() == 60);
+  iter.for_each([](int *o, const int *x, const int *y, ptrdiff_t so, ptrdiff_t sx,
+                  ptrdiff_t sy, size_t count) {
+    for (size_t n { 0 }; n < count; ++n) o[n * so] = x[n * sx] * 10 + y[n * sy];
+  });
+  for (size_t i { 0 }; i < 4; ++i)
+    for (size_t j { 0 }; j < 5; ++j)
+      for (size_t k { 0 }; k < 3; ++k) ASSERT(out(i, j, k) == a(i, 0, k) * 10 + b(j, 0));
+  int32 mismatched { D(4, 2) };
+  EXPECT_THROW(std::invalid_argument, CODE(nditer bad { out, mismatched };))
+  TEST_SUCCESS;
+}
+
+bool chunks()
+{
+  int32 a { counting(D(6, 7, 9)) };
+  a.transpose();
+
+  // partial ranges cover the elements exactly once
+  const nditer iter { a };
+  std::vector<int> seen(a.size());
+  for (size_t begin { 0 }; begin < iter.size(); begin += 50)
+    iter.for_each(begin, begin + 50, [&](int *p, ptrdiff_t step, size_t count) {
+      for (size_t i { 0 }; i < count; ++i) ++seen[size_t(p[ptrdiff_t(i) * step])];
+    });
+  ASSERT(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+
+  // parallel runs on disjoint elements
+  iter.parallel_for_each(16, [](int *p, ptrdiff_t step, size_t count) {
+    for (size_t i { 0 }; i < count; ++i) p[ptrdiff_t(i) * step] *= 2;
+  });
+  a.transpose();
+  ASSERT(a == counting(D(6, 7, 9)) * 2);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "nditer.hh", "iterators and n-dimensional traversal" };
+
+  tester.run("Iterators", iterators);
+  tester.run("Coalescing", coalescing);
+  tester.run("Broadcasting", broadcasting);
+  tester.run("Chunks", chunks);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
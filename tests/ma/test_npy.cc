@@ -0,0 +1,242 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/npy.hh"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+using namespace covdel::ma;
+
+// writes a header as laid out by older numpy versions, followed by raw bytes starting
+// `shift` bytes past a multiple of 16
+void write_npy(const std::string &path, const std::string &dict,
+  const std::string &payload, const size_t shift = 0)
+{
+  std::string header { "\x93NUMPY\x01\x00", 8 };
+  std::string padded { dict };
+  while ((10 + padded.size() + 1) % 16 != shift) padded += ' ';
+  padded += '\n';
+  header += char(padded.size() & 0xFF);
+  header += char(padded.size() >> 8);
+  std::ofstream { path, std::ios::binary } << header << padded << payload;
+}
+
+// archive written by python's zipfile, with ramp.npy deflated as by np.savez_compressed
+// and packed.npy compressed with bzip2
+const std::string compressed {
+  "\x50\x4b\x03\x04\x14\x00\x00\x00\x08\x00\x00\x00\x21\x00\x36\x12\x5f\xcd\x78\x00"
+  "\x00\x00\xb0\x00\x00\x00\x08\x00\x00\x00\x72\x61\x6d\x70\x2e\x6e\x70\x79\x9b\xec"
+  "\x17\xea\x1b\x10\xc9\xc8\x50\xc6\x50\xad\x9e\x92\x5a\x9c\x5c\xa4\x6e\xa5\xa0\x6e"
+  "\x93\x69\xa4\xae\xa3\xa0\x9e\x96\x5f\x54\x52\x94\x98\x17\x9f\x5f\x94\x92\x0a\x12"
+  "\x77\x4b\xcc\x29\x4e\x05\x8a\x17\x67\x24\x16\xa4\x02\xf9\x1a\x26\x3a\x0a\x66\x9a"
+  "\x3a\x0a\xb5\x0a\x64\x03\xae\x1b\xff\xef\xfe\x7f\xf4\xff\xf9\xff\x37\xff\x3f\xfe"
+  "\xff\xf6\xff\xf7\x7f\x06\x06\x56\x06\x2e\x06\x7e\x06\x11\x06\x49\x06\x39\x06\x65"
+  "\x06\x0d\x06\x5d\x06\x23\x06\x73\x06\x1b\x06\x47\x06\x37\x06\x6f\x06\x00\x50\x4b"
+  "\x03\x04\x2e\x00\x00\x00\x0c\x00\x00\x00\x21\x00\x2a\xe3\x8e\xb1\x75\x00\x00\x00"
+  "\x83\x00\x00\x00\x0a\x00\x00\x00\x70\x61\x63\x6b\x65\x64\x2e\x6e\x70\x79\x42\x5a"
+  "\x68\x39\x31\x41\x59\x26\x53\x59\x9e\xfc\x3d\x0f\x00\x00\x25\xdf\xa0\x78\x10\x40"
+  "\xe4\x28\x50\x01\x03\x42\x20\xaf\x45\xdf\x0e\x08\x00\x20\x00\x54\x44\x9e\x91\x90"
+  "\x32\x00\x00\x64\xd3\x65\x08\xa7\xa2\x7a\x40\x0f\x50\xd0\x69\xa0\x68\x7a\x80\xf6"
+  "\xd6\x2c\xab\xf6\x60\xa8\x0c\x14\x2a\xb2\x0f\x14\x60\x01\x19\x5d\x7a\x36\x46\x44"
+  "\x2e\xfb\x37\x69\xd3\xce\x08\xaa\x11\x7e\x82\x45\xe0\xf8\x0c\x33\x22\x01\x2a\x2b"
+  "\x32\x04\xe8\x7f\x8b\xb9\x22\x9c\x28\x48\x4f\x7e\x1e\x87\x80\x50\x4b\x01\x02\x14"
+  "\x03\x14\x00\x00\x00\x08\x00\x00\x00\x21\x00\x36\x12\x5f\xcd\x78\x00\x00\x00\xb0"
+  "\x00\x00\x00\x08\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x80\x01\x00\x00\x00"
+  "\x00\x72\x61\x6d\x70\x2e\x6e\x70\x79\x50\x4b\x01\x02\x2e\x03\x2e\x00\x00\x00\x0c"
+  "\x00\x00\x00\x21\x00\x2a\xe3\x8e\xb1\x75\x00\x00\x00\x83\x00\x00\x00\x0a\x00\x00"
+  "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x80\x01\x9e\x00\x00\x00\x70\x61\x63\x6b\x65"
+  "\x64\x2e\x6e\x70\x79\x50\x4b\x05\x06\x00\x00\x00\x00\x02\x00\x02\x00\x6e\x00\x00"
+  "\x00\x3b\x01\x00\x00\x00\x00"
+  , 447 };
+
+template<typename _MultiArray>
+bool round_trip(const typename _MultiArray::native_type value)
+{
+  const auto path { scratch("round_trip.npy") };
+  const auto a { generate<_MultiArray>(D(3, 5, 7), [value](size_t i) {
+    return value * (i % 3);
+  }) };
+  save_npy(path, a);
+  const auto header { inspect_npy(path) };
+  ASSERT(header.type == a.type() && header.dim == a.dim() && !header.fortran_order);
+  const auto b { load_npy<_MultiArray>(path) };
+  ASSERT(b == a && b.is_base() && b.is_contiguous());
+  TEST_SUCCESS;
+}
+
+bool datatypes()
+{
+  ASSERT(round_trip<bool8>(true) && round_trip<int8>(-7) && round_trip<int16>(-300));
+  ASSERT(round_trip<int32>(-70000) && round_trip<int64>(-(int64_t(1) << 40)));
+  ASSERT(round_trip<uint8>(200) && round_trip<uint16>(60000));
+  ASSERT(round_trip<uint32>(1U << 31) && round_trip<uint64>(uint64_t(1) << 63));
+  ASSERT(round_trip<float32>(-1.5f) && round_trip<float64>(1e300));
+
+  // payloads start on aligned offsets, so the views are aligned like new buffers
+  const auto path { scratch("aligned.npy") };
+  save_npy(path, generate<float64>(D(1000), [](size_t i) { return i * 0.5; }));
+  const auto x { load_npy<float64>(path) };
+  ASSERT(reinterpret_cast<std::uintptr_t>(x.data()) % ALIGNMENT == 0 && x(999) == 499.5);
+  EXPECT_THROW(std::invalid_argument, load_npy<float32>(path););
+  EXPECT_THROW(std::system_error, load_npy<float64>(scratch("missing.npy")););
+  TEST_SUCCESS;
+}
+
+bool layouts()
+{
+  const auto path { scratch("layouts.npy") };
+  const auto a { generate<int32>(D(4, 6), [](size_t i) { return int(i); }) };
+
+  // transposed arrays are written as they lie, in column-major order
+  auto t { a };
+  t.transpose();
+  save_npy(path, t);
+  ASSERT(inspect_npy(path).fortran_order && inspect_npy(path).dim == D(6, 4));
+  const auto lt { load_npy<int32>(path) };
+  ASSERT(lt == t && !lt.is_contiguous() && lt(5, 3) == 23);
+
+  // other views are gathered
+  const auto s { a.slice(1, 5, -1, -2) };
+  save_npy(path, s);
+  ASSERT(!inspect_npy(path).fortran_order && load_npy<int32>(path) == s);
+  const auto b { a.slice(0, 1, 2).broadcast_to(D(3, 4, 6)) };
+  save_npy(path, b);
+  ASSERT(load_npy<int32>(path) == b && load_npy<int32>(path)(2, 0, 5) == 11);
+
+  // staging pieces are flushed at their capacity
+  auto big { generate<uint8>(D(3000, 3000), [](size_t i) { return i % 251; }) };
+  const auto mirrored { big.transpose().slice(1, 2999, -1, -1) };
+  save_npy(path, mirrored);
+  ASSERT(load_npy<uint8>(path) == mirrored);
+  TEST_SUCCESS;
+}
+
+bool interop()
+{
+  const auto path { scratch("numpy.npy") };
+
+  // 0-d arrays are loaded with the shape (1)
+  write_npy(path, "{'descr': '<f8', 'fortran_order': False, 'shape': (), }",
+    std::string { "\0\0\0\0\0\0\xf8\x3f", 8 });
+  ASSERT(inspect_npy(path).dim == D(1) && load_npy<float64>(path)(0) == 1.5);
+
+  // misaligned payloads are copied
+  write_npy(path, "{'descr': '<i2', 'fortran_order': False, 'shape': (3,), }",
+    std::string { "\x01\x00\x02\x00\xff\xff", 6 }, 1);
+  const auto s { load_npy<int16>(path) };
+  ASSERT(s.dim() == D(3) && s(0) == 1 && s(1) == 2 && s(2) == -1);
+
+  // column-major payloads are loaded as transposed views
+  write_npy(path, "{'shape': (2, 3), 'fortran_order': True, 'descr': '|u1'}",
+    std::string { "\x00\x03\x01\x04\x02\x05", 6 });
+  const auto f { load_npy<uint8>(path) };
+  ASSERT(f.dim() == D(2, 3) && f(0, 2) == 2 && f(1, 0) == 3 && f(1, 2) == 5);
+
+  // big-endian payloads are swapped into a new array
+  write_npy(path, "{'descr': '>u4', 'fortran_order': False, 'shape': (2,), }",
+    std::string { "\x01\x02\x03\x04\x00\x00\x00\x2a", 8 });
+  ASSERT(inspect_npy(path).swapped);
+  const auto be { load_npy<uint32>(path) };
+  ASSERT(be(0) == 0x01020304 && be(1) == 42);
+
+  write_npy(path, "{'descr': '<c8', 'fortran_order': False, 'shape': (1,), }",
+    std::string(8, '\0'));
+  EXPECT_THROW(std::invalid_argument, inspect_npy(path););
+  write_npy(path, "{'descr': '<f4', 'fortran_order': False, 'shape': (4,), }",
+    std::string(12, '\0'));
+  EXPECT_THROW(std::invalid_argument, load_npy<float32>(path););
+
+  // shapes whose element or byte counts overflow are rejected
+  write_npy(path,
+    "{'descr': '<f4', 'fortran_order': False, 'shape': (4611686018427387904, 4), }",
+    std::string(16, '\0'));
+  EXPECT_THROW(std::invalid_argument, load_npy<float32>(path););
+  write_npy(path,
+    "{'descr': '|u1', 'fortran_order': False, 'shape': (99999999999999999999,), }",
+    std::string(16, '\0'));
+  EXPECT_THROW(std::invalid_argument, inspect_npy(path););
+  std::ofstream { path } << "not an array";
+  EXPECT_THROW(std::invalid_argument, inspect_npy(path););
+  TEST_SUCCESS;
+}
+
+bool mappings()
+{
+  const auto path { scratch("mapping.npy") };
+  save_npy(path, float32(D(64, 64), 2.f));
+
+  // writes stay private to the mapping, the file is never modified
+  auto a { load_npy<float32>(path) };
+  a.fill(-1.f);
+  const auto b { load_npy<float32>(path, mapping::read_only) };
+  ASSERT(b == float32(D(64, 64), 2.f) && a == float32(D(64, 64), -1.f));
+
+  // views keep the mapping alive after the file is gone
+  std::filesystem::remove(path);
+  const auto row { b.slice(0, 10, 11) };
+  ASSERT(row.dim() == D(1, 64) && row(0, 63) == 2.f);
+  TEST_SUCCESS;
+}
+
+bool archives()
+{
+  const auto path { scratch("archive.npz") };
+  const auto a { generate<float32>(D(5, 7), [](size_t i) { return i * 0.25f; }) };
+  const auto b { generate<uint8>(D(33), [](size_t i) { return uint8_t(i * 7); }) };
+  auto c { generate<int64>(D(3, 4), [](size_t i) { return -int64_t(i); }) };
+  {
+    npz_writer out { path };
+    out.add("weights", a);
+    out.add("bytes", b);
+    out.add("transposed", c.transpose());
+  }
+
+  const npz_archive in { path };
+  ASSERT((in.names() == std::vector<std::string> { "weights", "bytes", "transposed" }));
+  ASSERT(in.contains("bytes") && !in.contains("bytes.npy"));
+  ASSERT(in.header("transposed").fortran_order && in.header("weights").dim == D(5, 7));
+  const auto la { in.get<float32>("weights") };
+  const auto lb { in.get<uint8>("bytes") };
+  const auto lc { in.get<int64>("transposed") };
+  ASSERT(la == a && lb == b && lc == c && lc(3, 2) == -11);
+  for (const void *ptr : { (void *)la.data(), (void *)lb.data(), (void *)lc.data() })
+    ASSERT(reinterpret_cast<std::uintptr_t>(ptr) % ALIGNMENT == 0);
+  EXPECT_THROW(std::out_of_range, in.get<uint8>("missing"););
+  EXPECT_THROW(std::invalid_argument, in.get<float64>("weights"););
+
+  npz_writer closed { scratch("closed.npz") };
+  closed.close();
+  EXPECT_THROW(std::logic_error, closed.add("late", a););
+  ASSERT(npz_archive { scratch("closed.npz") }.names().empty());
+
+  // deflated members are decompressed and checked, other methods are refused
+  std::ofstream { scratch("compressed.npz"), std::ios::binary } << compressed;
+  const npz_archive packed { scratch("compressed.npz") };
+  ASSERT(packed.header("ramp").dim == D(4, 6));
+  const auto ramp { packed.get<int16>("ramp") };
+  ASSERT(ramp == generate<int16>(D(4, 6), [](size_t i) { return int16_t(i * 5 - 40); }));
+  EXPECT_THROW(std::invalid_argument, packed.get<uint8>("packed"););
+  std::string corrupt { compressed };
+  corrupt[60] = char(corrupt[60] ^ 0x10);
+  std::ofstream { scratch("corrupt.npz"), std::ios::binary } << corrupt;
+  EXPECT_THROW(std::invalid_argument,
+    npz_archive { scratch("corrupt.npz") }.get<int16>("ramp"););
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "npy.hh", ".npy and .npz files" };
+
+  tester.run("Datatypes", datatypes);
+  tester.run("Layouts", layouts);
+  tester.run("Interop", interop);
+  tester.run("Mappings", mappings);
+  tester.run("Archives", archives);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
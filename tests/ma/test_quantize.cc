@@ -0,0 +1,231 @@
+#include "../utils.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/quantize.hh"
+#include "covdel/ma/simd.hh"
+
+#include <cmath>
+#include <cstdint>
+
+using namespace covdel::ma;
+
+// values of the seeded sequence, quantized as a whole
+template<typename _DType>
+quantized<_DType> operand(const D &dim, const std::int32_t zero_point, const size_t seed)
+{
+  return { generate<multiarray<_DType>>(dim, std::uint32_t(seed)),
+    { { 0.05f }, { zero_point }, -1 } };
+}
+
+// sums of the products of 2-D views less their zero points, in 64 bits
+template<typename _ADType, typename _BDType>
+int64 reference(const quantized<_ADType> &a, const quantized<_BDType> &b)
+{
+  const size_t m { a.values.dim()[0] }, k { a.values.dim()[1] }, n { b.values.dim()[1] };
+  const auto &zb { b.params.zero_points };
+  int64 out { D(m, n) };
+  for (size_t i { 0 }; i < m; ++i)
+    for (size_t j { 0 }; j < n; ++j) {
+      std::int64_t sum { 0 };
+      for (size_t p { 0 }; p < k; ++p)
+        sum += (std::int64_t(a.values(i, p)) - a.params.zero_points[0])
+          * (std::int64_t(b.values(p, j)) - zb[zb.size() == 1 ? 0 : j]);
+      out(i, j) = sum;
+    }
+  return out;
+}
+
+template<typename _ADType, typename _BDType>
+bool matches(const quantized<_ADType> &a, const quantized<_BDType> &b)
+{
+  const auto expected { reference(a, b) };
+  int32 c { expected.dim(), -1 };
+  qgemm(a, b, c);
+  for (size_t i { 0 }; i < c.dim()[0]; ++i)
+    for (size_t j { 0 }; j < c.dim()[1]; ++j)
+      if (c(i, j) != expected(i, j)) return false;
+  return true;
+}
+
+bool roundtrip()
+{
+  // values come back within half a step, per tensor and per channel
+  float32 x { D(3, 40) };
+  for (size_t i { 0 }; i < x.size(); ++i)
+    x.data()[i] = std::sin(float(i)) * float(i % 40 + 1);
+  for (const auto type : { datatype::int8, datatype::uint8 })
+    for (const int axis : { -1, 0 })
+      for (const bool symmetric : { false, true }) {
+        const auto params { calibrate(x, type, axis, symmetric) };
+        const auto back { type == datatype::int8
+            ? dequantize(quantize<dtype::int8>(x, params))
+            : dequantize(quantize<dtype::uint8>(x, params)) };
+        for (size_t c { 0 }; c < 3; ++c)
+          for (size_t i { 0 }; i < 40; ++i) {
+            const float scale { params.scales[axis < 0 ? 0 : c] };
+            ASSERT(std::abs(back(c, i) - x(c, i)) <= scale * 0.5001f);
+          }
+      }
+
+  // zero is always exact, and values out of range saturate
+  const auto q { quantize<dtype::uint8>(float32(D(4), 0.f), { { 0.5f }, { 7 }, -1 }) };
+  ASSERT(q.values == uint8(D(4), 7) && dequantize(q) == float32(D(4), 0.f));
+  const auto high { quantize<dtype::int8>(float32(D(2), 1e9f), { { 0.5f }, { 0 }, -1 }) };
+  ASSERT(high.values == int8(D(2), 127));
+  TEST_SUCCESS;
+}
+
+bool products()
+{
+  // shapes around the tiles and panels of every level, for every pair of datatypes
+  const size_t shapes[][3] { { 1, 1, 1 }, { 5, 3, 7 }, { 13, 33, 17 }, { 64, 64, 64 },
+    { 37, 300, 45 }, { 130, 1100, 70 }, { 9, 40, 700 } };
+  for (const auto &[m, k, n] : shapes) {
+    const auto ua { operand<dtype::uint8>(D(m, k), 3, m) };
+    const auto sa { operand<dtype::int8>(D(m, k), -5, m + 1) };
+    const auto sb { operand<dtype::int8>(D(k, n), 0, n) };
+    const auto ub { operand<dtype::uint8>(D(k, n), 131, n + 1) };
+    ASSERT(matches(ua, sb) && matches(ua, ub) && matches(sa, sb) && matches(sa, ub));
+  }
+
+  // per-channel zero points of b, and products along no depth
+  auto b { operand<dtype::int8>(D(50, 3), 0, 1) };
+  b.params = { { 0.1f, 0.2f, 0.3f }, { -3, 0, 9 }, 1 };
+  ASSERT(matches(operand<dtype::uint8>(D(20, 50), 100, 2), b));
+  ASSERT(
+    matches(operand<dtype::uint8>(D(4, 0), 9, 3), operand<dtype::int8>(D(0, 5), 2, 4)));
+  TEST_SUCCESS;
+}
+
+bool transposed()
+{
+  // operands are read through their strides, as flags or as views
+  const auto a { operand<dtype::uint8>(D(70, 45), 12, 5) };
+  auto b { operand<dtype::int8>(D(33, 70), -1, 6) };
+  b.params = quantization { std::vector<float>(33, 0.1f),
+    std::vector<std::int32_t>(33, 4), 0 };
+  auto at { a };
+  auto bt { b };
+  at.values.transpose();
+  bt.values.transpose();
+  bt.params.axis = 1;
+  const auto expected { reference(at, bt) };
+  int32 c { D(45, 33) }, flagged { D(45, 33) };
+  qgemm(at, bt, c);
+  qgemm(a, b, flagged, true, true);
+  ASSERT(c == flagged);
+  for (size_t i { 0 }; i < 45; ++i)
+    for (size_t j { 0 }; j < 33; ++j) ASSERT(c(i, j) == expected(i, j));
+
+  // reversed and sliced views, into a strided output
+  const auto big { operand<dtype::int8>(D(60, 80), 7, 8) };
+  const quantized<dtype::int8> view { big.values.slice(0, 50, 10, -2).slice(1, 3, 80, 3),
+    big.params };
+  const auto square { operand<dtype::uint8>(D(26, 26), 200, 9) };
+  int32 wide { D(20, 52) };
+  auto columns { wide.slice(1, 0, 52, 2) };
+  qgemm(view, square, columns);
+  ASSERT(columns == reference(view, square).astype<int32>());
+  TEST_SUCCESS;
+}
+
+bool requantized()
+{
+  const auto a { operand<dtype::uint8>(D(37, 150), 128, 10) };
+  auto b { operand<dtype::int8>(D(150, 21), 0, 11) };
+  b.params.axis = 1;
+  b.params.scales.resize(21);
+  b.params.zero_points.assign(21, 0);
+  for (size_t j { 0 }; j < 21; ++j) b.params.scales[j] = 0.01f * float(j + 1);
+  requantization epilogue { std::vector<std::int32_t>(21), false };
+  for (size_t j { 0 }; j < 21; ++j) epilogue.bias[j] = std::int32_t(j * 977) - 9000;
+  const auto sums { reference(a, b) };
+
+  // the scaled sums, clamped and rounded to nearest even around the zero point of c
+  for (const bool relu : { false, true }) {
+    epilogue.relu = relu;
+    quantized<dtype::uint8> c { uint8 { D(37, 21) }, { { 0.8f }, { 100 }, -1 } };
+    qgemm(a, b, c, epilogue);
+    for (size_t i { 0 }; i < 37; ++i)
+      for (size_t j { 0 }; j < 21; ++j) {
+        const float scale { float(0.05 * double(b.params.scales[j]) / 0.8) };
+        float v { float(std::int32_t(sums(i, j) + epilogue.bias[j])) * scale };
+        v = std::fmin(std::fmax(v, relu ? 0.f : -100.f), 155.f);
+        ASSERT(c.values(i, j) == std::uint8_t(std::nearbyint(v) + 100));
+      }
+  }
+
+  // into int8, and into an operand of the product
+  quantized<dtype::int8> s { int8 { D(37, 21) }, { { 0.5f }, { -10 }, -1 } };
+  qgemm(a, b, s, epilogue);
+  auto square { operand<dtype::uint8>(D(30, 30), 128, 12) };
+  const auto weights { operand<dtype::int8>(D(30, 30), 0, 13) };
+  quantized<dtype::uint8> copy { square.values.copy(), square.params };
+  qgemm(copy, weights, copy);
+  qgemm(square, weights, square);
+  ASSERT(square.values == copy.values);
+  TEST_SUCCESS;
+}
+
+bool errors()
+{
+  const auto a { operand<dtype::uint8>(D(4, 5), 0, 1) };
+  const auto b { operand<dtype::int8>(D(5, 3), 0, 2) };
+  int32 c { D(4, 3) }, wrong { D(4, 4) };
+  EXPECT_THROW(std::invalid_argument, qgemm(a, a, c););
+  EXPECT_THROW(std::invalid_argument, qgemm(a, b, wrong););
+  EXPECT_THROW(std::invalid_argument,
+    qgemm(operand<dtype::uint8>(D(2, 4, 5), 0, 3), b, c););
+  EXPECT_THROW(std::invalid_argument,
+    qgemm(operand<dtype::uint8>(D(1, 40000), 0, 3),
+      operand<dtype::int8>(D(40000, 1), 0, 4), c););
+  auto per_row { b };
+  per_row.params = { { 1.f, 1.f, 1.f, 1.f, 1.f }, { 0, 0, 0, 0, 0 }, 0 };
+  EXPECT_THROW(std::invalid_argument, qgemm(a, per_row, c););
+  EXPECT_THROW(std::invalid_argument,
+    quantize<dtype::int8>(float32(D(3, 2)), { { 1.f, 2.f }, { 0, 0 }, 0 }););
+  EXPECT_THROW(std::invalid_argument, calibrate(float32(D(3)), datatype::int16););
+  quantized<dtype::uint8> out { uint8 { D(4, 3) }, {} };
+  EXPECT_THROW(std::invalid_argument, qgemm(a, b, out, { { 1, 2 }, false }););
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  // products are exact, so every level and split across threads agree
+  const auto a { operand<dtype::uint8>(D(200, 300), 120, 14) };
+  const auto b { operand<dtype::int8>(D(300, 150), 3, 15) };
+  int32 expected { D(200, 150) };
+  qgemm(a, b, expected);
+  const auto level { active_isa() };
+  for (int l { 0 }; l <= int(max_isa()); ++l) {
+    set_isa(isa(l));
+    int32 c { D(200, 150) };
+    ASSERT(qgemm(a, b, c) == expected);
+  }
+  set_isa(level);
+
+  thread_pool pool { 3 };
+  int32 shared { D(200, 150) }, serial { D(200, 150) };
+  set_default_executor(pool);
+  qgemm(a, b, shared);
+  set_default_executor(serial_executor::instance());
+  qgemm(a, b, serial);
+  set_default_executor(thread_pool::instance());
+  ASSERT(shared == expected && serial == expected);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "quantize.hh", "quantized arrays and products" };
+
+  tester.run("Roundtrip", roundtrip);
+  tester.run("Products", products);
+  tester.run("Transposed", transposed);
+  tester.run("Requantized", requantized);
+  tester.run("Errors", errors);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,135 @@
+#include "../utils.hh"
+#include "covdel/ma/factory.hh"
+#include "covdel/ma/reduction.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace covdel::ma;
+
+bool totals()
+{
+  // narrow integers accumulate in 64 bits
+  const auto bytes { array<uint8>(D(1000, 37), 255) };
+  ASSERT(sum(bytes) == 255UL * 37000 && sum(bytes, 0).type() == datatype::uint64);
+  ASSERT(sum(array<int8>(D(300), -100)) == -30000 && sum(bool8(D(7), true)) == 7);
+  ASSERT(prod(array<int16>(D(5), 3)) == 243 && prod(float32(D(0))) == 1.f);
+  ASSERT(sum(int32(D(0))) == 0 && mean(array<uint8>(D(4), 3)) == 3.0);
+
+  // pairwise summation keeps a million float32 additions accurate
+  const auto tenths { array<float32>(D(1000000), 0.1f) };
+  ASSERT(std::abs(sum(tenths) - 100000.f) < 1.f);
+  ASSERT(std::abs(mean(tenths) - 0.1f) < 1e-6f);
+  TEST_SUCCESS;
+}
+
+bool axes()
+{
+  const auto a { generate<int32>(D(2, 3, 4), [](size_t i) { return int(i); }) };
+  const auto s0 { sum(a, 0) }, s12 { sum(a, { 1, 2 }) }, s2 { sum(a, -1, true) };
+  ASSERT(s0.dim() == D(3, 4) && s0(0, 0) == 12 && s0(2, 3) == 11 + 23);
+  ASSERT(s12.dim() == D(2) && s12(0) == 66 && s12(1) == 66 + 144);
+  ASSERT(s2.dim() == D(2, 3, 1) && s2(1, 2, 0) == 20 + 21 + 22 + 23);
+  ASSERT(sum(a, { 0, 1, 2 }, true).dim() == D(1, 1, 1) && sum(a, { 2, 0, 1 })(0) == 276);
+  ASSERT(sum(a, std::vector<int> {}) == a.astype<int64>());
+  EXPECT_THROW(std::out_of_range, sum(a, 3););
+  EXPECT_THROW(std::invalid_argument, sum(a, { 0, -3 }););
+
+  // strided views reduce the same as their contiguous copies
+  auto t { a };
+  t.transpose();
+  ASSERT(sum(t, 0) == sum(t.copy(), 0) && sum(t, { 1, 2 }) == sum(a, { 0, 1 }));
+  const auto reversed { a.slice(2, 3, -1, -1) };
+  ASSERT(max(reversed, 2) == max(a, 2) && argmax(reversed, 2) == uint64(D(2, 3), 0));
+  TEST_SUCCESS;
+}
+
+bool rows()
+{
+  // leading axes of wide arrays are accumulated row by row, and agree with the
+  // blockwise reduction of the transposed layout
+  const auto a { generate<float64>(D(300, 257), [](size_t i) { return (i % 101) * 0.3; }) };
+  auto t { a.copy() };
+  t.transpose();
+  const auto by_rows { sum(a, 0) }, by_blocks { sum(t.copy(), 1) };
+  for (size_t j { 0 }; j < 257; ++j) ASSERT(std::abs(by_rows(j) - by_blocks(j)) < 1e-9);
+
+  // few long rows are also split along the reduced axis
+  const auto tall { generate<uint16>(D(40000, 20), [](size_t i) { return std::uint16_t(i); }) };
+  const auto column { sum(tall, 0) };
+  const auto lowest { min(tall, 0) };
+  for (size_t j { 0 }; j < 20; ++j) {
+    std::uint64_t expected { 0 };
+    std::uint16_t least { tall(0, j) };
+    for (size_t i { 0 }; i < 40000; ++i)
+      expected += tall(i, j), least = std::min(least, tall(i, j));
+    ASSERT(column(j) == expected && lowest(j) == least);
+  }
+  TEST_SUCCESS;
+}
+
+bool moments()
+{
+  const auto a { generate<float32>(D(4, 50), [](size_t i) { return float(i % 7) - 2.f; }) };
+  const auto m { mean(a, 1) }, v { var(a, 1) }, s { stddev(a, { 1 }, false, 1) };
+  for (size_t r { 0 }; r < 4; ++r) {
+    double mu { 0 }, ss { 0 };
+    for (size_t c { 0 }; c < 50; ++c) mu += a(r, c);
+    mu /= 50;
+    for (size_t c { 0 }; c < 50; ++c) ss += (a(r, c) - mu) * (a(r, c) - mu);
+    ASSERT(std::abs(m(r) - mu) < 1e-6 && std::abs(v(r) - ss / 50) < 1e-5);
+    ASSERT(std::abs(s(r) - std::sqrt(ss / 49)) < 1e-5);
+  }
+  ASSERT(var(array<int32>(D(10), 7)) == 0.0);
+  ASSERT(std::abs(stddev(a) - std::sqrt(var(a))) < 1e-6f);
+  ASSERT(std::isnan(var(a, { 0, 1 }, false, 200)(0)));
+  TEST_SUCCESS;
+}
+
+bool extremes()
+{
+  const auto a { generate<int16>(D(5, 9), [](size_t i) { return int(i * 37 % 23) - 11; }) };
+  ASSERT(min(a) == -11 && max(a) == 11);
+  const auto lo { argmin(a, 1) };
+  const auto hi { argmax(a) };
+  for (size_t r { 0 }; r < 5; ++r) ASSERT(a(r, lo(r)) == min(a, 1)(r));
+  ASSERT(a(hi / 9, hi % 9) == 11);
+
+  // the first extreme is reported, and NaN wins over every number
+  const auto ties { array<float32>(D(6), 2.f) };
+  ASSERT(argmax(ties) == 0 && argmin(ties) == 0);
+  auto nan { generate<float64>(D(64), [](size_t i) { return double(i); }) };
+  nan(40) = std::numeric_limits<double>::quiet_NaN();
+  nan(50) = std::numeric_limits<double>::quiet_NaN();
+  ASSERT(std::isnan(min(nan)) && std::isnan(max(nan)) && argmin(nan) == 40);
+  ASSERT(max(nan.slice(0, 0, 40)) == 39.0 && argmax(nan.slice(0, 41, 50)) == 8);
+  EXPECT_THROW(std::invalid_argument, min(int32(D(0))););
+  EXPECT_THROW(std::invalid_argument, argmax(float32(D(3, 0)), 1););
+  TEST_SUCCESS;
+}
+
+bool truth()
+{
+  auto flags { bool8(D(3, 100), false) };
+  flags(1, 99) = true;
+  ASSERT(any(flags) && !all(flags) && any(flags, 1) == any(flags, { 1 }));
+  ASSERT(any(flags, 1)(1) && !any(flags, 1)(0) && max(flags) && !min(flags));
+  const auto values { generate<float32>(D(50), [](size_t i) { return float(i) + 0.5f; }) };
+  ASSERT(all(values) && !all(float32(D(3), 0.f)) && all(float32(D(0))) && !any(int8(D(0))));
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "reduction.hh", "reductions along axes" };
+
+  tester.run("Totals", totals);
+  tester.run("Axes", axes);
+  tester.run("Rows", rows);
+  tester.run("Moments", moments);
+  tester.run("Extremes", extremes);
+  tester.run("Truth", truth);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,292 @@
+#include "../utils.hh"
+#include "covdel/ma/executor.hh"
+#include "covdel/ma/simd.hh"
+#include "covdel/nn/conv.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using nn::conv2d_params;
+using nn::conv_algorithm;
+using nn::layout;
+
+// convolution of an nchw input in double, straight from the definition
+ma::float64 reference(const ma::float32 &x, const ma::float32 &w, const ma::float32 &b,
+  const conv2d_params &p)
+{
+  const size_t n { x.dim()[0] }, h { x.dim()[2] }, wd { x.dim()[3] };
+  const size_t m { w.dim()[0] }, cg { w.dim()[1] }, kh { w.dim()[2] }, kw { w.dim()[3] };
+  const size_t mg { m / p.groups };
+  const size_t oh { (h + 2 * p.padding[0] - p.dilation[0] * (kh - 1) - 1) / p.stride[0] + 1 };
+  const size_t ow { (wd + 2 * p.padding[1] - p.dilation[1] * (kw - 1) - 1) / p.stride[1] + 1 };
+  ma::float64 out { D(n, m, oh, ow) };
+  for (size_t i { 0 }; i < n; ++i)
+    for (size_t f { 0 }; f < m; ++f)
+      for (size_t y { 0 }; y < oh; ++y)
+        for (size_t xo { 0 }; xo < ow; ++xo) {
+          double sum { b.size() ? b(f) : 0. };
+          for (size_t k { 0 }; k < cg; ++k)
+            for (size_t ky { 0 }; ky < kh; ++ky)
+              for (size_t kx { 0 }; kx < kw; ++kx) {
+                const auto iy { ptrdiff_t(y * p.stride[0] + ky * p.dilation[0]) - ptrdiff_t(p.padding[0]) };
+                const auto ix { ptrdiff_t(xo * p.stride[1] + kx * p.dilation[1]) - ptrdiff_t(p.padding[1]) };
+                if (iy < 0 || iy >= ptrdiff_t(h) || ix < 0 || ix >= ptrdiff_t(wd)) continue;
+                sum += double(x(i, f / mg * cg + k, size_t(iy), size_t(ix))) * w(f, k, ky, kx);
+              }
+          out(i, f, y, xo) = sum;
+        }
+  return out;
+}
+
+// a result in nchw order, an nhwc one read through a permuted view
+ma::float32 nchw(ma::float32 y, const layout format)
+{
+  if (format == layout::nhwc) y.permute({ 0, 3, 1, 2 });
+  return y;
+}
+
+ma::float32 channels_last(const ma::float32 &x)
+{
+  return x.copy().permute({ 0, 2, 3, 1 }).copy();
+}
+
+struct config {
+  size_t n, c, h, w, m, kh, kw;
+  conv2d_params params;
+};
+
+// every algorithm which fits each shape, over both layouts
+bool matches(const config &cfg, const std::vector<conv_algorithm> &algorithms)
+{
+  const D xdim { cfg.n, cfg.c, cfg.h, cfg.w };
+  const D wdim { cfg.m, cfg.c / cfg.params.groups, cfg.kh, cfg.kw };
+  const auto x { generate<ma::float32>(xdim, uint32_t(cfg.c + cfg.h)) };
+  const auto w { generate<ma::float32>(wdim, uint32_t(cfg.m)) };
+  const auto b { generate<ma::float32>(D(cfg.m), 7) };
+  const auto expected { reference(x, w, b, cfg.params) };
+  const auto unbiased { reference(x, w, ma::float32 { D(0) }, cfg.params) };
+  for (const auto format : { layout::nchw, layout::nhwc })
+    for (const auto algorithm : algorithms) {
+      auto params { cfg.params };
+      params.format    = format;
+      params.algorithm = algorithm;
+      const auto input { format == layout::nhwc ? channels_last(x) : x };
+      if (!close(nchw(nn::conv2d(input, w, b, params), format), expected)) return false;
+      if (!close(nchw(nn::conv2d(input, w, params), format), unbiased)) return false;
+    }
+  return true;
+}
+
+bool shapes()
+{
+  conv2d_params p {};
+  p.stride   = { 2, 1 };
+  p.padding  = { 1, 2 };
+  p.dilation = { 1, 3 };
+  ASSERT(nn::conv2d_shape(D(2, 3, 9, 10), D(4, 3, 3, 3), p) == D(2, 4, 5, 8));
+  p.format = layout::nhwc;
+  ASSERT(nn::conv2d_shape(D(2, 9, 10, 3), D(4, 3, 3, 3), p) == D(2, 5, 8, 4));
+
+  const conv2d_params grouped { { 1, 1 }, { 0, 0 }, { 1, 1 }, 2 };
+  EXPECT_THROW(std::invalid_argument, nn::conv2d_shape(D(1, 3, 5, 5), D(4, 3, 3, 3), grouped););
+  EXPECT_THROW(std::invalid_argument, nn::conv2d_shape(D(1, 4, 5, 5), D(4, 4, 3, 3), grouped););
+  EXPECT_THROW(std::invalid_argument, nn::conv2d_shape(D(1, 4, 2, 2), D(4, 4, 3, 3)););
+  EXPECT_THROW(std::invalid_argument, nn::conv2d_shape(D(4, 5, 5), D(4, 4, 3, 3)););
+  EXPECT_THROW(std::invalid_argument,
+    nn::conv2d_shape(D(1, 4, 5, 5), D(4, 4, 3, 3), { { 0, 1 } }););
+
+  ma::float32 x { D(1, 4, 5, 5) }, w { D(2, 4, 3, 3) }, out { D(1, 2, 4, 4) };
+  EXPECT_THROW(std::invalid_argument, nn::conv2d(x, w, ma::float32 { D(0) }, out););
+  EXPECT_THROW(std::invalid_argument, nn::conv2d(x, w, ma::float32 { D(3) }););
+  TEST_SUCCESS;
+}
+
+bool general()
+{
+  using A = conv_algorithm;
+  // padded, strided, dilated and rectangular kernels
+  ASSERT(matches({ 2, 3, 11, 13, 5, 3, 3, { { 1, 1 }, { 1, 1 } } }, { A::im2col, A::winograd }));
+  ASSERT(matches({ 1, 4, 9, 7, 6, 3, 2, { { 2, 1 }, { 1, 0 }, { 1, 2 } } }, { A::im2col }));
+  ASSERT(matches({ 3, 2, 8, 8, 3, 5, 5, { { 3, 3 }, { 2, 2 }, { 2, 1 } } }, { A::im2col }));
+  // winograd tiles cut by the edges of odd outputs
+  ASSERT(matches({ 1, 5, 7, 8, 4, 3, 3, {} }, { A::im2col, A::winograd }));
+  ASSERT(matches({ 2, 70, 9, 6, 67, 3, 3, { { 1, 1 }, { 2, 0 } } }, { A::winograd }));
+  // groups, pointwise and depthwise kernels, with a channel multiplier
+  ASSERT(matches({ 2, 6, 7, 7, 4, 3, 3, { { 1, 1 }, { 1, 1 }, { 1, 1 }, 2 } }, { A::im2col }));
+  ASSERT(matches({ 2, 8, 5, 6, 6, 1, 1, { { 1, 1 }, { 0, 0 }, { 1, 1 }, 2 } },
+    { A::im2col, A::direct }));
+  ASSERT(matches({ 2, 5, 9, 10, 5, 3, 3, { { 2, 2 }, { 1, 1 }, { 1, 1 }, 5 } },
+    { A::im2col, A::direct }));
+  ASSERT(matches({ 1, 3, 6, 7, 6, 3, 2, { { 1, 2 }, { 2, 1 }, { 2, 1 }, 3 } },
+    { A::im2col, A::direct }));
+  ASSERT(matches({ 1, 70, 5, 5, 70, 3, 3, { { 1, 1 }, { 1, 1 }, { 1, 1 }, 70 } }, { A::direct }));
+  TEST_SUCCESS;
+}
+
+bool strided()
+{
+  // inputs and outputs are views of other arrays, and outputs may overlap inputs
+  const auto big { generate<ma::float32>(D(2, 7, 12, 20), 3) };
+  const auto x { big.slice(1, 1, 7, 2).slice(3, 19, 0, -2) };
+  const auto w { generate<ma::float32>(D(4, 3, 3, 3), 4) };
+  const auto b { generate<ma::float32>(D(4), 5) };
+  const auto expected { reference(x.copy(), w, b, { { 1, 1 }, { 1, 1 } }) };
+
+  for (const auto algorithm : { conv_algorithm::im2col, conv_algorithm::winograd }) {
+    conv2d_params p { { 1, 1 }, { 1, 1 } };
+    p.algorithm = algorithm;
+    ma::float32 wide { D(2, 4, 12, 20), 0.F };
+    auto out { wide.slice(3, 0, 20, 2) };
+    nn::conv2d(x, w, b, out, p);
+    ASSERT(close(out, expected));
+
+    auto same { generate<ma::float32>(D(1, 4, 6, 6), 6) };
+    const auto copy { same.copy() }, k { generate<ma::float32>(D(4, 4, 3, 3), 7) };
+    nn::conv2d(same, k, ma::float32 { D(0) }, same, p);
+    ASSERT(close(same, reference(copy, k, ma::float32 { D(0) }, p)));
+  }
+  TEST_SUCCESS;
+}
+
+bool heuristic()
+{
+  using A = conv_algorithm;
+  const conv2d_params same { { 1, 1 }, { 1, 1 } };
+  const conv2d_params depthwise { { 1, 1 }, { 1, 1 }, { 1, 1 }, 32 };
+  ASSERT(nn::conv2d_algorithm(D(8, 64, 56, 56), D(64, 64, 3, 3), same) == A::winograd);
+  ASSERT(nn::conv2d_algorithm(D(8, 64, 56, 56), D(128, 64, 1, 1)) == A::direct);
+  ASSERT(nn::conv2d_algorithm(D(8, 32, 56, 56), D(32, 1, 3, 3), depthwise) == A::direct);
+  ASSERT(nn::conv2d_algorithm(D(8, 3, 224, 224), D(64, 3, 7, 7), { { 2, 2 }, { 3, 3 } })
+         == A::im2col);
+  ASSERT(nn::conv2d_algorithm(D(8, 3, 32, 32), D(16, 3, 3, 3), same) == A::im2col);
+
+  conv2d_params forced { same };
+  forced.algorithm = A::direct;
+  EXPECT_THROW(std::invalid_argument,
+    nn::conv2d_algorithm(D(1, 4, 8, 8), D(4, 4, 3, 3), forced););
+  forced.algorithm = A::winograd;
+  forced.stride    = { 2, 2 };
+  EXPECT_THROW(std::invalid_argument,
+    nn::conv2d_algorithm(D(1, 4, 8, 8), D(4, 4, 3, 3), forced););
+  TEST_SUCCESS;
+}
+
+bool workspace()
+{
+  // temporaries only grow to the largest shape and are then reused
+  nn::workspace ws {};
+  const auto x { generate<ma::float32>(D(2, 16, 20, 20), 8) };
+  const auto w { generate<ma::float32>(D(8, 16, 3, 3), 9) };
+  ma::float32 out { D(2, 8, 18, 18) };
+  const ma::float32 none { D(0) };
+  for (const auto algorithm : { conv_algorithm::im2col, conv_algorithm::winograd }) {
+    conv2d_params p {};
+    p.algorithm = algorithm;
+    nn::conv2d(x, w, none, out, p, ws);
+    const size_t grown { ws.allocations() };
+    for (int i { 0 }; i < 5; ++i) nn::conv2d(x, w, none, out, p, ws);
+    ASSERT(ws.allocations() == grown && ws.capacity() > 0);
+  }
+  ws.release();
+  ASSERT(ws.capacity() == 0);
+  TEST_SUCCESS;
+}
+
+template<typename _DType>
+ma::quantized<_DType> quantized(const D &dim, const int32_t zero_point, const uint32_t seed)
+{
+  ma::quantized<_DType> out { ma::multiarray<_DType> { dim }, { { 0.05F }, { zero_point }, -1 } };
+  uint32_t state { seed * 2654435761U + 1 };
+  for (size_t i { 0 }; i < out.values.size(); ++i)
+    out.values.data()[i] = typename ma::multiarray<_DType>::native_type((state = state * 1103515245U + 12345U) >> 24);
+  return out;
+}
+
+bool quantized_conv()
+{
+  // integer sums of the dequantized operands, requantized as qgemm does
+  for (const auto format : { layout::nchw, layout::nhwc })
+    for (const size_t groups : { 1, 2 }) {
+      conv2d_params p { { 2, 1 }, { 1, 1 }, { 1, 1 }, groups, format };
+      const size_t n { 2 }, c { 4 }, m { 6 }, h { 7 }, wd { 6 };
+      auto x { quantized<ma::dtype::uint8>(D(n, c, h, wd), 120, 1) };
+      auto w { quantized<ma::dtype::int8>(D(m, c / groups, 3, 3), 0, 2) };
+      w.params = { { 0.01F, 0.02F, 0.03F, 0.04F, 0.05F, 0.06F }, { 0, 1, -2, 0, 3, 0 }, 0 };
+      ma::requantization epilogue { { 100, -200, 300, -400, 500, -600 }, groups == 2 };
+
+      ma::float32 xs { x.values.dim() }, ws { w.values.dim() };
+      for (size_t i { 0 }; i < xs.size(); ++i) xs.data()[i] = float(int(x.values.data()[i]) - 120);
+      for (size_t f { 0 }; f < m; ++f)
+        for (size_t i { 0 }; i < ws.size() / m; ++i)
+          ws.data()[f * (ws.size() / m) + i] = float(int(w.values.data()[f * (ws.size() / m) + i]) - w.params.zero_points[f]);
+      const auto sums { reference(xs, ws, ma::float32 { D(0) }, p) };
+
+      const auto input { format == layout::nhwc
+                           ? ma::quantized<ma::dtype::uint8> { x.values.copy().permute({ 0, 2, 3, 1 }).copy(), x.params }
+                           : x };
+      ma::quantized<ma::dtype::uint8> out { ma::uint8 { nn::conv2d_shape(input.values.dim(), w.values.dim(), p) }, { { 0.4F }, { 10 }, -1 } };
+      nn::conv2d(input, w, epilogue, out, p);
+      auto y { out.values };
+      if (format == layout::nhwc) y.permute({ 0, 3, 1, 2 });
+      for (size_t i { 0 }; i < n; ++i)
+        for (size_t f { 0 }; f < m; ++f)
+          for (size_t r { 0 }; r < sums.dim()[2]; ++r)
+            for (size_t q { 0 }; q < sums.dim()[3]; ++q) {
+              const float scale { float(0.05 * double(w.params.scales[f]) / 0.4) };
+              float v { float(int32_t(sums(i, f, r, q)) + epilogue.bias[f]) * scale };
+              v = std::fmin(std::fmax(v, epilogue.relu ? 0.F : -10.F), 245.F);
+              ASSERT(y(i, f, r, q) == uint8_t(std::nearbyint(v) + 10));
+            }
+    }
+
+  const auto x { quantized<ma::dtype::uint8>(D(1, 2, 5, 5), 0, 3) };
+  const auto w { quantized<ma::dtype::int8>(D(2, 2, 3, 3), 0, 4) };
+  ma::quantized<ma::dtype::int8> out { ma::int8 { D(1, 2, 3, 3) }, {} };
+  conv2d_params winograd {};
+  winograd.algorithm = conv_algorithm::winograd;
+  EXPECT_THROW(std::invalid_argument, nn::conv2d(x, w, {}, out, winograd););
+  EXPECT_THROW(std::invalid_argument, nn::conv2d(x, w, { { 1, 2, 3 }, false }, out););
+  TEST_SUCCESS;
+}
+
+bool dispatch()
+{
+  // direct loops give identical results on every level and across threads
+  conv2d_params p { { 1, 1 }, { 1, 1 }, { 1, 1 }, 24 };
+  const auto x { generate<ma::float32>(D(2, 24, 15, 17), 10) };
+  const auto w { generate<ma::float32>(D(24, 1, 3, 3), 11) };
+  const auto b { generate<ma::float32>(D(24), 12) };
+  const auto expected { nn::conv2d(x, w, b, p) };
+  const auto level { ma::active_isa() };
+  for (int l { 0 }; l <= int(ma::max_isa()); ++l) {
+    ma::set_isa(ma::isa(l));
+    ASSERT(nn::conv2d(x, w, b, p) == expected);
+  }
+  ma::set_isa(level);
+
+  ma::thread_pool pool { 3 };
+  ma::set_default_executor(pool);
+  const auto shared { nn::conv2d(x, w, b, p) };
+  ma::set_default_executor(ma::thread_pool::instance());
+  ASSERT(shared == expected);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "conv.hh", "2-D convolutions" };
+
+  tester.run("Shapes", shapes);
+  tester.run("General", general);
+  tester.run("Strided", strided);
+  tester.run("Heuristic", heuristic);
+  tester.run("Workspace", workspace);
+  tester.run("Quantized", quantized_conv);
+  tester.run("Dispatch", dispatch);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
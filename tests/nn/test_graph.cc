@@ -0,0 +1,211 @@
+#include "../utils.hh"
+#include "covdel/ma/allocator.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/nn/graph.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using nn::tensor;
+
+ma::float32 eager(nn::module &model, const ma::float32 &input)
+{
+  const nn::no_grad inference;
+  return model(tensor { input }).value();
+}
+
+// global average pooling and a linear classifier
+struct head final : nn::module {
+  head(const size_t in, const size_t out) : fc { in, out } { }
+
+  tensor forward(const tensor &input) override { return fc(nn::mean(input, { 2, 3 })); }
+  std::vector<tensor> parameters() const override { return fc.parameters(); }
+
+  nn::linear fc;
+};
+
+// conv, folded batch norm and relu, a residual block and a head
+std::unique_ptr<nn::sequential> network()
+{
+  nn::manual_seed(7);
+  auto model { std::make_unique<nn::sequential>() };
+  nn::conv2d_params same {};
+  same.padding = { 1, 1 };
+  model->add<nn::convolution>(3, 8, std::array<size_t, 2> { 3, 3 }, same);
+  auto &norm { model->add<nn::affine>(8) };
+  norm.scale.value() = generate<ma::float32>(D(8, 1, 1), 11);
+  norm.shift.value() = generate<ma::float32>(D(8, 1, 1), 12);
+  model->add<nn::activation_layer>(nn::activation::relu);
+  auto body { std::make_unique<nn::sequential>() };
+  body->add<nn::convolution>(8, 8, std::array<size_t, 2> { 3, 3 }, same);
+  body->add<nn::activation_layer>(nn::activation::sigmoid);
+  model->add<nn::residual>(std::move(body));
+  model->add<head>(8, 5);
+  return model;
+}
+
+bool modules()
+{
+  auto model { network() };
+  ASSERT(model->parameters().size() == 8);
+
+  // fitting a linear layer through its parameters
+  nn::manual_seed(3);
+  nn::linear fit { 3, 1 };
+  const ma::float32 x { generate<ma::float32>(D(64, 3), 1) };
+  ma::float32 truth { D(3, 1) };
+  truth(0, 0) = 1.5F, truth(1, 0) = -2.F, truth(2, 0) = 0.5F;
+  const tensor inputs { x }, targets { ma::matmul(x, truth) + 0.25F };
+  for (int step { 0 }; step < 300; ++step) {
+    fit.zero_grad();
+    const auto error { fit(inputs) - targets };
+    nn::mean(error * error).backward();
+    const nn::no_grad update;
+    for (auto &p : fit.parameters()) p.value() -= 0.5F * p.grad();
+  }
+  for (size_t i { 0 }; i < 3; ++i)
+    ASSERT(std::abs(fit.weight.value()(i, 0) - truth(i, 0)) < 1e-3F);
+  ASSERT(std::abs(fit.bias.value()(0) - 0.25F) < 1e-3F);
+  TEST_SUCCESS;
+}
+
+bool equivalence()
+{
+  auto model { network() };
+  const ma::float32 x { generate<ma::float32>(D(2, 3, 12, 12), 5) };
+  nn::graph g { *model, x.dim() };
+  ASSERT(g.input() == x.dim());
+  ASSERT(g.output() == D(2, 5));
+  ASSERT(close(g.run(x), eager(*model, x)));
+
+  // parameters are shared, updates are seen by the next run
+  for (auto &p : model->parameters()) p.value() *= 0.5F;
+  ASSERT(close(g.run(x), eager(*model, x)));
+
+  EXPECT_THROW(std::invalid_argument, g.run(generate<ma::float32>(D(1, 3, 12, 12), 5));)
+  TEST_SUCCESS;
+}
+
+bool fusion()
+{
+  // conv, affine and relu are one node, the second conv takes the sigmoid and the
+  // residual sum, then the pooling and the product with its bias
+  auto model { network() };
+  nn::graph g { *model, D(1, 3, 8, 8) };
+  ASSERT(g.size() == 4);
+  const auto profile { g.profile() };
+  ASSERT(profile[0].name == "conv2d+multiply+add+maximum");
+  ASSERT(profile[1].name == "conv2d+negative+exp+add+divide+add");
+  ASSERT(profile[2].name == "mean");
+  ASSERT(profile[3].name == "matmul+add");
+  TEST_SUCCESS;
+}
+
+// element-wise chains with broadcast operands, reusing the buffers of dying results
+struct chains final : nn::module {
+  tensor forward(const tensor &input) override
+  {
+    const auto a { nn::matmul(input, w) };
+    const auto b { a * a };
+    const auto c { nn::exp(-b) / (b + 1.F) };
+    const auto s { nn::sum(c, { 1 }, true) };
+    return nn::sqrt(c - s * 0.5F + 16.F);
+  }
+
+  tensor w { generate<ma::float32>(D(16, 24), 2) };
+};
+
+bool chaining()
+{
+  chains model;
+  const ma::float32 x { generate<ma::float32>(D(10, 16), 3) };
+  nn::graph g { model, x.dim() };
+  ASSERT(close(g.run(x), eager(model, x)));
+
+  // an input of any strides, here every other column
+  ma::float32 wide { generate<ma::float32>(D(10, 32), 4) };
+  const ma::float32 view { wide.data(), D(10, 16), ma::stride(32, 2), nullptr };
+  ASSERT(close(g.run(view), eager(model, view.copy())));
+
+  // a module returning its input copies it
+  nn::sequential identity;
+  nn::graph copy { identity, x.dim() };
+  ASSERT(copy.size() == 1);
+  ASSERT(close(copy.run(view), view.copy(), 0.));
+  TEST_SUCCESS;
+}
+
+bool planning()
+{
+  // results of a deep stack only live until the next layer, so two buffers do
+  nn::sequential stack;
+  for (int i { 0 }; i < 6; ++i) {
+    stack.add<nn::linear>(64, 64);
+    stack.add<nn::activation_layer>(nn::activation::relu);
+  }
+  nn::graph g { stack, D(32, 64) };
+  ASSERT(g.size() == 6);
+  const size_t layer { 32 * 64 * sizeof(float) };
+  ASSERT(g.unplanned_bytes() == 6 * layer);
+  ASSERT(g.planned_bytes() == 2 * layer);
+
+  const ma::float32 x { generate<ma::float32>(D(32, 64), 9) };
+  ma::float32 out { g.output(), ma::uninitialized };
+  g.run(x, out);
+  ASSERT(close(out, eager(stack, x)));
+  TEST_SUCCESS;
+}
+
+bool allocations()
+{
+  ma::tracking_allocator tracker;
+  const scoped_allocator scope { tracker };
+  auto model { network() };
+  const ma::float32 x { generate<ma::float32>(D(2, 3, 16, 16), 6) };
+  nn::graph g { *model, x.dim() };
+  const ma::float32 expected { eager(*model, x) };
+
+  // warmed up, runs neither allocate arrays nor miss the pool
+  g.run(x), g.run(x);
+  tracker.reset_peak();
+  ma::pool_allocator::instance().reset_stats();
+  for (int i { 0 }; i < 5; ++i) ASSERT(close(g.run(x), expected));
+  ASSERT(tracker.stats().allocations == 0);
+  ASSERT(ma::pool_allocator::instance().stats().misses == 0);
+  ASSERT(g.planned_bytes() <= g.unplanned_bytes());
+  TEST_SUCCESS;
+}
+
+bool profiling()
+{
+  auto model { network() };
+  const ma::float32 x { generate<ma::float32>(D(1, 3, 8, 8), 8) };
+  nn::graph g { *model, x.dim() };
+  for (int i { 0 }; i < 3; ++i) g.run(x);
+  for (const auto &node : g.profile()) ASSERT(node.calls == 3 && node.seconds >= 0.);
+  ASSERT(g.report().find("conv2d+multiply+add+maximum") != std::string::npos);
+  g.reset_profile();
+  for (const auto &node : g.profile()) ASSERT(node.calls == 0 && node.seconds == 0.);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "graph.hh", "traced inference graphs of modules" };
+
+  tester.run("Modules", modules);
+  tester.run("Equivalence", equivalence);
+  tester.run("Fusion", fusion);
+  tester.run("Chaining", chaining);
+  tester.run("Planning", planning);
+  tester.run("Allocations", allocations);
+  tester.run("Profiling", profiling);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
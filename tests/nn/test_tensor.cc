@@ -0,0 +1,249 @@
+#include "../utils.hh"
+#include "covdel/ma/arithmetic.hh"
+#include "covdel/ma/linalg.hh"
+#include "covdel/nn/tensor.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+using namespace covdel;
+using ma::D;
+using nn::tensor;
+
+tensor parameter(const D &dim, const uint32_t seed)
+{
+  return tensor { generate<ma::float32>(dim, seed), true };
+}
+
+// gradients of the scalar `loss` of the leaves against central differences, every
+// element of each leaf nudged in place
+bool gradients(const std::function<tensor()> &loss, std::vector<tensor> leaves)
+{
+  for (auto &leaf : leaves) leaf.zero_grad();
+  loss().backward();
+
+  constexpr float EPS { 1e-2F };
+  const nn::no_grad inference;
+  for (auto &leaf : leaves) {
+    if (leaf.grad().dim() != leaf.dim()) return false;
+    float *data { leaf.value().data() };
+    for (size_t i { 0 }; i < leaf.value().size(); ++i) {
+      const float kept { data[i] };
+      data[i]            = kept + EPS;
+      const double above { loss().value()(0) };
+      data[i]            = kept - EPS;
+      const double below { loss().value()(0) };
+      data[i]            = kept;
+      const double expected { (above - below) / (2 * EPS) };
+      if (std::abs(leaf.grad().data()[i] - expected) > 1e-2 * (1 + std::abs(expected)))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool elementwise()
+{
+  auto a { parameter(D(3, 4), 1) }, b { parameter(D(4), 2) }, c { parameter(D(3, 1), 3) };
+  const auto noise { generate<ma::float32>(D(3, 4), 4) };
+  auto positive { tensor { ma::add(ma::abs(noise), 0.5F), true } };
+
+  // operands broadcast, and their gradients are summed back over the broadcast axes
+  ASSERT(gradients([&] { return nn::sum(a * b + c - a / (b * b + 2.F)); }, { a, b, c }));
+  ASSERT(gradients([&] { return nn::sum(nn::exp(a) * nn::log(positive) + nn::sqrt(positive)); },
+    { a, positive }));
+  ASSERT(gradients([&] { return nn::sum(nn::sigmoid(a * 3.F) - nn::relu(a + c) * 0.5F); },
+    { a, c }));
+  ASSERT(gradients([&] { return nn::sum(-(a * a) + 1.F); }, { a }));
+
+  // an operand used twice receives both gradients
+  auto x { parameter(D(5), 5) };
+  auto y { x * x + x };
+  nn::sum(y).backward();
+  for (size_t i { 0 }; i < 5; ++i)
+    ASSERT(std::abs(x.grad()(i) - (2 * x.value()(i) + 1)) < 1e-6F);
+  TEST_SUCCESS;
+}
+
+bool reductions()
+{
+  auto a { parameter(D(2, 3, 4), 6) };
+  auto w { parameter(D(3, 1), 7) };
+  ASSERT(gradients([&] { return nn::sum(nn::mean(a, { 0, -1 }, true) * w); }, { a, w }));
+  ASSERT(gradients([&] { return nn::mean(nn::sum(a, { 1 }) * nn::sum(a, { 1 })); }, { a }));
+  ASSERT(nn::mean(a).dim() == D(1) && nn::sum(a, { 2 }).dim() == D(2, 3));
+  ASSERT(nn::sum(a, { 2 }, true).dim() == D(2, 3, 1));
+  TEST_SUCCESS;
+}
+
+bool products()
+{
+  // matrices, stacks of the same shape, and stacks against one matrix
+  auto a { parameter(D(3, 5), 8) }, b { parameter(D(5, 2), 9) };
+  auto s { parameter(D(2, 3, 5), 10) }, t { parameter(D(2, 5, 4), 11) };
+  ASSERT(gradients([&] { return nn::sum(nn::relu(nn::matmul(a, b))); }, { a, b }));
+  ASSERT(gradients([&] { return nn::sum(nn::matmul(s, t) * nn::matmul(s, t)); }, { s, t }));
+  ASSERT(gradients([&] { return nn::sum(nn::sigmoid(nn::matmul(s, b))); }, { s, b }));
+  EXPECT_THROW(std::invalid_argument, nn::matmul(t, s););
+  EXPECT_THROW(std::invalid_argument, nn::matmul(parameter(D(5), 12), b););
+  TEST_SUCCESS;
+}
+
+bool convolutions()
+{
+  // strides, padding, dilation and groups, in either layout
+  for (const auto format : { nn::layout::nchw, nn::layout::nhwc }) {
+    nn::conv2d_params params {};
+    params.format = format;
+    const bool nhwc { format == nn::layout::nhwc };
+    auto x { parameter(nhwc ? D(2, 5, 6, 4) : D(2, 4, 5, 6), 13) };
+    auto w { parameter(D(6, 4, 3, 3), 14) }, b { parameter(D(6), 15) };
+    params.padding = { 1, 1 };
+    ASSERT(gradients([&] { return nn::sum(nn::sigmoid(nn::conv2d(x, w, b, params))); }, { x, w, b }));
+
+    auto g { parameter(D(4, 2, 2, 3), 16) };
+    params.stride   = { 2, 1 };
+    params.dilation = { 1, 2 };
+    params.groups   = 2;
+    ASSERT(gradients([&] {
+      const auto y { nn::conv2d(x, g, params) };
+      return nn::sum(y * y);
+    }, { x, g }));
+  }
+
+  // gradients of strided arrays are added through views
+  auto x { generate<ma::float32>(D(1, 2, 4, 4), 17) };
+  auto w { generate<ma::float32>(D(3, 2, 3, 3), 18) };
+  const auto grad { generate<ma::float32>(D(1, 3, 2, 2), 19) };
+  ma::float32 wide { D(3, 2, 3, 6), 1.F };
+  auto view { wide.slice(3, 0, 6, 2) };
+  nn::conv2d_weight_grad(x, grad, view, {}, true);
+  ma::float32 dense { D(3, 2, 3, 3) };
+  nn::conv2d_weight_grad(x, grad, dense);
+  for (size_t i { 0 }; i < 3; ++i)
+    ASSERT(std::abs(view(2, 1, i, 2) - dense(2, 1, i, 2) - 1.F) < 1e-5F
+           && wide(2, 1, i, 1) == 1.F);
+  TEST_SUCCESS;
+}
+
+bool accumulation()
+{
+  auto w { parameter(D(4, 4), 20) };
+  const tensor x { generate<ma::float32>(D(8, 4), 21) };
+
+  // gradients of later passes are added in place onto the first one
+  nn::sum(nn::matmul(x, w)).backward();
+  const float *buffer { w.grad().data() };
+  const ma::float32 first { w.grad().copy() };
+  nn::sum(nn::matmul(x, w)).backward();
+  ASSERT(w.grad().data() == buffer && w.grad() == ma::multiply(first, 2.F));
+  w.zero_grad();
+  ASSERT(w.grad().data() == buffer && w.grad() == ma::float32(D(4, 4), 0.F));
+
+  // leaves which do not require gradients never receive them
+  ASSERT(x.grad().size() == 0 && !x.requires_grad() && w.is_leaf());
+  TEST_SUCCESS;
+}
+
+bool tape()
+{
+  auto w { parameter(D(3), 22) };
+  auto y { nn::exp(w) * 2.F };
+  ASSERT(y.requires_grad() && !y.is_leaf());
+  EXPECT_THROW(std::invalid_argument, y.set_requires_grad(false););
+  EXPECT_THROW(std::invalid_argument, y.backward(););
+
+  // operations are freed by the pass through them
+  auto loss { nn::sum(y) };
+  loss.backward();
+  EXPECT_THROW(std::logic_error, loss.backward(););
+  EXPECT_THROW(std::logic_error, nn::sum(y).backward(););
+
+  // nothing is recorded without gradients, or under no_grad
+  {
+    const nn::no_grad inference;
+    const auto z { nn::sum(nn::exp(w)) };
+    ASSERT(!nn::grad_enabled() && z.is_leaf() && !z.requires_grad());
+    {
+      const nn::no_grad nested;
+    }
+    ASSERT(!nn::grad_enabled());
+  }
+  ASSERT(nn::grad_enabled());
+  const auto detached { nn::exp(w.detach()) };
+  ASSERT(detached.is_leaf() && !detached.requires_grad());
+  tensor non_scalar { generate<ma::float32>(D(2), 23) };
+  EXPECT_THROW(std::invalid_argument, non_scalar.backward(););
+  TEST_SUCCESS;
+}
+
+bool memory()
+{
+  ma::tracking_allocator tracker;
+  {
+    const scoped_allocator scope { tracker };
+    auto w { parameter(D(64, 64), 24) }, b { parameter(D(64), 25) };
+    const tensor x { generate<ma::float32>(D(256, 64), 26) };
+    const size_t held { tracker.stats().live };
+
+    // the activations kept by the tape are returned as the pass goes, leaving the
+    // parameters, their gradients and the loss
+    tracker.reset_peak();
+    auto loss { nn::mean(nn::relu(nn::matmul(x, w) + b)) };
+    const size_t forward { tracker.stats().live };
+    loss.backward();
+    const auto stats { tracker.stats() };
+    ASSERT(forward >= held + 2 * 256 * 64 * 4 && stats.peak >= forward);
+    ASSERT(stats.live <= held + (64 * 64 + 64) * 4 + 256);
+
+    // inference keeps nothing beyond the result
+    const size_t before { tracker.stats().live };
+    tracker.reset_peak();
+    {
+      const nn::no_grad inference;
+      const auto y { nn::relu(nn::matmul(x, w) + b) };
+      ASSERT(tracker.stats().live == before + 256 * 64 * 4);
+    }
+    ASSERT(tracker.stats().peak <= before + 3 * 256 * 64 * 4 + 256);
+  }
+  ASSERT(tracker.stats().live == 0);
+  TEST_SUCCESS;
+}
+
+bool training()
+{
+  // least squares fit of a linear map, by plain gradient descent
+  const auto x { generate<ma::float32>(D(64, 3), 27) };
+  ma::float32 truth { D(3, 1) };
+  truth(0, 0) = 1.5F, truth(1, 0) = -2.F, truth(2, 0) = 0.5F;
+  const tensor inputs { x }, targets { ma::matmul(x, truth) };
+  auto w { tensor { ma::float32 { D(3, 1), 0.F }, true } };
+  for (int step { 0 }; step < 300; ++step) {
+    const auto error { nn::matmul(inputs, w) - targets };
+    w.zero_grad();
+    nn::mean(error * error).backward();
+    const nn::no_grad update;
+    w.value() -= 0.5F * w.grad();
+  }
+  for (size_t i { 0 }; i < 3; ++i) ASSERT(std::abs(w.value()(i, 0) - truth(i, 0)) < 1e-3F);
+  TEST_SUCCESS;
+}
+
+int main()
+{
+  UnitTestRunner tester { "tensor.hh", "tensors with reverse-mode gradients" };
+
+  tester.run("Elementwise", elementwise);
+  tester.run("Reductions", reductions);
+  tester.run("Products", products);
+  tester.run("Convolutions", convolutions);
+  tester.run("Accumulation", accumulation);
+  tester.run("Tape", tape);
+  tester.run("Memory", memory);
+  tester.run("Training", training);
+
+  return tester.passed() == tester.total() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -23,7 +23,18 @@
 // placeholder for successful return of test function
 #define TEST_SUCCESS return true;
 
+#include "covdel/ma/allocator.hh"
+#include "covdel/ma/dimension.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 class UnitTestRunner {
 public:
@@ -60,4 +71,91 @@ private:
   unsigned m_total;
 };
 
+// array of a dimension whose elements are `func(i)`, with `i` counting in row-major order
+template<typename _MultiArray, typename _Func,
+  typename = std::enable_if_t<std::is_invocable_v<_Func &, std::size_t>>>
+_MultiArray generate(const covdel::ma::dimension &dim, _Func func)
+{
+  _MultiArray out { dim };
+  auto *data { out.data() };
+  for (std::size_t i { 0 }; i < out.size(); ++i) data[i] = func(i);
+  return out;
+}
+
+// array of a dimension filled from a linear congruential sequence of the seed, with the
+// high bytes of each state for integers and values in [-1, 1) for floating point
+template<typename _MultiArray>
+_MultiArray generate(const covdel::ma::dimension &dim, const std::uint32_t seed)
+{
+  using native_type = typename _MultiArray::native_type;
+  _MultiArray out { dim };
+  auto *data { out.data() };
+  std::uint32_t state { seed * 2654435761U + 1 };
+  for (std::size_t i { 0 }; i < out.size(); ++i) {
+    state = state * 1103515245U + 12345U;
+    if constexpr (std::is_floating_point_v<native_type>)
+      data[i] = native_type(float(state >> 8) / float(1U << 23) - 1.F);
+    else
+      data[i] = native_type(state >> 24);
+  }
+  return out;
+}
+
+// whether arrays of a shape agree elementwise, within a tolerance relative to `b`
+template<typename _Lhs, typename _Rhs>
+bool close(const _Lhs &a, const _Rhs &b, const double tolerance = 1e-4)
+{
+  if (a.dim() != b.dim()) return false;
+  const auto x { a.ascontiguous() };
+  const auto y { b.ascontiguous() };
+  for (std::size_t i { 0 }; i < x.size(); ++i) {
+    const double want { double(y.data()[i]) };
+    if (!(std::abs(double(x.data()[i]) - want) <= tolerance * (1 + std::abs(want))))
+      return false;
+  }
+  return true;
+}
+
+// elements of an array in row-major order
+template<typename _MultiArray>
+std::vector<double> samples(const _MultiArray &a)
+{
+  const auto flat { a.copy() };
+  return std::vector<double>(flat.data(), flat.data() + flat.size());
+}
+
+// whether an array agrees with reference values, uint8 results are off by one at most
+// from rounding and floats by their precision
+template<typename _MultiArray>
+bool close(const _MultiArray &result, const std::vector<double> &expected)
+{
+  const auto got { samples(result) };
+  using native_type = typename _MultiArray::native_type;
+  constexpr bool bytes { std::is_same_v<native_type, std::uint8_t> };
+  for (std::size_t i { 0 }; i < got.size(); ++i) {
+    const double want { bytes ? std::clamp(expected[i], 0.0, 255.0) : expected[i] };
+    const double tolerance { bytes ? 1.0 : 1e-3 * (1 + std::fabs(want)) };
+    if (std::fabs(got[i] - want) > tolerance) return false;
+  }
+  return true;
+}
+
+// path of a file named `name` in the temporary directory, for tests to write to
+inline std::string scratch(const std::string &name)
+{
+  return (std::filesystem::temp_directory_path() / ("covdel_test_" + name)).string();
+}
+
+// makes an allocator the default of the calling thread for its scope
+struct scoped_allocator {
+  scoped_allocator(covdel::ma::allocator &alloc)
+  {
+    covdel::ma::set_default_allocator(alloc);
+  }
+  ~scoped_allocator()
+  {
+    covdel::ma::set_default_allocator(covdel::ma::pool_allocator::instance());
+  }
+};
+
 #endif